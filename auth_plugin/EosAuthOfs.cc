@@ -33,6 +33,7 @@
 #include "ProtoUtils.hh"
 #include "EosAuthOfsDirectory.hh"
 #include "EosAuthOfsFile.hh"
+#include "RequestMux.hh"
 #include "common/SymKeys.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucTrace.hh"
@@ -41,9 +42,6 @@
 #include "XrdSec/XrdSecEntity.hh"
 #include "XrdNet/XrdNetIF.hh"
 #include "XrdVersion.hh"
-/*----------------------------------------------------------------------------*/
-#include "google/protobuf/io/zero_copy_stream_impl.h"
-
 /*----------------------------------------------------------------------------*/
 
 // The global OFS handle
@@ -88,14 +86,12 @@ EOSAUTHNAMESPACE_BEGIN
 EosAuthOfs::EosAuthOfs():
   XrdOfs(),
   eos::common::LogId(),
-  proxy_tid(0),
-  mSizePoolSocket(5),
+  mTimeout(5),
   mLogLevel(LOG_INFO)
 {
   // Initialise the ZMQ client
   mZmqContext = new zmq::context_t(1);
-  mBackend1 = std::make_pair(std::string(""), (zmq::socket_t*)0);
-  mBackend2 = std::make_pair(std::string(""), (zmq::socket_t*)0);
+  mMux = new RequestMux(mZmqContext);
 
   // Set Logging parameters
   XrdOucString unit = "auth@localhost";
@@ -113,22 +109,8 @@ EosAuthOfs::EosAuthOfs():
 //------------------------------------------------------------------------------
 EosAuthOfs::~EosAuthOfs()
 {
-  zmq::socket_t* socket;
-
-  // Kill the auth proxy thread
-  if (proxy_tid)
-  {
-    XrdSysThread::Cancel(proxy_tid);
-    XrdSysThread::Join(proxy_tid, 0);
-  }
-
-  // Release memory    
-  while (mPoolSocket.try_pop(socket))
-    delete socket;
-
-  delete mFrontend;
-  delete mBackend1.second;
-  delete mBackend2.second;
+  // Stop the I/O thread and close the sockets before the context
+  delete mMux;
   delete mZmqContext;
 }
 
@@ -195,7 +177,7 @@ EosAuthOfs::Configure(XrdSysError& error)
             mgm_instance = val;
 
             if (mgm_instance.find(":") != string::npos)
-              mBackend1 = std::make_pair(mgm_instance, (zmq::socket_t*)0);
+              mBackend1 = mgm_instance;
           }
           else
           {
@@ -215,19 +197,33 @@ EosAuthOfs::Configure(XrdSysError& error)
             mgm_instance = val;
 
             if (mgm_instance.find(":") != string::npos)
-              mBackend2 = std::make_pair(mgm_instance, (zmq::socket_t*)0);
+              mBackend2 = mgm_instance;
           }
         }
 
-        // Get number of sockets in the pool by default 10
+        // Requests are multiplexed, there is no socket pool any more
         option_tag = "numsockets";
 
         if (!strncmp(var, option_tag.c_str(), option_tag.length()))
         {
-          if (!(val = Config.GetWord()))
-            error.Emsg("Configure ", "No number of sockets specified");
+          Config.GetWord();
+          error.Say("=====> eosauth.numsockets is obsolete and ignored", "", "");
+        }
+
+        // Get the request timeout in seconds by default 5
+        option_tag = "timeout";
+
+        if (!strncmp(var, option_tag.c_str(), option_tag.length()))
+        {
+          if (!(val = Config.GetWord()) || (atoi(val) <= 0))
+          {
+            error.Emsg("Configure ", "No valid request timeout specified");
+          }
           else
-            mSizePoolSocket = atoi(val);
+          {
+            mTimeout = atoi(val);
+            error.Say("=====> eosauth.timeout: ", val, "");
+          }
         }
         
         // Get log level by default LOG_INFO
@@ -266,44 +262,17 @@ EosAuthOfs::Configure(XrdSysError& error)
     }
 
     // Check and connect at least to an MGM master
-    if (!mBackend1.first.empty())
+    if (!mBackend1.empty())
     {
-      if ((XrdSysThread::Run(&proxy_tid, EosAuthOfs::StartAuthProxyThread,
-                             static_cast<void *>(this), 0, "Auth Proxy Thread")))
+      OfsEroute.Say("=====> connected to master MGM: ", mBackend1.c_str());
+
+      if (!mBackend2.empty())
+        OfsEroute.Say("=====> connected to slave MGM: ", mBackend2.c_str());
+
+      if (!mMux->Start(mBackend1, mBackend2, mTimeout * 1000))
       {
-        eos_err("cannot start the authentication proxy thread");
+        eos_err("cannot start forwarding requests to the MGM nodes");
         NoGo = 1;
-      }    
-      
-      // Create a pool of sockets connected to the master proxy service 
-      for (int i = 0; i < mSizePoolSocket; i++)
-      {
-        // Set socket receive timeout to 5 seconds
-        zmq::socket_t* socket = new zmq::socket_t(*mZmqContext, ZMQ_REQ);
-#if ZMQ_VERSION >= 20200
-        int timeout_mili = 5000;
-        socket->setsockopt(ZMQ_RCVTIMEO, &timeout_mili, sizeof timeout_mili);
-#endif
-        std::string endpoint = "inproc://proxyfrontend";
-        
-        // Try in a loop to connect to the proxyfrontend as it can take a while for
-        // the poxy thread to do the binding, therefore connect can fail
-        while (1)
-        {
-          try
-          {
-            socket->connect(endpoint.c_str());
-          }
-          catch (zmq::error_t& err)
-          {
-            eos_warning("dealing with connect exception, retrying ...");
-            continue;
-          }
-
-          break;
-        }
-        
-        mPoolSocket.push(socket);
       }
     }
     else
@@ -357,194 +326,6 @@ EosAuthOfs::Configure(XrdSysError& error)
 }
 
 
-//------------------------------------------------------------------------------
-// Authentication proxy thread startup function
-//------------------------------------------------------------------------------
-void*
-EosAuthOfs::StartAuthProxyThread(void *pp)
-{
-  EosAuthOfs* ofs = static_cast<EosAuthOfs*>(pp);
-  ofs->AuthProxyThread();
-  return 0;  
-}
-
-
-//------------------------------------------------------------------------------
-// Authentication proxt thread which forwards requests form the clients
-// to the proper MGM intance.
-//------------------------------------------------------------------------------
-void
-EosAuthOfs::AuthProxyThread()
-{
-  // Bind the client facing socket
-  mFrontend = new zmq::socket_t(*mZmqContext, ZMQ_ROUTER);
-  mFrontend->bind("inproc://proxyfrontend");
-
-  // Connect sockets facing the MGM nodes - master and slave
-  std::ostringstream sstr;
-  mBackend1 = std::make_pair(mBackend1.first,
-                             new zmq::socket_t(*mZmqContext, ZMQ_DEALER));
-  sstr << "tcp://" << mBackend1.first;
-  OfsEroute.Say("=====> connected to master MGM: ", mBackend1.first.c_str());
-  mBackend1.second->connect(sstr.str().c_str());
-  
-  // Connect to the slave if present
-  if (!mBackend2.first.empty())
-  {
-    sstr.str("");
-    mBackend2 = std::make_pair(mBackend2.first,
-                               new zmq::socket_t(*mZmqContext, ZMQ_DEALER));
-    sstr << "tcp://" << mBackend2.first;
-    OfsEroute.Say("=====> connected to slave MGM: ", mBackend2.first.c_str());
-    mBackend2.second->connect(sstr.str().c_str());
-  }
-  
-  // Set the master to point to the master MGM - no need for lock
-  mMaster = mBackend1.second;
-
-  int rc;
-  zmq::message_t msg;
-  
-  // Start the poxy using the first entry
-  int more;
-  size_t moresz;
-  int poll_size = 2;
-  zmq_pollitem_t items [3];
-  items[0] = {mFrontend, 0, ZMQ_POLLIN, 0};
-  items[1] = {mBackend1.second, 0, ZMQ_POLLIN, 0};
-    
-  if (!mBackend2.first.empty())
-  {
-    poll_size = 3;
-    items[2] = {mBackend2.second, 0, ZMQ_POLLIN, 0};
-  }
-  
-  // Main loop in which the proxy thread accepts request from the clients and
-  // then he forwards them to the current master MGM. The master MGM can change
-  // at any point.
-  while (true)
-  {
-    // Wait while there are either requests or replies to process
-    rc = zmq::poll(&items[0], poll_size, -1);
-    
-    if (rc < 0)
-    {
-      eos_err("error in poll");
-      return;
-    }
-
-    // Process a request
-    if (items[0].revents & ZMQ_POLLIN)
-    {
-      eos_debug("got frontend event");
-      
-      while (true)
-      {
-        if (!mFrontend->recv(&msg))
-        {
-          eos_err("error while recv on frontend");
-          return;
-        }
-      
-        try
-        {
-          moresz = sizeof more;
-          mFrontend->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        }
-        catch (zmq::error_t& err)
-        {
-          eos_err("exception in getsockopt");
-          return;
-        }
-        
-        // Send request to the current master MGM
-        {
-          XrdSysMutexHelper scop_lock(mMutexMaster);
-          if (!mMaster->send(msg, more ? ZMQ_SNDMORE : 0))
-          {
-            eos_err("error while sending to master");
-            return;
-          }
-        }
-
-        if (more == 0)
-          break;
-      }
-    }
-
-    // Process a reply from the first MGM
-    if (items[1].revents & ZMQ_POLLIN)
-    {
-      eos_debug("got mBackend1 event");
-      
-      while (true)
-      {
-        if (!mBackend1.second->recv(&msg))
-        {
-          eos_err("error while recv on mBackend1");
-          return;
-        }
-        
-        moresz = sizeof more;
-        try
-        {
-          mBackend1.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        }
-        catch (zmq::error_t& err)
-        {
-          eos_err("exception in getsockopt");
-          return;
-        }
-
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0))
-        {
-          eos_err("error while send to frontend(1)");
-          return;
-        }
-       
-        if (more == 0)
-          break;
-      }
-    }
-
-    // Process a reply from the second MGM
-    if ((poll_size == 3) && (items[2].revents & ZMQ_POLLIN))
-    {
-      eos_debug("got mBackend2 event");
-      
-      while (true)
-      {
-        if (!mBackend2.second->recv(&msg))
-        {
-          eos_err("error while recv on mBackend2");
-          return;
-        }
-        
-        moresz = sizeof more;
-        try
-        {
-          mBackend2.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        }
-        catch (zmq::error_t& err)
-        {
-          eos_err("exception in getsockopt");
-          return;
-        }
-
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0))
-        {
-          eos_err("error while send to frontend(2)");
-          return;
-        }
-
-        if (more == 0)
-          break;
-      }
-    }
-  }
-}
-
-
 //------------------------------------------------------------------------------
 // Get directory object
 //------------------------------------------------------------------------------
@@ -590,38 +371,30 @@ EosAuthOfs::stat(const char* path,
     return retc;
   }  
  
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_stat = SendRequest(req_proto);
 
-  if (SendProtoBufRequest(socket, req_proto))
+  if (resp_stat)
   {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_stat->response();
 
-    if (resp_stat)
-     {
-       retc = resp_stat->response();
-    
-       if (resp_stat->has_error())
-       {
-         error.setErrInfo(resp_stat->error().code(),
-                          resp_stat->error().message().c_str());
-       }
-       
-       // We retrieve the struct stat if response is ok
-       if ((retc == SFS_OK) && resp_stat->has_message())
-       {
-         buf = static_cast<struct stat*>(memcpy((void*)buf,
-                                                resp_stat->message().c_str(),
-                                                sizeof(struct stat)));
-       }
-       
-       delete resp_stat;
-     }
+    if (resp_stat->has_error())
+    {
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
+    }
+
+    // We retrieve the struct stat if response is ok
+    if ((retc == SFS_OK) && resp_stat->has_message())
+    {
+      buf = static_cast<struct stat*>(memcpy((void*)buf,
+                                             resp_stat->message().c_str(),
+                                             sizeof(struct stat)));
+    }
+
+    ReleaseResponse(resp_stat);
   }
-    
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -650,35 +423,26 @@ EosAuthOfs::stat(const char* path,
     return retc;
   }  
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_stat = SendRequest(req_proto);
 
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  if (resp_stat)
   {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_stat->response();
 
-    if (resp_stat)
+    if (resp_stat->has_error())
     {
-      retc = resp_stat->response();
-      
-      if (resp_stat->has_error())
-      {
-        error.setErrInfo(resp_stat->error().code(),
-                         resp_stat->error().message().c_str());
-      }
-      
-      // We retrieve the open mode if response if ok
-      if ((retc == SFS_OK) && resp_stat->has_message())
-        memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
-      
-      delete resp_stat;
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
     }
+
+    // We retrieve the open mode if response if ok
+    if ((retc == SFS_OK) && resp_stat->has_message())
+      memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
+
+    ReleaseResponse(resp_stat);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -722,30 +486,22 @@ EosAuthOfs::fsctl(const int cmd,
     return retc;
   }  
     
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_fsctl1 = SendRequest(req_proto);
+
+  if(resp_fsctl1)
   {
-    ResponseProto* resp_fsctl1 = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_fsctl1->response();
 
-    if(resp_fsctl1)
+    if (resp_fsctl1->has_error())
     {
-      retc = resp_fsctl1->response();
-      
-      if (resp_fsctl1->has_error())
-      {
-        error.setErrInfo(resp_fsctl1->error().code(),
-                         resp_fsctl1->error().message().c_str());
-      }
-      
-      delete resp_fsctl1;
+      error.setErrInfo(resp_fsctl1->error().code(),
+                       resp_fsctl1->error().message().c_str());
     }
+
+    ReleaseResponse(resp_fsctl1);
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -772,30 +528,22 @@ EosAuthOfs::FSctl(const int cmd,
     return retc;
   }  
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_fsctl2 = SendRequest(req_proto);
+
+  if (resp_fsctl2)
   {
-    ResponseProto* resp_fsctl2 = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_fsctl2->response();
 
-    if (resp_fsctl2)
+    if (resp_fsctl2->has_error())
     {
-      retc = resp_fsctl2->response();
-      
-      if (resp_fsctl2->has_error())
-      {
-        error.setErrInfo(resp_fsctl2->error().code(),
-                         resp_fsctl2->error().message().c_str());
-      }
-      
-      delete resp_fsctl2;
+      error.setErrInfo(resp_fsctl2->error().code(),
+                       resp_fsctl2->error().message().c_str());
     }
+
+    ReleaseResponse(resp_fsctl2);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -823,30 +571,22 @@ EosAuthOfs::chmod (const char *path,
     return retc;
   }  
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_chmod = SendRequest(req_proto);
+
+  if (resp_chmod)
   {
-    ResponseProto* resp_chmod = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_chmod->response();
 
-    if (resp_chmod)
+    if (resp_chmod->has_error())
     {
-      retc = resp_chmod->response();
-      
-      if (resp_chmod->has_error())
-      {
-        error.setErrInfo(resp_chmod->error().code(),
-                         resp_chmod->error().message().c_str());
-      }
-      
-      delete resp_chmod;
+      error.setErrInfo(resp_chmod->error().code(),
+                       resp_chmod->error().message().c_str());
     }
+
+    ReleaseResponse(resp_chmod);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -876,31 +616,23 @@ EosAuthOfs::chksum(csFunc func,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_chksum = SendRequest(req_proto);
+
+  if (resp_chksum)
   {
-    ResponseProto* resp_chksum = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_chksum->response();
+    eos_debug("chksum retc=%i", retc);
 
-    if (resp_chksum)
+    if (resp_chksum->has_error())
     {
-      retc = resp_chksum->response();
-      eos_debug("chksum retc=%i", retc);
-      
-      if (resp_chksum->has_error())
-      {
-        error.setErrInfo(resp_chksum->error().code(),
-                         resp_chksum->error().message().c_str());
-      }
-      
-      delete resp_chksum;
+      error.setErrInfo(resp_chksum->error().code(),
+                       resp_chksum->error().message().c_str());
     }
+
+    ReleaseResponse(resp_chksum);
   }
- 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -928,34 +660,26 @@ EosAuthOfs::exists(const char* path,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_exists = SendRequest(req_proto);
+
+  if (resp_exists)
   {
-    ResponseProto* resp_exists = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_exists->response();
+    eos_debug("exists retc=%i", retc);
 
-    if (resp_exists)
+    if (resp_exists->has_error())
     {
-      retc = resp_exists->response();
-      eos_debug("exists retc=%i", retc);
-      
-      if (resp_exists->has_error())
-      {
-        error.setErrInfo(resp_exists->error().code(),
-                         resp_exists->error().message().c_str());
-      }
-    
-      if (resp_exists->has_message())
-        exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
-      
-      delete resp_exists;
+      error.setErrInfo(resp_exists->error().code(),
+                       resp_exists->error().message().c_str());
     }
+
+    if (resp_exists->has_message())
+      exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
+
+    ReleaseResponse(resp_exists);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -987,31 +711,23 @@ EosAuthOfs::mkdir (const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-    
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_mkdir = SendRequest(req_proto);
+
+  if (resp_mkdir)
   {
-    ResponseProto* resp_mkdir = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_mkdir->response();
+    eos_debug("mkdir retc=%i", retc);
 
-    if (resp_mkdir)
+    if (resp_mkdir->has_error())
     {
-      retc = resp_mkdir->response();
-      eos_debug("mkdir retc=%i", retc);
-      
-      if (resp_mkdir->has_error())
-      {
-        error.setErrInfo(resp_mkdir->error().code(),
-                         resp_mkdir->error().message().c_str());
-      }
-      
-      delete resp_mkdir;
+      error.setErrInfo(resp_mkdir->error().code(),
+                       resp_mkdir->error().message().c_str());
     }
+
+    ReleaseResponse(resp_mkdir);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1038,31 +754,23 @@ EosAuthOfs::remdir(const char* path,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_remdir = SendRequest(req_proto);
+
+  if (resp_remdir)
   {
-    ResponseProto* resp_remdir = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_remdir->response();
+    eos_debug("remdir retc=%i", retc);
 
-    if (resp_remdir)
+    if (resp_remdir->has_error())
     {
-      retc = resp_remdir->response();
-      eos_debug("remdir retc=%i", retc);
-      
-      if (resp_remdir->has_error())
-      {
-        error.setErrInfo(resp_remdir->error().code(),
-                         resp_remdir->error().message().c_str());
-      }
-      
-      delete resp_remdir;
+      error.setErrInfo(resp_remdir->error().code(),
+                       resp_remdir->error().message().c_str());
     }
+
+    ReleaseResponse(resp_remdir);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1089,31 +797,23 @@ EosAuthOfs::rem(const char* path,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_rem = SendRequest(req_proto);
+
+  if (resp_rem)
   {
-    ResponseProto* resp_rem = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_rem->response();
+    eos_debug("rem retc=%i", retc);
 
-    if (resp_rem)
+    if (resp_rem->has_error())
     {
-      retc = resp_rem->response();
-      eos_debug("rem retc=%i", retc);
-      
-      if (resp_rem->has_error())
-      {
-        error.setErrInfo(resp_rem->error().code(),
-                         resp_rem->error().message().c_str());
-      }
-      
-      delete resp_rem;  
+      error.setErrInfo(resp_rem->error().code(),
+                       resp_rem->error().message().c_str());
     }
+
+    ReleaseResponse(resp_rem);
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1143,31 +843,23 @@ EosAuthOfs::rename (const char *oldName,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_rename = SendRequest(req_proto);
+
+  if (resp_rename)
   {
-    ResponseProto* resp_rename = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_rename->response();
+    eos_debug("rename retc=%i", retc);
 
-    if (resp_rename)
+    if (resp_rename->has_error())
     {
-      retc = resp_rename->response();
-      eos_debug("rename retc=%i", retc);
-      
-      if (resp_rename->has_error())
-      {
-        error.setErrInfo(resp_rename->error().code(),
-                         resp_rename->error().message().c_str());
-      }
-      
-      delete resp_rename;
+      error.setErrInfo(resp_rename->error().code(),
+                       resp_rename->error().message().c_str());
     }
+
+    ReleaseResponse(resp_rename);
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1193,31 +885,23 @@ EosAuthOfs::prepare(XrdSfsPrep& pargs,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_prepare = SendRequest(req_proto);
+
+  if (resp_prepare)
   {
-    ResponseProto* resp_prepare = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_prepare->response();
+    eos_debug("prepare retc=%i", retc);
 
-    if (resp_prepare)
+    if (resp_prepare->has_error())
     {
-      retc = resp_prepare->response();
-      eos_debug("prepare retc=%i", retc);
-      
-      if (resp_prepare->has_error())
-      {
-        error.setErrInfo(resp_prepare->error().code(),
-                         resp_prepare->error().message().c_str());
-      }
-      
-      delete resp_prepare;
+      error.setErrInfo(resp_prepare->error().code(),
+                       resp_prepare->error().message().c_str());
     }
+
+    ReleaseResponse(resp_prepare);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1246,31 +930,23 @@ EosAuthOfs::truncate(const char* path,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-     
-  if (SendProtoBufRequest(socket, req_proto))
+  ResponseProto* resp_truncate = SendRequest(req_proto);
+
+  if (resp_truncate)
   {
-    ResponseProto* resp_truncate = static_cast<ResponseProto*>(GetResponse(socket));
+    retc = resp_truncate->response();
+    eos_debug("truncate retc=%i", retc);
 
-    if (resp_truncate)
+    if (resp_truncate->has_error())
     {
-      retc = resp_truncate->response();
-      eos_debug("truncate retc=%i", retc);
-      
-      if (resp_truncate->has_error())
-      {
-        error.setErrInfo(resp_truncate->error().code(),
-                         resp_truncate->error().message().c_str());
-      }
-      
-      delete resp_truncate;
+      error.setErrInfo(resp_truncate->error().code(),
+                       resp_truncate->error().message().c_str());
     }
+
+    ReleaseResponse(resp_truncate);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1290,118 +966,61 @@ EosAuthOfs::getStats (char *buff, int blen)
 
 
 //------------------------------------------------------------------------------
-// Send ProtocolBuffer object using ZMQ
+// Send a request to the current master MGM and wait for the response
 //------------------------------------------------------------------------------
-bool
-EosAuthOfs::SendProtoBufRequest(zmq::socket_t* socket,
-                                google::protobuf::Message* message)
+ResponseProto*
+EosAuthOfs::SendRequest(RequestProto* request)
 {
-  // Send the request
-  bool sent = false;
-  int msg_size = message->ByteSize();
-  zmq::message_t request(msg_size);
-  google::protobuf::io::ArrayOutputStream aos(request.data(), msg_size);
-
-  // Use google::protobuf::io::ArrayOutputStream which is way faster than
-  // StringOutputStream as it avoids copying data
-  message->SerializeToZeroCopyStream(&aos);
-  sent = socket->send(request, ZMQ_NOBLOCK);
-
-  if (!sent)
-    eos_err("unable to send request using zmq");
-
-  return sent;
-}
+  ResponseProto* resp = mMux->Send(request);
 
+  if (!resp)
+  {
+    eos_err("no response from MGM %s", mMux->GetMaster().c_str());
+    return resp;
+  }
 
-//------------------------------------------------------------------------------
-// Get ProtocolBuffer response object using ZMQ
-//------------------------------------------------------------------------------
-google::protobuf::Message*
-EosAuthOfs::GetResponse(zmq::socket_t* socket)
-{
-  zmq::message_t reply;
-  ResponseProto* resp = static_cast<ResponseProto*>(0);
-  bool done = socket->recv(&reply);
-  
-  if (done)
+  // If response is redirect and the error information matches one of the MGM
+  // nodes specified in the configuration, this means there was a master/slave
+  // switch and we need to update the MGM to which requests are sent.
+  if (resp->response() == SFS_REDIRECT)
   {
-    std::string resp_str = std::string(static_cast<char*>(reply.data()), reply.size());
-    resp = new ResponseProto();
-    resp->ParseFromString(resp_str);
-
-    // If response is redirect and the error information matches one of the MGM
-    // nodes specified in the configuration, this means there was a master/slave
-    // switch and we need to update the socket to which requests are sent.
-    if (resp->response() == SFS_REDIRECT)
+    if (resp->has_error())
     {
-      if (resp->has_error())
+      std::string redirect_host = resp->error().message();
+
+      // Update the master MGM instance
+      if (mMux->SetMaster(redirect_host))
       {
-        std::ostringstream sstr;
-        sstr << resp->error().message();
-        std::string redirect_host = sstr.str();
-        // Update the master MGM instance
-        if (UpdateMaster(redirect_host))
-        {
-          eos_debug("successfully update the master MGM to: %s", redirect_host.c_str());
-          resp->set_response(SFS_STALL);
-        }
-        else
-        {
-          eos_warning("redirect host:%s is not among our known MGM nodes -  "
-                      "failed update master MGM; it migth well be an FST node",
-                      redirect_host.c_str());
-        }
+        eos_debug("successfully update the master MGM to: %s", redirect_host.c_str());
+        resp->set_response(SFS_STALL);
       }
       else
       {
-        eos_err("redirect message without error information - change to error");
-        resp->set_response(SFS_ERROR);
-      }    
-    }    
-  }
-  else
-  {
-    eos_err("socket error/timeout during receive");
+        eos_warning("redirect host:%s is not among our known MGM nodes -  "
+                    "failed update master MGM; it migth well be an FST node",
+                    redirect_host.c_str());
+      }
+    }
+    else
+    {
+      eos_err("redirect message without error information - change to error");
+      resp->set_response(SFS_ERROR);
+    }
   }
-  
+
   return resp;
 }
 
 
 //------------------------------------------------------------------------------
-// Update the socket pointing to the master MGM instance
+// Give back a response object obtained from SendRequest
 //------------------------------------------------------------------------------
-bool
-EosAuthOfs::UpdateMaster(std::string& redirect_host)
+void
+EosAuthOfs::ReleaseResponse(ResponseProto* response)
 {
-  bool found = false;
-  zmq::socket_t* upd_socket;
-  eos_debug("redirect_host:%s", redirect_host.c_str());
-  
-  // Chech if the new master was also specified in the configuration
-  if (mBackend1.first.find(redirect_host) != string::npos)
-  {
-    upd_socket = mBackend1.second;
-    found = true;
-  }
-  else if (mBackend2.first.find(redirect_host) != string::npos)
-  {
-    upd_socket = mBackend2.second;
-    found = true;
-  }
-
-  if (found)
-  {
-    XrdSysMutexHelper scop_lock(mMutexMaster);
-    if (mMaster != upd_socket)
-      mMaster = upd_socket;    
-  }
-
-  return found;
+  mMux->Release(response);
 }
 
 
-
 EOSAUTHNAMESPACE_END
 
@@ -30,7 +30,6 @@
 /*----------------------------------------------------------------------------*/
 #include "common/ZMQ.hh"
 /*----------------------------------------------------------------------------*/
-#include "common/ConcurrentQueue.hh"
 #include "Namespace.hh"
 /*----------------------------------------------------------------------------*/
 
@@ -38,16 +37,13 @@
 class EosAuthOfsDirectory;
 class EosAuthOfsFile;
 
-namespace google
-{
-  namespace protobuf
-  {
-    class Message;
-  }
-}
-
 EOSAUTHNAMESPACE_BEGIN
 
+//! Forward declaration
+class RequestMux;
+class RequestProto;
+class ResponseProto;
+
 //------------------------------------------------------------------------------
 //! Class EosAuthOfs built on top of XrdOfs
 /*! Decription: The libEosAuthOfs.so is inteded to be used as an OFS library
@@ -70,18 +66,20 @@ EOSAUTHNAMESPACE_BEGIN
         ports to which ZMQ can connect to the MGM nodes so that it can forward
         requests and receive responses. Only the mastermgm parameter is mandatory
         the other one is optional and can be left out.
-    - eosauth.numsockets - once a clients wants to send a request the thread
-        allocated to him in XRootD will require a socket to send the request
-        to the MGM node. Therefore, we set up a pool of sockets from the
-        begining which can be used to send/receiver requests/responses.
-        The default size is 10 sockets.
+    - eosauth.timeout - timeout in seconds of a request sent to the MGM node,
+        by default 5 seconds. The requests of all the XRootD threads are
+        multiplexed over one connection to each MGM node (see RequestMux) so
+        any number of them can be in flight. If the master MGM does not answer
+        any request for half of this time, the requests are sent to the other
+        MGM node. The former eosauth.numsockets parameter is ignored.
 
     MGM - configuration
     ===================
     - mgmofs.auththreads - since we now receive requests using ZMQ, we no longer
         use the default thread pool from XRootD and we need threads for dealing
         with the requests. This parameter sets the thread pool size when starting
-        the MGM node.
+        the MGM node. Each request is given to an idle thread (see
+        RequestBroker) so a slow request does not delay the others.
     - mgmofs.authport - this is the endpoint where the MGM listens for ZMQ
         requests from any EosAuthOfs plugins. This port needs to be opened also
         in the firewall.
@@ -269,69 +267,35 @@ class EosAuthOfs: public XrdOfs, public eos::common::LogId
   
   private:
 
-    pthread_t proxy_tid; ///< id of the proxy thread
+    RequestMux* mMux; ///< forwards the requests to the MGM nodes
     zmq::context_t* mZmqContext; ///< ZMQ context
-    zmq::socket_t* mFrontend; ///< proxy socket facing the clients
-    zmq::socket_t* mMaster; ///< socket pointing to the MGM master
-    XrdSysMutex mMutexMaster; ///< mutex for switching the MGM master
-    int mSizePoolSocket; ///< maximum size of the client socket pool
-    eos::common::ConcurrentQueue<zmq::socket_t*> mPoolSocket; ///< ZMQ client socket pool
-    ///! MGM endpoints to which requests can be dispatched and the corresponding sockets
-    std::pair<std::string, zmq::socket_t*> mBackend1;
-    std::pair<std::string, zmq::socket_t*> mBackend2;
+    std::string mBackend1; ///< master MGM endpoint "host:port"
+    std::string mBackend2; ///< slave MGM endpoint "host:port", may be empty
+    int mTimeout; ///< request timeout in seconds
     std::string mManagerIp; ///< the IP address of the auth instance
     int mManagerPort;   ///< port on which the current auth server runs
     int mLogLevel; ///< log level value 0 -7 (LOG_EMERG - LOG_DEBUG)
 
 
     //--------------------------------------------------------------------------
-    //! Authentication proxy thread which forwards requests form the clients
-    //! to the proper MGM intance.
-    //--------------------------------------------------------------------------
-    void AuthProxyThread();
-
-
-    //--------------------------------------------------------------------------
-    //! Authentication proxy thread startup function
-    //--------------------------------------------------------------------------
-    static void* StartAuthProxyThread(void *pp);
-  
-
-    //--------------------------------------------------------------------------
-    //! Send ProtocolBuffer object using ZMQ
-    //!
-    //! @param socket ZMQ socket object
-    //! @param object to be sent over the wire
-    //!
-    //! @return true if object sent successfully, otherwise false
-    //!
-    //--------------------------------------------------------------------------
-    bool SendProtoBufRequest(zmq::socket_t* socket,
-                             google::protobuf::Message* message);
-
-
-    //--------------------------------------------------------------------------
-    //! Get ProtocolBuffer reply object using ZMQ
+    //! Send a request to the current master MGM and wait for the response
     //!
-    //! @param socket ZMQ socket object
+    //! @param request request object
     //!
-    //! @return pointer to received object, the user has the responsibility to
-    //!         delete the obtained object
+    //! @return response object which has to be given back using
+    //!         ReleaseResponse, 0 if the request could not be sent
     //!
     //--------------------------------------------------------------------------
-    google::protobuf::Message* GetResponse(zmq::socket_t* socket);
+    ResponseProto* SendRequest(RequestProto* request);
 
 
     //--------------------------------------------------------------------------
-    //! Update the socket pointing to the master MGM instance
-    //!
-    //! @param new_master new host and port values for the master MGM
-    //!                   the format is: "host:port"
+    //! Give back a response object obtained from SendRequest
     //!
-    //! @return true if update was successful, false otherwise
+    //! @param response response object
     //!
     //--------------------------------------------------------------------------
-    bool UpdateMaster(std::string& new_master);
+    void ReleaseResponse(ResponseProto* response);
 
   
 };
@@ -78,24 +78,16 @@ EosAuthOfsDirectory::open(const char* name,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_open = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_open)
   {
-    ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
-
-    if (resp_open)
-    {
-      retc = resp_open->response();
-      eos_debug("got response for dir open request");
-      delete resp_open;
-    }
+    retc = resp_open->response();
+    eos_debug("got response for dir open request");
+    gOFS->ReleaseResponse(resp_open);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -121,35 +113,27 @@ EosAuthOfsDirectory::nextEntry()
     return static_cast<const char*>(0) ;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_read = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_read)
   {
-    ResponseProto* resp_read = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    retc = resp_read->response();
+    eos_debug("got response for dir read request");
 
-    if (resp_read)
+    if (retc == SFS_OK)
     {
-      retc = resp_read->response();
-      eos_debug("got response for dir read request");
-      
-      if (retc == SFS_OK)
-      {
-        eos_debug("next entry is: %s", resp_read->message().c_str());
-        mNextEntry = resp_read->message();
-      }
-      else 
-      {
-        eos_debug("no more entries or error on server side");
-      }
-      
-      delete resp_read;
+      eos_debug("next entry is: %s", resp_read->message().c_str());
+      mNextEntry = resp_read->message();
     }
+    else
+    {
+      eos_debug("no more entries or error on server side");
+    }
+
+    gOFS->ReleaseResponse(resp_read);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return (retc ? static_cast<const char*>(0) : mNextEntry.c_str());
 }
@@ -175,24 +159,16 @@ EosAuthOfsDirectory::close()
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_close = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_close)
   {
-    ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
-
-    if (resp_close)
-    {
-      retc = resp_close->response();
-      eos_debug("got response dir close request");
-      delete resp_close;
-    }
+    retc = resp_close->response();
+    eos_debug("got response dir close request");
+    gOFS->ReleaseResponse(resp_close);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -218,35 +194,27 @@ EosAuthOfsDirectory::FName()
     return static_cast<const char*>(0) ;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_fname = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_fname)
   {
-    ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    retc = resp_fname->response();
+    eos_debug("got response for dirfname request");
 
-    if (resp_fname)
+    if (retc == SFS_OK)
     {
-      retc = resp_fname->response();
-      eos_debug("got response for dirfname request");
-      
-      if (retc == SFS_OK)
-      {
-        eos_debug("dir fname is: %s", resp_fname->message().c_str());
-        mName = resp_fname->message();
-      }
-      else 
-      {
-        eos_debug("dir fname not found or error on server side");
-      }
-      
-      delete resp_fname;
+      eos_debug("dir fname is: %s", resp_fname->message().c_str());
+      mName = resp_fname->message();
     }
+    else
+    {
+      eos_debug("dir fname not found or error on server side");
+    }
+
+    gOFS->ReleaseResponse(resp_fname);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return (retc ? static_cast<const char*>(0) : mName.c_str());
 }
@@ -83,28 +83,20 @@ EosAuthOfsFile::open(const char* fileName,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_open = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_open)
   {
-    ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    retc = resp_open->response();
+    eos_debug("got response for file open request: %i", retc);
 
-    if (resp_open)
-    {
-      retc = resp_open->response();
-      eos_debug("got response for file open request: %i", retc);
-      
-      if (resp_open->has_error())
-        error.setErrInfo(resp_open->error().code(), resp_open->error().message().c_str());
-      
-      delete resp_open;
-    }
+    if (resp_open->has_error())
+      error.setErrInfo(resp_open->error().code(), resp_open->error().message().c_str());
+
+    gOFS->ReleaseResponse(resp_open);
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -133,31 +125,23 @@ EosAuthOfsFile::read(XrdSfsFileOffset offset,
     return retc;
   }
  
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_fread = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_fread)
   {
-    ResponseProto* resp_fread = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    retc = resp_fread->response();
 
-    if (resp_fread)
+    if (retc && resp_fread->has_message())
     {
-      retc = resp_fread->response();
-
-      if (retc && resp_fread->has_message())
-      {
-        buffer = static_cast<char*>(memcpy((void*)buffer,
-                                           resp_fread->message().c_str(),
-                                           resp_fread->message().length()));
-      }
-      
-      delete resp_fread;
+      buffer = static_cast<char*>(memcpy((void*)buffer,
+                                         resp_fread->message().c_str(),
+                                         resp_fread->message().length()));
     }
+
+    gOFS->ReleaseResponse(resp_fread);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -186,24 +170,16 @@ EosAuthOfsFile::write(XrdSfsFileOffset offset,
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_fwrite = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_fwrite)
   {
-    ResponseProto* resp_fwrite = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
-
-    if (resp_fwrite)
-    {
-      retc = resp_fwrite->response();
-      eos_debug("got response for file write request");
-      delete resp_fwrite;
-    }
+    retc = resp_fwrite->response();
+    eos_debug("got response for file write request");
+    gOFS->ReleaseResponse(resp_fwrite);
   }
- 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -230,35 +206,27 @@ EosAuthOfsFile::FName()
     return static_cast<const char*>(0);
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_fname = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_fname)
   {
-    ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    retc = resp_fname->response();
+    eos_debug("got response for filefname request");
 
-    if (resp_fname)
+    if (retc == SFS_OK)
+    {
+      eos_debug("file fname is: %s", resp_fname->message().c_str());
+      mName = resp_fname->message();
+    }
+    else
     {
-      retc = resp_fname->response();
-      eos_debug("got response for filefname request");
-      
-      if (retc == SFS_OK)
-      {
-        eos_debug("file fname is: %s", resp_fname->message().c_str());
-        mName = resp_fname->message();
-      }
-      else
-      { 
-        eos_debug("file fname not found or error on server side");
-      }
-      
-      delete resp_fname;
+      eos_debug("file fname not found or error on server side");
     }
+
+    gOFS->ReleaseResponse(resp_fname);
   }
- 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return (retc ? static_cast<const char*>(0) : mName.c_str());
 }
@@ -285,32 +253,24 @@ EosAuthOfsFile::stat(struct stat* buf)
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_fstat = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_fstat)
   {
-    ResponseProto* resp_fstat = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
-
-    if (resp_fstat)
-    {
-      retc = resp_fstat->response();
-      buf = static_cast<struct stat*>(memcpy((void*)buf,
-                                             resp_fstat->message().c_str(),
-                                             sizeof(struct stat)));
-      eos_debug("got response for fstat request: %i", retc);
-      delete resp_fstat;
-    }
+    retc = resp_fstat->response();
+    buf = static_cast<struct stat*>(memcpy((void*)buf,
+                                           resp_fstat->message().c_str(),
+                                           sizeof(struct stat)));
+    eos_debug("got response for fstat request: %i", retc);
+    gOFS->ReleaseResponse(resp_fstat);
   }
   else
   {
-    eos_err("file stat - unable to send request");
+    eos_err("file stat - no response");
     memset(buf, 0, sizeof(struct stat));
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -337,24 +297,16 @@ EosAuthOfsFile::close()
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_close = gOFS->SendRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (resp_close)
   {
-    ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
-
-    if (resp_close)
-    {
-      retc = resp_close->response();
-      eos_debug("got response for file close request: %i", retc);
-      delete resp_close;
-    }
+    retc = resp_close->response();
+    eos_debug("got response for file close request: %i", retc);
+    gOFS->ReleaseResponse(resp_close);
   }
-  
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+
+  // Free memory
   delete req_proto;
   return retc;
 }
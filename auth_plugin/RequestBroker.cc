@@ -0,0 +1,327 @@
+//------------------------------------------------------------------------------
+// File: RequestBroker.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+/*----------------------------------------------------------------------------*/
+#include "RequestBroker.hh"
+/*----------------------------------------------------------------------------*/
+
+EOSAUTHNAMESPACE_BEGIN
+
+//! Message sent by a worker when connecting to the broker
+static const char* sReady = "READY";
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RequestBroker::RequestBroker(zmq::context_t* context):
+  eos::common::LogId(),
+  mFrontend(*context, ZMQ_ROUTER),
+  mBackend(*context, ZMQ_ROUTER)
+{
+  int linger = 0;
+  mFrontend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+  mBackend.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+RequestBroker::~RequestBroker()
+{ }
+
+
+//------------------------------------------------------------------------------
+// Bind the sockets facing the auth plugins and the workers
+//------------------------------------------------------------------------------
+bool
+RequestBroker::Bind(const std::string& frontend, const std::string& backend)
+{
+  try
+  {
+    mFrontend.bind(frontend.c_str());
+  }
+  catch (zmq::error_t& err)
+  {
+    eos_err("failed to bind frontend socket to %s", frontend.c_str());
+    return false;
+  }
+
+  try
+  {
+    mBackend.bind(backend.c_str());
+  }
+  catch (zmq::error_t& err)
+  {
+    eos_err("failed to bind backend socket to %s", backend.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the endpoint the frontend socket is bound to
+//------------------------------------------------------------------------------
+std::string
+RequestBroker::GetFrontendEndpoint()
+{
+  char endpoint[256];
+  size_t size = sizeof(endpoint);
+
+  try
+  {
+    mFrontend.getsockopt(ZMQ_LAST_ENDPOINT, endpoint, &size);
+  }
+  catch (zmq::error_t& err)
+  {
+    eos_err("unable to get the frontend endpoint: %s", err.what());
+    return "";
+  }
+
+  // The size includes the terminating null character
+  return std::string(endpoint, size ? size - 1 : 0);
+}
+
+
+//------------------------------------------------------------------------------
+// Dispatch requests to the workers and replies to the auth plugins
+//------------------------------------------------------------------------------
+void
+RequestBroker::Run()
+{
+  zmq_pollitem_t items[2];
+  items[0].socket = static_cast<void*>(mBackend);
+  items[0].fd = 0;
+  items[0].events = ZMQ_POLLIN;
+  items[1].socket = static_cast<void*>(mFrontend);
+  items[1].fd = 0;
+  items[1].events = ZMQ_POLLIN;
+
+  while (true)
+  {
+    try
+    {
+      // Only accept requests while there is a worker to execute them, the
+      // frontend events are not updated when it is left out of the poll
+      items[1].revents = 0;
+      zmq::poll(&items[0], mIdle.empty() ? 1 : 2, -1);
+
+      if (items[0].revents & ZMQ_POLLIN)
+      {
+        // Frames: [worker id][READY] or [worker id][envelope...][empty][reply]
+        zmq::message_t frame;
+        mBackend.recv(&frame);
+        std::string worker(static_cast<char*>(frame.data()), frame.size());
+
+        if (!HasMore(mBackend))
+        {
+          eos_err("worker message without content");
+          continue;
+        }
+
+        mBackend.recv(&frame);
+
+        if (HasMore(mBackend))
+        {
+          mFrontend.send(frame, ZMQ_SNDMORE);
+
+          if (!ForwardFrames(mBackend, mFrontend))
+            eos_err("failed to forward reply to the auth plugin");
+        }
+
+        mIdle.push_back(worker);
+      }
+
+      if (!mIdle.empty() && (items[1].revents & ZMQ_POLLIN))
+      {
+        // Most recently used worker first, its stack is still warm
+        std::string worker = mIdle.back();
+        mIdle.pop_back();
+        zmq::message_t frame(worker.size());
+        memcpy(frame.data(), worker.c_str(), worker.size());
+        mBackend.send(frame, ZMQ_SNDMORE);
+
+        if (!ForwardFrames(mFrontend, mBackend))
+          eos_err("failed to forward request to a worker");
+      }
+    }
+    catch (zmq::error_t& err)
+    {
+      if (err.num() == ETERM)
+      {
+        // The context termination waits for all its sockets to be closed
+        mFrontend.close();
+        mBackend.close();
+        break;
+      }
+
+      eos_err("ZMQ error in the auth broker: %s", err.what());
+    }
+  }
+
+  eos_info("auth broker exiting");
+}
+
+
+//------------------------------------------------------------------------------
+// Connect a worker socket to the broker and announce it as idle
+//------------------------------------------------------------------------------
+bool
+RequestBroker::ConnectWorker(zmq::socket_t& socket, const std::string& backend,
+                             int retries)
+{
+  // The bind can take a while therefore keep trying until it is successful
+  for (int i = 0; i <= retries; i++)
+  {
+    try
+    {
+      socket.connect(backend.c_str());
+      zmq::message_t ready(strlen(sReady));
+      memcpy(ready.data(), sReady, strlen(sReady));
+      return socket.send(ready, 0);
+    }
+    catch (zmq::error_t& err)
+    {
+      eos_static_debug("auth worker connection failed - retry");
+      sleep(1);
+    }
+  }
+
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// Receive a request in a worker
+//------------------------------------------------------------------------------
+bool
+RequestBroker::RecvRequest(zmq::socket_t& socket,
+                           std::vector<std::string>& envelope,
+                           zmq::message_t& request)
+{
+  bool delimiter = false;
+  envelope.clear();
+
+  while (true)
+  {
+    socket.recv(&request);
+
+    if (!HasMore(socket))
+      break;
+
+    if (delimiter)
+    {
+      // More than one frame after the delimiter
+      delimiter = false;
+      envelope.clear();
+    }
+    else if (request.size())
+    {
+      envelope.push_back(std::string(static_cast<char*>(request.data()),
+                                     request.size()));
+    }
+    else
+    {
+      // Delimiter, what follows is the request
+      delimiter = true;
+    }
+  }
+
+  if (delimiter && !envelope.empty())
+    return true;
+
+  // Malformed request, there is nobody to reply to but the broker has to see
+  // this worker as idle again
+  eos_static_err("malformed request with %llu envelope frames",
+                 (unsigned long long) envelope.size());
+  zmq::message_t ready(strlen(sReady));
+  memcpy(ready.data(), sReady, strlen(sReady));
+  socket.send(ready, 0);
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// Send the reply of a request from a worker
+//------------------------------------------------------------------------------
+bool
+RequestBroker::SendReply(zmq::socket_t& socket,
+                         const std::vector<std::string>& envelope,
+                         zmq::message_t& reply)
+{
+  for (size_t i = 0; i < envelope.size(); i++)
+  {
+    zmq::message_t frame(envelope[i].size());
+    memcpy(frame.data(), envelope[i].c_str(), envelope[i].size());
+    socket.send(frame, ZMQ_SNDMORE);
+  }
+
+  zmq::message_t delimiter;
+  socket.send(delimiter, ZMQ_SNDMORE);
+  return socket.send(reply, 0);
+}
+
+
+//------------------------------------------------------------------------------
+// Forward the remaining frames of a message from one socket to another
+//------------------------------------------------------------------------------
+bool
+RequestBroker::ForwardFrames(zmq::socket_t& from, zmq::socket_t& to)
+{
+  zmq::message_t frame;
+  bool more = true;
+
+  while (more)
+  {
+    if (!from.recv(&frame))
+      return false;
+
+    more = HasMore(from);
+
+    if (!to.send(frame, more ? ZMQ_SNDMORE : 0))
+      return false;
+  }
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Check if the last frame received on a socket is followed by more
+//------------------------------------------------------------------------------
+bool
+RequestBroker::HasMore(zmq::socket_t& socket)
+{
+  int more = 0;
+  size_t more_size = sizeof(more);
+  socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  return (more != 0);
+}
+
+EOSAUTHNAMESPACE_END
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// File: RequestBroker.hh
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOS_AUTH_REQUESTBROKER_HH__
+#define __EOS_AUTH_REQUESTBROKER_HH__
+
+/*----------------------------------------------------------------------------*/
+#include <string>
+#include <vector>
+/*----------------------------------------------------------------------------*/
+#include "Namespace.hh"
+#include "common/Logging.hh"
+#include "common/ZMQ.hh"
+/*----------------------------------------------------------------------------*/
+
+EOSAUTHNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class RequestBroker
+/*! Description: MGM side of the auth plugin protocol. The broker accepts the
+    requests of the auth plugins on a ROUTER socket and hands each of them to
+    a worker thread which is idle, the workers being connected with DEALER
+    sockets to a second ROUTER socket. Unlike a plain DEALER which deals the
+    requests round robin, a slow request only keeps busy the worker executing
+    it while the following requests go to the other workers. Requests are
+    only read from the auth plugins while there is an idle worker, the rest
+    waits in the ZMQ queues.
+
+    The envelope of a request, i.e. all frames up to the empty delimiter, is
+    returned unchanged with the reply. The auth plugins put there the
+    correlation id of the request, older plugins using REQ sockets the
+    identity frames added by their proxy.
+*/
+//------------------------------------------------------------------------------
+class RequestBroker: public eos::common::LogId
+{
+public:
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param context ZMQ context
+  //----------------------------------------------------------------------------
+  RequestBroker(zmq::context_t* context);
+
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~RequestBroker();
+
+
+  //----------------------------------------------------------------------------
+  //! Bind the sockets facing the auth plugins and the workers
+  //!
+  //! @param frontend endpoint for the auth plugins e.g. "tcp://*:15555"
+  //! @param backend endpoint for the workers e.g. "inproc://authbackend"
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Bind(const std::string& frontend, const std::string& backend);
+
+
+  //----------------------------------------------------------------------------
+  //! Get the endpoint the frontend socket is bound to, this includes the port
+  //! chosen by the system when binding to port "*"
+  //----------------------------------------------------------------------------
+  std::string GetFrontendEndpoint();
+
+
+  //----------------------------------------------------------------------------
+  //! Dispatch requests to the workers and replies to the auth plugins until
+  //! the ZMQ context is terminated
+  //----------------------------------------------------------------------------
+  void Run();
+
+
+  //----------------------------------------------------------------------------
+  //! Connect a worker socket (DEALER) to the broker and announce it as idle
+  //!
+  //! @param socket worker socket
+  //! @param backend endpoint of the broker given to Bind
+  //! @param retries number of connection attempts, one per second
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool ConnectWorker(zmq::socket_t& socket, const std::string& backend,
+                            int retries = 5);
+
+
+  //----------------------------------------------------------------------------
+  //! Receive a request in a worker
+  //!
+  //! @param socket worker socket
+  //! @param envelope returns the envelope to be given to SendReply
+  //! @param request returns the serialised request
+  //!
+  //! @return true if successful, false if the message is malformed in which
+  //!         case the worker has been announced as idle again
+  //----------------------------------------------------------------------------
+  static bool RecvRequest(zmq::socket_t& socket,
+                          std::vector<std::string>& envelope,
+                          zmq::message_t& request);
+
+
+  //----------------------------------------------------------------------------
+  //! Send the reply of a request from a worker, this makes the worker idle
+  //!
+  //! @param socket worker socket
+  //! @param envelope envelope of the request
+  //! @param reply serialised reply
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool SendReply(zmq::socket_t& socket,
+                        const std::vector<std::string>& envelope,
+                        zmq::message_t& reply);
+
+private:
+
+  zmq::socket_t mFrontend; ///< ROUTER socket facing the auth plugins
+  zmq::socket_t mBackend; ///< ROUTER socket facing the workers
+  std::vector<std::string> mIdle; ///< identities of the idle workers
+
+
+  //----------------------------------------------------------------------------
+  //! Forward the remaining frames of a message from one socket to another
+  //!
+  //! @return true if the whole message was forwarded
+  //----------------------------------------------------------------------------
+  static bool ForwardFrames(zmq::socket_t& from, zmq::socket_t& to);
+
+
+  //----------------------------------------------------------------------------
+  //! Check if the last frame received on a socket is followed by more
+  //----------------------------------------------------------------------------
+  static bool HasMore(zmq::socket_t& socket);
+};
+
+EOSAUTHNAMESPACE_END
+
+#endif // __EOS_AUTH_REQUESTBROKER_HH__
@@ -0,0 +1,639 @@
+//------------------------------------------------------------------------------
+// File: RequestMux.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+/*----------------------------------------------------------------------------*/
+#include "RequestMux.hh"
+#include "proto/Request.pb.h"
+#include "proto/Response.pb.h"
+/*----------------------------------------------------------------------------*/
+
+EOSAUTHNAMESPACE_BEGIN
+
+//! Maximum number of response objects kept for reuse
+static const size_t sMaxFreeResponses = 256;
+
+//! Poll period of the I/O thread in milliseconds, bounds the failover delay
+static const long sPollPeriod = 100;
+
+//! Poll period of the I/O thread while the master socket would block
+static const long sRetryPeriod = 10;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RequestMux::RequestMux(zmq::context_t* context):
+  eos::common::LogId(),
+  mContext(context),
+  mNumBackends(0),
+  mMaster(0),
+  mTimeout(5000),
+  mLastFailover(0),
+  mSignalled(false),
+  mStop(false),
+  mTid(0),
+  mLastId(0)
+{
+  mSocket[0] = mSocket[1] = 0;
+  mLastReply[0] = mLastReply[1] = 0;
+  mPipe[0] = mPipe[1] = -1;
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+RequestMux::~RequestMux()
+{
+  Stop();
+
+  for (size_t i = 0; i < mFreeResponses.size(); i++)
+    delete mFreeResponses[i];
+}
+
+
+//------------------------------------------------------------------------------
+// Connect to the MGM nodes and start the I/O thread
+//------------------------------------------------------------------------------
+bool
+RequestMux::Start(const std::string& master, const std::string& slave,
+                  int timeout)
+{
+  mEndpoint[0] = master;
+  mEndpoint[1] = slave;
+  mNumBackends = (slave.empty() ? 1 : 2);
+  mMaster = 0;
+
+  if (timeout > 0)
+    mTimeout = timeout;
+
+  if (pipe(mPipe))
+  {
+    eos_err("unable to create the wake up pipe errno=%i", errno);
+    return false;
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+    fcntl(mPipe[i], F_SETFL, fcntl(mPipe[i], F_GETFL) | O_NONBLOCK);
+    fcntl(mPipe[i], F_SETFD, FD_CLOEXEC);
+  }
+
+  try
+  {
+    for (int i = 0; i < mNumBackends; i++)
+    {
+      mSocket[i] = new zmq::socket_t(*mContext, ZMQ_DEALER);
+      int linger = 0;
+      mSocket[i]->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+#ifdef ZMQ_IMMEDIATE
+      // Don't queue requests for an MGM which is not connected, they have
+      // to stay with us to be sent to the other one on failover
+      int immediate = 1;
+      mSocket[i]->setsockopt(ZMQ_IMMEDIATE, &immediate, sizeof(immediate));
+#endif
+      std::string endpoint = "tcp://" + mEndpoint[i];
+      mSocket[i]->connect(endpoint.c_str());
+    }
+  }
+  catch (zmq::error_t& err)
+  {
+    eos_err("unable to connect to the MGM nodes master=%s slave=%s: %s",
+            master.c_str(), slave.c_str(), err.what());
+    return false;
+  }
+
+  if (XrdSysThread::Run(&mTid, RequestMux::StartIOThread,
+                        static_cast<void*>(this), 0, "Auth Mux Thread"))
+  {
+    eos_err("cannot start the auth I/O thread");
+    mTid = 0;
+    return false;
+  }
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Stop the I/O thread
+//------------------------------------------------------------------------------
+void
+RequestMux::Stop()
+{
+  if (mTid)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStop = true;
+      Signal();
+    }
+
+    XrdSysThread::Join(mTid, 0);
+    mTid = 0;
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+    delete mSocket[i];
+    mSocket[i] = 0;
+
+    if (mPipe[i] >= 0)
+    {
+      close(mPipe[i]);
+      mPipe[i] = -1;
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Send a request to the current master MGM and wait for the reply
+//------------------------------------------------------------------------------
+ResponseProto*
+RequestMux::Send(RequestProto* request, int timeout)
+{
+  Pending pending;
+  int msg_size = request->ByteSize();
+  pending.request.rebuild(msg_size);
+  // Serialise directly into the ZMQ frame, the size is already cached
+  request->SerializeWithCachedSizesToArray(
+    static_cast<google::protobuf::uint8*>(pending.request.data()));
+
+  pending.idempotent = IsIdempotent(request);
+
+  if (timeout <= 0)
+    timeout = mTimeout;
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStop || !mTid)
+    {
+      eos_err("auth I/O thread is not running");
+      return 0;
+    }
+
+    uint64_t id = ++mLastId;
+    pending.submitted = Now();
+    mPending[id] = &pending;
+    mOutgoing.push_back(id);
+    Signal();
+
+    if (!pending.cond.wait_for(lock, std::chrono::milliseconds(timeout),
+                               [&pending] { return pending.done; }))
+    {
+      // The I/O thread skips requests which are no longer pending
+      mPending.erase(id);
+      mStats.timeouts++;
+      eos_err("request id=%llu timed out after %i ms master=%s",
+              (unsigned long long) id, timeout, mEndpoint[mMaster].c_str());
+      return 0;
+    }
+  }
+
+  // Parse the reply outside the lock into a recycled response object
+  ResponseProto* response = 0;
+  {
+    std::unique_lock<std::mutex> lock(mFreeMutex);
+
+    if (!mFreeResponses.empty())
+    {
+      response = mFreeResponses.back();
+      mFreeResponses.pop_back();
+    }
+  }
+
+  if (!response)
+    response = new ResponseProto();
+
+  if (!response->ParseFromArray(pending.reply.data(), pending.reply.size()))
+  {
+    eos_err("unable to parse response of size %llu",
+            (unsigned long long) pending.reply.size());
+    Release(response);
+    return 0;
+  }
+
+  return response;
+}
+
+
+//------------------------------------------------------------------------------
+// Give back a response object obtained from Send
+//------------------------------------------------------------------------------
+void
+RequestMux::Release(ResponseProto* response)
+{
+  if (!response)
+    return;
+
+  // Clear keeps the memory allocated for the strings of the message
+  response->Clear();
+  std::unique_lock<std::mutex> lock(mFreeMutex);
+
+  if (mFreeResponses.size() < sMaxFreeResponses)
+    mFreeResponses.push_back(response);
+  else
+    delete response;
+}
+
+
+//------------------------------------------------------------------------------
+// Make one of the MGM nodes the current master
+//------------------------------------------------------------------------------
+bool
+RequestMux::SetMaster(const std::string& host)
+{
+  if (host.empty())
+    return false;
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  for (int i = 0; i < mNumBackends; i++)
+  {
+    if (mEndpoint[i].find(host) != std::string::npos)
+    {
+      if (mMaster != i)
+      {
+        eos_info("switch master MGM from %s to %s", mEndpoint[mMaster].c_str(),
+                 mEndpoint[i].c_str());
+        mMaster = i;
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the endpoint of the current master MGM
+//------------------------------------------------------------------------------
+std::string
+RequestMux::GetMaster()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mEndpoint[mMaster];
+}
+
+
+//------------------------------------------------------------------------------
+// Get the counters
+//------------------------------------------------------------------------------
+RequestMux::Stats
+RequestMux::GetStats()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+
+//------------------------------------------------------------------------------
+// I/O thread startup function
+//------------------------------------------------------------------------------
+void*
+RequestMux::StartIOThread(void* pp)
+{
+  RequestMux* mux = static_cast<RequestMux*>(pp);
+  mux->IOThread();
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// I/O thread sending the queued requests and dispatching the replies
+//------------------------------------------------------------------------------
+void
+RequestMux::IOThread()
+{
+  zmq_pollitem_t items[3];
+  int poll_size = 1 + mNumBackends;
+  items[0].socket = 0;
+  items[0].fd = mPipe[0];
+  items[0].events = ZMQ_POLLIN;
+
+  for (int i = 0; i < mNumBackends; i++)
+  {
+    items[1 + i].socket = static_cast<void*>(*mSocket[i]);
+    items[1 + i].fd = 0;
+    items[1 + i].events = ZMQ_POLLIN;
+  }
+
+  bool blocked = false;
+
+  while (true)
+  {
+    long wait = (blocked ? sRetryPeriod : sPollPeriod);
+#if ZMQ_VERSION_MAJOR == 2
+    wait *= 1000;
+#endif
+
+    try
+    {
+      zmq::poll(&items[0], poll_size, wait);
+
+      if (items[0].revents & ZMQ_POLLIN)
+      {
+        char buff[64];
+
+        while (read(mPipe[0], buff, sizeof(buff)) > 0) ;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSignalled = false;
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        if (mStop)
+          break;
+      }
+
+      for (int i = 0; i < mNumBackends; i++)
+      {
+        if (items[1 + i].revents & ZMQ_POLLIN)
+          RecvReplies(i);
+      }
+
+      blocked = !SendQueued();
+      CheckFailover(Now());
+    }
+    catch (zmq::error_t& err)
+    {
+      if (err.num() == ETERM)
+        break;
+
+      eos_err("ZMQ error in the auth I/O thread: %s", err.what());
+    }
+  }
+
+  eos_info("auth I/O thread exiting");
+}
+
+
+//------------------------------------------------------------------------------
+// Send the queued requests to the current master MGM
+//------------------------------------------------------------------------------
+bool
+RequestMux::SendQueued()
+{
+  while (true)
+  {
+    uint64_t id;
+    int backend;
+    zmq::message_t payload;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      if (mOutgoing.empty())
+        return true;
+
+      id = mOutgoing.front();
+      std::map<uint64_t, Pending*>::iterator it = mPending.find(id);
+
+      if (it == mPending.end())
+      {
+        // Timed out or already answered
+        mOutgoing.pop_front();
+        continue;
+      }
+
+      backend = mMaster;
+      // Shares the buffer, the request is kept in case it has to be resent
+      payload.copy(&it->second->request);
+    }
+
+    zmq::message_t id_frame(sizeof(id));
+    memcpy(id_frame.data(), &id, sizeof(id));
+    zmq::message_t empty_frame;
+
+    // Once the first frame is accepted the rest of the message is as well
+    if (!mSocket[backend]->send(id_frame, ZMQ_SNDMORE | ZMQ_NOBLOCK))
+      return false;
+
+    mSocket[backend]->send(empty_frame, ZMQ_SNDMORE);
+    mSocket[backend]->send(payload, 0);
+    std::unique_lock<std::mutex> lock(mMutex);
+    mOutgoing.pop_front();
+    std::map<uint64_t, Pending*>::iterator it = mPending.find(id);
+
+    if (it != mPending.end())
+      it->second->backend = backend;
+
+    mStats.sent++;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Receive all the replies available on a socket
+//------------------------------------------------------------------------------
+void
+RequestMux::RecvReplies(int backend)
+{
+  zmq::socket_t* socket = mSocket[backend];
+
+  while (true)
+  {
+    zmq::message_t id_frame;
+
+    if (!socket->recv(&id_frame, ZMQ_NOBLOCK))
+      return;
+
+    // Frames: [correlation id][empty][payload]
+    zmq::message_t payload;
+    int num_frames = 1;
+    int more = 1;
+    size_t more_size = sizeof(more);
+    socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+
+    while (more)
+    {
+      socket->recv(&payload);
+      num_frames++;
+      more_size = sizeof(more);
+      socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mLastReply[backend] = Now();
+
+    if ((num_frames != 3) || (id_frame.size() != sizeof(uint64_t)))
+    {
+      eos_err("malformed reply with %i frames from %s", num_frames,
+              mEndpoint[backend].c_str());
+      mStats.dropped++;
+      continue;
+    }
+
+    uint64_t id;
+    memcpy(&id, id_frame.data(), sizeof(id));
+    std::map<uint64_t, Pending*>::iterator it = mPending.find(id);
+
+    if (it == mPending.end())
+    {
+      eos_debug("drop reply id=%llu from %s, request timed out or already "
+                "answered", (unsigned long long) id, mEndpoint[backend].c_str());
+      mStats.dropped++;
+      continue;
+    }
+
+    Pending* pending = it->second;
+    mPending.erase(it);
+    pending->reply.move(&payload);
+    pending->done = true;
+    pending->cond.notify_one();
+    mStats.replies++;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Switch to the other MGM node if the current master does not answer
+//------------------------------------------------------------------------------
+void
+RequestMux::CheckFailover(uint64_t now)
+{
+  if (mNumBackends < 2)
+    return;
+
+  uint64_t delay = mTimeout / 2;
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (mPending.empty() || (now < mLastFailover + delay))
+    return;
+
+  // Oldest request waiting for the current master, ids grow with time
+  Pending* oldest = 0;
+
+  for (std::map<uint64_t, Pending*>::iterator it = mPending.begin();
+       it != mPending.end(); ++it)
+  {
+    if ((it->second->backend == mMaster) || (it->second->backend == -1))
+    {
+      oldest = it->second;
+      break;
+    }
+  }
+
+  // A master answering other requests is busy, not gone
+  if (!oldest || (now < oldest->submitted + delay) ||
+      (mLastReply[mMaster] >= oldest->submitted))
+    return;
+
+  int old_master = mMaster;
+  mMaster = 1 - mMaster;
+  mLastFailover = now;
+  mStats.failovers++;
+  uint64_t resent = 0;
+  uint64_t kept = 0;
+
+  // Requests not sent yet go to the new master anyway. The ones which are not
+  // idempotent may have been executed already, they wait for the old master.
+  for (std::map<uint64_t, Pending*>::iterator it = mPending.begin();
+       it != mPending.end(); ++it)
+  {
+    if (it->second->backend == old_master)
+    {
+      if (it->second->idempotent)
+      {
+        mOutgoing.push_back(it->first);
+        resent++;
+      }
+      else
+      {
+        kept++;
+      }
+    }
+  }
+
+  mStats.resent += resent;
+  mStats.kept += kept;
+  eos_warning("MGM %s did not answer for %llu ms, fail over to %s, resend "
+              "%llu requests and keep %llu requests which are not idempotent",
+              mEndpoint[old_master].c_str(),
+              (unsigned long long)(now - oldest->submitted),
+              mEndpoint[mMaster].c_str(), (unsigned long long) resent,
+              (unsigned long long) kept);
+}
+
+
+//------------------------------------------------------------------------------
+// Check if a request only queries the namespace
+//------------------------------------------------------------------------------
+bool
+RequestMux::IsIdempotent(const RequestProto* request)
+{
+  // The directory and file requests refer to objects living in the MGM which
+  // opened them, FSctl may run any command
+  switch (request->type())
+  {
+  case RequestProto_OperationType_STAT:
+  case RequestProto_OperationType_STATM:
+  case RequestProto_OperationType_EXISTS:
+  case RequestProto_OperationType_CHKSUM:
+  case RequestProto_OperationType_FSCTL1:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Wake up the I/O thread
+//------------------------------------------------------------------------------
+void
+RequestMux::Signal()
+{
+  if (!mSignalled)
+  {
+    mSignalled = true;
+    char c = 0;
+
+    if (write(mPipe[1], &c, 1) != 1)
+      eos_err("unable to wake up the auth I/O thread errno=%i", errno);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Get the current time in milliseconds from a monotonic clock
+//------------------------------------------------------------------------------
+uint64_t
+RequestMux::Now()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+EOSAUTHNAMESPACE_END
@@ -0,0 +1,263 @@
+//------------------------------------------------------------------------------
+// File: RequestMux.hh
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOS_AUTH_REQUESTMUX_HH__
+#define __EOS_AUTH_REQUESTMUX_HH__
+
+/*----------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+/*----------------------------------------------------------------------------*/
+#include "Namespace.hh"
+#include "common/Logging.hh"
+#include "common/ZMQ.hh"
+/*----------------------------------------------------------------------------*/
+
+EOSAUTHNAMESPACE_BEGIN
+
+//! Forward declarations
+class RequestProto;
+class ResponseProto;
+
+//------------------------------------------------------------------------------
+//! Class RequestMux
+/*! Description: multiplexes the requests of all the threads of the auth plugin
+    over one ZMQ DEALER socket per MGM node. Every request is sent as
+    [correlation id][empty][payload] and the MGM returns the envelope with the
+    reply, therefore any number of requests can be in flight at the same time
+    and the replies are matched to the waiting threads by their correlation id,
+    no matter the order in which the MGM answers them. A single I/O thread owns
+    the sockets: the callers hand their serialised request over through a queue
+    and wait on their own condition variable for the reply or for the
+    per-request timeout to expire.
+
+    If the current master does not answer any request during half of the
+    request timeout the other MGM becomes the current master. Only the
+    requests in flight which can be executed twice without harm, i.e. the
+    stat, exists, checksum and locate queries, are resent to it. The others,
+    e.g. a rename or a file open, may already have been executed by the
+    first MGM and stay with it: they get its reply if it recovers in time
+    and fail with a timeout otherwise. When a request is answered by both
+    MGM nodes only the first reply is delivered.
+
+    The ResponseProto objects handed out by Send are recycled by Release so
+    that the buffers allocated while parsing a reply are reused by the
+    following ones.
+*/
+//------------------------------------------------------------------------------
+class RequestMux: public eos::common::LogId
+{
+public:
+
+  //----------------------------------------------------------------------------
+  //! Counters
+  //----------------------------------------------------------------------------
+  struct Stats
+  {
+    Stats(): sent(0), replies(0), timeouts(0), failovers(0), resent(0),
+      kept(0), dropped(0) {}
+
+    uint64_t sent; ///< requests sent
+    uint64_t replies; ///< replies delivered
+    uint64_t timeouts; ///< requests which timed out
+    uint64_t failovers; ///< master switches due to an unresponsive MGM
+    uint64_t resent; ///< requests resent to the other MGM
+    uint64_t kept; ///< requests not resent on failover as not idempotent
+    uint64_t dropped; ///< late or unknown replies
+  };
+
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param context ZMQ context
+  //----------------------------------------------------------------------------
+  RequestMux(zmq::context_t* context);
+
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~RequestMux();
+
+
+  //----------------------------------------------------------------------------
+  //! Connect to the MGM nodes and start the I/O thread
+  //!
+  //! @param master master MGM endpoint "host:port"
+  //! @param slave slave MGM endpoint "host:port", may be empty
+  //! @param timeout default request timeout in milliseconds
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Start(const std::string& master, const std::string& slave,
+             int timeout);
+
+
+  //----------------------------------------------------------------------------
+  //! Stop the I/O thread, requests still waiting time out
+  //----------------------------------------------------------------------------
+  void Stop();
+
+
+  //----------------------------------------------------------------------------
+  //! Send a request to the current master MGM and wait for the reply
+  //!
+  //! @param request request object
+  //! @param timeout timeout in milliseconds, 0 for the default one
+  //!
+  //! @return response object which has to be given back with Release, 0 if
+  //!         the request could not be sent or timed out
+  //----------------------------------------------------------------------------
+  ResponseProto* Send(RequestProto* request, int timeout = 0);
+
+
+  //----------------------------------------------------------------------------
+  //! Give back a response object obtained from Send
+  //----------------------------------------------------------------------------
+  void Release(ResponseProto* response);
+
+
+  //----------------------------------------------------------------------------
+  //! Make one of the MGM nodes the current master
+  //!
+  //! @param host host or "host:port" of the new master
+  //!
+  //! @return true if the host matches one of the MGM nodes, otherwise false
+  //----------------------------------------------------------------------------
+  bool SetMaster(const std::string& host);
+
+
+  //----------------------------------------------------------------------------
+  //! Get the endpoint of the current master MGM
+  //----------------------------------------------------------------------------
+  std::string GetMaster();
+
+
+  //----------------------------------------------------------------------------
+  //! Get the counters
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+private:
+
+  //----------------------------------------------------------------------------
+  //! Request waiting for its reply, lives on the stack of the caller
+  //----------------------------------------------------------------------------
+  struct Pending
+  {
+    Pending(): done(false), idempotent(false), backend(-1), submitted(0) {}
+
+    std::condition_variable cond; ///< signalled when the reply arrived
+    bool done; ///< reply arrived
+    bool idempotent; ///< request can be resent to the other MGM
+    int backend; ///< MGM the request was last sent to, -1 if not yet sent
+    uint64_t submitted; ///< time of submission in milliseconds
+    zmq::message_t request; ///< serialised request kept for resending
+    zmq::message_t reply; ///< serialised reply
+  };
+
+  zmq::context_t* mContext; ///< ZMQ context
+  std::string mEndpoint[2]; ///< MGM endpoints, master and slave
+  zmq::socket_t* mSocket[2]; ///< DEALER sockets connected to the MGM nodes
+  int mNumBackends; ///< number of MGM nodes
+  int mMaster; ///< index of the current master MGM
+  int mTimeout; ///< default request timeout in milliseconds
+  uint64_t mLastReply[2]; ///< time of the last reply from each MGM
+  uint64_t mLastFailover; ///< time of the last master switch
+  int mPipe[2]; ///< pipe used to wake up the I/O thread
+  bool mSignalled; ///< the I/O thread has been woken up
+  bool mStop; ///< the I/O thread has to exit
+  pthread_t mTid; ///< id of the I/O thread
+  uint64_t mLastId; ///< last correlation id handed out
+  std::map<uint64_t, Pending*> mPending; ///< requests waiting for a reply
+  std::deque<uint64_t> mOutgoing; ///< requests to be sent by the I/O thread
+  Stats mStats; ///< counters
+  std::mutex mMutex; ///< protects all of the above shared with the callers
+  std::vector<ResponseProto*> mFreeResponses; ///< recycled response objects
+  std::mutex mFreeMutex; ///< protects the recycled response objects
+
+  //----------------------------------------------------------------------------
+  //! I/O thread startup function
+  //----------------------------------------------------------------------------
+  static void* StartIOThread(void* pp);
+
+
+  //----------------------------------------------------------------------------
+  //! I/O thread sending the queued requests and dispatching the replies
+  //----------------------------------------------------------------------------
+  void IOThread();
+
+
+  //----------------------------------------------------------------------------
+  //! Send the queued requests to the current master MGM
+  //!
+  //! @return true if everything was sent, false if the socket would block
+  //----------------------------------------------------------------------------
+  bool SendQueued();
+
+
+  //----------------------------------------------------------------------------
+  //! Receive all the replies available on a socket
+  //!
+  //! @param backend index of the MGM node
+  //----------------------------------------------------------------------------
+  void RecvReplies(int backend);
+
+
+  //----------------------------------------------------------------------------
+  //! Switch to the other MGM node if the current master does not answer and
+  //! resend the idempotent requests which were sent to it
+  //!
+  //! @param now current time in milliseconds
+  //----------------------------------------------------------------------------
+  void CheckFailover(uint64_t now);
+
+
+  //----------------------------------------------------------------------------
+  //! Check if a request only queries the namespace and can therefore be
+  //! executed again by the other MGM node
+  //----------------------------------------------------------------------------
+  static bool IsIdempotent(const RequestProto* request);
+
+
+  //----------------------------------------------------------------------------
+  //! Wake up the I/O thread, to be called with mMutex held
+  //----------------------------------------------------------------------------
+  void Signal();
+
+
+  //----------------------------------------------------------------------------
+  //! Get the current time in milliseconds from a monotonic clock
+  //----------------------------------------------------------------------------
+  static uint64_t Now();
+};
+
+EOSAUTHNAMESPACE_END
+
+#endif // __EOS_AUTH_REQUESTMUX_HH__
@@ -0,0 +1,454 @@
+//------------------------------------------------------------------------------
+// File: RequestMuxTest.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include <cppunit/extensions/HelperMacros.h>
+/*----------------------------------------------------------------------------*/
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+/*----------------------------------------------------------------------------*/
+#include "auth_plugin/ProtoUtils.hh"
+#include "auth_plugin/RequestBroker.hh"
+#include "auth_plugin/RequestMux.hh"
+#include "XrdOuc/XrdOucErrInfo.hh"
+#include "XrdSec/XrdSecEntity.hh"
+/*----------------------------------------------------------------------------*/
+
+using namespace eos::auth;
+
+//------------------------------------------------------------------------------
+//! RequestMuxTest class - auth plugin and MGM ends of the request forwarding
+//! connected over the loopback interface
+//------------------------------------------------------------------------------
+class RequestMuxTest: public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(RequestMuxTest);
+    CPPUNIT_TEST(ThroughputTest);
+    CPPUNIT_TEST(SlowRequestTest);
+    CPPUNIT_TEST(TimeoutTest);
+    CPPUNIT_TEST(FailoverTest);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+
+  //----------------------------------------------------------------------------
+  //! Many threads sending small requests
+  //----------------------------------------------------------------------------
+  void ThroughputTest();
+
+  //----------------------------------------------------------------------------
+  //! A slow request does not delay the others
+  //----------------------------------------------------------------------------
+  void SlowRequestTest();
+
+  //----------------------------------------------------------------------------
+  //! A request not answered in time fails without affecting the others
+  //----------------------------------------------------------------------------
+  void TimeoutTest();
+
+  //----------------------------------------------------------------------------
+  //! Idempotent requests to an unresponsive master are resent to the slave,
+  //! the others are not
+  //----------------------------------------------------------------------------
+  void FailoverTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RequestMuxTest);
+
+
+//------------------------------------------------------------------------------
+//! MGM end listening on a port of the loopback interface chosen by the system.
+//! The workers reply with the path of the request. Requests whose path starts
+//! with /hold, or all of them for an unresponsive MGM, are only answered once
+//! the test releases them.
+//------------------------------------------------------------------------------
+class LoopbackMgm
+{
+ public:
+
+  LoopbackMgm(zmq::context_t* context, int num_workers,
+              bool unresponsive = false):
+    mBroker(context),
+    mUnresponsive(unresponsive),
+    mReleased(false)
+  {
+    std::ostringstream backend;
+    backend << "inproc://authtest" << this;
+    CPPUNIT_ASSERT(mBroker.Bind("tcp://127.0.0.1:*", backend.str()));
+    mEndpoint = mBroker.GetFrontendEndpoint();
+    CPPUNIT_ASSERT(mEndpoint.find("tcp://") == 0);
+    mEndpoint.erase(0, strlen("tcp://"));
+    mThreads.push_back(std::thread(&RequestBroker::Run, &mBroker));
+
+    for (int i = 0; i < num_workers; i++)
+      mThreads.push_back(std::thread(&LoopbackMgm::Worker, this, context,
+                                     backend.str()));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the "host:port" endpoint the auth plugins connect to
+  //----------------------------------------------------------------------------
+  std::string GetEndpoint() const
+  {
+    return mEndpoint;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait until a request with the given path prefix reached a worker
+  //!
+  //! @return true if such a request arrived within the timeout
+  //----------------------------------------------------------------------------
+  bool WaitReceived(const std::string& prefix, int timeout)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mCond.wait_for(lock, std::chrono::milliseconds(timeout), [&]() -> bool
+    {
+      for (size_t i = 0; i < mReceived.size(); i++)
+      {
+        if (mReceived[i].find(prefix) == 0)
+          return true;
+      }
+
+      return false;
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  //! Answer the held requests, has to be done before terminating the context
+  //----------------------------------------------------------------------------
+  void Release()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mReleased = true;
+    mCond.notify_all();
+  }
+
+  //----------------------------------------------------------------------------
+  //! The threads exit once the ZMQ context is terminated
+  //----------------------------------------------------------------------------
+  void Join()
+  {
+    for (size_t i = 0; i < mThreads.size(); i++)
+      mThreads[i].join();
+  }
+
+ private:
+
+  void Worker(zmq::context_t* context, std::string backend)
+  {
+    try
+    {
+      zmq::socket_t socket(*context, ZMQ_DEALER);
+      int linger = 0;
+      socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+
+      if (!RequestBroker::ConnectWorker(socket, backend))
+        return;
+
+      while (true)
+      {
+        zmq::message_t request;
+        std::vector<std::string> envelope;
+
+        if (!RequestBroker::RecvRequest(socket, envelope, request))
+          continue;
+
+        RequestProto req_proto;
+        req_proto.ParseFromArray(request.data(), request.size());
+        std::string path =
+          (req_proto.type() == RequestProto_OperationType_MKDIR) ?
+          req_proto.mkdir().path() : req_proto.stat().path();
+        {
+          std::unique_lock<std::mutex> lock(mMutex);
+          mReceived.push_back(path);
+          mCond.notify_all();
+
+          if (mUnresponsive || (path.find("/hold") == 0))
+            mCond.wait(lock, [this]() { return mReleased; });
+        }
+
+        ResponseProto resp;
+        resp.set_response(SFS_OK);
+        resp.set_message(path);
+        zmq::message_t reply(resp.ByteSize());
+        resp.SerializeToArray(reply.data(), reply.size());
+        RequestBroker::SendReply(socket, envelope, reply);
+      }
+    }
+    catch (zmq::error_t& err)
+    {
+      // Context terminated
+    }
+  }
+
+  RequestBroker mBroker;
+  std::string mEndpoint; ///< "host:port" of the frontend
+  bool mUnresponsive; ///< hold all of the requests
+  bool mReleased; ///< the held requests can be answered
+  std::vector<std::string> mReceived; ///< paths of the received requests
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  std::vector<std::thread> mThreads;
+};
+
+
+//------------------------------------------------------------------------------
+//! Send a request and check the response matches its path
+//------------------------------------------------------------------------------
+static bool
+RoundTrip(RequestMux& mux, RequestProto* req_proto, const std::string& path)
+{
+  ResponseProto* resp = mux.Send(req_proto);
+  bool ok = (resp && (resp->response() == SFS_OK) &&
+             (resp->message() == path));
+  mux.Release(resp);
+  delete req_proto;
+  return ok;
+}
+
+
+//------------------------------------------------------------------------------
+//! Send a stat request and check the response matches it
+//------------------------------------------------------------------------------
+static bool
+StatRoundTrip(RequestMux& mux, const std::string& path)
+{
+  XrdOucErrInfo error("test");
+  XrdSecEntity client("unix");
+  return RoundTrip(mux, utils::GetStatRequest(RequestProto_OperationType_STAT,
+                                              path.c_str(), error, &client,
+                                              ""), path);
+}
+
+
+//------------------------------------------------------------------------------
+//! Send a mkdir request and check the response matches it
+//------------------------------------------------------------------------------
+static bool
+MkdirRoundTrip(RequestMux& mux, const std::string& path)
+{
+  XrdOucErrInfo error("test");
+  XrdSecEntity client("unix");
+  return RoundTrip(mux, utils::GetMkdirRequest(path.c_str(), 0755, error,
+                                               &client, ""), path);
+}
+
+
+//------------------------------------------------------------------------------
+//! Run num_threads threads each doing num_requests round trips
+//!
+//! @return number of failed round trips
+//------------------------------------------------------------------------------
+static int
+RunClients(RequestMux& mux, int num_threads, int num_requests,
+           const std::string& prefix)
+{
+  std::atomic<int> failed(0);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < num_threads; t++)
+  {
+    threads.push_back(std::thread([&, t]()
+    {
+      for (int i = 0; i < num_requests; i++)
+      {
+        std::ostringstream path;
+        path << prefix << "/" << t << "/" << i;
+
+        if (!StatRoundTrip(mux, path.str()))
+          failed++;
+      }
+    }));
+  }
+
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+
+  return failed;
+}
+
+
+//------------------------------------------------------------------------------
+//! Wait until the counters of the mux satisfy a condition, the I/O thread
+//! updates them asynchronously e.g. when dropping a late reply
+//!
+//! @return true if the condition was met within the timeout
+//------------------------------------------------------------------------------
+static bool
+WaitStats(RequestMux& mux, std::function<bool(const RequestMux::Stats&)> cond,
+          int timeout)
+{
+  std::chrono::steady_clock::time_point deadline =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+  while (!cond(mux.GetStats()))
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Many threads sending small requests
+//------------------------------------------------------------------------------
+void
+RequestMuxTest::ThroughputTest()
+{
+  zmq::context_t* context = new zmq::context_t(1);
+  LoopbackMgm mgm(context, 8);
+  int num_threads = 32;
+  int num_requests = 2000;
+  {
+    RequestMux mux(context);
+    CPPUNIT_ASSERT(mux.Start(mgm.GetEndpoint(), "", 5000));
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    CPPUNIT_ASSERT_EQUAL(0, RunClients(mux, num_threads, num_requests, "/fast"));
+    double elapsed = std::chrono::duration<double>
+                     (std::chrono::steady_clock::now() - start).count();
+    std::cerr << std::endl << "auth request round trips: "
+              << num_threads * num_requests << " in " << elapsed << " s = "
+              << num_threads * num_requests / elapsed << " Hz" << std::endl;
+    RequestMux::Stats stats = mux.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)(num_threads * num_requests), stats.replies);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 0, stats.timeouts);
+  }
+  delete context;
+  mgm.Join();
+}
+
+
+//------------------------------------------------------------------------------
+// A slow request does not delay the others
+//------------------------------------------------------------------------------
+void
+RequestMuxTest::SlowRequestTest()
+{
+  zmq::context_t* context = new zmq::context_t(1);
+  LoopbackMgm mgm(context, 4);
+  {
+    RequestMux mux(context);
+    CPPUNIT_ASSERT(mux.Start(mgm.GetEndpoint(), "", 5000));
+    std::atomic<bool> slow_done(false);
+    std::atomic<bool> slow_ok(false);
+    std::thread slow([&]()
+    {
+      slow_ok = StatRoundTrip(mux, "/hold/ls");
+      slow_done = true;
+    });
+    // The slow request keeps one worker busy until it is released
+    CPPUNIT_ASSERT(mgm.WaitReceived("/hold", 5000));
+    CPPUNIT_ASSERT_EQUAL(0, RunClients(mux, 8, 100, "/fast"));
+    CPPUNIT_ASSERT(!slow_done);
+    mgm.Release();
+    slow.join();
+    CPPUNIT_ASSERT(slow_ok);
+  }
+  delete context;
+  mgm.Join();
+}
+
+
+//------------------------------------------------------------------------------
+// A request not answered in time fails without affecting the others
+//------------------------------------------------------------------------------
+void
+RequestMuxTest::TimeoutTest()
+{
+  zmq::context_t* context = new zmq::context_t(1);
+  LoopbackMgm mgm(context, 2);
+  {
+    RequestMux mux(context);
+    CPPUNIT_ASSERT(mux.Start(mgm.GetEndpoint(), "", 500));
+    CPPUNIT_ASSERT(!StatRoundTrip(mux, "/hold/ls"));
+    CPPUNIT_ASSERT(mgm.WaitReceived("/hold", 0));
+    CPPUNIT_ASSERT_EQUAL(0, RunClients(mux, 2, 10, "/fast"));
+    // The late reply is dropped
+    mgm.Release();
+    CPPUNIT_ASSERT(WaitStats(mux, [](const RequestMux::Stats & stats)
+    {
+      return stats.dropped == 1;
+    }, 5000));
+    RequestMux::Stats stats = mux.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 1, stats.timeouts);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 1, stats.dropped);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 20, stats.replies);
+  }
+  delete context;
+  mgm.Join();
+}
+
+
+//------------------------------------------------------------------------------
+// Idempotent requests to an unresponsive master are resent to the slave
+//------------------------------------------------------------------------------
+void
+RequestMuxTest::FailoverTest()
+{
+  zmq::context_t* context = new zmq::context_t(1);
+  LoopbackMgm master(context, 4, true);
+  LoopbackMgm slave(context, 4);
+  {
+    RequestMux mux(context);
+    // The master never answers, fail over after one second
+    CPPUNIT_ASSERT(mux.Start(master.GetEndpoint(), slave.GetEndpoint(), 2000));
+    std::atomic<bool> mkdir_ok(true);
+    std::thread mkdir([&]()
+    {
+      mkdir_ok = MkdirRoundTrip(mux, "/mkdir/ls");
+    });
+    // The mkdir may have been executed by the master, it is not resent
+    CPPUNIT_ASSERT(master.WaitReceived("/mkdir", 5000));
+    CPPUNIT_ASSERT_EQUAL(0, RunClients(mux, 8, 10, "/fast"));
+    mkdir.join();
+    CPPUNIT_ASSERT(!mkdir_ok);
+    CPPUNIT_ASSERT(!slave.WaitReceived("/mkdir", 0));
+    RequestMux::Stats stats = mux.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 1, stats.failovers);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 8, stats.resent);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 1, stats.kept);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 1, stats.timeouts);
+    CPPUNIT_ASSERT_EQUAL(slave.GetEndpoint(), mux.GetMaster());
+    // A redirect to the master switches back
+    CPPUNIT_ASSERT(mux.SetMaster(master.GetEndpoint()));
+    CPPUNIT_ASSERT(!mux.SetMaster("unknown.cern.ch"));
+    CPPUNIT_ASSERT_EQUAL(master.GetEndpoint(), mux.GetMaster());
+  }
+  master.Release();
+  delete context;
+  master.Join();
+  slave.Join();
+}
@@ -36,6 +36,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <openssl/sha.h>
+#include <map>
+#include <string>
 
 #ifdef __APPLE__
 #define ENOKEY 126
@@ -47,6 +50,202 @@ XrdSysError TkEroute(0,"capability");
 XrdOucTrace TkTrace(&TkEroute);
 /*----------------------------------------------------------------------------*/
 XrdCapability gCapabilityEngine;
+XrdCapability::Format XrdCapability::sFormat = XrdCapability::kLegacy;
+
+/*----------------------------------------------------------------------------*/
+// HMAC capability layout: header (u32 magic, u32 payload length, u64 expiry
+// time, all big endian), payload (capability environment) and the first
+// kHmacMacLength bytes of the HMAC-SHA256 of header and payload
+/*----------------------------------------------------------------------------*/
+static const uint32_t kHmacMagic = 0x45434831; // "ECH1"
+static const size_t kHmacHeaderLength = 16;
+static const size_t kHmacMacLength = 16;
+static const size_t kHmacMaxContexts = 64;
+
+/*----------------------------------------------------------------------------*/
+// SHA256 states after absorbing the inner and outer padded key of a symmetric
+// key. An HMAC then only costs the hashing of the message plus one block.
+/*----------------------------------------------------------------------------*/
+struct HmacKeyContext {
+  char digest64[SHA_DIGEST_LENGTH * 2];
+  SHA256_CTX inner;
+  SHA256_CTX outer;
+};
+
+static XrdSysMutex sHmacMutex;
+static std::map<std::string, HmacKeyContext> sHmacContexts;
+static thread_local HmacKeyContext tHmacContext; // last context used by thread
+
+/*----------------------------------------------------------------------------*/
+// Get the cached HMAC context of a key, valid until the next call
+/*----------------------------------------------------------------------------*/
+static const HmacKeyContext*
+GetHmacContext(eos::common::SymKey* key)
+{
+  if (!strcmp(tHmacContext.digest64, key->GetDigest64())) {
+    return &tHmacContext;
+  }
+
+  XrdSysMutexHelper lock(sHmacMutex);
+  std::map<std::string, HmacKeyContext>::iterator it =
+    sHmacContexts.find(key->GetDigest64());
+
+  if (it == sHmacContexts.end()) {
+    // keys are added but never removed from the key store, bound the cache
+    if (sHmacContexts.size() >= kHmacMaxContexts) {
+      sHmacContexts.clear();
+    }
+
+    HmacKeyContext ctx;
+    unsigned char ipad[SHA256_CBLOCK];
+    unsigned char opad[SHA256_CBLOCK];
+    memset(ipad, 0x36, sizeof(ipad));
+    memset(opad, 0x5c, sizeof(opad));
+
+    for (int i = 0; i < SHA_DIGEST_LENGTH; ++i) {
+      ipad[i] ^= (unsigned char) key->GetKey()[i];
+      opad[i] ^= (unsigned char) key->GetKey()[i];
+    }
+
+    memset(ctx.digest64, 0, sizeof(ctx.digest64));
+    strncpy(ctx.digest64, key->GetDigest64(), sizeof(ctx.digest64) - 1);
+    SHA256_Init(&ctx.inner);
+    SHA256_Update(&ctx.inner, ipad, sizeof(ipad));
+    SHA256_Init(&ctx.outer);
+    SHA256_Update(&ctx.outer, opad, sizeof(opad));
+    it = sHmacContexts.insert(std::make_pair(std::string(ctx.digest64),
+                              ctx)).first;
+  }
+
+  tHmacContext = it->second;
+  return &tHmacContext;
+}
+
+/*----------------------------------------------------------------------------*/
+// Compute the truncated HMAC-SHA256 of a buffer
+/*----------------------------------------------------------------------------*/
+static void
+ComputeHmac(const HmacKeyContext* key, const char* data, size_t len,
+            unsigned char* mac)
+{
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256_CTX ctx = key->inner;
+  SHA256_Update(&ctx, data, len);
+  SHA256_Final(digest, &ctx);
+  ctx = key->outer;
+  SHA256_Update(&ctx, digest, sizeof(digest));
+  SHA256_Final(digest, &ctx);
+  memcpy(mac, digest, kHmacMacLength);
+}
+
+/*----------------------------------------------------------------------------*/
+// Big endian integer coding
+/*----------------------------------------------------------------------------*/
+static void
+PutUInt(char* out, uint64_t value, int len)
+{
+  for (int i = len - 1; i >= 0; --i, value >>= 8) {
+    out[i] = (char)(value & 0xff);
+  }
+}
+
+static uint64_t
+GetUInt(const char* in, int len)
+{
+  uint64_t value = 0;
+
+  for (int i = 0; i < len; ++i) {
+    value = (value << 8) | (unsigned char) in[i];
+  }
+
+  return value;
+}
+
+/*----------------------------------------------------------------------------*/
+// Base64url coding without padding - the result can be passed in an URL
+// without escaping
+/*----------------------------------------------------------------------------*/
+static const char kBase64Url[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static void
+Base64UrlEncode(const char* in, size_t len, std::string& out)
+{
+  out.clear();
+  out.reserve((len * 4 + 2) / 3);
+  const unsigned char* p = (const unsigned char*) in;
+  size_t i = 0;
+
+  for (; i + 2 < len; i += 3) {
+    uint32_t v = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+    out += kBase64Url[(v >> 18) & 0x3f];
+    out += kBase64Url[(v >> 12) & 0x3f];
+    out += kBase64Url[(v >> 6) & 0x3f];
+    out += kBase64Url[v & 0x3f];
+  }
+
+  if (i + 1 == len) {
+    uint32_t v = p[i] << 16;
+    out += kBase64Url[(v >> 18) & 0x3f];
+    out += kBase64Url[(v >> 12) & 0x3f];
+  } else if (i + 2 == len) {
+    uint32_t v = (p[i] << 16) | (p[i + 1] << 8);
+    out += kBase64Url[(v >> 18) & 0x3f];
+    out += kBase64Url[(v >> 12) & 0x3f];
+    out += kBase64Url[(v >> 6) & 0x3f];
+  }
+}
+
+static int
+Base64UrlValue(char c)
+{
+  if ((c >= 'A') && (c <= 'Z')) {
+    return c - 'A';
+  }
+
+  if ((c >= 'a') && (c <= 'z')) {
+    return c - 'a' + 26;
+  }
+
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0' + 52;
+  }
+
+  return (c == '-') ? 62 : ((c == '_') ? 63 : -1);
+}
+
+static bool
+Base64UrlDecode(const char* in, std::string& out)
+{
+  size_t len = strlen(in);
+
+  if (len % 4 == 1) {
+    return false;
+  }
+
+  out.clear();
+  out.reserve(len * 3 / 4);
+  uint32_t v = 0;
+  int bits = 0;
+
+  for (size_t i = 0; i < len; ++i) {
+    int c = Base64UrlValue(in[i]);
+
+    if (c < 0) {
+      return false;
+    }
+
+    v = (v << 6) | c;
+    bits += 6;
+
+    if (bits >= 8) {
+      bits -= 8;
+      out += (char)((v >> bits) & 0xff);
+    }
+  }
+
+  return true;
+}
 
 /*----------------------------------------------------------------------------*/
 XrdAccPrivs
@@ -103,6 +302,21 @@ XrdCapability::Create(XrdOucEnv *inenv,
                       eos::common::SymKey* key,
                       uint64_t cap_validity)
 {
+  return Create(inenv, outenv, key, cap_validity, sFormat);
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdCapability::Create(XrdOucEnv *inenv, 
+                      XrdOucEnv* &outenv, 
+                      eos::common::SymKey* key,
+                      uint64_t cap_validity,
+                      Format format)
+{
+  if (format == kHmac) {
+    return CreateHmac(inenv, outenv, key, cap_validity);
+  }
+
   outenv = 0;
 
   if (!key)
@@ -143,6 +357,25 @@ XrdCapability::Extract(XrdOucEnv *inenv, XrdOucEnv* &outenv)
   if (!inenv)
     return EINVAL;
 
+  // ---------------------------------------------------------------------------
+  // HMAC capabilities need neither decryption nor the '#' fix-up
+  // ---------------------------------------------------------------------------
+  const char* symmac = inenv->Get("cap.mac");
+
+  if (symmac) {
+    const char* symkey = inenv->Get("cap.sym");
+
+    if (!symkey)
+      return EINVAL;
+
+    eos::common::SymKey* key = eos::common::gSymKeyStore.GetKey(symkey);
+
+    if (!key)
+      return ENOKEY;
+
+    return ExtractHmac(key, symmac, outenv);
+  }
+
   int envlen;
   XrdOucString instring = inenv->Env(envlen);
   while (instring.replace('#','\n')) {};
@@ -187,6 +420,97 @@ XrdCapability::Extract(XrdOucEnv *inenv, XrdOucEnv* &outenv)
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+int
+XrdCapability::CreateHmac(XrdOucEnv *inenv,
+                          XrdOucEnv* &outenv,
+                          eos::common::SymKey* key,
+                          uint64_t cap_validity)
+{
+  outenv = 0;
+
+  if (!key)
+    return ENOKEY;
+
+  if (!inenv) 
+    return EINVAL;
+
+  int envlen = 0;
+  const char* env = inenv->Env(envlen);
+
+  if (envlen < 0)
+    return EINVAL;
+
+  std::string blob;
+  blob.resize(kHmacHeaderLength + envlen + kHmacMacLength);
+  char* p = &blob[0];
+  PutUInt(p, kHmacMagic, 4);
+  PutUInt(p + 4, envlen, 4);
+  PutUInt(p + 8, time(NULL) + cap_validity, 8);
+  memcpy(p + kHmacHeaderLength, env, envlen);
+  ComputeHmac(GetHmacContext(key), p, kHmacHeaderLength + envlen,
+              (unsigned char*) p + kHmacHeaderLength + envlen);
+  std::string encoded;
+  Base64UrlEncode(blob.c_str(), blob.length(), encoded);
+  std::string encenv = "cap.sym=";
+  encenv += key->GetDigest64();
+  encenv += "&cap.mac=";
+  encenv += encoded;
+  outenv = new XrdOucEnv(encenv.c_str());
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdCapability::ExtractHmac(eos::common::SymKey* key,
+                           const char* symmac,
+                           XrdOucEnv* &outenv)
+{
+  std::string blob;
+
+  if (!Base64UrlDecode(symmac, blob) ||
+      (blob.length() < kHmacHeaderLength + kHmacMacLength))
+    return EINVAL;
+
+  const char* p = blob.c_str();
+  uint64_t envlen = GetUInt(p + 4, 4);
+
+  if ((GetUInt(p, 4) != kHmacMagic) ||
+      (blob.length() != kHmacHeaderLength + envlen + kHmacMacLength))
+    return EINVAL;
+
+  unsigned char mac[kHmacMacLength];
+  ComputeHmac(GetHmacContext(key), p, kHmacHeaderLength + envlen, mac);
+  const unsigned char* inmac =
+    (const unsigned char*) p + kHmacHeaderLength + envlen;
+  unsigned char diff = 0;
+
+  // constant time comparison
+  for (size_t i = 0; i < kHmacMacLength; ++i) {
+    diff |= mac[i] ^ inmac[i];
+  }
+
+  if (diff)
+    return EKEYREJECTED;
+
+  // ---------------------------------------------------------------------------
+  // rebuild the environment as the legacy format returns it
+  // ---------------------------------------------------------------------------
+  uint64_t valid = GetUInt(p + 8, 8);
+  std::string env(p + kHmacHeaderLength, envlen);
+  char validity[32];
+  snprintf(validity, sizeof(validity), "&cap.valid=%llu",
+           (unsigned long long) valid);
+  env += validity;
+  outenv = new XrdOucEnv(env.c_str());
+
+  // capability expired!
+  if (valid < (uint64_t) time(NULL))
+    return ETIME;
+
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
@@ -95,14 +95,68 @@ public:
 
   XrdCapability(){}
 
+  //----------------------------------------------------------------------------
+  //! Capability formats
+  //!
+  //! kLegacy: the capability environment is encrypted with the symmetric key
+  //!          and passed as 'cap.sym=<key digest>&cap.msg=<encrypted env>'
+  //! kHmac:   the capability environment is passed in clear in a binary
+  //!          layout authenticated with a truncated HMAC-SHA256 as
+  //!          'cap.sym=<key digest>&cap.mac=<base64url blob>'. It is much
+  //!          cheaper to create and to verify but the content is readable by
+  //!          the client.
+  //!
+  //! Extract always accepts both formats.
+  //----------------------------------------------------------------------------
+  enum Format { kLegacy = 0, kHmac = 1 };
+
+  //----------------------------------------------------------------------------
+  //! Set/get the format used by Create
+  //----------------------------------------------------------------------------
+  static void SetFormat(Format format) { sFormat = format; }
+  static Format GetFormat() { return sFormat; }
+
+  //----------------------------------------------------------------------------
+  //! Create a capability in the configured format
+  //!
+  //! @param inenv capability environment
+  //! @param outenv returns the capability
+  //! @param symkey key to sign/encrypt with
+  //! @param cap_validity validity in seconds
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
   static int Create(XrdOucEnv *inenv, XrdOucEnv* &outenv,
                     eos::common::SymKey* symkey, uint64_t cap_validity);
 
+  //----------------------------------------------------------------------------
+  //! Create a capability in the given format
+  //----------------------------------------------------------------------------
+  static int Create(XrdOucEnv *inenv, XrdOucEnv* &outenv,
+                    eos::common::SymKey* symkey, uint64_t cap_validity,
+                    Format format);
+
+  //----------------------------------------------------------------------------
+  //! Verify a capability in any format and extract its environment
+  //!
+  //! @param inenv environment holding the capability
+  //! @param outenv returns the capability environment, the caller has to
+  //!        delete it also if an error is returned
+  //!
+  //! @return 0 if successful, ETIME if expired, otherwise errno
+  //----------------------------------------------------------------------------
   static int Extract(XrdOucEnv *inenv, XrdOucEnv* &outenv);
 
   virtual                  ~XrdCapability();
 
 private:
+  static Format sFormat; ///< format used by Create
+
+  static int CreateHmac(XrdOucEnv *inenv, XrdOucEnv* &outenv,
+                        eos::common::SymKey* symkey, uint64_t cap_validity);
+
+  static int ExtractHmac(eos::common::SymKey* symkey, const char* symmac,
+                         XrdOucEnv* &outenv);
 };
 
 /*----------------------------------------------------------------------------*/
@@ -0,0 +1,246 @@
+//------------------------------------------------------------------------------
+//! @file XrdCapabilityTest.cc
+//! @author agent <agent@local>
+//! @brief Unit tests for the HMAC capability format
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "XrdCapabilityTest.hh"
+#include "authz/XrdCapability.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char* gEnv = "mgm.access=read&mgm.ruid=1234&mgm.path=/eos/a/b";
+
+//------------------------------------------------------------------------------
+// Create an HMAC capability and return its cap.sym and cap.mac values
+//------------------------------------------------------------------------------
+static int
+CreateCap(const std::string& keydigest, const std::string& env,
+          uint64_t validity, std::string& sym, std::string& mac)
+{
+  XrdOucEnv inenv(env.c_str());
+  XrdOucEnv* capenv = 0;
+  eos::common::SymKey* key =
+    eos::common::gSymKeyStore.GetKey(keydigest.c_str());
+  int rc = XrdCapability::Create(&inenv, capenv, key, validity,
+                                 XrdCapability::kHmac);
+
+  if (!rc) {
+    sym = capenv->Get("cap.sym") ? capenv->Get("cap.sym") : "";
+    mac = capenv->Get("cap.mac") ? capenv->Get("cap.mac") : "";
+  }
+
+  delete capenv;
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Extract a capability given by its cap.sym and cap.mac values
+//------------------------------------------------------------------------------
+static int
+ExtractCap(const std::string& sym, const std::string& mac,
+           std::string* path = 0)
+{
+  std::string cap = "cap.mac=" + mac;
+
+  if (!sym.empty()) {
+    cap += "&cap.sym=" + sym;
+  }
+
+  XrdOucEnv capenv(cap.c_str());
+  XrdOucEnv* outenv = 0;
+  int rc = XrdCapability::Extract(&capenv, outenv);
+
+  if (path && outenv && outenv->Get("mgm.path")) {
+    *path = outenv->Get("mgm.path");
+  }
+
+  delete outenv;
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Replace one base64url character by another valid one
+//------------------------------------------------------------------------------
+static std::string
+Flip(const std::string& mac, size_t pos)
+{
+  std::string out = mac;
+  out[pos] = (out[pos] == 'A') ? 'B' : 'A';
+  return out;
+}
+
+void XrdCapabilityTest::setUp()
+{
+  eos::common::SymKey* other =
+    eos::common::gSymKeyStore.SetKey64("YWJjZGVmZ2hpamtsbW5vcHFyc3Q=", 0);
+  eos::common::SymKey* key =
+    eos::common::gSymKeyStore.SetKey64("MTIzNDU2Nzg5MDEyMzQ1Njc4OTA=", 0);
+  CPPUNIT_ASSERT(other && key);
+  mOtherKey = other->GetDigest64();
+  mKey = key->GetDigest64();
+  CPPUNIT_ASSERT(mKey != mOtherKey);
+}
+
+void XrdCapabilityTest::RoundTripTest()
+{
+  std::string sym, mac, path;
+  time_t now = time(NULL);
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+  CPPUNIT_ASSERT(sym == mKey);
+  // the value is passed in an URL without escaping
+  CPPUNIT_ASSERT(mac.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                       "abcdefghijklmnopqrstuvwxyz0123456789-_")
+                 == std::string::npos);
+  XrdOucEnv capenv(("cap.sym=" + sym + "&cap.mac=" + mac).c_str());
+  XrdOucEnv* outenv = 0;
+  CPPUNIT_ASSERT_EQUAL(0, XrdCapability::Extract(&capenv, outenv));
+  CPPUNIT_ASSERT(outenv);
+  CPPUNIT_ASSERT(std::string(outenv->Get("mgm.access")) == "read");
+  CPPUNIT_ASSERT(std::string(outenv->Get("mgm.ruid")) == "1234");
+  CPPUNIT_ASSERT(std::string(outenv->Get("mgm.path")) == "/eos/a/b");
+  CPPUNIT_ASSERT(outenv->Get("cap.valid"));
+  time_t valid = strtoull(outenv->Get("cap.valid"), 0, 10);
+  CPPUNIT_ASSERT(valid >= now + 3600);
+  CPPUNIT_ASSERT(valid <= time(NULL) + 3600);
+  delete outenv;
+}
+
+void XrdCapabilityTest::EdgeLengthTest()
+{
+  // the blob holds 32 bytes besides the environment, three consecutive
+  // environment lengths cover the base64url tails of 0, 2 and 3 characters
+  std::string env = std::string(gEnv) + "&mgm.pad=";
+  size_t tails[3] = { 0, 0, 0 };
+
+  for (int i = 0; i < 3; ++i) {
+    std::string sym, mac, path;
+    CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, env, 3600, sym, mac));
+    tails[mac.length() % 4 == 0 ? 0 : mac.length() % 4 - 1]++;
+    CPPUNIT_ASSERT(mac.length() % 4 != 1);
+    CPPUNIT_ASSERT_EQUAL(0, ExtractCap(sym, mac, &path));
+    CPPUNIT_ASSERT(path == "/eos/a/b");
+    // one character more can never be a valid encoding
+    CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap(sym, mac + "A"));
+    env += "x";
+  }
+
+  CPPUNIT_ASSERT(tails[0] == 1 && tails[1] == 1 && tails[2] == 1);
+  // characters outside of the base64url alphabet
+  std::string sym, mac;
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+  const char* invalid[] = { "+", "/", "=", "." };
+
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    std::string bad = mac;
+    bad.replace(mac.length() / 2, 1, invalid[i]);
+    CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap(sym, bad));
+  }
+
+  CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap(sym, ""));
+}
+
+void XrdCapabilityTest::TamperTest()
+{
+  std::string sym, mac;
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+  // Characters 22 and beyond only hold payload and MAC bits. The lowest bit
+  // of the last character may be padding which is dropped when decoding.
+  for (size_t pos = 22; pos < mac.length() - 1; ++pos) {
+    CPPUNIT_ASSERT_EQUAL(EKEYREJECTED, ExtractCap(sym, Flip(mac, pos)));
+  }
+
+  // a modified expiry time is covered by the MAC as well
+  CPPUNIT_ASSERT_EQUAL(EKEYREJECTED, ExtractCap(sym, Flip(mac, 18)));
+  CPPUNIT_ASSERT_EQUAL(0, ExtractCap(sym, mac));
+}
+
+void XrdCapabilityTest::TruncateTest()
+{
+  std::string sym, mac;
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+
+  // every shorter capability is refused, also if the cut leaves a valid
+  // base64url length or removes exactly the MAC
+  for (size_t len = 0; len < mac.length(); ++len) {
+    CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap(sym, mac.substr(0, len)));
+  }
+}
+
+void XrdCapabilityTest::HeaderTest()
+{
+  std::string sym, mac;
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+
+  // the lowest bit of characters 0-9 falls into the magic (bytes 0-3) or the
+  // payload length (bytes 4-7)
+  for (size_t pos = 0; pos < 10; ++pos) {
+    CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap(sym, Flip(mac, pos)));
+  }
+}
+
+void XrdCapabilityTest::KeyTest()
+{
+  std::string sym, mac, other_sym, other_mac;
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 3600, sym, mac));
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mOtherKey, gEnv, 3600, other_sym,
+                                    other_mac));
+  CPPUNIT_ASSERT(sym != other_sym);
+  CPPUNIT_ASSERT(mac != other_mac);
+  CPPUNIT_ASSERT_EQUAL(0, ExtractCap(other_sym, other_mac));
+  // a known key which did not sign the capability
+  CPPUNIT_ASSERT_EQUAL(EKEYREJECTED, ExtractCap(other_sym, mac));
+  CPPUNIT_ASSERT_EQUAL(EKEYREJECTED, ExtractCap(sym, other_mac));
+  // an unknown key
+  CPPUNIT_ASSERT_EQUAL(ENOKEY, ExtractCap("AAAAAAAAAAAAAAAAAAAAAAAAAAA=", mac));
+  // no key at all
+  CPPUNIT_ASSERT_EQUAL(EINVAL, ExtractCap("", mac));
+  // no key to sign with
+  XrdOucEnv inenv(gEnv);
+  XrdOucEnv* capenv = 0;
+  CPPUNIT_ASSERT_EQUAL(ENOKEY, XrdCapability::Create(&inenv, capenv, 0, 3600,
+                       XrdCapability::kHmac));
+  CPPUNIT_ASSERT(!capenv);
+}
+
+void XrdCapabilityTest::ExpiryTest()
+{
+  std::string sym, mac, path;
+  // the validity is added to the current time modulo 2^64, this creates a
+  // capability which expired 10 seconds ago
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, (uint64_t)(-10), sym, mac));
+  CPPUNIT_ASSERT_EQUAL(ETIME, ExtractCap(sym, mac, &path));
+  // the environment is still returned
+  CPPUNIT_ASSERT(path == "/eos/a/b");
+  CPPUNIT_ASSERT_EQUAL(0, CreateCap(mKey, gEnv, 10, sym, mac));
+  CPPUNIT_ASSERT_EQUAL(0, ExtractCap(sym, mac));
+}
+
+int main(int argc, char** argv)
+{
+  CppUnit::TextUi::TestRunner runner;
+  CppUnit::TestFactoryRegistry& registry =
+    CppUnit::TestFactoryRegistry::getRegistry();
+  runner.addTest(registry.makeTest());
+  return runner.run() ? 0 : 1;
+}
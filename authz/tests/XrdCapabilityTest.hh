@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+//! @file XrdCapabilityTest.hh
+//! @author agent <agent@local>
+//! @brief Unit tests for the HMAC capability format
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+#ifndef __EOSAUTHZTEST_XRDCAPABILITYTEST_HH__
+#define __EOSAUTHZTEST_XRDCAPABILITYTEST_HH__
+
+#include <string>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class XrdCapabilityTest: public CppUnit::TestCase
+{
+public:
+  void setUp();
+
+  CPPUNIT_TEST_SUITE(XrdCapabilityTest);
+  CPPUNIT_TEST(RoundTripTest);
+  CPPUNIT_TEST(EdgeLengthTest);
+  CPPUNIT_TEST(TamperTest);
+  CPPUNIT_TEST(TruncateTest);
+  CPPUNIT_TEST(HeaderTest);
+  CPPUNIT_TEST(KeyTest);
+  CPPUNIT_TEST(ExpiryTest);
+  CPPUNIT_TEST_SUITE_END();
+
+  //----------------------------------------------------------------------------
+  //! An HMAC capability extracts to its environment plus the validity
+  //----------------------------------------------------------------------------
+  void RoundTripTest();
+
+  //----------------------------------------------------------------------------
+  //! Capabilities of every base64url tail length round trip, malformed
+  //! base64url is rejected
+  //----------------------------------------------------------------------------
+  void EdgeLengthTest();
+
+  //----------------------------------------------------------------------------
+  //! A modified payload or MAC is rejected with EKEYREJECTED
+  //----------------------------------------------------------------------------
+  void TamperTest();
+
+  //----------------------------------------------------------------------------
+  //! A truncated capability is rejected with EINVAL
+  //----------------------------------------------------------------------------
+  void TruncateTest();
+
+  //----------------------------------------------------------------------------
+  //! A wrong magic or payload length is rejected with EINVAL
+  //----------------------------------------------------------------------------
+  void HeaderTest();
+
+  //----------------------------------------------------------------------------
+  //! A missing, unknown or wrong cap.sym is rejected
+  //----------------------------------------------------------------------------
+  void KeyTest();
+
+  //----------------------------------------------------------------------------
+  //! An expired capability returns ETIME
+  //----------------------------------------------------------------------------
+  void ExpiryTest();
+
+private:
+  std::string mKey; ///< digest of the signing key
+  std::string mOtherKey; ///< digest of another key of the key store
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(XrdCapabilityTest);
+
+#endif // __EOSAUTHZTEST_XRDCAPABILITYTEST_HH__
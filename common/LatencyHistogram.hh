@@ -0,0 +1,227 @@
+// ----------------------------------------------------------------------
+// File: LatencyHistogram.hh
+// Author: agent <agent@local>
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/**
+ * @file   LatencyHistogram.hh
+ *
+ * @brief  Fixed size log-linear histogram for latency measurements
+ *
+ */
+
+#ifndef __EOSCOMMON__LATENCYHISTOGRAM__HH
+#define __EOSCOMMON__LATENCYHISTOGRAM__HH
+
+#include "common/Namespace.hh"
+#include <string.h>
+#include <math.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+/*----------------------------------------------------------------------------*/
+//! Log-linear histogram of latencies with microsecond resolution.
+//!
+//! Values below 16 us are counted in linear bins, above every power of two is
+//! split into 8 sub-bins, which bounds the relative error of a percentile to
+//! ~6%. Values above 2^40 us are accounted in the last bin. The class is not
+//! thread-safe, callers have to serialize access.
+//!
+//! Example: LatencyHistogram h; h.Add(0.2); h.Percentile(0.99);
+/*----------------------------------------------------------------------------*/
+class LatencyHistogram
+{
+public:
+  static const int kLinearBins = 16;
+  static const int kSubBinBits = 3;
+  static const int kSubBins = 1 << kSubBinBits;
+  static const int kMaxExponent = 40;
+  static const int kBins = kLinearBins + (kMaxExponent - 4) * kSubBins + 1;
+
+  LatencyHistogram()
+  {
+    Reset();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reset all counters
+  //----------------------------------------------------------------------------
+  void
+  Reset()
+  {
+    memset(mBins, 0, sizeof(mBins));
+    mCount = 0;
+    mSum = 0;
+    mSum2 = 0;
+    mMax = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add a sample
+  //!
+  //! @param ms latency in milliseconds
+  //----------------------------------------------------------------------------
+  void
+  Add(double ms)
+  {
+    if (ms < 0) {
+      ms = 0;
+    }
+
+    mBins[Bin((unsigned long long)(ms * 1000.0))]++;
+    mCount++;
+    mSum += ms;
+    mSum2 += ms * ms;
+
+    if (ms > mMax) {
+      mMax = ms;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Merge another histogram into this one
+  //----------------------------------------------------------------------------
+  void
+  Merge(const LatencyHistogram& other)
+  {
+    for (int i = 0; i < kBins; ++i) {
+      mBins[i] += other.mBins[i];
+    }
+
+    mCount += other.mCount;
+    mSum += other.mSum;
+    mSum2 += other.mSum2;
+
+    if (other.mMax > mMax) {
+      mMax = other.mMax;
+    }
+  }
+
+  unsigned long long
+  GetCount() const
+  {
+    return mCount;
+  }
+
+  double
+  GetMax() const
+  {
+    return mMax;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get average in milliseconds and the standard deviation
+  //----------------------------------------------------------------------------
+  double
+  GetAvg(double& deviation) const
+  {
+    deviation = 0;
+
+    if (!mCount) {
+      return 0;
+    }
+
+    double avg = mSum / mCount;
+    double var = (mSum2 / mCount) - (avg * avg);
+    deviation = (var > 0) ? sqrt(var) : 0;
+    return avg;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get a percentile in milliseconds
+  //!
+  //! @param fraction value between 0 and 1 e.g. 0.99 for p99
+  //!
+  //! @return center of the bin containing the percentile, 0 if empty
+  //----------------------------------------------------------------------------
+  double
+  Percentile(double fraction) const
+  {
+    if (!mCount) {
+      return 0;
+    }
+
+    unsigned long long rank = (unsigned long long) ceil(fraction * mCount);
+
+    if (rank < 1) {
+      rank = 1;
+    }
+
+    unsigned long long sum = 0;
+
+    for (int i = 0; i < kBins; ++i) {
+      sum += mBins[i];
+
+      if (sum >= rank) {
+        double center = (BinLow(i) + BinLow(i + 1)) / 2.0 / 1000.0;
+        return (center > mMax) ? mMax : center;
+      }
+    }
+
+    return mMax;
+  }
+
+private:
+  unsigned long long mBins[kBins];
+  unsigned long long mCount;
+  double mSum;
+  double mSum2;
+  double mMax;
+
+  //----------------------------------------------------------------------------
+  //! Map a value in microseconds to a bin index
+  //----------------------------------------------------------------------------
+  static int
+  Bin(unsigned long long us)
+  {
+    if (us < (unsigned long long) kLinearBins) {
+      return (int) us;
+    }
+
+    int exp = 63 - __builtin_clzll(us);
+
+    if (exp >= kMaxExponent) {
+      return kBins - 1;
+    }
+
+    int sub = (int)((us >> (exp - kSubBinBits)) & (kSubBins - 1));
+    return kLinearBins + (exp - 4) * kSubBins + sub;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Lower edge of a bin in microseconds
+  //----------------------------------------------------------------------------
+  static double
+  BinLow(int bin)
+  {
+    if (bin < kLinearBins) {
+      return bin;
+    }
+
+    int exp = 4 + (bin - kLinearBins) / kSubBins;
+    int sub = (bin - kLinearBins) % kSubBins;
+    return ldexp(1.0, exp) + sub * ldexp(1.0, exp - kSubBinBits);
+  }
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif
@@ -0,0 +1,218 @@
+// ----------------------------------------------------------------------
+// File: LinuxSysStat.hh
+// Author: agent <agent@local>
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/**
+ * @file   LinuxSysStat.hh
+ *
+ * @brief  Class getting host statistics from the linux proc and sys
+ *         filesystems without spawning external processes
+ *
+ */
+
+#ifndef __EOSCOMMON__LINUXSYSSTAT__HH
+#define __EOSCOMMON__LINUXSYSSTAT__HH
+
+#include "common/Namespace.hh"
+#include <string>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+/*----------------------------------------------------------------------------*/
+//! Static Class to read host statistics which used to be retrieved via shell
+//! pipelines (uptime, wc -l /proc/net/tcp, ethtool)
+//!
+//! Example: std::string up; GetUptime(up);
+//!
+/*----------------------------------------------------------------------------*/
+class LinuxSysStat
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Build an 'uptime' like string from /proc/uptime and /proc/loadavg
+  //!
+  //! @param result e.g. " 10:01:02 up 3 days,  4:05,  load average: 0.10, ..."
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool GetUptime(std::string& result)
+  {
+    double up = 0;
+    double load1 = 0, load5 = 0, load15 = 0;
+    result = "";
+    FILE* f = fopen("/proc/uptime", "r");
+
+    if (!f) {
+      return false;
+    }
+
+    if (fscanf(f, "%lf", &up) != 1) {
+      fclose(f);
+      return false;
+    }
+
+    fclose(f);
+    f = fopen("/proc/loadavg", "r");
+
+    if (!f) {
+      return false;
+    }
+
+    if (fscanf(f, "%lf %lf %lf", &load1, &load5, &load15) != 3) {
+      fclose(f);
+      return false;
+    }
+
+    fclose(f);
+    char nowstr[16];
+    time_t now = time(NULL);
+    struct tm tnow;
+    localtime_r(&now, &tnow);
+    strftime(nowstr, sizeof(nowstr), "%H:%M:%S", &tnow);
+    unsigned long long upsec = (unsigned long long) up;
+    unsigned long long days = upsec / 86400;
+    unsigned long long hours = (upsec % 86400) / 3600;
+    unsigned long long mins = (upsec % 3600) / 60;
+    char updays[64];
+    updays[0] = 0;
+
+    if (days) {
+      snprintf(updays, sizeof(updays), "%llu day%s, ", days,
+               (days != 1) ? "s" : "");
+    }
+
+    char line[256];
+
+    if (hours) {
+      snprintf(line, sizeof(line),
+               " %s up %s%2llu:%02llu,  load average: %.2f, %.2f, %.2f",
+               nowstr, updays, hours, mins, load1, load5, load15);
+    } else {
+      snprintf(line, sizeof(line),
+               " %s up %s%llu min,  load average: %.2f, %.2f, %.2f",
+               nowstr, updays, mins, load1, load5, load15);
+    }
+
+    result = line;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Count the lines in /proc/net/tcp (same value as 'cat /proc/net/tcp | wc -l')
+  //!
+  //! @param result number of lines
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool GetTcpSockets(unsigned long long& result)
+  {
+    result = 0;
+    FILE* f = fopen("/proc/net/tcp", "r");
+
+    if (!f) {
+      return false;
+    }
+
+    char buffer[65536];
+    size_t nread = 0;
+
+    while ((nread = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+      for (size_t i = 0; i < nread; ++i) {
+        if (buffer[i] == '\n') {
+          result++;
+        }
+      }
+    }
+
+    fclose(f);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the network device used by the default route from /proc/net/route
+  //!
+  //! @param device name of the device e.g. eth0
+  //!
+  //! @return true if a default route was found, otherwise false
+  //----------------------------------------------------------------------------
+  static bool GetDefaultRouteDevice(std::string& device)
+  {
+    device = "";
+    FILE* f = fopen("/proc/net/route", "r");
+
+    if (!f) {
+      return false;
+    }
+
+    char line[1024];
+    char iface[256];
+    unsigned long dest = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+      if ((sscanf(line, "%255s %lx", iface, &dest) == 2) && (dest == 0)) {
+        device = iface;
+        break;
+      }
+    }
+
+    fclose(f);
+    return (device.length() != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the link speed of a network device from /sys/class/net/<dev>/speed
+  //!
+  //! @param device name of the device
+  //! @param result link speed in bit/s
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool GetNetSpeed(const std::string& device, unsigned long long& result)
+  {
+    std::string path = "/sys/class/net/";
+    path += device;
+    path += "/speed";
+    FILE* f = fopen(path.c_str(), "r");
+
+    if (!f) {
+      return false;
+    }
+
+    long long speed = 0;
+    bool ok = ((fscanf(f, "%lld", &speed) == 1) && (speed > 0));
+    fclose(f);
+
+    if (ok) {
+      // the kernel reports Mb/s
+      result = (unsigned long long) speed * 1000000ull;
+    }
+
+    return ok;
+  }
+};
+
+EOSCOMMONNAMESPACE_END
+
+#endif
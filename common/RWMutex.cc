@@ -25,6 +25,11 @@
 #include "common/RWMutex.hh"
 #include "XrdSys/XrdSysAtomics.hh"
 /*----------------------------------------------------------------------------*/
+#ifdef EOS_INSTRUMENTED_RWMUTEX
+#include <cxxabi.h>
+#include <algorithm>
+#endif
+/*----------------------------------------------------------------------------*/
 
 
 EOSCOMMONNAMESPACE_BEGIN
@@ -55,6 +60,15 @@ __thread unsigned long
 RWMutex::ordermask_staticthread[EOS_RWMUTEX_ORDER_NRULES];
 std::map<pthread_t, bool> RWMutex::threadOrderCheckResetFlags_static;
 pthread_rwlock_t RWMutex::orderChkMgmLock;
+int RWMutex::profileSamplingModulo_static = 1000;
+size_t RWMutex::longWriteHold_static = 0;
+__thread unsigned int RWMutex::profileCounter_staticthread = 0;
+__thread RWMutex::ProfileHeld
+RWMutex::profileHeld_staticthread[EOS_RWMUTEX_PROFILE_NHELD];
+__thread int RWMutex::profileNHeld_staticthread = 0;
+std::set<RWMutex*>* RWMutex::profiledMutexes_static = NULL;
+std::deque<RWMutexLongHold>* RWMutex::longHolds_static = NULL;
+pthread_mutex_t RWMutex::profileMgmLock = PTHREAD_MUTEX_INITIALIZER;
 
 #define EOS_RWMUTEX_CHECKORDER_LOCK if(enableordercheckglobal) CheckAndLockOrder();
 #define EOS_RWMUTEX_CHECKORDER_UNLOCK if(enableordercheckglobal) CheckAndUnlockOrder();
@@ -86,11 +100,42 @@ pthread_rwlock_t RWMutex::orderChkMgmLock;
       do {size_t mymin=AtomicGet(minwait##what##_static); if (tstamp < mymin) needloop=!AtomicCAS(minwait##what##_static, mymin, tstamp); else needloop=false; }while(needloop); \
     }\
   }
+
+// the call site has to be taken in the lock function itself, see GetProfileSite,
+// and before the wait starts so that the backtrace is neither wait nor hold
+#define EOS_RWMUTEX_PROFILE_START \
+  bool isprofiled=false; size_t ptstamp=0; ProfileSite psite; \
+  if( enableprofiling ) { \
+    isprofiled=!((++profileCounter_staticthread)%profileSamplingModulo_static); \
+    if( isprofiled ) { GetProfileSite(psite); ptstamp=NowInt(); } \
+  }
+
+// nested read locks are counted while the thread holds a sampled one
+#define EOS_RWMUTEX_PROFILE_READ_LOCKED \
+  if( isprofiled || (enableprofiling && profileNHeld_staticthread) ) { \
+    ProfileReadLocked(isprofiled ? &psite : NULL, ptstamp); \
+  }
+
+#define EOS_RWMUTEX_PROFILE_WRITE_LOCKED \
+  if( isprofiled || (enableprofiling && longWriteHold_static) ) { \
+    writeHoldStart=NowInt(); writeHoldSampled=isprofiled; \
+    if( isprofiled ) { writeHoldWait=writeHoldStart-ptstamp; writeHoldSite=psite; } \
+  }
+
+#define EOS_RWMUTEX_PROFILE_READ_UNLOCK if(profileNHeld_staticthread) ProfileReadUnlock();
+#define EOS_RWMUTEX_PROFILE_WRITE_UNLOCK size_t longhold=writeHoldStart?ProfileWriteUnlock():0;
+#define EOS_RWMUTEX_PROFILE_WRITE_UNLOCKED if(longhold) LongWriteHoldMessage(longhold);
 #else
 #define EOS_RWMUTEX_CHECKORDER_LOCK
 #define EOS_RWMUTEX_CHECKORDER_UNLOCK
 #define EOS_RWMUTEX_TIMER_START
 #define EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(what) AtomicInc(what##LockCounter);
+#define EOS_RWMUTEX_PROFILE_START
+#define EOS_RWMUTEX_PROFILE_READ_LOCKED
+#define EOS_RWMUTEX_PROFILE_WRITE_LOCKED
+#define EOS_RWMUTEX_PROFILE_READ_UNLOCK
+#define EOS_RWMUTEX_PROFILE_WRITE_UNLOCK
+#define EOS_RWMUTEX_PROFILE_WRITE_UNLOCKED
 #endif
 
 
@@ -121,6 +166,10 @@ RWMutex::RWMutex()
   enabletiming = false;
   enablesampling = false;
   nrules = 0;
+  enableprofiling = false;
+  writeHoldStart = writeHoldWait = 0;
+  writeHoldSampled = false;
+  pthread_mutex_init(&profileLock, NULL);
 #endif
 #ifndef __APPLE__
   pthread_rwlockattr_init(&attr);
@@ -190,6 +239,13 @@ RWMutex::~RWMutex()
     delete rules;
   }
 
+  pthread_mutex_lock(&profileMgmLock);
+
+  if (profiledMutexes_static) {
+    profiledMutexes_static->erase(this);
+  }
+
+  pthread_mutex_unlock(&profileMgmLock);
 #endif
 }
 
@@ -1037,6 +1093,457 @@ RWMutex::ResetCheckOrder()
   pthread_rwlock_unlock(&orderChkMgmLock);
 }
 
+void
+RWMutexHistogram::Reset()
+{
+  for (int k = 0; k < EOS_RWMUTEX_PROFILE_NBINS; k++) {
+    bins[k] = 0;
+  }
+
+  count = total = max = 0;
+}
+
+void
+RWMutexHistogram::Add(size_t duration)
+{
+  int bin = duration ? (63 - __builtin_clzll(duration)) : 0;
+
+  if (bin >= EOS_RWMUTEX_PROFILE_NBINS) {
+    bin = EOS_RWMUTEX_PROFILE_NBINS - 1;
+  }
+
+  bins[bin]++;
+  count++;
+  total += duration;
+
+  if (duration > max) {
+    max = duration;
+  }
+}
+
+void
+RWMutexHistogram::Merge(const RWMutexHistogram& other)
+{
+  for (int k = 0; k < EOS_RWMUTEX_PROFILE_NBINS; k++) {
+    bins[k] += other.bins[k];
+  }
+
+  count += other.count;
+  total += other.total;
+
+  if (other.max > max) {
+    max = other.max;
+  }
+}
+
+size_t
+RWMutexHistogram::Percentile(double percent) const
+{
+  if (!count) {
+    return 0;
+  }
+
+  size_t rank = (size_t) ceil(count * percent / 100.0);
+  size_t cumulated = 0;
+
+  for (int k = 0; k < EOS_RWMUTEX_PROFILE_NBINS; k++) {
+    cumulated += bins[k];
+
+    if (cumulated >= rank) {
+      // upper edge of the bin, the largest sample is a tighter bound
+      return std::min(max, (size_t) 2 << k);
+    }
+  }
+
+  return max;
+}
+
+bool
+RWMutex::ProfileSite::operator < (const ProfileSite& other) const
+{
+  return std::lexicographical_compare(frames,
+                                      frames + EOS_RWMUTEX_PROFILE_DEPTH,
+                                      other.frames,
+                                      other.frames + EOS_RWMUTEX_PROFILE_DEPTH);
+}
+
+void
+RWMutex::GetProfileSite(ProfileSite& site)
+{
+  // ---------------------------------------------------------------------------
+  //! Record the return addresses of the caller of a lock function
+  // ---------------------------------------------------------------------------
+  // skip this function, the lock function might be missing after a tail call
+  // so the frames of the RWMutex classes are only skipped when symbolizing
+  void* array[EOS_RWMUTEX_PROFILE_DEPTH + 1];
+  int size = backtrace(array, EOS_RWMUTEX_PROFILE_DEPTH + 1);
+
+  for (int k = 0; k < EOS_RWMUTEX_PROFILE_DEPTH; k++) {
+    site.frames[k] = (k + 1 < size) ? array[k + 1] : NULL;
+  }
+}
+
+void
+RWMutex::AddProfileSample(const ProfileSite& site, bool write, size_t wait,
+                          size_t hold)
+{
+  // ---------------------------------------------------------------------------
+  //! Add a sampled lock to the histograms of its call site
+  // ---------------------------------------------------------------------------
+  pthread_mutex_lock(&profileLock);
+  ProfileEntry& entry = profile[site];
+
+  if (write) {
+    entry.waitwrite.Add(wait);
+    entry.holdwrite.Add(hold);
+  } else {
+    entry.waitread.Add(wait);
+    entry.holdread.Add(hold);
+  }
+
+  pthread_mutex_unlock(&profileLock);
+}
+
+void
+RWMutex::ProfileReadLocked(const ProfileSite* site, size_t tstamp)
+{
+  // ---------------------------------------------------------------------------
+  //! Track the hold of a read lock just acquired
+  // ---------------------------------------------------------------------------
+  size_t now = site ? NowInt() : 0;
+
+  // a recursive read lock of a sampled mutex ends before the sampled one, a
+  // sample taken for it is dropped
+  for (int k = 0; k < profileNHeld_staticthread; k++) {
+    if (profileHeld_staticthread[k].mutex == this) {
+      profileHeld_staticthread[k].depth++;
+      return;
+    }
+  }
+
+  // the sample is dropped if the thread already holds too many sampled locks
+  if (!site || (profileNHeld_staticthread == EOS_RWMUTEX_PROFILE_NHELD)) {
+    return;
+  }
+
+  ProfileHeld& held = profileHeld_staticthread[profileNHeld_staticthread++];
+  held.mutex = this;
+  held.start = now;
+  held.wait = now - tstamp;
+  held.depth = 0;
+  held.site = *site;
+}
+
+void
+RWMutex::ProfileReadUnlock()
+{
+  // ---------------------------------------------------------------------------
+  //! Account the hold of a read lock about to be released
+  // ---------------------------------------------------------------------------
+  for (int k = profileNHeld_staticthread - 1; k >= 0; k--) {
+    if (profileHeld_staticthread[k].mutex == this) {
+      // the sampled read lock is the outermost one
+      if (profileHeld_staticthread[k].depth) {
+        profileHeld_staticthread[k].depth--;
+        return;
+      }
+
+      ProfileHeld held = profileHeld_staticthread[k];
+      profileHeld_staticthread[k] =
+        profileHeld_staticthread[--profileNHeld_staticthread];
+      AddProfileSample(held.site, false, held.wait, NowInt() - held.start);
+      return;
+    }
+  }
+}
+
+size_t
+RWMutex::ProfileWriteUnlock()
+{
+  // ---------------------------------------------------------------------------
+  //! Account the hold of the write lock about to be released
+  // ---------------------------------------------------------------------------
+  size_t hold = NowInt() - writeHoldStart;
+  writeHoldStart = 0;
+
+  if (writeHoldSampled) {
+    AddProfileSample(writeHoldSite, true, writeHoldWait, hold);
+  }
+
+  if (longWriteHold_static && (hold > longWriteHold_static)) {
+    return hold;
+  }
+
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Symbolize a backtrace_symbols entry "module(mangled+offset) [address]" into
+// "demangled+offset", entries without symbol are returned unchanged
+// ---------------------------------------------------------------------------
+static std::string
+SymbolizeFrame(const char* symbol)
+{
+  std::string entry = symbol;
+  size_t begin = entry.find('(');
+  size_t end = entry.find(')', begin);
+
+  if ((begin == std::string::npos) || (end == std::string::npos)) {
+    return entry;
+  }
+
+  std::string name = entry.substr(begin + 1, end - begin - 1);
+  std::string offset;
+  size_t plus = name.find('+');
+
+  if (plus != std::string::npos) {
+    offset = name.substr(plus);
+    name.erase(plus);
+  }
+
+  if (name.empty()) {
+    return entry;
+  }
+
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+
+  if (demangled && !status) {
+    name = demangled;
+  }
+
+  free(demangled);
+  return name + offset;
+}
+
+void
+RWMutex::LongWriteHoldMessage(size_t duration)
+{
+  // ---------------------------------------------------------------------------
+  //! Report a write hold exceeding the threshold with the holder's backtrace
+  // ---------------------------------------------------------------------------
+  void* array[16];
+  int size = backtrace(array, 16);
+  unsigned long threadid = XrdSysThread::Num();
+  fprintf(stderr,
+          "RWMutex: Long Write Hold of %s (%p) for %.03f ms in thread %lu\n",
+          debugname.c_str(), this, duration / 1000000.0, threadid);
+  backtrace_symbols_fd(array, size, 2);
+  RWMutexLongHold hold;
+  hold.mutex = debugname;
+  hold.duration = duration;
+  hold.when = time(NULL);
+  char** symbols = backtrace_symbols(array, size);
+
+  if (symbols) {
+    // skip the frames of the RWMutex classes
+    for (int k = 0; k < size; k++) {
+      std::string frame = SymbolizeFrame(symbols[k]);
+
+      if (hold.backtrace.empty() && (frame.find("RWMutex") != std::string::npos)) {
+        continue;
+      }
+
+      hold.backtrace.push_back(frame);
+    }
+
+    free(symbols);
+  }
+
+  pthread_mutex_lock(&profileMgmLock);
+
+  if (!longHolds_static) {
+    longHolds_static = new std::deque<RWMutexLongHold>();
+  }
+
+  longHolds_static->push_back(hold);
+
+  if (longHolds_static->size() > EOS_RWMUTEX_PROFILE_NLONGHOLDS) {
+    longHolds_static->pop_front();
+  }
+
+  pthread_mutex_unlock(&profileMgmLock);
+}
+
+void
+RWMutex::SetProfiling(bool on)
+{
+  // ---------------------------------------------------------------------------
+  //! Turn on/off contention profiling at the instance level
+  // ---------------------------------------------------------------------------
+  if (on) {
+    pthread_mutex_lock(&profileMgmLock);
+
+    if (!profiledMutexes_static) {
+      profiledMutexes_static = new std::set<RWMutex*>();
+    }
+
+    profiledMutexes_static->insert(this);
+    pthread_mutex_unlock(&profileMgmLock);
+  }
+
+  enableprofiling = on;
+}
+
+bool
+RWMutex::GetProfiling()
+{
+  // ---------------------------------------------------------------------------
+  //! Get the contention profiling status at the instance level
+  // ---------------------------------------------------------------------------
+  return enableprofiling;
+}
+
+void
+RWMutex::SetProfileSampling(float rate)
+{
+  // ---------------------------------------------------------------------------
+  //! Set the fraction of locks sampled by each thread for profiling
+  // ---------------------------------------------------------------------------
+  if (rate <= 0) {
+    profileSamplingModulo_static = RAND_MAX;
+  } else {
+    profileSamplingModulo_static = std::min(RAND_MAX, std::max(1,
+                                            (int) std::round(1.0 / rate)));
+  }
+}
+
+float
+RWMutex::GetProfileSampling()
+{
+  // ---------------------------------------------------------------------------
+  //! Get the fraction of locks sampled by each thread for profiling
+  // ---------------------------------------------------------------------------
+  return 1.0 / profileSamplingModulo_static;
+}
+
+void
+RWMutex::SetLongWriteHold(size_t nsec)
+{
+  // ---------------------------------------------------------------------------
+  //! Set the write hold time above which the holder's backtrace is reported
+  // ---------------------------------------------------------------------------
+  longWriteHold_static = nsec;
+}
+
+size_t
+RWMutex::GetLongWriteHold()
+{
+  // ---------------------------------------------------------------------------
+  //! Get the long write hold threshold in nanoseconds
+  // ---------------------------------------------------------------------------
+  return longWriteHold_static;
+}
+
+void
+RWMutex::GetProfileStatistics(std::vector<RWMutexSiteStats>& stats)
+{
+  // ---------------------------------------------------------------------------
+  //! Get the contention statistics of all profiled mutexes
+  // ---------------------------------------------------------------------------
+  // different return address sequences can end up in the same call site
+  std::map<std::pair<std::string, std::string>, RWMutexSiteStats> merged;
+  pthread_mutex_lock(&profileMgmLock);
+
+  if (profiledMutexes_static) {
+    for (auto it = profiledMutexes_static->begin();
+         it != profiledMutexes_static->end(); it++) {
+      std::map<ProfileSite, ProfileEntry> profile;
+      pthread_mutex_lock(&(*it)->profileLock);
+      profile = (*it)->profile;
+      pthread_mutex_unlock(&(*it)->profileLock);
+      std::string name = (*it)->debugname;
+
+      if (name.empty()) {
+        char address[32];
+        snprintf(address, sizeof(address), "%p", (void*) *it);
+        name = address;
+      }
+
+      for (auto pit = profile.begin(); pit != profile.end(); pit++) {
+        int size = 0;
+
+        while ((size < EOS_RWMUTEX_PROFILE_DEPTH) && pit->first.frames[size]) {
+          size++;
+        }
+
+        std::string site = "unknown";
+        char** symbols = backtrace_symbols(pit->first.frames, size);
+
+        if (symbols) {
+          // the call site is the first frame outside of the RWMutex classes
+          for (int k = 0; k < size; k++) {
+            std::string frame = SymbolizeFrame(symbols[k]);
+
+            if (frame.find("RWMutex") == std::string::npos) {
+              site = frame;
+              break;
+            }
+          }
+
+          free(symbols);
+        }
+
+        RWMutexSiteStats& entry = merged[std::make_pair(name, site)];
+        entry.mutex = name;
+        entry.site = site;
+        entry.waitread.Merge(pit->second.waitread);
+        entry.waitwrite.Merge(pit->second.waitwrite);
+        entry.holdread.Merge(pit->second.holdread);
+        entry.holdwrite.Merge(pit->second.holdwrite);
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&profileMgmLock);
+  stats.clear();
+
+  for (auto it = merged.begin(); it != merged.end(); it++) {
+    stats.push_back(it->second);
+  }
+}
+
+void
+RWMutex::GetLongWriteHolds(std::vector<RWMutexLongHold>& holds)
+{
+  // ---------------------------------------------------------------------------
+  //! Get the last write holds exceeding the long write hold threshold
+  // ---------------------------------------------------------------------------
+  pthread_mutex_lock(&profileMgmLock);
+
+  if (longHolds_static) {
+    holds.assign(longHolds_static->begin(), longHolds_static->end());
+  } else {
+    holds.clear();
+  }
+
+  pthread_mutex_unlock(&profileMgmLock);
+}
+
+void
+RWMutex::ResetProfileStatistics()
+{
+  // ---------------------------------------------------------------------------
+  //! Reset the contention statistics and long write holds of all mutexes
+  // ---------------------------------------------------------------------------
+  pthread_mutex_lock(&profileMgmLock);
+
+  if (profiledMutexes_static) {
+    for (auto it = profiledMutexes_static->begin();
+         it != profiledMutexes_static->end(); it++) {
+      pthread_mutex_lock(&(*it)->profileLock);
+      (*it)->profile.clear();
+      pthread_mutex_unlock(&(*it)->profileLock);
+    }
+  }
+
+  if (longHolds_static) {
+    longHolds_static->clear();
+  }
+
+  pthread_mutex_unlock(&profileMgmLock);
+}
+
 #endif
 
 void
@@ -1046,6 +1553,7 @@ RWMutex::LockRead()
   //! Lock for read
   // ---------------------------------------------------------------------------
   EOS_RWMUTEX_CHECKORDER_LOCK;
+  EOS_RWMUTEX_PROFILE_START;
   EOS_RWMUTEX_TIMER_START;
 
   if (pthread_rwlock_rdlock(&rwlock)) {
@@ -1053,6 +1561,7 @@ RWMutex::LockRead()
   }
 
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(read);
+  EOS_RWMUTEX_PROFILE_READ_LOCKED;
 }
 
 void
@@ -1062,6 +1571,7 @@ RWMutex::LockReadCancel()
   //! Lock for read allowing to be canceled waiting for a lock
   // ---------------------------------------------------------------------------
   EOS_RWMUTEX_CHECKORDER_LOCK;
+  EOS_RWMUTEX_PROFILE_START;
   EOS_RWMUTEX_TIMER_START;
 #ifndef __APPLE__
 
@@ -1096,6 +1606,7 @@ RWMutex::LockReadCancel()
   LockRead();
 #endif
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(read);
+  EOS_RWMUTEX_PROFILE_READ_LOCKED;
 }
 
 void
@@ -1105,6 +1616,7 @@ RWMutex::UnLockRead()
   //! Unlock a read lock
   // ---------------------------------------------------------------------------
   EOS_RWMUTEX_CHECKORDER_UNLOCK;
+  EOS_RWMUTEX_PROFILE_READ_UNLOCK;
 
   if (pthread_rwlock_unlock(&rwlock)) {
     throw "pthread_rwlock_unlock failed";
@@ -1119,6 +1631,7 @@ RWMutex::LockWrite()
   // ---------------------------------------------------------------------------
   //AtomicInc(writeLockCounter);  // not needed anymore because of the macro EOS_RWMUTEX_TIMER_STOP_AND_UPDATE
   EOS_RWMUTEX_CHECKORDER_LOCK;
+  EOS_RWMUTEX_PROFILE_START;
   EOS_RWMUTEX_TIMER_START;
 
   if (blocking) {
@@ -1168,6 +1681,7 @@ RWMutex::LockWrite()
   }
 
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(write);
+  EOS_RWMUTEX_PROFILE_WRITE_LOCKED;
 }
 
 void
@@ -1177,11 +1691,14 @@ RWMutex::UnLockWrite()
   //! Unlock a write lock
   // ---------------------------------------------------------------------------
   EOS_RWMUTEX_CHECKORDER_UNLOCK;
+  EOS_RWMUTEX_PROFILE_WRITE_UNLOCK;
 
   if (pthread_rwlock_unlock(&rwlock)) {
     throw "pthread_rwlock_unlock failed";
   }
 
+  EOS_RWMUTEX_PROFILE_WRITE_UNLOCKED;
+
   //    fprintf(stderr,"*** WRITE LOCK RELEASED  **** TID=%llu OBJECT=%llx\n",(unsigned long long)XrdSysThread::ID(), (unsigned long long)this);
 }
 
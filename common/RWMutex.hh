@@ -40,6 +40,11 @@
  *            A rule is defined by a locking order ( a sequence of pointers to RWMutex instances ). The maximum length of this sequence is 63.
  *            The added latency by order checking for 3 mutexes and 1 rule is about 15% of the locking/unlocking execution time.
  *            An estimation of this added latency is provided.
+ *          - contention profiling
+ *            Each thread samples one lock out of N of the profiled mutexes using a thread local counter.
+ *            For a sampled lock the wait time and the hold time are added to log2 histograms kept per mutex and per call site.
+ *            The call site is identified by the return addresses of the caller and is only symbolized when the statistics are read.
+ *            Optionally every write hold longer than a threshold is reported with the backtrace of the holder.
  */
 
 #ifndef __EOSCOMMON_RWMUTEX_HH__
@@ -66,6 +71,9 @@
 #include <execinfo.h>
 #include <limits>
 #include <cmath>
+#include <set>
+#include <deque>
+#include <string>
 #endif
 
 #define _MULTI_THREADED
@@ -103,6 +111,69 @@ inline std::ostream& operator << (std::ostream& os,
   return os;
 }
 
+#define EOS_RWMUTEX_PROFILE_NBINS 40
+#define EOS_RWMUTEX_PROFILE_DEPTH 4
+#define EOS_RWMUTEX_PROFILE_NHELD 16
+#define EOS_RWMUTEX_PROFILE_NLONGHOLDS 32
+
+// -----------------------------------------------------------------------------
+//! Histogram of durations in nanoseconds, bin k counts durations in [2^k, 2^(k+1))
+// -----------------------------------------------------------------------------
+struct RWMutexHistogram {
+  size_t bins[EOS_RWMUTEX_PROFILE_NBINS];
+  size_t count, total, max;
+
+  RWMutexHistogram()
+  {
+    Reset();
+  }
+
+  void Reset();
+
+  void Add(size_t duration);
+
+  void Merge(const RWMutexHistogram& other);
+
+  // ---------------------------------------------------------------------------
+  //! Get an upper bound of the given percentile (0-100) in nanoseconds
+  // ---------------------------------------------------------------------------
+  size_t Percentile(double percent) const;
+
+  size_t Average() const
+  {
+    return count ? (total / count) : 0;
+  }
+};
+
+// -----------------------------------------------------------------------------
+//! Contention statistics of one call site of a mutex
+// -----------------------------------------------------------------------------
+struct RWMutexSiteStats {
+  std::string mutex; // debug name of the mutex
+  std::string site; // symbolized call site
+  RWMutexHistogram waitread, waitwrite, holdread, holdwrite;
+
+  size_t TotalWait() const
+  {
+    return waitread.total + waitwrite.total;
+  }
+
+  size_t TotalHold() const
+  {
+    return holdread.total + holdwrite.total;
+  }
+};
+
+// -----------------------------------------------------------------------------
+//! Write hold exceeding the long write hold threshold
+// -----------------------------------------------------------------------------
+struct RWMutexLongHold {
+  std::string mutex; // debug name of the mutex
+  size_t duration; // hold time in nanoseconds
+  time_t when; // time of the unlock
+  std::vector<std::string> backtrace; // symbolized stack of the holder
+};
+
 #endif
 
 /*----------------------------------------------------------------------------*/
@@ -175,6 +246,80 @@ private:
   static size_t orderCheckingLatency;
   // ****************************************
   // ###########################################
+
+  // ######### CONTENTION PROFILING MEMBERS ###########
+  // return addresses identifying a call site
+  struct ProfileSite {
+    void* frames[EOS_RWMUTEX_PROFILE_DEPTH];
+    bool operator < (const ProfileSite& other) const;
+  };
+  struct ProfileEntry {
+    RWMutexHistogram waitread, waitwrite, holdread, holdwrite;
+  };
+  // a sampled read lock held by a thread
+  struct ProfileHeld {
+    RWMutex* mutex;
+    size_t wait;
+    size_t start;
+    int depth; // read locks of the mutex taken since and not yet released
+    ProfileSite site;
+  };
+  bool enableprofiling;
+  static int profileSamplingModulo_static;
+  static size_t longWriteHold_static;
+  // each thread samples every profileSamplingModulo_static-th lock
+  static __thread unsigned int profileCounter_staticthread;
+  static __thread ProfileHeld profileHeld_staticthread[EOS_RWMUTEX_PROFILE_NHELD];
+  static __thread int profileNHeld_staticthread;
+  // the write lock is exclusive, so its hold is tracked in the instance
+  size_t writeHoldStart, writeHoldWait;
+  bool writeHoldSampled;
+  ProfileSite writeHoldSite;
+  // per call site histograms of this instance
+  std::map<ProfileSite, ProfileEntry> profile;
+  pthread_mutex_t profileLock;
+  // profiled instances and the last long write holds, allocated once and
+  // never freed so that global mutexes can be destroyed in any order
+  static std::set<RWMutex*>* profiledMutexes_static;
+  static std::deque<RWMutexLongHold>* longHolds_static;
+  static pthread_mutex_t profileMgmLock;
+  // ****************************************
+  // ###########################################
+
+  // ---------------------------------------------------------------------------
+  //! Record the return addresses of the caller of a lock function
+  // ---------------------------------------------------------------------------
+  static void GetProfileSite(ProfileSite& site) __attribute__((noinline));
+
+  // ---------------------------------------------------------------------------
+  //! Add a sampled lock to the histograms of its call site
+  // ---------------------------------------------------------------------------
+  void AddProfileSample(const ProfileSite& site, bool write, size_t wait,
+                        size_t hold);
+
+  // ---------------------------------------------------------------------------
+  //! Track the hold of a read lock just acquired
+  // @param site
+  //   call site if the lock is sampled, NULL to only count a recursive lock
+  // ---------------------------------------------------------------------------
+  void ProfileReadLocked(const ProfileSite* site, size_t tstamp);
+
+  // ---------------------------------------------------------------------------
+  //! Account the hold of a read lock about to be released
+  // ---------------------------------------------------------------------------
+  void ProfileReadUnlock();
+
+  // ---------------------------------------------------------------------------
+  //! Account the hold of the write lock about to be released
+  // @return
+  //   the hold time if it exceeds the long write hold threshold, otherwise 0
+  // ---------------------------------------------------------------------------
+  size_t ProfileWriteUnlock();
+
+  // ---------------------------------------------------------------------------
+  //! Report a write hold exceeding the threshold with the holder's backtrace
+  // ---------------------------------------------------------------------------
+  void LongWriteHoldMessage(size_t duration);
 #endif
 public:
   // ---------------------------------------------------------------------------
@@ -387,6 +532,57 @@ public:
   // ---------------------------------------------------------------------------
   void ResetCheckOrder();
 
+  // ---------------------------------------------------------------------------
+  //! Turn on/off contention profiling at the instance level
+  // ---------------------------------------------------------------------------
+  void SetProfiling(bool on);
+
+  // ---------------------------------------------------------------------------
+  //! Get the contention profiling status at the instance level
+  // ---------------------------------------------------------------------------
+  bool GetProfiling();
+
+  // ---------------------------------------------------------------------------
+  //! Set the fraction of locks sampled by each thread for profiling
+  // @param $first
+  //   sampling between 0 and 1
+  // ---------------------------------------------------------------------------
+  static void SetProfileSampling(float rate);
+
+  // ---------------------------------------------------------------------------
+  //! Get the fraction of locks sampled by each thread for profiling
+  // ---------------------------------------------------------------------------
+  static float GetProfileSampling();
+
+  // ---------------------------------------------------------------------------
+  //! Set the write hold time above which the holder's backtrace is reported
+  // @param $first
+  //   threshold in nanoseconds, 0 disables the reporting
+  // ---------------------------------------------------------------------------
+  static void SetLongWriteHold(size_t nsec);
+
+  // ---------------------------------------------------------------------------
+  //! Get the long write hold threshold in nanoseconds
+  // ---------------------------------------------------------------------------
+  static size_t GetLongWriteHold();
+
+  // ---------------------------------------------------------------------------
+  //! Get the contention statistics of all profiled mutexes
+  // @param $first
+  //   filled with one entry per mutex and call site
+  // ---------------------------------------------------------------------------
+  static void GetProfileStatistics(std::vector<RWMutexSiteStats>& stats);
+
+  // ---------------------------------------------------------------------------
+  //! Get the last write holds exceeding the long write hold threshold
+  // ---------------------------------------------------------------------------
+  static void GetLongWriteHolds(std::vector<RWMutexLongHold>& holds);
+
+  // ---------------------------------------------------------------------------
+  //! Reset the contention statistics and long write holds of all mutexes
+  // ---------------------------------------------------------------------------
+  static void ResetProfileStatistics();
+
 #endif
 
   // ---------------------------------------------------------------------------
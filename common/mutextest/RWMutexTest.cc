@@ -342,6 +342,69 @@ main()
 
   RunThreads2();
 
+  cout<<"###################################################################"<<endl;
+  cout<<"################### CONTENTION PROFILING TESTS ####################"<<endl;
+  cout<<"###################################################################"<<endl;
+  RWMutex::SetOrderCheckingGlobal(false);
+  globmutex.SetDebugName("globmutex");
+  globmutex.SetTiming(false);
+  globmutex.SetSampling(false);
+  globmutex.SetBlocking(true);
+  RWMutex::SetProfileSampling(1.0);
+  globmutex.SetProfiling(true);
+  t = NowInt();
+  RunThreads();
+  t = NowInt() - t;
+  cout << " ------------------------- " << endl;
+  cout << " Multithreaded Loop (" << NUM_THREADS << " threads half reading/half writing, blocking mutex) of size " << double(loopsize) / (int) NUM_THREADS
+      << " with profiling (sample rate 1.0) took " << t / 1.0e9 << " sec"<<" ("<<double(loopsize)/(t / 1.0e9)<<"Hz"<<")" << endl;
+  RWMutex::SetProfileSampling(0.001);
+  t = NowInt();
+  RunThreads();
+  t = NowInt() - t;
+  cout << " Multithreaded Loop (" << NUM_THREADS << " threads half reading/half writing, blocking mutex) of size " << double(loopsize) / (int) NUM_THREADS
+      << " with profiling (sample rate 0.001) took " << t / 1.0e9 << " sec"<<" ("<<double(loopsize)/(t / 1.0e9)<<"Hz"<<")" << endl;
+  vector<RWMutexSiteStats> sites;
+  RWMutex::GetProfileStatistics(sites);
+  for (size_t k = 0; k < sites.size(); k++)
+  {
+    cout << " " << sites[k].mutex << " @ " << sites[k].site << endl;
+    cout << "\tread  samples " << sites[k].waitread.count << " wait avg/p99/max [ns] " << sites[k].waitread.Average() << " / " << sites[k].waitread.Percentile(99)
+        << " / " << sites[k].waitread.max << " hold avg [ns] " << sites[k].holdread.Average() << endl;
+    cout << "\twrite samples " << sites[k].waitwrite.count << " wait avg/p99/max [ns] " << sites[k].waitwrite.Average() << " / " << sites[k].waitwrite.Percentile(99)
+        << " / " << sites[k].waitwrite.max << " hold avg [ns] " << sites[k].holdwrite.Average() << endl;
+  }
+  cout << " ------------------------- " << endl << endl;
+
+  cout<<"======== Holding a write lock for 20ms with a 10ms long write hold threshold ON PURPOSE... ========"<<std::endl; cout.flush();
+  RWMutex::SetLongWriteHold(10000000);
+  globmutex.LockWrite();
+  usleep(20000);
+  globmutex.UnLockWrite();
+  vector<RWMutexLongHold> holds;
+  RWMutex::GetLongWriteHolds(holds);
+  for (size_t k = 0; k < holds.size(); k++)
+  {
+    cout << " " << holds[k].mutex << " held for " << holds[k].duration / 1.0e6 << " ms" << endl;
+    for (size_t f = 0; f < holds[k].backtrace.size(); f++)
+      cout << "\t" << holds[k].backtrace[f] << endl;
+  }
+  RWMutex::SetLongWriteHold(0);
+  cout<<"======== ... done ========"<<std::endl<<std::endl; cout.flush();
+
+  cout<<"======== Holding a recursive read lock for 20ms, the nested lock is released first ========"<<std::endl; cout.flush();
+  RWMutex::ResetProfileStatistics();
+  RWMutex::SetProfileSampling(1.0);
+  globmutex.LockRead();
+  globmutex.LockRead();
+  globmutex.UnLockRead();
+  usleep(20000);
+  globmutex.UnLockRead();
+  RWMutex::GetProfileStatistics(sites);
+  for (size_t k = 0; k < sites.size(); k++)
+    cout << " " << sites[k].mutex << " read samples " << sites[k].waitread.count << " hold avg " << sites[k].holdread.Average() / 1.0e6 << " ms" << endl;
+  globmutex.SetProfiling(false);
+  cout<<"======== ... done ========"<<std::endl<<std::endl; cout.flush();
 
   return 0;
 }
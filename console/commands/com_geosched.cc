@@ -49,7 +49,7 @@ com_geosched (char* arg1)
   if (wants_help(arg1))
     goto com_geosched_usage;
 
-  if ((cmd != "show") && (cmd != "set") && (cmd != "updater") && (cmd != "forcerefresh") && (cmd != "disabled") && (cmd != "access"))
+  if ((cmd != "show") && (cmd != "set") && (cmd != "updater") && (cmd != "forcerefresh") && (cmd != "disabled") && (cmd != "access") && (cmd != "trace") && (cmd != "bench"))
   {
     goto com_geosched_usage;
   }
@@ -171,6 +171,48 @@ com_geosched (char* arg1)
       in += "&mgm.subcmd=forcerefresh";
   }
 
+  if(cmd == "trace")
+  {
+    XrdOucString subcmd = subtokenizer.GetToken();
+    if(subcmd == "start")
+    {
+      XrdOucString tracefile = subtokenizer.GetToken();
+      if(!tracefile.length())
+        goto com_geosched_usage;
+      in += "&mgm.subcmd=tracestart&mgm.tracefile=";
+      in += tracefile;
+    }
+    else if(subcmd == "stop")
+    {
+      in += "&mgm.subcmd=tracestop";
+    }
+    else if(subcmd == "show")
+    {
+      in += "&mgm.subcmd=traceshow";
+    }
+    else
+      goto com_geosched_usage;
+  }
+
+  if(cmd == "bench")
+  {
+    XrdOucString group = subtokenizer.GetToken();
+    XrdOucString nfiles = subtokenizer.GetToken();
+    XrdOucString nreplicas = subtokenizer.GetToken();
+    if(!group.length() || !nfiles.length() || !nfiles.isdigit() ||
+       (nreplicas.length() && !nreplicas.isdigit()))
+      goto com_geosched_usage;
+    in += "&mgm.subcmd=bench&mgm.schedgroup=";
+    in += group;
+    in += "&mgm.nfiles=";
+    in += nfiles;
+    if(nreplicas.length())
+    {
+      in += "&mgm.nreplicas=";
+      in += nreplicas;
+    }
+  }
+
   if (cmd == "disabled")
   {
     XrdOucString subcmd = subtokenizer.GetToken();
@@ -264,7 +306,7 @@ com_geosched (char* arg1)
 
 com_geosched_usage:
   fprintf(stdout, "'[eos] geosched ..' Interact with the file geoscheduling engine in EOS.\n");
-  fprintf(stdout, "Usage: geosched show|set|updater|forcerefresh|disabled|access ...\n");
+  fprintf(stdout, "Usage: geosched show|set|updater|forcerefresh|disabled|access|trace|bench ...\n");
   fprintf(stdout, "Options:\n");
   fprintf(stdout, "       geosched show [-c] tree [<scheduling subgroup>]                    :  show scheduling trees\n");
   fprintf(stdout, "                                                                          :  if <scheduling group> is specified only the tree for this group is shown. If it's not all, the trees are shown.\n");
@@ -279,6 +321,11 @@ com_geosched_usage:
   fprintf(stdout, "       geosched set <param name> [param index] <param value>              :  set the value of an internal state parameter (all names can be listed with geosched show state) \n");
   fprintf(stdout, "       geosched updater {pause|resume}                                    :  pause / resume the tree updater\n");
   fprintf(stdout, "       geosched forcerefresh                                              :  force a refresh of the trees/snapshots\n");
+  fprintf(stdout, "       geosched trace start <name>                                        :  record a binary trace of fs states, placements and accesses into a new file\n");
+  fprintf(stdout, "                                                                          :  /var/log/eos/mgm/geosched/<name> on the MGM, it can be replayed offline with eos-geosched-replay\n");
+  fprintf(stdout, "       geosched trace {stop|show}                                         :  stop recording / show the status of the trace\n");
+  fprintf(stdout, "       geosched bench <scheduling subgroup> <nfiles> [<nreplicas>]        :  time the placement of <nfiles> files of <nreplicas> (default 1) replicas one by one and in one batch\n");
+  fprintf(stdout, "                                                                          :  nothing is booked but the penalties of the placements apply as for real ones\n");
   fprintf(stdout, "       geosched disabled add <geotag> {<optype>,*} {<scheduling subgroup>,*}      :  disable a branch of a subtree for the specified group and operation\n");
   fprintf(stdout, "                                                                                  :  multiple branches can be disabled (by successive calls) as long as they have no intersection\n");
   fprintf(stdout, "       geosched disabled rm {<geotag>,*} {<optype>,*} {<scheduling subgroup>,*}   :  re-enable a disabled branch for the specified group and operation\n");
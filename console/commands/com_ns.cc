@@ -181,6 +181,36 @@ com_ns (char* arg1)
                     {
                       options += "f";
                     }
+                    else if (option == "--toggleprofile")
+                    {
+                      options += "p";
+                    }
+                    else if (option == "--top")
+                    {
+                      XrdOucString top = subtokenizer.GetToken();
+                      if (!top.length() || !top.isdigit() || !atoi(top.c_str()))
+                        goto com_ns_usage;
+                      options += "P";
+                      in += "&mgm.mutex.top=";
+                      in += top;
+                    }
+                    else if (option == "--sort")
+                    {
+                      XrdOucString sort = subtokenizer.GetToken();
+                      if ((sort != "wait") && (sort != "hold"))
+                        goto com_ns_usage;
+                      in += "&mgm.mutex.sort=";
+                      in += sort;
+                    }
+                    else if (option == "--longwrite")
+                    {
+                      XrdOucString ms = subtokenizer.GetToken();
+                      if (!ms.length() || !ms.isdigit())
+                        goto com_ns_usage;
+                      options += "L";
+                      in += "&mgm.mutex.longwrite=";
+                      in += ms;
+                    }
                     else
                     {
                       goto com_ns_usage;
@@ -222,6 +252,10 @@ com_ns_usage:
   fprintf(stdout, "                --smplrate1                                          -  set the timing sample rate at 1%%   (default, almost no slow-down)\n");
   fprintf(stdout, "                --smplrate10                                         -  set the timing sample rate at 10%%  (medium slow-down)\n");
   fprintf(stdout, "                --smplrate100                                        -  set the timing sample rate at 100%% (severe slow-down)\n");
+  fprintf(stdout, "                --toggleprofile                                      -  toggle the contention profiling of the wait and hold times per call site\n");
+  fprintf(stdout, "                --top <n> [--sort wait|hold]                         -  show the <n> call sites with the largest total wait (default) or hold time and the last long write holds\n");
+  fprintf(stdout, "                --longwrite <ms>                                     -  report write holds above <ms> milliseconds with a backtrace, 0 disables it\n");
+  fprintf(stdout, "                --reset                                              -  reset the contention profiles and long write holds\n");
 #endif
   fprintf(stdout, "       ns compact on <delay> [<interval>] [<type>]                   -  enable online compactification after <delay> seconds\n");
   fprintf(stdout, "                                                                     -  if <interval> is >0 the compactifcation is repeated automatically after <interval> seconds!\n");
@@ -22,71 +22,449 @@
  ************************************************************************/
 
 #include "Health.hh"
+#include "fst/Load.hh"
+#include "common/Logging.hh"
 #include "common/ShellCmd.hh"
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 EOSFSTNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Read the first line of a file, false if it can not be read
+//------------------------------------------------------------------------------
+static bool
+ReadLine(const std::string& path, std::string& line)
+{
+  std::ifstream file(path.c_str());
+  return (file && std::getline(file, line));
+}
+
+//------------------------------------------------------------------------------
+// Leading integer of a string skipping blanks and thousands separators,
+// empty if there is none
+//------------------------------------------------------------------------------
+static std::string
+LeadingNumber(const std::string& str, size_t pos = 0)
+{
+  std::string number;
+
+  while ((pos < str.length()) && isspace(str[pos])) {
+    pos++;
+  }
+
+  for (; pos < str.length(); pos++) {
+    if (isdigit(str[pos])) {
+      number += str[pos];
+    } else if ((str[pos] != ',') || number.empty()) {
+      break;
+    }
+  }
+
+  return number;
+}
+
+//------------------------------------------------------------------------------
+// Device name without the partition suffix e.g. sda1 => sda, nvme0n1p1 =>
+// nvme0n1
+//------------------------------------------------------------------------------
+static std::string
+DeviceName(std::string dev)
+{
+  if (dev.empty() || (dev[0] == 'm')) {
+    return dev;
+  }
+
+  size_t len = dev.length();
+
+  while (len && isdigit(dev[len - 1])) {
+    len--;
+  }
+
+  if (!dev.compare(0, 4, "nvme")) {
+    // nvme0n1 is a device, nvme0n1p1 one of its partitions
+    if ((len < dev.length()) && len && (dev[len - 1] == 'p')) {
+      dev.resize(len - 1);
+    }
+
+    return dev;
+  }
+
+  if (len) {
+    dev.resize(len);
+  }
+
+  return dev;
+}
+
 //------------------------------------------------------------------------------
 //                        **** Class DiskHealth ****
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-// Get health information about a certain device
+// Constructor
+//------------------------------------------------------------------------------
+DiskHealth::DiskHealth(time_t interval, time_t timeout, time_t max_backoff):
+  mInterval(interval), mTimeout(timeout), mMaxBackoff(max_backoff),
+  mSysfs("/sys"), mMdstat("/proc/mdstat")
+{
+  mProbe = [timeout](const std::string & device, std::string & output) {
+    return DiskHealth::Smartctl(device, output, timeout);
+  };
+}
+
+//------------------------------------------------------------------------------
+// Set the function probing a device
+//------------------------------------------------------------------------------
+void
+DiskHealth::SetProbe(const ProbeFunc& probe)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mProbe = probe;
+}
+
+//------------------------------------------------------------------------------
+// Set the locations of sysfs and of the mdstat file
+//------------------------------------------------------------------------------
+void
+DiskHealth::SetSources(const std::string& sysfs, const std::string& mdstat)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mSysfs = sysfs;
+  mMdstat = mdstat;
+}
+
+//------------------------------------------------------------------------------
+// Get the cached health information about a device
 //------------------------------------------------------------------------------
 std::map<std::string, std::string> DiskHealth::getHealth(const char* devpath)
 {
-  std::string dev = Load::DevMap(devpath);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mPaths.find(devpath);
 
-  if (dev[0] == 'm') {
-    return parse_mdstat(dev.c_str());
+  if (it == mPaths.end()) {
+    // resolved by the next measurement
+    mPaths[devpath] = "";
+    return std::map<std::string, std::string>();
   }
 
-  // Chunck partition digits, we need the actual device name for smartctl...
-  // no string::back or pop_back support in gcc 4.4 so it looks a bit funny.
-  while (isdigit(dev.at(dev.length() - 1))) {
-    dev.resize(dev.length() - 1);
+  auto dev = mDevices.find(it->second);
+
+  if (dev == mDevices.end()) {
+    return std::map<std::string, std::string>();
   }
 
+  return dev->second.health;
+}
+
+//------------------------------------------------------------------------------
+// Number of probes still running
+//------------------------------------------------------------------------------
+size_t
+DiskHealth::RunningProbes()
+{
   std::lock_guard<std::mutex> lock(mMutex);
-  return smartctl_results[dev];
+  size_t running = 0;
+
+  for (auto it = mDevices.begin(); it != mDevices.end(); ++it) {
+    if (it->second.probe && !it->second.probe->done) {
+      running++;
+    }
+  }
+
+  return running;
 }
 
 //------------------------------------------------------------------------------
-// Update health information for all the registered devices
+// Run one measurement round
 //------------------------------------------------------------------------------
 void
-DiskHealth::Measure()
+DiskHealth::Measure(time_t now)
 {
-  std::map<std::string, std::map<std::string, std::string>> tmp;
+  // Resolve the devices of new paths outside the lock
+  std::vector<std::string> paths;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto it = mPaths.begin(); it != mPaths.end(); ++it) {
+      if (it->second.empty()) {
+        paths.push_back(it->first);
+      }
+    }
+  }
+  std::map<std::string, std::string> resolved;
 
-  for (auto it = smartctl_results.begin(); it != smartctl_results.end(); it++) {
-    tmp[it->first]["summary"] = smartctl(it->first.c_str());
+  for (auto it = paths.begin(); it != paths.end(); ++it) {
+    resolved[*it] = DeviceName(Load::DevMap(*it));
   }
 
   std::lock_guard<std::mutex> lock(mMutex);
-  smartctl_results = tmp;
+  bool has_md = false;
+
+  for (auto it = resolved.begin(); it != resolved.end(); ++it) {
+    if (!it->second.empty()) {
+      mPaths[it->first] = it->second;
+      mDevices[it->second];
+    }
+  }
+
+  for (auto it = mDevices.begin(); it != mDevices.end(); ++it) {
+    Device& dev = it->second;
+
+    if (it->first[0] == 'm') {
+      has_md = true;
+      continue;
+    }
+
+    if (dev.probe) {
+      if (dev.probe->done) {
+        Collect(dev, now);
+      } else if ((now - dev.started >= mTimeout) &&
+                 (dev.health["summary"] != "timeout")) {
+        // Hanging - keep the last attributes and back off
+        dev.failures++;
+        time_t backoff = mInterval;
+
+        for (unsigned int i = 0; (i < dev.failures) && (backoff < mMaxBackoff); i++) {
+          backoff *= 2;
+        }
+
+        dev.next = dev.started + std::min(backoff, mMaxBackoff);
+        dev.health["summary"] = "timeout";
+        eos_static_warning("msg=\"S.M.A.R.T probe hanging\" device=%s failures=%u "
+                           "next_probe_in=%llds", it->first.c_str(), dev.failures,
+                           (long long)(dev.next - now));
+      }
+    }
+
+    if (dev.probe || (now < dev.next)) {
+      continue;
+    }
+
+    // Don't probe devices which the kernel already took offline
+    std::map<std::string, std::string> sysfs;
+
+    if (!ReadSysfs(it->first, sysfs)) {
+      sysfs["summary"] = "offline";
+      dev.health = sysfs;
+      dev.next = now + mInterval;
+      continue;
+    }
+
+    std::shared_ptr<Probe> probe = std::make_shared<Probe>();
+    ProbeFunc func = mProbe;
+    std::string device = it->first;
+
+    try {
+      std::thread([probe, func, device]() {
+        std::string output;
+        int exit_code = func(device, output);
+        probe->output = output;
+        probe->exit_code = exit_code;
+        probe->done = true;
+      }).detach();
+    } catch (const std::system_error& e) {
+      eos_static_err("msg=\"failed to start S.M.A.R.T probe\" device=%s "
+                     "error=\"%s\"", device.c_str(), e.what());
+      continue;
+    }
+
+    dev.probe = probe;
+    dev.started = now;
+    dev.sysfs = sysfs;
+  }
+
+  if (has_md) {
+    std::ifstream file(mMdstat.c_str());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    for (auto it = mDevices.begin(); it != mDevices.end(); ++it) {
+      if (it->first[0] == 'm') {
+        it->second.health = ParseMdstat(buffer.str(), it->first.c_str());
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect the result of a finished probe
+//------------------------------------------------------------------------------
+void
+DiskHealth::Collect(Device& dev, time_t now)
+{
+  bool late = (dev.health["summary"] == "timeout") && dev.failures;
+  dev.health = ParseSmartctl(dev.probe->exit_code, dev.probe->output);
+  dev.health.insert(dev.sysfs.begin(), dev.sysfs.end());
+  dev.probe.reset();
+
+  // A late result is still the latest information but the device stays in
+  // backoff until it answers in time again
+  if (!late) {
+    dev.failures = 0;
+    dev.next = dev.started + mInterval;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the state of a device from sysfs
+//------------------------------------------------------------------------------
+bool
+DiskHealth::ReadSysfs(const std::string& device,
+                      std::map<std::string, std::string>& health)
+{
+  std::string base = mSysfs + "/block/" + device + "/device/";
+  std::string line;
+
+  if (ReadLine(base + "ioerr_cnt", line)) {
+    health["ioerr_cnt"] = std::to_string((unsigned long long)
+                                         strtoull(line.c_str(), 0, 0));
+  }
+
+  if (ReadLine(base + "state", line)) {
+    return (line.compare(0, 7, "running") == 0) || (line == "live");
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Parse the output of 'smartctl -a' and its exit code
+//------------------------------------------------------------------------------
+std::map<std::string, std::string>
+DiskHealth::ParseSmartctl(int exit_code, const std::string& output)
+{
+  std::map<std::string, std::string> health;
+  std::string& summary = health["summary"];
+
+  if (exit_code < 0) {
+    summary = "timeout";
+  } else if (exit_code == 0) {
+    summary = "OK";
+  } else if (exit_code == 127) {
+    summary = "no smartctl";
+  } else {
+    summary = "invalid";
+
+    for (int i = 0; i < 8; i++) {
+      if (exit_code & (1 << i)) {
+        summary = (i < 3) ? "N/A" : ((i == 3) ? "FAILING" : "Check");
+        break;
+      }
+    }
+  }
+
+  std::istringstream lines(output);
+  std::string line;
+  std::string airflow;
+
+  while (std::getline(lines, line)) {
+    size_t pos;
+
+    if ((pos = line.find("self-assessment test result:")) != std::string::npos) {
+      std::istringstream(line.substr(pos + 28)) >> health["overall"];
+    } else if ((pos = line.find("SMART Health Status:")) != std::string::npos) {
+      std::istringstream(line.substr(pos + 20)) >> health["overall"];
+    } else if (!line.compare(0, 26, "Current Drive Temperature:")) {
+      health["temperature"] = LeadingNumber(line, 26);
+    } else if (!line.compare(0, 30, "Elements in grown defect list:")) {
+      health["grown_defects"] = LeadingNumber(line, 30);
+    } else if ((pos = line.find("power on time, hours:minutes")) !=
+               std::string::npos) {
+      health["power_on_hours"] = LeadingNumber(line, pos + 28);
+    } else if (!line.compare(0, 12, "Temperature:")) {
+      health["temperature"] = LeadingNumber(line, 12);
+    } else if (!line.compare(0, 15, "Power On Hours:")) {
+      health["power_on_hours"] = LeadingNumber(line, 15);
+    } else if (!line.compare(0, 32, "Media and Data Integrity Errors:")) {
+      health["media_errors"] = LeadingNumber(line, 32);
+    } else {
+      // ATA attribute table:
+      // ID# ATTRIBUTE_NAME FLAG VALUE WORST THRESH TYPE UPDATED WHEN_FAILED RAW
+      std::istringstream fields(line);
+      std::string id, field, raw;
+      fields >> id;
+
+      if (id.empty() || (id.find_first_not_of("0123456789") != std::string::npos)) {
+        continue;
+      }
+
+      for (int i = 0; i < 8; i++) {
+        fields >> field;
+      }
+
+      std::getline(fields, raw);
+
+      if (!fields && raw.empty()) {
+        continue;
+      }
+
+      raw = LeadingNumber(raw);
+
+      switch (atoi(id.c_str())) {
+      case 5:
+        health["reallocated_sectors"] = raw;
+        break;
+
+      case 9:
+        health["power_on_hours"] = raw;
+        break;
+
+      case 190:
+        airflow = raw;
+        break;
+
+      case 194:
+        health["temperature"] = raw;
+        break;
+
+      case 197:
+        health["pending_sectors"] = raw;
+        break;
+
+      case 198:
+        health["offline_uncorrectable"] = raw;
+        break;
+      }
+    }
+  }
+
+  if (!health.count("temperature") && !airflow.empty()) {
+    health["temperature"] = airflow;
+  }
+
+  return health;
 }
 
 //------------------------------------------------------------------------------
-// Parse /proc/mdstat to obtain raid health
+// Parse the mdstat content to obtain raid health
 //------------------------------------------------------------------------------
-std::map<std::string, std::string> DiskHealth::parse_mdstat(const char* device)
+std::map<std::string, std::string>
+DiskHealth::ParseMdstat(const std::string& output, const char* device)
 {
   std::map<std::string, std::string> health;
-  std::ifstream file("/proc/mdstat");
-  file.rdbuf()->pubsetbuf(0, 0);
-  std::stringstream buffer;
-  buffer << file.rdbuf();
 
-  if (buffer.str().empty()) {
+  if (output.empty()) {
     health["summary"] = "no mdstat";
     return health;
   }
 
-  std::string output = buffer.str();
   auto pos = output.find(device);
   int redundancy_factor;
   pos = output.find("raid", pos);
+
+  if ((pos == std::string::npos) || (pos + 4 >= output.length())) {
+    health["summary"] = "unknown raid";
+    return health;
+  }
+
   auto c = output[pos + 4];
 
   switch (c) {
@@ -147,49 +525,51 @@ std::map<std::string, std::string> DiskHealth::parse_mdstat(const char* device)
 }
 
 //------------------------------------------------------------------------------
-// Obtain health of a single locally attached storage device by evaluating
-// S.M.A.R.T values.
+// Run smartctl on a device, -1 if it had to be killed
 //------------------------------------------------------------------------------
-std::string DiskHealth::smartctl(const char* device)
+int
+DiskHealth::Smartctl(const std::string& device, std::string& output,
+                     time_t timeout)
 {
-  std::string command("smartctl -q silent -a /dev/");
+  std::string command("smartctl -a /dev/");
   command += device;
   eos::common::ShellCmd scmd(command.c_str());
-  eos::common::cmd_status rc = scmd.wait(5);
+  time_t deadline = time(NULL) + timeout;
+  char buffer[4096];
+  output.clear();
+
+  // Drain the output while waiting, smartctl blocks on a full pipe
+  while (time(NULL) < deadline) {
+    struct pollfd pfd;
+    pfd.fd = scmd.outfd;
+    pfd.events = POLLIN;
+    int rc = poll(&pfd, 1, (deadline - time(NULL)) * 1000);
+
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
 
-  if (rc.exit_code == 0) {
-    return "OK";
-  }
+    if (rc <= 0) {
+      break;
+    }
 
-  if (rc.exit_code == 127) {
-    return "no smartctl";
-  }
+    ssize_t nread = read(scmd.outfd, buffer, sizeof(buffer));
 
-  int mask = 1;
+    if (nread <= 0) {
+      break;
+    }
 
-  for (int i = 0; i < 8; i++) {
-    if ((rc.exit_code & mask) && 1) {
-      switch (i) {
-      case 0:
-      case 1:
-      case 2:
-        return "N/A";
+    output.append(buffer, nread);
+  }
 
-      case 3:
-        return "FAILING";
+  time_t left = deadline - time(NULL);
+  eos::common::cmd_status rc = scmd.wait(left > 0 ? left : 0);
 
-      case 4:
-      case 5:
-      case 6:
-      case 7:
-        return "Check";
-      }
-    }
-
-    mask = mask << 1;
+  if (!rc.exited) {
+    return -1;
   }
 
-  return "invalid";
+  return rc.exit_code;
 }
 
 //------------------------------------------------------------------------------
@@ -211,11 +591,8 @@ Health::StartHealthThread(void* pp)
 // Constructor
 //------------------------------------------------------------------------------
 Health::Health(unsigned int ival_minutes):
-  mSkip(false), mTid(0), mIntervalMin(ival_minutes)
+  mTid(0), mDiskHealth((ival_minutes ? ival_minutes : 1) * 60)
 {
-  if (mIntervalMin == 0) {
-    mIntervalMin = 1;
-  }
 }
 
 //------------------------------------------------------------------------------
@@ -247,41 +624,26 @@ Health::Monitor()
 
 //------------------------------------------------------------------------------
 // Loop run by the monitoring thread to keep updated the disk health info.
+// The probes run in the background, a round only collects and starts them.
 //------------------------------------------------------------------------------
 void
 Health::Measure()
 {
   while (1) {
     XrdSysThread::SetCancelOff();
-    mDiskHealth.Measure();
+    mDiskHealth.Measure(time(NULL));
     XrdSysThread::SetCancelOn();
-
-    for (unsigned int i = 0; i < mIntervalMin; i++) {
-      sleep(60);
-
-      if (mSkip) {
-        mSkip = false;
-        break;
-      }
-    }
+    sleep(10);
   }
 }
 
 //------------------------------------------------------------------------------
-// Get disk health information for a specific device. If no measurements are
-// available then trigger the monitoring thread to do an update.
+// Get the cached disk health information for a specific device
 //------------------------------------------------------------------------------
 std::map<std::string, std::string>
 Health::getDiskHealth(const char* devpath)
 {
-  auto result = mDiskHealth.getHealth(devpath);
-
-  // If we don't have any result, don't wait for interval timeout to measure
-  if (result.empty()) {
-    mSkip = true; // this doesn't need a mutex, worst case we wait 1 more min.
-  }
-
-  return result;
+  return mDiskHealth.getHealth(devpath);
 }
 
 EOSFSTNAMESPACE_END
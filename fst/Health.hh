@@ -25,57 +25,160 @@
 #define __EOSFST_HEALTH_HH__
 
 #include "fst/Namespace.hh"
-#include "fst/storage/FileSystem.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
 
 EOSFSTNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
-//! Class retrieving disk health information
+//! Class collecting disk health information asynchronously
+//!
+//! Every device is probed by smartctl in a thread of its own so that a device
+//! hanging smartctl only delays its own results. A probe exceeding the timeout
+//! marks the device as 'timeout' and the device is probed again only after an
+//! exponential backoff. The parsed results are kept in a cache, getHealth only
+//! reads from it and never forks or blocks on a device.
 //------------------------------------------------------------------------------
 class DiskHealth
 {
 public:
   //----------------------------------------------------------------------------
-  //! Get health information about a certain device
+  //! Function probing a device, e.g. running smartctl on it
   //!
-  //! @param devpath path of the targeted device
+  //! @param device device name e.g. sda
+  //! @param output returns the text output of the probe
   //!
-  //! @return map of health parameters and values
+  //! @return exit code of the probe
+  //----------------------------------------------------------------------------
+  typedef std::function<int(const std::string& device, std::string& output)>
+  ProbeFunc;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param interval seconds between two probes of a device
+  //! @param timeout seconds after which a probe is considered hanging
+  //! @param max_backoff max. seconds between two probes of a hanging device
+  //----------------------------------------------------------------------------
+  DiskHealth(time_t interval = 900, time_t timeout = 60,
+             time_t max_backoff = 86400);
+
+  //----------------------------------------------------------------------------
+  //! Set the function probing a device, by default smartctl is run
+  //----------------------------------------------------------------------------
+  void SetProbe(const ProbeFunc& probe);
+
+  //----------------------------------------------------------------------------
+  //! Set the locations of sysfs and of the mdstat file
+  //----------------------------------------------------------------------------
+  void SetSources(const std::string& sysfs, const std::string& mdstat);
+
+  //----------------------------------------------------------------------------
+  //! Get the cached health information about a device. A device seen for the
+  //! first time is registered for the next measurement.
+  //!
+  //! @param devpath path of the targeted device or device name
+  //!
+  //! @return map of health parameters and values, empty if not measured yet
   //----------------------------------------------------------------------------
   std::map<std::string, std::string> getHealth(const char* devpath);
 
   //----------------------------------------------------------------------------
-  //! Update health information for all the registered devices
+  //! Run one measurement round: collect finished probes, detect hanging ones,
+  //! start the probes which are due and refresh the raid status. Does not
+  //! wait for any probe.
+  //!
+  //! @param now current time
   //----------------------------------------------------------------------------
-  void Measure();
+  void Measure(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Number of probes still running
+  //----------------------------------------------------------------------------
+  size_t RunningProbes();
 
-private:
   //----------------------------------------------------------------------------
-  //! Parse /proc/mdstat to obtain raid health. Existing indicator shows
+  //! Parse the output of 'smartctl -a' and its exit code
+  //!
+  //! @param exit_code exit code of smartctl
+  //! @param output text output of smartctl
+  //!
+  //! @return map with the summary and the parsed S.M.A.R.T attributes
+  //----------------------------------------------------------------------------
+  static std::map<std::string, std::string>
+  ParseSmartctl(int exit_code, const std::string& output);
+
+  //----------------------------------------------------------------------------
+  //! Parse the mdstat content to obtain raid health. Existing indicator shows
   //! rebuild in progress.
   //!
+  //! @param mdstat content of /proc/mdstat
   //! @param device targeted device
   //!
   //! @return map of health parameters and values
   //----------------------------------------------------------------------------
-  std::map<std::string, std::string> parse_mdstat(const char* device);
+  static std::map<std::string, std::string>
+  ParseMdstat(const std::string& mdstat, const char* device);
+
+private:
+  //----------------------------------------------------------------------------
+  //! State of a probe shared with the thread running it
+  //----------------------------------------------------------------------------
+  struct Probe {
+    Probe(): exit_code(0), done(false) {}
+
+    std::string output; ///< output of the probe
+    int exit_code; ///< exit code of the probe
+    std::atomic<bool> done; ///< set once output and exit_code are valid
+  };
 
   //----------------------------------------------------------------------------
-  //! Obtain health of a single locally attached storage device by evaluating
-  //! S.M.A.R.T values.
-  //!
-  //! @param device targeted device
+  //! Cached state of a device
+  //----------------------------------------------------------------------------
+  struct Device {
+    Device(): started(0), next(0), failures(0) {}
+
+    std::map<std::string, std::string> health; ///< last health information
+    std::map<std::string, std::string> sysfs; ///< sysfs values of the probe
+    std::shared_ptr<Probe> probe; ///< running probe if any
+    time_t started; ///< start time of the running probe
+    time_t next; ///< time of the next probe
+    unsigned int failures; ///< consecutive hanging probes
+  };
+
+  //----------------------------------------------------------------------------
+  //! Run smartctl on a device
+  //----------------------------------------------------------------------------
+  static int Smartctl(const std::string& device, std::string& output,
+                      time_t timeout);
+
+  //----------------------------------------------------------------------------
+  //! Read the state of a device from sysfs
   //!
-  //! @return string representin the result of smartctl run on the targeted
-  //!         device. Can be one of the following: OK, no smartclt, N/A, Check,
-  //!         invalid, FAILING.
+  //! @return false if sysfs reports the device as not running
   //----------------------------------------------------------------------------
-  std::string smartctl(const char* device);
+  bool ReadSysfs(const std::string& device,
+                 std::map<std::string, std::string>& health);
 
-  //! Map holding the smartclt results
-  std::map<std::string, std::map<std::string, std::string>> smartctl_results;
-  std::mutex mMutex; ///< Protect acces to the smartctl_results map
+  //----------------------------------------------------------------------------
+  //! Collect the result of a finished probe
+  //----------------------------------------------------------------------------
+  void Collect(Device& dev, time_t now);
+
+  time_t mInterval; ///< seconds between two probes of a device
+  time_t mTimeout; ///< seconds after which a probe is hanging
+  time_t mMaxBackoff; ///< max. seconds between probes of a hanging device
+  ProbeFunc mProbe; ///< function probing a device
+  std::string mSysfs; ///< sysfs mount point
+  std::string mMdstat; ///< path of the mdstat file
+  std::map<std::string, std::string> mPaths; ///< device path => device name
+  std::map<std::string, Device> mDevices; ///< device name => state
+  std::mutex mMutex; ///< Protect access to mPaths and mDevices
 };
 
 //------------------------------------------------------------------------------
@@ -93,6 +196,8 @@ public:
 
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param ival_minutes minutes between two S.M.A.R.T probes of a device
   //----------------------------------------------------------------------------
   Health(unsigned int ival_minutes = 15);
 
@@ -114,8 +219,8 @@ public:
   void Measure();
 
   //----------------------------------------------------------------------------
-  //! Get disk health information for a specific device. If no measurements
-  //! are available then trigger the monitoring thread to do an update.
+  //! Get the cached disk health information for a specific device. Devices
+  //! seen for the first time are measured within the next few seconds.
   //!
   //! @param devpath targeted device
   //!
@@ -124,10 +229,7 @@ public:
   std::map<std::string, std::string> getDiskHealth(const char* devpath);
 
 private:
-  ///< Trigger update thread without waiting for the whole interval to elapse
-  bool mSkip;
   pthread_t mTid; ///< Monitoring thread id
-  unsigned int mIntervalMin; ///< Minutes interval when monitoring thread runs
   DiskHealth mDiskHealth; ///< Objecting collecting disk health information
 };
 
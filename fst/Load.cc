@@ -24,9 +24,11 @@
 #include "fst/Load.hh"
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <errno.h>
 #include <sys/stat.h>
 #include "XrdOuc/XrdOucString.hh"
+#include "common/LinuxSysStat.hh"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -38,7 +40,7 @@ EOSFSTNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 Load::Load(unsigned int ival):
-  mTid(0)
+  mTid(0), mTcpSockets(0)
 {
   mInterval = ival;
 
@@ -62,76 +64,79 @@ Load::~Load()
 //------------------------------------------------------------------------------
 // Get device name mounted at the given path
 //-----------------------------------------------------------------------------
-const char*
-Load::DevMap(const char* dev_path)
+std::string
+Load::DevMap(const std::string& dev_path)
 {
   static time_t loadtime = 0;
-  static std::map<std::string, std::string> dev_map;
-  static XrdOucString mapdev = dev_path;
-  static XrdOucString mappath = "";
-  static XrdSysMutex mutex_map; // Protect access to the dev_map
-
-  if (mapdev.beginswith("/")) {
-    XrdSysMutexHelper scope_lock(&mutex_map);
-    mapdev = "";
+  static time_t checktime = 0;
+  static std::map<std::string, std::string> dev_map; // device => mount path
+  static std::map<std::string, std::string> path_map; // path => device
+  static XrdSysMutex mutex_map; // Protect access to the maps
+
+  if (dev_path.empty() || (dev_path[0] != '/')) {
+    return dev_path;
+  }
+
+  XrdSysMutexHelper scope_lock(&mutex_map);
+  time_t now = time(NULL);
+
+  // This is called on the publishing path, look at the mtab only every 10s
+  if (now - checktime >= 10) {
     struct stat stbuf;
+    checktime = now;
 
-    if (!(stat("/etc/mtab", &stbuf))) {
-      dev_map.clear();
+    if (!stat("/etc/mtab", &stbuf) && (stbuf.st_mtime != loadtime)) {
+      FILE* fd = fopen("/etc/mtab", "r");
 
-      if (stbuf.st_mtime != loadtime) {
-	FILE* fd = fopen("/etc/mtab", "r");
+      if (fd) {
 	// Reparse the mtab
 	char line[1025];
 	char val[6][1024];
 	line[0] = 0;
+	loadtime = stbuf.st_mtime;
+	dev_map.clear();
+	path_map.clear();
 
-	while (fd && fgets(line, 1024, fd)) {
+	while (fgets(line, 1024, fd)) {
 	  if ((sscanf(line, "%s %s %s %s %s %s\n", val[0], val[1], val[2],
 		      val[3], val[4], val[5])) == 6) {
 	    XrdOucString sdev = val[0];
-	    XrdOucString spath = val[1];
 
-	    // fprintf(stderr,"%s => %s\n", sdev.c_str(), spath.c_str());
 	    if (sdev.beginswith("/dev/")) {
 	      sdev.erase(0, 5);
-	      dev_map[sdev.c_str()] = spath.c_str();
-	      // fprintf(stderr,"=> %s %s\n", sdev.c_str(),spath.c_str());
+	      dev_map[sdev.c_str()] = val[1];
 	    }
 	  }
 	}
 
-	if (fd) {
-	  fclose(fd);
-	}
+	fclose(fd);
       }
     }
+  }
 
-    XrdOucString match, it_str;
-
-    for (auto dev_map_it = dev_map.begin(); dev_map_it != dev_map.end();
-	 dev_map_it++) {
-      match = dev_path;
-      it_str = dev_map_it->second.c_str();
-      match.erase(dev_map_it->second.length());
+  auto cached = path_map.find(dev_path);
 
-      // fprintf(stderr,"%s <=> %s\n",match.c_str(),it_str.c_str());
-      if (match == it_str) {
-	if ((int) dev_map_it->second.length() > (int) mappath.length()) {
-	  mapdev = dev_map_it->first.c_str();
-	  mappath = dev_map_it->second.c_str();
-	  // fprintf(stderr,"Setting up mapping %s=>%s\n", mapdev.c_str(), mappath.c_str());
-	}
-      }
-    }
+  if (cached != path_map.end()) {
+    return cached->second;
   }
 
-  if (!mapdev.length()) {
-    mapdev = dev_path;
+  // Longest mount path containing the given path
+  std::string mapdev = dev_path;
+  size_t maplen = 0;
+
+  for (auto it = dev_map.begin(); it != dev_map.end(); ++it) {
+    const std::string& mnt = it->second;
+
+    if ((mnt.length() > maplen) && !dev_path.compare(0, mnt.length(), mnt) &&
+	((dev_path.length() == mnt.length()) || (mnt == "/") ||
+	 (dev_path[mnt.length()] == '/'))) {
+      mapdev = it->first;
+      maplen = mnt.length();
+    }
   }
 
-  // printf("===> returning |%s|\n", mapdev.c_str());
-  return mapdev.c_str();
+  path_map[dev_path] = mapdev;
+  return mapdev;
 }
 
 //------------------------------------------------------------------------------
@@ -140,9 +145,8 @@ Load::DevMap(const char* dev_path)
 double
 Load::GetDiskRate(const char* dev_path, const char* tag)
 {
-  const char* dev = DevMap(dev_path);
-  //fprintf(stderr,"**** Device is %s\n", dev);
-  double val = fDiskStat.GetRate(dev, tag);
+  std::string dev = DevMap(dev_path);
+  double val = fDiskStat.GetRate(dev.c_str(), tag);
   return val;
 }
 
@@ -156,6 +160,17 @@ Load::GetNetRate(const char* dev, const char* tag)
   return val;
 }
 
+//------------------------------------------------------------------------------
+// Get the last measured uptime and number of TCP sockets
+//------------------------------------------------------------------------------
+void
+Load::GetNodeStat(std::string& uptime, unsigned long long& tcp_sockets)
+{
+  XrdSysMutexHelper scope_lock(&mNodeMutex);
+  uptime = mUptime;
+  tcp_sockets = mTcpSockets;
+}
+
 //------------------------------------------------------------------------------
 // Method run by scurbber thread to  measurement both disk and network values
 // on regular intervals.
@@ -174,6 +189,16 @@ Load::Measure()
       fprintf(stderr, "error: cannot get network IO statistic\n");
     }
 
+    std::string uptime;
+    unsigned long long sockets = 0;
+
+    if (eos::common::LinuxSysStat::GetUptime(uptime) &&
+	eos::common::LinuxSysStat::GetTcpSockets(sockets)) {
+      XrdSysMutexHelper scope_lock(&mNodeMutex);
+      mUptime = uptime;
+      mTcpSockets = sockets;
+    }
+
     XrdSysThread::SetCancelOn();
     sleep(mInterval);
   }
@@ -132,10 +132,10 @@ public:
   //!
   //! @param dev_path device mount path
   //!
-  //! @return name of the devices which is mounted at the given path or empty
-  //!         string if no device found
+  //! @return name of the device which is mounted at the given path or the
+  //!         given path if no device found
   //----------------------------------------------------------------------------
-  static const char* DevMap(const char* dev_path);
+  static std::string DevMap(const std::string& dev_path);
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -180,6 +180,14 @@ public:
   //----------------------------------------------------------------------------
   double GetNetRate(const char* dev, const char* tag);
 
+  //----------------------------------------------------------------------------
+  //! Get the node statistics of the last measurement
+  //!
+  //! @param uptime 'uptime' like string
+  //! @param tcp_sockets number of TCP sockets
+  //----------------------------------------------------------------------------
+  void GetNodeStat(std::string& uptime, unsigned long long& tcp_sockets);
+
   //----------------------------------------------------------------------------
   //! Static method used to start the scrubber thread
   //----------------------------------------------------------------------------
@@ -190,6 +198,9 @@ private:
   unsigned int mInterval; ///< Sampling interval for the monitor thread
   DiskStat fDiskStat; ///< Disk statistics
   NetStat fNetStat; ///< Network statistics
+  std::string mUptime; ///< Last measured uptime string
+  unsigned long long mTcpSockets; ///< Last measured number of TCP sockets
+  XrdSysMutex mNodeMutex; ///< Protect the node statistics
 };
 
 EOSFSTNAMESPACE_END
@@ -613,12 +613,19 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
 
   int nread = 0;
   off_t offset = 0;
-
-  do {
-    errno = 0;
-    nread = io->fileRead(offset, buffer, bufferSize);
-
-    if (nread < 0) {
+  // File and block checksums are computed in a single pass over the data
+  eos::fst::ChecksumEngine engine(normalXS, blockXS);
+
+  if ((scanThreads > 1) && (io->GetIoType() == "FsIo")) {
+    // Dedicated scan without load regulation, spread over several threads
+    eos::fst::FileIo* fio = io.get();
+    eos::fst::ChecksumEngine::ReadFunc reader =
+    [fio](off_t offset, char* buffer, size_t length) {
+      return fio->fileRead(offset, buffer, length);
+    };
+
+    if (!engine.ScanFile(reader, current_stat.st_size, scansize, scantime,
+                         currentRate, scanThreads)) {
       if (blockXS) {
         blockXS->CloseMap();
         delete blockXS;
@@ -631,50 +638,63 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
       return false;
     }
 
-    if (nread) {
-      if (!corruptBlockXS && blockXS)
-        if (!blockXS->CheckBlockSum(offset, buffer, nread)) {
-          corruptBlockXS = true;
+    offset = scansize;
+  } else {
+    do {
+      errno = 0;
+      nread = io->fileRead(offset, buffer, bufferSize);
+
+      if (nread < 0) {
+        if (blockXS) {
+          blockXS->CloseMap();
+          delete blockXS;
+        }
+
+        if (normalXS) {
+          delete normalXS;
         }
 
-      //      fprintf(stderr,"adding %ld %llu\n", nread,offset);
-      if (normalXS) {
-        normalXS->Add(buffer, nread, offset);
+        return false;
       }
 
-      offset += nread;
+      if (nread) {
+        engine.Check(buffer, nread, offset);
+        offset += nread;
 
-      if (currentRate) {
-        // regulate the verification rate
-        gettimeofday(&currenttime, &tz);
-        scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                      currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-        float expecttime = (1.0 * offset / currentRate) / 1000.0;
+        if (currentRate) {
+          // regulate the verification rate
+          gettimeofday(&currenttime, &tz);
+          scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                        currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+          float expecttime = (1.0 * offset / currentRate) / 1000.0;
 
-        if (expecttime > scantime) {
-          XrdSysTimer sleeper;
-          sleeper.Wait(expecttime - scantime);
-        }
+          if (expecttime > scantime) {
+            XrdSysTimer sleeper;
+            sleeper.Wait(expecttime - scantime);
+          }
 
-        //adjust the rate according to the load information
-        load = fstLoad->GetDiskRate("sda", "millisIO") / 1000.0;
+          //adjust the rate according to the load information
+          load = fstLoad->GetDiskRate("sda", "millisIO") / 1000.0;
 
-        if (load > 0.7) {
-          //adjust currentRate
-          if (currentRate > 5) {
-            currentRate = 0.9 * currentRate;
+          if (load > 0.7) {
+            //adjust currentRate
+            if (currentRate > 5) {
+              currentRate = 0.9 * currentRate;
+            }
+          } else {
+            currentRate = rateBandwidth;
           }
-        } else {
-          currentRate = rateBandwidth;
         }
       }
-    }
-  } while (nread == bufferSize);
+    } while (nread == bufferSize);
+
+    gettimeofday(&currenttime, &tz);
+    scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                  currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+  }
 
-  gettimeofday(&currenttime, &tz);
-  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
   scansize = (unsigned long long) offset;
+  corruptBlockXS = engine.IsBlockCorrupted();
 
   if (normalXS) {
     normalXS->Finalize();
@@ -33,6 +33,7 @@
 #include "common/FileSystem.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/checksum/ChecksumEngine.hh"
 #include "fst/io/FileIo.hh"
 /*----------------------------------------------------------------------------*/
 #include <syslog.h>
@@ -71,6 +72,7 @@ private:
 
   bool setChecksum;
   int rateBandwidth; // MB/s
+  int scanThreads; // threads checksumming a file, local files only
   long alignment;
   char* buffer;
 
@@ -82,9 +84,9 @@ public:
 
   ScanDir(const char* dirpath, eos::common::FileSystem::fsid_t fsid,
           eos::fst::Load* fstload, bool bgthread = true, long int testinterval = 10,
-          int ratebandwidth = 100, bool setchecksum = false) :
+          int ratebandwidth = 100, bool setchecksum = false, int scanthreads = 1) :
     fstLoad(fstload), fsId(fsid), dirPath(dirpath), testInterval(testinterval),
-    rateBandwidth(ratebandwidth)
+    rateBandwidth(ratebandwidth), scanThreads(scanthreads)
   {
     thread = 0;
     noNoChecksumFiles = noScanFiles = noCorruptFiles = noTotalFiles = SkippedFiles =
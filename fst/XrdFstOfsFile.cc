@@ -36,6 +36,10 @@
 #include "XrdCl/XrdClXRootDResponses.hh"
 /*----------------------------------------------------------------------------*/
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
 #include <fst/io/FileIoPluginCommon.hh>
 
 /*----------------------------------------------------------------------------*/
@@ -105,6 +109,7 @@ XrdFstOfsFile::XrdFstOfsFile(const char* user, int MonID) :
   mTimeout = getenv("EOS_FST_STREAM_TIMEOUT") ? strtoul(
                getenv("EOS_FST_STREAM_TIMEOUT"), 0, 10) : msDefaultTimeout;
   hasWriteError = false;
+  mZeroCopyFd = -1;
 }
 
 
@@ -147,6 +152,11 @@ XrdFstOfsFile::~XrdFstOfsFile()
     delete layOut;
     layOut = 0;
   }
+
+  if (mZeroCopyFd >= 0) {
+    ::close(mZeroCopyFd);
+    mZeroCopyFd = -1;
+  }
 }
 
 
@@ -246,6 +256,7 @@ XrdFstOfsFile::open(const char* path,
   // mask some opaque parameters to shorten the logging
   eos::common::StringConversion::MaskTag(maskOpaque, "cap.sym");
   eos::common::StringConversion::MaskTag(maskOpaque, "cap.msg");
+  eos::common::StringConversion::MaskTag(maskOpaque, "cap.mac");
   eos::common::StringConversion::MaskTag(maskOpaque, "authz");
   // For RAIN layouts if the opaque information contains the tag fst.store=1 the
   // corrupted files are recovered back on disk. There is no other way to make
@@ -2410,6 +2421,144 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset,
 }
 
 
+//------------------------------------------------------------------------------
+// Get a descriptor of the local replica for zero-copy reads
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::GetZeroCopyFd()
+{
+  if (!opened || isRW || !layOut || (tpcFlag != kTpcNone) ||
+      gOFS.Simulate_IO_read_error) {
+    return -1;
+  }
+
+  unsigned long ltype = eos::common::LayoutId::GetLayoutType(lid);
+
+  if (ltype == eos::common::LayoutId::kReplica) {
+    // Without a replica index this is a gateway access to a remote replica
+    if (!openOpaque || !openOpaque->Get("mgm.replicaindex")) {
+      return -1;
+    }
+  } else if (ltype != eos::common::LayoutId::kPlain) {
+    return -1;
+  }
+
+  if (eos::common::LayoutId::GetIoType(fstPath.c_str()) !=
+      eos::common::LayoutId::kLocal) {
+    return -1;
+  }
+
+  if (mZeroCopyFd < 0) {
+    struct stat buf;
+    mZeroCopyFd = ::open(fstPath.c_str(), O_RDONLY);
+
+    if (mZeroCopyFd < 0) {
+      eos_warning("msg=\"unable to open local replica for zero-copy\" path=%s "
+                  "errno=%d", fstPath.c_str(), errno);
+      return -1;
+    }
+
+    // The replica has to be complete, otherwise sendfile would stop short
+    if (::fstat(mZeroCopyFd, &buf) || (buf.st_size < openSize)) {
+      ::close(mZeroCopyFd);
+      mZeroCopyFd = -1;
+      return -1;
+    }
+  }
+
+  int fd = ::dup(mZeroCopyFd);
+
+  if (fd >= 0) {
+    // The read time accounted is the one of the whole transfer
+    gettimeofday(&cTime, &tz);
+  }
+
+  return fd;
+}
+
+
+//------------------------------------------------------------------------------
+// Account a range which was sent by the zero-copy path
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::ZeroCopyRead(XrdSfsFileOffset fileOffset, off_t length)
+{
+  static const long pagesize = sysconf(_SC_PAGESIZE);
+  // Same granularity as the file reader callback of the HTTP server
+  static const off_t chunksize = 4 * 1024 * 1024;
+  eos_debug("fileOffset=%lli, length=%lli", fileOffset, (long long) length);
+
+  if (mZeroCopyFd < 0) {
+    return gOFS.Emsg("ZeroCopyRead", error, EBADF, "account zero-copy read - "
+                     "no local replica descriptor fn=", FName());
+  }
+
+  off_t done = 0;
+
+  while (done < length) {
+    XrdSfsFileOffset offset = fileOffset + done;
+    size_t len = std::min(chunksize, length - done);
+
+    if (checkSum) {
+      // Map the pages which were just sent, they are still in the page cache
+      off_t shift = offset % pagesize;
+      void* ptr = mmap(0, len + shift, PROT_READ, MAP_SHARED, mZeroCopyFd,
+                       offset - shift);
+
+      if (ptr == MAP_FAILED) {
+        eos_err("msg=\"failed to map local replica\" offset=%llu len=%llu "
+                "errno=%d", (unsigned long long) offset,
+                (unsigned long long) len, errno);
+        return gOFS.Emsg("ZeroCopyRead", error, errno, "map local replica fn=",
+                         FName());
+      }
+
+      {
+        XrdSysMutexHelper cLock(ChecksumMutex);
+        checkSum->Add((const char*) ptr + shift, len,
+                      static_cast<off_t>(offset));
+      }
+      munmap(ptr, len + shift);
+    }
+
+    {
+      XrdSysMutexHelper vecLock(vecMutex);
+      rvec.push_back(len);
+    }
+
+    rCalls++;
+    done += len;
+  }
+
+  if (rOffset != static_cast<unsigned long long>(fileOffset)) {
+    if (rOffset < static_cast<unsigned long long>(fileOffset)) {
+      nFwdSeeks++;
+      sFwdBytes += (fileOffset - rOffset);
+    } else {
+      nBwdSeeks++;
+      sBwdBytes += (rOffset - fileOffset);
+    }
+  }
+
+  rOffset = fileOffset + length;
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+
+  if ((fileOffset + length) >= openSize) {
+    if (checkSum) {
+      if (!checkSum->NeedsRecalculation()) {
+        if (verifychecksum()) {
+          return gOFS.Emsg("ZeroCopyRead", error, EIO, "read file - wrong file "
+                           "checksum fn=", FName());
+        }
+      }
+    }
+  }
+
+  return SFS_OK;
+}
+
+
 //------------------------------------------------------------------------------
 // Vector read - low level ofs method which is called from one of the
 // layout plugins
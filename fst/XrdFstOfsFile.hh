@@ -210,6 +210,31 @@ public:
   int read(XrdSfsAio* aioparm);
 
 
+  //--------------------------------------------------------------------------
+  //! Get a descriptor of the local replica which can be handed to sendfile.
+  //! This is only possible for files opened read-only with a plain or replica
+  //! layout doing IO on a local disk.
+  //!
+  //! @return new descriptor to be closed by the caller, -1 if not possible
+  //--------------------------------------------------------------------------
+  int GetZeroCopyFd();
+
+
+  //--------------------------------------------------------------------------
+  //! Account a range which was sent from a descriptor obtained with
+  //! GetZeroCopyFd. The checksum is updated from the page cache of the local
+  //! replica, i.e. from the pages which were just sent, and verified like in
+  //! read once the end of the file is reached. As the response is already
+  //! complete a mismatch is reported through the checksum error of close.
+  //!
+  //! @param fileOffset offset of the range
+  //! @param length length of the range
+  //!
+  //! @return SFS_OK if successful, SFS_ERROR otherwise
+  //--------------------------------------------------------------------------
+  int ZeroCopyRead(XrdSfsFileOffset fileOffset, off_t length);
+
+
   //--------------------------------------------------------------------------
   //! Vector read - low level ofs method which is called from one of the
   //! layout plugins
@@ -464,6 +489,7 @@ protected:
 
   off_t openSize; //! file size when the file was opened
   off_t closeSize; //! file size when the file was closed
+  int mZeroCopyFd; //! descriptor of the local replica used by ZeroCopyRead
 
 private:
   //----------------------------------------------------------------------------
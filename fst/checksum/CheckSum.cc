@@ -713,6 +713,15 @@ CheckSum::SetXSMap(off_t offset)
 /*----------------------------------------------------------------------------*/
 bool
 CheckSum::VerifyXSMap(off_t offset)
+{
+  int len = 0;
+  const char* cks = GetBinChecksum(len);
+  return VerifyXSMap(offset, cks, len);
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+CheckSum::VerifyXSMap(off_t offset, const char* cks, int len)
 {
   if (!ChangeMap((offset + BlockSize), false)) {
     fprintf(stderr, "Fatal: [CheckSum::VerifyXSMap] ChangeMap failed\n");
@@ -721,8 +730,6 @@ CheckSum::VerifyXSMap(off_t offset)
 
   off_t mapoffset = (offset / BlockSize) * GetCheckSumLen();
   //  fprintf(stderr,"Verifying %llu %llu %d %llu %llu\n", offset, mapoffset, ChecksumMapFd, ChecksumMap, ChecksumMapSize);
-  int len = 0;
-  const char* cks = GetBinChecksum(len);
 
   if (!sigsetjmp(sj_env, 1)) {
     for (int i = 0; i < len; i++) {
@@ -144,6 +144,12 @@ public:
     return needsRecalculation;
   }
 
+  size_t
+  GetBlockSize()
+  {
+    return BlockSize;
+  }
+
   class ReadCallBack
   {
   public:
@@ -199,6 +205,7 @@ public:
                         unsigned long long& scansize, float& scantime, int rate = 0);
   virtual bool SetXSMap(off_t offset);
   virtual bool VerifyXSMap(off_t offset);
+  virtual bool VerifyXSMap(off_t offset, const char* cks, int len);
 
   virtual bool OpenMap(const char* mapfilepath, size_t maxfilesize,
                        size_t blocksize, bool isRW);
@@ -0,0 +1,671 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumEngine.cc
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include "fst/checksum/ChecksumEngine.hh"
+#include "fst/checksum/crc32c.h"
+/*----------------------------------------------------------------------------*/
+#include <sys/time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+/*----------------------------------------------------------------------------*/
+
+EOSFSTNAMESPACE_BEGIN
+
+//! Data going through all the checksums before the next slice is touched
+static const size_t sSliceSize = 256 * 1024;
+//! Data read and checksummed at once by a scanning thread
+static const size_t sSegmentSize = 4 * 1024 * 1024;
+//! Max. memory used by the read buffers of a parallel scan
+static const size_t sMaxBufferMemory = 256 * 1024 * 1024;
+//! Max. data given at once to the zlib functions which take 32 bit lengths
+static const size_t sMaxZlibLength = 1024 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+// Multiply a vector by a 32x32 matrix over GF(2)
+//------------------------------------------------------------------------------
+static uint32_t
+gf2_matrix_times(const uint32_t* mat, uint32_t vec)
+{
+  uint32_t sum = 0;
+
+  while (vec) {
+    if (vec & 1) {
+      sum ^= *mat;
+    }
+
+    vec >>= 1;
+    mat++;
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Square a 32x32 matrix over GF(2)
+//------------------------------------------------------------------------------
+static void
+gf2_matrix_square(uint32_t* square, const uint32_t* mat)
+{
+  for (int n = 0; n < 32; n++) {
+    square[n] = gf2_matrix_times(mat, mat[n]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Combine two crc32c checksums, same algorithm as crc32_combine of zlib with
+// the Castagnoli polynomial
+//------------------------------------------------------------------------------
+static uint32_t
+crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+  uint32_t even[32]; // even-power-of-two zeros operator
+  uint32_t odd[32]; // odd-power-of-two zeros operator
+
+  if (!len2) {
+    return crc1;
+  }
+
+  // Operator for one zero bit in odd
+  odd[0] = 0x82f63b78;
+  uint32_t row = 1;
+
+  for (int n = 1; n < 32; n++) {
+    odd[n] = row;
+    row <<= 1;
+  }
+
+  // Operators for two and four zero bits
+  gf2_matrix_square(even, odd);
+  gf2_matrix_square(odd, even);
+
+  // Apply len2 zeros to crc1, the first square puts the operator for one
+  // zero byte (eight zero bits) in even
+  do {
+    gf2_matrix_square(even, odd);
+
+    if (len2 & 1) {
+      crc1 = gf2_matrix_times(even, crc1);
+    }
+
+    len2 >>= 1;
+
+    if (!len2) {
+      break;
+    }
+
+    gf2_matrix_square(odd, even);
+
+    if (len2 & 1) {
+      crc1 = gf2_matrix_times(odd, crc1);
+    }
+
+    len2 >>= 1;
+  } while (len2);
+
+  return crc1 ^ crc2;
+}
+
+//------------------------------------------------------------------------------
+// Digest constructor
+//------------------------------------------------------------------------------
+ChecksumEngine::Digest::Digest(Kind kind):
+  mKind(kind), mValue(0)
+{
+  Reset();
+}
+
+//------------------------------------------------------------------------------
+// Digest reset
+//------------------------------------------------------------------------------
+void
+ChecksumEngine::Digest::Reset()
+{
+  switch (mKind) {
+  case kAdler:
+    mValue = adler32(0L, Z_NULL, 0);
+    break;
+
+  case kCRC32:
+    mValue = crc32(0L, Z_NULL, 0);
+    break;
+
+  case kCRC32C:
+    mValue = checksum::crc32cInit();
+    break;
+
+  case kMD5:
+    MD5_Init(&mMD5);
+    break;
+
+  case kSHA1:
+    SHA1_Init(&mSHA1);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Digest update
+//------------------------------------------------------------------------------
+void
+ChecksumEngine::Digest::Update(const char* buffer, size_t length)
+{
+  switch (mKind) {
+  case kAdler:
+  case kCRC32:
+    while (length) {
+      size_t len = std::min(length, sMaxZlibLength);
+      mValue = (mKind == kAdler) ?
+               adler32(mValue, (const Bytef*) buffer, len) :
+               crc32(mValue, (const Bytef*) buffer, len);
+      buffer += len;
+      length -= len;
+    }
+
+    break;
+
+  case kCRC32C:
+    mValue = checksum::crc32c(mValue, buffer, length);
+    break;
+
+  case kMD5:
+    MD5_Update(&mMD5, buffer, length);
+    break;
+
+  case kSHA1:
+    SHA1_Update(&mSHA1, buffer, length);
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Digest finalization
+//------------------------------------------------------------------------------
+int
+ChecksumEngine::Digest::Final(char* out)
+{
+  switch (mKind) {
+  case kAdler:
+  case kCRC32:
+    memcpy(out, &mValue, sizeof(mValue));
+    return sizeof(mValue);
+
+  case kCRC32C: {
+    uint32_t value = checksum::crc32cFinish(mValue);
+    memcpy(out, &value, sizeof(value));
+    return sizeof(value);
+  }
+
+  case kMD5:
+    MD5_Final((unsigned char*) out, &mMD5);
+    return MD5_DIGEST_LENGTH;
+
+  case kSHA1:
+    SHA1_Final((unsigned char*) out, &mSHA1);
+    return SHA_DIGEST_LENGTH;
+
+  default:
+    return 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ChecksumEngine::ChecksumEngine(CheckSum* file_xs, CheckSum* block_xs):
+  mFileXS(file_xs), mBlockXS(block_xs), mFileKind(GetKind(file_xs)),
+  mBlockKind(GetKind(block_xs)), mBlockSize(0), mBlockCorrupted(false)
+{
+  if (mBlockXS) {
+    mBlockSize = mBlockXS->GetBlockSize();
+
+    if (!mBlockSize) {
+      mBlockXS = 0;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the kernel kind of a checksum object
+//------------------------------------------------------------------------------
+ChecksumEngine::Kind
+ChecksumEngine::GetKind(CheckSum* xs)
+{
+  if (!xs) {
+    return kNone;
+  }
+
+  std::string name = xs->GetName();
+
+  if (name == "adler") {
+    return kAdler;
+  } else if (name == "crc32") {
+    return kCRC32;
+  } else if (name == "crc32c") {
+    return kCRC32C;
+  } else if (name == "md5") {
+    return kMD5;
+  } else if (name == "sha1") {
+    return kSHA1;
+  }
+
+  return kNone;
+}
+
+//------------------------------------------------------------------------------
+// Combine the binary checksums of two consecutive pieces of data
+//------------------------------------------------------------------------------
+uint32_t
+ChecksumEngine::Combine(Kind kind, uint32_t first, uint32_t second,
+                        size_t second_length)
+{
+  switch (kind) {
+  case kAdler:
+    return adler32_combine(first, second, second_length);
+
+  case kCRC32:
+    return crc32_combine(first, second, second_length);
+
+  case kCRC32C:
+    return crc32c_combine(first, second, second_length);
+
+  default:
+    return 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add a buffer to the file checksum and verify the blocks contained in it
+//------------------------------------------------------------------------------
+void
+ChecksumEngine::Check(const char* buffer, size_t length, off_t offset)
+{
+  off_t end = offset + length;
+  // Range of the whole blocks inside the buffer
+  off_t first = end;
+  off_t last = end;
+  size_t slice = sSliceSize;
+
+  if (mBlockXS && !mBlockCorrupted) {
+    first = ((offset + mBlockSize - 1) / mBlockSize) * mBlockSize;
+    last = (end / mBlockSize) * mBlockSize;
+
+    if (last <= first) {
+      first = last = end;
+    } else {
+      slice = std::max(mBlockSize, (sSliceSize / mBlockSize) * mBlockSize);
+    }
+  }
+
+  off_t pos = offset;
+
+  while (pos < end) {
+    size_t len;
+
+    if (pos < first) {
+      // Leading piece of a block
+      len = std::min((off_t) slice, first - pos);
+    } else if (pos < last) {
+      len = std::min((off_t) slice, last - pos);
+    } else {
+      len = std::min((off_t) slice, end - pos);
+    }
+
+    const char* ptr = buffer + (pos - offset);
+
+    if (mFileXS) {
+      mFileXS->Add(ptr, len, pos);
+    }
+
+    if ((pos >= first) && (pos < last) && !mBlockCorrupted) {
+      CheckBlocks(ptr, len, pos);
+    }
+
+    pos += len;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Verify the block checksums of a block aligned piece of data
+//------------------------------------------------------------------------------
+void
+ChecksumEngine::CheckBlocks(const char* buffer, size_t length, off_t offset)
+{
+  if (mBlockKind == kNone) {
+    // Unknown algorithm, let the checksum object do it
+    if (!mBlockXS->CheckBlockSum(offset, buffer, length)) {
+      mBlockCorrupted = true;
+    }
+
+    return;
+  }
+
+  Digest digest(mBlockKind);
+  char cks[SHA_DIGEST_LENGTH];
+
+  for (size_t done = 0; done < length; done += mBlockSize) {
+    digest.Reset();
+    digest.Update(buffer + done, mBlockSize);
+    int len = digest.Final(cks);
+
+    if (!mBlockXS->VerifyXSMap(offset + done, cks, len)) {
+      mBlockCorrupted = true;
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sleep as long as needed to stay below the scan rate
+//------------------------------------------------------------------------------
+void
+ChecksumEngine::Regulate(const struct timeval& start, off_t offset, int rate,
+                         float& scantime)
+{
+  struct timeval now;
+  gettimeofday(&now, 0);
+  scantime = (((now.tv_sec - start.tv_sec) * 1000.0) +
+              ((now.tv_usec - start.tv_usec) / 1000.0));
+
+  if (rate) {
+    float expecttime = (1.0 * offset / rate) / 1000.0;
+
+    if (expecttime > scantime) {
+      usleep(1000.0 * (expecttime - scantime));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Scan a whole file
+//------------------------------------------------------------------------------
+bool
+ChecksumEngine::ScanFile(const ReadFunc& reader, off_t size,
+                         unsigned long long& scansize, float& scantime,
+                         int rate, int nthreads)
+{
+  if ((nthreads > 1) && (size > (off_t)(2 * sSegmentSize)) &&
+      (!mFileXS || IsCombinable(mFileKind)) &&
+      (!mBlockXS || (mBlockKind != kNone))) {
+    return ScanParallel(reader, size, scansize, scantime, rate, nthreads);
+  }
+
+  struct timeval start;
+  gettimeofday(&start, 0);
+  scansize = 0;
+  scantime = 0;
+  size_t buffersize = sSegmentSize;
+
+  if (mBlockXS) {
+    buffersize = std::max(mBlockSize, (sSegmentSize / mBlockSize) * mBlockSize);
+  }
+
+  char* buffer = (char*) malloc(buffersize);
+
+  if (!buffer) {
+    return false;
+  }
+
+  if (mFileXS) {
+    mFileXS->Reset();
+  }
+
+  int64_t nread = 0;
+  off_t offset = 0;
+
+  do {
+    nread = reader(offset, buffer, buffersize);
+
+    if (nread < 0) {
+      free(buffer);
+      return false;
+    }
+
+    if (nread > 0) {
+      Check(buffer, nread, offset);
+      offset += nread;
+    }
+
+    Regulate(start, offset, rate, scantime);
+  } while (nread == (int64_t) buffersize);
+
+  free(buffer);
+
+  if (mFileXS) {
+    mFileXS->Finalize();
+  }
+
+  scansize = offset;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Scan a whole file with several threads
+//------------------------------------------------------------------------------
+bool
+ChecksumEngine::ScanParallel(const ReadFunc& reader, off_t size,
+                             unsigned long long& scansize, float& scantime,
+                             int rate, int nthreads)
+{
+  //----------------------------------------------------------------------------
+  // Result of a segment, kept until the segments before it are combined
+  //----------------------------------------------------------------------------
+  struct Segment {
+    Segment(): nread(0), partial(0), cks_len(0), done(false) {}
+
+    int64_t nread; ///< bytes read, -1 on error
+    uint32_t partial; ///< file checksum of the segment
+    std::string blocks; ///< checksums of the whole blocks of the segment
+    int cks_len; ///< length of a block checksum
+    bool done; ///< result is ready
+  };
+
+  struct timeval start;
+  gettimeofday(&start, 0);
+  scansize = 0;
+  scantime = 0;
+  size_t segsize = sSegmentSize;
+
+  if (mBlockXS) {
+    segsize = std::max(mBlockSize, (sSegmentSize / mBlockSize) * mBlockSize);
+  }
+
+  nthreads = std::max(1, std::min(nthreads, (int)(sMaxBufferMemory / segsize)));
+  uint64_t nsegments = (size + segsize - 1) / segsize;
+  uint64_t window = 2 * nthreads;
+  std::vector<Segment> slots(window);
+  std::vector<std::vector<char> > buffers;
+
+  try {
+    buffers.resize(nthreads, std::vector<char>(segsize));
+  } catch (std::bad_alloc& e) {
+    return false;
+  }
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  uint64_t next = 0;
+  uint64_t consumed = 0;
+  bool stop = false;
+  // Segments are handed out in order but at most window segments ahead of the
+  // one being combined, their results wait in the slots
+  auto worker = [&](char* buffer) {
+    while (true) {
+      uint64_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] {
+          return (stop || (next >= nsegments) || (next < consumed + window));
+        });
+
+        if (stop || (next >= nsegments)) {
+          return;
+        }
+
+        index = next++;
+      }
+      Segment& seg = slots[index % window];
+      off_t offset = index * segsize;
+      size_t length = std::min((off_t) segsize, size - offset);
+      int64_t nread = 0;
+
+      while (nread < (int64_t) length) {
+        int64_t n = reader(offset + nread, buffer + nread, length - nread);
+
+        if (n < 0) {
+          nread = -1;
+          break;
+        }
+
+        if (!n) {
+          break;
+        }
+
+        nread += n;
+      }
+
+      if (nread >= 0) {
+        if (mFileXS) {
+          Digest digest(mFileKind);
+          digest.Update(buffer, nread);
+          digest.Final((char*) &seg.partial);
+        }
+
+        if (mBlockXS) {
+          Digest digest(mBlockKind);
+          char cks[SHA_DIGEST_LENGTH];
+          seg.blocks.clear();
+
+          for (int64_t done = 0; done + (int64_t) mBlockSize <= nread;
+               done += mBlockSize) {
+            digest.Reset();
+            digest.Update(buffer + done, mBlockSize);
+            seg.cks_len = digest.Final(cks);
+            seg.blocks.append(cks, seg.cks_len);
+          }
+        }
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        seg.nread = nread;
+        seg.done = true;
+      }
+      cond.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < nthreads; ++i) {
+    threads.push_back(std::thread(worker, &buffers[i][0]));
+  }
+
+  bool ok = true;
+  uint32_t value = 0;
+  off_t offset = 0;
+
+  for (uint64_t index = 0; index < nsegments; ++index) {
+    Segment& seg = slots[index % window];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&] { return seg.done; });
+    }
+
+    if (seg.nread < 0) {
+      ok = false;
+      break;
+    }
+
+    if (mFileXS) {
+      value = (index ? Combine(mFileKind, value, seg.partial, seg.nread) :
+               seg.partial);
+    }
+
+    if (mBlockXS && seg.cks_len) {
+      for (size_t i = 0; (i < seg.blocks.size()) && !mBlockCorrupted;
+           i += seg.cks_len) {
+        off_t block = offset + (i / seg.cks_len) * mBlockSize;
+
+        if (!mBlockXS->VerifyXSMap(block, seg.blocks.c_str() + i, seg.cks_len)) {
+          mBlockCorrupted = true;
+        }
+      }
+    }
+
+    bool truncated = (offset + seg.nread < std::min((off_t)((index + 1) * segsize),
+                      size));
+    offset += seg.nread;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      seg.done = false;
+      seg.cks_len = 0;
+      ++consumed;
+    }
+    cond.notify_all();
+    Regulate(start, offset, rate, scantime);
+
+    if (truncated) {
+      // The file shrank while being scanned
+      break;
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stop = true;
+  }
+  cond.notify_all();
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  if (!ok) {
+    return false;
+  }
+
+  if (mFileXS) {
+    // The checksum object gets the combined value as finalized checksum
+    mFileXS->Reset();
+    mFileXS->Finalize();
+    mFileXS->SetBinChecksum(&value, sizeof(value));
+  }
+
+  scansize = offset;
+  return true;
+}
+
+EOSFSTNAMESPACE_END
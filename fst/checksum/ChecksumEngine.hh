@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumEngine.hh
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_CHECKSUMENGINE_HH__
+#define __EOSFST_CHECKSUMENGINE_HH__
+
+/*----------------------------------------------------------------------------*/
+#include "fst/Namespace.hh"
+#include "fst/checksum/CheckSum.hh"
+/*----------------------------------------------------------------------------*/
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+#include <stdint.h>
+#include <functional>
+/*----------------------------------------------------------------------------*/
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class computing the file checksum and verifying the block checksums of a
+//! file in a single pass over the data
+//!
+//! The data is processed in slices small enough to stay in the CPU cache, each
+//! slice going through the file checksum and the block checksums before the
+//! next one is touched. The block checksums are computed with the stateless
+//! kernels of the Digest class instead of resetting the block checksum object
+//! for every block.
+//!
+//! A whole file can also be scanned by several threads, each reading and
+//! checksumming segments of the file. The partial file checksums of the
+//! segments are combined in order, which is possible for adler32, crc32 and
+//! crc32c. Files with an md5 or sha1 file checksum are scanned by one thread.
+//------------------------------------------------------------------------------
+class ChecksumEngine
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Checksum algorithms known to the kernels
+  //----------------------------------------------------------------------------
+  enum Kind { kNone, kAdler, kCRC32, kCRC32C, kMD5, kSHA1 };
+
+  //----------------------------------------------------------------------------
+  //! Function reading from the file being scanned, must be callable from
+  //! several threads at once when scanning with more than one thread
+  //!
+  //! @return number of bytes read, -1 on error
+  //----------------------------------------------------------------------------
+  typedef std::function<int64_t(off_t offset, char* buffer, size_t length)>
+  ReadFunc;
+
+  //----------------------------------------------------------------------------
+  //! Stateless checksum kernel producing the binary checksum in the format of
+  //! CheckSum::GetBinChecksum
+  //----------------------------------------------------------------------------
+  class Digest
+  {
+  public:
+    Digest(Kind kind);
+
+    void Reset();
+    void Update(const char* buffer, size_t length);
+
+    //--------------------------------------------------------------------------
+    //! Finalize the checksum
+    //!
+    //! @param out receives the binary checksum, at least 20 bytes
+    //!
+    //! @return length of the binary checksum
+    //--------------------------------------------------------------------------
+    int Final(char* out);
+
+  private:
+    Kind mKind; ///< algorithm
+    uint32_t mValue; ///< running value of the 32 bit algorithms
+    MD5_CTX mMD5; ///< md5 context
+    SHA_CTX mSHA1; ///< sha1 context
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param file_xs file checksum object or 0, not owned
+  //! @param block_xs block checksum object with an open map or 0, not owned
+  //----------------------------------------------------------------------------
+  ChecksumEngine(CheckSum* file_xs, CheckSum* block_xs);
+
+  //----------------------------------------------------------------------------
+  //! Add a buffer to the file checksum and verify the blocks fully contained
+  //! in it. Once a block checksum mismatches the blocks are not verified
+  //! anymore.
+  //!
+  //! @param buffer data
+  //! @param length length of the data
+  //! @param offset file offset of the data
+  //----------------------------------------------------------------------------
+  void Check(const char* buffer, size_t length, off_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Scan a whole file, the file checksum is finalized afterwards
+  //!
+  //! @param reader function reading from the file
+  //! @param size size of the file
+  //! @param scansize returns the number of bytes scanned
+  //! @param scantime returns the scan time in ms
+  //! @param rate max. scan rate in MB/s, 0 for no limit
+  //! @param nthreads number of threads reading and checksumming
+  //!
+  //! @return true if successful, false if reading failed
+  //----------------------------------------------------------------------------
+  bool ScanFile(const ReadFunc& reader, off_t size,
+                unsigned long long& scansize, float& scantime,
+                int rate = 0, int nthreads = 1);
+
+  //----------------------------------------------------------------------------
+  //! Check if a block checksum mismatched
+  //----------------------------------------------------------------------------
+  bool
+  IsBlockCorrupted() const
+  {
+    return mBlockCorrupted;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the kernel kind of a checksum object
+  //----------------------------------------------------------------------------
+  static Kind GetKind(CheckSum* xs);
+
+  //----------------------------------------------------------------------------
+  //! Check if the checksums of consecutive pieces of data can be combined
+  //----------------------------------------------------------------------------
+  static bool
+  IsCombinable(Kind kind)
+  {
+    return ((kind == kAdler) || (kind == kCRC32) || (kind == kCRC32C));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Combine the binary checksums of two consecutive pieces of data
+  //!
+  //! @param kind adler32, crc32 or crc32c
+  //! @param first checksum of the first piece
+  //! @param second checksum of the second piece
+  //! @param second_length length of the second piece
+  //!
+  //! @return checksum of both pieces
+  //----------------------------------------------------------------------------
+  static uint32_t Combine(Kind kind, uint32_t first, uint32_t second,
+                          size_t second_length);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Verify the block checksums of a block aligned piece of data
+  //----------------------------------------------------------------------------
+  void CheckBlocks(const char* buffer, size_t length, off_t offset);
+
+  //----------------------------------------------------------------------------
+  //! Scan a whole file with several threads
+  //----------------------------------------------------------------------------
+  bool ScanParallel(const ReadFunc& reader, off_t size,
+                    unsigned long long& scansize, float& scantime, int rate,
+                    int nthreads);
+
+  //----------------------------------------------------------------------------
+  //! Sleep as long as needed to stay below the scan rate
+  //----------------------------------------------------------------------------
+  static void Regulate(const struct timeval& start, off_t offset, int rate,
+                       float& scantime);
+
+  CheckSum* mFileXS; ///< file checksum
+  CheckSum* mBlockXS; ///< block checksum with an open map
+  Kind mFileKind; ///< kernel of the file checksum
+  Kind mBlockKind; ///< kernel of the block checksums
+  size_t mBlockSize; ///< block size of the block checksums
+  bool mBlockCorrupted; ///< a block checksum mismatched
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
@@ -44,6 +44,8 @@ EOSFSTNAMESPACE_BEGIN
 XrdSysMutex HttpHandler::mOpenMutexMapMutex;
 std::map<unsigned int, XrdSysMutex*> HttpHandler::mOpenMutexMap;
 eos::common::MimeTypes HttpHandler::gMime;
+bool HttpHandler::gZeroCopy = (!getenv("EOS_FST_HTTP_ZEROCOPY") ||
+                               strcmp(getenv("EOS_FST_HTTP_ZEROCOPY"), "0"));
 
 /*----------------------------------------------------------------------------*/
 
@@ -355,6 +357,16 @@ HttpHandler::Get (eos::common::HttpRequest *request)
     response->AddHeader("Last-Modified", eos::common::Timing::utctime(mtime));
     // We want to use the file callbacks
     response->mUseFileReaderCallback = true;
+
+    // Full file and single range downloads can be sent by the HTTP server
+    // straight from the local replica if the layout allows it
+    if (gZeroCopy && (request->GetMethod() == "GET") && mRequestSize &&
+        (!mRangeRequest || (mOffsetMap.size() == 1)))
+    {
+      mZeroCopy = true;
+      mZeroCopyOffset = mRangeRequest ? mOffsetMap.begin()->first : 0;
+      mZeroCopyLength = mRequestSize;
+    }
   }
 
   return response;
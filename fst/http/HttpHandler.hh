@@ -77,10 +77,15 @@ public:
   std::string                mLogId;              //< log id used in EOS - determined after Ofs::Open
   int                        mErrCode;            //< first seen error code
   std::string                mErrText;            //< error text
+  bool                       mZeroCopy;           //< response can be sent from the local replica
+  off_t                      mZeroCopyOffset;     //< offset of the zero-copy response
+  off_t                      mZeroCopyLength;     //< length of the zero-copy response
+  bool                       mZeroCopySent;       //< true when the zero-copy response was queued
 
   static XrdSysMutex mOpenMutexMapMutex;
   static std::map<unsigned int, XrdSysMutex*> mOpenMutexMap;
   static eos::common::MimeTypes gMime;
+  static bool gZeroCopy; //< zero-copy responses enabled (EOS_FST_HTTP_ZEROCOPY)
   /**
    * Constructor
    */
@@ -107,6 +112,10 @@ public:
     mUploadLeftSize         = 0;
     mLastChunk              = false;
     mErrCode                = 0;
+    mZeroCopy               = false;
+    mZeroCopyOffset         = 0;
+    mZeroCopyLength         = 0;
+    mZeroCopySent           = false;
   }
 
   /**
@@ -30,6 +30,7 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 /*----------------------------------------------------------------------------*/
+#include <unistd.h>
 
 /*----------------------------------------------------------------------------*/
 
@@ -149,10 +150,40 @@ HttpServer::Handler(void* cls,
 
   if (response->mUseFileReaderCallback) {
     eos_static_debug("response length=%d", response->mResponseLength);
-    mhdResponse = MHD_create_response_from_callback(response->mResponseLength,
-                  4 * 1024 * 1024, /* 4M page size */
-                  &HttpServer::FileReaderCallback,
-                  (void*) protocolHandler, 0);
+    eos::fst::HttpHandler* httpHandle = dynamic_cast<eos::fst::HttpHandler*>
+                                        (protocolHandler);
+    mhdResponse = 0;
+
+    if (httpHandle && httpHandle->mZeroCopy && httpHandle->mFile) {
+      // Let MHD send the data with sendfile from the local replica, it owns
+      // the descriptor from now on
+      int fd = httpHandle->mFile->GetZeroCopyFd();
+
+      if (fd >= 0) {
+#if MHD_VERSION >= 0x00094400
+        mhdResponse = MHD_create_response_from_fd_at_offset64(
+                        httpHandle->mZeroCopyLength, fd,
+                        httpHandle->mZeroCopyOffset);
+#else
+        mhdResponse = MHD_create_response_from_fd_at_offset(
+                        httpHandle->mZeroCopyLength, fd,
+                        httpHandle->mZeroCopyOffset);
+#endif
+
+        if (mhdResponse) {
+          httpHandle->mZeroCopySent = true;
+        } else {
+          close(fd);
+        }
+      }
+    }
+
+    if (!mhdResponse) {
+      mhdResponse = MHD_create_response_from_callback(response->mResponseLength,
+                    4 * 1024 * 1024, /* 4M page size */
+                    &HttpServer::FileReaderCallback,
+                    (void*) protocolHandler, 0);
+    }
   } else {
     mhdResponse = MHD_create_response_from_buffer(response->GetBodySize(),
                   (void*) response->GetBody().c_str(),
@@ -344,6 +375,18 @@ HttpServer::CompleteHandler(void*                              cls,
   }
 
   if (httpHandle) {
+    // The data of zero-copy responses did not go through the file object,
+    // account it now for the checksum and the IO report
+    if (httpHandle->mZeroCopySent && httpHandle->mFile &&
+        (toe == MHD_REQUEST_TERMINATED_COMPLETED_OK)) {
+      if (httpHandle->mFile->ZeroCopyRead(httpHandle->mZeroCopyOffset,
+                                          httpHandle->mZeroCopyLength) < 0) {
+        eos_static_err("msg=\"zero-copy read accounting failed\" path=\"%s\" "
+                       "error=\"%s\"", httpHandle->mFile->GetPath().c_str(),
+                       httpHandle->mFile->error.getErrText());
+      }
+    }
+
     // deal with delete-on-close logic
     if ((toe != MHD_REQUEST_TERMINATED_COMPLETED_OK)) {
       eos_static_info("msg=\"http connection disconnect\" action=\"Cleanup\" ");
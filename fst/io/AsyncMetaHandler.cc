@@ -28,7 +28,7 @@
 EOSFSTNAMESPACE_BEGIN
 
 ///! maximum number of obj in cache used for recycling
-const unsigned int AsyncMetaHandler::msMaxNumAsyncObj = 20;
+unsigned int AsyncMetaHandler::msMaxNumAsyncObj = 20;
 
 //------------------------------------------------------------------------------
 // Constructor
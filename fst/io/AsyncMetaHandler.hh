@@ -117,6 +117,27 @@ public:
   //----------------------------------------------------------------------------
   void Reset();
 
+  //----------------------------------------------------------------------------
+  //! Set the maximum number of async requests in flight per file, to be
+  //! called before any file is opened
+  //!
+  //! @param max maximum number of requests
+  //----------------------------------------------------------------------------
+  static void SetMaxNumAsyncObj(unsigned int max)
+  {
+    if (max) {
+      msMaxNumAsyncObj = max;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of async requests in flight per file
+  //----------------------------------------------------------------------------
+  static unsigned int GetMaxNumAsyncObj()
+  {
+    return msMaxNumAsyncObj;
+  }
+
 private:
   uint16_t mErrorType; ///< type of error, we are mostly interested in timeouts
   //! number of async requests in flight (for which no response was received)
@@ -134,7 +155,7 @@ private:
   XrdCl::ChunkList mErrors; ///< chunks for which the request failed
   //! Maxium number of async requests in flight and also the maximum number
   //! of ChunkHandler object that can be saved in cache
-  static const unsigned int msMaxNumAsyncObj;
+  static unsigned int msMaxNumAsyncObj;
 };
 
 EOSFSTNAMESPACE_END
@@ -23,11 +23,13 @@
 
 #include <stdint.h>
 #include <cstdlib>
+#include <algorithm>
 #include "fst/io/xrd/XrdIo.hh"
 #include "fst/io/ChunkHandler.hh"
 #include "fst/io/VectChunkHandler.hh"
 #include "common/FileMap.hh"
 #include "common/Logging.hh"
+#include "common/Timing.hh"
 #include "XrdCl/XrdClDefaultEnv.hh"
 #include "XrdCl/XrdClBuffer.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
@@ -42,7 +44,19 @@
 EOSFSTNAMESPACE_BEGIN
 
 const uint64_t ReadaheadBlock::sDefaultBlocksize = 1 * 1024 * 1024;
-const uint32_t XrdIo::sNumRdAheadBlocks = 2;
+const uint32_t XrdIo::sMinRdAheadBlocks = 2;
+XrdSysMutex XrdIo::sBlockPoolMutex;
+std::map<uint64_t, std::list<ReadaheadBlock*> > XrdIo::sBlockPool;
+uint64_t XrdIo::sBlockPoolBytes = 0;
+uint64_t XrdIo::sBlockPoolMaxBytes =
+  (getenv("EOS_FST_XRDIO_RA_POOL_MB") ?
+   strtoull(getenv("EOS_FST_XRDIO_RA_POOL_MB"), 0, 10) : 256) * 1024 * 1024;
+// initialized after the pool size which bounds it
+uint32_t XrdIo::sMaxRdAheadBlocks = XrdIo::ClampRdAheadBlocks(
+                                      getenv("EOS_FST_XRDIO_RA_MAX_BLOCKS") ?
+                                      strtoul(getenv("EOS_FST_XRDIO_RA_MAX_BLOCKS"), 0, 10) : 16,
+                                      ReadaheadBlock::sDefaultBlocksize);
+ReadaheadStats XrdIo::sRaStats;
 uint32_t XrdIo::sConnectionPoolMaxSize = 64;
 XrdSysMutex XrdIo::sConnectionPoolMutex;
 std::map<std::string, std::map<int, size_t> > XrdIo::sConnectionPool;
@@ -99,8 +113,21 @@ XrdIo::XrdIo(std::string path) :
   mDoReadahead(false),
   mBlocksize(ReadaheadBlock::sDefaultBlocksize),
   mXrdFile(NULL),
-  mMetaHandler(new AsyncMetaHandler())
+  mMetaHandler(new AsyncMetaHandler()),
+  mRaPattern(kRaSequential),
+  mRaLastOffset(-1),
+  mRaLastEnd(0),
+  mRaStride(0),
+  mRaStrideHits(0),
+  mRaNextOffset(-1),
+  mRaEofOffset(-1),
+  mRaWindow(sMinRdAheadBlocks),
+  mRaMaxWindow(sMaxRdAheadBlocks),
+  mRaCalmHits(0),
+  mRaLatencyNs(0),
+  mRaIntervalNs(0)
 {
+  mRaLastConsumed.tv_sec = mRaLastConsumed.tv_nsec = 0;
   // Set the TimeoutResolution to 1
   XrdCl::Env* env = XrdCl::DefaultEnv::GetEnv();
   env->PutInt("TimeoutResolution", 1);
@@ -131,17 +158,8 @@ XrdIo::~XrdIo()
 
   DropConnection();
 
-  if (mDoReadahead) {
-    while (!mQueueBlocks.empty()) {
-      ReadaheadBlock* ptr_readblock = mQueueBlocks.front();
-      mQueueBlocks.pop();
-      delete ptr_readblock;
-    }
-
-    while (!mMapBlocks.empty()) {
-      delete mMapBlocks.begin()->second;
-      mMapBlocks.erase(mMapBlocks.begin());
-    }
+  if (!mMapBlocks.empty()) {
+    (void) DropAllBlocks();
   }
 
   delete mMetaHandler;
@@ -188,9 +206,11 @@ XrdIo::fileOpen(XrdSfsFileOpenMode flags,
       mBlocksize = static_cast<uint64_t>(atoll(val));
     }
 
-    for (unsigned int i = 0; i < sNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
+    if ((val = open_opaque.Get("fst.readahead.maxblocks"))) {
+      mRaMaxWindow = strtoul(val, 0, 10);
     }
+
+    mRaMaxWindow = ClampRdAheadBlocks(mRaMaxWindow, mBlocksize);
   }
 
   request = mFilePath;
@@ -278,9 +298,11 @@ XrdIo::fileOpenAsync(void* io_handler,
       mBlocksize = static_cast<uint64_t>(atoll(val));
     }
 
-    for (unsigned int i = 0; i < sNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
+    if ((val = open_opaque.Get("fst.readahead.maxblocks"))) {
+      mRaMaxWindow = strtoul(val, 0, 10);
     }
+
+    mRaMaxWindow = ClampRdAheadBlocks(mRaMaxWindow, mBlocksize);
   }
 
   request = mFilePath;
@@ -416,45 +438,87 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
     uint64_t read_length = 0;
     uint32_t aligned_length;
     uint32_t shift;
-    std::map<uint64_t, ReadaheadBlock*>::iterator iter;
+    bool missed = false;
+    PrefetchMap::iterator iter;
     mPrefetchMutex.Lock(); // -->
+    UpdateReadPattern(offset, length);
 
     while (length) {
       iter = FindBlock(offset);
 
       if (iter != mMapBlocks.end()) {
         // Block found in prefetched blocks
-        SimpleHandler* sh = iter->second->handler;
+        ReadaheadBlock* block = iter->second;
+        SimpleHandler* sh = block->handler;
         shift = offset - iter->first;
 
-        // We can prefetch another block if we still have available blocks in
-        // the queue or if first read was from second prefetched block
-        if (!mQueueBlocks.empty() || (iter != mMapBlocks.begin())) {
-          if (iter != mMapBlocks.begin()) {
-            eos_debug("recycle the oldest block");
-            mQueueBlocks.push(mMapBlocks.begin()->second);
-            mMapBlocks.erase(mMapBlocks.begin());
-          }
+        if (!missed) {
+          mRaStats.mHits++;
+        }
 
-          eos_debug("prefetch new block(2)");
+        missed = false;
 
-          if (!PrefetchBlock(offset + mBlocksize, false, timeout)) {
-            eos_warning("failed to send prefetch request(2)");
-            break;
+        // Blocks behind the current one in the direction of the stream are
+        // not going to be read anymore
+        if (mRaPattern == kRaBackward) {
+          PrefetchMap::iterator behind = iter;
+          ++behind;
+
+          while (behind != mMapBlocks.end()) {
+            if (!RecycleBlock(behind++)) {
+              ShrinkWindow();
+            }
+          }
+        } else {
+          while (mMapBlocks.begin() != iter) {
+            if (!RecycleBlock(mMapBlocks.begin())) {
+              ShrinkWindow();
+            }
           }
         }
 
+        if (!PrefetchWindow(timeout)) {
+          eos_warning("failed to send prefetch request(2)");
+        }
+
+        bool first_use = !block->consumed;
+        struct timespec ts;
+        eos::common::Timing::GetTimeSpec(ts);
+
         if (sh->WaitOK()) {
           eos_debug("block in cache, blk_off=%lld, req_off= %lld", iter->first, offset);
 
+          if (first_use) {
+            block->consumed = true;
+            // Consider the reader stalled if it waited more than 100us
+            bool stalled = (eos::common::Timing::GetAgeInNs(&ts) > 100000);
+
+            if (stalled) {
+              mRaStats.mStalls++;
+              long long latency = eos::common::Timing::GetAgeInNs(&block->issued);
+              mRaLatencyNs = mRaLatencyNs ? (3 * mRaLatencyNs + latency) / 4 : latency;
+            }
+
+            if (mRaLastConsumed.tv_sec) {
+              long long interval = eos::common::Timing::GetAgeInNs(&mRaLastConsumed);
+              mRaIntervalNs = mRaIntervalNs ? (3 * mRaIntervalNs + interval) / 4 :
+                              interval;
+            }
+
+            eos::common::Timing::GetTimeSpec(mRaLastConsumed);
+            AdaptWindow(stalled);
+          }
+
           if (sh->GetRespLength() == 0) {
             // The request got a response but it read 0 bytes
             eos_warning("response contains 0 bytes");
             break;
           }
 
-          aligned_length = sh->GetRespLength() - shift;
-          read_length = ((uint32_t) length < aligned_length) ? length : aligned_length;
+          if (sh->GetRespLength() != mBlocksize) {
+            // Short response, nothing to prefetch beyond this offset
+            mRaEofOffset = iter->first + sh->GetRespLength();
+          }
 
           // If prefetch block smaller than mBlocksize and current offset at end
           // of the prefetch block then we reached the end of file
@@ -464,7 +528,9 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
             break;
           }
 
-          pBuff = static_cast<char*>(memcpy(pBuff, iter->second->buffer + shift,
+          aligned_length = sh->GetRespLength() - shift;
+          read_length = ((uint32_t) length < aligned_length) ? length : aligned_length;
+          pBuff = static_cast<char*>(memcpy(pBuff, block->buffer + shift,
                                             read_length));
           pBuff += read_length;
           offset += read_length;
@@ -472,39 +538,66 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
           nread += read_length;
         } else {
           // Error while prefetching, remove block from map
-          mQueueBlocks.push(iter->second);
-          mMapBlocks.erase(iter);
+          (void) RecycleBlock(iter);
           eos_err("error=prefetching failed, disable it and remove block from map");
           mDoReadahead = false;
           break;
         }
       } else {
-        // Remove all elements from map so that we can align with the new
-        // requests and prefetch a new block. But first we need to collect any
-        // responses which are in-flight as otherwise these response might
-        // arrive later on, when we are expecting replies for other blocks since
-        // we are recycling the SimpleHandler objects.
-        while (!mMapBlocks.empty()) {
-          SimpleHandler* sh = mMapBlocks.begin()->second->handler;
-
-          if (sh->HasRequest()) {
-            // Not interested in the result - discard it
-            sh->WaitOK();
+        mRaStats.mMisses++;
+
+        // Serve the rest of a request which outgrew the window, random
+        // requests and requests past the end of file the classic way, the
+        // prefetched blocks are kept for the case the stream continues
+        if (nread || (mRaPattern == kRaRandom) ||
+            ((mRaEofOffset >= 0) && (offset >= mRaEofOffset))) {
+          if (mRaPattern == kRaRandom) {
+            ShrinkWindow();
           }
 
-          mQueueBlocks.push(mMapBlocks.begin()->second);
-          mMapBlocks.erase(mMapBlocks.begin());
+          break;
         }
 
-        if (!mQueueBlocks.empty()) {
-          eos_debug("prefetch new block(1)");
-
-          if (!PrefetchBlock(offset, false, timeout)) {
-            eos_err("error=failed to send prefetch request(1)");
-            mDoReadahead = false;
-            break;
+        // Realign the stream on the current request. The blocks which are
+        // still ahead of it are kept, the others are recycled. Any responses
+        // in-flight are collected first as the SimpleHandler objects are
+        // reused for other blocks.
+        missed = true;
+        PrefetchMap::iterator it = mMapBlocks.begin();
+
+        while (it != mMapBlocks.end()) {
+          bool ahead = (mRaPattern == kRaBackward) ?
+                       ((int64_t) it->first < offset) : ((int64_t) it->first > offset);
+
+          if (ahead) {
+            ++it;
+          } else {
+            if (!RecycleBlock(it++)) {
+              ShrinkWindow();
+            }
           }
         }
+
+        if (mRaPattern == kRaBackward) {
+          // The block ends at the end of the request
+          int64_t end = (int64_t) offset + (int64_t) length;
+          mRaNextOffset = std::max((int64_t) 0,
+                                   std::min((int64_t) offset, end - (int64_t) mBlocksize));
+        } else {
+          mRaNextOffset = offset;
+        }
+
+        eos_debug("prefetch new block(1)");
+
+        if (!PrefetchWindow(timeout)) {
+          eos_err("error=failed to send prefetch request(1)");
+          mDoReadahead = false;
+          break;
+        }
+
+        if (FindBlock(offset) == mMapBlocks.end()) {
+          break;
+        }
       }
     }
 
@@ -575,6 +668,274 @@ XrdIo::FindBlock(uint64_t offset)
   }
 }
 
+//------------------------------------------------------------------------------
+// Update the detected access pattern with a new read request
+//------------------------------------------------------------------------------
+void
+XrdIo::UpdateReadPattern(int64_t offset, int64_t length)
+{
+  if (mRaLastOffset >= 0) {
+    int64_t delta = offset - mRaLastOffset;
+
+    if (delta == mRaStride) {
+      mRaStrideHits++;
+    } else {
+      mRaStride = delta;
+      mRaStrideHits = 0;
+    }
+
+    if ((offset >= mRaLastEnd) && (offset - mRaLastEnd < (int64_t) mBlocksize)) {
+      // Contiguous or small gaps covered by the prefetched blocks
+      mRaPattern = kRaSequential;
+    } else if ((offset + length <= mRaLastOffset) &&
+               (mRaLastOffset - (offset + length) < (int64_t) mBlocksize)) {
+      mRaPattern = kRaBackward;
+    } else if (mRaStrideHits && delta) {
+      mRaPattern = (delta > 0) ? kRaStrided : kRaBackward;
+    } else {
+      mRaPattern = kRaRandom;
+    }
+  }
+
+  mRaLastOffset = offset;
+  mRaLastEnd = offset + length;
+}
+
+//------------------------------------------------------------------------------
+// Get the distance between two consecutive prefetched blocks
+//------------------------------------------------------------------------------
+int64_t
+XrdIo::GetReadaheadStep() const
+{
+  switch (mRaPattern) {
+  case kRaStrided:
+    return std::max(mRaStride, (int64_t) mBlocksize);
+
+  case kRaBackward:
+    if (mRaStrideHits && (mRaStride < -(int64_t) mBlocksize)) {
+      return mRaStride;
+    }
+
+    return -(int64_t) mBlocksize;
+
+  default:
+    return mBlocksize;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Prefetch blocks following the access pattern until the window is full
+//------------------------------------------------------------------------------
+bool
+XrdIo::PrefetchWindow(uint16_t timeout)
+{
+  if (mRaPattern == kRaRandom) {
+    return true;
+  }
+
+  int64_t step = GetReadaheadStep();
+
+  while ((mMapBlocks.size() < mRaWindow) && (mRaNextOffset >= 0)) {
+    if ((mRaEofOffset >= 0) && (mRaNextOffset >= mRaEofOffset)) {
+      break;
+    }
+
+    if (!mMapBlocks.count(mRaNextOffset)) {
+      if (!PrefetchBlock(mRaNextOffset, false, timeout)) {
+        return false;
+      }
+    }
+
+    mRaNextOffset += step;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Adapt the readahead window after consuming a prefetched block
+//------------------------------------------------------------------------------
+void
+XrdIo::AdaptWindow(bool stalled)
+{
+  uint32_t target = mRaWindow;
+
+  // Number of blocks consumed while a prefetch request is in flight plus the
+  // one being read
+  if (mRaLatencyNs && mRaIntervalNs) {
+    long long nblocks = (mRaLatencyNs + mRaIntervalNs - 1) / mRaIntervalNs + 1;
+    nblocks = std::min(nblocks, (long long) mRaMaxWindow);
+    target = std::max((uint32_t) nblocks, sMinRdAheadBlocks);
+  }
+
+  if (stalled) {
+    mRaCalmHits = 0;
+
+    if (mRaWindow < mRaMaxWindow) {
+      mRaWindow = std::min(std::max(target, mRaWindow * 2), mRaMaxWindow);
+      mRaStats.mGrows++;
+      eos_debug("readahead window grown to %u blocks", mRaWindow);
+    }
+  } else if ((++mRaCalmHits >= mRaWindow) && (target < mRaWindow)) {
+    // Only give up blocks after a full window consumed without waiting
+    mRaCalmHits = 0;
+    mRaWindow--;
+    mRaStats.mShrinks++;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Halve the readahead window
+//------------------------------------------------------------------------------
+void
+XrdIo::ShrinkWindow()
+{
+  if (mRaWindow > sMinRdAheadBlocks) {
+    mRaWindow = std::max(mRaWindow / 2, sMinRdAheadBlocks);
+    mRaStats.mShrinks++;
+    eos_debug("readahead window shrunk to %u blocks", mRaWindow);
+  }
+
+  mRaCalmHits = 0;
+}
+
+//------------------------------------------------------------------------------
+// Recycle a prefetched block
+//------------------------------------------------------------------------------
+bool
+XrdIo::RecycleBlock(PrefetchMap::iterator iter)
+{
+  ReadaheadBlock* block = iter->second;
+  mMapBlocks.erase(iter);
+
+  if (block->handler->HasRequest()) {
+    // Not interested in the result - discard it
+    (void) block->handler->WaitOK();
+  }
+
+  bool used = block->consumed;
+
+  if (block->handler->GetRespStatus()) {
+    mRaStats.mPrefetchedBytes += block->handler->GetRespLength();
+
+    if (!used) {
+      mRaStats.mWastedBytes += block->handler->GetRespLength();
+    }
+  }
+
+  PutPoolBlock(block);
+  return used;
+}
+
+//------------------------------------------------------------------------------
+// Recycle all prefetched blocks
+//------------------------------------------------------------------------------
+bool
+XrdIo::DropAllBlocks()
+{
+  bool all_ok = true;
+
+  while (!mMapBlocks.empty()) {
+    SimpleHandler* shandler = mMapBlocks.begin()->second->handler;
+
+    if (shandler->HasRequest()) {
+      all_ok = shandler->WaitOK() && all_ok;
+    }
+
+    (void) RecycleBlock(mMapBlocks.begin());
+  }
+
+  if (mRaStats.mHits || mRaStats.mMisses) {
+    eos_info("msg=\"readahead statistics\" path=%s hits=%llu misses=%llu "
+             "prefetched=%llu wasted=%llu stalls=%llu grows=%llu shrinks=%llu "
+             "window=%u", mFilePath.c_str(),
+             (unsigned long long) mRaStats.mHits,
+             (unsigned long long) mRaStats.mMisses,
+             (unsigned long long) mRaStats.mPrefetchedBytes,
+             (unsigned long long) mRaStats.mWastedBytes,
+             (unsigned long long) mRaStats.mStalls,
+             (unsigned long long) mRaStats.mGrows,
+             (unsigned long long) mRaStats.mShrinks, mRaWindow);
+    XrdSysMutexHelper lock(sBlockPoolMutex);
+    sRaStats.Add(mRaStats);
+  }
+
+  mRaStats = ReadaheadStats();
+  return all_ok;
+}
+
+//------------------------------------------------------------------------------
+// Get a block from the shared pool or allocate a new one
+//------------------------------------------------------------------------------
+ReadaheadBlock*
+XrdIo::GetPoolBlock(uint64_t blocksize)
+{
+  {
+    XrdSysMutexHelper lock(sBlockPoolMutex);
+    std::list<ReadaheadBlock*>& idle = sBlockPool[blocksize];
+
+    if (!idle.empty()) {
+      ReadaheadBlock* block = idle.front();
+      idle.pop_front();
+      sBlockPoolBytes -= blocksize;
+      block->consumed = false;
+      return block;
+    }
+  }
+
+  return new ReadaheadBlock(blocksize);
+}
+
+//------------------------------------------------------------------------------
+// Give a block back to the shared pool
+//------------------------------------------------------------------------------
+void
+XrdIo::PutPoolBlock(ReadaheadBlock* block)
+{
+  {
+    XrdSysMutexHelper lock(sBlockPoolMutex);
+
+    if (sBlockPoolBytes + block->size <= sBlockPoolMaxBytes) {
+      sBlockPool[block->size].push_front(block);
+      sBlockPoolBytes += block->size;
+      return;
+    }
+  }
+
+  delete block;
+}
+
+//------------------------------------------------------------------------------
+// Bound the number of readahead blocks in flight by the pool size
+//------------------------------------------------------------------------------
+uint32_t
+XrdIo::ClampRdAheadBlocks(unsigned long nblocks, uint64_t blocksize)
+{
+  if (blocksize && (nblocks > sBlockPoolMaxBytes / blocksize)) {
+    nblocks = sBlockPoolMaxBytes / blocksize;
+  }
+
+  return std::max(sMinRdAheadBlocks, (uint32_t) nblocks);
+}
+
+//------------------------------------------------------------------------------
+// Get the aggregated readahead counters and the state of the block pool
+//------------------------------------------------------------------------------
+void
+XrdIo::GetReadaheadStats(ReadaheadStats& stats, uint64_t& pool_blocks,
+                         uint64_t& pool_bytes)
+{
+  XrdSysMutexHelper lock(sBlockPoolMutex);
+  stats = sRaStats;
+  pool_blocks = 0;
+
+  for (auto it = sBlockPool.begin(); it != sBlockPool.end(); ++it) {
+    pool_blocks += it->second.size();
+  }
+
+  pool_bytes = sBlockPoolBytes;
+}
+
 //------------------------------------------------------------------------------
 // Vector read - sync
 //------------------------------------------------------------------------------
@@ -830,18 +1191,10 @@ XrdIo::fileClose(uint16_t timeout)
   bool async_ok = true;
   mIsOpen = false;
 
-  if (mDoReadahead) {
-    // Wait for any requests on the fly and then close
-    while (!mMapBlocks.empty()) {
-      SimpleHandler* shandler = mMapBlocks.begin()->second->handler;
-
-      if (shandler->HasRequest()) {
-        async_ok = shandler->WaitOK();
-      }
-
-      delete mMapBlocks.begin()->second;
-      mMapBlocks.erase(mMapBlocks.begin());
-    }
+  // Wait for any requests on the fly and give the blocks back to the pool.
+  // Readahead could have been disabled after an error with blocks still around.
+  if (!mMapBlocks.empty() || mDoReadahead) {
+    async_ok = DropAllBlocks();
   }
 
   // Wait for any async requests before closing
@@ -969,15 +1322,9 @@ XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
   eos_debug("try to prefetch with offset: %lli, length: %4u",
             offset, mBlocksize);
 
-  if (!mQueueBlocks.empty()) {
-    block = mQueueBlocks.front();
-    mQueueBlocks.pop();
-  } else {
-    done = false;
-    return done;
-  }
-
+  block = GetPoolBlock(mBlocksize);
   block->handler->Update(offset, mBlocksize, isWrite);
+  eos::common::Timing::GetTimeSpec(block->issued);
   status = mXrdFile->Read(offset, mBlocksize, block->buffer, block->handler,
                           timeout);
 
@@ -985,7 +1332,8 @@ XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
     // Create tmp status which is deleted in the HandleResponse method
     XrdCl::XRootDStatus* tmp_status = new XrdCl::XRootDStatus(status);
     block->handler->HandleResponse(tmp_status, NULL);
-    mQueueBlocks.push(block);
+    (void) block->handler->WaitOK();
+    PutPoolBlock(block);
     done = false;
   } else {
     mMapBlocks.insert(std::make_pair(offset, block));
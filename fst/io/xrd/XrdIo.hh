@@ -29,7 +29,8 @@
 #include "fst/io/SimpleHandler.hh"
 #include "common/FileMap.hh"
 #include "XrdCl/XrdClFile.hh"
-#include <queue>
+#include <list>
+#include <time.h>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -88,10 +89,12 @@ struct ReadaheadBlock {
   //!
   //! @param blocksize the size of the readahead
   //----------------------------------------------------------------------------
-  ReadaheadBlock(uint64_t blocksize = sDefaultBlocksize)
+  ReadaheadBlock(uint64_t blocksize = sDefaultBlocksize):
+    size(blocksize), consumed(false)
   {
     buffer = new char[blocksize];
     handler = new SimpleHandler();
+    issued.tv_sec = issued.tv_nsec = 0;
   }
 
   //----------------------------------------------------------------------------
@@ -117,6 +120,40 @@ struct ReadaheadBlock {
 
   char* buffer; ///< pointer to where the data is read
   SimpleHandler* handler; ///< async handler for the requests
+  uint64_t size; ///< size of the buffer
+  bool consumed; ///< mark if the reader used data from this block
+  struct timespec issued; ///< time when the prefetch request was sent
+};
+
+//------------------------------------------------------------------------------
+//! Readahead counters, kept per file and aggregated over all files
+//------------------------------------------------------------------------------
+struct ReadaheadStats {
+  uint64_t mHits; ///< reads served from prefetched blocks
+  uint64_t mMisses; ///< reads not found in the prefetched blocks
+  uint64_t mPrefetchedBytes; ///< bytes received by prefetch requests
+  uint64_t mWastedBytes; ///< prefetched bytes recycled without being read
+  uint64_t mStalls; ///< hits which had to wait for the prefetch response
+  uint64_t mGrows; ///< number of times the window was enlarged
+  uint64_t mShrinks; ///< number of times the window was reduced
+
+  ReadaheadStats():
+    mHits(0), mMisses(0), mPrefetchedBytes(0), mWastedBytes(0), mStalls(0),
+    mGrows(0), mShrinks(0) {}
+
+  //----------------------------------------------------------------------------
+  //! Add the counters of another object
+  //----------------------------------------------------------------------------
+  void Add(const ReadaheadStats& other)
+  {
+    mHits += other.mHits;
+    mMisses += other.mMisses;
+    mPrefetchedBytes += other.mPrefetchedBytes;
+    mWastedBytes += other.mWastedBytes;
+    mStalls += other.mStalls;
+    mGrows += other.mGrows;
+    mShrinks += other.mShrinks;
+  }
 };
 
 
@@ -127,7 +164,30 @@ class XrdIo : public FileIo
 {
   friend class AsyncIoOpenHandler;
 public:
-  static const uint32_t sNumRdAheadBlocks; ///< no. of blocks used for readahead
+  static const uint32_t sMinRdAheadBlocks; ///< min no. of blocks in flight
+  static uint32_t sMaxRdAheadBlocks; ///< max no. of blocks in flight
+
+  //----------------------------------------------------------------------------
+  //! Get the readahead counters aggregated over all closed files and the
+  //! state of the shared block pool
+  //!
+  //! @param stats aggregated counters
+  //! @param pool_blocks number of idle blocks in the pool
+  //! @param pool_bytes memory held by the idle blocks in the pool
+  //----------------------------------------------------------------------------
+  static void GetReadaheadStats(ReadaheadStats& stats, uint64_t& pool_blocks,
+                                uint64_t& pool_bytes);
+
+  //----------------------------------------------------------------------------
+  //! Bound a number of readahead blocks in flight so that they fit in the
+  //! shared block pool, at least sMinRdAheadBlocks are always allowed
+  //!
+  //! @param nblocks requested number of blocks
+  //! @param blocksize size of the blocks
+  //!
+  //! @return number of blocks to use
+  //----------------------------------------------------------------------------
+  static uint32_t ClampRdAheadBlocks(unsigned long nblocks, uint64_t blocksize);
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -478,13 +538,40 @@ public:
   virtual int ftsClose(FileIo::FtsHandle* fts_handle);
 
 private:
+  //! Access pattern detected by the readahead
+  enum RaPattern {
+    kRaRandom = 0, kRaSequential, kRaStrided, kRaBackward
+  };
+
   bool mDoReadahead; ///< mark if readahead is enabled
   uint32_t mBlocksize; ///< block size for rd/wr opertations
   XrdCl::File* mXrdFile; ///< handler to xrd file
   AsyncMetaHandler* mMetaHandler; ///< async requests meta handler
   PrefetchMap mMapBlocks; ///< map of block read/prefetched
-  std::queue<ReadaheadBlock*> mQueueBlocks; ///< queue containing available blocks
   XrdSysMutex mPrefetchMutex; ///< mutex to serialise the prefetch step
+  RaPattern mRaPattern; ///< current access pattern
+  int64_t mRaLastOffset; ///< offset of the previous read request, -1 if none
+  int64_t mRaLastEnd; ///< end offset of the previous read request
+  int64_t mRaStride; ///< distance between the last two read requests
+  uint32_t mRaStrideHits; ///< no. of consecutive requests with the same stride
+  int64_t mRaNextOffset; ///< offset of the next block to prefetch
+  int64_t mRaEofOffset; ///< end of file seen by a short response, -1 if none
+  uint32_t mRaWindow; ///< current no. of blocks kept in flight
+  uint32_t mRaMaxWindow; ///< max no. of blocks kept in flight for this file
+  uint32_t mRaCalmHits; ///< no. of consecutive hits without waiting
+  long long mRaLatencyNs; ///< smoothed latency of a prefetch request
+  long long mRaIntervalNs; ///< smoothed time between two consumed blocks
+  struct timespec mRaLastConsumed; ///< time when the last block was consumed
+  ReadaheadStats mRaStats; ///< readahead counters of this file
+
+  // Readahead blocks are shared between all files through a pool, organized
+  // by block size, which keeps idle blocks up to a maximum amount of memory
+  static XrdSysMutex sBlockPoolMutex; ///< mutex protecting the pool
+  ///< Idle blocks by block size
+  static std::map<uint64_t, std::list<ReadaheadBlock*> > sBlockPool;
+  static uint64_t sBlockPoolBytes; ///< memory held by idle blocks
+  static uint64_t sBlockPoolMaxBytes; ///< max memory held by idle blocks
+  static ReadaheadStats sRaStats; ///< counters aggregated over closed files
   eos::common::FileMap mFileMap; ///< extended attribute file map
   std::string mAttrUrl; ///< extended attribute url
   std::string mOpaque; ///< opaque tags in original url
@@ -519,9 +606,9 @@ private:
   void DumpConnectionPool();
 
   //----------------------------------------------------------------------------
-  //! Method used to prefetch the next block using the readahead mechanism
+  //! Method used to prefetch a block using the readahead mechanism
   //!
-  //! @param offset begin offset of the current block we are reading
+  //! @param offset begin offset of the block
   //! @param isWrite true if block is for write, false otherwise
   //! @param timeout timeout value
   //!
@@ -529,6 +616,75 @@ private:
   //----------------------------------------------------------------------------
   bool PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout = 0);
 
+  //----------------------------------------------------------------------------
+  //! Send prefetch requests following the detected access pattern until the
+  //! readahead window is full
+  //!
+  //! @param timeout timeout value
+  //!
+  //! @return false if a prefetch request could not be sent, otherwise true
+  //----------------------------------------------------------------------------
+  bool PrefetchWindow(uint16_t timeout = 0);
+
+  //----------------------------------------------------------------------------
+  //! Update the detected access pattern with a new read request
+  //!
+  //! @param offset request offset
+  //! @param length request length
+  //----------------------------------------------------------------------------
+  void UpdateReadPattern(int64_t offset, int64_t length);
+
+  //----------------------------------------------------------------------------
+  //! Get the distance between two consecutive prefetched blocks for the
+  //! current access pattern
+  //----------------------------------------------------------------------------
+  int64_t GetReadaheadStep() const;
+
+  //----------------------------------------------------------------------------
+  //! Adapt the readahead window after consuming a prefetched block. The window
+  //! follows the number of blocks the reader consumes during the latency of a
+  //! prefetch request and is enlarged whenever the reader had to wait.
+  //!
+  //! @param stalled true if the reader had to wait for the block
+  //----------------------------------------------------------------------------
+  void AdaptWindow(bool stalled);
+
+  //----------------------------------------------------------------------------
+  //! Halve the readahead window e.g. when prefetched blocks are wasted
+  //----------------------------------------------------------------------------
+  void ShrinkWindow();
+
+  //----------------------------------------------------------------------------
+  //! Remove a block from the map of prefetched blocks and give it back to the
+  //! pool, waiting first for any response still in flight
+  //!
+  //! @param iter block to be recycled
+  //!
+  //! @return false if the block was never read, otherwise true
+  //----------------------------------------------------------------------------
+  bool RecycleBlock(PrefetchMap::iterator iter);
+
+  //----------------------------------------------------------------------------
+  //! Recycle all prefetched blocks and account them in the global counters
+  //!
+  //! @return false if any of the in-flight requests failed, otherwise true
+  //----------------------------------------------------------------------------
+  bool DropAllBlocks();
+
+  //----------------------------------------------------------------------------
+  //! Get a block from the shared pool or allocate a new one
+  //!
+  //! @param blocksize size of the block
+  //----------------------------------------------------------------------------
+  static ReadaheadBlock* GetPoolBlock(uint64_t blocksize);
+
+  //----------------------------------------------------------------------------
+  //! Give a block without any request in flight back to the shared pool
+  //!
+  //! @param block block to be recycled
+  //----------------------------------------------------------------------------
+  static void PutPoolBlock(ReadaheadBlock* block);
+
   //----------------------------------------------------------------------------
   //! Try to find a block in cache with contains the provided offset
   //!
@@ -229,6 +229,7 @@ ReplicaParLayout::Open(XrdSfsFileOpenMode flags, mode_t mode,
           // Mask some opaque parameters to shorten the logging
           eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
           eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+          eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
           eos::common::StringConversion::MaskTag(maskUrl, "authz");
           FileIo* file = FileIoPlugin::GetIoObject(mReplicaUrl[i].c_str(), mOfsFile,
                          mSecEntity);
@@ -293,6 +294,7 @@ ReplicaParLayout::Read(XrdSfsFileOffset offset, char* buffer,
       // mask some opaque parameters to shorten the logging
       eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
       eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+      eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
       eos::common::StringConversion::MaskTag(maskUrl, "authz");
       eos_warning("Failed to read from replica off=%lld, lenght=%i, mask_url=%s",
                   offset, length, maskUrl.c_str());
@@ -330,6 +332,7 @@ ReplicaParLayout::ReadV(XrdCl::ChunkList& chunkList, uint32_t len)
       // Mask some opaque parameters to shorten the logging
       eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
       eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+      eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
       eos::common::StringConversion::MaskTag(maskUrl, "authz");
       eos_warning("Failed to readv from replica -%s", maskUrl.c_str());
       continue;
@@ -366,6 +369,7 @@ ReplicaParLayout::Write(XrdSfsFileOffset offset,
       // mask some opaque parameters to shorten the logging
       eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
       eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+      eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
       eos::common::StringConversion::MaskTag(maskUrl, "authz");
 
       if (i != 0) {
@@ -410,6 +414,7 @@ ReplicaParLayout::Truncate(XrdSfsFileOffset offset)
       // mask some opaque parameters to shorten the logging
       eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
       eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+      eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
       eos::common::StringConversion::MaskTag(maskUrl, "authz");
       eos_err("Failed to truncate replica %i", i);
       return gOFS.Emsg("ReplicaParTuncate", *mError, errno, "truncate failed",
@@ -455,6 +460,7 @@ ReplicaParLayout::Sync()
     // mask some opaque parameters to shorten the logging
     eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
     eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+    eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
     eos::common::StringConversion::MaskTag(maskUrl, "authz");
     rc = mReplicaFile[i]->fileSync(mTimeout);
 
@@ -490,6 +496,7 @@ ReplicaParLayout::Remove()
       // mask some opaque parameters to shorten the logging
       eos::common::StringConversion::MaskTag(maskUrl, "cap.sym");
       eos::common::StringConversion::MaskTag(maskUrl, "cap.msg");
+      eos::common::StringConversion::MaskTag(maskUrl, "cap.mac");
       eos::common::StringConversion::MaskTag(maskUrl, "authz");
       got_error = true;
 
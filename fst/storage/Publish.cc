@@ -24,12 +24,151 @@
 /*----------------------------------------------------------------------------*/
 #include "fst/storage/Storage.hh"
 #include "fst/XrdFstOfs.hh"
+#include "fst/io/xrd/XrdIo.hh"
 #include "common/LinuxStat.hh"
-#include "common/ShellCmd.hh"
+#include "common/LinuxSysStat.hh"
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
 
+/*----------------------------------------------------------------------------*/
+//! Cache of the values broadcasted by the previous publishing cycle. Values
+//! which did not change are not put into the mux transaction again unless a
+//! full refresh was requested for the current cycle.
+/*----------------------------------------------------------------------------*/
+class PublishCache
+{
+public:
+  PublishCache(): mForce(true) { }
+
+  //----------------------------------------------------------------------------
+  //! Start a new publishing cycle
+  //!
+  //! @param force if true all values are broadcasted in this cycle
+  //----------------------------------------------------------------------------
+  void
+  NewCycle(bool force)
+  {
+    mForce = force;
+    mPublished.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! End a publishing cycle, the values of the subjects not published in it
+  //! belong to filesystems which were removed and are dropped so that a
+  //! filesystem registered again under the same queue is fully broadcasted
+  //----------------------------------------------------------------------------
+  void
+  EndCycle()
+  {
+    for (auto it = mValues.begin(); it != mValues.end();) {
+      if (mPublished.count(it->first)) {
+        ++it;
+      } else {
+        it = mValues.erase(it);
+      }
+    }
+  }
+
+  bool
+  SetString(eos::common::FileSystem* fs, const char* key,
+            const std::string& value)
+  {
+    if (!Changed(fs->GetQueuePath(), key, value)) {
+      return true;
+    }
+
+    return Commit(fs->GetQueuePath(), key, value,
+                  fs->SetString(key, value.c_str()));
+  }
+
+  bool
+  SetLongLong(eos::common::FileSystem* fs, const char* key, long long value)
+  {
+    return SetString(fs, key, Format(value));
+  }
+
+  bool
+  SetDouble(eos::common::FileSystem* fs, const char* key, double value)
+  {
+    return SetString(fs, key, Format(value));
+  }
+
+  bool
+  SetString(XrdMqSharedHash* hash, const char* key, const std::string& value)
+  {
+    if (!Changed(hash->GetSubject(), key, value)) {
+      return true;
+    }
+
+    return Commit(hash->GetSubject(), key, value, hash->Set(key, value.c_str()));
+  }
+
+  bool
+  SetLongLong(XrdMqSharedHash* hash, const char* key, long long value)
+  {
+    return SetString(hash, key, Format(value));
+  }
+
+  bool
+  SetDouble(XrdMqSharedHash* hash, const char* key, double value)
+  {
+    return SetString(hash, key, Format(value));
+  }
+
+private:
+  bool mForce;
+  //! map subject => key => last published value
+  std::map<std::string, std::map<std::string, std::string> > mValues;
+  //! subjects published in the current cycle
+  std::set<std::string> mPublished;
+
+  bool
+  Changed(const std::string& subject, const char* key, const std::string& value)
+  {
+    mPublished.insert(subject);
+
+    if (mForce) {
+      return true;
+    }
+
+    std::map<std::string, std::string>& values = mValues[subject];
+    std::map<std::string, std::string>::const_iterator it = values.find(key);
+    return ((it == values.end()) || (it->second != value));
+  }
+
+  bool
+  Commit(const std::string& subject, const char* key, const std::string& value,
+         bool success)
+  {
+    if (success) {
+      mValues[subject][key] = value;
+    } else {
+      // make sure we retry in the next cycle
+      mValues[subject].erase(key);
+    }
+
+    return success;
+  }
+
+  // the same formatting as used by XrdMqSharedHash::SetLongLong/SetDouble
+  static std::string
+  Format(long long value)
+  {
+    char convert[1024];
+    snprintf(convert, sizeof(convert) - 1, "%lld", value);
+    return convert;
+  }
+
+  static std::string
+  Format(double value)
+  {
+    char convert[1024];
+    snprintf(convert, sizeof(convert) - 1, "%f", value);
+    return convert;
+  }
+};
+
 /*----------------------------------------------------------------------------*/
 void
 Storage::Publish()
@@ -39,35 +178,22 @@ Storage::Publish()
   struct timezone tz;
   unsigned long long netspeed = 1000000000;
   // ---------------------------------------------------------------------
-  // get our network speed
+  // get our network speed from the device carrying the default route
   // ---------------------------------------------------------------------
-  char* tmpname = tmpnam(NULL);
-  XrdOucString getnetspeed =
-    "ip route list | sed -ne '/^default/s/.*dev //p' | xargs ethtool | grep Speed | cut -d ':' -f2 | cut -d 'M' -f1 >> ";
-  getnetspeed += tmpname;
-  eos::common::ShellCmd scmd1(getnetspeed.c_str());
-  eos::common::cmd_status rc = scmd1.wait(5);
-
-  if (rc.exit_code) {
-    eos_static_err("ip route list call failed to get netspeed");
+  std::string route_dev;
+
+  if (!eos::common::LinuxSysStat::GetDefaultRouteDevice(route_dev) ||
+      !eos::common::LinuxSysStat::GetNetSpeed(route_dev, netspeed)) {
+    eos_static_err("failed to get netspeed of default route device '%s'",
+                   route_dev.c_str());
+  } else {
+    eos_static_info("sysfs:networkspeed=%.02f GB/s",
+                    1.0 * netspeed / 1000000000.0);
   }
 
   XrdOucString lNodeGeoTag = (getenv("EOS_GEOTAG") ? getenv("EOS_GEOTAG") : "");
   XrdOucString lEthernetDev = (getenv("EOS_FST_NETWORK_INTERFACE") ?
                                getenv("EOS_FST_NETWORK_INTERFACE") : "eth0");
-  FILE* fnetspeed = fopen(tmpname, "r");
-
-  if (fnetspeed) {
-    if ((fscanf(fnetspeed, "%llu", &netspeed)) == 1) {
-      // we get MB as a number => convert into bytes
-      netspeed *= 1000000;
-      eos_static_info("ethtool:networkspeed=%.02f GB/s",
-                      1.0 * netspeed / 1000000000.0);
-    }
-
-    fclose(fnetspeed);
-  }
-
   eos_static_info("publishing:networkspeed=%.02f GB/s",
                   1.0 * netspeed / 1000000000.0);
   // ---------------------------------------------------------------------
@@ -85,32 +211,17 @@ Storage::Publish()
   eos::common::FileSystem::fsid_t fsid = 0;
   std::string publish_uptime = "";
   std::string publish_sockets = "";
+  PublishCache publishCache;
+  time_t next_full_publish = 0;
 
   while (1) {
     {
       // ---------------------------------------------------------------------
-      // retrieve uptime information
+      // uptime and socket information measured by the load thread
       // ---------------------------------------------------------------------
-      XrdOucString uptime = "uptime | tr -d \"\n\" > ";
-      uptime += tmpname;
-      eos::common::ShellCmd scmd2(uptime.c_str());
-      rc = scmd2.wait(5);
-
-      if (rc.exit_code) {
-        eos_static_err("retrieve uptime call failed");
-      }
-
-      eos::common::StringConversion::LoadFileIntoString(tmpname, publish_uptime);
-      XrdOucString sockets = "cat /proc/net/tcp | wc -l | tr -d \"\n\" >";
-      sockets += tmpname;
-      eos::common::ShellCmd scmd3(sockets.c_str());
-      rc = scmd3.wait(5);
-
-      if (rc.exit_code) {
-        eos_static_err("retrieve #socket call failed");
-      }
-
-      eos::common::StringConversion::LoadFileIntoString(tmpname, publish_sockets);
+      unsigned long long nsockets = 0;
+      fstLoad.GetNodeStat(publish_uptime, nsockets);
+      publish_sockets = std::to_string(nsockets);
     }
     time_t now = time(NULL);
     gettimeofday(&tv1, &tz);
@@ -142,6 +253,14 @@ Storage::Publish()
       static time_t last_consistency_stats = 0;
       static time_t next_consistency_stats = 0;
 
+      // broadcast unchanged values only once per minute
+      if (next_full_publish <= now) {
+        publishCache.NewCycle(true);
+        next_full_publish = now + 60;
+      } else {
+        publishCache.NewCycle(false);
+      }
+
       if (!gOFS.ObjectManager.OpenMuxTransaction()) {
         eos_static_err("cannot open mux transaction");
       } else {
@@ -234,7 +353,7 @@ Storage::Publish()
                 //eos_static_debug("%-24s => %lu", isit->first.c_str(), isit->second);
                 std::string sname = "stat.fsck.";
                 sname += isit->first;
-                success &= fileSystemsVector[i]->SetLongLong(sname.c_str(), isit->second);
+                success &= publishCache.SetLongLong(fileSystemsVector[i], sname.c_str(), isit->second);
               }
             }
           }
@@ -250,11 +369,11 @@ Storage::Publish()
           }
 
           // copy out net info
-          success &= fileSystemsVector[i]->SetDouble("stat.net.ethratemib",
+          success &= publishCache.SetDouble(fileSystemsVector[i], "stat.net.ethratemib",
                      netspeed / (8 * 1024 * 1024));
-          success &= fileSystemsVector[i]->SetDouble("stat.net.inratemib",
+          success &= publishCache.SetDouble(fileSystemsVector[i], "stat.net.inratemib",
                      fstLoad.GetNetRate(lEthernetDev.c_str(), "rxbytes") / 1024.0 / 1024.0);
-          success &= fileSystemsVector[i]->SetDouble("stat.net.outratemib",
+          success &= publishCache.SetDouble(fileSystemsVector[i], "stat.net.outratemib",
                      fstLoad.GetNetRate(lEthernetDev.c_str(), "txbytes") / 1024.0 / 1024.0);
 
           // set current load stats, io-target specific implementation may override fst load implementation
@@ -275,24 +394,28 @@ Storage::Publish()
               writeratemb = fstLoad.GetDiskRate(fileSystemsVector[i]->GetPath().c_str(), "writeSectors") * 512.0 / 1000000.0;
               diskload = fstLoad.GetDiskRate(fileSystemsVector[i]->GetPath().c_str(), "millisIO") / 1000.0;
             }
-            success &= fileSystemsVector[i]->SetDouble("stat.disk.readratemb", readratemb);
-            success &= fileSystemsVector[i]->SetDouble("stat.disk.writeratemb", writeratemb);
-            success &= fileSystemsVector[i]->SetDouble("stat.disk.load", diskload);
+            success &= publishCache.SetDouble(fileSystemsVector[i], "stat.disk.readratemb", readratemb);
+            success &= publishCache.SetDouble(fileSystemsVector[i], "stat.disk.writeratemb", writeratemb);
+            success &= publishCache.SetDouble(fileSystemsVector[i], "stat.disk.load", diskload);
           }
 
           // set current health stats
           {
             std::map<std::string, std::string> health;
 
-            // file system implementation may override standard implementation.
+            // file system implementation may override standard implementation,
+            // the standard one only reads from the health cache
             if (!fileSystemsVector[i]->getHealth(health)) {
               health = fstHealth.getDiskHealth(fileSystemsVector[i]->GetPath().c_str());
             }
-            success &= fileSystemsVector[i]->SetString("stat.health", health["summary"].c_str());
-            success &= fileSystemsVector[i]->SetLongLong("stat.health.indicator", strtoll(health["indicator"].c_str(), 0, 10));
-            success &= fileSystemsVector[i]->SetLongLong("stat.health.drives_total", strtoll(health["drives_total"].c_str(), 0, 10));
-            success &= fileSystemsVector[i]->SetLongLong("stat.health.drives_failed", strtoll(health["drives_failed"].c_str(), 0, 10));
-            success &= fileSystemsVector[i]->SetLongLong("stat.health.redundancy_factor",  strtoll(health["redundancy_factor"].c_str(), 0, 10));
+            success &= publishCache.SetString(fileSystemsVector[i], "stat.health", health["summary"].c_str());
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.indicator", strtoll(health["indicator"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.drives_total", strtoll(health["drives_total"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.drives_failed", strtoll(health["drives_failed"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.redundancy_factor",  strtoll(health["redundancy_factor"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.temperature", strtoll(health["temperature"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.reallocated_sectors", strtoll(health["reallocated_sectors"].c_str(), 0, 10));
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.health.pending_sectors", strtoll(health["pending_sectors"].c_str(), 0, 10));
           }
 
           long long r_open = 0;
@@ -302,47 +425,47 @@ Storage::Publish()
             r_open = (long long) gOFS.ROpenFid[fsid].size();
             w_open = (long long) gOFS.WOpenFid[fsid].size();
           }
-          success &= fileSystemsVector[i]->SetLongLong("stat.ropen", r_open);
-          success &= fileSystemsVector[i]->SetLongLong("stat.wopen", w_open);
-          success &= fileSystemsVector[i]->SetLongLong("stat.statfs.freebytes",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.ropen", r_open);
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.wopen", w_open);
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.statfs.freebytes",
                      fileSystemsVector[i]->GetLongLong("stat.statfs.bfree") *
                      fileSystemsVector[i]->GetLongLong("stat.statfs.bsize"));
-          success &= fileSystemsVector[i]->SetLongLong("stat.statfs.usedbytes",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.statfs.usedbytes",
                      (fileSystemsVector[i]->GetLongLong("stat.statfs.blocks") -
                       fileSystemsVector[i]->GetLongLong("stat.statfs.bfree")) *
                      fileSystemsVector[i]->GetLongLong("stat.statfs.bsize"));
-          success &= fileSystemsVector[i]->SetDouble("stat.statfs.filled",
+          success &= publishCache.SetDouble(fileSystemsVector[i], "stat.statfs.filled",
                      100.0 * ((fileSystemsVector[i]->GetLongLong("stat.statfs.blocks") -
                                fileSystemsVector[i]->GetLongLong("stat.statfs.bfree"))) /
                      (1 + fileSystemsVector[i]->GetLongLong("stat.statfs.blocks")));
-          success &= fileSystemsVector[i]->SetLongLong("stat.statfs.capacity",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.statfs.capacity",
                      fileSystemsVector[i]->GetLongLong("stat.statfs.blocks") *
                      fileSystemsVector[i]->GetLongLong("stat.statfs.bsize"));
-          success &= fileSystemsVector[i]->SetLongLong("stat.statfs.fused",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.statfs.fused",
                      (fileSystemsVector[i]->GetLongLong("stat.statfs.files") -
                       fileSystemsVector[i]->GetLongLong("stat.statfs.ffree")) *
                      fileSystemsVector[i]->GetLongLong("stat.statfs.bsize"));
           {
             eos::common::RWMutexReadLock lock(gFmdDbMapHandler.Mutex);
-            success &= fileSystemsVector[i]->SetLongLong("stat.usedfiles",
+            success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.usedfiles",
                        (long long)(gFmdDbMapHandler.dbmap.count(fsid) ?
                                    gFmdDbMapHandler.dbmap[fsid]->size() : 0));
           }
-          success &= fileSystemsVector[i]->SetString("stat.boot",
+          success &= publishCache.SetString(fileSystemsVector[i], "stat.boot",
                      fileSystemsVector[i]->GetStatusAsString(fileSystemsVector[i]->GetStatus()));
-          success &= fileSystemsVector[i]->SetString("stat.geotag", lNodeGeoTag.c_str());
+          success &= publishCache.SetString(fileSystemsVector[i], "stat.geotag", lNodeGeoTag.c_str());
           struct timeval tvfs;
           gettimeofday(&tvfs, &tz);
           size_t nowms = tvfs.tv_sec * 1000 + tvfs.tv_usec / 1000;
-          success &= fileSystemsVector[i]->SetLongLong("stat.publishtimestamp", nowms);
-          success &= fileSystemsVector[i]->SetLongLong("stat.drainer.running",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.publishtimestamp", nowms);
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.drainer.running",
                      fileSystemsVector[i]->GetDrainQueue()->GetRunningAndQueued());
-          success &= fileSystemsVector[i]->SetLongLong("stat.balancer.running",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.balancer.running",
                      fileSystemsVector[i]->GetBalanceQueue()->GetRunningAndQueued());
           // copy out IOPS + bandwidth measurement
-          success &= fileSystemsVector[i]->SetLongLong("stat.disk.iops",
+          success &= publishCache.SetLongLong(fileSystemsVector[i], "stat.disk.iops",
                      fileSystemsVector[i]->getIOPS());
-          success &= fileSystemsVector[i]->SetDouble("stat.disk.bw",
+          success &= publishCache.SetDouble(fileSystemsVector[i], "stat.disk.bw",
                      fileSystemsVector[i]->getSeqBandwidth()); // in MB
           {
             // we have to set something which is not empty to update the value
@@ -355,9 +478,9 @@ Storage::Publish()
             }
 
             // copy out hot file list
-            success &= fileSystemsVector[i]->SetString("stat.ropen.hotfiles",
+            success &= publishCache.SetString(fileSystemsVector[i], "stat.ropen.hotfiles",
                        r_open_hotfiles.c_str());
-            success &= fileSystemsVector[i]->SetString("stat.wopen.hotfiles",
+            success &= publishCache.SetString(fileSystemsVector[i], "stat.wopen.hotfiles",
                        w_open_hotfiles.c_str());
           }
           {
@@ -398,38 +521,53 @@ Storage::Publish()
                                     Config::gConfig.FstNodeConfigQueue.c_str(), "hash");
 
           if (hash) {
-            hash->Set("stat.sys.kernel", eos::fst::Config::gConfig.KernelVersion.c_str());
-            hash->SetLongLong("stat.sys.vsize", osstat.vsize);
-            hash->SetLongLong("stat.sys.rss", osstat.rss);
-            hash->SetLongLong("stat.sys.threads", osstat.threads);
+            publishCache.SetString(hash, "stat.sys.kernel", eos::fst::Config::gConfig.KernelVersion.c_str());
+            publishCache.SetLongLong(hash, "stat.sys.vsize", osstat.vsize);
+            publishCache.SetLongLong(hash, "stat.sys.rss", osstat.rss);
+            publishCache.SetLongLong(hash, "stat.sys.threads", osstat.threads);
             {
               XrdOucString v=VERSION; v+="-"; v+=RELEASE;
-              hash->Set("stat.sys.eos.version", v.c_str());
+              publishCache.SetString(hash, "stat.sys.eos.version", v.c_str());
+            }
+            publishCache.SetString(hash, "stat.sys.keytab", eos::fst::Config::gConfig.KeyTabAdler.c_str());
+            publishCache.SetString(hash, "stat.sys.uptime", publish_uptime.c_str());
+            publishCache.SetString(hash, "stat.sys.sockets", publish_sockets.c_str());
+            publishCache.SetString(hash, "stat.sys.eos.start", eos::fst::Config::gConfig.StartDate.c_str());
+            publishCache.SetString(hash, "stat.geotag", lNodeGeoTag.c_str());
+            {
+              // readahead of the files read through XrdIo (e.g. by RAIN layouts)
+              ReadaheadStats ra_stats;
+              uint64_t ra_pool_blocks = 0;
+              uint64_t ra_pool_bytes = 0;
+              XrdIo::GetReadaheadStats(ra_stats, ra_pool_blocks, ra_pool_bytes);
+              publishCache.SetLongLong(hash, "stat.ra.hits", ra_stats.mHits);
+              publishCache.SetLongLong(hash, "stat.ra.misses", ra_stats.mMisses);
+              publishCache.SetLongLong(hash, "stat.ra.prefetched", ra_stats.mPrefetchedBytes);
+              publishCache.SetLongLong(hash, "stat.ra.wasted", ra_stats.mWastedBytes);
+              publishCache.SetLongLong(hash, "stat.ra.stalls", ra_stats.mStalls);
+              publishCache.SetLongLong(hash, "stat.ra.pool.blocks", ra_pool_blocks);
+              publishCache.SetLongLong(hash, "stat.ra.pool.bytes", ra_pool_bytes);
             }
-            hash->Set("stat.sys.keytab", eos::fst::Config::gConfig.KeyTabAdler.c_str());
-            hash->Set("stat.sys.uptime", publish_uptime.c_str());
-            hash->Set("stat.sys.sockets", publish_sockets.c_str());
-            hash->Set("stat.sys.eos.start", eos::fst::Config::gConfig.StartDate.c_str());
-            hash->Set("stat.geotag", lNodeGeoTag.c_str());
-            hash->Set("debug.state",
+            publishCache.SetString(hash, "debug.state",
                       LC_STRING(eos::common::Logging::GetPriorityString(
                                   eos::common::Logging::gPriorityLevel)));
             // copy out net info
-            hash->SetDouble("stat.net.ethratemib", netspeed / (8 * 1024 * 1024));
-            hash->SetDouble("stat.net.inratemib", fstLoad.GetNetRate(lEthernetDev.c_str(),
+            publishCache.SetDouble(hash, "stat.net.ethratemib", netspeed / (8 * 1024 * 1024));
+            publishCache.SetDouble(hash, "stat.net.inratemib", fstLoad.GetNetRate(lEthernetDev.c_str(),
                             "rxbytes") / 1024.0 / 1024.0);
-            hash->SetDouble("stat.net.outratemib", fstLoad.GetNetRate(lEthernetDev.c_str(),
+            publishCache.SetDouble(hash, "stat.net.outratemib", fstLoad.GetNetRate(lEthernetDev.c_str(),
                             "txbytes") / 1024.0 / 1024.0);
             struct timeval tvfs;
             gettimeofday(&tvfs, &tz);
             size_t nowms = tvfs.tv_sec * 1000 + tvfs.tv_usec / 1000;
-            hash->SetLongLong("stat.publishtimestamp", nowms);
+            publishCache.SetLongLong(hash, "stat.publishtimestamp", nowms);
           }
 
           gOFS.ObjectManager.HashMutex.UnLockRead();
         }
 
         gOFS.ObjectManager.CloseMuxTransaction();
+        publishCache.EndCycle();
         next_consistency_stats = last_consistency_stats +
                                  60; // report the consistency only once per minute
       }
@@ -0,0 +1,252 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumEngineTest.cc
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "ChecksumEngineTest.hh"
+#include "fst/checksum/ChecksumEngine.hh"
+#include "fst/checksum/Adler.hh"
+#include "fst/checksum/CRC32.hh"
+#include "fst/checksum/CRC32C.hh"
+#include "fst/checksum/MD5.hh"
+#include "fst/checksum/SHA1.hh"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChecksumEngineTest);
+
+using eos::fst::CheckSum;
+using eos::fst::ChecksumEngine;
+
+//------------------------------------------------------------------------------
+// Create a checksum object of the given algorithm
+//------------------------------------------------------------------------------
+static CheckSum*
+NewChecksum(int algorithm)
+{
+  switch (algorithm) {
+  case 0:
+    return new eos::fst::Adler();
+
+  case 1:
+    return new eos::fst::CRC32();
+
+  case 2:
+    return new eos::fst::CRC32C();
+
+  case 3:
+    return new eos::fst::MD5();
+
+  default:
+    return new eos::fst::SHA1();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Random test data
+//------------------------------------------------------------------------------
+static std::vector<char>
+RandomData(size_t length)
+{
+  std::vector<char> data(length);
+  srandom(length);
+
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = random() % 256;
+  }
+
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Hex checksum of data computed with a checksum object in one go
+//------------------------------------------------------------------------------
+static std::string
+Reference(int algorithm, const char* data, size_t length)
+{
+  std::unique_ptr<CheckSum> xs(NewChecksum(algorithm));
+  xs->Add(data, length, 0);
+  xs->Finalize();
+  return xs->GetHexChecksum();
+}
+
+//------------------------------------------------------------------------------
+// CPPUNIT setUp method
+//------------------------------------------------------------------------------
+void ChecksumEngineTest::setUp(void)
+{
+  char dir[] = "/tmp/eos-xs-engine-test-XXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(dir));
+  mDir = dir;
+}
+
+//------------------------------------------------------------------------------
+// CPPUNIT tearDown method
+//------------------------------------------------------------------------------
+void ChecksumEngineTest::tearDown(void)
+{
+  std::string cmd = "rm -rf " + mDir;
+  system(cmd.c_str());
+}
+
+//------------------------------------------------------------------------------
+// Combine the checksums of consecutive pieces of data
+//------------------------------------------------------------------------------
+void ChecksumEngineTest::CombineTest()
+{
+  std::vector<char> data = RandomData(1000003);
+  ChecksumEngine::Kind kinds[] = {ChecksumEngine::kAdler, ChecksumEngine::kCRC32,
+                                  ChecksumEngine::kCRC32C
+                                 };
+
+  for (int algorithm = 0; algorithm < 3; ++algorithm) {
+    ChecksumEngine::Kind kind = kinds[algorithm];
+    CPPUNIT_ASSERT(ChecksumEngine::IsCombinable(kind));
+    size_t split[] = {0, 1, 4096, 777777, data.size()};
+
+    for (size_t i = 0; i < sizeof(split) / sizeof(split[0]); ++i) {
+      ChecksumEngine::Digest first(kind);
+      ChecksumEngine::Digest second(kind);
+      uint32_t cks1, cks2;
+      first.Update(&data[0], split[i]);
+      first.Final((char*) &cks1);
+      second.Update(&data[split[i]], data.size() - split[i]);
+      second.Final((char*) &cks2);
+      uint32_t combined = ChecksumEngine::Combine(kind, cks1, cks2,
+                          data.size() - split[i]);
+      std::unique_ptr<CheckSum> xs(NewChecksum(algorithm));
+      xs->Add(&data[0], data.size(), 0);
+      xs->Finalize();
+      int len = 0;
+      CPPUNIT_ASSERT(!memcmp(&combined, xs->GetBinChecksum(len), sizeof(combined)));
+    }
+  }
+
+  CPPUNIT_ASSERT(!ChecksumEngine::IsCombinable(ChecksumEngine::kMD5));
+  CPPUNIT_ASSERT(!ChecksumEngine::IsCombinable(ChecksumEngine::kSHA1));
+}
+
+//------------------------------------------------------------------------------
+// File and block checksums of buffers of any size and alignment
+//------------------------------------------------------------------------------
+void ChecksumEngineTest::SinglePassTest()
+{
+  size_t blocksize = 64 * 1024;
+  std::vector<char> data = RandomData(3 * 1024 * 1024 + 12345);
+  std::string map = mDir + "/single.xsmap";
+
+  for (int algorithm = 0; algorithm < 5; ++algorithm) {
+    // Block checksum map written by the classic code
+    std::unique_ptr<CheckSum> writer(NewChecksum(algorithm));
+    CPPUNIT_ASSERT(writer->OpenMap(map.c_str(), data.size(), blocksize, true));
+    CPPUNIT_ASSERT(writer->AddBlockSum(0, &data[0], data.size()));
+    CPPUNIT_ASSERT(writer->CloseMap());
+    std::unique_ptr<CheckSum> file_xs(NewChecksum(algorithm));
+    std::unique_ptr<CheckSum> block_xs(NewChecksum(algorithm));
+    CPPUNIT_ASSERT(block_xs->OpenMap(map.c_str(), data.size(), blocksize, false));
+    ChecksumEngine engine(file_xs.get(), block_xs.get());
+    // Pieces not aligned to the blocks
+    size_t pieces[] = {1, 70000, 1024 * 1024 + 3, 131072, 1500000};
+    off_t offset = 0;
+
+    for (size_t i = 0; offset < (off_t) data.size(); ++i) {
+      size_t len = std::min(pieces[i % 5], data.size() - offset);
+      engine.Check(&data[offset], len, offset);
+      offset += len;
+    }
+
+    file_xs->Finalize();
+    CPPUNIT_ASSERT(!engine.IsBlockCorrupted());
+    CPPUNIT_ASSERT_EQUAL(Reference(algorithm, &data[0], data.size()),
+                         std::string(file_xs->GetHexChecksum()));
+    // A modified block is detected
+    data[200000] ^= 1;
+    engine.Check(&data[0], data.size(), 0);
+    CPPUNIT_ASSERT(engine.IsBlockCorrupted());
+    data[200000] ^= 1;
+    block_xs->CloseMap();
+    unlink(map.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Scan a file with several threads and detect a corrupted block
+//------------------------------------------------------------------------------
+void ChecksumEngineTest::ParallelScanTest()
+{
+  size_t blocksize = 4096;
+  std::vector<char> data = RandomData(19 * 1024 * 1024 + 4321);
+  std::string path = mDir + "/parallel";
+  std::string map = path + ".xsmap";
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  CPPUNIT_ASSERT(fd >= 0);
+  CPPUNIT_ASSERT(pwrite(fd, &data[0], data.size(), 0) == (ssize_t) data.size());
+  ChecksumEngine::ReadFunc reader = [fd](off_t offset, char* buffer,
+  size_t length) {
+    return (int64_t) pread(fd, buffer, length, offset);
+  };
+
+  for (int algorithm = 0; algorithm < 5; ++algorithm) {
+    std::unique_ptr<CheckSum> writer(NewChecksum(algorithm));
+    CPPUNIT_ASSERT(writer->OpenMap(map.c_str(), data.size(), blocksize, true));
+    CPPUNIT_ASSERT(writer->AddBlockSum(0, &data[0], data.size()));
+    CPPUNIT_ASSERT(writer->CloseMap());
+    std::string reference = Reference(algorithm, &data[0], data.size());
+
+    for (int nthreads = 1; nthreads <= 8; nthreads *= 2) {
+      std::unique_ptr<CheckSum> file_xs(NewChecksum(algorithm));
+      std::unique_ptr<CheckSum> block_xs(NewChecksum(algorithm));
+      CPPUNIT_ASSERT(block_xs->OpenMap(map.c_str(), data.size(), blocksize, false));
+      ChecksumEngine engine(file_xs.get(), block_xs.get());
+      unsigned long long scansize = 0;
+      float scantime = 0;
+      CPPUNIT_ASSERT(engine.ScanFile(reader, data.size(), scansize, scantime, 0,
+                                     nthreads));
+      CPPUNIT_ASSERT_EQUAL((unsigned long long) data.size(), scansize);
+      CPPUNIT_ASSERT(!engine.IsBlockCorrupted());
+      // ScanDir finalizes the checksum again before comparing
+      file_xs->Finalize();
+      CPPUNIT_ASSERT_EQUAL(reference, std::string(file_xs->GetHexChecksum()));
+      block_xs->CloseMap();
+    }
+
+    // Corrupt a block in the second half of the file
+    char byte = data[15 * 1024 * 1024] ^ 1;
+    CPPUNIT_ASSERT(pwrite(fd, &byte, 1, 15 * 1024 * 1024) == 1);
+    std::unique_ptr<CheckSum> file_xs(NewChecksum(algorithm));
+    std::unique_ptr<CheckSum> block_xs(NewChecksum(algorithm));
+    CPPUNIT_ASSERT(block_xs->OpenMap(map.c_str(), data.size(), blocksize, false));
+    ChecksumEngine engine(file_xs.get(), block_xs.get());
+    unsigned long long scansize = 0;
+    float scantime = 0;
+    CPPUNIT_ASSERT(engine.ScanFile(reader, data.size(), scansize, scantime, 0, 4));
+    CPPUNIT_ASSERT(engine.IsBlockCorrupted());
+    CPPUNIT_ASSERT(reference != file_xs->GetHexChecksum());
+    block_xs->CloseMap();
+    CPPUNIT_ASSERT(pwrite(fd, &data[15 * 1024 * 1024], 1, 15 * 1024 * 1024) == 1);
+    unlink(map.c_str());
+  }
+
+  close(fd);
+}
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+//! @file ChecksumEngineTest.hh
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_TESTS_CHECKSUMENGINETEST__HH__
+#define __EOSFST_TESTS_CHECKSUMENGINETEST__HH__
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+//------------------------------------------------------------------------------
+//! Class ChecksumEngineTest - compares the checksums of the engine with the
+//! ones of the checksum objects
+//------------------------------------------------------------------------------
+class ChecksumEngineTest : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(ChecksumEngineTest);
+  CPPUNIT_TEST(CombineTest);
+  CPPUNIT_TEST(SinglePassTest);
+  CPPUNIT_TEST(ParallelScanTest);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::string mDir; ///< directory holding the test files
+
+public:
+  //----------------------------------------------------------------------------
+  //! CPPUNIT required methods
+  //----------------------------------------------------------------------------
+  void setUp(void);
+  void tearDown(void);
+
+  //----------------------------------------------------------------------------
+  //! Combine the checksums of consecutive pieces of data
+  //----------------------------------------------------------------------------
+  void CombineTest();
+
+  //----------------------------------------------------------------------------
+  //! File and block checksums of buffers of any size and alignment
+  //----------------------------------------------------------------------------
+  void SinglePassTest();
+
+  //----------------------------------------------------------------------------
+  //! Scan a file with several threads and detect a corrupted block
+  //----------------------------------------------------------------------------
+  void ParallelScanTest();
+};
+
+#endif // __EOSFST_TESTS_CHECKSUMENGINETEST__HH__
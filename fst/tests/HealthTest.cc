@@ -0,0 +1,307 @@
+//------------------------------------------------------------------------------
+//! @file HealthTest.cc
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "HealthTest.hh"
+#include "fst/Health.hh"
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HealthTest);
+
+//------------------------------------------------------------------------------
+// Recorded 'smartctl -a' output of a SATA drive (shortened)
+//------------------------------------------------------------------------------
+static const char* sSmartAta =
+  "smartctl 6.2 2013-07-26 r3841 [x86_64-linux-3.10.0] (local build)\n"
+  "=== START OF READ SMART DATA SECTION ===\n"
+  "SMART overall-health self-assessment test result: PASSED\n"
+  "\n"
+  "SMART Attributes Data Structure revision number: 10\n"
+  "Vendor Specific SMART Attributes with Thresholds:\n"
+  "ID# ATTRIBUTE_NAME          FLAG     VALUE WORST THRESH TYPE      UPDATED  WHEN_FAILED RAW_VALUE\n"
+  "  1 Raw_Read_Error_Rate     0x000b   100   100   016    Pre-fail  Always       -       0\n"
+  "  5 Reallocated_Sector_Ct   0x0033   100   100   005    Pre-fail  Always       -       3\n"
+  "  9 Power_On_Hours          0x0012   096   096   000    Old_age   Always       -       31450\n"
+  "194 Temperature_Celsius     0x0002   162   162   000    Old_age   Always       -       37 (Min/Max 18/45)\n"
+  "197 Current_Pending_Sector  0x0022   100   100   000    Old_age   Always       -       1\n"
+  "198 Offline_Uncorrectable   0x0008   100   100   000    Old_age   Offline      -       0\n"
+  "\n"
+  "SMART Error Log Version: 1\n"
+  "No Errors Logged\n";
+
+//------------------------------------------------------------------------------
+// Recorded 'smartctl -a' output of a SAS drive (shortened)
+//------------------------------------------------------------------------------
+static const char* sSmartSas =
+  "=== START OF READ SMART DATA SECTION ===\n"
+  "SMART Health Status: OK\n"
+  "\n"
+  "Current Drive Temperature:     31 C\n"
+  "Drive Trip Temperature:        60 C\n"
+  "Elements in grown defect list: 12\n"
+  "\n"
+  "  number of hours powered up = 20456.63\n"
+  "Accumulated power on time, hours:minutes 20456:38\n";
+
+//------------------------------------------------------------------------------
+// Recorded 'smartctl -a' output of a NVMe drive (shortened)
+//------------------------------------------------------------------------------
+static const char* sSmartNvme =
+  "=== START OF SMART DATA SECTION ===\n"
+  "SMART overall-health self-assessment test result: PASSED\n"
+  "\n"
+  "SMART/Health Information (NVMe Log 0x02, NSID 0xffffffff)\n"
+  "Critical Warning:                   0x00\n"
+  "Temperature:                        42 Celsius\n"
+  "Available Spare:                    100%\n"
+  "Power On Hours:                     1,234\n"
+  "Media and Data Integrity Errors:    0\n";
+
+//------------------------------------------------------------------------------
+// Recorded 'smartctl -a' output of a failing SATA drive (shortened)
+//------------------------------------------------------------------------------
+static const char* sSmartFailing =
+  "=== START OF READ SMART DATA SECTION ===\n"
+  "SMART overall-health self-assessment test result: FAILED!\n"
+  "Drive failure expected in less than 24 hours. SAVE ALL DATA.\n"
+  "ID# ATTRIBUTE_NAME          FLAG     VALUE WORST THRESH TYPE      UPDATED  WHEN_FAILED RAW_VALUE\n"
+  "  5 Reallocated_Sector_Ct   0x0033   001   001   005    Pre-fail  Always   FAILING_NOW 4032\n"
+  "190 Airflow_Temperature_Cel 0x0022   067   055   045    Old_age   Always       -       33\n"
+  "197 Current_Pending_Sector  0x0012   100   100   000    Old_age   Always       -       88\n";
+
+//------------------------------------------------------------------------------
+// Recorded /proc/mdstat with a rebuilding raid6
+//------------------------------------------------------------------------------
+static const char* sMdstat =
+  "Personalities : [raid6] [raid5] [raid4]\n"
+  "md0 : active raid6 sdl[11] sdk[10] sdj[9] sdi[8] sdh[7] sdg[6] sdf[5]\n"
+  "      19533829120 blocks super 1.2 level 6, 512k chunk, algorithm 2 [7/6] [UUUUUU_]\n"
+  "      [==>..................]  recovery = 12.6% (492183040/3906765824) finish=305.4min speed=186300K/sec\n"
+  "\n"
+  "unused devices: <none>\n";
+
+//------------------------------------------------------------------------------
+// Fake smartctl serving the recordings, 'sdd' hangs until released
+//------------------------------------------------------------------------------
+static std::mutex sProbeMutex;
+static std::map<std::string, int> sProbeCount;
+static std::atomic<bool> sRelease(false);
+
+static int
+FakeSmartctl(const std::string& device, std::string& output)
+{
+  {
+    std::lock_guard<std::mutex> lock(sProbeMutex);
+    sProbeCount[device]++;
+  }
+
+  if (device == "sda") {
+    output = sSmartAta;
+    return 0;
+  } else if (device == "sdb") {
+    output = sSmartSas;
+    return 0;
+  } else if (device == "sdc") {
+    output = sSmartFailing;
+    return 8 | 32;
+  } else if (device == "nvme0n1") {
+    output = sSmartNvme;
+    return 0;
+  } else if (device == "sdd") {
+    while (!sRelease) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    output = sSmartAta;
+    return 0;
+  }
+
+  return 2;
+}
+
+static int
+ProbeCount(const std::string& device)
+{
+  std::lock_guard<std::mutex> lock(sProbeMutex);
+  return sProbeCount[device];
+}
+
+//------------------------------------------------------------------------------
+// Wait until only the given number of probes is running
+//------------------------------------------------------------------------------
+static bool
+WaitProbes(eos::fst::DiskHealth& health, size_t running)
+{
+  for (int i = 0; i < 500; ++i) {
+    if (health.RunningProbes() == running) {
+      return true;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Write a fixture file
+//------------------------------------------------------------------------------
+static void
+WriteFile(const std::string& path, const std::string& content)
+{
+  std::string cmd = "mkdir -p " + path.substr(0, path.rfind('/'));
+  CPPUNIT_ASSERT(system(cmd.c_str()) == 0);
+  std::ofstream file(path.c_str());
+  file << content;
+}
+
+//------------------------------------------------------------------------------
+// CPPUNIT setUp method
+//------------------------------------------------------------------------------
+void HealthTest::setUp(void)
+{
+  char dir[] = "/tmp/eos-health-test-XXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(dir));
+  mDir = dir;
+  WriteFile(mDir + "/sys/block/sda/device/state", "running\n");
+  WriteFile(mDir + "/sys/block/sda/device/ioerr_cnt", "0x1f\n");
+  WriteFile(mDir + "/sys/block/sde/device/state", "offline\n");
+  WriteFile(mDir + "/mdstat", sMdstat);
+}
+
+//------------------------------------------------------------------------------
+// CPPUNIT tearDown method
+//------------------------------------------------------------------------------
+void HealthTest::tearDown(void)
+{
+  std::string cmd = "rm -rf " + mDir;
+  system(cmd.c_str());
+}
+
+//------------------------------------------------------------------------------
+// Parse the recorded smartctl and mdstat output
+//------------------------------------------------------------------------------
+void HealthTest::ParseTest()
+{
+  auto ata = eos::fst::DiskHealth::ParseSmartctl(0, sSmartAta);
+  CPPUNIT_ASSERT(ata["summary"] == "OK");
+  CPPUNIT_ASSERT(ata["overall"] == "PASSED");
+  CPPUNIT_ASSERT(ata["reallocated_sectors"] == "3");
+  CPPUNIT_ASSERT(ata["power_on_hours"] == "31450");
+  CPPUNIT_ASSERT(ata["temperature"] == "37");
+  CPPUNIT_ASSERT(ata["pending_sectors"] == "1");
+  CPPUNIT_ASSERT(ata["offline_uncorrectable"] == "0");
+  auto sas = eos::fst::DiskHealth::ParseSmartctl(0, sSmartSas);
+  CPPUNIT_ASSERT(sas["overall"] == "OK");
+  CPPUNIT_ASSERT(sas["temperature"] == "31");
+  CPPUNIT_ASSERT(sas["grown_defects"] == "12");
+  CPPUNIT_ASSERT(sas["power_on_hours"] == "20456");
+  auto nvme = eos::fst::DiskHealth::ParseSmartctl(0, sSmartNvme);
+  CPPUNIT_ASSERT(nvme["temperature"] == "42");
+  CPPUNIT_ASSERT(nvme["power_on_hours"] == "1234");
+  CPPUNIT_ASSERT(nvme["media_errors"] == "0");
+  auto failing = eos::fst::DiskHealth::ParseSmartctl(8 | 32, sSmartFailing);
+  CPPUNIT_ASSERT(failing["summary"] == "FAILING");
+  CPPUNIT_ASSERT(failing["overall"] == "FAILED!");
+  CPPUNIT_ASSERT(failing["reallocated_sectors"] == "4032");
+  CPPUNIT_ASSERT(failing["temperature"] == "33");
+  CPPUNIT_ASSERT(failing["pending_sectors"] == "88");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseSmartctl(127, "")["summary"] ==
+                 "no smartctl");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseSmartctl(2, "")["summary"] == "N/A");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseSmartctl(64, "")["summary"] ==
+                 "Check");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseSmartctl(-1, "")["summary"] ==
+                 "timeout");
+  auto md = eos::fst::DiskHealth::ParseMdstat(sMdstat, "md0");
+  CPPUNIT_ASSERT(md["summary"] == "! 6/7 (+1)");
+  CPPUNIT_ASSERT(md["redundancy_factor"] == "2");
+  CPPUNIT_ASSERT(md["drives_failed"] == "1");
+  CPPUNIT_ASSERT(md["indicator"] == "1");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseMdstat("", "md0")["summary"] ==
+                 "no mdstat");
+  CPPUNIT_ASSERT(eos::fst::DiskHealth::ParseMdstat(sMdstat, "md1")["summary"] ==
+                 "unknown raid");
+}
+
+//------------------------------------------------------------------------------
+// Run measurement rounds with timeouts and backoff
+//------------------------------------------------------------------------------
+void HealthTest::CollectTest()
+{
+  eos::fst::DiskHealth health(900, 60, 86400);
+  health.SetProbe(FakeSmartctl);
+  health.SetSources(mDir + "/sys", mDir + "/mdstat");
+  const char* devices[] = {"sda1", "sdb", "sdc2", "sdd", "sde1", "nvme0n1p1",
+                           "md0"
+                          };
+  time_t t0 = 1000000;
+
+  // Unknown devices are registered but not measured on the caller's thread
+  for (auto dev : devices) {
+    CPPUNIT_ASSERT(health.getHealth(dev).empty());
+  }
+
+  CPPUNIT_ASSERT(ProbeCount("sda") == 0);
+  health.Measure(t0);
+  // Only the hanging probe of sdd is left
+  CPPUNIT_ASSERT(WaitProbes(health, 1));
+  health.Measure(t0 + 10);
+  CPPUNIT_ASSERT(health.getHealth("sda1")["summary"] == "OK");
+  CPPUNIT_ASSERT(health.getHealth("sda1")["temperature"] == "37");
+  CPPUNIT_ASSERT(health.getHealth("sda1")["ioerr_cnt"] == "31");
+  CPPUNIT_ASSERT(health.getHealth("sdb")["grown_defects"] == "12");
+  CPPUNIT_ASSERT(health.getHealth("sdc2")["summary"] == "FAILING");
+  CPPUNIT_ASSERT(health.getHealth("nvme0n1p1")["power_on_hours"] == "1234");
+  CPPUNIT_ASSERT(health.getHealth("md0")["summary"] == "! 6/7 (+1)");
+  CPPUNIT_ASSERT(health.getHealth("sdd").empty());
+  // Offline devices are not probed at all
+  CPPUNIT_ASSERT(health.getHealth("sde1")["summary"] == "offline");
+  CPPUNIT_ASSERT(ProbeCount("sde") == 0);
+  // A hanging probe times out and is not started again while running
+  health.Measure(t0 + 60);
+  CPPUNIT_ASSERT(health.getHealth("sdd")["summary"] == "timeout");
+  CPPUNIT_ASSERT(health.getHealth("sda1")["summary"] == "OK");
+  health.Measure(t0 + 900);
+  CPPUNIT_ASSERT(WaitProbes(health, 1));
+  CPPUNIT_ASSERT(ProbeCount("sda") == 2);
+  CPPUNIT_ASSERT(ProbeCount("sdd") == 1);
+  // A late result is used but the device stays in backoff (2 x interval)
+  sRelease = true;
+  CPPUNIT_ASSERT(WaitProbes(health, 0));
+  health.Measure(t0 + 910);
+  CPPUNIT_ASSERT(health.getHealth("sdd")["summary"] == "OK");
+  health.Measure(t0 + 1000);
+  CPPUNIT_ASSERT(WaitProbes(health, 0));
+  CPPUNIT_ASSERT(ProbeCount("sdd") == 1);
+  health.Measure(t0 + 1800);
+  CPPUNIT_ASSERT(WaitProbes(health, 0));
+  CPPUNIT_ASSERT(ProbeCount("sdd") == 2);
+  CPPUNIT_ASSERT(ProbeCount("sda") == 3);
+}
@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+//! @file HealthTest.hh
+//! @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_TESTS_HEALTHTEST__HH__
+#define __EOSFST_TESTS_HEALTHTEST__HH__
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+//------------------------------------------------------------------------------
+//! Class HealthTest - feeds recorded smartctl, sysfs and mdstat output to the
+//! disk health collector
+//------------------------------------------------------------------------------
+class HealthTest : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(HealthTest);
+  CPPUNIT_TEST(ParseTest);
+  CPPUNIT_TEST(CollectTest);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::string mDir; ///< directory holding the sysfs and mdstat fixtures
+
+public:
+  //----------------------------------------------------------------------------
+  //! CPPUNIT required methods
+  //----------------------------------------------------------------------------
+  void setUp(void);
+  void tearDown(void);
+
+  //----------------------------------------------------------------------------
+  //! Parse the recorded smartctl and mdstat output
+  //----------------------------------------------------------------------------
+  void ParseTest();
+
+  //----------------------------------------------------------------------------
+  //! Run measurement rounds with timeouts and backoff
+  //----------------------------------------------------------------------------
+  void CollectTest();
+};
+
+#endif // __EOSFST_TESTS_HEALTHTEST__HH__
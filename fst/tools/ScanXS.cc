@@ -43,24 +43,37 @@ int
 main(int argc, char* argv[])
 {
   bool setxs = false;
+  int rate = 100;
+  int threads = 1;
+  const char* usage =
+    "usage: eos-scan-fs <directory> [--setxs] [--rate <MB/s>] [--threads <n>]\n";
   eos::common::Logging::Init();
   eos::common::Logging::SetLogPriority(LOG_INFO);
   eos::common::Logging::SetUnit("Scandir");
 
-  if ((argc < 2) || (argc > 3)) {
-    fprintf(stderr, "usage: eos-scan-fs <directory> [--setxs]\n");
+  if (argc < 2) {
+    fprintf(stderr, "%s", usage);
     exit(-1);
   }
 
-  if (argc == 3) {
-    XrdOucString set = argv[2];
+  for (int i = 2; i < argc; ++i) {
+    XrdOucString option = argv[i];
 
-    if (set != "--setxs") {
-      fprintf(stderr, "usage: eos-scan-fs <directory> [--setxs]\n");
+    if (option == "--setxs") {
+      setxs = true;
+    } else if ((option == "--rate") && (i + 1 < argc)) {
+      rate = atoi(argv[++i]);
+    } else if ((option == "--threads") && (i + 1 < argc)) {
+      threads = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "%s", usage);
       exit(-1);
     }
+  }
 
-    setxs = true;
+  if ((rate <= 0) || (threads <= 0)) {
+    fprintf(stderr, "%s", usage);
+    exit(-1);
   }
 
   srand((unsigned int) time(NULL));
@@ -69,7 +82,7 @@ main(int argc, char* argv[])
   usleep(100000);
   XrdOucString dirName = argv[1];
   eos::fst::ScanDir* sd = new eos::fst::ScanDir(dirName.c_str(), 0, &fstLoad,
-      false, 10, 100, setxs);
+      false, 10, rate, setxs, threads);
 
   if (sd) {
     eos::fst::ScanDir::StaticThreadProc((void*) sd);
@@ -165,8 +165,16 @@ TransferJob::GetSourceUrl ()
     mSourceUrl += "?";
     mSourceUrl += "cap.sym=";
     mSourceUrl += mJob->GetEnv()->Get("source.cap.sym");
-    mSourceUrl += "&cap.msg=";
-    mSourceUrl += mJob->GetEnv()->Get("source.cap.msg");
+    if (mJob->GetEnv()->Get("source.cap.mac"))
+    {
+      mSourceUrl += "&cap.mac=";
+      mSourceUrl += mJob->GetEnv()->Get("source.cap.mac");
+    }
+    else
+    {
+      mSourceUrl += "&cap.msg=";
+      mSourceUrl += mJob->GetEnv()->Get("source.cap.msg");
+    }
   }
   else
   {
@@ -195,8 +203,16 @@ TransferJob::GetTargetUrl ()
     mTargetUrl += "?";
     mTargetUrl += "cap.sym=";
     mTargetUrl += mJob->GetEnv()->Get("target.cap.sym");
-    mTargetUrl += "&cap.msg=";
-    mTargetUrl += mJob->GetEnv()->Get("target.cap.msg");
+    if (mJob->GetEnv()->Get("target.cap.mac"))
+    {
+      mTargetUrl += "&cap.mac=";
+      mTargetUrl += mJob->GetEnv()->Get("target.cap.mac");
+    }
+    else
+    {
+      mTargetUrl += "&cap.msg=";
+      mTargetUrl += mJob->GetEnv()->Get("target.cap.msg");
+    }
   }
   else
   {
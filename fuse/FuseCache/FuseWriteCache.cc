@@ -25,6 +25,7 @@
 #include <cstdio>
 #include <cstring>
 #include <unistd.h>
+#include <sstream>
 //------------------------------------------------------------------------------
 #include "FuseWriteCache.hh"
 #include "FileAbstraction.hh"
@@ -37,10 +38,10 @@ FuseWriteCache* FuseWriteCache::pInstance = NULL;
 // Return a singleton instance of the class
 //------------------------------------------------------------------------------
 FuseWriteCache*
-FuseWriteCache::GetInstance(size_t sizeMax)
+FuseWriteCache::GetInstance(size_t sizeMax, size_t nWriters)
 {
   if (!pInstance) {
-    pInstance = new FuseWriteCache(sizeMax);
+    pInstance = new FuseWriteCache(sizeMax, nWriters);
 
     if (!pInstance->Init()) {
       return NULL;
@@ -54,13 +55,16 @@ FuseWriteCache::GetInstance(size_t sizeMax)
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-FuseWriteCache::FuseWriteCache(size_t sizeMax) :
+FuseWriteCache::FuseWriteCache(size_t sizeMax, size_t nWriters) :
   eos::common::LogId(),
   mCacheSizeMax(sizeMax),
   mAllocSize(0)
 {
   mRecycleQueue = new eos::common::ConcurrentQueue<CacheEntry*>();
-  mWrReqQueue = new eos::common::ConcurrentQueue<CacheEntry*>();
+
+  for (size_t i = 0; i < (nWriters ? nWriters : 1); i++) {
+    mWriters.push_back(new Writer(this));
+  }
 }
 
 
@@ -70,13 +74,16 @@ FuseWriteCache::FuseWriteCache(size_t sizeMax) :
 bool
 FuseWriteCache::Init()
 {
-  // Start worker thread
-  if ((XrdSysThread::Run(&mWriteThread, FuseWriteCache::StartWriterThread,
-                         static_cast<void*>(this)))) {
-    eos_crit("can not start async writer thread");
-    return false;
+  // Start worker threads
+  for (auto it = mWriters.begin(); it != mWriters.end(); ++it) {
+    if ((XrdSysThread::Run(&(*it)->mThread, FuseWriteCache::StartWriterThread,
+                           static_cast<void*>(*it)))) {
+      eos_crit("can not start async writer thread");
+      return false;
+    }
   }
 
+  eos_static_info("started %zu async writer threads", mWriters.size());
   return true;
 }
 
@@ -87,10 +94,20 @@ FuseWriteCache::Init()
 FuseWriteCache::~FuseWriteCache()
 {
   void* ret;
-  // Kill the async thread
-  CacheEntry* ptr = 0;
-  mWrReqQueue->push(ptr);
-  XrdSysThread::Join(mWriteThread, &ret);
+  // Kill the async threads
+  WriteReq req;
+  req.mEntry = 0;
+
+  for (auto it = mWriters.begin(); it != mWriters.end(); ++it) {
+    if ((*it)->mThread) {
+      (*it)->mQueue.push(req);
+      XrdSysThread::Join((*it)->mThread, &ret);
+    }
+
+    delete *it;
+  }
+
+  mWriters.clear();
 }
 
 
@@ -100,9 +117,9 @@ FuseWriteCache::~FuseWriteCache()
 void*
 FuseWriteCache::StartWriterThread(void* arg)
 {
-  FuseWriteCache* fwc = static_cast<FuseWriteCache*>(arg);
-  fwc->RunThreadWrites();
-  return static_cast<void*>(fwc);
+  Writer* writer = static_cast<Writer*>(arg);
+  writer->mCache->RunThreadWrites(writer);
+  return static_cast<void*>(writer);
 }
 
 
@@ -110,22 +127,76 @@ FuseWriteCache::StartWriterThread(void* arg)
 // Method run by the thread doing asynchronous writes
 //------------------------------------------------------------------------------
 void
-FuseWriteCache::RunThreadWrites()
+FuseWriteCache::RunThreadWrites(Writer* writer)
 {
-  CacheEntry* pEntry = 0;
+  WriteReq req;
+  struct timespec now;
 
   while (1) {
-    mWrReqQueue->wait_pop(pEntry);
+    writer->mQueue.wait_pop(req);
 
-    if (pEntry == 0) {
+    if (req.mEntry == 0) {
       break;
     } else {
-      ProcessWriteReq(pEntry);
+      ProcessWriteReq(req.mEntry);
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double ms = (now.tv_sec - req.mQueued.tv_sec) * 1000.0 +
+                  (now.tv_nsec - req.mQueued.tv_nsec) / 1000000.0;
+      XrdSysMutexHelper lock(writer->mMutexStats);
+      writer->mNumWrites++;
+      writer->mLatency.Add(ms);
     }
   }
 }
 
 
+//------------------------------------------------------------------------------
+// Queue a block to the writer in charge of its file - all the blocks of a
+// file go to the same writer so that they are written in order
+//------------------------------------------------------------------------------
+void
+FuseWriteCache::QueueWrite(CacheEntry* pEntry)
+{
+  WriteReq req;
+  req.mEntry = pEntry;
+  clock_gettime(CLOCK_MONOTONIC, &req.mQueued);
+  size_t shard = (size_t) pEntry->GetParentFile()->GetFd() % mWriters.size();
+  mWriters[shard]->mQueue.push(req);
+}
+
+
+//------------------------------------------------------------------------------
+// Get the statistics of the writer threads
+//------------------------------------------------------------------------------
+void
+FuseWriteCache::GetStats(std::string& out)
+{
+  std::ostringstream oss;
+  eos::common::LatencyHistogram total;
+  size_t total_depth = 0;
+  unsigned long long total_writes = 0;
+
+  for (size_t i = 0; i < mWriters.size(); i++) {
+    size_t depth = mWriters[i]->mQueue.size();
+    XrdSysMutexHelper lock(mWriters[i]->mMutexStats);
+    oss << "writer=" << i << " queue=" << depth
+        << " writes=" << mWriters[i]->mNumWrites
+        << " latency.p50=" << mWriters[i]->mLatency.Percentile(0.5)
+        << " latency.p99=" << mWriters[i]->mLatency.Percentile(0.99)
+        << " latency.max=" << mWriters[i]->mLatency.GetMax() << std::endl;
+    total.Merge(mWriters[i]->mLatency);
+    total_depth += depth;
+    total_writes += mWriters[i]->mNumWrites;
+  }
+
+  oss << "writer=all queue=" << total_depth << " writes=" << total_writes
+      << " latency.p50=" << total.Percentile(0.5)
+      << " latency.p99=" << total.Percentile(0.99)
+      << " latency.max=" << total.GetMax() << std::endl;
+  out = oss.str();
+}
+
+
 //------------------------------------------------------------------------------
 // Submit a write request
 //------------------------------------------------------------------------------
@@ -189,7 +260,7 @@ FuseWriteCache::AddWrite(FileAbstraction*& fabst,
     if (pEntry->IsFull()) {
       eos_static_debug("cache entry full add to writes queue");
       mKeyEntryMap.erase(k);//mKeyEntryMap.find(k));
-      mWrReqQueue->push(pEntry);
+      QueueWrite(pEntry);
     }
   } else {
     // Get CacheEntry obj - new or recycled
@@ -204,7 +275,7 @@ FuseWriteCache::AddWrite(FileAbstraction*& fabst,
     if (!pEntry->IsFull()) {
       mKeyEntryMap.insert(std::make_pair(k, pEntry));
     } else {
-      mWrReqQueue->push(pEntry);
+      QueueWrite(pEntry);
     }
   }
 }
@@ -282,11 +353,10 @@ FuseWriteCache::ForceWrite()
 {
   auto iStart = mKeyEntryMap.begin();
   auto iEnd = mKeyEntryMap.end();
-  CacheEntry* pEntry = iStart->second;
 
   if (iStart != iEnd) {
     eos_static_debug("force single write");
-    mWrReqQueue->push(pEntry);
+    QueueWrite(iStart->second);
     mKeyEntryMap.erase(iStart);
   }
 }
@@ -308,7 +378,7 @@ FuseWriteCache::ForceAllWrites(FileAbstraction* fabst, bool wait)
 
     while (iStart != iEnd) {
       pEntry = iStart->second;
-      mWrReqQueue->push(pEntry);
+      QueueWrite(pEntry);
       mKeyEntryMap.erase(iStart++);
     }
 
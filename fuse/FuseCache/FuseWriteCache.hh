@@ -26,8 +26,12 @@
 
 //------------------------------------------------------------------------------
 #include <pthread.h>
+#include <time.h>
+#include <string>
+#include <vector>
 //------------------------------------------------------------------------------
 #include "common/ConcurrentQueue.hh"
+#include "common/LatencyHistogram.hh"
 #include "common/Logging.hh"
 //------------------------------------------------------------------------------
 
@@ -50,9 +54,11 @@ class FuseWriteCache: public eos::common::LogId
   //! Get instance of class
   //!
   //! @param sizeMax maximum size of the write cache
+  //! @param nWriters number of writer threads, the files are sharded over
+  //!        them so that the writes of one file are done in order
   //!
   //----------------------------------------------------------------------------
-  static FuseWriteCache* GetInstance(size_t sizeMax);
+  static FuseWriteCache* GetInstance(size_t sizeMax, size_t nWriters = 1);
 
 
   //----------------------------------------------------------------------------
@@ -84,15 +90,47 @@ class FuseWriteCache: public eos::common::LogId
   //----------------------------------------------------------------------------
   void ForceAllWrites(FileAbstraction* fabst, bool wait = true);
 
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics of the writer threads: queue depth, number of blocks
+  //! written and latency between the queueing and the write of a block
+  //!
+  //! @param out statistics in key=value format, one line per writer and a
+  //!        line with the totals
+  //----------------------------------------------------------------------------
+  void GetStats(std::string& out);
+
  private:
 
+  //----------------------------------------------------------------------------
+  //! Block queued for writing
+  //----------------------------------------------------------------------------
+  struct WriteReq {
+    CacheEntry* mEntry; ///< block to write, null to stop the writer
+    struct timespec mQueued; ///< time when the block was queued
+  };
+
+  //----------------------------------------------------------------------------
+  //! Writer thread with its own queue of blocks
+  //----------------------------------------------------------------------------
+  struct Writer {
+    FuseWriteCache* mCache; ///< owning cache
+    pthread_t mThread; ///< thread doing the writes
+    eos::common::ConcurrentQueue<WriteReq> mQueue; ///< write request queue
+    XrdSysMutex mMutexStats; ///< mutex protecting the statistics
+    unsigned long long mNumWrites; ///< number of blocks written
+    eos::common::LatencyHistogram mLatency; ///< queue to write latency
+
+    Writer(FuseWriteCache* cache): mCache(cache), mThread(0), mNumWrites(0) {}
+  };
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
   //! @param sizeMax maximum size
   //!
   //----------------------------------------------------------------------------
-  FuseWriteCache(size_t sizeMax);
+  FuseWriteCache(size_t sizeMax, size_t nWriters);
 
 
   //----------------------------------------------------------------------------
@@ -108,9 +146,19 @@ class FuseWriteCache: public eos::common::LogId
 
 
   //----------------------------------------------------------------------------
-  //! Method executed by the thread doing the write operations
+  //! Method executed by the threads doing the write operations
+  //!
+  //! @param writer writer run by the calling thread
+  //----------------------------------------------------------------------------
+  void RunThreadWrites(Writer* writer);
+
+
+  //----------------------------------------------------------------------------
+  //! Queue a block to the writer in charge of its file
+  //!
+  //! @param pEntry cache entry handler
   //----------------------------------------------------------------------------
-  void RunThreadWrites();
+  void QueueWrite(CacheEntry* pEntry);
 
 
   //----------------------------------------------------------------------------
@@ -167,13 +215,12 @@ class FuseWriteCache: public eos::common::LogId
   static FuseWriteCache* pInstance; ///< singleton object
   size_t mCacheSizeMax; ///< max cache size
   size_t mAllocSize; ///< total allocated cache size
-  pthread_t mWriteThread; ///< async thread doing the writes
+  std::vector<Writer*> mWriters; ///< async threads doing the writes
   key_entry_t mKeyEntryMap; ///< map of entries in the cache
   XrdSysMutex mMapLock; ///< rw lock for the key entry map
   XrdSysMutex mMutexSize; ///< cache size mutex
 
   eos::common::ConcurrentQueue<CacheEntry*>* mRecycleQueue; ///< pool of reusable objects
-  eos::common::ConcurrentQueue<CacheEntry*>* mWrReqQueue; ///< write request queue
 };
 
 #endif // __EOS_FUSE_FUSEWRITECACHE_HH__
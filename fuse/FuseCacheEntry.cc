@@ -80,6 +80,7 @@ FuseCacheEntry::Update (int noEntries,
   mModifTime.tv_nsec = modifTime.tv_nsec;
   mNumEntries = noEntries;
   mSubEntries.clear();
+  mSubEntriesTime.clear();
 
   if (mBuf.size != pBuf->size)
   {
@@ -129,6 +130,7 @@ FuseCacheEntry::AddEntry (unsigned long long inode,
   if (!mSubEntries.count(inode))
   {
     mSubEntries[inode] = *e;
+    clock_gettime(CLOCK_MONOTONIC, &mSubEntriesTime[inode]);
   }
 }
 
@@ -152,6 +154,65 @@ FuseCacheEntry::GetEntry (unsigned long long inode,
   return false;
 }
 
+
+//------------------------------------------------------------------------------
+// Get subentry attributes
+//------------------------------------------------------------------------------
+
+bool
+FuseCacheEntry::GetEntryAttr (unsigned long long inode,
+                              struct stat& buf,
+                              double maxAge)
+{
+  eos::common::RWMutexReadLock rd_lock(mMutex);
+  std::map<unsigned long long, struct fuse_entry_param>::iterator it =
+    mSubEntries.find(inode);
+  std::map<unsigned long long, struct timespec>::iterator itime =
+    mSubEntriesTime.find(inode);
+
+  // entries listed without stat information have a zero inode
+  if ((it == mSubEntries.end()) || (itime == mSubEntriesTime.end()) ||
+      (!it->second.attr.st_ino))
+  {
+    return false;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double age = (now.tv_sec - itime->second.tv_sec) +
+               (now.tv_nsec - itime->second.tv_nsec) / 1000000000.0;
+
+  if (age > maxAge)
+  {
+    return false;
+  }
+
+  buf = it->second.attr;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Replace subentry attributes
+//------------------------------------------------------------------------------
+
+bool
+FuseCacheEntry::SetEntryAttr (unsigned long long inode,
+                              const struct stat& buf)
+{
+  eos::common::RWMutexWriteLock wr_lock(mMutex);
+  std::map<unsigned long long, struct fuse_entry_param>::iterator it =
+    mSubEntries.find(inode);
+
+  if (it == mSubEntries.end())
+  {
+    return false;
+  }
+
+  it->second.attr = buf;
+  clock_gettime(CLOCK_MONOTONIC, &mSubEntriesTime[inode]);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Update subentry
 //------------------------------------------------------------------------------
@@ -161,7 +222,7 @@ FuseCacheEntry::UpdateEntry( unsigned long long inode, struct stat* buf )
 {
   eos::common::RWMutexWriteLock wr_lock(mMutex);
 
-  if (!mSubEntries.count(inode))
+  if (mSubEntries.count(inode))
   {
     mSubEntries[inode].attr.st_size = buf->st_size;
     return true;
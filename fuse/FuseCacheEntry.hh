@@ -28,6 +28,7 @@
 /*----------------------------------------------------------------------------*/
 #include <map>
 #include <set>
+#include <time.h>
 /*----------------------------------------------------------------------------*/
 #include "common/RWMutex.hh"
 /*----------------------------------------------------------------------------*/
@@ -129,6 +130,31 @@ class FuseCacheEntry
     bool GetEntry( unsigned long long inode, struct fuse_entry_param& e );
 
 
+    //--------------------------------------------------------------------------
+    //! Get the attributes of a subentry if they were added recently
+    //!
+    //! @param inode subentry inode
+    //! @param buf stat structure filled with the cached attributes
+    //! @param maxAge maximum age in seconds of the cached attributes
+    //!
+    //! @return true if entry found with valid attributes, otherwise false
+    //!
+    //--------------------------------------------------------------------------
+    bool GetEntryAttr( unsigned long long inode, struct stat& buf, double maxAge );
+
+
+    //--------------------------------------------------------------------------
+    //! Replace the attributes of a subentry e.g. after a setattr
+    //!
+    //! @param inode subentry inode
+    //! @param buf new attributes
+    //!
+    //! @return true if entry found, otherwise false
+    //!
+    //--------------------------------------------------------------------------
+    bool SetEntryAttr( unsigned long long inode, const struct stat& buf );
+
+
     //--------------------------------------------------------------------------
     //! Update subentry stat
     //!
@@ -159,6 +185,7 @@ class FuseCacheEntry
     struct timespec mModifTime;        ///< modification time of the directory
     eos::common::RWMutex mMutex;       ///< mutex protecting the subentries map
     std::map<unsigned long long, struct fuse_entry_param> mSubEntries;  ///< map of subentries
+    std::map<unsigned long long, struct timespec> mSubEntriesTime;      ///< time when the subentries were added
 };
 
 #endif
@@ -385,8 +385,23 @@ EosFuse::getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
   me.fs().unlock_r_p2i();   // <=
   eos_static_debug("inode=%lld path=%s",
                    (long long) ino, fullpath.c_str());
-  int retc = me.fs().stat(fullpath.c_str(), &stbuf, fuse_req_ctx(req)->uid,
-                          fuse_req_ctx(req)->gid, fuse_req_ctx(req)->pid, ino);
+  int retc = 0;
+
+  // use the attributes prefetched by the last listing of the parent directory
+  if (me.fs().dir_cache_get_attr(ino, &stbuf, me.config.attrcachetime)) {
+    struct stat ostat;
+
+    // an open file might have a more recent size and mtime
+    if (!me.fs().stat(fullpath.c_str(), &ostat, fuse_req_ctx(req)->uid,
+                      fuse_req_ctx(req)->gid, fuse_req_ctx(req)->pid, ino, true)) {
+      stbuf.MTIMESPEC = ostat.MTIMESPEC;
+      stbuf.st_mtime = ostat.MTIMESPEC.tv_sec;
+      stbuf.st_size = ostat.st_size;
+    }
+  } else {
+    retc = me.fs().stat(fullpath.c_str(), &stbuf, fuse_req_ctx(req)->uid,
+                        fuse_req_ctx(req)->gid, fuse_req_ctx(req)->pid, ino);
+  }
 
  if (!retc)
  {
@@ -501,6 +516,8 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int to_set,
      
    if (!retc)
    {
+     // keep the attributes prefetched by the directory listing consistent
+     me.fs().dir_cache_set_attr(ino, &newattr);
      eos_static_info("attr-reply %lld %u %u %ld.%ld %ld.%ld",  (long long) newattr.st_ino, newattr.st_uid, newattr.st_gid, (long) newattr.ATIMESPEC.tv_sec, (long) newattr.ATIMESPEC.tv_nsec, (long) newattr.MTIMESPEC.tv_sec, (long) newattr.MTIMESPEC.tv_nsec);
      fuse_reply_attr (req, &newattr, me.config.attrcachetime);
      eos_static_debug("mode=%x timeout=%.02f\n", newattr.st_mode, me.config.attrcachetime);
@@ -1687,6 +1704,24 @@ EosFuse::getxattr(fuse_req_t req, fuse_ino_t ino, const char* xattr_name,
  }
 
   EosFuse& me = instance();
+
+  // statistics of the write-back cache of the mount, served locally
+  if (xa == "eos.fuse.wbcache") {
+    std::string stats;
+
+    if (!me.fs().write_cache_stats(stats)) {
+      fuse_reply_err(req, ENOATTR);
+    } else if (!size) {
+      fuse_reply_xattr(req, stats.length());
+    } else if (size < stats.length()) {
+      fuse_reply_err(req, ERANGE);
+    } else {
+      fuse_reply_buf(req, stats.c_str(), stats.length());
+    }
+
+    return;
+  }
+
  // re-resolve the inode
  ino = me.fs().redirect_i2i(ino);
 
@@ -51,6 +51,7 @@
 #include "XrdCl/XrdClXRootDResponses.hh"
 #include "MacOSXHelper.hh"
 #include "FuseCache/CacheEntry.hh"
+#include "fst/io/AsyncMetaHandler.hh"
 #include "common/XrdErrorMap.hh"
 #include "filesystem.hh"
 
@@ -245,6 +246,16 @@ filesystem::log_settings()
                       getenv("EOS_FUSE_CACHE_PAGE_SIZE") : "(default 262144)";
  s += efpcs;
   log("WARNING", s.c_str());
+ s = "write-cache-writers    := ";
+  std::string efcw = getenv("EOS_FUSE_CACHE_WRITERS") ?
+                     getenv("EOS_FUSE_CACHE_WRITERS") : "(default 4)";
+ s += efcw;
+  log("WARNING", s.c_str());
+ s = "write-cache-inflight   := ";
+  std::string efci = getenv("EOS_FUSE_CACHE_WRITE_INFLIGHT") ?
+                     getenv("EOS_FUSE_CACHE_WRITE_INFLIGHT") : "(default 20)";
+ s += efci;
+  log("WARNING", s.c_str());
  s = "big-writes             := ";
   std::string bw = getenv("EOS_FUSE_BIGWRITES") ? getenv("EOS_FUSE_BIGWRITES") :
                    "0";
@@ -728,6 +739,57 @@ filesystem::dir_cache_update_entry(unsigned long long entry_inode,
 }
 
 
+//------------------------------------------------------------------------------
+// Get the attributes of an entry prefetched by a directory listing
+//------------------------------------------------------------------------------
+bool
+filesystem::dir_cache_get_attr(unsigned long long entry_inode,
+                               struct stat* buf,
+                               double max_age)
+{
+  eos::common::RWMutexReadLock rd_lock(mutex_fuse_cache);
+  FuseCacheEntry* dir = 0;
+  auto it = inode2parent.find(entry_inode);
+
+  if (it == inode2parent.end()) {
+    return false;
+  }
+
+  auto dit = inode2cache.find(it->second);
+
+  if ((dit == inode2cache.end()) || !(dir = dit->second)) {
+    return false;
+  }
+
+  return dir->GetEntryAttr(entry_inode, *buf, max_age);
+}
+
+
+//------------------------------------------------------------------------------
+// Replace the cached attributes of an entry
+//------------------------------------------------------------------------------
+bool
+filesystem::dir_cache_set_attr(unsigned long long entry_inode,
+                               struct stat* buf)
+{
+  eos::common::RWMutexReadLock rd_lock(mutex_fuse_cache);
+  FuseCacheEntry* dir = 0;
+  auto it = inode2parent.find(entry_inode);
+
+  if (it == inode2parent.end()) {
+    return false;
+  }
+
+  auto dit = inode2cache.find(it->second);
+
+  if ((dit == inode2cache.end()) || !(dir = dit->second)) {
+    return false;
+  }
+
+  return dir->SetEntryAttr(entry_inode, *buf);
+}
+
+
 //------------------------------------------------------------------------------
 // Create artificial file descriptor
 int
@@ -2259,6 +2321,151 @@ filesystem::access(const char* path,
 }
 
 
+//------------------------------------------------------------------------------
+// Get the statistics of the write-back cache
+//------------------------------------------------------------------------------
+bool
+filesystem::write_cache_stats(std::string& out)
+{
+  if (!XFC) {
+    return false;
+  }
+
+  XFC->GetStats(out);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Handler of one asynchronous chunk read of a proc response
+//------------------------------------------------------------------------------
+class ProcChunkHandler : public XrdCl::ResponseHandler
+{
+public:
+  ProcChunkHandler(XrdSysCondVar& cond, int& pending, bool& failed,
+                   uint32_t expected):
+    mCond(cond), mPending(pending), mFailed(failed), mExpected(expected) {}
+
+  virtual ~ProcChunkHandler() {}
+
+  virtual void HandleResponse(XrdCl::XRootDStatus* status,
+                              XrdCl::AnyObject* response)
+  {
+    uint32_t nbytes = 0;
+    bool ok = status && status->IsOK();
+
+    if (ok && response) {
+      XrdCl::ChunkInfo* chunk = 0;
+      response->Get(chunk);
+      nbytes = chunk ? chunk->length : 0;
+    }
+
+    delete status;
+    delete response;
+    XrdSysCondVarHelper lock(mCond);
+
+    if (!ok || (nbytes != mExpected)) {
+      mFailed = true;
+    }
+
+    if (!--mPending) {
+      mCond.Signal();
+    }
+  }
+
+private:
+  XrdSysCondVar& mCond;
+  int& mPending;
+  bool& mFailed;
+  uint32_t mExpected;
+};
+
+//------------------------------------------------------------------------------
+// Read the complete response of an open proc file
+//------------------------------------------------------------------------------
+XrdCl::XRootDStatus
+filesystem::read_proc_response(XrdCl::File* file, char*& value, off_t& length)
+{
+  XrdCl::StatInfo* info = 0;
+  XrdCl::XRootDStatus status = file->Stat(true, info);
+  uint64_t size = (status.IsOK() && info) ? info->GetSize() : 0;
+  delete info;
+  length = 0;
+
+  if (size) {
+    // the response is created during the open, its size is known and it is
+    // fetched with a window of parallel reads of large chunks
+    value = (char*) malloc(size + 1);
+    XrdSysCondVar cond(0);
+    bool failed = false;
+    uint64_t offset = 0;
+
+    while (offset < size && !failed) {
+      int pending = 0;
+      std::vector<ProcChunkHandler*> handlers;
+      cond.Lock();
+
+      for (int i = 0; (i < PROCREADWINDOW) && (offset < size); i++) {
+        uint32_t chunk = (size - offset > PROCCHUNKSIZE) ? PROCCHUNKSIZE :
+                         (uint32_t)(size - offset);
+        ProcChunkHandler* handler = new ProcChunkHandler(cond, pending, failed,
+            chunk);
+        pending++;
+
+        if (!file->Read(offset, chunk, value + offset, handler).IsOK()) {
+          pending--;
+          failed = true;
+          delete handler;
+          break;
+        }
+
+        handlers.push_back(handler);
+        offset += chunk;
+      }
+
+      while (pending) {
+        cond.Wait();
+      }
+
+      cond.UnLock();
+
+      for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+        delete *it;
+      }
+    }
+
+    if (!failed) {
+      length = size;
+      return status;
+    }
+
+    eos_static_warning("parallel read of proc response failed - retry sequentially");
+    free(value);
+  }
+
+  // sequential reads growing the buffer geometrically
+  size_t alloc = PAGESIZE;
+  unsigned int nbytes = 0;
+  value = (char*) malloc(alloc + 1);
+  status = file->Read(0, PAGESIZE, value, nbytes);
+
+  while (status.IsOK() && (nbytes == PAGESIZE)) {
+    length += nbytes;
+
+    if (length + PAGESIZE > (off_t) alloc) {
+      alloc *= 2;
+      value = (char*) realloc(value, alloc + 1);
+    }
+
+    status = file->Read(length, PAGESIZE, value + length, nbytes);
+  }
+
+  if (status.IsOK()) {
+    length += nbytes;
+  }
+
+  return status;
+}
+
 //------------------------------------------------------------------------------
 // Get list of entries in directory
 //------------------------------------------------------------------------------
@@ -2312,24 +2519,9 @@ filesystem::inodirlist(unsigned long long dirinode,
   }
   
   // Start to read
-  int npages = 1;
   off_t offset = 0;
-  unsigned int nbytes = 0;
-  value = (char*) malloc(PAGESIZE + 1);
   COMMONTIMING("READSTSTREAM", &inodirtiming);
-  status = file->Read(offset, PAGESIZE, value + offset, nbytes);
-  
-  while ((status.IsOK()) && (nbytes == PAGESIZE)) {
-    npages++;
-    value = (char*) realloc(value, npages * PAGESIZE + 1);
-    offset += PAGESIZE;
-    status = file->Read(offset, PAGESIZE, value + offset, nbytes);
-    }
-
-  if (status.IsOK()) {
-    offset += nbytes;
-  }
-  
+  status = read_proc_response(file, value, offset);
   value[offset] = 0;
   //eos_static_info("request reply is %s",value);
   delete file;
@@ -4634,8 +4826,20 @@ filesystem::init(int argc, char* argv[], void* userdata,
       setenv("EOS_FUSE_CACHE_SIZE", "30000000", 1);  // ~300MB
  }
 
+    size_t nwriters = 4;
+
+    if (getenv("EOS_FUSE_CACHE_WRITERS")) {
+      nwriters = (size_t) strtoul(getenv("EOS_FUSE_CACHE_WRITERS"), 0, 10);
+    }
+
+    // number of async writes in flight per file
+    if (getenv("EOS_FUSE_CACHE_WRITE_INFLIGHT")) {
+      eos::fst::AsyncMetaHandler::SetMaxNumAsyncObj((unsigned int) strtoul(
+            getenv("EOS_FUSE_CACHE_WRITE_INFLIGHT"), 0, 10));
+    }
+
     XFC = FuseWriteCache::GetInstance(static_cast<size_t>(atol(
-                                        getenv("EOS_FUSE_CACHE_SIZE"))));
+                                        getenv("EOS_FUSE_CACHE_SIZE"))), nwriters);
    fuse_cache_write = true;
  }
 
@@ -49,6 +49,8 @@
 #include "common/RWMutex.hh"
 #include "common/SymKeys.hh"
 /*----------------------------------------------------------------------------*/
+#include "XrdCl/XrdClFile.hh"
+/*----------------------------------------------------------------------------*/
 #include <google/dense_hash_map>
 #include <google/sparse_hash_map>
 #include <google/sparsehash/densehashtable.h>
@@ -72,6 +74,8 @@
 #define N_OPEN_MUTEXES (1 << N_OPEN_MUTEXES_NBITS)
 
 #define PAGESIZE 128 * 1024
+#define PROCCHUNKSIZE (4 * 1024 * 1024)
+#define PROCREADWINDOW 8
 
 class filesystem
 {
@@ -466,6 +470,28 @@ public:
   bool dir_cache_update_entry(unsigned long long entry_inode,
 			      struct stat* buf);
 
+ //----------------------------------------------------------------------------
+ //! Get the attributes of an entry prefetched by a directory listing
+ //!
+ //! @param entry_inode entry inode
+ //! @param buf stat info
+ //! @param max_age maximum age in seconds of the prefetched attributes
+ //!
+ //! @return true if found, otherwise false
+ //----------------------------------------------------------------------------
+  bool dir_cache_get_attr(unsigned long long entry_inode,
+                          struct stat* buf,
+                          double max_age);
+
+ //----------------------------------------------------------------------------
+ //! Replace the cached attributes of an entry
+ //!
+ //! @param entry_inode entry inode
+ //! @param buf stat info
+ //----------------------------------------------------------------------------
+  bool dir_cache_set_attr(unsigned long long entry_inode,
+                          struct stat* buf);
+
 
 
  //----------------------------------------------------------------------------
@@ -708,6 +734,28 @@ public:
              pid_t pid
              );
 
+ //----------------------------------------------------------------------------
+ //! Get the statistics of the write-back cache
+ //!
+ //! @param out statistics of the writer threads
+ //!
+ //! @return true if the write-back cache is enabled, otherwise false
+ //----------------------------------------------------------------------------
+  bool write_cache_stats(std::string& out);
+
+ //----------------------------------------------------------------------------
+ //! Read the complete response of an open proc file
+ //!
+ //! @param file open proc file
+ //! @param value malloc'ed buffer with the response and space for a trailing
+ //!        null character, to be freed by the caller
+ //! @param length length of the response
+ //!
+ //! @return status of the last read
+ //----------------------------------------------------------------------------
+  XrdCl::XRootDStatus read_proc_response(XrdCl::File* file, char*& value,
+                                         off_t& length);
+
  //----------------------------------------------------------------------------
  //!
  //----------------------------------------------------------------------------
@@ -70,6 +70,9 @@ bool Access::gStallWrite = false;
 //! indicates a user or group rate stall entry
 bool Access::gStallUserGroup = false;
 
+//! rate limiter compiled from the rate stall rules
+RateLimiter Access::gRateLimiter;
+
 //! singleton map for UID based redirection (not used yet)
 std::map<uid_t, std::string> Access::gUserRedirection;
 
@@ -128,6 +131,7 @@ Access::Reset ()
   Access::gGroupRedirection.clear();
   Access::gStallGlobal = Access::gStallRead = \
     Access::gStallWrite = Access::gStallUserGroup = false;
+  Access::gRateLimiter.Compile(Access::gStallRules, Access::gStallComment);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -290,6 +294,8 @@ Access::ApplyAccessConfig (bool applyredirectandstall)
       }
     }
   }
+
+  Access::gRateLimiter.Compile(Access::gStallRules, Access::gStallComment);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -392,6 +398,8 @@ Access::StoreAccessConfig ()
     }
   }
 
+  gRateLimiter.Compile(Access::gStallRules, Access::gStallComment);
+
   for (itredirect = Access::gRedirectionRules.begin();
        itredirect != Access::gRedirectionRules.end(); itredirect++)
   {
@@ -37,6 +37,7 @@
 /*----------------------------------------------------------------------------*/
 #include "mgm/Namespace.hh"
 #include "common/RWMutex.hh"
+#include "mgm/RateLimiter.hh"
 /*----------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------*/
@@ -60,7 +61,9 @@ EOSMGMNAMESPACE_BEGIN
  * '*' => everything get's stalled by number of seconds stored 
  * in gStallRules["*"]\n
  * 'r:*" => everything get's stalled in read operations as above.\n
- *'w:*" => everything get's stalled in write operations as above.\n\n
+ *'w:*" => everything get's stalled in write operations as above.\n
+ * 'rate:<user|group>:<id|*>:<op>' => limits the rate of an operation 
+ * (see RateLimiter).\n\n
  * The same syntax is used in gRedirectionRules to define r+w, 
  * r or w operation redirection. 
  * The value in this map is defined as '<host>:<port>'
@@ -142,6 +145,9 @@ public:
   //! indicates a user or group rate stall entry
   static bool gStallUserGroup;
 
+  //! token buckets enforcing the compiled 'rate:' stall rules
+  static RateLimiter gRateLimiter;
+
   //! map containing user based redirection
   static std::map<uid_t, std::string> gUserRedirection;
 
@@ -123,6 +123,7 @@ FileConfigEngine::FileConfigEngine(const char* config_dir)
 //------------------------------------------------------------------------------
 FileConfigEngine::~FileConfigEngine()
 {
+  StopAutoSaver();
 }
 
 //------------------------------------------------------------------------------
@@ -212,7 +213,10 @@ FileConfigEngine::LoadConfig(XrdOucEnv& env, XrdOucString& err)
       mBroadcast = true;
       cl += " successfully";
       mChangelog->AddEntry(cl.c_str());
-      mConfigFile = name;
+      {
+        XrdSysMutexHelper lock(mMutex);
+        mConfigFile = name;
+      }
       mChangelog->ClearChanges();
       return true;
     }
@@ -253,9 +257,16 @@ FileConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
 
   eos_notice("saving config name=%s comment=%s force=%d", name, comment, force);
 
+  XrdOucString current;
+
   if (!name) {
-    if (mConfigFile.length()) {
-      name = mConfigFile.c_str();
+    {
+      XrdSysMutexHelper lock(mMutex);
+      current = mConfigFile;
+    }
+
+    if (current.length()) {
+      name = current.c_str();
       force = true;
     } else {
       err = "error: you have to specify a configuration file name";
@@ -355,7 +366,10 @@ FileConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
   cl += " ]";
   mChangelog->AddEntry(cl.c_str());
   mChangelog->ClearChanges();
-  mConfigFile = name;
+  {
+    XrdSysMutexHelper lock(mMutex);
+    mConfigFile = name;
+  }
   return true;
 }
 
@@ -526,7 +540,11 @@ FileConfigEngine::FilterConfig(PrintInfo& pinfo, XrdOucString& out,
 bool
 FileConfigEngine::AutoSave()
 {
-  if (gOFS->MgmMaster.IsMaster() && mAutosave && mConfigFile.length()) {
+  XrdOucString name;
+
+  if (gOFS->MgmMaster.IsMaster() && mAutosave) {
+    // the autosave thread and the config commands both use the file name
+    XrdSysMutexHelper lock(mMutex);
     int aspos = 0;
 
     if ((aspos = mConfigFile.find(".autosave")) != STR_NPOS) {
@@ -537,8 +555,12 @@ FileConfigEngine::AutoSave()
       mConfigFile.erase(aspos);
     }
 
+    name = mConfigFile;
+  }
+
+  if (name.length()) {
     XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
+    envstring += name;
     envstring += "&mgm.config.force=1";
     envstring += "&mgm.config.autosave=1";
     XrdOucEnv env(envstring.c_str());
@@ -611,26 +633,7 @@ FileConfigEngine::SetConfigValue(const char* prefix, const char* key,
   }
 
   if (gOFS->MgmMaster.IsMaster() && mAutosave && mConfigFile.length()) {
-    int aspos = 0;
-
-    if ((aspos = mConfigFile.find(".autosave")) != STR_NPOS) {
-      mConfigFile.erase(aspos);
-    }
-
-    if ((aspos = mConfigFile.find(".backup")) != STR_NPOS) {
-      mConfigFile.erase(aspos);
-    }
-
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    envstring += "&mgm.config.autosave=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+    ScheduleAutoSave();
   }
 }
 
@@ -678,26 +681,7 @@ FileConfigEngine::DeleteConfigValue(const char* prefix, const char* key,
   }
 
   if (gOFS->MgmMaster.IsMaster() && mAutosave && mConfigFile.length()) {
-    int aspos = 0;
-
-    if ((aspos = mConfigFile.find(".autosave")) != STR_NPOS) {
-      mConfigFile.erase(aspos);
-    }
-
-    if ((aspos = mConfigFile.find(".backup")) != STR_NPOS) {
-      mConfigFile.erase(aspos);
-    }
-
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    envstring += "&mgm.config.autosave=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+    ScheduleAutoSave();
   }
 
   eos_static_debug("%s", key);
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// @file FindVisitor.hh
+// @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_FINDVISITOR__HH__
+#define __EOSMGM_FINDVISITOR__HH__
+
+#include "mgm/Namespace.hh"
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Receiver of the entries found by XrdMgmOfs::_find.
+//!
+//! The entries are delivered directory by directory while the walk is still
+//! running. The callbacks are serialized by the walker and are invoked
+//! without holding the namespace lock, so they may take it themselves.
+//------------------------------------------------------------------------------
+class FindVisitor
+{
+public:
+  virtual ~FindVisitor() {}
+
+  //----------------------------------------------------------------------------
+  //! A directory was found
+  //!
+  //! @param path directory path ending with '/'
+  //----------------------------------------------------------------------------
+  virtual void VisitDir(const std::string& path) = 0;
+
+  //----------------------------------------------------------------------------
+  //! The selected files of a directory
+  //!
+  //! @param dir directory path ending with '/'
+  //! @param names sorted file names, symbolic links as "<name> -> <target>"
+  //----------------------------------------------------------------------------
+  virtual void VisitFiles(const std::string& dir,
+                          const std::vector<std::string>& names) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Check if the receiver is no longer interested in further entries, the
+  //! walk is then stopped as soon as possible
+  //----------------------------------------------------------------------------
+  virtual bool Stopped()
+  {
+    return false;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Visitor collecting the whole result in a map of directory => files
+//------------------------------------------------------------------------------
+class FindCollector : public FindVisitor
+{
+public:
+  FindCollector(std::map<std::string, std::set<std::string> >& found) :
+    mFound(found) {}
+
+  virtual void VisitDir(const std::string& path)
+  {
+    mFound[path].size();
+  }
+
+  virtual void VisitFiles(const std::string& dir,
+                          const std::vector<std::string>& names)
+  {
+    mFound[dir].insert(names.begin(), names.end());
+  }
+
+private:
+  std::map<std::string, std::set<std::string> >& mFound;
+};
+
+//------------------------------------------------------------------------------
+//! Visitor forwarding the entries to two functions and optionally asking a
+//! third one if the walk should stop
+//------------------------------------------------------------------------------
+class FindFunctionVisitor : public FindVisitor
+{
+public:
+  typedef std::function<void(const std::string&)> DirFunction;
+  typedef std::function<void(const std::string&,
+                             const std::vector<std::string>&)> FilesFunction;
+  typedef std::function<bool()> StopFunction;
+
+  FindFunctionVisitor(DirFunction dir_func, FilesFunction files_func,
+                      StopFunction stop_func = StopFunction()) :
+    mDirFunc(dir_func), mFilesFunc(files_func), mStopFunc(stop_func) {}
+
+  virtual void VisitDir(const std::string& path)
+  {
+    mDirFunc(path);
+  }
+
+  virtual void VisitFiles(const std::string& dir,
+                          const std::vector<std::string>& names)
+  {
+    mFilesFunc(dir, names);
+  }
+
+  virtual bool Stopped()
+  {
+    return mStopFunc && mStopFunc();
+  }
+
+private:
+  DirFunction mDirFunc;
+  FilesFunction mFilesFunc;
+  StopFunction mStopFunc;
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
@@ -49,6 +49,8 @@ const size_t GeoTreeEngine::gGeoBufferSize = sizeof(FastPlacementTree) + FastPla
 __thread void* GeoTreeEngine::tlGeoBuffer = NULL;
 pthread_key_t GeoTreeEngine::gPthreadKey;
 __thread const FsGroup* GeoTreeEngine::tlCurrentGroup = NULL;
+__thread GeoTreeEngine::IdxArena* GeoTreeEngine::tlIdxArena = NULL;
+pthread_key_t GeoTreeEngine::gArenaPthreadKey;
 
 const int
 GeoTreeEngine::sfgId = 1,
@@ -349,6 +351,8 @@ bool GeoTreeEngine::insertFsIntoGroup(FileSystem *fs ,
 
   mapEntry->fs2SlowTreeNode[fsid] = node;
   mapEntry->slowTreeModified = true;
+  if(pTrace.IsEnabled())
+    traceFsState(group->mName,fsn,node->pNodeState);
 
   // update the fast structures now if requested
   if(updateFastStruct)
@@ -769,55 +773,29 @@ void GeoTreeEngine::printInfo(std::string &info,
   info = ostr.str();
 }
 
-bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNewReplicas,
-    vector<FileSystem::fsid_t> *newReplicas,
-    ino64_t inode,
-    std::vector<std::string> *dataProxys,
-    std::vector<std::string> *firewallEntryPoint,
-    SchedType type,
+void GeoTreeEngine::resolvePlacementIdx(SchedTME *entry, IdxArena *arena,
     vector<FileSystem::fsid_t> *existingReplicas,
     std::vector<std::string> *fsidsgeotags,
-    unsigned long long bookingSize,
-    const std::string &startFromGeoTag,
-    const std::string &clientGeoTag,
-    const size_t &nCollocatedReplicas,
     vector<FileSystem::fsid_t> *excludeFs,
     vector<string> *excludeGeoTags,
-    vector<string> *forceGeoTags)
+    vector<string> *forceGeoTags,
+    vector<SchedTreeBase::tFastTreeIdx> **existingReplicasIdx,
+    vector<SchedTreeBase::tFastTreeIdx> **excludeFsIdx,
+    vector<SchedTreeBase::tFastTreeIdx> **forceBrIdx)
 {
-  assert(nNewReplicas);
-  assert(newReplicas);
-  std::vector<SchedTME*> entries;
-
-  // find the entry in the map
-  tlCurrentGroup = group;
-  SchedTME *entry;
-  {
-    RWMutexReadLock lock(this->pTreeMapMutex);
-    if(!pGroup2SchedTME.count(group))
-    {
-      eos_err("could not find the requested placement group in the map");
-      return false;
-    }
-    entry = pGroup2SchedTME[group];
-    AtomicInc(entry->fastStructLockWaitersCount);
-  }
-
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
+  // a read lock is supposed to be acquired on the fast structures
+  *existingReplicasIdx = *excludeFsIdx = *forceBrIdx = NULL;
 
   // locate the existing replicas and the excluded fs in the tree
-  vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx(nNewReplicas),*existingReplicasIdx=NULL,*excludeFsIdx=NULL,*forceBrIdx=NULL;
-  newReplicasIdx.resize(0);
   if(existingReplicas)
   {
-    existingReplicasIdx = new vector<SchedTreeBase::tFastTreeIdx>(existingReplicas->size());
-    existingReplicasIdx->resize(0);
+    *existingReplicasIdx = &arena->existingReplicasIdx;
+    (*existingReplicasIdx)->clear();
     int count = 0;
     for(auto it = existingReplicas->begin(); it != existingReplicas->end(); ++it , ++count)
     {
       const SchedTreeBase::tFastTreeIdx *idx = static_cast<const SchedTreeBase::tFastTreeIdx*>(0);
-      if(!entry->foregroundFastStruct->fs2TreeIdx->get(*it,idx) && !(*fsidsgeotags)[count].empty())
+      if(!entry->foregroundFastStruct->fs2TreeIdx->get(*it,idx) && fsidsgeotags && !(*fsidsgeotags)[count].empty())
       {
 	// the fs is not in that group.
 	// this could happen because the former file scheduler
@@ -828,8 +806,8 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
 	SchedTreeBase::tFastTreeIdx idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode((*fsidsgeotags)[count].c_str());
 	if(idx && (*entry->foregroundFastStruct->treeInfo)[idx].nodeType == SchedTreeBase::TreeNodeInfo::fs)
 	{
-	  if((std::find(existingReplicasIdx->begin(),existingReplicasIdx->end(),idx) == existingReplicasIdx->end()))
-	  existingReplicasIdx->push_back(idx);
+	  if((std::find((*existingReplicasIdx)->begin(),(*existingReplicasIdx)->end(),idx) == (*existingReplicasIdx)->end()))
+	  (*existingReplicasIdx)->push_back(idx);
 	}
 	// if we can't find any such filesystem, the information is not taken into account
 	// (and then can lead to unoptimal placement
@@ -839,13 +817,18 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
 	}
 	continue;
       }
-      existingReplicasIdx->push_back(*idx);
+      if(!idx)
+      {
+	eos_debug("could not place preexisting replica on the fast tree");
+	continue;
+      }
+      (*existingReplicasIdx)->push_back(*idx);
     }
   }
   if(excludeFs)
   {
-    excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeFs->size());
-    excludeFsIdx->resize(0);
+    *excludeFsIdx = &arena->excludeFsIdx;
+    (*excludeFsIdx)->clear();
     for(auto it = excludeFs->begin(); it != excludeFs->end(); ++it)
     {
       const SchedTreeBase::tFastTreeIdx *idx;
@@ -856,35 +839,47 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
 	// eos_warning("could not place excluded fs on the fast tree");
 	continue;
       }
-      excludeFsIdx->push_back(*idx);
+      (*excludeFsIdx)->push_back(*idx);
     }
   }
   if(excludeGeoTags)
   {
-    if(!excludeFsIdx)
+    if(!*excludeFsIdx)
     {
-      excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeGeoTags->size());
-      excludeFsIdx->resize(0);
+      *excludeFsIdx = &arena->excludeFsIdx;
+      (*excludeFsIdx)->clear();
     }
     for(auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it)
     {
       SchedTreeBase::tFastTreeIdx idx;
       idx=entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(it->c_str());
-      excludeFsIdx->push_back(idx);
+      (*excludeFsIdx)->push_back(idx);
     }
   }
   if(forceGeoTags)
   {
-    forceBrIdx = new vector<SchedTreeBase::tFastTreeIdx>(forceGeoTags->size());
-    excludeFsIdx->resize(0);
+    *forceBrIdx = &arena->forceBrIdx;
+    (*forceBrIdx)->clear();
     for(auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it)
     {
       SchedTreeBase::tFastTreeIdx idx;
       idx=entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(it->c_str());
-      forceBrIdx->push_back(idx);
+      (*forceBrIdx)->push_back(idx);
     }
   }
+}
 
+bool GeoTreeEngine::placeResolved(SchedTME *entry, SchedType type, const size_t &nNewReplicas,
+    vector<SchedTreeBase::tFastTreeIdx> *newReplicasIdx,
+    vector<FileSystem::fsid_t> *newReplicas,
+    vector<SchedTreeBase::tFastTreeIdx> *existingReplicasIdx,
+    unsigned long long bookingSize,
+    const std::string &startFromGeoTag,
+    const size_t &nCollocatedReplicas,
+    vector<SchedTreeBase::tFastTreeIdx> *excludeFsIdx,
+    vector<SchedTreeBase::tFastTreeIdx> *forceBrIdx)
+{
+  // a read lock is supposed to be acquired on the fast structures
   SchedTreeBase::tFastTreeIdx startFromNode=0;
   if(!startFromGeoTag.empty())
   {
@@ -893,30 +888,31 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
 
   // actually do the job
   bool success = false;
+  newReplicasIdx->clear();
   switch(type)
   {
     case regularRO:
     case regularRW:
-    success = placeNewReplicas(entry,nNewReplicas,&newReplicasIdx,entry->foregroundFastStruct->placementTree,
+    success = placeNewReplicas(entry,nNewReplicas,newReplicasIdx,entry->foregroundFastStruct->placementTree,
 	existingReplicasIdx,bookingSize,startFromNode,nCollocatedReplicas,excludeFsIdx,forceBrIdx,pSkipSaturatedPlct);
     break;
     case draining:
-    success = placeNewReplicas(entry,nNewReplicas,&newReplicasIdx,entry->foregroundFastStruct->drnPlacementTree,
+    success = placeNewReplicas(entry,nNewReplicas,newReplicasIdx,entry->foregroundFastStruct->drnPlacementTree,
 	existingReplicasIdx,bookingSize,startFromNode,nCollocatedReplicas,excludeFsIdx,forceBrIdx,pSkipSaturatedDrnPlct);
     break;
     case balancing:
-    success = placeNewReplicas(entry,nNewReplicas,&newReplicasIdx,entry->foregroundFastStruct->blcPlacementTree,
+    success = placeNewReplicas(entry,nNewReplicas,newReplicasIdx,entry->foregroundFastStruct->blcPlacementTree,
 	existingReplicasIdx,bookingSize,startFromNode,nCollocatedReplicas,excludeFsIdx,forceBrIdx,pSkipSaturatedBlcPlct);
     break;
     default:
     ;
   }
-  if(!success) goto cleanup;
+  if(!success) return false;
 
   // fill the resulting vector and
   // update the fastTree UlScore and DlScore by applying the penalties
   newReplicas->resize(0);
-  for(auto it = newReplicasIdx.begin(); it != newReplicasIdx.end(); ++it)
+  for(auto it = newReplicasIdx->begin(); it != newReplicasIdx->end(); ++it)
   {
     const SchedTreeBase::tFastTreeIdx *idx=NULL;
     const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
@@ -929,6 +925,57 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
     if(entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore>0)
     applyUlScorePenalty(entry,*idx,pPenaltySched.pPlctUlScorePenalty[netSpeedClass]);
   }
+  return true;
+}
+
+bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNewReplicas,
+    vector<FileSystem::fsid_t> *newReplicas,
+    ino64_t inode,
+    std::vector<std::string> *dataProxys,
+    std::vector<std::string> *firewallEntryPoint,
+    SchedType type,
+    vector<FileSystem::fsid_t> *existingReplicas,
+    std::vector<std::string> *fsidsgeotags,
+    unsigned long long bookingSize,
+    const std::string &startFromGeoTag,
+    const std::string &clientGeoTag,
+    const size_t &nCollocatedReplicas,
+    vector<FileSystem::fsid_t> *excludeFs,
+    vector<string> *excludeGeoTags,
+    vector<string> *forceGeoTags)
+{
+  assert(nNewReplicas);
+  assert(newReplicas);
+  std::vector<SchedTME*> entries;
+  uint64_t traceStartUs = pTrace.IsEnabled()?SchedulingTraceWriter::Now():0;
+
+  // find the entry in the map
+  tlCurrentGroup = group;
+  SchedTME *entry;
+  {
+    RWMutexReadLock lock(this->pTreeMapMutex);
+    if(!pGroup2SchedTME.count(group))
+    {
+      eos_err("could not find the requested placement group in the map");
+      return false;
+    }
+    entry = pGroup2SchedTME[group];
+    AtomicInc(entry->fastStructLockWaitersCount);
+  }
+
+  // readlock the original fast structure
+  entry->doubleBufferMutex.LockRead();
+
+  // locate the existing replicas and the excluded fs in the tree
+  IdxArena *arena = tlGetArena();
+  vector<SchedTreeBase::tFastTreeIdx> &newReplicasIdx = arena->newReplicasIdx,*existingReplicasIdx=NULL,*excludeFsIdx=NULL,*forceBrIdx=NULL;
+  resolvePlacementIdx(entry,arena,existingReplicas,fsidsgeotags,excludeFs,excludeGeoTags,forceGeoTags,
+      &existingReplicasIdx,&excludeFsIdx,&forceBrIdx);
+
+  // actually do the job
+  bool success = placeResolved(entry,type,nNewReplicas,&newReplicasIdx,newReplicas,existingReplicasIdx,
+      bookingSize,startFromGeoTag,nCollocatedReplicas,excludeFsIdx,forceBrIdx);
+  if(!success) goto cleanup;
 
   if(dataProxys || firewallEntryPoint )
     entries.assign(newReplicasIdx.size(),entry);
@@ -985,15 +1032,69 @@ bool GeoTreeEngine::placeNewReplicasOneGroup( FsGroup* group, const size_t &nNew
   // unlock, cleanup
   cleanup:
   if(!success) newReplicas->clear();
+  if(traceStartUs)
+    tracePlacement(entry,type,nNewReplicas,existingReplicas,excludeFs,bookingSize,startFromGeoTag,newReplicas,success,traceStartUs);
   entry->doubleBufferMutex.UnLockRead();
   AtomicDec(entry->fastStructLockWaitersCount);
-  if(existingReplicasIdx) delete existingReplicasIdx;
-  if(excludeFsIdx) delete excludeFsIdx;
-  if(forceBrIdx) delete forceBrIdx;
 
   return success;
 }
 
+size_t GeoTreeEngine::placeNewReplicasOneGroupBatch(FsGroup* group,
+    std::vector<PlacementRequest> &requests,
+    SchedType type)
+{
+  size_t nPlaced = 0;
+  for(auto it = requests.begin(); it != requests.end(); ++it)
+  {
+    it->newReplicas.clear();
+    it->success = false;
+  }
+  if(requests.empty()) return 0;
+
+  // find the entry in the map
+  tlCurrentGroup = group;
+  SchedTME *entry;
+  {
+    RWMutexReadLock lock(this->pTreeMapMutex);
+    if(!pGroup2SchedTME.count(group))
+    {
+      eos_err("could not find the requested placement group in the map");
+      return 0;
+    }
+    entry = pGroup2SchedTME[group];
+    AtomicInc(entry->fastStructLockWaitersCount);
+  }
+
+  // readlock the original fast structure once for the whole batch
+  entry->doubleBufferMutex.LockRead();
+
+  IdxArena *arena = tlGetArena();
+  for(auto it = requests.begin(); it != requests.end(); ++it)
+  {
+    if(!it->nNewReplicas) continue;
+    uint64_t traceStartUs = pTrace.IsEnabled()?SchedulingTraceWriter::Now():0;
+    vector<SchedTreeBase::tFastTreeIdx> *existingReplicasIdx=NULL,*excludeFsIdx=NULL,*forceBrIdx=NULL;
+    resolvePlacementIdx(entry,arena,it->existingReplicas,it->fsidsgeotags,it->excludeFs,it->excludeGeoTags,it->forceGeoTags,
+	&existingReplicasIdx,&excludeFsIdx,&forceBrIdx);
+    // the penalties of the previous placements are already applied
+    // to the fast structure the next working copy is made from
+    it->success = placeResolved(entry,type,it->nNewReplicas,&arena->newReplicasIdx,&it->newReplicas,existingReplicasIdx,
+	it->bookingSize,it->startFromGeoTag,it->nCollocatedReplicas,excludeFsIdx,forceBrIdx);
+    if(it->success) nPlaced++;
+    else it->newReplicas.clear();
+    if(traceStartUs)
+      tracePlacement(entry,type,it->nNewReplicas,it->existingReplicas,it->excludeFs,it->bookingSize,
+	  it->startFromGeoTag,&it->newReplicas,it->success,traceStartUs);
+  }
+
+  entry->doubleBufferMutex.UnLockRead();
+  AtomicDec(entry->fastStructLockWaitersCount);
+
+  eos_debug("placed %lu files out of %lu in one batch",(unsigned long)nPlaced,(unsigned long)requests.size());
+  return nPlaced;
+}
+
 // would be better as defined locally in find Proxy
 // but it is not supported by gcc 4.4
 struct TreeInfoFsIdComparator
@@ -1296,12 +1397,13 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group, const size_t &nAccess
   entry->doubleBufferMutex.LockRead();
 
   // locate the existing replicas and the excluded fs in the tree
-  vector<SchedTreeBase::tFastTreeIdx> accessedReplicasIdx(nAccessReplicas),*existingReplicasIdx=NULL,*excludeFsIdx=NULL,*forceBrIdx=NULL;
-  accessedReplicasIdx.resize(0);
+  IdxArena *arena = tlGetArena();
+  vector<SchedTreeBase::tFastTreeIdx> &accessedReplicasIdx = arena->newReplicasIdx,*existingReplicasIdx=NULL,*excludeFsIdx=NULL,*forceBrIdx=NULL;
+  accessedReplicasIdx.clear();
   if(existingReplicas)
   {
-    existingReplicasIdx = new vector<SchedTreeBase::tFastTreeIdx>(existingReplicas->size());
-    existingReplicasIdx->resize(0);
+    existingReplicasIdx = &arena->existingReplicasIdx;
+    existingReplicasIdx->clear();
     for(auto it = existingReplicas->begin(); it != existingReplicas->end(); ++it)
     {
       const SchedTreeBase::tFastTreeIdx *idx;
@@ -1315,8 +1417,8 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group, const size_t &nAccess
   }
   if(excludeFs)
   {
-    excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeFs->size());
-    excludeFsIdx->resize(0);
+    excludeFsIdx = &arena->excludeFsIdx;
+    excludeFsIdx->clear();
     for(auto it = excludeFs->begin(); it != excludeFs->end(); ++it)
     {
       const SchedTreeBase::tFastTreeIdx *idx;
@@ -1332,8 +1434,8 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group, const size_t &nAccess
   {
     if(!excludeFsIdx)
     {
-      excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeGeoTags->size());
-      excludeFsIdx->resize(0);
+      excludeFsIdx = &arena->excludeFsIdx;
+      excludeFsIdx->clear();
     }
     for(auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it)
     {
@@ -1344,8 +1446,8 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group, const size_t &nAccess
   }
   if(forceGeoTags)
   {
-    forceBrIdx = new vector<SchedTreeBase::tFastTreeIdx>(forceGeoTags->size());
-    excludeFsIdx->resize(0);
+    forceBrIdx = &arena->forceBrIdx;
+    forceBrIdx->clear();
     for(auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it)
     {
       SchedTreeBase::tFastTreeIdx idx;
@@ -1408,13 +1510,43 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group, const size_t &nAccess
   cleanup:
   entry->doubleBufferMutex.UnLockRead();
   AtomicDec(entry->fastStructLockWaitersCount);
-  if(existingReplicasIdx) delete existingReplicasIdx;
-  if(excludeFsIdx) delete excludeFsIdx;
-  if(forceBrIdx) delete forceBrIdx;
 
   return success;
 }
 
+void GeoTreeEngine::lockAccessEntries(const std::vector<eos::common::FileSystem::fsid_t> &fsids,
+    std::vector<SchedTME*> &locked)
+{
+  // lock the scheduling group -> trees map so that the a map entry cannot be delete while processing it
+  RWMutexReadLock lock(this->pTreeMapMutex);
+  for(auto it = fsids.begin(); it != fsids.end(); it++)
+  {
+    auto mentry = pFs2SchedTME.find(*it);
+    // if we cannot find the fs in any group, it is reported by the access itself
+    if(mentry == pFs2SchedTME.end())
+    continue;
+    SchedTME *entry = mentry->second;
+    // if the entry is already there, it was locked already
+    if(std::find(locked.begin(),locked.end(),entry) != locked.end())
+    continue;
+    // lock the double buffering to make sure all the fast trees are not modified
+    entry->doubleBufferMutex.LockRead();
+    // to prevent the destruction of the entry
+    AtomicInc(entry->fastStructLockWaitersCount);
+    locked.push_back(entry);
+  }
+}
+
+void GeoTreeEngine::unlockAccessEntries(std::vector<SchedTME*> &locked)
+{
+  for(auto it = locked.begin(); it != locked.end(); it++ )
+  {
+    (*it)->doubleBufferMutex.UnLockRead();
+    AtomicDec((*it)->fastStructLockWaitersCount);
+  }
+  locked.clear();
+}
+
 int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t &nAccessReplicas,
     unsigned long &fsIndex,
     std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
@@ -1427,6 +1559,66 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t &nAccessReplicas,
     std::vector<eos::common::FileSystem::fsid_t> *unavailableFs,
     bool noIO
 )
+{
+  assert(existingReplicas);
+  uint64_t traceStartUs = pTrace.IsEnabled()?SchedulingTraceWriter::Now():0;
+  std::vector<SchedTME*> locked;
+  lockAccessEntries(*existingReplicas,locked);
+  int returnCode = accessHeadReplicaLocked(locked,nAccessReplicas,fsIndex,existingReplicas,inode,
+      dataProxys,firewallEntryPoint,type,accesserGeotag,forcedFsId,unavailableFs,noIO);
+  unlockAccessEntries(locked);
+  if(traceStartUs)
+    traceAccess(type,nAccessReplicas,existingReplicas,accesserGeotag,fsIndex,returnCode,traceStartUs);
+  return returnCode;
+}
+
+size_t GeoTreeEngine::accessHeadReplicaMultipleGroupBatch(std::vector<AccessRequest> &requests,
+    SchedType type,
+    const std::string &accesserGeotag,
+    bool noIO)
+{
+  size_t nAccessed = 0;
+  std::vector<SchedTME*> locked;
+
+  // lock all the scheduling groups involved once for the whole batch
+  for(auto it = requests.begin(); it != requests.end(); ++it)
+  {
+    it->fsIndex = 0;
+    it->retCode = ENODATA;
+    if(it->existingReplicas)
+    lockAccessEntries(*it->existingReplicas,locked);
+  }
+
+  for(auto it = requests.begin(); it != requests.end(); ++it)
+  {
+    if(!it->existingReplicas || !it->nReplicas) continue;
+    uint64_t traceStartUs = pTrace.IsEnabled()?SchedulingTraceWriter::Now():0;
+    it->retCode = accessHeadReplicaLocked(locked,it->nReplicas,it->fsIndex,it->existingReplicas,0,
+	NULL,NULL,type,accesserGeotag,it->forcedFsId,&it->unavailableFs,noIO);
+    if(!it->retCode) nAccessed++;
+    if(traceStartUs)
+      traceAccess(type,it->nReplicas,it->existingReplicas,accesserGeotag,it->fsIndex,it->retCode,traceStartUs);
+  }
+
+  unlockAccessEntries(locked);
+
+  eos_debug("accessed %lu files out of %lu in one batch",(unsigned long)nAccessed,(unsigned long)requests.size());
+  return nAccessed;
+}
+
+int GeoTreeEngine::accessHeadReplicaLocked(const std::vector<SchedTME*> &locked,
+    const size_t &nAccessReplicas,
+    unsigned long &fsIndex,
+    std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
+    ino64_t inode,
+    std::vector<std::string> *dataProxys,
+    std::vector<std::string> *firewallEntryPoint,
+    SchedType type,
+    const std::string &accesserGeotag,
+    const eos::common::FileSystem::fsid_t &forcedFsId,
+    std::vector<eos::common::FileSystem::fsid_t> *unavailableFs,
+    bool noIO
+)
 {
   int returnCode = ENODATA;
 
@@ -1476,24 +1668,17 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t &nAccessReplicas,
       }
       entry = mentry->second;
 
-      // lock the double buffering to make sure all the fast trees are not modified
-      if(!entry2FsId.count(entry))
+      // the double buffering must have been locked by the caller to make sure all the fast trees are not modified
+      if(std::find(locked.begin(),locked.end(),entry) == locked.end())
       {
-	// if the entry is already there, it was locked already
-	entry->doubleBufferMutex.LockRead();
-	// to prevent the destruction of the entry
-	AtomicInc(entry->fastStructLockWaitersCount);
+	eos_warning("the scheduling group of the existing replica is not locked");
+	continue;
       }
 
       const SchedTreeBase::tFastTreeIdx *idx;
       if(!entry->foregroundFastStruct->fs2TreeIdx->get(*exrepIt,idx) )
       {
 	eos_warning("cannot find fs in the scheduling group in the 2nd pass");
-	if(!entry2FsId.count(entry))
-	{
-	  entry->doubleBufferMutex.UnLockRead();
-	  AtomicDec(entry->fastStructLockWaitersCount);
-	}
 	continue;
       }
       // take the fastindex of each existing replica
@@ -1766,11 +1951,6 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t &nAccessReplicas,
 
   // cleanup and exit
   cleanup:
-  for(auto cit = entry2FsId.begin(); cit != entry2FsId.end(); cit++ )
-  {
-    cit->first->doubleBufferMutex.UnLockRead();
-    AtomicDec(cit->first->fastStructLockWaitersCount);
-  }
   return returnCode;
 }
 
@@ -2621,6 +2801,22 @@ bool GeoTreeEngine::updateTreeInfo(const map<string,int> &updatesFs, const map<s
     updateTreeInfo(entry, &fs, it->second, idx?*idx:0 , node);
     if(idx) entry->fastStructModified = true;
     if(node) entry->slowTreeModified = true;
+    if(pTrace.IsEnabled())
+    {
+      SchedTreeBase::TreeNodeStateFloat state;
+      if(idx)
+      {
+        const FastPlacementTree::FsData &fastState = entry->backgroundFastStruct->placementTree->pNodes[*idx].fsData;
+        state.mStatus = fastState.mStatus;
+        state.ulScore = fastState.ulScore;
+        state.dlScore = fastState.dlScore;
+        state.totalSpace = fastState.totalSpace;
+        state.fillRatio = fastState.fillRatio;
+      }
+      else
+        state = node->pNodeState;
+      traceFsState(entry->group?entry->group->mName:"",fs,state);
+    }
     // if we update the slowtree, then a fast tree generation is already pending
     entry->doubleBufferMutex.UnLockRead();
     AtomicDec(entry->fastStructLockWaitersCount);
@@ -4094,6 +4290,190 @@ char* GeoTreeEngine::tlAlloc( size_t size)
   return buf;
 }
 
+void GeoTreeEngine::traceFsState(const std::string &group, const FileSystem::fs_snapshot_t &fs,
+    const SchedTreeBase::TreeNodeStateFloat &state)
+{
+  SchedulingTraceRecord rec;
+  rec.type = SchedulingTraceRecord::kFsState;
+  rec.timeUs = SchedulingTraceWriter::Now();
+  rec.fsId = fs.mId;
+  rec.group = group;
+  rec.geotag = fs.mGeoTag.empty()?std::string("nogeotag"):fs.mGeoTag;
+  rec.host = fs.mHost;
+  rec.status = state.mStatus;
+  rec.ulScore = state.ulScore;
+  rec.dlScore = state.dlScore;
+  rec.totalSpace = state.totalSpace;
+  rec.fillRatio = state.fillRatio;
+  pTrace.Write(rec);
+}
+
+void GeoTreeEngine::tracePlacement(SchedTME *entry, SchedType type, const size_t &nNewReplicas,
+    const vector<FileSystem::fsid_t> *existingReplicas,
+    const vector<FileSystem::fsid_t> *excludeFs,
+    unsigned long long bookingSize, const std::string &startFromGeoTag,
+    const vector<FileSystem::fsid_t> *newReplicas,
+    bool success, uint64_t startUs)
+{
+  SchedulingTraceRecord rec;
+  rec.type = SchedulingTraceRecord::kPlacement;
+  rec.timeUs = SchedulingTraceWriter::Now();
+  rec.latencyUs = (uint32_t)(rec.timeUs - startUs);
+  rec.group = entry->group?entry->group->mName:"";
+  rec.schedType = (uint8_t)type;
+  rec.nReplicas = nNewReplicas;
+  if(existingReplicas) rec.existingReplicas.assign(existingReplicas->begin(),existingReplicas->end());
+  if(excludeFs) rec.excludeFs.assign(excludeFs->begin(),excludeFs->end());
+  rec.bookingSize = bookingSize;
+  rec.clientGeotag = startFromGeoTag;
+  if(success && newReplicas) rec.result.assign(newReplicas->begin(),newReplicas->end());
+  rec.retCode = success?1:0;
+  pTrace.Write(rec);
+}
+
+void GeoTreeEngine::traceAccess(SchedType type, const size_t &nReplicas,
+    const vector<FileSystem::fsid_t> *existingReplicas,
+    const std::string &accesserGeotag, unsigned long fsIndex,
+    int retCode, uint64_t startUs)
+{
+  SchedulingTraceRecord rec;
+  rec.type = SchedulingTraceRecord::kAccess;
+  rec.timeUs = SchedulingTraceWriter::Now();
+  rec.latencyUs = (uint32_t)(rec.timeUs - startUs);
+  rec.schedType = (uint8_t)type;
+  rec.nReplicas = nReplicas;
+  rec.existingReplicas.assign(existingReplicas->begin(),existingReplicas->end());
+  rec.clientGeotag = accesserGeotag;
+  if(!retCode && fsIndex < existingReplicas->size())
+    rec.result.push_back((*existingReplicas)[fsIndex]);
+  rec.retCode = retCode;
+  pTrace.Write(rec);
+}
+
+int GeoTreeEngine::startTrace(const std::string &name, XrdOucString *output)
+{
+  std::string path;
+  if(!SchedulingTraceWriter::BuildPath(EOS_GEOSCHED_TRACE_DIR,name,path))
+  {
+    if(output) *output += ("error: invalid trace file name " + name + ", expecting a plain file name\n").c_str();
+    eos_err("invalid scheduling trace file name %s",name.c_str());
+    return EINVAL;
+  }
+  // the trace directory is only accessible to the MGM
+  if(mkdir(EOS_GEOSCHED_TRACE_DIR,S_IRWXU) && (errno != EEXIST))
+    eos_err("could not create the scheduling trace directory %s errno=%d",EOS_GEOSCHED_TRACE_DIR,errno);
+  int retc = pTrace.Open(path);
+  if(retc)
+  {
+    if(output) *output += ("error: could not create the trace file " + path + " : " + strerror(retc) + "\n").c_str();
+    eos_err("could not create the scheduling trace file %s errno=%d",path.c_str(),retc);
+    return retc;
+  }
+  if(output) *output += ("GeoTreeEngine is tracing to " + path + "\n").c_str();
+  eos_notice("started scheduling trace to %s",path.c_str());
+  return 0;
+}
+
+void GeoTreeEngine::stopTrace(XrdOucString *output)
+{
+  std::string path;
+  unsigned long long records = 0;
+  pTrace.GetStatus(path,records);
+  pTrace.Close();
+  if(output)
+  {
+    char line[4096];
+    if(path.empty())
+      snprintf(line,sizeof(line),"GeoTreeEngine was not tracing\n");
+    else
+      snprintf(line,sizeof(line),"GeoTreeEngine stopped tracing to %s after %llu records\n",path.c_str(),records);
+    *output += line;
+  }
+  eos_notice("stopped scheduling trace to %s after %llu records",path.c_str(),records);
+}
+
+void GeoTreeEngine::showTrace(XrdOucString *output)
+{
+  std::string path;
+  unsigned long long records = 0;
+  pTrace.GetStatus(path,records);
+  char line[4096];
+  if(path.empty())
+    snprintf(line,sizeof(line),"trace=off\n");
+  else
+    snprintf(line,sizeof(line),"trace=on file=%s records=%llu\n",path.c_str(),records);
+  *output += line;
+}
+
+int GeoTreeEngine::benchPlacement(const std::string &group, size_t nFiles, size_t nReplicas, XrdOucString *output)
+{
+  if(!nFiles || !nReplicas)
+  {
+    *output += "error: the number of files and replicas must be positive\n";
+    return EINVAL;
+  }
+
+  // the fs view is locked as for the placements done by the Scheduler
+  RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
+  auto git = FsView::gFsView.mGroupView.find(group);
+  if(git == FsView::gFsView.mGroupView.end())
+  {
+    *output += ("error: unknown scheduling group " + group + "\n").c_str();
+    return ENOENT;
+  }
+  FsGroup *fsgroup = git->second;
+
+  // one file at a time
+  std::vector<FileSystem::fsid_t> newReplicas;
+  size_t nSingle = 0;
+  uint64_t startUs = SchedulingTraceWriter::Now();
+  for(size_t i = 0; i < nFiles; i++)
+  {
+    newReplicas.clear();
+    if(placeNewReplicasOneGroup(fsgroup,nReplicas,&newReplicas,0,NULL,NULL,regularRW,NULL))
+      nSingle++;
+  }
+  uint64_t singleUs = SchedulingTraceWriter::Now() - startUs;
+
+  // all the files in one batch
+  std::vector<PlacementRequest> requests(nFiles);
+  for(auto it = requests.begin(); it != requests.end(); ++it)
+    it->nNewReplicas = nReplicas;
+  startUs = SchedulingTraceWriter::Now();
+  size_t nBatch = placeNewReplicasOneGroupBatch(fsgroup,requests,regularRW);
+  uint64_t batchUs = SchedulingTraceWriter::Now() - startUs;
+
+  char line[4096];
+  snprintf(line,sizeof(line),"group=%s files=%lu replicas=%lu\n",group.c_str(),(unsigned long)nFiles,(unsigned long)nReplicas);
+  *output += line;
+  snprintf(line,sizeof(line),"single : placed=%lu elapsed=%.3f ms speed=%.0f files/sec\n",(unsigned long)nSingle,
+      singleUs/1e3,singleUs?nFiles*1e6/singleUs:0.0);
+  *output += line;
+  snprintf(line,sizeof(line),"batch  : placed=%lu elapsed=%.3f ms speed=%.0f files/sec\n",(unsigned long)nBatch,
+      batchUs/1e3,batchUs?nFiles*1e6/batchUs:0.0);
+  *output += line;
+  return 0;
+}
+
+void GeoTreeEngine::tlArenaFree( void *arg)
+{
+  eos_static_debug("destroying thread specific index arena");
+  delete (IdxArena*)arg;
+}
+
+GeoTreeEngine::IdxArena* GeoTreeEngine::tlGetArena()
+{
+  // allocate the arena only once for the lifetime of the thread
+  if(!tlIdxArena)
+  {
+    eos_static_debug("allocating thread specific index arena");
+    tlIdxArena = new IdxArena;
+    if(pthread_setspecific(gArenaPthreadKey, tlIdxArena))
+      eos_static_crit("error registering thread-local index arena located at %p for cleaning up : memory will be leaked when thread is terminated",tlIdxArena);
+  }
+  return tlIdxArena;
+}
+
 
 EOSMGMNAMESPACE_END
 
@@ -31,6 +31,7 @@
 /*----------------------------------------------------------------------------*/
 #include "mgm/FsView.hh"
 #include "mgm/geotree/SchedulingSlowTree.hh"
+#include "mgm/geotree/SchedulingTrace.hh"
 #include "common/Timing.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
@@ -1106,6 +1107,22 @@ protected:
   static pthread_key_t gPthreadKey;
   /// Current scheduling group for the current thread
   static __thread const FsGroup* tlCurrentGroup;
+  /// Reusable per-thread vectors holding the fast tree indices of the
+  /// constraints of a scheduling operation (avoids heap allocations per file)
+  struct IdxArena
+  {
+    std::vector<SchedTreeBase::tFastTreeIdx> existingReplicasIdx;
+    std::vector<SchedTreeBase::tFastTreeIdx> excludeFsIdx;
+    std::vector<SchedTreeBase::tFastTreeIdx> forceBrIdx;
+    std::vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx;
+  };
+  static __thread IdxArena* tlIdxArena;
+  static pthread_key_t gArenaPthreadKey;
+  //
+  // => scheduling trace
+  //
+  /// Binary trace of the fs states, placements and accesses (see SchedulingTrace.hh)
+  SchedulingTraceWriter pTrace;
   //
   // => penalties system
   //
@@ -1231,6 +1248,86 @@ protected:
   /// thread-local buffer management
   static void tlFree( void *arg);
   static char* tlAlloc( size_t size);
+  static void tlArenaFree( void *arg);
+  static IdxArena* tlGetArena();
+
+  /// scheduling trace recording, to be called only if pTrace.IsEnabled()
+  void traceFsState(const std::string &group, const eos::common::FileSystem::fs_snapshot_t &fs,
+      const SchedTreeBase::TreeNodeStateFloat &state);
+  void tracePlacement(SchedTME *entry, SchedType type, const size_t &nNewReplicas,
+      const std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
+      const std::vector<eos::common::FileSystem::fsid_t> *excludeFs,
+      unsigned long long bookingSize, const std::string &startFromGeoTag,
+      const std::vector<eos::common::FileSystem::fsid_t> *newReplicas,
+      bool success, uint64_t startUs);
+  void traceAccess(SchedType type, const size_t &nReplicas,
+      const std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
+      const std::string &accesserGeotag, unsigned long fsIndex,
+      int retCode, uint64_t startUs);
+
+  // ---------------------------------------------------------------------------
+  //! Translate the fsids and geotags constraints of a placement into fast tree
+  //! indices stored in the thread local arena.
+  //! A read lock is supposed to be acquired on the fast structures of entry.
+  // @return
+  //   for each constraint, a pointer to the arena vector or NULL if the
+  //   constraint is not given
+  // ---------------------------------------------------------------------------
+  void resolvePlacementIdx(SchedTME *entry, IdxArena *arena,
+      std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
+      std::vector<std::string> *fsidsgeotags,
+      std::vector<eos::common::FileSystem::fsid_t> *excludeFs,
+      std::vector<std::string> *excludeGeoTags,
+      std::vector<std::string> *forceGeoTags,
+      std::vector<SchedTreeBase::tFastTreeIdx> **existingReplicasIdx,
+      std::vector<SchedTreeBase::tFastTreeIdx> **excludeFsIdx,
+      std::vector<SchedTreeBase::tFastTreeIdx> **forceBrIdx);
+
+  // ---------------------------------------------------------------------------
+  //! Run the placement on the tree matching the scheduling type, translate the
+  //! result back to fsids and apply the placement penalties.
+  //! A read lock is supposed to be acquired on the fast structures of entry.
+  // ---------------------------------------------------------------------------
+  bool placeResolved(SchedTME *entry, SchedType type, const size_t &nNewReplicas,
+      std::vector<SchedTreeBase::tFastTreeIdx> *newReplicasIdx,
+      std::vector<eos::common::FileSystem::fsid_t> *newReplicas,
+      std::vector<SchedTreeBase::tFastTreeIdx> *existingReplicasIdx,
+      unsigned long long bookingSize,
+      const std::string &startFromGeoTag,
+      const size_t &nCollocatedReplicas,
+      std::vector<SchedTreeBase::tFastTreeIdx> *excludeFsIdx,
+      std::vector<SchedTreeBase::tFastTreeIdx> *forceBrIdx);
+
+  // ---------------------------------------------------------------------------
+  //! Read lock the fast structures of all the scheduling groups holding
+  //! at least one of the given fsids. Already locked entries are not locked
+  //! twice.
+  // ---------------------------------------------------------------------------
+  void lockAccessEntries(const std::vector<eos::common::FileSystem::fsid_t> &fsids,
+      std::vector<SchedTME*> &locked);
+
+  // ---------------------------------------------------------------------------
+  //! Release the locks taken by lockAccessEntries
+  // ---------------------------------------------------------------------------
+  void unlockAccessEntries(std::vector<SchedTME*> &locked);
+
+  // ---------------------------------------------------------------------------
+  //! Body of accessHeadReplicaMultipleGroup. The fast structures of the
+  //! scheduling groups holding the existing replicas are supposed to be read
+  //! locked by the caller and listed in locked.
+  // ---------------------------------------------------------------------------
+  int accessHeadReplicaLocked(const std::vector<SchedTME*> &locked,
+      const size_t &nReplicas,
+      unsigned long &fsIndex,
+      std::vector<eos::common::FileSystem::fsid_t> *existingReplicas,
+      ino64_t inode,
+      std::vector<std::string> *dataProxys,
+      std::vector<std::string> *firewallEntryPoints,
+      SchedType type,
+      const std::string &accesserGeotag,
+      const eos::common::FileSystem::fsid_t &forcedFsId,
+      std::vector<eos::common::FileSystem::fsid_t> *unavailableFs,
+      bool noIO);
 
   inline void applyDlScorePenalty(SchedTME *entry, const SchedTreeBase::tFastTreeIdx &idx, const char &penalty, bool background=false)
   {
@@ -1717,6 +1814,10 @@ public:
       it->reserve(100);
     // create the thread local key to handle allocation/destruction of thread local geobuffers
     pthread_key_create(&gPthreadKey, GeoTreeEngine::tlFree);
+    pthread_key_create(&gArenaPthreadKey, GeoTreeEngine::tlArenaFree);
+    // record a scheduling trace from the start if requested
+    if(getenv("EOS_MGM_GEOTREE_TRACE"))
+      startTrace(getenv("EOS_MGM_GEOTREE_TRACE"),NULL);
     // initialize pauser semaphore
     if(sem_init(&gUpdaterPauseSem, 0, 1)) { throw "sem_init() failed";}
 #ifdef EOS_GEOTREEENGINE_USE_INSTRUMENTED_MUTEX
@@ -1747,6 +1848,47 @@ public:
   // ---------------------------------------------------------------------------
   bool forceRefresh();
 
+  // ---------------------------------------------------------------------------
+  //! Start recording a scheduling trace
+  // @param name
+  //   name of the trace file to create in EOS_GEOSCHED_TRACE_DIR, it must
+  //   not exist yet
+  // @param output
+  //   message for the user
+  // @return
+  //   0 if success, EINVAL for an invalid name or the errno of the creation
+  // ---------------------------------------------------------------------------
+  int startTrace(const std::string &name, XrdOucString *output);
+
+  // ---------------------------------------------------------------------------
+  //! Stop recording the scheduling trace
+  // ---------------------------------------------------------------------------
+  void stopTrace(XrdOucString *output);
+
+  // ---------------------------------------------------------------------------
+  //! Show the status of the scheduling trace
+  // ---------------------------------------------------------------------------
+  void showTrace(XrdOucString *output);
+
+  // ---------------------------------------------------------------------------
+  //! Compare the placement of files one by one and in one batch
+  //! The files are placed twice in the given scheduling group, first with
+  //! placeNewReplicasOneGroup and then with placeNewReplicasOneGroupBatch.
+  //! Nothing is booked but the penalties of the placements are applied as
+  //! for real ones.
+  // @param group
+  //   name of the scheduling group
+  // @param nFiles
+  //   number of files to place
+  // @param nReplicas
+  //   number of replicas of each file
+  // @param output
+  //   timings for the user
+  // @return
+  //   0 if success, ENOENT if the group is unknown, EINVAL if nothing to place
+  // ---------------------------------------------------------------------------
+  int benchPlacement(const std::string &group, size_t nFiles, size_t nReplicas, XrdOucString *output);
+
   // ---------------------------------------------------------------------------
   //! Insert a file system into the GeoTreeEngine
   // @param fs
@@ -1864,6 +2006,55 @@ public:
       std::vector<std::string> *excludeGeoTags=NULL,
       std::vector<std::string> *forceGeoTags=NULL);
 
+  // ---------------------------------------------------------------------------
+  //! Constraints and result of the placement of one file in a batch.
+  //! See placeNewReplicasOneGroup for the meaning of the parameters.
+  // ---------------------------------------------------------------------------
+  struct PlacementRequest
+  {
+    size_t nNewReplicas;
+    std::vector<eos::common::FileSystem::fsid_t> *existingReplicas;
+    std::vector<std::string> *fsidsgeotags;
+    unsigned long long bookingSize;
+    std::string startFromGeoTag;
+    size_t nCollocatedReplicas;
+    std::vector<eos::common::FileSystem::fsid_t> *excludeFs;
+    std::vector<std::string> *excludeGeoTags;
+    std::vector<std::string> *forceGeoTags;
+    /// fsids of the new replicas, filled by the placement
+    std::vector<eos::common::FileSystem::fsid_t> newReplicas;
+    /// true if the placement of this file succeeded
+    bool success;
+
+    PlacementRequest() :
+      nNewReplicas(0), existingReplicas(NULL), fsidsgeotags(NULL),
+      bookingSize(0), nCollocatedReplicas(0), excludeFs(NULL),
+      excludeGeoTags(NULL), forceGeoTags(NULL), success(false)
+    {}
+  };
+
+  // ---------------------------------------------------------------------------
+  //! Place the replicas of several files in one scheduling group.
+  //! The group is looked up and its fast structures are locked only once for
+  //! the whole batch and the per-file constraints are resolved into reusable
+  //! thread local vectors. Penalties of a placement are applied before the
+  //! next file is placed so that a batch spreads like sequential calls.
+  //! Proxies and firewall entry points are not scheduled, callers needing
+  //! them should use placeNewReplicasOneGroup.
+  // @param group
+  //   the group to place the replicas in
+  // @param requests
+  //   the files to place, the result is stored in each request
+  // @param type
+  //   type of placement to be performed. It can be:
+  //     regularRO, regularRW, balancing or draining
+  // @return
+  //   the number of files successfully placed
+  // ---------------------------------------------------------------------------
+  size_t placeNewReplicasOneGroupBatch(FsGroup* group,
+      std::vector<PlacementRequest> &requests,
+      SchedType type);
+
   // ---------------------------------------------------------------------------
   //! Access several replicas in one scheduling group.
   // @param group
@@ -1961,6 +2152,51 @@ public:
       bool noIO=false
   );
 
+  // ---------------------------------------------------------------------------
+  //! Parameters and result of the access to one file in a batch.
+  //! See accessHeadReplicaMultipleGroup for the meaning of the parameters.
+  // ---------------------------------------------------------------------------
+  struct AccessRequest
+  {
+    size_t nReplicas;
+    std::vector<eos::common::FileSystem::fsid_t> *existingReplicas;
+    eos::common::FileSystem::fsid_t forcedFsId;
+    /// index of the head replica in existingReplicas
+    unsigned long fsIndex;
+    /// file systems known to be unavailable, the ones found unavailable
+    /// by the access are appended
+    std::vector<eos::common::FileSystem::fsid_t> unavailableFs;
+    /// return code as for accessHeadReplicaMultipleGroup
+    int retCode;
+
+    AccessRequest() :
+      nReplicas(0), existingReplicas(NULL), forcedFsId(0), fsIndex(0),
+      retCode(ENODATA)
+    {}
+  };
+
+  // ---------------------------------------------------------------------------
+  //! Access the head replicas of several files.
+  //! The fast structures of all the scheduling groups involved are locked
+  //! only once for the whole batch. Proxies and firewall entry points are
+  //! not scheduled.
+  // @param requests
+  //   the files to access, the result is stored in each request
+  // @param type
+  //   type of access to be performed. It can be:
+  //     regularRO, regularRW, balancing or draining
+  // @param accesserGeotag
+  //   try to get the replicas as close to this geotag as possible
+  // @param noIO
+  //   if true, no penalty is applied
+  // @return
+  //   the number of files successfully accessed
+  // ---------------------------------------------------------------------------
+  size_t accessHeadReplicaMultipleGroupBatch(std::vector<AccessRequest> &requests,
+      SchedType type=regularRO,
+      const std::string &accesserGeotag="",
+      bool noIO=false);
+
   // ---------------------------------------------------------------------------
   //! Start the background updater thread
   // @return
@@ -174,8 +174,118 @@ ICfgEngineChangelog::ParseTextEntry(const char* entry, std::string& key,
 //------------------------------------------------------------------------------
 IConfigEngine::IConfigEngine():
   mChangelog(), mAutosave(false), mBroadcast(true),
-  mConfigFile("default"), mConfigDir()
-{}
+  mConfigFile("default"), mConfigDir(), mSaveSignal(0), mSavePending(false),
+  mSaveStop(false), mSaveDelayMs(0)
+{
+  if (getenv("EOS_MGM_CONFIG_AUTOSAVE_MS")) {
+    mSaveDelayMs = atoi(getenv("EOS_MGM_CONFIG_AUTOSAVE_MS"));
+
+    if (mSaveDelayMs < 0) {
+      mSaveDelayMs = 0;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Request a (coalesced) autosave
+//------------------------------------------------------------------------------
+void
+IConfigEngine::ScheduleAutoSave()
+{
+  if (!mSaveDelayMs) {
+    AutoSave();
+    return;
+  }
+
+  XrdSysCondVarHelper lock(mSaveSignal);
+
+  if (mSaveStop) {
+    return;
+  }
+
+  if (!mSaveThread.joinable()) {
+    mSaveThread = std::thread(&IConfigEngine::AutoSaver, this);
+  }
+
+  // the thread is only woken up for the first change of a burst
+  if (!mSavePending) {
+    mSavePending = true;
+    mSaveSignal.Signal();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Flush a pending autosave and stop the autosave thread
+//------------------------------------------------------------------------------
+void
+IConfigEngine::StopAutoSaver()
+{
+  {
+    XrdSysCondVarHelper lock(mSaveSignal);
+    mSaveStop = true;
+    mSaveSignal.Signal();
+  }
+
+  if (mSaveThread.joinable()) {
+    mSaveThread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Autosave thread loop - waits for a change, lets the burst settle for the
+// coalescing window and saves once
+//------------------------------------------------------------------------------
+void
+IConfigEngine::AutoSaver()
+{
+  while (true) {
+    {
+      XrdSysCondVarHelper lock(mSaveSignal);
+
+      while (!mSavePending && !mSaveStop) {
+        mSaveSignal.Wait();
+      }
+
+      if (!mSavePending) {
+        return;
+      }
+
+      if (!mSaveStop) {
+        mSaveSignal.WaitMS(mSaveDelayMs);
+      }
+
+      if (!mSavePending) {
+        // already saved by FlushAutoSave
+        continue;
+      }
+
+      mSavePending = false;
+    }
+
+    XrdSysMutexHelper lock(mSaveMutex);
+    AutoSave();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Do a pending autosave synchronously
+//------------------------------------------------------------------------------
+void
+IConfigEngine::FlushAutoSave()
+{
+  {
+    XrdSysCondVarHelper lock(mSaveSignal);
+
+    if (!mSavePending) {
+      return;
+    }
+
+    mSavePending = false;
+  }
+
+  XrdSysMutexHelper lock(mSaveMutex);
+  AutoSave();
+}
 
 
 //------------------------------------------------------------------------------
@@ -592,7 +702,10 @@ IConfigEngine::ResetConfig()
   std::string cmd = "reset config";
   mChangelog->AddEntry(cmd.c_str());
   mChangelog->ClearChanges();
-  mConfigFile = "";
+  {
+    XrdSysMutexHelper lock(mMutex);
+    mConfigFile = "";
+  }
   (void) Quota::CleanUp();
   {
     eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
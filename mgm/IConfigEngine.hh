@@ -29,6 +29,7 @@
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucHash.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <thread>
 
 //------------------------------------------------------------------------------
 //! @brief Interface Class responsible to handle configuration (load, save,
@@ -168,7 +169,7 @@ public:
   IConfigEngine();
 
   //----------------------------------------------------------------------------
-  //! Destructor
+  //! Destructor - derived classes have to call StopAutoSaver
   //----------------------------------------------------------------------------
   virtual ~IConfigEngine() {};
 
@@ -331,7 +332,28 @@ public:
     return mAutosave;
   }
 
+  //----------------------------------------------------------------------------
+  //! Do a pending autosave synchronously. Called when the MGM shuts down or
+  //! stops being the master, so that the last changes are not only in the
+  //! changelog. Changes done within the autosave window before a crash are
+  //! only in the config changelog, they are not replayed at load.
+  //----------------------------------------------------------------------------
+  void FlushAutoSave();
+
 protected:
+  //----------------------------------------------------------------------------
+  //! Request an autosave after a configuration change. The changes are already
+  //! journaled in the changelog, so bursts of changes are coalesced into one
+  //! save done by the autosave thread at most every EOS_MGM_CONFIG_AUTOSAVE_MS
+  //! milliseconds. With a value of 0 (default) the save is done in place.
+  //----------------------------------------------------------------------------
+  void ScheduleAutoSave();
+
+  //----------------------------------------------------------------------------
+  //! Flush a pending autosave and stop the autosave thread
+  //----------------------------------------------------------------------------
+  void StopAutoSaver();
+
   //! Helper struct for passing information in/out of XrdOucHash callbacks
   struct PrintInfo {
     XrdOucString* out; ///< Output string
@@ -339,7 +361,9 @@ protected:
   };
 
   std::unique_ptr<ICfgEngineChangelog> mChangelog; ///< Changelog object
-  XrdSysMutex mMutex; ///< Protect the static configuration definitions hash
+  //! Protect the static configuration definitions hash and the current config
+  //! name, recursive since an autosave can be triggered with the mutex held
+  XrdSysRecMutex mMutex;
   bool mAutosave; ///< Create autosave file for each change
   //! Broadcast changes into the MGM configuration queue (config/<inst>/mgm)
   bool mBroadcast;
@@ -347,6 +371,18 @@ protected:
   XrdOucString mConfigDir; ///< Path where configuration files are stored
 
 private:
+  //----------------------------------------------------------------------------
+  //! Autosave thread loop
+  //----------------------------------------------------------------------------
+  void AutoSaver();
+
+  XrdSysCondVar mSaveSignal; ///< Signal/protect the autosave thread state
+  XrdSysMutex mSaveMutex; ///< Serialize the autosaves of thread and flush
+  bool mSavePending; ///< Changes not yet saved
+  bool mSaveStop; ///< Request the autosave thread to exit
+  int mSaveDelayMs; ///< Coalescing window of the autosave
+  std::thread mSaveThread; ///< Autosave thread, started on first use
+
   //----------------------------------------------------------------------------
   //! Filter configuration
   //!
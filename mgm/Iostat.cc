@@ -44,9 +44,72 @@ const char* Iostat::gIostatReportNamespace = "iostat::reportnamespace";
 const char* Iostat::gIostatPopularity = "iostat::popularity";
 const char* Iostat::gIostatUdpTargetList = "iostat::udptargets";
 
+const char* IostatCounters::gTags[IostatCounters::kNTags] = {
+  "bytes_read",
+  "bytes_written",
+  "read_calls",
+  "readv_calls",
+  "write_calls",
+  "fwd_seeks",
+  "bwd_seeks",
+  "xl_fwd_seeks",
+  "xl_bwd_seeks",
+  "bytes_fwd_seek",
+  "bytes_bwd_wseek",
+  "bytes_xl_fwd_seek",
+  "bytes_xl_bwd_wseek",
+  "disk_time_read",
+  "disk_time_write"
+};
+
+/* ------------------------------------------------------------------------- */
+void
+IostatCounters::Add (const eos::common::Report &report)
+{
+  // has to follow the order of gTags
+  unsigned long val[kNTags] = {
+    (unsigned long) report.rb,
+    (unsigned long) report.wb,
+    (unsigned long) report.nrc,
+    (unsigned long) report.rv_op,
+    (unsigned long) report.nwc,
+    (unsigned long) report.nfwds,
+    (unsigned long) report.nbwds,
+    (unsigned long) report.nxlfwds,
+    (unsigned long) report.nxlbwds,
+    (unsigned long) report.sfwdb,
+    (unsigned long) report.sbwdb,
+    (unsigned long) report.sxlfwdb,
+    (unsigned long) report.sxlbwdb,
+    (unsigned long) report.rt,
+    (unsigned long) report.wt
+  };
+
+  for (int i = 0; i < kNTags; ++i)
+  {
+    total[i] += val[i];
+    avg[i].Add(val[i], report.ots, report.cts);
+  }
+}
+
 /* ------------------------------------------------------------------------- */
 Iostat::Iostat ()
 {
+  mWorkerStop = false;
+  mBacklog = 0;
+  mIngested = 0;
+  mIngestedLast = 0;
+  mIngestRateTime = time(NULL);
+  mIngestRate = 0;
+  mNumWorkers = 4;
+
+  if (getenv("EOS_MGM_IOSTAT_THREADS"))
+  {
+    int n = atoi(getenv("EOS_MGM_IOSTAT_THREADS"));
+    if ((n > 0) && (n <= 64))
+      mNumWorkers = n;
+  }
+
   mRunning = false;
   mInit = false;
   mStoreFileName = "";
@@ -202,6 +265,12 @@ Iostat::Start ()
   if (!mRunning)
   {
     mClient.Subscribe();
+    mWorkerStop = false;
+    mWorkers.resize(mNumWorkers);
+    for (size_t i = 0; i < mWorkers.size(); ++i)
+    {
+      XrdSysThread::Run(&mWorkers[i], Iostat::StaticWorker, static_cast<void *> (this), XRDSYSTHREAD_HOLD, "Report Worker Thread");
+    }
     XrdSysThread::Run(&thread, Iostat::StaticReceive, static_cast<void *> (this), XRDSYSTHREAD_HOLD, "Report Receiver Thread");
     mRunning = true;
     return true;
@@ -220,6 +289,16 @@ Iostat::Stop ()
   {
     XrdSysThread::Cancel(thread);
     XrdSysThread::Join(thread, NULL);
+    // let the workers drain the queue and exit
+    mQueueCond.Lock();
+    mWorkerStop = true;
+    mQueueCond.Broadcast();
+    mQueueCond.UnLock();
+    for (size_t i = 0; i < mWorkers.size(); ++i)
+    {
+      XrdSysThread::Join(mWorkers[i], NULL);
+    }
+    mWorkers.clear();
     mRunning = false;
     mClient.Unsubscribe();
     return true;
@@ -256,209 +335,344 @@ Iostat::StaticCirculate (void* arg)
   return reinterpret_cast<Iostat*> (arg)->Circulate();
 }
 
+/* ------------------------------------------------------------------------- */
+void*
+Iostat::StaticWorker (void* arg)
+{
+  return reinterpret_cast<Iostat*> (arg)->Worker();
+}
+
 /* ------------------------------------------------------------------------- */
 void*
 Iostat::Receive (void)
 {
+  // ---------------------------------------------------------------------------
+  // ! pull report messages from the MQ and queue them in batches for the
+  // ! worker threads
+  // ---------------------------------------------------------------------------
   while (1)
   {
+    std::vector<XrdMqMessage*>* batch = 0;
     XrdMqMessage* newmessage = 0;
     while ((newmessage = mClient.RecvMessage()))
     {
-      XrdOucString body = newmessage->GetBody();
-      while (body.replace("&&", "&"))
-      {
-      }
-      XrdOucEnv ioreport(body.c_str());
-      eos::common::Report* report = new eos::common::Report(ioreport);
-      Add("bytes_read", report->uid, report->gid, report->rb, report->ots, report->cts);
-      Add("bytes_written", report->uid, report->gid, report->wb, report->ots, report->cts);
-      Add("read_calls", report->uid, report->gid, report->nrc, report->ots, report->cts);
-      Add("readv_calls", report->uid, report->gid, report->rv_op, report->ots, report->cts);      
-      Add("write_calls", report->uid, report->gid, report->nwc, report->ots, report->cts);
-      Add("fwd_seeks", report->uid, report->gid, report->nfwds, report->ots, report->cts);
-      Add("bwd_seeks", report->uid, report->gid, report->nbwds, report->ots, report->cts);
-      Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds, report->ots, report->cts);
-      Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds, report->ots, report->cts);
-      Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb, report->ots, report->cts);
-      Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb, report->ots, report->cts);
-      Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb, report->ots, report->cts);
-      Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb, report->ots, report->cts);
-      Add("disk_time_read", report->uid, report->gid, (unsigned long long) report->rt, report->ots, report->cts);
-      Add("disk_time_write", report->uid, report->gid, (unsigned long long) report->wt, report->ots, report->cts);
-
-      // do the UDP broadcasting here
+      if (!batch)
       {
-        XrdSysMutexHelper mLock(BroadcastMutex);
-        if (mUdpPopularityTarget.size())
-        {
-          UdpBroadCast(report);
-        }
+        batch = new std::vector<XrdMqMessage*>();
+        batch->reserve(kIngestBatch);
       }
 
-      // do the domain accounting here      
-      if (report->path.substr(0, 11) == "/replicate:")
+      batch->push_back(newmessage);
+
+      if (batch->size() >= kIngestBatch)
       {
-        // check if this is a replication path
-        // push into the 'eos' domain
-        Mutex.Lock();
-        if (report->rb)
-          IostatAvgDomainIOrb["eos"].Add(report->rb, report->ots, report->cts);
-        if (report->wb)
-          IostatAvgDomainIOwb["eos"].Add(report->wb, report->ots, report->cts);
-        Mutex.UnLock();
+        mQueueCond.Lock();
+        mQueue.push_back(batch);
+        mBacklog += batch->size();
+        mQueueCond.Signal();
+        mQueueCond.UnLock();
+        batch = 0;
       }
-      else
-      {
-        bool dfound = false;
+    }
 
-        if (mReportPopularity)
-        {
-          // do the popularity accounting here for everything which is not replication!
-          AddToPopularity(report->path, report->rb, report->ots, report->cts);
-        }
+    if (batch)
+    {
+      mQueueCond.Lock();
+      mQueue.push_back(batch);
+      mBacklog += batch->size();
+      mQueueCond.Signal();
+      mQueueCond.UnLock();
+    }
 
-        size_t pos = 0;
-        if ((pos = report->sec_domain.rfind(".")) != std::string::npos)
+    XrdSysThread::SetCancelOn();
+    XrdSysTimer sleeper;
+    sleeper.Snooze(1);
+    XrdSysThread::CancelPoint();
+    XrdSysThread::SetCancelOff();
+
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+void*
+Iostat::Worker (void)
+{
+  // ---------------------------------------------------------------------------
+  // ! digest queued batches of report messages until stopped and drained
+  // ---------------------------------------------------------------------------
+  while (1)
+  {
+    std::vector<XrdMqMessage*>* batch = 0;
+    mQueueCond.Lock();
+
+    while (mQueue.empty() && !mWorkerStop)
+    {
+      mQueueCond.Wait();
+    }
+
+    if (mQueue.empty())
+    {
+      // stop requested and nothing left to do
+      mQueueCond.UnLock();
+      break;
+    }
+
+    batch = mQueue.front();
+    mQueue.pop_front();
+    mQueueCond.UnLock();
+
+    for (size_t i = 0; i < batch->size(); ++i)
+    {
+      ProcessMessage((*batch)[i]);
+    }
+
+    mQueueCond.Lock();
+    mBacklog -= batch->size();
+    mIngested += batch->size();
+    mQueueCond.UnLock();
+    delete batch;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::ProcessMessage (XrdMqMessage* newmessage)
+{
+  XrdOucString body = newmessage->GetBody();
+  while (body.replace("&&", "&"))
+  {
+  }
+  XrdOucEnv ioreport(body.c_str());
+  eos::common::Report* report = new eos::common::Report(ioreport);
+  ApplyReport(*report);
+
+  // do the UDP broadcasting here
+  {
+    XrdSysMutexHelper mLock(BroadcastMutex);
+    if (mUdpPopularityTarget.size())
+    {
+      UdpBroadCast(report);
+    }
+  }
+
+  if (mReportPopularity && (report->path.substr(0, 11) != "/replicate:"))
+  {
+    // do the popularity accounting here for everything which is not replication!
+    AddToPopularity(report->path, report->rb, report->ots, report->cts);
+  }
+
+  if (mReport)
+  {
+    // add the record to a daily report log file
+    XrdSysMutexHelper rLock(ReportFileMutex);
+    static XrdOucString openreportfile = "";
+    static FILE* openreportfd = 0;
+    time_t now = time(NULL);
+    struct tm nowtm;
+    XrdOucString reportfile = "";
+
+    if (localtime_r(&now, &nowtm))
+    {
+      static char logfile[4096];
+      snprintf(logfile, sizeof (logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
+               gOFS->IoReportStorePath.c_str(),
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               nowtm.tm_mday);
+
+      reportfile = logfile;
+
+      if (reportfile == openreportfile)
+      {
+        // just add it here;
+        if (openreportfd)
         {
-          // we can sort in by domain
-          std::string sdomain = report->sec_domain.substr(pos);
-          if (IoDomains.find(sdomain) != IoDomains.end())
-          {
-            Mutex.Lock();
-            if (report->rb)
-              IostatAvgDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts);
-            if (report->wb)
-              IostatAvgDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts);
-            Mutex.UnLock();
-            dfound = true;
-          }
+          fprintf(openreportfd, "%s\n", body.c_str());
+          fflush(openreportfd);
         }
+      }
+      else
+      {
+        if (openreportfd)
+          fclose(openreportfd);
 
-        // do the node accounting here - keep the node list small !!!
-        std::set<std::string>::const_iterator nit;
-        for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++)
+        eos::common::Path cPath(reportfile.c_str());
+        if (cPath.MakeParentPath(S_IRWXU))
         {
-          if (*nit == report->sec_host.substr(0, nit->length()))
+          openreportfd = fopen(reportfile.c_str(), "a+");
+          if (openreportfd)
           {
-            Mutex.Lock();
-            if (report->rb)
-              IostatAvgDomainIOrb[*nit].Add(report->rb, report->ots, report->cts);
-            if (report->wb)
-              IostatAvgDomainIOwb[*nit].Add(report->wb, report->ots, report->cts);
-            Mutex.UnLock();
-            dfound = true;
+            fprintf(openreportfd, "%s\n", body.c_str());
+            fflush(openreportfd);
           }
-        }
-
-        if (!dfound)
-        {
-          // push into the 'other' domain
-          Mutex.Lock();
-          if (report->rb)
-            IostatAvgDomainIOrb["other"].Add(report->rb, report->ots, report->cts);
-          if (report->wb)
-            IostatAvgDomainIOwb["other"].Add(report->wb, report->ots, report->cts);
-          Mutex.UnLock();
+          openreportfile = reportfile;
         }
       }
+    }
+  }
+
+  if (mReportNamespace)
+  {
+    // add the record into the report namespace file
+    XrdSysMutexHelper rLock(ReportFileMutex);
+    char path[4096];
+    snprintf(path, sizeof (path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(), report->path.c_str());
+    eos::common::Path cPath(path);
 
-      // do the application accounting here      
-      std::string apptag = "other";
-      if (report->sec_app.length())
+    if (cPath.MakeParentPath(S_IRWXU))
+    {
+      FILE* freport = fopen(path, "a+");
+      if (freport)
       {
-        apptag = report->sec_app;
+        fprintf(freport, "%s\n", body.c_str());
+        fclose(freport);
       }
+    }
+  }
 
-      // push into the app accounting
-      Mutex.Lock();
-      if (report->rb)
-        IostatAvgAppIOrb[apptag].Add(report->rb, report->ots, report->cts);
-      if (report->wb)
-        IostatAvgAppIOwb[apptag].Add(report->wb, report->ots, report->cts);
-      Mutex.UnLock();
+  delete report;
+  delete newmessage;
+}
 
-      if (mReport)
-      {
-        // add the record to a daily report log file
+/* ------------------------------------------------------------------------- */
+void
+Iostat::ApplyReport (const eos::common::Report &report)
+{
+  // ---------------------------------------------------------------------------
+  // ! account a report in the shard of its uid - taking a single lock
+  // ---------------------------------------------------------------------------
+  IostatShard& shard = mShards[report.uid % kShards];
+  unsigned long long key = (((unsigned long long) report.uid) << 32) | report.gid;
+  XrdSysMutexHelper sLock(shard.Mutex);
+  IostatCounters*& counters = shard.Counters[key];
 
-        static XrdOucString openreportfile = "";
-        static FILE* openreportfd = 0;
-        time_t now = time(NULL);
-        struct tm nowtm;
-        XrdOucString reportfile = "";
+  if (!counters)
+    counters = new IostatCounters();
 
-        if (localtime_r(&now, &nowtm))
-        {
-          static char logfile[4096];
-          snprintf(logfile, sizeof (logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
-                   gOFS->IoReportStorePath.c_str(),
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   nowtm.tm_mday);
-
-          reportfile = logfile;
-
-          if (reportfile == openreportfile)
-          {
-            // just add it here;
-            if (openreportfd)
-            {
-              fprintf(openreportfd, "%s\n", body.c_str());
-              fflush(openreportfd);
-            }
-          }
-          else
-          {
-            if (openreportfd)
-              fclose(openreportfd);
+  counters->Add(report);
 
-            eos::common::Path cPath(reportfile.c_str());
-            if (cPath.MakeParentPath(S_IRWXU))
-            {
-              openreportfd = fopen(reportfile.c_str(), "a+");
-              if (openreportfd)
-              {
-                fprintf(openreportfd, "%s\n", body.c_str());
-                fflush(openreportfd);
-              }
-              openreportfile = reportfile;
-            }
-          }
-        }
+  // do the domain accounting here
+  if (report.path.substr(0, 11) == "/replicate:")
+  {
+    // check if this is a replication path
+    // push into the 'eos' domain
+    if (report.rb)
+      shard.DomainIOrb["eos"].Add(report.rb, report.ots, report.cts);
+    if (report.wb)
+      shard.DomainIOwb["eos"].Add(report.wb, report.ots, report.cts);
+  }
+  else
+  {
+    bool dfound = false;
+    size_t pos = 0;
+    if ((pos = report.sec_domain.rfind(".")) != std::string::npos)
+    {
+      // we can sort in by domain
+      std::string sdomain = report.sec_domain.substr(pos);
+      if (IoDomains.find(sdomain) != IoDomains.end())
+      {
+        if (report.rb)
+          shard.DomainIOrb[sdomain].Add(report.rb, report.ots, report.cts);
+        if (report.wb)
+          shard.DomainIOwb[sdomain].Add(report.wb, report.ots, report.cts);
+        dfound = true;
       }
+    }
 
-      if (mReportNamespace)
+    // do the node accounting here - keep the node list small !!!
+    std::set<std::string>::const_iterator nit;
+    for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++)
+    {
+      if (*nit == report.sec_host.substr(0, nit->length()))
       {
-        // add the record into the report namespace file
-        char path[4096];
-        snprintf(path, sizeof (path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(), report->path.c_str());
-        eos::common::Path cPath(path);
-
-        if (cPath.MakeParentPath(S_IRWXU))
-        {
-          FILE* freport = fopen(path, "a+");
-          if (freport)
-          {
-            fprintf(freport, "%s\n", body.c_str());
-            fclose(freport);
-          }
-        }
+        if (report.rb)
+          shard.DomainIOrb[*nit].Add(report.rb, report.ots, report.cts);
+        if (report.wb)
+          shard.DomainIOwb[*nit].Add(report.wb, report.ots, report.cts);
+        dfound = true;
       }
+    }
 
-      delete report;
-      delete newmessage;
+    if (!dfound)
+    {
+      // push into the 'other' domain
+      if (report.rb)
+        shard.DomainIOrb["other"].Add(report.rb, report.ots, report.cts);
+      if (report.wb)
+        shard.DomainIOwb["other"].Add(report.wb, report.ots, report.cts);
     }
-    XrdSysThread::SetCancelOn();
-    XrdSysTimer sleeper;
-    sleeper.Snooze(1);
-    XrdSysThread::CancelPoint();
-    XrdSysThread::SetCancelOff();
+  }
 
+  // do the application accounting here
+  std::string apptag = "other";
+  if (report.sec_app.length())
+  {
+    apptag = report.sec_app;
+  }
+
+  // push into the app accounting
+  if (report.rb)
+    shard.AppIOrb[apptag].Add(report.rb, report.ots, report.cts);
+  if (report.wb)
+    shard.AppIOwb[apptag].Add(report.wb, report.ots, report.cts);
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::MergeShards ()
+{
+  // ---------------------------------------------------------------------------
+  // ! move the staged reports of all shards into the uid/gid tables
+  // ! warning: you have to lock the mutex
+  // ---------------------------------------------------------------------------
+  for (int i = 0; i < kShards; ++i)
+  {
+    IostatShard& shard = mShards[i];
+    std::map<unsigned long long, IostatCounters*> counters;
+    std::map<std::string, IostatAvg> domainrb;
+    std::map<std::string, IostatAvg> domainwb;
+    std::map<std::string, IostatAvg> apprb;
+    std::map<std::string, IostatAvg> appwb;
+    {
+      // keep the shard lock only for the swap
+      XrdSysMutexHelper sLock(shard.Mutex);
+      counters.swap(shard.Counters);
+      domainrb.swap(shard.DomainIOrb);
+      domainwb.swap(shard.DomainIOwb);
+      apprb.swap(shard.AppIOrb);
+      appwb.swap(shard.AppIOwb);
+    }
+
+    std::map<unsigned long long, IostatCounters*>::iterator it;
+    for (it = counters.begin(); it != counters.end(); ++it)
+    {
+      uid_t uid = (uid_t) (it->first >> 32);
+      gid_t gid = (gid_t) (it->first & 0xffffffff);
+      for (int t = 0; t < IostatCounters::kNTags; ++t)
+      {
+        const char* tag = IostatCounters::gTags[t];
+        IostatUid[tag][uid] += it->second->total[t];
+        IostatGid[tag][gid] += it->second->total[t];
+        IostatAvgUid[tag][uid].Merge(it->second->avg[t]);
+        IostatAvgGid[tag][gid].Merge(it->second->avg[t]);
+      }
+      delete it->second;
+    }
+
+    std::map<std::string, IostatAvg>::const_iterator dit;
+    for (dit = domainrb.begin(); dit != domainrb.end(); ++dit)
+      IostatAvgDomainIOrb[dit->first].Merge(dit->second);
+    for (dit = domainwb.begin(); dit != domainwb.end(); ++dit)
+      IostatAvgDomainIOwb[dit->first].Merge(dit->second);
+    for (dit = apprb.begin(); dit != apprb.end(); ++dit)
+      IostatAvgAppIOrb[dit->first].Merge(dit->second);
+    for (dit = appwb.begin(); dit != appwb.end(); ++dit)
+      IostatAvgAppIOwb[dit->first].Merge(dit->second);
   }
-  return 0;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -468,6 +682,7 @@ Iostat::PrintOut (XrdOucString &out, bool summary, bool details,
                   bool domain, bool apps, XrdOucString option)
 {
   Mutex.Lock();
+  MergeShards();
   std::vector<std::string> tags;
   std::vector<std::string>::iterator it;
 
@@ -525,6 +740,37 @@ Iostat::PrintOut (XrdOucString &out, bool summary, bool details,
       out += outline;
     }
 
+    {
+      // report ingestion statistics
+      unsigned long long backlog = 0;
+      unsigned long long ingested = 0;
+      double rate = 0;
+      {
+        XrdSysCondVarHelper qLock(mQueueCond);
+        backlog = mBacklog;
+        ingested = mIngested;
+        rate = mIngestRate;
+      }
+
+      if (!monitoring)
+      {
+        out += "# -----------------------------------------------------------------------------------------------------------\n";
+        sprintf(outline, "%-10s %-32s %10llu\n", "ALL", "ingest_reports", ingested);
+        out += outline;
+        sprintf(outline, "%-10s %-32s %10.02f\n", "ALL", "ingest_rate(Hz)", rate);
+        out += outline;
+        sprintf(outline, "%-10s %-32s %10llu\n", "ALL", "ingest_backlog", backlog);
+        out += outline;
+        sprintf(outline, "%-10s %-32s %10lu\n", "ALL", "ingest_threads", (unsigned long) mNumWorkers);
+        out += outline;
+      }
+      else
+      {
+        sprintf(outline, "uid=all gid=all ingest.reports=%llu ingest.rate=%.02f ingest.backlog=%llu ingest.threads=%lu\n", ingested, rate, backlog, (unsigned long) mNumWorkers);
+        out += outline;
+      }
+    }
+
     {
       XrdSysMutexHelper mLock(BroadcastMutex);
       std::set<std::string>::const_iterator it;
@@ -1297,6 +1543,7 @@ Iostat::Store ()
   google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator tuit;
   google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator tgit;
   Mutex.Lock();
+  MergeShards();
   // store user counters
   for (tuit = IostatUid.begin(); tuit != IostatUid.end(); tuit++)
   {
@@ -1439,7 +1686,19 @@ Iostat::Circulate ()
     sc++;
     XrdSysTimer sleeper;
     sleeper.Wait(512);
+    {
+      // update the ingestion rate every 5 seconds
+      XrdSysCondVarHelper qLock(mQueueCond);
+      time_t now = time(NULL);
+      if ((now - mIngestRateTime) >= 5)
+      {
+        mIngestRate = 1.0 * (mIngested - mIngestedLast) / (now - mIngestRateTime);
+        mIngestedLast = mIngested;
+        mIngestRateTime = now;
+      }
+    }
     Mutex.Lock();
+    MergeShards();
     google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, IostatAvg> >::iterator tit;
     google::sparse_hash_map<std::string, IostatAvg >::iterator dit;
     // loop over tags
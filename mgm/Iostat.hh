@@ -38,6 +38,9 @@
 #include <sys/types.h>
 #include <string>
 #include <set>
+#include <map>
+#include <deque>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -138,6 +141,19 @@ public:
     }
   }
 
+  void
+  Merge (const IostatAvg &other)
+  {
+    // the bins are absolute in time, so we can just sum them up
+    for (int i = 0; i < 60; i++)
+    {
+      avg86400[i] += other.avg86400[i];
+      avg3600[i] += other.avg3600[i];
+      avg300[i] += other.avg300[i];
+      avg60[i] += other.avg60[i];
+    }
+  }
+
   void
   StampZero ()
   {
@@ -189,6 +205,50 @@ public:
   }
 };
 
+/*----------------------------------------------------------------------------*/
+//! All measurements of io reports for one (uid,gid) pair - a report is applied
+//! with a single call instead of one update per measurement
+/*----------------------------------------------------------------------------*/
+class IostatCounters
+{
+public:
+  static const int kNTags = 15;
+  static const char* gTags[kNTags];
+
+  unsigned long long total[kNTags];
+  IostatAvg avg[kNTags];
+
+  IostatCounters ()
+  {
+    memset (total, 0, sizeof (total));
+  }
+
+  void Add (const eos::common::Report &report);
+};
+
+/*----------------------------------------------------------------------------*/
+//! Shard of io reports not yet merged into the Iostat tables. Reports are
+//! distributed by uid, the shards are drained by Iostat::Circulate.
+/*----------------------------------------------------------------------------*/
+class IostatShard
+{
+public:
+  XrdSysMutex Mutex;
+  // key is (uid << 32) | gid
+  std::map<unsigned long long, IostatCounters*> Counters;
+  std::map<std::string, IostatAvg> DomainIOrb;
+  std::map<std::string, IostatAvg> DomainIOwb;
+  std::map<std::string, IostatAvg> AppIOrb;
+  std::map<std::string, IostatAvg> AppIOwb;
+
+  ~IostatShard ()
+  {
+    std::map<unsigned long long, IostatCounters*>::iterator it;
+    for (it = Counters.begin (); it != Counters.end (); ++it)
+      delete it->second;
+  }
+};
+
 class Iostat
 {
   // -------------------------------------------------------------
@@ -264,6 +324,32 @@ private:
   XrdOucString mUdpPopularityTargetList; // contains the string describing the set above for the configuration store
   XrdOucString mStoreFileName; // file name where a dump is loaded/saved in Restore/Store
 
+  // -----------------------------------------------------------
+  // report ingestion - the receiver thread queues batches of
+  // messages which are digested by a pool of worker threads
+  // -----------------------------------------------------------
+  static const int kShards = 16;
+  static const size_t kIngestBatch = 256;
+
+  IostatShard mShards[kShards];
+
+  XrdSysCondVar mQueueCond; // protecting the queue and the ingest counters
+  std::deque<std::vector<XrdMqMessage*>* > mQueue;
+  bool mWorkerStop;
+  std::vector<pthread_t> mWorkers;
+  size_t mNumWorkers;
+  unsigned long long mBacklog; // messages in the queue
+  unsigned long long mIngested; // messages digested since start
+  unsigned long long mIngestedLast; // messages digested at the last rate update
+  time_t mIngestRateTime; // time of the last rate update
+  double mIngestRate; // messages per second
+
+  XrdSysMutex ReportFileMutex; // serializing writes to the report files
+
+  void ProcessMessage (XrdMqMessage* message);
+  void ApplyReport (const eos::common::Report &report);
+  void MergeShards (); // warning: you have to lock the mutex
+
 
 public:
   // configuration keys used in config key-val store
@@ -318,7 +404,9 @@ public:
 
   static void* StaticReceive (void*);
   static void* StaticCirculate (void*);
+  static void* StaticWorker (void*);
   void* Receive ();
+  void* Worker ();
 
   static bool NamespaceReport (const char* path, XrdOucString &stdOut, XrdOucString &stdErr);
 
@@ -29,6 +29,8 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "common/Statfs.hh"
 #include "common/ShellCmd.hh"
+#include "common/SymKeys.hh"
+#include "common/Timing.hh"
 #include "common/plugin_manager/PluginManager.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdNet/XrdNet.hh"
@@ -39,6 +41,9 @@
 /*----------------------------------------------------------------------------*/
 #include "namespace/interface/IChLogFileMDSvc.hh"
 #include "namespace/interface/IChLogContainerMDSvc.hh"
+#include "namespace/interface/IDeferredAccounting.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogCheckpoint.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogStream.hh"
 /*----------------------------------------------------------------------------*/
 
 // -----------------------------------------------------------------------------
@@ -52,6 +57,13 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+//! Changelog bytes left to be copied under the namespace write lock
+static const uint64_t sCompactCommitBytes = 1024 * 1024;
+//! Maximum number of compacting catch-up rounds before committing anyway
+static const int sCompactMaxRounds = 16;
+//! In-memory log offsets updated per namespace write lock after compacting
+static const uint64_t sCompactRemapBatch = 100000;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -65,9 +77,14 @@ Master::Master()
   fRunningState = Run::State::kIsNothing;
   fCompactingState = Compact::State::kIsNotCompacting;
   fCompactingThread = 0;
+  fCheckpointThread = 0;
+  fCheckpointInterval = 0;
   fCompactingStart = 0;
   fCompactingInterval = 0;
   fCompactingRatio = 0;
+  fCompactingRound = 0;
+  fCompactingBehind = 0;
+  fCompactingLockHold = 0;
   fCompactFiles = false;
   fCompactDirectories = false;
   fDevNull = 0;
@@ -77,6 +94,8 @@ Master::Master()
   fFileNamespaceInode = fDirNamespaceInode = 0;
   f2MasterTransitionTime = time(NULL) - 3600; // start without service delays
   fHasSystemd = false;
+  fStreamPort = 1099;
+  fStreamServer.reset(new eos::ChangeLogStreamServer());
 }
 
 //------------------------------------------------------------------------------
@@ -113,6 +132,18 @@ Master::Init()
                     static_cast<void*>(this), XRDSYSTHREAD_HOLD,
                     "Master OnlineCompacting Thread");
 
+  // Start the checkpoint thread if checkpoint images are enabled
+  if (getenv("EOS_MGM_NS_CHECKPOINT_INTERVAL")) {
+    fCheckpointInterval = strtoul(getenv("EOS_MGM_NS_CHECKPOINT_INTERVAL"), 0,
+                                  10);
+  }
+
+  if (fCheckpointInterval) {
+    XrdSysThread::Run(&fCheckpointThread, Master::StaticCheckpointing,
+                      static_cast<void*>(this), XRDSYSTHREAD_HOLD,
+                      "Master Checkpoint Thread");
+  }
+
   if (fThisHost == fRemoteHost) {
     // No master slave configuration ... also fine
     fMasterHost = fThisHost;
@@ -200,6 +231,61 @@ Master::Init()
     return false;
   }
 
+  // Start the changelog stream server, a slave follows the master changelogs
+  if (getenv("EOS_MGM_NS_STREAM_PORT")) {
+    fStreamPort = atoi(getenv("EOS_MGM_NS_STREAM_PORT"));
+  }
+
+  // Listen on the cluster interface and serve only the two master hosts,
+  // which authenticate with the instance symkey
+  std::string bind_address = fThisHost.c_str();
+
+  if (getenv("EOS_MGM_NS_STREAM_BIND")) {
+    bind_address = getenv("EOS_MGM_NS_STREAM_BIND");
+  }
+
+  std::vector<std::string> masters;
+  masters.push_back(getenv("EOS_MGM_MASTER1"));
+  masters.push_back(getenv("EOS_MGM_MASTER2"));
+
+  for (auto it = masters.begin(); it != masters.end(); ++it) {
+    size_t pos = it->find(':');
+
+    if (pos != std::string::npos) {
+      it->erase(pos);
+    }
+  }
+
+  eos::common::SymKey* symkey = eos::common::gSymKeyStore.GetCurrentKey();
+
+  if (!symkey) {
+    eos_crit("no symmetric key to authenticate the changelog streams");
+    return false;
+  }
+
+  fStreamSecret.assign(symkey->GetKey(), SHA_DIGEST_LENGTH);
+  fStreamServer->setSecret(fStreamSecret);
+  fStreamServer->setAllowedHosts(masters);
+
+  try {
+    fStreamServer->start(fStreamPort, bind_address);
+  } catch (eos::MDException& e) {
+    eos_crit("failed to start changelog stream server address=%s port=%d: %s",
+             bind_address.c_str(), fStreamPort, e.getMessage().str().c_str());
+    return false;
+  }
+
+  if (fMasterHost == fThisHost) {
+    ServeChangeLogStreams();
+  } else {
+    FollowChangeLogStreams();
+    bool connected = true;
+
+    if (!WaitChangeLogStreamsInSync(300, connected)) {
+      eos_warning("msg=\"booting with changelogs not in sync with master\"");
+    }
+  }
+
   return true;
 }
 
@@ -594,6 +680,18 @@ Master::ScheduleOnlineCompacting(time_t starttime, time_t repetitioninterval)
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Publish the progress of the running compaction
+//------------------------------------------------------------------------------
+void
+Master::SetCompactingProgress(const char* phase, int round, uint64_t behind)
+{
+  XrdSysMutexHelper cLock(fCompactingMutex);
+  fCompactingPhase = phase;
+  fCompactingRound = round;
+  fCompactingBehind = behind;
+}
+
 //------------------------------------------------------------------------------
 // Do compacting
 //------------------------------------------------------------------------------
@@ -722,42 +820,101 @@ Master::Compacting()
         void* compDirData = 0;
         {
           MasterLog(eos_info("msg=\"compact prepare\""));
-          // Require NS read lock
+          SetCompactingProgress("prepare", 0, 0);
+          // Requires NS read lock, only marks the end of the snapshot
           eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
 
           if (CompactFiles) {
-            compData = eos_chlog_filesvc->compactPrepare(ocfile);
+            compData = eos_chlog_filesvc->compactPrepareIncremental(ocfile);
           }
 
           if (CompactDirectories) {
-            compDirData = eos_chlog_dirsvc->compactPrepare(ocdir);
+            compDirData = eos_chlog_dirsvc->compactPrepareIncremental(ocdir);
           }
         }
-        {
-          MasterLog(eos_info("msg=\"compacting\""));
+
+        // Copy the snapshot and then what was appended meanwhile until the
+        // tail left for the commit is small
+        int round = 0;
+        uint64_t behind = 0;
+
+        do {
+          SetCompactingProgress(round ? "catchup" : "snapshot", round, behind);
+          uint64_t copied = 0;
 
           // Does not require namespace lock
           if (CompactFiles) {
-            eos_chlog_filesvc->compact(compData);
+            copied += eos_chlog_filesvc->compactCatchUp(compData);
           }
 
           if (CompactDirectories) {
-            eos_chlog_dirsvc->compact(compDirData);
+            copied += eos_chlog_dirsvc->compactCatchUp(compDirData);
           }
-        }
+
+          {
+            // Requires NS read lock
+            eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+            behind = 0;
+
+            if (CompactFiles) {
+              behind += eos_chlog_filesvc->compactMark(compData);
+            }
+
+            if (CompactDirectories) {
+              behind += eos_chlog_dirsvc->compactMark(compDirData);
+            }
+          }
+
+          ++round;
+          MasterLog(eos_info("msg=\"compacting\" round=%d copied=%llu behind=%llu",
+                             round, (unsigned long long) copied,
+                             (unsigned long long) behind));
+        } while ((behind > sCompactCommitBytes) && (round < sCompactMaxRounds));
+
+        long long lockHoldMs = 0;
         {
-          // Requires namespace write lock
+          // Requires namespace write lock, copies the last tail and swaps
           MasterLog(eos_info("msg=\"compact commit\""));
+          SetCompactingProgress("commit", round, behind);
           eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          struct timespec ts_start;
+          eos::common::Timing::GetTimeSpec(ts_start);
 
           if (CompactFiles) {
-            eos_chlog_filesvc->compactCommit(compData);
+            eos_chlog_filesvc->compactCommitIncremental(compData);
           }
 
           if (CompactDirectories) {
-            eos_chlog_dirsvc->compactCommit(compDirData);
+            eos_chlog_dirsvc->compactCommitIncremental(compDirData);
           }
+
+          lockHoldMs = eos::common::Timing::GetAgeInNs(&ts_start) / 1000000;
+        }
+
+        {
+          XrdSysMutexHelper cLock(fCompactingMutex);
+          fCompactingLockHold = lockHoldMs;
         }
+
+        MasterLog(eos_info("msg=\"compact committed\" lock-hold-ms=%lld",
+                           lockHoldMs));
+        SetCompactingProgress("remap", round, 0);
+        uint64_t left = 0;
+
+        // Update the in-memory log offsets in batches, releasing the write
+        // lock in between
+        do {
+          eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          left = 0;
+
+          if (CompactFiles) {
+            left += eos_chlog_filesvc->compactRemap(sCompactRemapBatch);
+          }
+
+          if (CompactDirectories) {
+            left += eos_chlog_dirsvc->compactRemap(sCompactRemapBatch);
+          }
+        } while (left);
         {
           XrdSysMutexHelper cLock(fCompactingMutex);
           reschedule = (fCompactingInterval != 0);
@@ -902,6 +1059,76 @@ Master::Compacting()
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Checkpoint thread start function
+//------------------------------------------------------------------------------
+void*
+Master::StaticCheckpointing(void* arg)
+{
+  return reinterpret_cast<Master*>(arg)->Checkpointing();
+}
+
+//------------------------------------------------------------------------------
+// Get the checkpoint image path of a changelog type
+//------------------------------------------------------------------------------
+std::string
+Master::GetCheckpointPath(const char* name)
+{
+  std::string path = gOFS->MgmMetaLogDir.c_str();
+  path += "/";
+  path += name;
+  path += ".mdlog.ckp";
+  return path;
+}
+
+//------------------------------------------------------------------------------
+// Write the checkpoint images periodically
+//------------------------------------------------------------------------------
+void*
+Master::Checkpointing()
+{
+  do {
+    XrdSysThread::SetCancelOn();
+    XrdSysTimer sleeper;
+    sleeper.Wait(fCheckpointInterval * 1000);
+    XrdSysThread::SetCancelOff();
+    std::string logs[2];
+    {
+      // Only checkpoint a booted namespace, never during compaction
+      XrdSysMutexHelper lock(gOFS->InitializationMutex);
+
+      if (gOFS->Initialized != gOFS->kBooted) {
+        continue;
+      }
+
+      logs[0] = gOFS->MgmNsFileChangeLogFile.c_str();
+      logs[1] = gOFS->MgmNsDirChangeLogFile.c_str();
+    }
+    const char* names[2] = { "files", "directories" };
+
+    for (int i = 0; i < 2; ++i) {
+      eos::ChangeLogCheckpoint::Info info;
+      eos::ChangeLogCheckpoint::CreateStats stats;
+
+      try {
+        eos::ChangeLogCheckpoint::create(logs[i], GetCheckpointPath(names[i]),
+                                         info, stats);
+        eos_info("msg=\"checkpoint written\" log=%s offset=%llu entries=%llu "
+                 "incremental=%d scanned=%llu elapsed=%lu", logs[i].c_str(),
+                 (unsigned long long) info.coveredOffset,
+                 (unsigned long long) info.numEntries, (int) stats.incremental,
+                 (unsigned long long) stats.recordsScanned,
+                 (unsigned long) stats.timeElapsed);
+      } catch (eos::MDException& e) {
+        MasterLog(eos_err("checkpoint of %s failed ec=%d %s", logs[i].c_str(),
+                          e.getErrno(), e.getMessage().str().c_str()));
+      }
+    }
+  } while (1);
+
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Print out compacting status
 //------------------------------------------------------------------------------
@@ -913,6 +1140,16 @@ Master::PrintOutCompacting(XrdOucString& out)
   if (IsCompacting()) {
     out += "status=compacting";
     out += " waitstart=0";
+    XrdSysMutexHelper cLock(fCompactingMutex);
+    out += " phase=";
+    out += fCompactingPhase.c_str();
+    out += " round=";
+    out += fCompactingRound;
+    char behind[64];
+    snprintf(behind, sizeof(behind) - 1, "%llu",
+             (unsigned long long) fCompactingBehind);
+    out += " behind=";
+    out += behind;
   } else {
     if (IsCompactingBlocked()) {
       out += "status=blocked";
@@ -948,6 +1185,10 @@ Master::PrintOutCompacting(XrdOucString& out)
   out += " ratio-dir=";
   out += cfratio;
   out += ":1";
+  XrdSysMutexHelper cLock(fCompactingMutex);
+  snprintf(cfratio, sizeof(cfratio) - 1, "%lld", fCompactingLockHold);
+  out += " lock-hold-ms=";
+  out += cfratio;
 }
 
 //------------------------------------------------------------------------------
@@ -1023,6 +1264,8 @@ Master::PrintOut(XrdOucString& out)
       out += fRemoteMq;
       out += "=down";
     }
+
+    PrintOutChangeLogStreams(out);
   }
 }
 
@@ -1251,22 +1494,14 @@ Master::Slave2Master()
   // This call transforms the namespace following slave into a master in RW mode
   std::map<std::string, std::string> fileSettings;
   std::map<std::string, std::string> contSettings;
-  std::string rfclf;
-  std::string rdclf;
   contSettings["changelog_path"] = gOFS->MgmMetaLogDir.c_str();
   fileSettings["changelog_path"] = gOFS->MgmMetaLogDir.c_str();
   contSettings["changelog_path"] += "/directories.";
   fileSettings["changelog_path"] += "/files.";
-  rfclf = fileSettings["changelog_path"];
-  rdclf = contSettings["changelog_path"];
   contSettings["changelog_path"] += fMasterHost.c_str();
   fileSettings["changelog_path"] += fMasterHost.c_str();
-  rfclf += fRemoteHost.c_str();
-  rdclf += fRemoteHost.c_str();
   contSettings["changelog_path"] += ".mdlog";
   fileSettings["changelog_path"] += ".mdlog";
-  rfclf += ".mdlog";
-  rdclf += ".mdlog";
   // -----------------------------------------------------------
   // convert the follower namespace into a read-write namespace
   // -----------------------------------------------------------
@@ -1311,99 +1546,24 @@ Master::Slave2Master()
     return false;
   }
 
-  // If possible evaluate if local and remote master files are in sync ...
-  off_t size_local_file_changelog = 0;
-  off_t size_local_dir_changelog = 0;
-  off_t size_remote_file_changelog = 0;
-  off_t size_remote_dir_changelog = 0;
-  struct stat buf;
-  std::string remoteSyncUrlString = "root://";
-  remoteSyncUrlString += fRemoteHost.c_str();
-  remoteSyncUrlString += ":1096";
-  remoteSyncUrlString += "//dummy";
-  std::string remoteSyncHostPort = fRemoteHost.c_str();
-  remoteSyncHostPort += ":1096";
-
-  if (!stat(gOFS->MgmNsFileChangeLogFile.c_str(), &buf)) {
-    size_local_file_changelog = buf.st_size;
-  } else {
-    MasterLog(eos_crit("slave=>master transition aborted since we cannot stat "
-                       "our own slave file-changelog-file"));
-    fRunningState = Run::State::kIsRunningSlave;
-    return false;
-  }
+  // Check that the followed changelogs caught up with the remote master,
+  // unless the remote master is not reachable anymore
+  bool connected = true;
 
-  if (!stat(gOFS->MgmNsDirChangeLogFile.c_str(), &buf)) {
-    size_local_dir_changelog = buf.st_size;
-  } else {
-    MasterLog(eos_crit("slave=>master transition aborted since we cannot stat "
-                       "our own slave dir-changelog-file"));
+  if (!WaitChangeLogStreamsInSync(60, connected) && connected) {
+    MasterLog(eos_crit("slave=>master transition aborted - changelog "
+                       "synchronization problem found"));
     fRunningState = Run::State::kIsRunningSlave;
     return false;
   }
 
-  bool syncok = false;
-
-  if (HostCheck(fRemoteHost.c_str(), 1096)) {
-    MasterLog(eos_info("remote-sync host=%s:1096 is reachable",
-                       fRemoteHost.c_str()));
-    syncok = true;
-  } else {
-    MasterLog(eos_info("remote-sync host=%s:1096 is down", fRemoteHost.c_str()));
+  if (!connected) {
+    MasterLog(eos_warning("msg=\"remote changelog stream is down - taking "
+                          "over with the local changelogs\""));
   }
 
-  if (syncok) {
-    XrdCl::URL remoteSyncUrl(remoteSyncUrlString.c_str());
-    XrdCl::FileSystem FsSync(remoteSyncUrl);
-    XrdCl::StatInfo* sinfo = 0;
-
-    // Stat the two remote changelog files
-    if (FsSync.Stat(rfclf.c_str(), sinfo, 5).IsOK()) {
-      size_remote_file_changelog = sinfo->GetSize();
-
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-    } else {
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-    }
-
-    if (FsSync.Stat(rdclf.c_str(), sinfo, 5).IsOK()) {
-      size_remote_dir_changelog = sinfo->GetSize();
-
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-    } else {
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-    }
-
-    if (size_remote_file_changelog != size_local_file_changelog) {
-      MasterLog(eos_crit("slave=>master transition aborted - file changelog "
-                         "synchronization problem found - path=%s "
-                         "remote-size=%llu local-size=%llu", rfclf.c_str(),
-                         size_remote_file_changelog, size_local_file_changelog));
-      fRunningState = Run::State::kIsRunningSlave;
-      return false;
-    }
-
-    if (size_remote_dir_changelog != size_local_dir_changelog) {
-      MasterLog(eos_crit("slave=>master transition aborted - dir changelog "
-                         "synchronization problem found - path=%s "
-                         "remote-size=%llu local-size=%llu", rdclf.c_str(),
-                         size_remote_dir_changelog, size_local_dir_changelog));
-      fRunningState = Run::State::kIsRunningSlave;
-      return false;
-    }
-  }
+  StopChangeLogStreams();
+  struct stat buf;
 
   // Make a backup of the new target master file
   XrdOucString NsFileChangeLogFileCopy = fileSettings["changelog_path"].c_str();
@@ -1471,6 +1631,7 @@ Master::Slave2Master()
   }
 
   fRunningState = Run::State::kIsRunningMaster;
+  ServeChangeLogStreams();
   eos::common::ShellCmd
   scmd3(fHasSystemd ? "systemctl start eos@sync" :
         "service eos start sync");
@@ -1521,6 +1682,8 @@ bool
 Master::Master2MasterRO()
 {
   eos_alert("msg=\"rw-master to ro-master transition\"");
+  // Save the last configuration changes while still being the master
+  gOFS->ConfEngine->FlushAutoSave();
   fRunningState = Run::State::kIsTransition;
   // Convert the RW namespace into a read-only namespace
   // Wait that compacting is finished and block any further compacting
@@ -1583,6 +1746,17 @@ Master::MasterRO2Slave()
       Access::gStallGlobal = true;
     }
   }
+  // Follow the changelogs of the new master before booting from them
+  FollowChangeLogStreams();
+  bool connected = true;
+
+  if (!WaitChangeLogStreamsInSync(300, connected)) {
+    MasterLog(eos_warning("msg=\"booting with changelogs not in sync with "
+                          "master=%s\"", fMasterHost.c_str()));
+  }
+
+  // The deferred propagation needs the namespace lock to flush
+  StopDeferredAccounting();
   {
     // Convert the namespace
     eos::common::RWMutexWriteLock nsLock(gOFS->eosViewRWMutex);
@@ -1690,6 +1864,12 @@ Master::~Master()
     fCompactingThread = 0;
   }
 
+  if (fCheckpointThread) {
+    XrdSysThread::Cancel(fCheckpointThread);
+    XrdSysThread::Join(fCheckpointThread, 0);
+    fCheckpointThread = 0;
+  }
+
   if (fDevNull) {
     close(fDevNull);
     fDevNull = 0;
@@ -1832,6 +2012,12 @@ Master::BootNamespace()
   contSettings["changelog_path"] += ".mdlog";
   fileSettings["changelog_path"] += ".mdlog";
 
+  if (fCheckpointInterval) {
+    // Boot from the checkpoint images if they belong to the changelogs
+    contSettings["checkpoint_path"] = GetCheckpointPath("directories");
+    fileSettings["checkpoint_path"] = GetCheckpointPath("files");
+  }
+
   if (!IsMaster()) {
     contSettings["slave_mode"] = "true";
     contSettings["poll_interval_us"] = "1000";
@@ -1919,6 +2105,7 @@ Master::BootNamespace()
     }
 
     gOFS->BootContainerId = gOFS->eosDirectoryService->getFirstFreeId();
+    StartDeferredAccounting();
     MasterLog(eos_notice("eos directory view configure stopped after %d seconds",
                          (tstop - tstart)));
   } catch (eos::MDException& e) {
@@ -2078,162 +2265,79 @@ Master::WaitNamespaceFilesInSync(bool wait_files, bool wait_directories,
                                  unsigned int timeout)
 {
   time_t starttime = time(NULL);
-  // If possible evaluate if local and remote master files are in sync ...
   MasterLog(eos_info("msg=\"check ns file synchronization\""));
-  off_t size_local_file_changelog = 0;
-  off_t size_local_dir_changelog = 0;
-  off_t size_remote_file_changelog = 0;
-  off_t size_remote_dir_changelog = 0;
   unsigned long long lFileNamespaceInode = 0;
   unsigned long long lDirNamespaceInode = 0;
   struct stat buf;
-  std::string remoteSyncUrlString = "root://";
-  remoteSyncUrlString += fRemoteHost.c_str();
-  remoteSyncUrlString += ":1096";
-  remoteSyncUrlString += "//dummy";
-  std::string remoteSyncHostPort = fRemoteHost.c_str();
-  remoteSyncHostPort += ":1096";
-  std::string rfclf = gOFS->MgmMetaLogDir.c_str();
-  std::string rdclf = gOFS->MgmMetaLogDir.c_str();
-  rdclf += "/directories.";
-  rfclf += "/files.";
-  rdclf += fRemoteHost.c_str();
-  rfclf += fRemoteHost.c_str();
-  rdclf += ".mdlog";
-  rfclf += ".mdlog";
-  bool syncok = false;
-
-  if (HostCheck(fRemoteHost.c_str(), 1096)) {
-    syncok = true;
-    MasterLog(eos_info("remote-sync host=%s:1096 is reachable",
-                       fRemoteHost.c_str()));
-  } else {
-    MasterLog(eos_info("remote-sync host=%s:1096 is down", fRemoteHost.c_str()));
-  }
-
-  if (syncok) {
-    // Check once the remote size
-    XrdCl::URL remoteSyncUrl(remoteSyncUrlString.c_str());
-    XrdCl::FileSystem FsSync(remoteSyncUrl);
-    XrdCl::StatInfo* sinfo = 0;
 
-    // stat the two remote changelog files
-    if (FsSync.Stat(rfclf.c_str(), sinfo, 5).IsOK()) {
-      size_remote_file_changelog = sinfo->GetSize();
-
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
+  do {
+    // Wait that the inode changed - the changelog stream replaces the local
+    // files once the compacted master files are copied completely
+    if (!stat(gOFS->MgmNsFileChangeLogFile.c_str(), &buf)) {
+      lFileNamespaceInode = buf.st_ino;
     } else {
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-
-      MasterLog(eos_crit("remote stat failed for %s", rfclf.c_str()));
+      MasterLog(eos_crit("local stat failed for %s",
+                         gOFS->MgmNsFileChangeLogFile.c_str()));
       return false;
     }
 
-    if (FsSync.Stat(rdclf.c_str(), sinfo, 5).IsOK()) {
-      size_remote_dir_changelog = sinfo->GetSize();
-
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
+    if (!stat(gOFS->MgmNsDirChangeLogFile.c_str(), &buf)) {
+      lDirNamespaceInode = buf.st_ino;
     } else {
-      if (sinfo) {
-        delete sinfo;
-        sinfo = 0;
-      }
-
-      MasterLog(eos_crit("remote stat failed for %s", rdclf.c_str()));
+      MasterLog(eos_crit("local stat failed for %s",
+                         gOFS->MgmNsDirChangeLogFile.c_str()));
       return false;
     }
 
-    MasterLog(eos_info("remote files file=%llu dir=%llu",
-                       size_remote_file_changelog,
-                       size_remote_dir_changelog));
-
-    do {
-      // Wait that the inode changed and then check the local size and wait,
-      // that the local files is at least as big as the remote file
-      if (!stat(gOFS->MgmNsFileChangeLogFile.c_str(), &buf)) {
-        size_local_file_changelog = buf.st_size;
-        lFileNamespaceInode = buf.st_ino;
-      } else {
-        MasterLog(eos_crit("local stat failed for %s",
-                           gOFS->MgmNsFileChangeLogFile.c_str()));
+    if ((wait_directories) && (lDirNamespaceInode == fDirNamespaceInode)) {
+      // the inode didn't change yet
+      if (time(NULL) > (starttime + timeout)) {
+        MasterLog(eos_warning("timeout occured after %u seconds", timeout));
         return false;
       }
 
-      if (!stat(gOFS->MgmNsDirChangeLogFile.c_str(), &buf)) {
-        size_local_dir_changelog = buf.st_size;
-        lDirNamespaceInode = buf.st_ino;
-      } else {
-        MasterLog(eos_crit("local stat failed for %s",
-                           gOFS->MgmNsDirChangeLogFile.c_str()));
-        return false;
-      }
-
-      if ((wait_directories) && (lDirNamespaceInode == fDirNamespaceInode)) {
-        // the inode didn't change yet
-        if (time(NULL) > (starttime + timeout)) {
-          MasterLog(eos_warning("timeout occured after %u seconds", timeout));
-          return false;
-        }
-
-        MasterLog(eos_info("waiting for 'directories' inode change %llu=>%llu ",
-                           fDirNamespaceInode, lDirNamespaceInode));
-        XrdSysTimer sleeper;
-        sleeper.Wait(10000);
-        continue;
-      }
-
-      if ((wait_files) && (lFileNamespaceInode == fFileNamespaceInode)) {
-        // the inode didn't change yet
-        if (time(NULL) > (starttime + timeout)) {
-          MasterLog(eos_warning("timeout occured after %u seconds", timeout));
-          return false;
-        }
+      MasterLog(eos_info("waiting for 'directories' inode change %llu=>%llu ",
+                         fDirNamespaceInode, lDirNamespaceInode));
+      XrdSysTimer sleeper;
+      sleeper.Wait(10000);
+      continue;
+    }
 
-        MasterLog(eos_info("waiting for 'files' inode change %llu=>%llu ",
-                           fFileNamespaceInode, lFileNamespaceInode));
-        XrdSysTimer sleeper;
-        sleeper.Wait(10000);
-        continue;
+    if ((wait_files) && (lFileNamespaceInode == fFileNamespaceInode)) {
+      // the inode didn't change yet
+      if (time(NULL) > (starttime + timeout)) {
+        MasterLog(eos_warning("timeout occured after %u seconds", timeout));
+        return false;
       }
 
-      if (size_remote_file_changelog > size_local_file_changelog) {
-        if (time(NULL) > (starttime + timeout)) {
-          MasterLog(eos_warning("timeout occured after %u seconds", timeout));
-          return false;
-        }
+      MasterLog(eos_info("waiting for 'files' inode change %llu=>%llu ",
+                         fFileNamespaceInode, lFileNamespaceInode));
+      XrdSysTimer sleeper;
+      sleeper.Wait(10000);
+      continue;
+    }
 
-        XrdSysTimer sleeper;
-        sleeper.Wait(10000);
-        continue;
-      }
+    break;
+  } while (1);
 
-      if (size_remote_dir_changelog > size_local_dir_changelog) {
-        if (time(NULL) > (starttime + timeout)) {
-          MasterLog(eos_warning("timeout occured after %u seconds", timeout));
-          return false;
-        }
+  // Wait that the local files caught up with the master files
+  time_t now = time(NULL);
+  unsigned int left = ((starttime + timeout) > now) ?
+                      (starttime + timeout - now) : 0;
+  bool connected = true;
 
-        XrdSysTimer sleeper;
-        sleeper.Wait(10000);
-        continue;
-      }
+  if (!WaitChangeLogStreamsInSync(left, connected)) {
+    if (!connected) {
+      MasterLog(eos_warning("msg=\"remote changelog stream is not ok\""));
+    } else {
+      MasterLog(eos_warning("timeout occured after %u seconds", timeout));
+    }
 
-      MasterLog(eos_info("msg=\"ns files  synchronized\""));
-      return true;
-    } while (1);
-  } else {
-    MasterLog(eos_warning("msg=\"remote sync service is not ok\""));
     return false;
   }
+
+  MasterLog(eos_info("msg=\"ns files  synchronized\""));
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -2263,6 +2367,57 @@ Master::RedirectToRemoteMaster()
   }
 }
 
+//------------------------------------------------------------------------------
+// Switch the accounting listeners to deferred propagation
+//------------------------------------------------------------------------------
+void
+Master::StartDeferredAccounting()
+{
+  uint32_t interval_ms = 0;
+
+  if (getenv("EOS_NS_ACCOUNTING_DEFERRED_MS")) {
+    interval_ms = strtoul(getenv("EOS_NS_ACCOUNTING_DEFERRED_MS"), 0, 10);
+  }
+
+  if (!interval_ms) {
+    return;
+  }
+
+  eos::IDeferredAccounting* deferred[2] = {
+    dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosContainerAccounting),
+    dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosSyncTimeAccounting)
+  };
+
+  for (size_t i = 0; i < 2; ++i) {
+    if (deferred[i]) {
+      deferred[i]->setDeferred(&fNsLock, interval_ms);
+    }
+  }
+
+  if (deferred[0] || deferred[1]) {
+    MasterLog(eos_notice("msg=\"enabled deferred accounting propagation\" "
+                         "interval_ms=%u", interval_ms));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stop the deferred propagation and apply the pending changes
+//------------------------------------------------------------------------------
+void
+Master::StopDeferredAccounting()
+{
+  eos::IDeferredAccounting* deferred[2] = {
+    dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosContainerAccounting),
+    dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosSyncTimeAccounting)
+  };
+
+  for (size_t i = 0; i < 2; ++i) {
+    if (deferred[i]) {
+      deferred[i]->stopDeferred();
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Reboot slave namespace
 //------------------------------------------------------------------------------
@@ -2275,6 +2430,7 @@ Master::RebootSlaveNamespace()
       XrdSysMutexHelper lock(gOFS->InitializationMutex);
       gOFS->Initialized = gOFS->kBooting;
     }
+    StopDeferredAccounting();
     // now convert the namespace
     eos::common::RWMutexWriteLock nsLock(gOFS->eosViewRWMutex);
 
@@ -2419,6 +2575,152 @@ Master::ShutdownSlaveFollower()
   }
 }
 
+//------------------------------------------------------------------------------
+// Serve our changelog files to the slave
+//------------------------------------------------------------------------------
+void
+Master::ServeChangeLogStreams()
+{
+  StopChangeLogStreams();
+  std::string prefix = gOFS->MgmMetaLogDir.c_str();
+  fStreamServer->setChannel("files", prefix + "/files." + fThisHost.c_str() +
+                           ".mdlog");
+  fStreamServer->setChannel("directories", prefix + "/directories." +
+                           fThisHost.c_str() + ".mdlog");
+  MasterLog(eos_info("msg=\"serving changelog streams\" port=%d",
+                     fStreamServer->getPort()));
+}
+
+//------------------------------------------------------------------------------
+// Follow the changelog files of the current master
+//------------------------------------------------------------------------------
+void
+Master::FollowChangeLogStreams()
+{
+  fStreamServer->clearChannels();
+  StopChangeLogStreams();
+  std::string prefix = gOFS->MgmMetaLogDir.c_str();
+  fFileStream.reset(new eos::ChangeLogStreamClient(
+                      fMasterHost.c_str(), fStreamPort, "files",
+                      prefix + "/files." + fMasterHost.c_str() + ".mdlog",
+                      fStreamSecret));
+  fDirStream.reset(new eos::ChangeLogStreamClient(
+                     fMasterHost.c_str(), fStreamPort, "directories",
+                     prefix + "/directories." + fMasterHost.c_str() + ".mdlog",
+                     fStreamSecret));
+  fFileStream->start();
+  fDirStream->start();
+  MasterLog(eos_info("msg=\"following changelog streams\" master=%s port=%d",
+                     fMasterHost.c_str(), fStreamPort));
+}
+
+//------------------------------------------------------------------------------
+// Stop following the changelog files of the master
+//------------------------------------------------------------------------------
+void
+Master::StopChangeLogStreams()
+{
+  fFileStream.reset();
+  fDirStream.reset();
+}
+
+//------------------------------------------------------------------------------
+// Wait until the followed changelog files have caught up with the master
+//------------------------------------------------------------------------------
+bool
+Master::WaitChangeLogStreamsInSync(unsigned int timeout, bool& connected)
+{
+  connected = false;
+
+  if (!fFileStream || !fDirStream) {
+    return false;
+  }
+
+  time_t starttime = time(NULL);
+  eos::ChangeLogStreamClient::Status fst;
+  eos::ChangeLogStreamClient::Status dst;
+
+  do {
+    bool insync = fFileStream->waitInSync(2) && fDirStream->waitInSync(2);
+    fst = fFileStream->getStatus();
+    dst = fDirStream->getStatus();
+    connected = fst.connected && dst.connected;
+
+    if (insync) {
+      return true;
+    }
+
+    // Give up early if the master does not answer at all
+    if (!connected && (time(NULL) > (starttime + 10))) {
+      MasterLog(eos_warning("msg=\"changelog stream not connected\" master=%s "
+                            "files=\"%s\" directories=\"%s\"",
+                            fMasterHost.c_str(), fst.lastError.c_str(),
+                            dst.lastError.c_str()));
+      return false;
+    }
+  } while (time(NULL) <= (starttime + timeout));
+
+  MasterLog(eos_warning("msg=\"changelog stream not in sync\" master=%s "
+                        "files=%llu/%llu directories=%llu/%llu",
+                        fMasterHost.c_str(),
+                        (unsigned long long) fst.localOffset,
+                        (unsigned long long) fst.masterOffset,
+                        (unsigned long long) dst.localOffset,
+                        (unsigned long long) dst.masterOffset));
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Print the replication lag of the changelog streams
+//------------------------------------------------------------------------------
+void
+Master::PrintOutChangeLogStreams(XrdOucString& out)
+{
+  time_t now = time(NULL);
+
+  if (fFileStream && fDirStream) {
+    // As slave: lag of our copies behind the master files
+    eos::ChangeLogStreamClient* clients[2] = {fFileStream.get(), fDirStream.get()};
+
+    for (size_t i = 0; i < 2; ++i) {
+      eos::ChangeLogStreamClient::Status st = clients[i]->getStatus();
+      out += " stream:";
+      out += clients[i]->getChannel().c_str();
+
+      if (!st.connected) {
+        out += "=down";
+        continue;
+      }
+
+      uint64_t lag = (st.masterOffset > st.localOffset) ?
+                     (st.masterOffset - st.localOffset) : 0;
+      out += "=lag:";
+      out += std::to_string(lag).c_str();
+      out += "B/";
+      out += (int)(st.behindSince ? (now - st.behindSince) : 0);
+      out += "s";
+    }
+  } else {
+    // As master: lag of the acknowledged data of every slave
+    std::vector<eos::ChangeLogStreamServer::SubscriberStatus> subs =
+      fStreamServer->getSubscribers();
+
+    for (auto it = subs.begin(); it != subs.end(); ++it) {
+      uint64_t lag = (it->endOffset > it->ackedOffset) ?
+                     (it->endOffset - it->ackedOffset) : 0;
+      out += " stream:";
+      out += it->peer.c_str();
+      out += ":";
+      out += it->channel.c_str();
+      out += "=lag:";
+      out += std::to_string(lag).c_str();
+      out += "B/";
+      out += (int)((lag && it->lastAck) ? (now - it->lastAck) : 0);
+      out += "s";
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Post the namespace record errors to the master changelog
 //------------------------------------------------------------------------------
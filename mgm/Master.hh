@@ -32,6 +32,15 @@
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
 /*----------------------------------------------------------------------------*/
+#include <memory>
+/*----------------------------------------------------------------------------*/
+
+//! Forward declaration
+namespace eos
+{
+  class ChangeLogStreamServer;
+  class ChangeLogStreamClient;
+}
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -292,16 +301,29 @@ class Master : public eos::common::LogId
   bool fCompactDirectories; ///< compact the directories changelog file if true
   pthread_t fThread; ///< heartbeat thread id
   pthread_t fCompactingThread; ///< online compacting thread id
+  pthread_t fCheckpointThread; ///< namespace checkpoint thread id
+  time_t fCheckpointInterval; ///< checkpoint interval, 0 if disabled
   //! compacting ratio for file changelog e.g. 4:1 => 4 times smaller after compaction
   double fCompactingRatio;
   //! compacting ratio for directory changelog e.g. 4:1 => 4 times smaller after compaction
   double fDirCompactingRatio;
+  std::string fCompactingPhase; ///< phase of the running compaction
+  int fCompactingRound; ///< catch-up round of the running compaction
+  uint64_t fCompactingBehind; ///< changelog bytes not copied yet
+  long long fCompactingLockHold; ///< write lock hold of the last commit in ms
   XrdSysLogger* fDevNullLogger; ///< /dev/null logger
   XrdSysError* fDevNullErr; ///< /dev/null error
   unsigned long long fFileNamespaceInode; ///< inode number of the file namespace file
   unsigned long long fDirNamespaceInode; ///< inode number of the dir  namespace file
   bool fAutoRepair; ///< enable auto-repair to skip over broken records during compaction
   bool fHasSystemd; ///< machine has systemd (as opposed to sysv init)
+  int fStreamPort; ///< port of the changelog stream server
+  //! serves our changelogs as master
+  std::unique_ptr<eos::ChangeLogStreamServer> fStreamServer;
+  std::string fStreamSecret; ///< symkey authenticating the changelog streams
+  //! followers of the master file/directory changelogs as slave
+  std::unique_ptr<eos::ChangeLogStreamClient> fFileStream;
+  std::unique_ptr<eos::ChangeLogStreamClient> fDirStream;
 
   //----------------------------------------------------------------------------
   // Lock class wrapper used by the namespace
@@ -417,6 +439,48 @@ class Master : public eos::common::LogId
   //----------------------------------------------------------------------------
   bool IsCompacting();
 
+  //----------------------------------------------------------------------------
+  //! Switch the accounting listeners to deferred propagation if configured
+  //! by EOS_NS_ACCOUNTING_DEFERRED_MS
+  //----------------------------------------------------------------------------
+  void StartDeferredAccounting();
+
+  //----------------------------------------------------------------------------
+  //! Stop the deferred propagation and apply the pending changes. Must be
+  //! called without holding the namespace lock.
+  //----------------------------------------------------------------------------
+  void StopDeferredAccounting();
+
+  //----------------------------------------------------------------------------
+  //! Serve our changelog files to the slave and stop following a remote master
+  //----------------------------------------------------------------------------
+  void ServeChangeLogStreams();
+
+  //----------------------------------------------------------------------------
+  //! Follow the changelog files of the current master into the local ones
+  //----------------------------------------------------------------------------
+  void FollowChangeLogStreams();
+
+  //----------------------------------------------------------------------------
+  //! Stop following the changelog files of the master
+  //----------------------------------------------------------------------------
+  void StopChangeLogStreams();
+
+  //----------------------------------------------------------------------------
+  //! Wait until the followed changelog files have caught up with the master
+  //!
+  //! @param timeout max. time to wait in seconds
+  //! @param connected returns false if the master stream was not reachable
+  //!
+  //! @return true if in sync, otherwise false
+  //----------------------------------------------------------------------------
+  bool WaitChangeLogStreamsInSync(unsigned int timeout, bool& connected);
+
+  //----------------------------------------------------------------------------
+  //! Print the replication lag of the changelog streams
+  //----------------------------------------------------------------------------
+  void PrintOutChangeLogStreams(XrdOucString& out);
+
   //----------------------------------------------------------------------------
   //! Check if we are currently blocking the compacting
   //----------------------------------------------------------------------------
@@ -434,6 +498,15 @@ class Master : public eos::common::LogId
   //----------------------------------------------------------------------------
   void WaitCompactingFinished();
 
+  //----------------------------------------------------------------------------
+  //! Publish the progress of the running compaction
+  //!
+  //! @param phase prepare, snapshot, catchup, commit or remap
+  //! @param round number of catch-up rounds done
+  //! @param behind changelog bytes not copied yet
+  //----------------------------------------------------------------------------
+  void SetCompactingProgress(const char* phase, int round, uint64_t behind);
+
   //----------------------------------------------------------------------------
   //! Compacting thread function
   //----------------------------------------------------------------------------
@@ -453,6 +526,27 @@ class Master : public eos::common::LogId
   //! Online compacting thread start function
   //----------------------------------------------------------------------------
   static void* StaticOnlineCompacting(void*);
+
+  //----------------------------------------------------------------------------
+  //! Checkpoint thread start function
+  //----------------------------------------------------------------------------
+  static void* StaticCheckpointing(void*);
+
+  //----------------------------------------------------------------------------
+  //! Checkpoint thread function - periodically writes the checkpoint images
+  //! of the changelogs we are running on, both as master and as slave
+  //----------------------------------------------------------------------------
+  void* Checkpointing();
+
+  //----------------------------------------------------------------------------
+  //! Get the checkpoint image path of a changelog type
+  //!
+  //! @param name changelog type ("files" or "directories")
+  //!
+  //! @return image path, it does not depend on the master host since an image
+  //!         stays valid for the copy of a changelog made at a transition
+  //----------------------------------------------------------------------------
+  std::string GetCheckpointPath(const char* name);
 };
 
 EOSMGMNAMESPACE_END
@@ -42,10 +42,44 @@
 #include <map>
 #include <string>
 #include <math.h>
+#include <stdio.h>
+#include <atomic>
 #include <json/json.h>
 
 EOSMGMNAMESPACE_BEGIN
 
+#ifndef __APPLE__
+//! Number of proc commands currently streaming their result
+static std::atomic<int> sActiveStreams(0);
+
+//------------------------------------------------------------------------------
+// Write function of the stdout FILE of a streamed proc command - seals the
+// output and pushes it into the result stream
+//------------------------------------------------------------------------------
+static ssize_t
+StreamedStdoutWrite(void* cookie, const char* buf, size_t size)
+{
+  ProcResultStream* stream = (ProcResultStream*) cookie;
+  std::string chunk;
+  chunk.reserve(size + size / 16);
+
+  for (size_t i = 0; i < size; ++i) {
+    if (buf[i] == '&') {
+      chunk += "#and#";
+    } else {
+      chunk += buf[i];
+    }
+  }
+
+  if (!stream->Write(chunk)) {
+    errno = ECANCELED;
+    return -1;
+  }
+
+  return size;
+}
+#endif
+
 //------------------------------------------------------------------------------
 //                            *** ProcInterface ***
 //------------------------------------------------------------------------------
@@ -231,6 +265,9 @@ ProcCommand::ProcCommand()
   ininfo = 0;
   fstdout = fstderr = fresultStream = 0;
   fstdoutfilename = fstderrfilename = fresultStreamfilename = "";
+  mStreaming = false;
+  mStreamErr = 0;
+  mStreamErrLen = 0;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -241,6 +278,8 @@ ProcCommand::ProcCommand()
 /*----------------------------------------------------------------------------*/
 ProcCommand::~ProcCommand()
 {
+  StopStream();
+
   if (fstdout) {
     fclose(fstdout);
     fstdout = 0;
@@ -259,6 +298,11 @@ ProcCommand::~ProcCommand()
     unlink(fresultStreamfilename.c_str());
   }
 
+  if (mStreamErr) {
+    free(mStreamErr);
+    mStreamErr = 0;
+  }
+
   if (pOpaque) {
     delete pOpaque;
     pOpaque = 0;
@@ -275,6 +319,38 @@ ProcCommand::~ProcCommand()
 bool
 ProcCommand::OpenTemporaryOutputFiles()
 {
+#ifndef __APPLE__
+
+  if (mStream) {
+    // streamed results: stdout goes into the result stream, stderr is small
+    // and kept in memory until the command has finished
+    cookie_io_functions_t io_funcs;
+    memset(&io_funcs, 0, sizeof(io_funcs));
+    io_funcs.write = StreamedStdoutWrite;
+    fstdout = fopencookie(mStream.get(), "w", io_funcs);
+    fstderr = open_memstream(&mStreamErr, &mStreamErrLen);
+
+    if ((!fstdout) || (!fstderr)) {
+      if (fstdout) {
+        fclose(fstdout);
+        fstdout = 0;
+      }
+
+      if (fstderr) {
+        fclose(fstderr);
+        fstderr = 0;
+      }
+
+      return false;
+    }
+
+    setvbuf(fstdout, 0, _IOFBF, 64 * 1024);
+    std::string prefix = "&mgm.proc.stdout=";
+    mStream->Write(prefix);
+    return true;
+  }
+
+#endif
   char tmpdir [4096];
   snprintf(tmpdir, sizeof(tmpdir) - 1, "/tmp/eos.mgm/%llu",
            (unsigned long long) XrdSysThread::ID());
@@ -548,6 +624,10 @@ ProcCommand::open(const char* inpath,
       Whoami();
       mDoSort = false;
     } else if (mCmd == "find") {
+      if (StreamCommand(&ProcCommand::Find)) {
+        return SFS_OK;
+      }
+
       Find();
     } else if (mCmd == "map") {
       Map();
@@ -595,7 +675,10 @@ ProcCommand::open(const char* inpath,
 int
 ProcCommand::read(XrdSfsFileOffset mOffset, char* buff, XrdSfsXferSize blen)
 {
-  if (fresultStream) {
+  if (mStream) {
+    // streamed results go here ...
+    return mStream->Read(mOffset, buff, blen);
+  } else if (fresultStream) {
     // file based results go here ...
     if ((fseek(fresultStream, mOffset, 0)) == 0) {
       size_t nread = fread(buff, 1, blen, fresultStream);
@@ -623,7 +706,9 @@ ProcCommand::read(XrdSfsFileOffset mOffset, char* buff, XrdSfsXferSize blen)
 /*----------------------------------------------------------------------------*/
 /**
  * return stat information for the result stream to tell the client the size
- * of the proc output
+ * of the proc output - for streamed results this waits for the command to
+ * finish, the output not fitting into the stream buffer is spilled to a
+ * temporary file meanwhile
  * @param buf stat structure to fill
  * @return SFS_OK in any case
  */
@@ -633,7 +718,7 @@ int
 ProcCommand::stat(struct stat* buf)
 {
   memset(buf, 0, sizeof(struct stat));
-  buf->st_size = mLen;
+  buf->st_size = mStream ? mStream->GetSize() : mLen;
   return SFS_OK;
 }
 
@@ -647,6 +732,9 @@ ProcCommand::stat(struct stat* buf)
 int
 ProcCommand::close()
 {
+  // a client closing before the end of a streamed result cancels the command
+  StopStream();
+
   if (!mClosed) {
     // only instance users or sudoers can add to the log book
     if ((pVid->uid <= 2) || (pVid->sudoer)) {
@@ -936,6 +1024,123 @@ ProcCommand::MakeResult()
 }
 
 
+/*----------------------------------------------------------------------------*/
+/**
+ * Run a command in a separate thread streaming its result to the client. Only
+ * the default output format is streamed, other formats need the complete
+ * result. At most EOS_MGM_PROC_STREAM_MAX commands (default 16) stream at the
+ * same time, further ones run inline with a file based result.
+ * @param cmd command to run
+ * @return true if the command has been started otherwise false
+ */
+
+/*----------------------------------------------------------------------------*/
+bool
+ProcCommand::StreamCommand(int (ProcCommand::*cmd)())
+{
+#ifdef __APPLE__
+  return false;
+#else
+
+  if (!mStreaming || mFuseFormat || mStream) {
+    return false;
+  }
+
+  static size_t sMaxBytes = 0;
+  static int sMaxStreams = 0;
+  static int sTimeout = 0;
+
+  if (!sMaxBytes) {
+    const char* ptr = getenv("EOS_MGM_PROC_STREAM_BUFFER");
+    long long max_bytes = ptr ? strtoll(ptr, 0, 10) : 0;
+    sMaxBytes = (max_bytes > 0) ? max_bytes : (4 * 1024 * 1024);
+    ptr = getenv("EOS_MGM_PROC_STREAM_MAX");
+    int max_streams = ptr ? atoi(ptr) : 0;
+    sMaxStreams = (max_streams > 0) ? max_streams : 16;
+    ptr = getenv("EOS_MGM_PROC_STREAM_TIMEOUT");
+    int timeout = ptr ? atoi(ptr) : 0;
+    sTimeout = (timeout > 0) ? timeout : 300;
+  }
+
+  int active = sActiveStreams.load();
+
+  do {
+    if (active >= sMaxStreams) {
+      eos_debug("msg=\"too many streamed proc results, running inline\" "
+                "active=%d", active);
+      return false;
+    }
+  } while (!sActiveStreams.compare_exchange_weak(active, active + 1));
+
+  mStream.reset(new ProcResultStream(sMaxBytes, sTimeout));
+  mStreamThread = std::thread(&ProcCommand::RunStreamedCommand, this, cmd);
+  return true;
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * Body of the thread running a streamed command. The stdout of the command
+ * has been streamed while it was running, stderr and retc are appended at
+ * the end. Commands failing before opening their output produce an in-memory
+ * result which is streamed as a whole.
+ * @param cmd command to run
+ */
+
+/*----------------------------------------------------------------------------*/
+void
+ProcCommand::RunStreamedCommand(int (ProcCommand::*cmd)())
+{
+  (this->*cmd)();
+  std::string tail;
+
+  if (fstdout) {
+    // flushes the remaining stdout into the stream
+    fclose(fstdout);
+    fstdout = 0;
+    fclose(fstderr);
+    fstderr = 0;
+    XrdOucString serr = "";
+
+    if (mStreamErr) {
+      serr = std::string(mStreamErr, mStreamErrLen).c_str();
+      free(mStreamErr);
+      mStreamErr = 0;
+      mStreamErrLen = 0;
+    }
+
+    tail = "&mgm.proc.stderr=";
+    tail += XrdMqMessage::Seal(serr);
+    tail += "&mgm.proc.retc=";
+    tail += std::to_string(retc);
+  } else {
+    MakeResult();
+    tail = mResultStream.c_str();
+  }
+
+  mStream->Write(tail);
+  mStream->Finish();
+  sActiveStreams--;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * Cancel a streamed command and wait for its thread to finish
+ */
+
+/*----------------------------------------------------------------------------*/
+void
+ProcCommand::StopStream()
+{
+  if (mStream) {
+    mStream->Cancel();
+  }
+
+  if (mStreamThread.joinable()) {
+    mStreamThread.join();
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * Try to detect and convert a monitor output format and convert it into a
@@ -27,10 +27,13 @@
 #include "mgm/Namespace.hh"
 #include "common/Logging.hh"
 #include "common/Mapping.hh"
+#include "mgm/ProcResultStream.hh"
 #include "proc/proc_fs.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 #include "XrdSec/XrdSecEntity.hh"
+#include <memory>
+#include <thread>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -147,6 +150,17 @@ public:
   //----------------------------------------------------------------------------
   int close();
 
+  //----------------------------------------------------------------------------
+  //! Allow streaming of the result to the client while the command is still
+  //! running. Only used for commands opened by a client, internal callers
+  //! get the complete result after open.
+  //----------------------------------------------------------------------------
+  void
+  EnableStreaming()
+  {
+    mStreaming = true;
+  }
+
   //----------------------------------------------------------------------------
   //! Add stdout,stderr to an external stdout,stderr variable
   //----------------------------------------------------------------------------
@@ -158,7 +172,8 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Open temporary outputfiles for find commands
+  //! Open temporary outputfiles for find commands. If the result is streamed
+  //! the output goes into the result stream instead.
   //!
   //! @return true if successful otherwise false
   //----------------------------------------------------------------------------
@@ -295,6 +310,16 @@ private:
   XrdOucString fresultStreamfilename;
   XrdOucErrInfo* mError;
 
+  //----------------------------------------------------------------------------
+  //! Streamed results: the command runs in its own thread and its stdout is
+  //! pushed through a bounded buffer which is drained by the client reads
+  //----------------------------------------------------------------------------
+  bool mStreaming; //< streaming is allowed for this command
+  std::unique_ptr<ProcResultStream> mStream; //< stream if the result is streamed
+  std::thread mStreamThread; //< thread running the streamed command
+  char* mStreamErr; //< stderr buffer of the streamed command
+  size_t mStreamErrLen; //< length of the stderr buffer
+
   XrdOucString mComment; //< comment issued by the user for the proc comamnd
   time_t mExecTime; //< execution time measured for the proc command
 
@@ -429,6 +454,28 @@ private:
                    const std::string& twindow_val,
                    const std::set<std::string>& excl_xattr);
 
+  //----------------------------------------------------------------------------
+  //! Run a command in a separate thread streaming its result to the client
+  //!
+  //! @param cmd command to run
+  //!
+  //! @return true if the command has been started, false if the result
+  //!         cannot be streamed and the command has to run inline
+  //----------------------------------------------------------------------------
+  bool StreamCommand(int (ProcCommand::*cmd)());
+
+  //----------------------------------------------------------------------------
+  //! Body of the thread running a streamed command
+  //!
+  //! @param cmd command to run
+  //----------------------------------------------------------------------------
+  void RunStreamedCommand(int (ProcCommand::*cmd)());
+
+  //----------------------------------------------------------------------------
+  //! Cancel a streamed command and wait for its thread
+  //----------------------------------------------------------------------------
+  void StopStream();
+
 public:
 
   //----------------------------------------------------------------------------
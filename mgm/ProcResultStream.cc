@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+// File: ProcResultStream.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/ProcResultStream.hh"
+#include "common/Logging.hh"
+#include <errno.h>
+#include <string.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProcResultStream::ProcResultStream(size_t max_bytes, int timeout):
+  mCond(0), mFrontPos(0), mBuffered(0), mMaxBytes(max_bytes), mProduced(0),
+  mReadOffset(0), mLastOffset(0), mSpill(0), mSpilled(0), mSpillRead(0),
+  mTimeout(timeout), mSizeWanted(false), mDone(false), mCancelled(false)
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ProcResultStream::~ProcResultStream()
+{
+  if (mSpill) {
+    fclose(mSpill);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait for the reader to drain a full buffer
+//------------------------------------------------------------------------------
+void
+ProcResultStream::WaitReader()
+{
+  off_t offset = mReadOffset;
+
+  if (mCond.Wait(mTimeout) && (offset == mReadOffset) && !mSizeWanted &&
+      !mCancelled) {
+    eos_static_err("msg=\"cancel streamed proc result not read by the "
+                   "client\" timeout=%d produced=%llu read=%lld", mTimeout,
+                   (unsigned long long) mProduced, (long long) mReadOffset);
+    mCancelled = true;
+    mChunks.clear();
+    mBuffered = 0;
+    mFrontPos = 0;
+    mCond.Broadcast();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Append a chunk
+//------------------------------------------------------------------------------
+bool
+ProcResultStream::Write(std::string& chunk)
+{
+  if (chunk.empty()) {
+    return true;
+  }
+
+  XrdSysCondVarHelper lock(mCond);
+
+  while (!mCancelled && !mSizeWanted && mBuffered &&
+         (mBuffered + chunk.size() > mMaxBytes)) {
+    WaitReader();
+  }
+
+  if (mCancelled) {
+    return false;
+  }
+
+  if (mSpill || (mSizeWanted && mBuffered &&
+                 (mBuffered + chunk.size() > mMaxBytes))) {
+    // once spilling everything goes to the file to keep the order
+    if (!mSpill && !(mSpill = tmpfile())) {
+      eos_static_err("msg=\"failed to create spill file of a streamed proc "
+                     "result\" errno=%d", errno);
+      mCancelled = true;
+      mCond.Broadcast();
+      return false;
+    }
+
+    if ((fseek(mSpill, mSpilled, SEEK_SET)) ||
+        (fwrite(chunk.c_str(), 1, chunk.size(), mSpill) != chunk.size())) {
+      eos_static_err("msg=\"failed to spill a streamed proc result\" "
+                     "errno=%d", errno);
+      mCancelled = true;
+      mCond.Broadcast();
+      return false;
+    }
+
+    mSpilled += chunk.size();
+    mProduced += chunk.size();
+    chunk.clear();
+    mCond.Broadcast();
+    return true;
+  }
+
+  mBuffered += chunk.size();
+  mProduced += chunk.size();
+  mChunks.push_back(std::string());
+  mChunks.back().swap(chunk);
+  mCond.Broadcast();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Mark the end of the result
+//------------------------------------------------------------------------------
+void
+ProcResultStream::Finish()
+{
+  XrdSysCondVarHelper lock(mCond);
+  mDone = true;
+  mCond.Broadcast();
+}
+
+//------------------------------------------------------------------------------
+// Cancel the stream
+//------------------------------------------------------------------------------
+void
+ProcResultStream::Cancel()
+{
+  XrdSysCondVarHelper lock(mCond);
+  mCancelled = true;
+  mChunks.clear();
+  mBuffered = 0;
+  mFrontPos = 0;
+  mCond.Broadcast();
+}
+
+//------------------------------------------------------------------------------
+// Check if the stream has been cancelled
+//------------------------------------------------------------------------------
+bool
+ProcResultStream::IsCancelled()
+{
+  XrdSysCondVarHelper lock(mCond);
+  return mCancelled;
+}
+
+//------------------------------------------------------------------------------
+// Copy buffered or spilled data
+//------------------------------------------------------------------------------
+size_t
+ProcResultStream::Consume(char* buff, size_t blen)
+{
+  size_t nread = 0;
+
+  while ((nread < blen) && !mChunks.empty()) {
+    std::string& front = mChunks.front();
+    size_t ncopy = front.size() - mFrontPos;
+
+    if (ncopy > (blen - nread)) {
+      ncopy = blen - nread;
+    }
+
+    memcpy(buff + nread, front.c_str() + mFrontPos, ncopy);
+    nread += ncopy;
+    mFrontPos += ncopy;
+    mBuffered -= ncopy;
+
+    if (mFrontPos == front.size()) {
+      mChunks.pop_front();
+      mFrontPos = 0;
+    }
+  }
+
+  // spilled data follows the buffered one
+  if ((nread < blen) && mChunks.empty() && (mSpillRead < mSpilled)) {
+    size_t ncopy = mSpilled - mSpillRead;
+
+    if (ncopy > (blen - nread)) {
+      ncopy = blen - nread;
+    }
+
+    if ((fseek(mSpill, mSpillRead, SEEK_SET) == 0) &&
+        (fread(buff + nread, 1, ncopy, mSpill) == ncopy)) {
+      nread += ncopy;
+      mSpillRead += ncopy;
+    } else {
+      eos_static_err("msg=\"failed to read spilled proc result\" errno=%d",
+                     errno);
+      mCancelled = true;
+    }
+  }
+
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Read the next part of the result
+//------------------------------------------------------------------------------
+int
+ProcResultStream::Read(off_t offset, char* buff, size_t blen)
+{
+  XrdSysCondVarHelper lock(mCond);
+
+  if ((offset > mReadOffset) || (offset < mLastOffset)) {
+    eos_static_err("msg=\"non-sequential read of a streamed proc result\" "
+                   "offset=%lld expected=%lld", (long long) offset,
+                   (long long) mReadOffset);
+    return -1;
+  }
+
+  size_t nread = 0;
+
+  if (offset < mReadOffset) {
+    // read again (part of) the data returned by the last read
+    nread = mReadOffset - offset;
+
+    if (nread > blen) {
+      nread = blen;
+    }
+
+    memcpy(buff, mLastRead.c_str() + (offset - mLastOffset), nread);
+  } else {
+    // the command may take long to produce, only Cancel stops the wait
+    while (!mBuffered && (mSpillRead == mSpilled) && !mDone && !mCancelled) {
+      mCond.Wait();
+    }
+  }
+
+  if (mCancelled) {
+    return -1;
+  }
+
+  size_t nnew = Consume(buff + nread, blen - nread);
+
+  if (mCancelled) {
+    return -1;
+  }
+
+  if (nnew) {
+    nread += nnew;
+    mLastRead.assign(buff, nread);
+    mLastOffset = offset;
+    mReadOffset = offset + nread;
+    // wake up a blocked producer
+    mCond.Broadcast();
+  }
+
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Wait for the end of the result and return its size
+//------------------------------------------------------------------------------
+size_t
+ProcResultStream::GetSize()
+{
+  XrdSysCondVarHelper lock(mCond);
+  mSizeWanted = true;
+  // wake up a producer blocked on a full buffer
+  mCond.Broadcast();
+
+  while (!mDone && !mCancelled) {
+    mCond.Wait();
+  }
+
+  return mProduced;
+}
+
+EOSMGMNAMESPACE_END
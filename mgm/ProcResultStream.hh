@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+// File: ProcResultStream.hh
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_PROCRESULTSTREAM__HH__
+#define __EOSMGM_PROCRESULTSTREAM__HH__
+
+#include "mgm/Namespace.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <stdio.h>
+#include <sys/types.h>
+#include <deque>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Bounded producer/consumer buffer for the result of a proc command.
+//!
+//! The command running in its own thread appends chunks while the client
+//! drains them with sequential reads. The producer blocks when more than the
+//! configured number of bytes is buffered, the reader blocks until data is
+//! available or the result is complete. Cancelling the stream (client went
+//! away) unblocks both sides and makes further writes fail.
+//!
+//! The data returned by the last read is kept so that the client can read it
+//! again e.g. after a retry. Asking for the size makes the producer spill
+//! what does not fit into the buffer into a temporary file until the result is
+//! complete. A producer blocked on a full buffer which the client does not
+//! read for longer than the timeout cancels the stream. A reader waits for a
+//! slow command as long as it runs.
+//------------------------------------------------------------------------------
+class ProcResultStream
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_bytes max. number of bytes buffered before writers block
+  //! @param timeout seconds a producer blocked on a full buffer waits for
+  //!        the client to read before the stream is cancelled
+  //----------------------------------------------------------------------------
+  ProcResultStream(size_t max_bytes, int timeout);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ProcResultStream();
+
+  //----------------------------------------------------------------------------
+  //! Append a chunk, blocks while the buffer is full
+  //!
+  //! @param chunk data to append, moved into the buffer
+  //!
+  //! @return false if the stream has been cancelled
+  //----------------------------------------------------------------------------
+  bool Write(std::string& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Mark the end of the result
+  //----------------------------------------------------------------------------
+  void Finish();
+
+  //----------------------------------------------------------------------------
+  //! Cancel the stream e.g. when the client closes before the end
+  //----------------------------------------------------------------------------
+  void Cancel();
+
+  //----------------------------------------------------------------------------
+  //! Check if the stream has been cancelled
+  //----------------------------------------------------------------------------
+  bool IsCancelled();
+
+  //----------------------------------------------------------------------------
+  //! Read the next part of the result, blocks until data is available
+  //!
+  //! @param offset offset of the read, has to follow the previous read or
+  //!        fall into the data returned by it
+  //! @param buff output buffer
+  //! @param blen size of the output buffer
+  //!
+  //! @return number of bytes read, 0 at the end of the result, -1 for a read
+  //!         at an offset no longer available or a cancelled stream
+  //----------------------------------------------------------------------------
+  int Read(off_t offset, char* buff, size_t blen);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the end of the result and return its size. The data not fitting
+  //! into the buffer is spilled into a temporary file meanwhile.
+  //!
+  //! @return size of the complete result, the size produced so far if the
+  //!         stream has been cancelled
+  //----------------------------------------------------------------------------
+  size_t GetSize();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Wait for the reader to drain a full buffer, cancels the stream if the
+  //! client read nothing within the timeout - needs mCond locked
+  //----------------------------------------------------------------------------
+  void WaitReader();
+
+  //----------------------------------------------------------------------------
+  //! Copy buffered or spilled data - needs mCond locked
+  //!
+  //! @return number of bytes copied
+  //----------------------------------------------------------------------------
+  size_t Consume(char* buff, size_t blen);
+
+  XrdSysCondVar mCond; ///< Protects the members and signals both sides
+  std::deque<std::string> mChunks; ///< Buffered chunks
+  size_t mFrontPos; ///< Read position in the first chunk
+  size_t mBuffered; ///< Bytes buffered and not yet read
+  size_t mMaxBytes; ///< Max. bytes buffered before writers block
+  size_t mProduced; ///< Bytes written so far
+  off_t mReadOffset; ///< Offset of the next sequential read
+  std::string mLastRead; ///< Data returned by the last read
+  off_t mLastOffset; ///< Offset of the data returned by the last read
+  FILE* mSpill; ///< Data written after the buffer got full while spilling
+  size_t mSpilled; ///< Bytes written to the spill file
+  size_t mSpillRead; ///< Bytes read from the spill file
+  int mTimeout; ///< Seconds a blocked producer waits for the reader
+  bool mSizeWanted; ///< Writers spill instead of blocking
+  bool mDone; ///< The producer has finished
+  bool mCancelled; ///< The consumer went away or stopped reading
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
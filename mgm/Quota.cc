@@ -1873,6 +1873,16 @@ Quota::FileAccess(Scheduler::AccessArguments* args)
   return Scheduler::FileAccess(args);
 }
 
+//------------------------------------------------------------------------------
+// Take the decisions from where to access a file for several transfers
+//------------------------------------------------------------------------------
+size_t
+Quota::FileAccessBatch(Scheduler::AccessArguments* args,
+                       std::vector<unsigned long>& fsindexes)
+{
+  return Scheduler::FileAccessBatch(args, fsindexes);
+}
+
 //------------------------------------------------------------------------------
 // Create quota node for path
 //------------------------------------------------------------------------------
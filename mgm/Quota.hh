@@ -585,6 +585,20 @@ public:
   //----------------------------------------------------------------------------
   static int FileAccess(Scheduler::AccessArguments* args);
 
+  //----------------------------------------------------------------------------
+  //! Take the decisions from where to access a file for several transfers at
+  //! once. The core of the implementation is in the Scheduler.
+  //!
+  //! @param args access arguments shared by all the transfers
+  //! @param fsindexes one entry per transfer, filled with the index in
+  //!        args->locationsfs of the filesystem to read from
+  //!
+  //! @return number of transfers for which an access was scheduled
+  //! @warning Must be called with a lock on the FsView::gFsView::ViewMutex
+  //----------------------------------------------------------------------------
+  static size_t FileAccessBatch(Scheduler::AccessArguments* args,
+                                std::vector<unsigned long>& fsindexes);
+
   static gid_t gProjectId; ///< gid indicating project quota
   static eos::common::RWMutex pMapMutex; ///< mutex to protect access to pMapQuota
 
@@ -0,0 +1,451 @@
+//------------------------------------------------------------------------------
+// File: RateLimiter.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/RateLimiter.hh"
+#include "mgm/Stat.hh"
+#include "common/Mapping.hh"
+#include "common/Logging.hh"
+#include "common/StringConversion.hh"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Wildcard or specific user rule of an operation
+//------------------------------------------------------------------------------
+const RateLimiter::RateRule*
+RateLimiter::OpRules::UserRule(uid_t uid) const
+{
+  std::map<uid_t, RateRule>::const_iterator it = users.find(uid);
+
+  if (it != users.end()) {
+    return &it->second;
+  }
+
+  return userAll.rate > 0 ? &userAll : 0;
+}
+
+//------------------------------------------------------------------------------
+// Wildcard or specific group rule of an operation
+//------------------------------------------------------------------------------
+const RateLimiter::RateRule*
+RateLimiter::OpRules::GroupRule(gid_t gid) const
+{
+  std::map<gid_t, RateRule>::const_iterator it = groups.find(gid);
+
+  if (it != groups.end()) {
+    return &it->second;
+  }
+
+  return groupAll.rate > 0 ? &groupAll : 0;
+}
+
+//------------------------------------------------------------------------------
+// Compiled rules of an operation
+//------------------------------------------------------------------------------
+const RateLimiter::OpRules*
+RateLimiter::Rules::GetOp(int tag) const
+{
+  if ((tag < 0) || ((size_t) tag >= ops.size()) || !ops[tag].active) {
+    return 0;
+  }
+
+  return &ops[tag];
+}
+
+//------------------------------------------------------------------------------
+// Find a bucket
+//------------------------------------------------------------------------------
+TokenBucket*
+RateLimiter::Table::FindBucket(uint64_t key) const
+{
+  auto it = buckets.find(key);
+  return (it != buckets.end()) ? it->second.get() : 0;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RateLimiter::RateLimiter():
+  mActive(false), mAdmitted(0), mRejected(0), mAdmitNs(0)
+{
+  std::shared_ptr<Table> table(new Table());
+  table->rules.reset(new Rules());
+  mTable = table;
+}
+
+//------------------------------------------------------------------------------
+// Current time in microseconds
+//------------------------------------------------------------------------------
+int64_t
+RateLimiter::Now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Create a bucket for a rule
+//------------------------------------------------------------------------------
+TokenBucket*
+RateLimiter::NewBucket(const RateRule& rule, int64_t now_us)
+{
+  double rate = rule.rate * kTolerance;
+  return new TokenBucket(rate, rate * kBurstTime, rule.key, now_us);
+}
+
+//------------------------------------------------------------------------------
+// Compile the rate rules out of the stall rules
+//------------------------------------------------------------------------------
+void
+RateLimiter::Compile(const std::map<std::string, std::string>& rules,
+                     const std::map<std::string, std::string>& comments)
+{
+  std::shared_ptr<Rules> compiled(new Rules());
+  std::vector<OpRules>& ops = compiled->ops;
+
+  for (auto it = rules.begin(); it != rules.end(); ++it) {
+    if (it->first.find("rate:") != 0) {
+      continue;
+    }
+
+    // rate:<user|group>:<id|*>:<operation>
+    std::vector<std::string> tokens;
+    std::string delimiter = ":";
+    eos::common::StringConversion::Tokenize(it->first, tokens, delimiter);
+    double rate = strtod(it->second.c_str(), 0);
+
+    if ((tokens.size() != 4) || ((tokens[1] != "user") &&
+                                 (tokens[1] != "group")) || (rate <= 0)) {
+      eos_static_err("msg=\"ignoring invalid rate rule\" rule=%s value=%s",
+                     it->first.c_str(), it->second.c_str());
+      continue;
+    }
+
+    bool group = (tokens[1] == "group");
+    bool all = (tokens[2] == "*");
+    uint32_t id = 0;
+
+    if (!all) {
+      char* end = 0;
+      id = strtoul(tokens[2].c_str(), &end, 10);
+
+      if (!end || *end) {
+        int errc = 0;
+        id = group ? eos::common::Mapping::GroupNameToGid(tokens[2], errc) :
+             eos::common::Mapping::UserNameToUid(tokens[2], errc);
+
+        if (errc) {
+          eos_static_err("msg=\"ignoring rate rule with unknown identity\" "
+                         "rule=%s", it->first.c_str());
+          continue;
+        }
+      }
+    }
+
+    int tag = Stat::RegisterTag(tokens[3].c_str());
+
+    if (tag < 0) {
+      continue;
+    }
+
+    if ((size_t) tag >= ops.size()) {
+      ops.resize(tag + 1);
+    }
+
+    OpRules& op = ops[tag];
+
+    if (!op.active) {
+      op.active = true;
+      compiled->tags.push_back(tag);
+    }
+
+    RateRule& rule = all ? (group ? op.groupAll : op.userAll) :
+                     (group ? op.groups[id] : op.users[id]);
+    rule.rate = rate;
+    rule.key = it->first;
+    auto itc = comments.find(it->first);
+    compiled->comments[it->first] = (itc != comments.end()) ? itc->second : "";
+  }
+
+  XrdSysMutexHelper lock(mWriteMutex);
+  std::shared_ptr<const Table> current = std::atomic_load(&mTable);
+  std::shared_ptr<Table> table(new Table());
+  table->rules = compiled;
+
+  // keep the buckets whose rule did not change
+  for (auto it = current->buckets.begin(); it != current->buckets.end(); ++it) {
+    const OpRules* op = compiled->GetOp((int)(it->first >> 33));
+    bool group = (it->first >> 32) & 0x1;
+    uint32_t id = (uint32_t) it->first;
+
+    if (!op) {
+      continue;
+    }
+
+    const RateRule* rule = group ? op->GroupRule(id) : op->UserRule(id);
+
+    if (rule && (rule->key == it->second->mRule) &&
+        (rule->rate * kTolerance == it->second->mRate)) {
+      table->buckets.insert(*it);
+    }
+  }
+
+  mActive = !compiled->tags.empty();
+  std::atomic_store(&mTable, std::shared_ptr<const Table>(table));
+}
+
+//------------------------------------------------------------------------------
+// Charge executed operations to the buckets of an identity
+//------------------------------------------------------------------------------
+void
+RateLimiter::Account(int tag, uid_t uid, gid_t gid, unsigned long n)
+{
+  if (!mActive.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  int64_t now = Now();
+  bool user_missing = false;
+  bool group_missing = false;
+  std::shared_ptr<const Table> table = std::atomic_load(&mTable);
+  const OpRules* op = table->rules->GetOp(tag);
+
+  if (!op) {
+    return;
+  }
+
+  if (op->UserRule(uid)) {
+    TokenBucket* bucket = table->FindBucket(BucketKey(tag, false, uid));
+
+    if (bucket) {
+      bucket->Take(n, now);
+    } else {
+      user_missing = true;
+    }
+  }
+
+  if (op->GroupRule(gid)) {
+    TokenBucket* bucket = table->FindBucket(BucketKey(tag, true, gid));
+
+    if (bucket) {
+      bucket->Take(n, now);
+    } else {
+      group_missing = true;
+    }
+  }
+
+  if (user_missing || group_missing) {
+    AddBuckets(tag, uid, gid, n, user_missing, group_missing, now);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Create the missing buckets of an identity and charge them
+//------------------------------------------------------------------------------
+void
+RateLimiter::AddBuckets(int tag, uid_t uid, gid_t gid, unsigned long n,
+                        bool user_missing, bool group_missing, int64_t now_us)
+{
+  XrdSysMutexHelper lock(mWriteMutex);
+  // the snapshot may have changed since the lookup - redo it on the latest
+  std::shared_ptr<const Table> current = std::atomic_load(&mTable);
+  const OpRules* op = current->rules->GetOp(tag);
+
+  if (!op) {
+    return;
+  }
+
+  std::shared_ptr<Table> table;
+
+  for (int i = 0; i < 2; ++i) {
+    bool group = (i == 1);
+
+    if (group ? !group_missing : !user_missing) {
+      continue;
+    }
+
+    const RateRule* rule = group ? op->GroupRule(gid) : op->UserRule(uid);
+
+    if (!rule) {
+      continue;
+    }
+
+    uint64_t key = BucketKey(tag, group, group ? gid : uid);
+    TokenBucket* bucket = current->FindBucket(key);
+
+    if (!bucket) {
+      if (!table) {
+        table.reset(new Table(*current));
+      }
+
+      bucket = NewBucket(*rule, now_us);
+      table->buckets[key].reset(bucket);
+    }
+
+    bucket->Take(n, now_us);
+  }
+
+  if (table) {
+    std::atomic_store(&mTable, std::shared_ptr<const Table>(table));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check one bucket during admission
+//------------------------------------------------------------------------------
+void
+RateLimiter::CheckBucket(const Table& table, uint64_t key, int64_t now_us,
+                         int64_t& worst, TokenBucket*& worst_bucket)
+{
+  TokenBucket* bucket = table.FindBucket(key);
+
+  if (!bucket) {
+    return;
+  }
+
+  int64_t debt = bucket->DebtTime(now_us);
+
+  if (debt > worst) {
+    worst = debt;
+    worst_bucket = bucket;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if a request of an identity can be admitted
+//------------------------------------------------------------------------------
+bool
+RateLimiter::Admit(uid_t uid, gid_t gid, int& stalltime, std::string& stallmsg)
+{
+  if (!mActive.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int64_t now = std::chrono::duration_cast<std::chrono::microseconds>
+                (start.time_since_epoch()).count();
+  int64_t worst = 0;
+  TokenBucket* worst_bucket = 0;
+  std::shared_ptr<const Table> table = std::atomic_load(&mTable);
+  const std::vector<int>& tags = table->rules->tags;
+
+  for (size_t i = 0; i < tags.size(); ++i) {
+    CheckBucket(*table, BucketKey(tags[i], false, uid), now, worst,
+                worst_bucket);
+    CheckBucket(*table, BucketKey(tags[i], true, gid), now, worst,
+                worst_bucket);
+  }
+
+  bool admit = true;
+
+  if (worst_bucket) {
+    admit = false;
+    worst_bucket->mRejected++;
+    mRejected++;
+    // stall until the debt is paid back, at least one second
+    stalltime = (int)((worst + 999999) / 1000000);
+
+    if (stalltime > kMaxStallTime) {
+      stalltime = kMaxStallTime;
+    }
+
+    auto it = table->rules->comments.find(worst_bucket->mRule);
+    stallmsg = (it != table->rules->comments.end()) ? it->second : "";
+  }
+
+  mAdmitted++;
+  mAdmitNs += std::chrono::duration_cast<std::chrono::nanoseconds>
+              (std::chrono::steady_clock::now() - start).count();
+  return admit;
+}
+
+//------------------------------------------------------------------------------
+// Print bucket levels, rejections and the admission cost
+//------------------------------------------------------------------------------
+void
+RateLimiter::Print(std::string& out, bool monitoring)
+{
+  std::shared_ptr<const Table> table = std::atomic_load(&mTable);
+
+  if (table->buckets.empty() && !mAdmitted) {
+    return;
+  }
+
+  // sort by rule and identity for a stable output
+  std::map<std::pair<std::string, uint64_t>, TokenBucket*> sorted;
+
+  for (auto it = table->buckets.begin(); it != table->buckets.end(); ++it) {
+    sorted[std::make_pair(it->second->mRule, it->first)] = it->second.get();
+  }
+
+  char line[1024];
+
+  if (!monitoring) {
+    out += "# ....................................................................................\n";
+    out += "# Rate Buckets ...\n";
+    out += "# ....................................................................................\n";
+  }
+
+  int cnt = 0;
+
+  for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+    const char* type = ((it->first.second >> 32) & 0x1) ? "gid" : "uid";
+    unsigned int id = (uint32_t) it->first.second;
+    TokenBucket* bucket = it->second;
+    cnt++;
+
+    if (monitoring) {
+      snprintf(line, sizeof(line) - 1, "rate.bucket=%s %s=%u level=%.02f "
+               "capacity=%.02f rate=%.02f rejected=%llu\n",
+               bucket->mRule.c_str(), type, id, bucket->GetLevel(),
+               bucket->mCapacity / 1000000.0, bucket->mRate,
+               bucket->mRejected.load());
+    } else {
+      snprintf(line, sizeof(line) - 1, "[ %02d ] %32s %s=%-8u level=%10.02f/"
+               "%-8.02f rate=%.02f Hz rejected=%llu\n", cnt,
+               bucket->mRule.c_str(), type, id, bucket->GetLevel(),
+               bucket->mCapacity / 1000000.0, bucket->mRate,
+               bucket->mRejected.load());
+    }
+
+    out += line;
+  }
+
+  unsigned long long admitted = mAdmitted.load();
+  double cost = admitted ? (1.0 * mAdmitNs.load() / admitted) : 0.0;
+
+  if (monitoring) {
+    snprintf(line, sizeof(line) - 1, "rate.admission checks=%llu rejected=%llu "
+             "cost_ns=%.0f\n", admitted, mRejected.load(), cost);
+  } else {
+    snprintf(line, sizeof(line) - 1, "# admission checks=%llu rejected=%llu "
+             "avg-cost=%.0f ns\n", admitted, mRejected.load(), cost);
+  }
+
+  out += line;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+// File: RateLimiter.hh
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_RATELIMITER__HH__
+#define __EOSMGM_RATELIMITER__HH__
+
+#include "mgm/Namespace.hh"
+#include "mgm/TokenBucket.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <sys/types.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Rate limiter enforcing the 'rate:user:<uid>:<op>' and
+//! 'rate:group:<gid>:<op>' stall rules.
+//!
+//! The rules are compiled into a table indexed by the statistics tag id of
+//! the operation, holding the per-uid/per-gid limits and the wildcard limit.
+//! A specific uid/gid rule overrides the wildcard rule of the same operation.
+//! Every identity under a rule gets its own token bucket, which is charged
+//! when the operation is accounted in the statistics and checked when a
+//! request is admitted in XrdMgmOfs::ShouldStall. A group rule with an
+//! explicit gid limits the group as a whole, wildcard rules limit each
+//! user/group separately.
+//!
+//! Like the 5 s average check it replaces, an identity is only stalled above
+//! kTolerance times the configured rate: the buckets refill at that rate and
+//! hold kBurstTime seconds of it, the number of operations the old 5 s window
+//! let through before it stalled.
+//!
+//! The rule table and the bucket index are an immutable snapshot which is
+//! swapped atomically - Account and Admit never take a lock. Compile and the
+//! creation of the bucket of a new identity copy the snapshot under
+//! mWriteMutex and publish the copy.
+//------------------------------------------------------------------------------
+class RateLimiter
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  RateLimiter();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~RateLimiter() {};
+
+  //----------------------------------------------------------------------------
+  //! Compile the rate rules out of the stall rules. Buckets of rules which are
+  //! unchanged keep their level and counters.
+  //!
+  //! @param rules stall rules
+  //! @param comments stall comments
+  //----------------------------------------------------------------------------
+  void Compile(const std::map<std::string, std::string>& rules,
+               const std::map<std::string, std::string>& comments);
+
+  //----------------------------------------------------------------------------
+  //! Charge executed operations to the buckets of an identity
+  //!
+  //! @param tag statistics tag id of the operation
+  //! @param uid user id
+  //! @param gid group id
+  //! @param n number of operations
+  //----------------------------------------------------------------------------
+  void Account(int tag, uid_t uid, gid_t gid, unsigned long n);
+
+  //----------------------------------------------------------------------------
+  //! Check if a request of an identity can be admitted
+  //!
+  //! @param uid user id
+  //! @param gid group id
+  //! @param stalltime returns the stall time in seconds
+  //! @param stallmsg returns the comment of the violated rule
+  //!
+  //! @return true if admitted, false if the client has to be stalled
+  //----------------------------------------------------------------------------
+  bool Admit(uid_t uid, gid_t gid, int& stalltime, std::string& stallmsg);
+
+  //----------------------------------------------------------------------------
+  //! Print bucket levels, rejections and the admission cost
+  //!
+  //! @param out output string
+  //! @param monitoring print in key=value format
+  //----------------------------------------------------------------------------
+  void Print(std::string& out, bool monitoring);
+
+  //! Max. stall time in seconds sent to a client in debt
+  static const int kMaxStallTime = 60;
+  //! Factor over the configured rate tolerated before stalling
+  static constexpr double kTolerance = 1.33;
+  //! Burst in seconds of the tolerated rate
+  static constexpr double kBurstTime = 5.0;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Limit defined by a rate rule
+  //----------------------------------------------------------------------------
+  struct RateRule {
+    RateRule(): rate(0) {};
+    double rate; ///< Tokens per second, 0 if not set
+    std::string key; ///< Stall rule key
+  };
+
+  //----------------------------------------------------------------------------
+  //! Compiled rules of one operation
+  //----------------------------------------------------------------------------
+  struct OpRules {
+    OpRules(): active(false) {};
+    bool active; ///< Any rule defined for this operation
+    RateRule userAll; ///< Wildcard user rule
+    RateRule groupAll; ///< Wildcard group rule
+    std::map<uid_t, RateRule> users; ///< Per-uid rules
+    std::map<gid_t, RateRule> groups; ///< Per-gid rules
+
+    const RateRule* UserRule(uid_t uid) const;
+    const RateRule* GroupRule(gid_t gid) const;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Compiled rules, never modified once published
+  //----------------------------------------------------------------------------
+  struct Rules {
+    std::vector<OpRules> ops; ///< Compiled rules indexed by stat tag id
+    std::vector<int> tags; ///< Tag ids having rules
+    std::map<std::string, std::string> comments; ///< Rule key => comment
+
+    const OpRules* GetOp(int tag) const;
+  };
+
+  typedef std::unordered_map<uint64_t, std::shared_ptr<TokenBucket>> BucketMap;
+
+  //----------------------------------------------------------------------------
+  //! Snapshot of the rules and the buckets, never modified once published
+  //----------------------------------------------------------------------------
+  struct Table {
+    std::shared_ptr<const Rules> rules; ///< Compiled rules
+    BucketMap buckets; ///< Buckets by BucketKey
+
+    TokenBucket* FindBucket(uint64_t key) const;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Bucket key for an operation and an identity
+  //----------------------------------------------------------------------------
+  static uint64_t
+  BucketKey(int tag, bool group, uint32_t id)
+  {
+    return (((uint64_t) tag) << 33) | (((uint64_t) group) << 32) | id;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Create a bucket for a rule
+  //----------------------------------------------------------------------------
+  static TokenBucket* NewBucket(const RateRule& rule, int64_t now_us);
+
+  //----------------------------------------------------------------------------
+  //! Current time in microseconds
+  //----------------------------------------------------------------------------
+  static int64_t Now();
+
+  //----------------------------------------------------------------------------
+  //! Check one bucket during admission
+  //----------------------------------------------------------------------------
+  static void CheckBucket(const Table& table, uint64_t key, int64_t now_us,
+                          int64_t& worst, TokenBucket*& worst_bucket);
+
+  //----------------------------------------------------------------------------
+  //! Create the missing buckets of an identity and charge them
+  //----------------------------------------------------------------------------
+  void AddBuckets(int tag, uid_t uid, gid_t gid, unsigned long n,
+                  bool user_missing, bool group_missing, int64_t now_us);
+
+  std::atomic<bool> mActive; ///< Any rate rule is defined
+  //! Current snapshot, accessed with std::atomic_load/std::atomic_store
+  std::shared_ptr<const Table> mTable;
+  XrdSysMutex mWriteMutex; ///< Serializes the publishing of new snapshots
+  std::atomic<unsigned long long> mAdmitted; ///< Number of admission checks
+  std::atomic<unsigned long long> mRejected; ///< Number of stalled requests
+  std::atomic<unsigned long long> mAdmitNs; ///< Time spent in admission checks
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
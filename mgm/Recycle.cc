@@ -25,6 +25,7 @@
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
 #include "common/Mapping.hh"
+#include "common/Path.hh"
 #include "common/RWMutex.hh"
 #include "mgm/Recycle.hh"
 #include "mgm/XrdMgmOfs.hh"
@@ -33,6 +34,10 @@
 /*----------------------------------------------------------------------------*/
 #include "XrdSys/XrdSysTimer.hh"
 /*----------------------------------------------------------------------------*/
+#include <atomic>
+#include <sys/time.h>
+#include <thread>
+/*----------------------------------------------------------------------------*/
 std::string Recycle::gRecyclingPrefix = "/recycle/"; // MgmOfsConfigure prepends the proc directory path e.g. the bin is /eos/<instance/proc/recycle/
 std::string Recycle::gRecyclingAttribute = "sys.recycle";
 std::string Recycle::gRecyclingTimeAttribute = "sys.recycle.keeptime";
@@ -40,6 +45,7 @@ std::string Recycle::gRecyclingKeepRatio = "sys.recycle.keepratio";
 std::string Recycle::gRecyclingVersionKey = "sys.recycle.version.key";
 std::string Recycle::gRecyclingPostFix = ".d";
 int Recycle::gRecyclingPollTime = 30;
+int Recycle::gRecyclingBatchSize = 1000;
 
 /*----------------------------------------------------------------------------*/
 
@@ -52,6 +58,19 @@ Recycle::Start ()
   // run an asynchronous recyling thread
   eos_static_info("constructor");
   mThread = 0;
+  {
+    // the index is rebuilt by the thread, e.g. after a master/slave transition
+    XrdSysMutexHelper lock(mIndexMutex);
+    mExpiryIndex.clear();
+    mIndexedEntries.clear();
+    mIndexed = false;
+  }
+  if (getenv("EOS_MGM_RECYCLE_THREADS"))
+  {
+    mPurgeThreads = atoi(getenv("EOS_MGM_RECYCLE_THREADS"));
+    if (mPurgeThreads < 1)
+      mPurgeThreads = 1;
+  }
   XrdSysThread::Run(&mThread, Recycle::StartRecycleThread, static_cast<void *> (this), XRDSYSTHREAD_HOLD, "Recycle garbage collection Thread");
   return (mThread ? true : false);
 }
@@ -93,7 +112,6 @@ Recycle::Recycler ()
   XrdOucErrInfo lError;
   time_t lKeepTime = 0;
   double lSpaceKeepRatio = 0;
-  std::multimap<time_t, std::string> lDeletionMap;
   time_t snoozetime = 10;
 
   unsigned long long lLowInodesWatermark = 0;
@@ -208,240 +226,68 @@ Recycle::Recycler ()
       if (attrmap.count(Recycle::gRecyclingTimeAttribute))
       {
         lKeepTime = strtoull(attrmap[Recycle::gRecyclingTimeAttribute].c_str(), 0, 10);
-        eos_static_info("keep-time=%llu deletion-map=%llu", lKeepTime, lDeletionMap.size());
+        unsigned long long indexed, files, bulks;
+        double rate;
+        GetPurgeStats(indexed, files, bulks, rate);
+        eos_static_info("keep-time=%llu indexed=%llu", lKeepTime, indexed);
         if (lKeepTime > 0)
         {
-          if (!lDeletionMap.size())
+          if (!mIndexed)
           {
             //...................................................................
-            //  the deletion map is filled if there is nothing inside with files/
-            //  directories found previously in the garbage bin
+            // the expiry index is filled once walking the recycle bin, later
+            // it is maintained by ToGarbage/Restore/Purge
             //...................................................................
-            std::string subdirs;
-            XrdMgmOfsDirectory dirl1;
-            XrdMgmOfsDirectory dirl2;
-            XrdMgmOfsDirectory dirl3;
-            int listrc = dirl1.open(Recycle::gRecyclingPrefix.c_str(), rootvid, (const char*) 0);
-            if (listrc)
+            IndexBin();
+            mIndexed = true;
+          }
+
+          time_t now = time(NULL);
+          time_t oldest = 0;
+
+          // If there is a keep-ratio policy defined we abort deletion once
+          // we are enough under the thresholds - checked before each entry
+          bool keepratio = attrmap.count(Recycle::gRecyclingKeepRatio);
+
+          while (1)
+          {
+            std::vector<std::pair<std::string, time_t> > entries;
+            oldest = PopExpired(now - lKeepTime, gRecyclingBatchSize, entries);
+
+            if (entries.empty())
             {
-              eos_static_err("msg=\"unable to list the garbage directory level-1\" recycle-path=%s", Recycle::gRecyclingPrefix.c_str());
+              break;
             }
-            else
+
+            if (PurgeBatch(entries, lKeepTime, keepratio, lLowInodesWatermark,
+                           lLowSpaceWatermark))
             {
-              // loop over all directories = group directories
-              const char* dname1;
-              while ((dname1 = dirl1.nextEntry()))
-              {
-                {
-                  std::string sdname = dname1;
-                  if ((sdname == ".") || (sdname == ".."))
-                  {
-                    continue;
-                  }
-                }
-                std::string l2 = Recycle::gRecyclingPrefix;
-                l2 += dname1;
-                // list level-2 user directories
-                listrc = dirl2.open(l2.c_str(), rootvid, (const char*) 0);
-                if (listrc)
-                {
-                  eos_static_err("msg=\"unable to list the garbage directory level-2\" recycle-path=%s l2-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str());
-                }
-                else
-                {
-                  const char* dname2;
-                  while ((dname2 = dirl2.nextEntry()))
-                  {
-                    {
-                      std::string sdname = dname2;
-                      if ((sdname == ".") || (sdname == ".."))
-                      {
-                        continue;
-                      }
-                    }
-                    std::string l3 = l2;
-                    l3 += "/";
-                    l3 += dname2;
-                    // list the level-3 entries
-                    listrc = dirl3.open(l3.c_str(), rootvid, (const char*) 0);
-                    if (listrc)
-                    {
-                      eos_static_err("msg=\"unable to list the garbage directory level-2\" recycle-path=%s l2-path=%s l3-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str(), l3.c_str());
-                    }
-                    else
-                    {
-                      const char* dname3;
-                      while ((dname3 = dirl3.nextEntry()))
-                      {
-                        {
-                          std::string sdname = dname3;
-                          if ((sdname == ".") || (sdname == ".."))
-                          {
-                            continue;
-                          }
-                        }
-                        std::string l4 = l3;
-                        l4 += "/";
-                        l4 += dname3;
-                        eos_static_info("path=%s", l4.c_str());
-                        //.......................................................
-                        // stat the directory to get the mtime
-                        //.......................................................
-                        struct stat buf;
-                        if (gOFS->_stat(l4.c_str(), &buf, lError, rootvid, ""))
-                        {
-                          eos_static_err("msg=\"unable to stat a garbage directory entry\" recycle-path=%s l2-path=%s l3-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str(), l3.c_str());
-
-                        }
-                        else
-                        {
-                          //.....................................................
-                          // add to the garbage fifo deletion multimap
-                          //.....................................................
-                          lDeletionMap.insert(std::pair<time_t, std::string > (buf.st_ctime, l4));
-                        }
-                      }
-                      dirl3.close();
-                    }
-                  }
-                  dirl2.close();
-                }
-              }
-              dirl1.close();
+              oldest = 0;
+              break; // leave the deletion loop
             }
           }
-          else
+
+          if (oldest)
           {
-            auto it = lDeletionMap.begin();
-            time_t now = time(NULL);
-            while (it != lDeletionMap.end())
+            //...................................................................
+            // the oldest entry has still to be kept
+            //...................................................................
+            snoozetime = (oldest + gRecyclingPollTime + lKeepTime) - now;
+            if (snoozetime < gRecyclingPollTime)
             {
-              // take the first element and see if it is exceeding the keep time
-              if ((it->first + lKeepTime) < now)
-              {
-                // This entry can be removed
-                // If there is a keep-ratio policy defined we abort deletion once
-		// we are enough under the thresholds
-                if (attrmap.count(Recycle::gRecyclingKeepRatio))
-		{
-		  auto map_quotas = Quota::GetGroupStatistics(Recycle::gRecyclingPrefix,
-							      Quota::gProjectId);
-
-		  if (!map_quotas.empty())
-		  {
-		    unsigned long long usedbytes = map_quotas[SpaceQuota::kGroupBytesIs];
-                    unsigned long long usedfiles = map_quotas[SpaceQuota::kGroupFilesIs];
-                    eos_static_debug("low-volume=%lld is-volume=%lld low-inodes=%lld is-inodes=%lld",
-                                     usedfiles,
-                                     lLowInodesWatermark,
-                                     usedbytes,
-                                     lLowSpaceWatermark);
-                    if ((lLowInodesWatermark >= usedfiles) &&
-                        (lLowSpaceWatermark >= usedbytes))
-                    {
-                      eos_static_debug("msg=\"skipping recycle clean-up - ratio went under low watermarks\"");
-                      break; // leave the deletion loop
-                    }
-		  }
-		}
-
-	        XrdOucString delpath = it->second.c_str();
-                if ((it->second.length()) && (delpath.endswith(Recycle::gRecyclingPostFix.c_str())))
-		{
-                  //.............................................................
-                  // do a directory deletion - first find all subtree children
-                  //.............................................................
-                  std::map<std::string, std::set<std::string> > found;
-                  std::map<std::string, std::set<std::string> >::const_reverse_iterator rfoundit;
-                  std::set<std::string>::const_iterator fileit;
-                  XrdOucString stdErr;
-                  if (gOFS->_find(it->second.c_str(), lError, stdErr, rootvid, found))
-                  {
-                    eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"", it->second.c_str(), stdErr.c_str());
-                  }
-                  else
-                  {
-                    //...........................................................
-                    // standard way to delete files recursively
-                    //...........................................................
-                    // delete files starting at the deepest level
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++)
-                    {
-                      for (fileit = rfoundit->second.begin(); fileit != rfoundit->second.end(); fileit++)
-                      {
-                        std::string fspath = rfoundit->first;
-                        fspath += *fileit;
-                        if (gOFS->_rem(fspath.c_str(), lError, rootvid, (const char*) 0))
-                        {
-                          eos_static_err("msg=\"unable to remove file\" path=%s", fspath.c_str());
-                        }
-                        else
-                        {
-                          eos_static_info("msg=\"permanently deleted file from recycle bin\" path=%s keep-time=%llu", fspath.c_str(), lKeepTime);
-                        }
-                      }
-                    }
-                    //...........................................................
-                    // delete directories starting at the deepest level
-                    //...........................................................
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++)
-                    {
-                      //.........................................................
-                      // don't even try to delete the root directory
-                      //.........................................................
-                      std::string fspath = rfoundit->first.c_str();
-                      if (fspath == "/")
-                        continue;
-                      if (gOFS->_remdir(rfoundit->first.c_str(), lError, rootvid, (const char*) 0))
-                      {
-                        eos_static_err("msg=\"unable to remove directory\" path=%s", fspath.c_str());
-                      }
-                      else
-                      {
-                        eos_static_info("msg=\"permanently deleted directory from recycle bin\" path=%s keep-time=%llu", fspath.c_str(), lKeepTime);
-                      }
-                    }
-                  }
-                  lDeletionMap.erase(it);
-                  it = lDeletionMap.begin();
-                }
-                else
-                {
-                  //...........................................................
-                  // do a single file deletion
-                  //...........................................................
-                  if (gOFS->_rem(it->second.c_str(), lError, rootvid, (const char*) 0))
-                  {
-                    eos_static_err("msg=\"unable to remove file\" path=%s", it->second.c_str());
-                  }
-                  lDeletionMap.erase(it);
-                  it = lDeletionMap.begin();
-                }
-              }
-              else
-              {
-                //...............................................................
-                // this entry has still to be kept
-                //...............................................................
-                snoozetime = (it->first + lKeepTime) - now;
-                if (snoozetime < gRecyclingPollTime)
-                {
-                  //.............................................................
-                  // avoid to activate this thread too many times, 5 minutess
-                  // resolution is perfectly fine
-                  //.............................................................
-                  snoozetime = gRecyclingPollTime;
-                }
-                if (snoozetime > lKeepTime)
-                {
-                  eos_static_warning("msg=\"snooze time exceeds keeptime\" snooze-time=%llu keep-time=%llu", snoozetime, lKeepTime);
-                  //.............................................................
-                  // that is sort of strange but let's have a fix for that
-                  //.............................................................
-                  snoozetime = lKeepTime;
-                }
-                it++;
-              }
+              //.................................................................
+              // avoid to activate this thread too many times, 5 minutess
+              // resolution is perfectly fine
+              //.................................................................
+              snoozetime = gRecyclingPollTime;
+            }
+            if (snoozetime > lKeepTime)
+            {
+              eos_static_warning("msg=\"snooze time exceeds keeptime\" snooze-time=%llu keep-time=%llu", snoozetime, lKeepTime);
+              //.................................................................
+              // that is sort of strange but let's have a fix for that
+              //.................................................................
+              snoozetime = lKeepTime;
             }
           }
         }
@@ -463,6 +309,373 @@ Recycle::Recycler ()
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+Recycle::IndexBin ()
+{
+  //.............................................................................
+  // walk the three levels <gid>/<uid>/<entry> of the recycle bin and add all
+  // entries with their deletion time to the expiry index
+  //.............................................................................
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  XrdOucErrInfo lError;
+
+  eos_static_info("msg=\"start indexing the recycle bin\"");
+  XrdMgmOfsDirectory dirl1;
+  XrdMgmOfsDirectory dirl2;
+  XrdMgmOfsDirectory dirl3;
+  int listrc = dirl1.open(Recycle::gRecyclingPrefix.c_str(), rootvid, (const char*) 0);
+  if (listrc)
+  {
+    eos_static_err("msg=\"unable to list the garbage directory level-1\" recycle-path=%s", Recycle::gRecyclingPrefix.c_str());
+  }
+  else
+  {
+    // loop over all directories = group directories
+    const char* dname1;
+    while ((dname1 = dirl1.nextEntry()))
+    {
+      {
+        std::string sdname = dname1;
+        if ((sdname == ".") || (sdname == ".."))
+        {
+          continue;
+        }
+      }
+      std::string l2 = Recycle::gRecyclingPrefix;
+      l2 += dname1;
+      // list level-2 user directories
+      listrc = dirl2.open(l2.c_str(), rootvid, (const char*) 0);
+      if (listrc)
+      {
+        eos_static_err("msg=\"unable to list the garbage directory level-2\" recycle-path=%s l2-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str());
+      }
+      else
+      {
+        const char* dname2;
+        while ((dname2 = dirl2.nextEntry()))
+        {
+          {
+            std::string sdname = dname2;
+            if ((sdname == ".") || (sdname == ".."))
+            {
+              continue;
+            }
+          }
+          std::string l3 = l2;
+          l3 += "/";
+          l3 += dname2;
+          // list the level-3 entries
+          listrc = dirl3.open(l3.c_str(), rootvid, (const char*) 0);
+          if (listrc)
+          {
+            eos_static_err("msg=\"unable to list the garbage directory level-2\" recycle-path=%s l2-path=%s l3-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str(), l3.c_str());
+          }
+          else
+          {
+            const char* dname3;
+            while ((dname3 = dirl3.nextEntry()))
+            {
+              {
+                std::string sdname = dname3;
+                if ((sdname == ".") || (sdname == ".."))
+                {
+                  continue;
+                }
+              }
+              std::string l4 = l3;
+              l4 += "/";
+              l4 += dname3;
+              eos_static_info("path=%s", l4.c_str());
+              //.......................................................
+              // stat the directory to get the mtime
+              //.......................................................
+              struct stat buf;
+              if (gOFS->_stat(l4.c_str(), &buf, lError, rootvid, ""))
+              {
+                eos_static_err("msg=\"unable to stat a garbage directory entry\" recycle-path=%s l2-path=%s l3-path=%s", Recycle::gRecyclingPrefix.c_str(), l2.c_str(), l3.c_str());
+
+              }
+              else
+              {
+                //.....................................................
+                // add to the expiry index
+                //.....................................................
+                IndexEntry(l4, buf.st_ctime);
+              }
+            }
+            dirl3.close();
+          }
+        }
+        dirl2.close();
+      }
+    }
+    dirl1.close();
+  }
+
+  unsigned long long indexed, files, bulks;
+  double rate;
+  GetPurgeStats(indexed, files, bulks, rate);
+  eos_static_info("msg=\"finished indexing the recycle bin\" entries=%llu", indexed);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+Recycle::IndexEntry (const std::string &path, time_t deletiontime)
+{
+  // entries are grouped in buckets of the poll interval of the recycle thread
+  time_t bucket = deletiontime - (deletiontime % gRecyclingPollTime);
+  // the callers build the path in different ways e.g. with a double '/'
+  eos::common::Path cPath(path.c_str());
+  std::string key = cPath.GetPath();
+  XrdSysMutexHelper lock(mIndexMutex);
+  auto it = mIndexedEntries.find(key);
+
+  if (it != mIndexedEntries.end())
+  {
+    mExpiryIndex[it->second].erase(key);
+
+    if (mExpiryIndex[it->second].empty())
+      mExpiryIndex.erase(it->second);
+  }
+
+  mIndexedEntries[key] = bucket;
+  mExpiryIndex[bucket].insert(key);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+Recycle::UnindexEntry (const std::string &path)
+{
+  eos::common::Path cPath(path.c_str());
+  std::string key = cPath.GetPath();
+  XrdSysMutexHelper lock(mIndexMutex);
+  auto it = mIndexedEntries.find(key);
+
+  if (it == mIndexedEntries.end())
+    return;
+
+  mExpiryIndex[it->second].erase(key);
+
+  if (mExpiryIndex[it->second].empty())
+    mExpiryIndex.erase(it->second);
+
+  mIndexedEntries.erase(it);
+}
+
+/*----------------------------------------------------------------------------*/
+time_t
+Recycle::PopExpired (time_t deadline, size_t max, std::vector<std::pair<std::string, time_t> > &entries)
+{
+  XrdSysMutexHelper lock(mIndexMutex);
+
+  while (!mExpiryIndex.empty() && (entries.size() < max))
+  {
+    auto bit = mExpiryIndex.begin();
+
+    // only buckets which are completely older than the deadline are expired
+    if ((bit->first + gRecyclingPollTime) > deadline)
+      break;
+
+    while (!bit->second.empty() && (entries.size() < max))
+    {
+      auto eit = bit->second.begin();
+      entries.push_back(std::make_pair(*eit, bit->first));
+      mIndexedEntries.erase(*eit);
+      bit->second.erase(eit);
+    }
+
+    if (bit->second.empty())
+      mExpiryIndex.erase(bit);
+  }
+
+  return (mExpiryIndex.empty() ? 0 : mExpiryIndex.begin()->first);
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Recycle::BelowWatermarks (unsigned long long lowinodes, unsigned long long lowspace)
+{
+  auto map_quotas = Quota::GetGroupStatistics(Recycle::gRecyclingPrefix,
+                                              Quota::gProjectId);
+
+  if (map_quotas.empty())
+    return false;
+
+  unsigned long long usedbytes = map_quotas[SpaceQuota::kGroupBytesIs];
+  unsigned long long usedfiles = map_quotas[SpaceQuota::kGroupFilesIs];
+  eos_static_debug("low-volume=%lld is-volume=%lld low-inodes=%lld is-inodes=%lld",
+                   lowspace, usedbytes, lowinodes, usedfiles);
+  return ((lowinodes >= usedfiles) && (lowspace >= usedbytes));
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Recycle::PurgeBatch (const std::vector<std::pair<std::string, time_t> > &entries, time_t keeptime, bool keepratio, unsigned long long lowinodes, unsigned long long lowspace)
+{
+  struct timeval tv_start, tv_stop;
+  gettimeofday(&tv_start, 0);
+  std::atomic<unsigned long long> nfiles(0);
+  std::atomic<unsigned long long> nbulks(0);
+  std::atomic<bool> stop(false);
+  std::vector<char> done(entries.size(), 0);
+  size_t nthreads = (mPurgeThreads > 0) ? mPurgeThreads : 1;
+
+  if (nthreads > entries.size())
+    nthreads = entries.size();
+
+  //.............................................................................
+  // the unlinks are spread over several threads, each taking every n-th entry
+  //.............................................................................
+  auto purge = [&](size_t offset)
+  {
+    for (size_t i = offset; i < entries.size(); i += nthreads)
+    {
+      if (stop)
+        return;
+
+      if (keepratio && BelowWatermarks(lowinodes, lowspace))
+      {
+        eos_static_debug("msg=\"skipping recycle clean-up - ratio went under low watermarks\"");
+        stop = true;
+        return;
+      }
+
+      if (RemoveEntry(entries[i].first, keeptime))
+        nbulks++;
+      else
+        nfiles++;
+
+      done[i] = 1;
+    }
+  };
+
+  std::vector<std::thread> workers;
+
+  for (size_t i = 1; i < nthreads; ++i)
+    workers.push_back(std::thread(purge, i));
+
+  purge(0);
+
+  for (auto it = workers.begin(); it != workers.end(); ++it)
+    it->join();
+
+  //.............................................................................
+  // entries left over when the low watermarks were reached stay in the index
+  //.............................................................................
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    if (!done[i])
+      IndexEntry(entries[i].first, entries[i].second);
+  }
+
+  gettimeofday(&tv_stop, 0);
+  double elapsed = (tv_stop.tv_sec - tv_start.tv_sec) +
+    (tv_stop.tv_usec - tv_start.tv_usec) / 1000000.0;
+  double purged = nfiles + nbulks;
+  {
+    XrdSysMutexHelper lock(mIndexMutex);
+    mPurgedFiles += nfiles;
+    mPurgedBulks += nbulks;
+    mPurgeRate = (elapsed > 0) ? (purged / elapsed) : purged;
+  }
+  eos_static_info("msg=\"purged recycle bin batch\" files=%llu bulks=%llu "
+                  "threads=%u rate=%.02f", (unsigned long long) nfiles,
+                  (unsigned long long) nbulks, (unsigned int) nthreads,
+                  (elapsed > 0) ? (purged / elapsed) : 0.0);
+  return stop;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+Recycle::GetPurgeStats (unsigned long long &indexed, unsigned long long &files, unsigned long long &bulks, double &rate)
+{
+  XrdSysMutexHelper lock(mIndexMutex);
+  indexed = mIndexedEntries.size();
+  files = mPurgedFiles;
+  bulks = mPurgedBulks;
+  rate = mPurgeRate;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Recycle::RemoveEntry (const std::string &path, time_t keeptime)
+{
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  XrdOucErrInfo lError;
+  XrdOucString delpath = path.c_str();
+
+  if ((path.length()) && (delpath.endswith(Recycle::gRecyclingPostFix.c_str())))
+  {
+    //.........................................................................
+    // do a directory deletion - first find all subtree children
+    //.........................................................................
+    std::map<std::string, std::set<std::string> > found;
+    std::map<std::string, std::set<std::string> >::const_reverse_iterator rfoundit;
+    std::set<std::string>::const_iterator fileit;
+    XrdOucString stdErr;
+    if (gOFS->_find(path.c_str(), lError, stdErr, rootvid, found))
+    {
+      eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"", path.c_str(), stdErr.c_str());
+    }
+    else
+    {
+      //.......................................................................
+      // standard way to delete files recursively
+      //.......................................................................
+      // delete files starting at the deepest level
+      for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++)
+      {
+        for (fileit = rfoundit->second.begin(); fileit != rfoundit->second.end(); fileit++)
+        {
+          std::string fspath = rfoundit->first;
+          fspath += *fileit;
+          if (gOFS->_rem(fspath.c_str(), lError, rootvid, (const char*) 0))
+          {
+            eos_static_err("msg=\"unable to remove file\" path=%s", fspath.c_str());
+          }
+          else
+          {
+            eos_static_info("msg=\"permanently deleted file from recycle bin\" path=%s keep-time=%llu", fspath.c_str(), keeptime);
+          }
+        }
+      }
+      //.......................................................................
+      // delete directories starting at the deepest level
+      //.......................................................................
+      for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++)
+      {
+        //.....................................................................
+        // don't even try to delete the root directory
+        //.....................................................................
+        std::string fspath = rfoundit->first.c_str();
+        if (fspath == "/")
+          continue;
+        if (gOFS->_remdir(rfoundit->first.c_str(), lError, rootvid, (const char*) 0))
+        {
+          eos_static_err("msg=\"unable to remove directory\" path=%s", fspath.c_str());
+        }
+        else
+        {
+          eos_static_info("msg=\"permanently deleted directory from recycle bin\" path=%s keep-time=%llu", fspath.c_str(), keeptime);
+        }
+      }
+    }
+    return true;
+  }
+
+  //...........................................................................
+  // do a single file deletion
+  //...........................................................................
+  if (gOFS->_rem(path.c_str(), lError, rootvid, (const char*) 0))
+  {
+    eos_static_err("msg=\"unable to remove file\" path=%s", path.c_str());
+  }
+  return false;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 Recycle::ToGarbage (const char* epname, XrdOucErrInfo & error)
@@ -566,6 +779,8 @@ Recycle::ToGarbage (const char* epname, XrdOucErrInfo & error)
   {
     return gOFS->Emsg(epname, error, EIO, "rename file/directory", srecyclepath);
   }
+  // make the entry known to the recycle thread
+  gOFS->Recycler.IndexEntry(srecyclepath, time(NULL));
   // store the recycle path in the error object
   error.setErrInfo(0,srecyclepath);
   return SFS_OK;
@@ -784,6 +999,9 @@ Recycle::Print (XrdOucString &stdOut, XrdOucString &stdErr, eos::common::Mapping
       char sline[1024];
       XrdOucString sizestring1;
       XrdOucString sizestring2;
+      unsigned long long indexed, purgedfiles, purgedbulks;
+      double purgerate;
+      gOFS->Recycler.GetPurgeStats(indexed, purgedfiles, purgedbulks, purgerate);
       eos::IContainerMD::XAttrMap attrmap;
       XrdOucErrInfo error;
       //...........................................................................
@@ -810,13 +1028,19 @@ Recycle::Print (XrdOucString &stdOut, XrdOucString &stdErr, eos::common::Mapping
 		 attrmap[Recycle::gRecyclingKeepRatio].c_str() : "not configured");
         stdOut += sline;
         stdOut += "\n";
+        snprintf(sline, sizeof (sline) - 1, "# indexed %llu entries - purged %llu "
+                 "files and %llu bulk deletions (%.02f entries/s in the last batch)",
+                 indexed, purgedfiles, purgedbulks, purgerate);
+        stdOut += sline;
+        stdOut += "\n";
         stdOut += "# _________________________________________________________"
 	  "__________________________________________________________________\n";
       }
       else
       {
         snprintf(sline, sizeof (sline) - 1, "recycle-bin=%s usedbytes=%s "
-		 "maxbytes=%s volumeusage=%.02f%% inodeusage=%.02f%% lifetime=%s ratio=%s",
+		 "maxbytes=%s volumeusage=%.02f%% inodeusage=%.02f%% lifetime=%s ratio=%s "
+                 "indexed=%llu purgedfiles=%llu purgedbulks=%llu purgerate=%.02f",
                  Recycle::gRecyclingPrefix.c_str(),
                  eos::common::StringConversion::GetSizeString(sizestring1, usedbytes),
                  eos::common::StringConversion::GetSizeString(sizestring2, maxbytes),
@@ -825,7 +1049,8 @@ Recycle::Print (XrdOucString &stdOut, XrdOucString &stdErr, eos::common::Mapping
                  attrmap.count(Recycle::gRecyclingTimeAttribute) ?
 		 attrmap[Recycle::gRecyclingTimeAttribute].c_str() : "-1",
                  attrmap.count(Recycle::gRecyclingKeepRatio) ?
-		 attrmap[Recycle::gRecyclingKeepRatio].c_str() : "-1");
+		 attrmap[Recycle::gRecyclingKeepRatio].c_str() : "-1",
+                 indexed, purgedfiles, purgedbulks, purgerate);
         stdOut += sline;
         stdOut += "\n";
       }
@@ -988,6 +1213,7 @@ Recycle::Restore (XrdOucString &stdOut, XrdOucString &stdErr, eos::common::Mappi
   }
   else
   {
+    gOFS->Recycler.UnindexEntry(cPath.GetPath());
     stdOut += "success: restored path=";
     stdOut += oPath.GetPath();
     stdOut += "\n";
@@ -1078,6 +1304,7 @@ Recycle::Purge (XrdOucString &stdOut, XrdOucString &stdErr, eos::common::Mapping
       Cmd.close();
       if (!result)
       {
+        gOFS->Recycler.UnindexEntry(pathname);
         if (S_ISDIR(buf.st_mode))
         {
           nbulk_deleted++;
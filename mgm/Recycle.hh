@@ -32,6 +32,11 @@
 #include "XrdOuc/XrdOucErrInfo.hh"
 /*----------------------------------------------------------------------------*/
 #include <sys/types.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 /*----------------------------------------------------------------------------*/
 
@@ -75,6 +80,45 @@ private:
   bool mWakeUp;
   XrdSysMutex mWakeUpMutex;
 
+  //............................................................................
+  // expiry index of the recycle bin entries
+  //............................................................................
+  XrdSysMutex mIndexMutex;
+  std::map<time_t, std::set<std::string> > mExpiryIndex; //< deletion time bucket => entries
+  std::map<std::string, time_t> mIndexedEntries; //< entry => deletion time bucket
+  bool mIndexed; //< true once the recycle bin has been indexed
+  unsigned long long mPurgedFiles; //< files purged by the recycle thread
+  unsigned long long mPurgedBulks; //< bulk deletions purged by the recycle thread
+  double mPurgeRate; //< entries/s purged in the last batch
+  int mPurgeThreads; //< number of parallel unlink threads
+
+  /* Fill the expiry index walking the recycle bin once
+   */
+  void IndexBin ();
+
+  /* Pop up to max entries deleted before the given time from the expiry index
+   * @param entries filled with the entries and their deletion time bucket
+   * @return the deletion time bucket of the oldest remaining entry or 0 if none
+   */
+  time_t PopExpired (time_t deadline, size_t max, std::vector<std::pair<std::string, time_t> > &entries);
+
+  /* Check if the recycle bin usage is below the low watermarks of the
+   * keep-ratio policy
+   */
+  bool BelowWatermarks (unsigned long long lowinodes, unsigned long long lowspace);
+
+  /* Permanently delete a batch of entries using mPurgeThreads threads
+   * @param keepratio if true the keep-ratio watermarks are checked before
+   *        each entry and the entries left are indexed again once below
+   * @return true if the deletion stopped at the low watermarks
+   */
+  bool PurgeBatch (const std::vector<std::pair<std::string, time_t> > &entries, time_t keeptime, bool keepratio, unsigned long long lowinodes, unsigned long long lowspace);
+
+  /* Permanently delete one recycle bin entry (file or bulk deletion)
+   * @return true if it was a bulk deletion
+   */
+  bool RemoveEntry (const std::string &path, time_t keeptime);
+
 public:
 
   /* Default Constructor - use it to run the Recycle thread by callign Start afterwards
@@ -82,6 +126,12 @@ public:
   Recycle ()
   {
     mThread = 0;
+    mWakeUp = false;
+    mIndexed = false;
+    mPurgedFiles = 0;
+    mPurgedBulks = 0;
+    mPurgeRate = 0;
+    mPurgeThreads = 4;
   }
 
   /* Start the recycle thread cleaning up the recycle bin
@@ -119,6 +169,11 @@ public:
     mId = id;
     mThread = 0;
     mWakeUp = false;
+    mIndexed = false;
+    mPurgedFiles = 0;
+    mPurgedBulks = 0;
+    mPurgeRate = 0;
+    mPurgeThreads = 0;
   }
 
   ~Recycle ()
@@ -193,6 +248,24 @@ public:
    */
   void WakeUp() {XrdSysMutexHelper lock(mWakeUpMutex); mWakeUp = true;}
 
+  /**
+   * add an entry to the expiry index of the recycle thread
+   * @param path of the entry in the recycle bin
+   * @param deletion time of the entry
+   */
+  void IndexEntry (const std::string &path, time_t deletiontime);
+
+  /**
+   * remove an entry from the expiry index of the recycle thread (restore/purge)
+   * @param path of the entry in the recycle bin
+   */
+  void UnindexEntry (const std::string &path);
+
+  /**
+   * get the statistics of the expiry index and the purging
+   */
+  void GetPurgeStats (unsigned long long &indexed, unsigned long long &files, unsigned long long &bulks, double &rate);
+
 
   static std::string gRecyclingPrefix; //< prefix for all recycle bins
   static std::string gRecyclingAttribute; //< attribute key defining a recycling location
@@ -201,6 +274,7 @@ public:
   static std::string gRecyclingPostFix; //<  postfix which identifies a name in the garbage bin as a bulk deletion of a directory
   static std::string gRecyclingVersionKey; //<  attribute key storing the recycling key of the version directory belonging to a given file
   static int gRecyclingPollTime; //< poll interval inside the garbage bin
+  static int gRecyclingBatchSize; //< max. number of entries purged in one batch
 };
 
 EOSMGMNAMESPACE_END
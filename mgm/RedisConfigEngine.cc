@@ -28,6 +28,7 @@
 #include "mq/XrdMqSharedObject.hh"
 #include "common/GlobalConfig.hh"
 #include "redox/redoxSet.hpp"
+#include <algorithm>
 #include <ctime>
 
 EOSMGMNAMESPACE_BEGIN
@@ -135,6 +136,7 @@ RedisConfigEngine::RedisConfigEngine(const char* configdir,
 //------------------------------------------------------------------------------
 RedisConfigEngine::~RedisConfigEngine()
 {
+  StopAutoSaver();
   client.disconnect();
 }
 
@@ -174,7 +176,10 @@ RedisConfigEngine::LoadConfig(XrdOucEnv& env, XrdOucString& err)
     mChangelog->AddEntry(cl.c_str());
     return false;
   } else {
-    mConfigFile = name;
+    {
+      XrdSysMutexHelper lock(mMutex);
+      mConfigFile = name;
+    }
     cl += " successfully";
     mChangelog->AddEntry(cl.c_str());
     mChangelog->ClearChanges();
@@ -211,9 +216,16 @@ RedisConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
 
   eos_notice("saving config name=%s comment=%s force=%d", name, comment, force);
 
+  XrdOucString current;
+
   if (!name) {
-    if (mConfigFile.length()) {
-      name = mConfigFile.c_str();
+    {
+      XrdSysMutexHelper lock(mMutex);
+      current = mConfigFile;
+    }
+
+    if (current.length()) {
+      name = current.c_str();
       force = true;
     } else {
       err = "error: you have to specify a configuration  name";
@@ -255,34 +267,7 @@ RedisConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
 
   if (rdx_hash.hlen() > 0) {
     if (force) {
-      // Create backup
-      char buff[20];
-      time_t now = time(NULL);
-      strftime(buff, 20, "%Y%m%d%H%M%S", localtime(&now));
-      std::string hash_key_backup;
-      hash_key_backup += conf_backup_hash_key_prefix.c_str();
-      hash_key_backup += ":";
-      hash_key_backup += name;
-      hash_key_backup += "-";
-      hash_key_backup += buff;
-      eos_notice("HASH KEY NAME => %s", hash_key_backup.c_str());
-      // Backup hash
-      redox::RedoxHash rdx_hash_backup(client, hash_key_backup);
-      std::vector<std::string> resp = rdx_hash.hkeys();
-
-      for (auto && elem : resp) {
-        rdx_hash_backup.hset(elem, rdx_hash.hget(elem));
-      }
-
-      // Clear
-      for (auto && elem : resp) {
-        rdx_hash.hdel(elem);
-      }
-
-      // Add hash to backup set
-      redox::RedoxSet rdx_set_backup(client, conf_set_backup_key);
-      // Add the hash key to the set if it's not there
-      rdx_set_backup.sadd(hash_key_backup);
+      BackupHash(hash_key, name);
     } else {
       errno = EEXIST;
       err = "error: a configuration with name \"";
@@ -292,9 +277,7 @@ RedisConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
     }
   }
 
-  mMutex.Lock();
-  sConfigDefinitions.Apply(SetConfigToRedisHash, &rdx_hash);
-  mMutex.UnLock();
+  StoreHash(hash_key);
   // Adding  timestamp
   XrdOucString stime;
   getTimeStamp(stime);
@@ -313,7 +296,10 @@ RedisConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
   cl += " ]";
   mChangelog->AddEntry(cl.c_str());
   mChangelog->ClearChanges();
-  mConfigFile = name;
+  {
+    XrdSysMutexHelper lock(mMutex);
+    mConfigFile = name;
+  }
   return true;
 }
 
@@ -465,9 +451,15 @@ RedisConfigEngine::FilterConfig(PrintInfo& pinfo, XrdOucString& out,
 bool
 RedisConfigEngine::AutoSave()
 {
-  if (mAutosave && mConfigFile.length()) {
+  XrdOucString name;
+  {
+    XrdSysMutexHelper lock(mMutex);
+    name = mConfigFile;
+  }
+
+  if (mAutosave && name.length()) {
     XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
+    envstring += name;
     envstring += "&mgm.config.force=1";
     envstring += "&mgm.config.autosave=1";
     XrdOucEnv env(envstring.c_str());
@@ -545,16 +537,7 @@ RedisConfigEngine::SetConfigValue(const char* prefix, const char* key,
   // If the change is not coming from a broacast we can can save it
   // (if autosave is enabled)
   if (mAutosave && not_bcast && mConfigFile.length()) {
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    envstring += "&mgm.config.autosave=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+    ScheduleAutoSave();
   }
 }
 
@@ -602,22 +585,15 @@ RedisConfigEngine::DeleteConfigValue(const char* prefix, const char* key,
     mChangelog->AddEntry(cl.c_str());
   }
 
-  // If the change is not coming from a broacast we can can save it
-  // (if autosave is enabled)
-  if (mAutosave && not_bcast && mConfigFile.length()) {
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    envstring += "&mgm.config.autosave=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
+  bool autosave = (mAutosave && not_bcast && mConfigFile.length());
+  mMutex.UnLock();
 
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+  // If the change is not coming from a broacast we can can save it
+  // (if autosave is enabled) - AutoSave takes the mutex itself
+  if (autosave) {
+    ScheduleAutoSave();
   }
 
-  mMutex.UnLock();
   eos_static_debug("%s", key);
 }
 
@@ -692,34 +668,7 @@ RedisConfigEngine::PushToRedis(XrdOucEnv& env, XrdOucString& err)
 
       if (rdx_hash.hlen() > 0) {
         if (force) {
-          // Create backup
-          char buff[20];
-          time_t now = time(NULL);
-          strftime(buff, 20, "%Y%m%d%H%M%S", localtime(&now));
-          std::string hash_key_backup;
-          hash_key_backup += conf_backup_hash_key_prefix.c_str();
-          hash_key_backup += ":";
-          hash_key_backup += name;
-          hash_key_backup += "-";
-          hash_key_backup += buff;
-          eos_notice("HASH KEY NAME => %s", hash_key_backup.c_str());
-          // Backup hash
-          redox::RedoxHash rdx_hash_backup(client, hash_key_backup);
-          std::vector<std::string> resp = rdx_hash.hkeys();
-
-          for (auto && elem : resp) {
-            rdx_hash_backup.hset(elem, rdx_hash.hget(elem));
-          }
-
-          // Clear
-          for (auto && elem : resp) {
-            rdx_hash.hdel(elem);
-          }
-
-          // Add hash to backup set
-          redox::RedoxSet rdx_set_backup(client, conf_set_backup_key);
-          // Add the hash key to the set if it's not there
-          rdx_set_backup.sadd(hash_key_backup);
+          BackupHash(hash_key, name);
         } else {
           errno = EEXIST;
           err = "error: a configuration with name \"";
@@ -729,9 +678,7 @@ RedisConfigEngine::PushToRedis(XrdOucEnv& env, XrdOucString& err)
         }
       }
 
-      mMutex.Lock();
-      sConfigDefinitions.Apply(SetConfigToRedisHash, &rdx_hash);
-      mMutex.UnLock();
+      StoreHash(hash_key);
       // Adding key for timestamp
       XrdOucString stime;
       getTimeStamp(stime);
@@ -746,7 +693,10 @@ RedisConfigEngine::PushToRedis(XrdOucEnv& env, XrdOucString& err)
 
       cl += " successfully";
       mChangelog->AddEntry(cl.c_str());
-      mConfigFile = name;
+      {
+        XrdSysMutexHelper lock(mMutex);
+        mConfigFile = name;
+      }
       mChangelog->ClearChanges();
       return true;
     }
@@ -761,20 +711,100 @@ RedisConfigEngine::PushToRedis(XrdOucEnv& env, XrdOucString& err)
 }
 
 //------------------------------------------------------------------------------
-// XrdOucHash callback function to add to the Redox hash all the
-// configuration values.
+// XrdOucHash callback function to add all the configuration values to a
+// batch of field/value pairs
 //------------------------------------------------------------------------------
 int
-RedisConfigEngine::SetConfigToRedisHash(const char* key, XrdOucString* def,
-                                        void* arg)
-
+RedisConfigEngine::AddConfigToBatch(const char* key, XrdOucString* def,
+                                    void* arg)
 {
   eos_static_debug("%s => %s", key, def->c_str());
-  redox::RedoxHash* hash = reinterpret_cast<redox::RedoxHash*>(arg);
-  hash->hset(key, std::string(def->c_str()));
+  std::vector<std::string>* batch =
+    reinterpret_cast<std::vector<std::string>*>(arg);
+  batch->push_back(key);
+  batch->push_back(def->c_str());
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Store the current configuration in a hash using batched HMSET commands
+//------------------------------------------------------------------------------
+void
+RedisConfigEngine::StoreHash(const std::string& hash_key)
+{
+  std::vector<std::string> batch;
+  mMutex.Lock();
+  sConfigDefinitions.Apply(AddConfigToBatch, &batch);
+  mMutex.UnLock();
+  // One round trip per sBatchSize keys instead of one per key
+  size_t npairs = batch.size() / 2;
+
+  for (size_t start = 0; start < npairs; start += sBatchSize) {
+    size_t stop = std::min(npairs, start + sBatchSize);
+    std::vector<std::string> cmd;
+    cmd.reserve(2 + 2 * (stop - start));
+    cmd.push_back("HMSET");
+    cmd.push_back(hash_key);
+    cmd.insert(cmd.end(), batch.begin() + 2 * start, batch.begin() + 2 * stop);
+    redox::Command<std::string>& c = client.commandSync<std::string>(cmd);
+
+    if (!c.ok()) {
+      eos_err("failed to store %lu configuration values in hash %s",
+              (unsigned long)(stop - start), hash_key.c_str());
+    }
+
+    c.free();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move an existing configuration hash to a time-stamped backup hash
+//------------------------------------------------------------------------------
+void
+RedisConfigEngine::BackupHash(const std::string& hash_key, const char* name)
+{
+  char buff[20];
+  time_t now = time(NULL);
+  strftime(buff, 20, "%Y%m%d%H%M%S", localtime(&now));
+  std::string hash_key_backup;
+  hash_key_backup += conf_backup_hash_key_prefix.c_str();
+  hash_key_backup += ":";
+  hash_key_backup += name;
+  hash_key_backup += "-";
+  hash_key_backup += buff;
+  std::string hash_key_base = hash_key_backup;
+
+  // Rename is done server side in one round trip and leaves the hash empty,
+  // RENAMENX keeps an existing backup saved within the same second
+  for (int i = 1; ; ++i) {
+    eos_notice("HASH KEY NAME => %s", hash_key_backup.c_str());
+    redox::Command<int>& c = client.commandSync<int>(
+    {"RENAMENX", hash_key, hash_key_backup});
+    bool ok = c.ok();
+    bool renamed = ok && c.reply();
+    c.free();
+
+    if (!ok) {
+      eos_err("failed to backup hash %s to %s", hash_key.c_str(),
+              hash_key_backup.c_str());
+      return;
+    }
+
+    if (renamed) {
+      break;
+    }
+
+    hash_key_backup = hash_key_base;
+    hash_key_backup += ".";
+    hash_key_backup += std::to_string((long long) i);
+  }
+
+  // Add hash to backup set
+  redox::RedoxSet rdx_set_backup(client, conf_set_backup_key);
+  // Add the hash key to the set if it's not there
+  rdx_set_backup.sadd(hash_key_backup);
+}
+
 //------------------------------------------------------------------------------
 // Get current timestamp
 //------------------------------------------------------------------------------
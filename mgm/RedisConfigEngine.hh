@@ -80,19 +80,19 @@ class RedisConfigEngine : public IConfigEngine
 {
 public:
   //----------------------------------------------------------------------------
-  //! XrdOucHash callback function to add to the Redox hash all the
-  //! configuration values.
+  //! XrdOucHash callback function to add all the configuration values to a
+  //! batch of field/value pairs
   //!
   //! @param key configuration key
   //! @param val configuration value
-  //! @param arg match pattern
+  //! @param arg vector of strings collecting the field/value pairs
   //!
   //! @return < 0 - the hash table item is deleted
   //!         = 0 - the next hash table item is processed
   //!         > 0 - processing stops and the hash table item is returned
   //----------------------------------------------------------------------------
   static int
-  SetConfigToRedisHash(const char* key, XrdOucString* def, void* Arg);
+  AddConfigToBatch(const char* key, XrdOucString* def, void* Arg);
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -221,6 +221,23 @@ private:
   std::string conf_hash_key_prefix = "EOSConfig";
   std::string conf_backup_hash_key_prefix = "EOSConfig:backup";
   std::string conf_set_backup_key = "EOSConfig:backuplist";
+  //! Max. number of keys sent with a single HMSET
+  static constexpr size_t sBatchSize = 1000;
+
+  //----------------------------------------------------------------------------
+  //! Store the current configuration in a hash using batched HMSET commands
+  //!
+  //! @param hash_key key of the hash
+  //----------------------------------------------------------------------------
+  void StoreHash(const std::string& hash_key);
+
+  //----------------------------------------------------------------------------
+  //! Move an existing configuration hash to a time-stamped backup hash
+  //!
+  //! @param hash_key key of the hash
+  //! @param name configuration name
+  //----------------------------------------------------------------------------
+  void BackupHash(const std::string& hash_key, const char* name);
 
   //----------------------------------------------------------------------------
   //! Get current timestamp
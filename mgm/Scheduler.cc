@@ -227,19 +227,20 @@ Scheduler::FilePlacement(PlacementArguments* args)
 }
 
 //------------------------------------------------------------------------------
-// Take the decision from where to access a file
+// Translate the access arguments for the GeoTreeEngine and add the already
+// tried filesystems to the unavailable ones
 //------------------------------------------------------------------------------
-
-int Scheduler::FileAccess(AccessArguments* args)
+static GeoTreeEngine::SchedType
+PrepareAccess(Scheduler::AccessArguments* args, size_t& nReqStripes)
 {
-  size_t nReqStripes = args->isRW ? eos::common::LayoutId::GetOnlineStripeNumber(
-                         args->lid) :
-                       eos::common::LayoutId::GetMinOnlineReplica(args->lid);
+  nReqStripes = args->isRW ? eos::common::LayoutId::GetOnlineStripeNumber(
+                  args->lid) :
+                eos::common::LayoutId::GetMinOnlineReplica(args->lid);
   eos_static_debug("requesting file access from geolocation %s",
                    args->vid->geolocation.c_str());
   GeoTreeEngine::SchedType st = GeoTreeEngine::regularRO;
 
-  if (args->schedtype == regular) {
+  if (args->schedtype == Scheduler::regular) {
     if (args->isRW) {
       st = GeoTreeEngine::regularRW;
     } else {
@@ -247,11 +248,11 @@ int Scheduler::FileAccess(AccessArguments* args)
     }
   }
 
-  if (args->schedtype == draining) {
+  if (args->schedtype == Scheduler::draining) {
     st = GeoTreeEngine::draining;
   }
 
-  if (args->schedtype == balancing) {
+  if (args->schedtype == Scheduler::balancing) {
     st = GeoTreeEngine::balancing;
   }
 
@@ -277,6 +278,17 @@ int Scheduler::FileAccess(AccessArguments* args)
     }
   }
 
+  return st;
+}
+
+//------------------------------------------------------------------------------
+// Take the decision from where to access a file
+//------------------------------------------------------------------------------
+
+int Scheduler::FileAccess(AccessArguments* args)
+{
+  size_t nReqStripes = 0;
+  GeoTreeEngine::SchedType st = PrepareAccess(args, nReqStripes);
   return gGeoTreeEngine.accessHeadReplicaMultipleGroup(nReqStripes,
          *args->fsindex,
          args->locationsfs,
@@ -290,4 +302,58 @@ int Scheduler::FileAccess(AccessArguments* args)
          args->forcedfsid, args->unavailfs, args->noIO);
 }
 
+//------------------------------------------------------------------------------
+// Take the decisions from where to access a file for several transfers
+//------------------------------------------------------------------------------
+size_t
+Scheduler::FileAccessBatch(AccessArguments* args,
+                           std::vector<unsigned long>& fsindexes)
+{
+  // the batch does not schedule proxies, do it one transfer at a time
+  if (args->dataproxys || args->firewallentpts) {
+    unsigned long* fsindex = args->fsindex;
+    size_t naccessed = 0;
+
+    for (; naccessed < fsindexes.size(); naccessed++) {
+      args->fsindex = &fsindexes[naccessed];
+
+      if (FileAccess(args)) {
+        break;
+      }
+    }
+
+    args->fsindex = fsindex;
+    return naccessed;
+  }
+
+  size_t nReqStripes = 0;
+  GeoTreeEngine::SchedType st = PrepareAccess(args, nReqStripes);
+  std::vector<GeoTreeEngine::AccessRequest> requests(fsindexes.size());
+
+  for (auto it = requests.begin(); it != requests.end(); ++it) {
+    it->nReplicas = nReqStripes;
+    it->existingReplicas = args->locationsfs;
+    it->forcedFsId = args->forcedfsid;
+    it->unavailableFs = *args->unavailfs;
+  }
+
+  gGeoTreeEngine.accessHeadReplicaMultipleGroupBatch(requests, st,
+      (!args->overridegeoloc ||
+       args->overridegeoloc->empty()) ? args->vid->geolocation : *
+      (args->overridegeoloc), args->noIO);
+  size_t naccessed = 0;
+
+  for (auto it = requests.begin(); it != requests.end(); ++it) {
+    if (it->retCode) {
+      // report the unavailable filesystems seen by the failed access
+      *args->unavailfs = it->unavailableFs;
+      break;
+    }
+
+    fsindexes[naccessed++] = it->fsIndex;
+  }
+
+  return naccessed;
+}
+
 EOSMGMNAMESPACE_END
@@ -218,6 +218,25 @@ public:
   //----------------------------------------------------------------------------
   static int FileAccess(AccessArguments* args);
 
+  //----------------------------------------------------------------------------
+  //! Take the decisions from where to access a file for several transfers at
+  //! once, e.g. one source per new replica. The scheduling groups holding the
+  //! file are locked only once and the penalty of each access is applied
+  //! before the next one is scheduled.
+  //!
+  //! @param args the structure holding the input arguments shared by all the
+  //!        transfers, args->fsindex is not used
+  //! @param fsindexes one entry per transfer, filled with the index in
+  //!        args->locationsfs of the filesystem to read from
+  //!
+  //! @return the number of transfers for which an access was scheduled, they
+  //!         are the first ones in fsindexes
+  //!
+  //! NOTE: Has to be called with a lock on the FsView::gFsView::ViewMutex
+  //----------------------------------------------------------------------------
+  static size_t FileAccessBatch(AccessArguments* args,
+                                std::vector<unsigned long>& fsindexes);
+
 protected:
 
   static XrdSysMutex pMapMutex; //< protect the following scheduling state maps
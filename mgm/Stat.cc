@@ -24,6 +24,7 @@
 /*----------------------------------------------------------------------------*/
 #include "common/Mapping.hh"
 #include "mgm/Stat.hh"
+#include "mgm/Access.hh"
 #include "mgm/FsView.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mq/XrdMqSharedObject.hh"
@@ -34,16 +35,92 @@
 /*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN
+
+XrdSysMutex Stat::sTagMutex;
+std::map<std::string, int> Stat::sTagIds;
+std::string Stat::sTagNames[Stat::kMaxTags];
+
+// per-thread cache of tag pointer => tag id
+#define EOS_STAT_TAG_CACHE 256
+static __thread const char* tlTagPtr[EOS_STAT_TAG_CACHE];
+static __thread int tlTagId[EOS_STAT_TAG_CACHE];
+// per-thread shard index
+static __thread int tlShard = -1;
+static int sNextShard = 0;
+
+/*----------------------------------------------------------------------------*/
+Stat::Stat () : mExecRotation(time(NULL) + kExecPeriod) { }
+
+/*----------------------------------------------------------------------------*/
+int
+Stat::RegisterTag (const char* tag)
+{
+  XrdSysMutexHelper lock(sTagMutex);
+  std::map<std::string, int>::const_iterator it = sTagIds.find(tag);
+
+  if (it != sTagIds.end())
+    return it->second;
+
+  int id = (int) sTagIds.size();
+
+  if (id >= kMaxTags)
+  {
+    eos_static_err("msg=\"statistics tag registry full\" tag=%s", tag);
+    return -1;
+  }
+
+  sTagNames[id] = tag;
+  sTagIds[tag] = id;
+  return id;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+Stat::GetTagId (const char* tag)
+{
+  // tags are almost always string literals, so the pointer is a good key -
+  // the name comparison protects against reused buffers
+  size_t slot = (((unsigned long long) tag) >> 3) % EOS_STAT_TAG_CACHE;
+
+  if ((tlTagPtr[slot] == tag) &&
+      (!strcmp(sTagNames[tlTagId[slot]].c_str(), tag)))
+    return tlTagId[slot];
+
+  int id = RegisterTag(tag);
+
+  if (id >= 0)
+  {
+    tlTagPtr[slot] = tag;
+    tlTagId[slot] = id;
+  }
+
+  return id;
+}
+
+/*----------------------------------------------------------------------------*/
+StatShard&
+Stat::GetShard ()
+{
+  if (tlShard < 0)
+    tlShard = __sync_fetch_and_add(&sNextShard, 1) % kShards;
+
+  return mShards[tlShard];
+}
+
 /*----------------------------------------------------------------------------*/
 void
 Stat::Add (const char* tag, uid_t uid, gid_t gid, unsigned long val)
 {
-  Mutex.Lock();
-  StatsUid[tag][uid] += val;
-  StatsGid[tag][gid] += val;
-  StatAvgUid[tag][uid].Add(val);
-  StatAvgGid[tag][gid].Add(val);
-  Mutex.UnLock();
+  int id = GetTagId(tag);
+
+  if (id < 0)
+    return;
+
+  Access::gRateLimiter.Account(id, uid, gid, val);
+  StatShard& shard = GetShard();
+  XrdSysMutexHelper lock(shard.Mutex);
+  shard.DeltaUid[(((unsigned long long) id) << 32) | uid] += val;
+  shard.DeltaGid[(((unsigned long long) id) << 32) | gid] += val;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -60,14 +137,63 @@ Stat::AddExt (const char* tag, uid_t uid, gid_t gid, unsigned long nsample, cons
 void
 Stat::AddExec (const char* tag, float exectime)
 {
-  Mutex.Lock();
-  StatExec[tag].push_back(exectime);
-  // we average over 100 entries
-  if (StatExec[tag].size() > 100)
+  int id = GetTagId(tag);
+
+  if (id < 0)
+    return;
+
+  StatShard& shard = GetShard();
+  XrdSysMutexHelper lock(shard.Mutex);
+
+  if (shard.Exec.size() <= (size_t) id)
+    shard.Exec.resize(id + 1, 0);
+
+  if (!shard.Exec[id])
+    shard.Exec[id] = new eos::common::LatencyHistogram();
+
+  shard.Exec[id]->Add(exectime);
+}
+
+/*----------------------------------------------------------------------------*/
+// warning: you have to lock the mutex
+
+void
+Stat::MergeShards ()
+{
+  for (int i = 0; i < kShards; ++i)
   {
-    StatExec[tag].pop_front();
+    StatShard& shard = mShards[i];
+    XrdSysMutexHelper lock(shard.Mutex);
+    std::unordered_map<unsigned long long, unsigned long long>::const_iterator it;
+
+    for (it = shard.DeltaUid.begin(); it != shard.DeltaUid.end(); ++it)
+    {
+      const std::string& tag = sTagNames[it->first >> 32];
+      uid_t uid = (uid_t) (it->first & 0xffffffff);
+      StatsUid[tag][uid] += it->second;
+      StatAvgUid[tag][uid].Add(it->second);
+    }
+
+    for (it = shard.DeltaGid.begin(); it != shard.DeltaGid.end(); ++it)
+    {
+      const std::string& tag = sTagNames[it->first >> 32];
+      gid_t gid = (gid_t) (it->first & 0xffffffff);
+      StatsGid[tag][gid] += it->second;
+      StatAvgGid[tag][gid].Add(it->second);
+    }
+
+    shard.DeltaUid.clear();
+    shard.DeltaGid.clear();
+
+    for (size_t id = 0; id < shard.Exec.size(); ++id)
+    {
+      if (shard.Exec[id] && shard.Exec[id]->GetCount())
+      {
+        StatExec[sTagNames[id]].Current.Merge(*shard.Exec[id]);
+        shard.Exec[id]->Reset();
+      }
+    }
   }
-  Mutex.UnLock();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -476,71 +602,58 @@ double
 Stat::GetExec (const char* tag, double &deviation)
 {
   // calculates average execution time for 'tag'
-  if (StatExec.count(tag))
-  {
-    std::deque<float>::const_iterator it;
-    double sum = 0;
-    double avg = 0;
-    deviation = 0;
-    int cnt = 0;
-    for (it = StatExec[tag].begin(); it != StatExec[tag].end(); it++)
-    {
-      cnt++;
-      sum += *it;
-    }
+  deviation = 0;
+  std::map<std::string, StatExecHist>::const_iterator it = StatExec.find(tag);
 
-    avg = sum / cnt;
+  if (it == StatExec.end())
+    return 0;
 
-    for (it = StatExec[tag].begin(); it != StatExec[tag].end(); it++)
-    {
-      deviation += pow((*it - avg), 2);
-    }
-    deviation = sqrt(deviation / cnt);
-    return avg;
-  }
-  return 0;
+  eos::common::LatencyHistogram hist;
+  it->second.Get(hist);
+  return hist.GetAvg(deviation);
 }
 
 /*----------------------------------------------------------------------------*/
 // warning: you have to lock the mutex if directly used
 
-double
-Stat::GetTotalExec (double &deviation)
+bool
+Stat::GetExecPercentiles (const char* tag, double &p50, double &p99, double &p999)
 {
-  // calculates average execution time for all commands
-  google::sparse_hash_map<std::string, std::deque<float> >::const_iterator ittag;
+  p50 = p99 = p999 = 0;
+  std::map<std::string, StatExecHist>::const_iterator it = StatExec.find(tag);
 
-  double sum = 0;
-  double avg = 0;
-  deviation = 0;
-  int cnt = 0;
+  if (it == StatExec.end())
+    return false;
 
-  for (ittag = StatExec.begin(); ittag != StatExec.end(); ittag++)
-  {
-    std::deque<float>::const_iterator it;
+  eos::common::LatencyHistogram hist;
+  it->second.Get(hist);
 
-    for (it = ittag->second.begin(); it != ittag->second.end(); it++)
-    {
-      cnt++;
-      sum += *it;
-    }
-  }
+  if (!hist.GetCount())
+    return false;
 
-  if (cnt)
-    avg = sum / cnt;
+  p50 = hist.Percentile(0.5);
+  p99 = hist.Percentile(0.99);
+  p999 = hist.Percentile(0.999);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+// warning: you have to lock the mutex if directly used
 
-  for (ittag = StatExec.begin(); ittag != StatExec.end(); ittag++)
+double
+Stat::GetTotalExec (double &deviation)
+{
+  // calculates average execution time for all commands
+  eos::common::LatencyHistogram total;
+  std::map<std::string, StatExecHist>::const_iterator it;
+
+  for (it = StatExec.begin(); it != StatExec.end(); ++it)
   {
-    std::deque<float>::const_iterator it;
-    for (it = ittag->second.begin(); it != ittag->second.end(); it++)
-    {
-      deviation += pow((*it - avg), 2);
-    }
+    total.Merge(it->second.Previous);
+    total.Merge(it->second.Current);
   }
 
-  if (cnt)
-    deviation = sqrt(deviation / cnt);
-  return avg;
+  return total.GetAvg(deviation);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -548,6 +661,22 @@ void
 Stat::Clear ()
 {
   Mutex.Lock();
+
+  // quiesce the shards while the tables are cleared, otherwise updates added
+  // concurrently would survive the clear and be merged afterwards
+  for (int i = 0; i < kShards; ++i)
+  {
+    mShards[i].Mutex.Lock();
+    mShards[i].DeltaUid.clear();
+    mShards[i].DeltaGid.clear();
+
+    for (size_t id = 0; id < mShards[i].Exec.size(); ++id)
+    {
+      if (mShards[i].Exec[id])
+        mShards[i].Exec[id]->Reset();
+    }
+  }
+
   google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator ittag;
   for (ittag = StatsUid.begin(); ittag != StatsUid.end(); ittag++)
   {
@@ -559,8 +688,14 @@ Stat::Clear ()
     StatAvgUid[ittag->first].resize(1000);
     StatAvgGid[ittag->first].clear();
     StatAvgGid[ittag->first].resize(1000);
-    StatExec[ittag->first].resize(1000);
   }
+  StatExec.clear();
+
+  for (int i = kShards - 1; i >= 0; --i)
+  {
+    mShards[i].Mutex.UnLock();
+  }
+
   Mutex.UnLock();
 }
 
@@ -569,6 +704,7 @@ void
 Stat::PrintOutTotal (XrdOucString &out, bool details, bool monitoring, bool numerical)
 {
   Mutex.Lock();
+  MergeShards();
   std::vector<std::string> tags, tags_ext;
   std::vector<std::string>::iterator it;
 
@@ -598,7 +734,7 @@ Stat::PrintOutTotal (XrdOucString &out, bool details, bool monitoring, bool nume
     sprintf(outline, "%-8s %-32s %3.02f +- %3.02f\n", "ALL", "Execution Time", avg, sig);
     out += outline;
     out += "# -----------------------------------------------------------------------------------------------------------\n";
-    sprintf(outline, "%-8s %-32s %-9s %8s %8s %8s %8s %-8s +- %-10s", "who", "command", "sum", "5s", "1min", "5min", "1h", "exec(ms)", "sigma(ms)");
+    sprintf(outline, "%-8s %-32s %-9s %8s %8s %8s %8s %-8s +- %-10s %8s %8s %8s", "who", "command", "sum", "5s", "1min", "5min", "1h", "exec(ms)", "sigma(ms)", "p50(ms)", "p99(ms)", "p999(ms)");
     out += outline;
     out += "\n";
     out += "# -----------------------------------------------------------------------------------------------------------\n";
@@ -619,9 +755,27 @@ Stat::PrintOutTotal (XrdOucString &out, bool details, bool monitoring, bool nume
     char a3600[1024];
     char aexec[1024];
     char aexecsig[1024];
+    char ap50[1024];
+    char ap99[1024];
+    char ap999[1024];
     double avg = 0;
     double sig = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
     avg = GetExec(tag, sig);
+    if (GetExecPercentiles(tag, p50, p99, p999))
+    {
+      sprintf(ap50, "%3.02f", p50);
+      sprintf(ap99, "%3.02f", p99);
+      sprintf(ap999, "%3.02f", p999);
+    }
+    else
+    {
+      sprintf(ap50, "-NA-");
+      sprintf(ap99, "-NA-");
+      sprintf(ap999, "-NA-");
+    }
     sprintf(a5, "%3.02f", GetTotalAvg5(tag));
     sprintf(a60, "%3.02f", GetTotalAvg60(tag));
     sprintf(a300, "%3.02f", GetTotalAvg300(tag));
@@ -637,11 +791,11 @@ Stat::PrintOutTotal (XrdOucString &out, bool details, bool monitoring, bool nume
 
     if (!monitoring)
     {
-      sprintf(outline, "ALL        %-32s %12llu %8s %8s %8s %8s %8s +- %-10s\n", tag, GetTotal(tag), a5, a60, a300, a3600, aexec, aexecsig);
+      sprintf(outline, "ALL        %-32s %12llu %8s %8s %8s %8s %8s +- %-10s %8s %8s %8s\n", tag, GetTotal(tag), a5, a60, a300, a3600, aexec, aexecsig, ap50, ap99, ap999);
     }
     else
     {
-      sprintf(outline, "uid=all gid=all cmd=%s total=%llu 5s=%s 60s=%s 300s=%s 3600s=%s exec=%f execsig=%f\n", tag, GetTotal(tag), a5, a60, a300, a3600, avg, sig);
+      sprintf(outline, "uid=all gid=all cmd=%s total=%llu 5s=%s 60s=%s 300s=%s 3600s=%s exec=%f execsig=%f exec50=%f exec99=%f exec999=%f\n", tag, GetTotal(tag), a5, a60, a300, a3600, avg, sig, p50, p99, p999);
     }
     out += outline;
   }
@@ -1188,6 +1342,19 @@ Stat::Circulate ()
     // --------------------------------------------
 
     Mutex.Lock();
+    MergeShards();
+
+    if (time(NULL) >= mExecRotation)
+    {
+      std::map<std::string, StatExecHist>::iterator eit;
+
+      for (eit = StatExec.begin(); eit != StatExec.end(); ++eit)
+      {
+        eit->second.Rotate();
+      }
+
+      mExecRotation = time(NULL) + kExecPeriod;
+    }
 
     google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatAvg> >::iterator tit;
     google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatExt> >::iterator tit_ext;
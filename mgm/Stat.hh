@@ -26,6 +26,7 @@
 
 /*----------------------------------------------------------------------------*/
 #include "mgm/Namespace.hh"
+#include "common/LatencyHistogram.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucHash.hh"
@@ -36,7 +37,7 @@
 #include <vector>
 #include <map>
 #include <string>
-#include <deque>
+#include <unordered_map>
 #include <math.h>
 
 EOSMGMNAMESPACE_BEGIN
@@ -426,6 +427,55 @@ public:
 
 };
 
+/*----------------------------------------------------------------------------*/
+//! Execution time histograms of a tag covering the running and the previous
+//! accounting period
+/*----------------------------------------------------------------------------*/
+class StatExecHist
+{
+public:
+  eos::common::LatencyHistogram Current;
+  eos::common::LatencyHistogram Previous;
+
+  void
+  Rotate ()
+  {
+    Previous = Current;
+    Current.Reset();
+  }
+
+  void
+  Get (eos::common::LatencyHistogram &merged) const
+  {
+    merged = Previous;
+    merged.Merge(Current);
+  }
+};
+
+/*----------------------------------------------------------------------------*/
+//! Shard of not yet merged statistics updates. Every thread is bound to one
+//! shard, the shards are drained into the Stat tables by Stat::Circulate and
+//! before the tables are printed.
+/*----------------------------------------------------------------------------*/
+class StatShard
+{
+public:
+  XrdSysMutex Mutex;
+  // key is (tag id << 32) | uid
+  std::unordered_map<unsigned long long, unsigned long long> DeltaUid;
+  // key is (tag id << 32) | gid
+  std::unordered_map<unsigned long long, unsigned long long> DeltaGid;
+  // execution time histograms indexed by tag id, allocated on first use
+  std::vector<eos::common::LatencyHistogram*> Exec;
+
+  StatShard () { };
+
+  ~StatShard ()
+  {
+    for (size_t i = 0; i < Exec.size(); ++i)
+      delete Exec[i];
+  }
+};
 
 #define EXEC_TIMING_BEGIN(__ID__)               \
   struct timeval start__ID__;                   \
@@ -440,6 +490,13 @@ public:
 class Stat
 {
 public:
+  //! maximum number of distinct tags
+  static const int kMaxTags = 1024;
+  //! number of update shards
+  static const int kShards = 32;
+  //! length of an execution time accounting period in seconds
+  static const time_t kExecPeriod = 300;
+
   XrdSysMutex Mutex;
 
   // first is name of value, then the map
@@ -449,7 +506,17 @@ public:
   google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatAvg> > StatAvgGid;
   google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatExt> > StatExtUid;
   google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatExt> > StatExtGid;
-  google::sparse_hash_map<std::string, std::deque<float> > StatExec;
+  std::map<std::string, StatExecHist> StatExec;
+
+  Stat ();
+
+  //----------------------------------------------------------------------------
+  //! Register a tag and return its id - tags are registered implicitly by
+  //! the Add functions, the registry is shared by all Stat objects
+  //!
+  //! @return tag id or -1 if the registry is full
+  //----------------------------------------------------------------------------
+  static int RegisterTag (const char* tag);
 
   void Add (const char* tag, uid_t uid, gid_t gid, unsigned long val);
 
@@ -490,6 +557,9 @@ public:
   // warning: you have to lock the mutex if directly used
   double GetExec (const char* tag, double &deviation);
 
+  // warning: you have to lock the mutex if directly used
+  bool GetExecPercentiles (const char* tag, double &p50, double &p99, double &p999);
+
   // warning: you have to lock the mutex if directly used
   double GetTotalExec (double &deviation);
 
@@ -498,6 +568,20 @@ public:
   void PrintOutTotal (XrdOucString &out, bool details = false, bool monitoring = false, bool numerical = false);
 
   void Circulate ();
+
+private:
+  static XrdSysMutex sTagMutex;
+  static std::map<std::string, int> sTagIds;
+  static std::string sTagNames[kMaxTags];
+
+  StatShard mShards[kShards];
+  time_t mExecRotation; ///< time of the next execution histogram rotation
+
+  static int GetTagId (const char* tag);
+  StatShard& GetShard ();
+
+  // warning: you have to lock the mutex
+  void MergeShards ();
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// File: TokenBucket.cc
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/TokenBucket.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+TokenBucket::TokenBucket(double rate, double burst, const std::string& rule,
+                         int64_t now_us):
+  mRate(rate),
+  mCapacity((int64_t)((burst < 1.0 ? 1.0 : burst) * 1000000.0)),
+  mRule(rule), mRejected(0), mLevel(mCapacity), mStamp(now_us)
+{}
+
+//------------------------------------------------------------------------------
+// Add the tokens accumulated since the last refill
+//------------------------------------------------------------------------------
+void
+TokenBucket::Refill(int64_t now_us)
+{
+  int64_t last = mStamp.load();
+
+  if (now_us <= last) {
+    return;
+  }
+
+  // whoever moves the time stamp owns the elapsed interval
+  if (!mStamp.compare_exchange_strong(last, now_us)) {
+    return;
+  }
+
+  int64_t add = (int64_t)((now_us - last) * mRate);
+  int64_t level = mLevel.fetch_add(add) + add;
+
+  while (level > mCapacity) {
+    if (mLevel.compare_exchange_weak(level, mCapacity)) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take tokens from the bucket
+//------------------------------------------------------------------------------
+void
+TokenBucket::Take(unsigned long n, int64_t now_us)
+{
+  Refill(now_us);
+  mLevel.fetch_sub(((int64_t) n) * 1000000);
+}
+
+//------------------------------------------------------------------------------
+// Time until the bucket is out of debt
+//------------------------------------------------------------------------------
+int64_t
+TokenBucket::DebtTime(int64_t now_us)
+{
+  Refill(now_us);
+  int64_t level = mLevel.load();
+
+  if (level >= 0) {
+    return 0;
+  }
+
+  return (int64_t)(-level / mRate) + 1;
+}
+
+EOSMGMNAMESPACE_END
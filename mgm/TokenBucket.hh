@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+// File: TokenBucket.hh
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_TOKENBUCKET__HH__
+#define __EOSMGM_TOKENBUCKET__HH__
+
+#include "mgm/Namespace.hh"
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Lock-free token bucket
+//!
+//! The level is kept in micro-tokens. The bucket refills with 'rate' tokens
+//! per second up to a capacity of 'burst' tokens (at least one). Operations
+//! are taken after they have been admitted, so the level can go below zero -
+//! the identity is then stalled until the debt is paid back.
+//------------------------------------------------------------------------------
+class TokenBucket
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor - the bucket starts full
+  //!
+  //! @param rate refill rate in tokens per second
+  //! @param burst capacity in tokens
+  //! @param rule stall rule this bucket enforces
+  //! @param now_us current time in microseconds
+  //----------------------------------------------------------------------------
+  TokenBucket(double rate, double burst, const std::string& rule,
+              int64_t now_us);
+
+  //----------------------------------------------------------------------------
+  //! Take tokens from the bucket
+  //!
+  //! @param n number of tokens
+  //! @param now_us current time in microseconds
+  //----------------------------------------------------------------------------
+  void Take(unsigned long n, int64_t now_us);
+
+  //----------------------------------------------------------------------------
+  //! Time until the bucket is out of debt
+  //!
+  //! @param now_us current time in microseconds
+  //!
+  //! @return microseconds until the level is positive again, 0 if it is
+  //----------------------------------------------------------------------------
+  int64_t DebtTime(int64_t now_us);
+
+  //----------------------------------------------------------------------------
+  //! Current level in tokens
+  //----------------------------------------------------------------------------
+  double
+  GetLevel() const
+  {
+    return mLevel.load() / 1000000.0;
+  }
+
+  const double mRate; ///< Refill rate in tokens per second
+  const int64_t mCapacity; ///< Max. level in micro-tokens
+  const std::string mRule; ///< Stall rule key this bucket enforces
+  std::atomic<unsigned long long> mRejected; ///< Number of stalled requests
+
+private:
+  //----------------------------------------------------------------------------
+  //! Add the tokens accumulated since the last refill
+  //----------------------------------------------------------------------------
+  void Refill(int64_t now_us);
+
+  std::atomic<int64_t> mLevel; ///< Level in micro-tokens
+  std::atomic<int64_t> mStamp; ///< Time of the last refill in microseconds
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
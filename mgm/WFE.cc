@@ -59,6 +59,10 @@ WFE::WFE()
 {
   mThread = 0;
   mMs = 0;
+  mInterval = 0;
+  mDispatchLag = 0;
+  mLatencySum = 0;
+  mLatencyCount = 0;
   eos::common::Mapping::Root(mRootVid);
   XrdSysMutexHelper sLock(gSchedulerMutex);
   gScheduler = new XrdScheduler(&gMgmOfsEroute, &gMgmOfsTrace, 2, 128, 64);
@@ -117,8 +121,10 @@ WFE::WFEr()
 /**
  * @brief WFE method doing the actual workflow
  *
- * This thread method loops in regular intervals over all workflow jobs in the
- * workflow directory /eos/<instance>/proc/workflow/
+ * This thread method dispatches the workflow jobs of the workflow directory
+ * /eos/<instance>/proc/workflow/ when they are due. The pending jobs are kept
+ * in an in-memory index ordered by due time, which is built from the namespace
+ * when the engine becomes active and then updated by Job::Save/Job::Delete.
  */
 /*----------------------------------------------------------------------------*/
 {
@@ -146,9 +152,10 @@ WFE::WFEr()
   //----------------------------------------------------------------------------
   // Eternal thread doing WFE scans
   //----------------------------------------------------------------------------
-  time_t snoozetime = 10;
   size_t lWFEntx = 0;
   time_t cleanuptime = 0;
+  time_t publishtime = 0;
+  bool indexed = false;
   eos_static_info("msg=\"async WFE thread started\"");
 
   while (1) {
@@ -158,11 +165,7 @@ WFE::WFEr()
     XrdSysThread::SetCancelOff();
     bool IsEnabledWFE;
     time_t lWFEInterval;
-    time_t lStartTime = time(NULL);
-    time_t lStopTime;
     time_t lKeepTime = 7 * 86400;
-    std::map<std::string, std::set<std::string> > wfedirs;
-    XrdOucString stdErr;
     {
       eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
 
@@ -190,147 +193,31 @@ WFE::WFEr()
       }
     }
 
+    {
+      XrdSysCondVarHelper lLock(mIndexSignal);
+      mInterval = lWFEInterval;
+    }
+
     // only a master needs to run WFE
     if (gOFS->MgmMaster.IsMaster() && IsEnabledWFE) {
-      // -------------------------------------------------------------------------
-      // do a find
-      // -------------------------------------------------------------------------
-      eos_static_info("msg=\"start WFE scan\"");
-      // -------------------------------------------------------------------------
-      // find all directories defining an WFE policy
-      // -------------------------------------------------------------------------
-      gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
-      EXEC_TIMING_BEGIN("WFEFind");
-      // prepare four queries today, yestereday for queued and error jobs
-      std::string queries[4];
-
-      for (size_t i = 0; i < 4; ++i) {
-        queries[i] = gOFS->MgmProcWorkflowPath.c_str();
-        queries[i] += "/";
-      }
-
-      {
-        // today
-        time_t when = time(NULL);
-        std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[0] += day;
-        queries[0] += "/q/";
-        queries[1] += day;
-        queries[1] += "/e/";
-        //yesterday
-        when -= (24 * 3600);
-        day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[2] += day;
-        queries[2] += "/q/";
-        queries[3] += day;
-        queries[3] += "/e/";
-      }
-
-      for (size_t i = 0; i < 4; ++i) {
-        eos_static_info("query-path=%s", queries[i].c_str());
-        gOFS->_find(queries[i].c_str(),
-                    mError,
-                    stdErr,
-                    mRootVid,
-                    wfedirs,
-                    0,
-                    0,
-                    false,
-                    0,
-                    false,
-                    0
-                   );
-      }
-
-      {
-        eos_static_info("msg=\"finished WFE find\" WFE-dirs=%llu %s",
-                        wfedirs.size(), stdErr.c_str()
-                       );
-        time_t now = time(NULL);
-
-        for (auto it = wfedirs.begin(); it != wfedirs.end(); it++) {
-          // -------------------------------------------------------------------
-          // get workflows
-          // -------------------------------------------------------------------
-          if (it->second.size()) {
-            for (auto wit = it->second.begin(); wit != it->second.end(); ++wit) {
-              eos_static_info("wfe-dir=\"%s\" wfe-job=\"%s\"", it->first.c_str(),
-                              wit->c_str());
-              std::string f = it->first;
-              f += *wit;
-              Job* job = new Job();
-
-              if (!job || job->Load(f)) {
-                eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"", f.c_str());
-
-                if (job) {
-                  delete job;
-                }
-              } else {
-                // don't schedule jobs for the future
-                if (now < job->mActions[0].mTime) {
-                  delete job;
-                  continue;
-                }
-
-                // stop scheduling if there are too many jobs running
-                if ((lWFEntx - GetActiveJobs()) <= 0) {
-                  if (lWFEntx > 0) {
-                    mDoneSignal.Wait(10);
-
-                    if ((lWFEntx - GetActiveJobs()) <= 0) {
-                      break;
-                    }
-                  }
-                }
-
-                // use the shared scheduler
-                XrdSysMutexHelper sLock(gSchedulerMutex);
-                gScheduler->Schedule((XrdJob*) job);
-                IncActiveJobs();
-                eos_static_info("msg=\"scheduled workflow\" job=\"%s\"",
-                                job->mDescription.c_str());
-              }
-            }
-          }
-        }
+      if (!indexed) {
+        // -----------------------------------------------------------------------
+        // (re-)build the index of pending jobs from the namespace, from now on
+        // it is maintained by Job::Save and Job::Delete
+        // -----------------------------------------------------------------------
+        RebuildIndex();
+        indexed = true;
       }
 
-      EXEC_TIMING_END("WFEFind");
-      eos_static_info("msg=\"finished WFE application\" WFE-dirs=%llu",
-                      wfedirs.size()
-                     );
-    }
-
-    lStopTime = time(NULL);
-
-    if ((lStopTime - lStartTime) < lWFEInterval) {
-      snoozetime = lWFEInterval - (lStopTime - lStartTime);
+      DispatchJobs(lWFEntx);
+    } else {
+      // the queues can change while we are not in charge
+      indexed = false;
     }
 
-    eos_static_info("snooze-time=%llu enabled=%d", snoozetime, IsEnabledWFE);
-    XrdSysThread::SetCancelOn();
-    XrdSysTimer sleeper;
-    time_t snoozeinterval = 1;
-    size_t snoozeloop = snoozetime / 1;
-
-    for (size_t i = 0; i < snoozeloop; i++) {
-      sleeper.Snooze(snoozeinterval);
-      {
-        // check if the setting changes
-        eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-
-        if (FsView::gFsView.mSpaceView.count("default") &&
-            (FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe") == "on")) {
-          if (!IsEnabledWFE) {
-            break;
-          }
-        } else {
-          if (IsEnabledWFE) {
-            break;
-          }
-        }
-      }
+    if (!publishtime || (publishtime < time(NULL))) {
+      PublishQueueStats();
+      publishtime = time(NULL) + 10;
     }
 
     if (!cleanuptime || (cleanuptime < time(NULL))) {
@@ -375,11 +262,275 @@ WFE::WFEr()
 
       cleanuptime = now + 3600;
     }
+
+    // -------------------------------------------------------------------------
+    // wait until the next job is due or a new job got queued, at most 1s to
+    // follow configuration changes
+    // -------------------------------------------------------------------------
+    {
+      XrdSysCondVarHelper lLock(mIndexSignal);
+
+      if (!indexed || mJobsByTime.empty() ||
+          (mJobsByTime.begin()->first > time(NULL))) {
+        mIndexSignal.WaitMS(1000);
+      }
+    }
+
+    XrdSysThread::SetCancelOn();
+    XrdSysThread::CancelPoint();
   };
 
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+WFE::RebuildIndex()
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief rebuild the index of the pending jobs from the namespace
+ *
+ * The queued and error entries of today and yesterday are indexed, which are
+ * the ones the engine is allowed to run.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  eos_static_info("msg=\"start WFE index rebuild\"");
+  gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
+  EXEC_TIMING_BEGIN("WFEFind");
+  {
+    XrdSysCondVarHelper lLock(mIndexSignal);
+    mJobsByTime.clear();
+    mJobsByPath.clear();
+  }
+  // prepare four queries today, yestereday for queued and error jobs
+  std::string queries[4];
+  std::string queues[4] = {"q", "e", "q", "e"};
+
+  for (size_t i = 0; i < 4; ++i) {
+    queries[i] = gOFS->MgmProcWorkflowPath.c_str();
+    queries[i] += "/";
+  }
+
+  {
+    // today
+    time_t when = time(NULL);
+    std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
+    queries[0] += day;
+    queries[0] += "/q/";
+    queries[1] += day;
+    queries[1] += "/e/";
+    //yesterday
+    when -= (24 * 3600);
+    day = eos::common::Timing::UnixTimstamp_to_Day(when);
+    queries[2] += day;
+    queries[2] += "/q/";
+    queries[3] += day;
+    queries[3] += "/e/";
+  }
+
+  for (size_t i = 0; i < 4; ++i) {
+    XrdOucString stdErr;
+    eos_static_info("query-path=%s", queries[i].c_str());
+    FindFunctionVisitor visitor(
+      [](const std::string & dir) {},
+      [&](const std::string & dir, const std::vector<std::string>& names) {
+      for (auto it = names.begin(); it != names.end(); ++it) {
+        // entries are named <when>:<fxid>:<event>
+        time_t when = strtoull(it->c_str(), 0, 10);
+        IndexJob(queues[i], dir + *it, when);
+      }
+    });
+    gOFS->_find(queries[i].c_str(),
+                mError,
+                stdErr,
+                mRootVid,
+                visitor,
+                0,
+                0,
+                false,
+                0,
+                false,
+                0
+               );
+  }
+
+  EXEC_TIMING_END("WFEFind");
+  eos_static_info("msg=\"finished WFE index rebuild\" queued=%llu",
+                  (unsigned long long) GetQueuedJobs());
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::DispatchJobs(size_t ntx)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief schedule all jobs which are due in the order of their due time
+ * @param ntx maximum number of active jobs, 0 for no limit
+ */
+/*----------------------------------------------------------------------------*/
+{
+  while (1) {
+    std::string path;
+    time_t due;
+    time_t now = time(NULL);
+    {
+      XrdSysCondVarHelper lLock(mIndexSignal);
+
+      if (mJobsByTime.empty()) {
+        return;
+      }
+
+      due = mJobsByTime.begin()->first;
+      path = mJobsByTime.begin()->second;
+
+      if (due > now) {
+        return;
+      }
+    }
+
+    // stop scheduling if there are too many jobs running
+    if (ntx && (GetActiveJobs() >= ntx)) {
+      {
+        XrdSysCondVarHelper lLock(mDoneSignal);
+        mDoneSignal.WaitMS(1000);
+      }
+
+      if (GetActiveJobs() >= ntx) {
+        return;
+      }
+    }
+
+    // the entry is taken out of the index, a job failing to load is dropped
+    UnindexJob(path);
+    Job* job = new Job();
+
+    if (job->Load(path)) {
+      eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"",
+                     path.c_str());
+      delete job;
+      continue;
+    }
+
+    {
+      XrdSysCondVarHelper lLock(mIndexSignal);
+
+      if ((now - due) > mDispatchLag) {
+        mDispatchLag = now - due;
+      }
+    }
+    // use the shared scheduler
+    XrdSysMutexHelper sLock(gSchedulerMutex);
+    gScheduler->Schedule((XrdJob*) job);
+    IncActiveJobs();
+    eos_static_info("msg=\"scheduled workflow\" job=\"%s\" lag=%lld",
+                    job->mDescription.c_str(), (long long)(now - due));
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::IndexJob(const std::string& queue, const std::string& path, time_t when)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief add a queue entry to the index of pending jobs
+ *
+ * Entries in the error queue are retried at the earliest one scan interval
+ * after their time stamp.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  if ((queue != "q") && (queue != "e")) {
+    return;
+  }
+
+  XrdSysCondVarHelper lLock(mIndexSignal);
+
+  if (queue == "e") {
+    when += mInterval;
+  }
+
+  auto it = mJobsByPath.find(path);
+
+  if (it != mJobsByPath.end()) {
+    mJobsByTime.erase(it->second);
+    mJobsByPath.erase(it);
+  }
+
+  mJobsByPath[path] = mJobsByTime.insert(std::make_pair(when, path));
+  mIndexSignal.Signal();
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::UnindexJob(const std::string& path)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief remove a queue entry from the index of pending jobs
+ */
+/*----------------------------------------------------------------------------*/
+{
+  XrdSysCondVarHelper lLock(mIndexSignal);
+  auto it = mJobsByPath.find(path);
+
+  if (it != mJobsByPath.end()) {
+    mJobsByTime.erase(it->second);
+    mJobsByPath.erase(it);
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::JobDone(time_t latency)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief account the latency of a finished job
+ */
+/*----------------------------------------------------------------------------*/
+{
+  XrdSysCondVarHelper lLock(mIndexSignal);
+  mLatencySum += (latency > 0) ? latency : 0;
+  mLatencyCount++;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::PublishQueueStats()
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief publish the queue depth, the maximum dispatch lag and the average job
+ * latency since the last publication in the space view
+ *
+ */
+/*----------------------------------------------------------------------------*/
+{
+  char squeued[256];
+  char slag[256];
+  char slatency[256];
+  {
+    XrdSysCondVarHelper lLock(mIndexSignal);
+    snprintf(squeued, sizeof(squeued) - 1, "%lu", mJobsByTime.size());
+    snprintf(slag, sizeof(slag) - 1, "%lld", (long long) mDispatchLag);
+    snprintf(slatency, sizeof(slatency) - 1, "%.02f", mLatencyCount ?
+             (1.0 * mLatencySum / mLatencyCount) : 0.0);
+    mDispatchLag = 0;
+    mLatencySum = 0;
+    mLatencyCount = 0;
+  }
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+  if (!FsView::gFsView.mSpaceView.count("default")) {
+    return;
+  }
+
+  FsView::gFsView.mSpaceView["default"]->SetConfigMember
+  ("stat.workflow.queued", squeued, true, "/eos/*/mgm", true);
+  FsView::gFsView.mSpaceView["default"]->SetConfigMember
+  ("stat.workflow.lag", slag, true, "/eos/*/mgm", true);
+  FsView::gFsView.mSpaceView["default"]->SetConfigMember
+  ("stat.workflow.latency", slatency, true, "/eos/*/mgm", true);
+}
+
 /*----------------------------------------------------------------------------*/
 int
 /*----------------------------------------------------------------------------*/
@@ -436,15 +587,13 @@ WFE::Job::Save(std::string queue, time_t when, int action, int retry)
 
   // evt. store with the current time
   if (!when) {
-    std::string tst;
-    workflowpath += eos::common::StringConversion::GetSizeString(tst,
-                    (unsigned long long) time(NULL));
-  } else {
-    XrdOucString tst;
-    workflowpath += eos::common::StringConversion::GetSizeString(tst,
-                    (unsigned long long) when);
+    when = time(NULL);
   }
 
+  XrdOucString tst;
+  workflowpath += eos::common::StringConversion::GetSizeString(tst,
+                  (unsigned long long) when);
+
   workflowpath += ":";
   workflowpath += entry;
   workflowpath += ":";
@@ -499,6 +648,8 @@ WFE::Job::Save(std::string queue, time_t when, int action, int retry)
   }
 
   mRetry = retry;
+  // make the job known to the dispatcher
+  gOFS->WFEd.IndexJob(queue, workflowpath, when);
   return SFS_OK;
 }
 
@@ -655,6 +806,7 @@ WFE::Job::Delete(std::string queue)
                   "",
                   false
                   , false, true)) {
+    gOFS->WFEd.UnindexJob(workflowpath);
     return SFS_OK;
   } else {
     eos_static_err("msg=\"failed to delete job\" job=\"%s\"", mDescription.c_str());
@@ -1553,6 +1705,7 @@ WFE::Job::DoIt()
     //Delete(mActions[0].mQueue);
   }
 
+  gOFS->WFEd.JobDone(time(NULL) - mActions[0].mTime);
   gOFS->WFEd.GetSignal()->Signal();
   gOFS->WFEd.DecActiveJobs();
 }
@@ -38,6 +38,7 @@
 #include "XrdCl/XrdClCopyProcess.hh"
 /*----------------------------------------------------------------------------*/
 #include <sys/types.h>
+#include <map>
 
 /*----------------------------------------------------------------------------*/
 
@@ -70,6 +71,45 @@ private:
   /// condition variabl to get signalled for a done job
   XrdSysCondVar mDoneSignal;
 
+  /// condition variable protecting the pending job index, signalled when a
+  /// job is queued
+  XrdSysCondVar mIndexSignal;
+
+  typedef std::multimap<time_t, std::string> JobTimeIndex;
+
+  /// queued jobs by due time => path of the queue entry
+  JobTimeIndex mJobsByTime;
+
+  /// path of the queue entry => position in mJobsByTime
+  std::map<std::string, JobTimeIndex::iterator> mJobsByPath;
+
+  /// scan interval, used as retry delay for the error queue
+  time_t mInterval;
+
+  /// maximum dispatch lag since the last publication
+  time_t mDispatchLag;
+
+  /// sum and count of the job latencies since the last publication
+  unsigned long long mLatencySum;
+  unsigned long long mLatencyCount;
+
+  /**
+   * @brief rebuild the index of the pending jobs from the queues of today
+   * and yesterday in the namespace
+   */
+  void RebuildIndex();
+
+  /**
+   * @brief schedule all jobs which are due
+   * @param ntx maximum number of active jobs, 0 for no limit
+   */
+  void DispatchJobs(size_t ntx);
+
+  /**
+   * @brief publish the queue depth, dispatch lag and job latency
+   */
+  void PublishQueueStats();
+
 public:
 
   /* Default Constructor - use it to run the WFE thread by calling Start
@@ -261,6 +301,36 @@ public:
   // ---------------------------------------------------------------------------
   void PublishActiveJobs();
 
+  // ---------------------------------------------------------------------------
+  //! Add a queue entry to the index of pending jobs
+  //!
+  //! @param queue queue of the entry, only 'q' and 'e' entries are indexed
+  //! @param path path of the queue entry
+  //! @param when time stamp of the entry
+  // ---------------------------------------------------------------------------
+  void IndexJob(const std::string& queue, const std::string& path, time_t when);
+
+  // ---------------------------------------------------------------------------
+  //! Remove a queue entry from the index of pending jobs
+  // ---------------------------------------------------------------------------
+  void UnindexJob(const std::string& path);
+
+  // ---------------------------------------------------------------------------
+  //! Account the latency of a finished job
+  //!
+  //! @param latency seconds between the due time and the end of the job
+  // ---------------------------------------------------------------------------
+  void JobDone(time_t latency);
+
+  // ---------------------------------------------------------------------------
+  //! Return the number of indexed pending jobs
+  // ---------------------------------------------------------------------------
+  size_t GetQueuedJobs()
+  {
+    XrdSysCondVarHelper lLock(mIndexSignal);
+    return mJobsByTime.size();
+  }
+
   // ---------------------------------------------------------------------------
   //! Return active jobs
   // ---------------------------------------------------------------------------
@@ -119,6 +119,7 @@
 #include "mgm/Master.hh"
 #include "mgm/Egroup.hh"
 #include "mgm/Recycle.hh"
+#include "mgm/FindVisitor.hh"
 #include "mgm/Messaging.hh"
 #include "mgm/VstMessaging.hh"
 #include "mgm/ProcInterface.hh"
@@ -139,6 +140,7 @@
 #include <dirent.h>
 /*----------------------------------------------------------------------------*/
 #include "auth_plugin/ProtoUtils.hh"
+#include "auth_plugin/RequestBroker.hh"
 /*----------------------------------------------------------------------------*/
 #include "common/ZMQ.hh"
 /*----------------------------------------------------------------------------*/
@@ -378,6 +380,23 @@ public:
             const char* filematch = 0
            );
 
+  // ---------------------------------------------------------------------------
+  // find files internal function delivering the result to a visitor
+  // ---------------------------------------------------------------------------
+  int _find(const char* path,
+            XrdOucErrInfo& out_error,
+            XrdOucString& stdErr,
+            eos::common::Mapping::VirtualIdentity& vid,
+            FindVisitor& visitor,
+            const char* key = 0,
+            const char* val = 0,
+            bool nofiles = false,
+            time_t millisleep = 0,
+            bool nscounter = true,
+            int maxdepth = 0,
+            const char* filematch = 0
+           );
+
   // ---------------------------------------------------------------------------
   // delete dir
   // ---------------------------------------------------------------------------
@@ -511,6 +530,16 @@ public:
             bool follow = true,
             std::string* uri = 0);
 
+  // ---------------------------------------------------------------------------
+  // stat file or container by id without resolving its path
+  // ---------------------------------------------------------------------------
+  int _stat(uint64_t id,
+            bool container,
+            struct stat* buf,
+            XrdOucErrInfo& out_error,
+            eos::common::Mapping::VirtualIdentity& vid,
+            std::string* etag = 0);
+
 
   // ---------------------------------------------------------------------------
   // stat file to retrieve mode
@@ -36,48 +36,24 @@ XrdMgmOfs::StartAuthMasterThread(void *pp)
 
 //------------------------------------------------------------------------------
 // Authentication master thread function - accepts requests from EOS AUTH
-// plugins which he then forwards to worker threads.
+// plugins which he then forwards to idle worker threads.
 //------------------------------------------------------------------------------
 void
 XrdMgmOfs::AuthMasterThread ()
 {
-  // Socket facing clients
-  zmq::socket_t frontend(*mZmqContext, ZMQ_ROUTER);
+  // Broker dispatching the requests to the idle worker threads
+  eos::auth::RequestBroker broker(mZmqContext);
   std::ostringstream sstr;
   sstr << "tcp://*:" << mFrontendPort;
 
-  try
+  if (!broker.Bind(sstr.str(), "inproc://authbackend"))
   {
-    frontend.bind(sstr.str().c_str());
-  }
-  catch (zmq::error_t& err)
-  {
-    eos_static_err("failed to bind frontend socket");
-    return;
-  }
-
-  // Socket facing worker threads
-  zmq::socket_t backend(*mZmqContext, ZMQ_DEALER);
-
-  try
-  {
-    backend.bind("inproc://authbackend");
-  }
-  catch (zmq::error_t& err)
-  {
-    eos_static_err("failed to bind backend socket");
+    eos_static_err("failed to bind the auth broker sockets");
     return;
   }
 
-  // Start the proxy
-#if ZMQ_VERSION_MAJOR == 2
-  zmq_device(ZMQ_QUEUE, &frontend, &backend);
-#else
-  zmq::proxy(static_cast<void*>(frontend),static_cast<void*>(backend),
-             static_cast<void*>(0));
-#endif
-
   eos_static_info("successfully started auth master thread");
+  broker.Run();
 }
 
 
@@ -103,32 +79,11 @@ XrdMgmOfs::AuthWorkerThread()
   using namespace eos::auth;
   int ret;
   eos_static_info("authentication worker thread starting");
-  zmq::socket_t responder(*mZmqContext, ZMQ_REP);
+  zmq::socket_t responder(*mZmqContext, ZMQ_DEALER);
 
-  // Try to connect to proxy thread - the bind can take a longer time so threfore
+  // Try to connect to the broker - the bind can take a longer time so threfore
   // keep trying until it is successful
-  bool connected = false;
-  uint8_t tries = 0;
-
-  while (tries <= 5)
-  {
-    try
-    {
-      responder.connect("inproc://authbackend");
-    }
-    catch (zmq::error_t& err)
-    {
-      eos_static_debug("auth worker connection failed - retry");
-      tries++;
-      sleep(1);
-      continue;
-    }
-
-    connected = true;
-    break;
-  }
-
-  if (!connected)
+  if (!RequestBroker::ConnectWorker(responder, "inproc://authbackend"))
   {
     eos_static_info("kill thread as we could not connect to backend socket");
     return;
@@ -138,14 +93,15 @@ XrdMgmOfs::AuthWorkerThread()
   while (1)
   {
     zmq::message_t request;
+    std::vector<std::string> envelope;
 
     // Wait for next request
-    responder.recv(&request);
+    if (!RequestBroker::RecvRequest(responder, envelope, request))
+      continue;
 
     // Read in the ProtocolBuffer object just received
-    std::string msg_recv((char*)request.data(), request.size());
     RequestProto req_proto;
-    req_proto.ParseFromString(msg_recv);
+    req_proto.ParseFromArray(request.data(), request.size());
 
     ResponseProto resp;
     std::shared_ptr<XrdOucErrInfo> error(static_cast<XrdOucErrInfo*>(0));
@@ -571,8 +527,11 @@ XrdMgmOfs::AuthWorkerThread()
     }
     else
     {
+      // Reply anyway, the broker only reuses a worker once it replied
       eos_debug("no such operation supported");
-      continue;
+      error.reset(new XrdOucErrInfo("admin"));
+      error.get()->setErrInfo(EOPNOTSUPP, "operation not supported");
+      ret = SFS_ERROR;
     }
 
     // Add error object only if it exists
@@ -589,7 +548,7 @@ XrdMgmOfs::AuthWorkerThread()
     google::protobuf::io::ArrayOutputStream aos(reply.data(), reply_size);
 
     resp.SerializeToZeroCopyStream(&aos);
-    responder.send(reply, ZMQ_NOBLOCK);
+    RequestBroker::SendReply(responder, envelope, reply);
 
     // Free memory
     if (client)
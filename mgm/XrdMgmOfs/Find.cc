@@ -43,13 +43,44 @@ XrdMgmOfs::_find (const char *path,
 		  const char* filematch
                   )
 /*----------------------------------------------------------------------------*/
+/*
+ * @brief low-level namespace find command returning the result in a map
+ *
+ * @param found result map/set of the find
+ *
+ * See the visitor based _find for the other parameters. The whole result is
+ * kept in memory, large queries should use a FindVisitor instead.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  FindCollector collector(found);
+  return _find(path, out_error, stdErr, vid, collector, key, val, nofiles,
+               millisleep, nscounter, maxdepth, filematch);
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdMgmOfs::_find (const char *path,
+                  XrdOucErrInfo &out_error,
+                  XrdOucString &stdErr,
+                  eos::common::Mapping::VirtualIdentity &vid,
+                  FindVisitor &visitor,
+                  const char* key,
+                  const char* val,
+                  bool nofiles,
+                  time_t millisleep,
+                  bool nscounter,
+                  int maxdepth,
+                  const char* filematch
+                  )
+/*----------------------------------------------------------------------------*/
 /*
  * @brief low-level namespace find command
  *
  * @param path path to start the sub-tree find
  * @param stdErr stderr output string
  * @param vid virtual identity of the client
- * @param found result map/set of the find
+ * @param visitor receives the directories and files found
  * @param key search for a certain key in the extended attributes
  * @param val search for a certain value in the extended attributes (requires key)
  * @param nofiles if true returns only directories, otherwise files and directories
@@ -73,17 +104,31 @@ XrdMgmOfs::_find (const char *path,
  * The millisleep variable allows to slow down full scans to decrease impact
  * when doing large scans.
  *
+ * The walk starts in the calling thread. Once more than
+ * EOS_MGM_FIND_PARALLEL_DIRS directories (default 64) are waiting to be
+ * listed, helper threads are added to walk independent subtrees in parallel.
+ * The helpers are taken from a budget of EOS_MGM_FIND_THREADS - 1 threads
+ * (default 3) shared by all concurrent finds, so small finds stay
+ * single-threaded and many parallel finds cannot multiply the thread count.
+ * Each directory is listed by id under a short read lock of the namespace and
+ * the entries found are handed to the visitor directory by directory after the
+ * lock has been released, so nothing is accumulated by the walk itself.
+ * Every thread uses its own error object, the first error is copied back to
+ * out_error.
  */
 /*----------------------------------------------------------------------------*/
 {
-  std::vector< std::vector<std::string> > found_dirs;
+  //! Directory queued for listing
+  struct FindDir
+  {
+    eos::IContainerMD::id_t id;
+    std::string path;
+    int depth;
+  };
 
-  // try if that is directory
-  std::shared_ptr<eos::IContainerMD> cmd;
   std::string Path = path;
   XrdOucString sPath = path;
   errno = 0;
-  XrdSysTimer snooze;
 
   EXEC_TIMING_BEGIN("Find");
 
@@ -95,11 +140,6 @@ XrdMgmOfs::_find (const char *path,
   if (!(sPath.endswith('/')))
     Path += "/";
 
-  found_dirs.resize(1);
-  found_dirs[0].resize(1);
-  found_dirs[0][0] = Path.c_str();
-  int deepness = 0;
-
   // users cannot return more than 100k files and 50k dirs with one find, 
   // unless there is an access rule allowing deeper queries
 
@@ -160,11 +200,14 @@ XrdMgmOfs::_find (const char *path,
   }
 
 
-  unsigned long long filesfound = 0;
-  unsigned long long dirsfound = 0;
+  static int findhelpers = (getenv("EOS_MGM_FIND_THREADS") ?
+                            atoi(getenv("EOS_MGM_FIND_THREADS")) : 4) - 1;
+  static size_t findparalleldirs = getenv("EOS_MGM_FIND_PARALLEL_DIRS") ?
+    strtoul(getenv("EOS_MGM_FIND_PARALLEL_DIRS"), 0, 10) : 64;
+  // helper threads currently running in all finds
+  static std::atomic<int> findhelpersused(0);
 
   bool limitresult = false;
-  bool limited = false;
 
   if ((vid.uid != 0) && (!eos::common::Mapping::HasUid(3, vid.uid_list)) &&
       (!eos::common::Mapping::HasGid(4, vid.gid_list)) && (!vid.sudoer))
@@ -172,60 +215,133 @@ XrdMgmOfs::_find (const char *path,
     limitresult = true;
   }
 
-  do
+  // ---------------------------------------------------------------------------
+  // resolve the start of the walk
+  // ---------------------------------------------------------------------------
+  eos::IContainerMD::id_t rootid = 0;
+  {
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    try
+    {
+      rootid = gOFS->eosView->getContainer(Path.c_str(), false)->getId();
+    }
+    catch (eos::MDException &e)
+    {
+      errno = e.getErrno();
+      eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                e.getErrno(), e.getMessage().str().c_str());
+    }
+  }
+
+  if (!rootid)
   {
-    bool permok = false;
+    // maybe this was a find by file
+    XrdSfsFileExistence file_exists;
+    std::string fpath = path;
+
+    while (fpath.length() > 1 && (*fpath.rbegin() == '/'))
+      fpath.erase(fpath.length() - 1);
 
-    found_dirs.resize(deepness + 2);
-    // loop over all directories in that deepness
-    for (unsigned int i = 0; i < found_dirs[deepness].size(); i++)
+    if ((!nofiles) &&
+        ((_exists(fpath.c_str(), file_exists, out_error, vid, 0)) == SFS_OK) &&
+        (file_exists == XrdSfsFileExistIsFile))
     {
-      Path = found_dirs[deepness][i].c_str();
-      eos_static_debug("Listing files in directory %s", Path.c_str());
+      eos::common::Path cPath(fpath.c_str());
+      visitor.VisitFiles(cPath.GetParentPath(),
+                         std::vector<std::string>(1, cPath.GetName()));
+    }
 
-      if (millisleep)
-      {
-        // slow down the find command without having locks
-        snooze.Wait(millisleep);
-      }
-      // -----------------------------------------------------------------------
+    if (nscounter)
+    {
+      EXEC_TIMING_END("Find");
+    }
+    return SFS_OK;
+  }
+
+  // include also the directory which was specified in the query since it can
+  // evt. be missing if it is empty
+  XrdSfsFileExistence dir_exists;
+  if (((_exists(Path.c_str(), dir_exists, out_error, vid, 0)) == SFS_OK)
+      && (dir_exists == XrdSfsFileExistIsDirectory))
+  {
+    visitor.VisitDir(Path);
+  }
+
+  // ---------------------------------------------------------------------------
+  // shared state of the walk
+  // ---------------------------------------------------------------------------
+  std::mutex walkMutex; // protects the queue, the counters and errors
+  std::condition_variable walkCond;
+  std::deque<FindDir> walkQueue;
+  size_t walkBusy = 0;
+  bool walkStop = false;
+  bool dirsLimited = false;
+  bool filesLimited = false;
+  std::string walkErr;
+  bool walkErrInfo = false; // out_error holds the first error of a thread
+  std::mutex visitMutex; // serializes the visitor
+  std::atomic<unsigned long long> dirsfound(0);
+  std::atomic<unsigned long long> filesfound(0);
+
+  FindDir rootdir;
+  rootdir.id = rootid;
+  rootdir.path = Path;
+  rootdir.depth = 0;
+  walkQueue.push_back(rootdir);
+
+  // ---------------------------------------------------------------------------
+  // list one directory, returns the subdirectories to walk
+  // ---------------------------------------------------------------------------
+  auto listDir = [&](const FindDir & dir, std::vector<FindDir>& subdirs,
+                     XrdOucErrInfo & error)
+  {
+    std::vector<std::string> dnames;
+    std::vector<std::string> fnames;
+    std::string err;
+    bool walksub = ((!maxdepth) || (dir.depth + 1 < maxdepth));
+    bool limited = false;
+
+    {
       eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+      std::shared_ptr<eos::IContainerMD> cmd;
+      bool permok = false;
+
       try
       {
-        cmd = gOFS->eosView->getContainer(Path.c_str(), false);
+        cmd = gOFS->eosDirectoryService->getContainerMD(dir.id);
         permok = cmd->access(vid.uid, vid.gid, R_OK | X_OK);
       }
       catch (eos::MDException &e)
       {
-        errno = e.getErrno();
         cmd.reset();
         eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
                   e.getErrno(), e.getMessage().str().c_str());
       }
 
-      if (cmd)
-      {
-	if (!permok)
-	{
-	  // check-out for ACLs
-	  permok = _access(Path.c_str(), R_OK|X_OK, out_error, vid, "")?false:true;
-	}
-        if (!permok)
-        {
-          stdErr += "error: no permissions to read directory ";
-          stdErr += Path.c_str();
-          stdErr += "\n";
-          continue;
-        }
+      if (!cmd)
+        return;
 
-        // Add all children into the 2D vectors
-	std::set<std::string> dnames = cmd->getNameContainers();
+      if (!permok)
+      {
+        // check-out for ACLs
+        permok = _access(dir.path.c_str(), R_OK|X_OK, error, vid, "")?false:true;
+      }
 
-        for (auto dit = dnames.begin(); dit != dnames.end(); ++dit)
+      if (!permok)
+      {
+        err = "error: no permissions to read directory ";
+        err += dir.path;
+        err += "\n";
+      }
+      else
+      {
+        cmd->visitContainers([&](const std::string & name, uint64_t id) -> bool
         {
-          std::string fpath = Path.c_str();
-          fpath += *dit;
+          std::string fpath = dir.path;
+          fpath += name;
           fpath += "/";
+          bool walk = true;
+
           // check if we select by tag
           if (key)
           {
@@ -235,38 +351,39 @@ XrdMgmOfs::_find (const char *path,
               // this is a search for 'beginswith' match
               eos::IContainerMD::XAttrMap attrmap;
               if (!gOFS->_attr_ls(fpath.c_str(),
-                                  out_error,
+                                  error,
                                   vid,
                                   (const char*) 0,
                                   attrmap,
-				  false))
+                                  false))
               {
                 for (auto it = attrmap.begin(); it != attrmap.end(); it++)
                 {
                   XrdOucString akey = it->first.c_str();
                   if (akey.matches(wkey.c_str()))
                   {
-                    found[fpath].size();
+                    dnames.push_back(fpath);
+                    break;
                   }
                 }
               }
-              found_dirs[deepness + 1].push_back(fpath.c_str());
             }
             else
             {
               // this is a search for a full match or a key search
-
-              std::string sval = val;
               XrdOucString attr = "";
-              if (!gOFS->_attr_get(fpath.c_str(), out_error, vid,
+              if (!gOFS->_attr_get(fpath.c_str(), error, vid,
                                    (const char*) 0, key, attr, true))
               {
-                found_dirs[deepness + 1].push_back(fpath.c_str());
                 if ((val == std::string("*")) || (attr == val))
                 {
-                  found[fpath].size();
+                  dnames.push_back(fpath);
                 }
               }
+              else
+              {
+                walk = false;
+              }
             }
           }
           else
@@ -274,115 +391,220 @@ XrdMgmOfs::_find (const char *path,
             if (limitresult)
             {
               // apply the user limits for non root/admin/sudoers
-              if (dirsfound >= finddiruserlimit)
+              if (dirsfound++ >= finddiruserlimit)
               {
-                stdErr += "warning: find results are limited for you to ndirs=";
-                stdErr += (int) finddiruserlimit;
-                stdErr += " -  result is truncated!\n";
                 limited = true;
-                break;
+                std::lock_guard<std::mutex> wlock(walkMutex);
+                dirsLimited = true;
+                return false;
               }
             }
-            found_dirs[deepness + 1].push_back(fpath.c_str());
-            found[fpath].size();
-            dirsfound++;
+            dnames.push_back(fpath);
           }
-        }
-
-        if (!nofiles)
-        {
-	  std::shared_ptr<eos::IFileMD> fmd;
-	  std::string link;
-	  std::set<std::string> fnames = cmd->getNameFiles();
 
-          for (auto fit = fnames.begin(); fit != fnames.end(); ++fit)
+          if (walk && walksub)
           {
-	    fmd = cmd->findFile(*fit);
+            FindDir sub;
+            sub.id = id;
+            sub.path = fpath;
+            sub.depth = dir.depth + 1;
+            subdirs.push_back(sub);
+          }
+          return true;
+        });
 
-	    // skip symbolic links
-	    if (fmd->isLink())
-	      link = fmd->getLink();
-	    else
-	      link.clear();
+        if ((!nofiles) && (!limited))
+        {
+          cmd->visitFiles([&](const std::string & name, uint64_t id) -> bool
+          {
+            if (filematch)
+            {
+              XrdOucString xname = name.c_str();
+              if (!xname.matches(filematch))
+                return true;
+            }
 
             if (limitresult)
             {
               // apply the user limits for non root/admin/sudoers
-              if (filesfound >= findfileuserlimit)
+              if (filesfound++ >= findfileuserlimit)
               {
-                stdErr += "warning: find results are limited for you to nfiles=";
-                stdErr += (int) findfileuserlimit;
-                stdErr += " -  result is truncated!\n";
                 limited = true;
-                break;
+                std::lock_guard<std::mutex> wlock(walkMutex);
+                filesLimited = true;
+                return false;
               }
             }
-	    if (!filematch)
-	    {
-	      if (link.length()) 
-	      {
-		std::string ip = *fit;
-		ip += " -> ";
-		ip += link;
-		found[Path].insert(ip);
-	      } 
-	      else 
-	      {
-		found[Path].insert(*fit);
-	      }
-	      filesfound++;
-	    }
-	    else
-	    {
-	      XrdOucString name = fit->c_str();
-	      if (name.matches(filematch))
-	      {
-		found[Path].insert(*fit);
-		filesfound++;
-	      }
-	    }
-          }
+
+            if (!filematch)
+            {
+              std::shared_ptr<eos::IFileMD> fmd;
+              try
+              {
+                fmd = gOFS->eosFileService->getFileMD(id);
+              }
+              catch (eos::MDException &e)
+              {
+              }
+
+              // show the target of symbolic links
+              if (fmd && fmd->isLink())
+              {
+                std::string ip = name;
+                ip += " -> ";
+                ip += fmd->getLink();
+                fnames.push_back(ip);
+                return true;
+              }
+            }
+
+            fnames.push_back(name);
+            return true;
+          });
         }
       }
-      if (limited)
+    }
+    // -------------------------------------------------------------------------
+    std::sort(dnames.begin(), dnames.end());
+    std::sort(fnames.begin(), fnames.end());
+    bool stopped = false;
+    {
+      std::lock_guard<std::mutex> vlock(visitMutex);
+
+      for (auto it = dnames.begin(); it != dnames.end(); ++it)
       {
-        break;
+        visitor.VisitDir(*it);
       }
+
+      if (fnames.size())
+      {
+        visitor.VisitFiles(dir.path, fnames);
+      }
+
+      stopped = visitor.Stopped();
     }
 
-    deepness++;
-    if (limited)
+    if (err.length() || limited || stopped)
     {
-      break;
+      std::lock_guard<std::mutex> wlock(walkMutex);
+      walkErr += err;
+
+      if (limited || stopped)
+      {
+        walkStop = true;
+      }
     }
-  }
-  while (found_dirs[deepness].size() && ( (!maxdepth) || (deepness < maxdepth)));
+  };
+
+  std::function<void()> addHelper;
+
+  // ---------------------------------------------------------------------------
+  // worker taking directories from the queue until the walk is done,
+  // the calling thread adds helpers when the queue grows
   // ---------------------------------------------------------------------------
-  if (!nofiles)
+  auto worker = [&](bool caller)
   {
-    // if the result is empty, maybe this was a find by file
-    if (!found.size())
+    XrdSysTimer snooze;
+    std::vector<FindDir> subdirs;
+    XrdOucErrInfo error;
+
+    while (1)
     {
-      XrdSfsFileExistence file_exists;
-      if (((_exists(Path.c_str(), file_exists, out_error, vid, 0)) == SFS_OK) &&
-          (file_exists == XrdSfsFileExistIsFile))
+      FindDir dir;
+      {
+        std::unique_lock<std::mutex> wlock(walkMutex);
+        walkCond.wait(wlock, [&]() -> bool
+        {
+          return walkStop || walkQueue.size() || !walkBusy;
+        });
+
+        if (walkStop || walkQueue.empty())
+        {
+          // nothing left to do or the result got truncated
+          walkCond.notify_all();
+          return;
+        }
+
+        dir = walkQueue.front();
+        walkQueue.pop_front();
+        walkBusy++;
+      }
+
+      if (millisleep)
+      {
+        // slow down the find command without having locks
+        snooze.Wait(millisleep);
+      }
+
+      eos_static_debug("Listing files in directory %s", dir.path.c_str());
+      subdirs.clear();
+      listDir(dir, subdirs, error);
+      size_t queued = 0;
       {
-        eos::common::Path cPath(Path.c_str());
-        found[cPath.GetParentPath()].insert(cPath.GetName());
+        std::lock_guard<std::mutex> wlock(walkMutex);
+        walkBusy--;
+        walkQueue.insert(walkQueue.end(), subdirs.begin(), subdirs.end());
+        queued = walkQueue.size();
+
+        if (error.getErrInfo() && !walkErrInfo)
+        {
+          out_error.setErrInfo(error.getErrInfo(), error.getErrText());
+          walkErrInfo = true;
+        }
+      }
+      walkCond.notify_all();
+
+      if (caller && (queued > findparalleldirs))
+      {
+        addHelper();
       }
     }
-  }
+  };
+
+  std::vector<std::thread> helpers;
+
   // ---------------------------------------------------------------------------
-  // include also the directory which was specified in the query if it is
-  // accessible and a directory since it can evt. be missing if it is empty
+  // start a helper thread if the shared budget allows it
   // ---------------------------------------------------------------------------
-  XrdSfsFileExistence dir_exists;
-  if (((_exists(found_dirs[0][0].c_str(), dir_exists, out_error, vid, 0)) == SFS_OK)
-      && (dir_exists == XrdSfsFileExistIsDirectory))
+  addHelper = [&]()
+  {
+    if ((int) helpers.size() >= findhelpers)
+      return;
+
+    int used = findhelpersused.load();
+
+    do
+    {
+      if (used >= findhelpers)
+        return;
+    }
+    while (!findhelpersused.compare_exchange_weak(used, used + 1));
+
+    helpers.push_back(std::thread(worker, false));
+  };
+
+  worker(true);
+
+  for (auto it = helpers.begin(); it != helpers.end(); ++it)
   {
+    it->join();
+    findhelpersused--;
+  }
+
+  stdErr += walkErr.c_str();
 
-    eos::common::Path cPath(found_dirs[0][0].c_str());
-    found[found_dirs[0][0].c_str()].size();
+  if (dirsLimited)
+  {
+    stdErr += "warning: find results are limited for you to ndirs=";
+    stdErr += (int) finddiruserlimit;
+    stdErr += " -  result is truncated!\n";
+  }
+
+  if (filesLimited)
+  {
+    stdErr += "warning: find results are limited for you to nfiles=";
+    stdErr += (int) findfileuserlimit;
+    stdErr += " -  result is truncated!\n";
   }
 
   if (nscounter)
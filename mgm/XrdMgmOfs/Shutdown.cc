@@ -56,6 +56,13 @@ xrdmgmofs_shutdown (int sig)
 
   gOFS->Shutdown = true;
 
+  // ---------------------------------------------------------------------------
+  eos_static_warning("Shutdown:: flush pending config autosave ... ");
+  if (gOFS->ConfEngine)
+  {
+    gOFS->ConfEngine->FlushAutoSave();
+  }
+
   // ---------------------------------------------------------------------------
   // handler to shutdown the daemon for valgrinding and clean server stop
   // (e.g. let's time to finish write operations)
@@ -104,6 +104,182 @@ XrdMgmOfs::stat(const char* inpath,
   return rc;
 }
 
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief fill stat information from file meta data
+ *
+ * @param fmd file meta data
+ * @param buf stat buffer where to store the stat information
+ * @param etag if given the ETag of the file is stored there
+ */
+/*----------------------------------------------------------------------------*/
+static void
+FileMdToStat(eos::IFileMD* fmd, struct stat* buf, std::string* etag)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_dev = 0xcaff;
+  buf->st_ino = eos::common::FileId::FidToInode(fmd->getId());
+
+  if (fmd->isLink()) {
+    buf->st_mode = S_IFLNK;
+  } else {
+    buf->st_mode = S_IFREG;
+  }
+
+  uint16_t flags = fmd->getFlags();
+
+  if (fmd->isLink()) {
+    buf->st_mode |= (S_IRWXU | S_IRWXG | S_IRWXO);
+    buf->st_nlink = 1;
+  } else {
+    if (!flags) {
+      buf->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR);
+    } else {
+      buf->st_mode |= flags;
+    }
+
+    buf->st_nlink = fmd->getNumLocation();
+  }
+
+  buf->st_uid = fmd->getCUid();
+  buf->st_gid = fmd->getCGid();
+  buf->st_rdev = 0; /* device type (if inode device) */
+  buf->st_size = fmd->getSize();
+  buf->st_blksize = 512;
+  buf->st_blocks = Quota::MapSizeCB(fmd) / 512; // including layout factor
+  eos::IFileMD::ctime_t atime;
+  // adding also nanosecond to stat struct
+  fmd->getCTime(atime);
+#ifdef __APPLE__
+  buf->st_ctimespec.tv_sec = atime.tv_sec;
+  buf->st_ctimespec.tv_nsec = atime.tv_nsec;
+#else
+  buf->st_ctime = atime.tv_sec;
+  buf->st_ctim.tv_sec = atime.tv_sec;
+  buf->st_ctim.tv_nsec = atime.tv_nsec;
+#endif
+  fmd->getMTime(atime);
+#ifdef __APPLE__
+  buf->st_mtimespec.tv_sec = atime.tv_sec;
+  buf->st_mtimespec.tv_nsec = atime.tv_nsec;
+  buf->st_atimespec.tv_sec = atime.tv_sec;
+  buf->st_atimespec.tv_nsec = atime.tv_nsec;
+#else
+  buf->st_mtime = atime.tv_sec;
+  buf->st_mtim.tv_sec = atime.tv_sec;
+  buf->st_mtim.tv_nsec = atime.tv_nsec;
+  buf->st_atime = atime.tv_sec;
+  buf->st_atim.tv_sec = atime.tv_sec;
+  buf->st_atim.tv_nsec = atime.tv_nsec;
+#endif
+
+  if (etag) {
+    // if there is a checksum we use the checksum, otherwise we return inode+mtime
+    size_t cxlen = eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId());
+
+    if (cxlen) {
+      // use inode + checksum
+      char setag[256];
+      snprintf(setag, sizeof(setag) - 1, "\"%llu:", (unsigned long long) buf->st_ino);
+
+      // if MD5 checksums are used we omit the inode number in the ETag (S3 wants that)
+      if (eos::common::LayoutId::GetChecksum(fmd->getLayoutId()) !=
+          eos::common::LayoutId::kMD5) {
+        *etag = setag;
+      } else {
+        *etag = "";
+      }
+
+      for (unsigned int i = 0; i < cxlen; i++) {
+        char hb[3];
+        sprintf(hb, "%02x", (i < cxlen) ? (unsigned char)(
+                  fmd->getChecksum().getDataPadded(i)) : 0);
+        *etag += hb;
+      }
+
+      *etag += "\"";
+    } else {
+      // use inode + mtime
+      char setag[256];
+      snprintf(setag, sizeof(setag) - 1, "\"%llu:%llu\"",
+               (unsigned long long) buf->st_ino,
+               (unsigned long long) buf->st_mtime);
+      *etag = setag;
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief fill stat information from container meta data
+ *
+ * @param cmd container meta data
+ * @param buf stat buffer where to store the stat information
+ * @param etag if given the ETag of the container is stored there
+ */
+/*----------------------------------------------------------------------------*/
+static void
+ContainerMdToStat(eos::IContainerMD* cmd, struct stat* buf, std::string* etag)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_dev = 0xcaff;
+  buf->st_ino = cmd->getId();
+  buf->st_mode = cmd->getMode();
+
+  if (cmd->attributesBegin() != cmd->attributesEnd()) {
+    buf->st_mode |= S_ISVTX;
+  }
+
+  buf->st_nlink = 1;
+  buf->st_uid = cmd->getCUid();
+  buf->st_gid = cmd->getCGid();
+  buf->st_rdev = 0; /* device type (if inode device) */
+  buf->st_size = cmd->getTreeSize();
+  buf->st_blksize = cmd->getNumContainers() + cmd->getNumFiles();
+  buf->st_blocks = 0;
+  eos::IContainerMD::ctime_t ctime;
+  eos::IContainerMD::ctime_t mtime;
+  eos::IContainerMD::ctime_t tmtime;
+  cmd->getCTime(ctime);
+  cmd->getMTime(mtime);
+
+  if (gOFS->eosSyncTimeAccounting) {
+    cmd->getTMTime(tmtime);
+  } else
+    // if there is no sync time accounting we just use the normal modification time
+  {
+    tmtime = mtime;
+  }
+
+#ifdef __APPLE__
+  buf->st_atimespec.tv_sec = tmtime.tv_sec;
+  buf->st_mtimespec.tv_sec = mtime.tv_sec;
+  buf->st_ctimespec.tv_sec = ctime.tv_sec;
+  buf->st_atimespec.tv_nsec = tmtime.tv_nsec;
+  buf->st_mtimespec.tv_nsec = mtime.tv_nsec;
+  buf->st_ctimespec.tv_nsec = ctime.tv_nsec;
+#else
+  buf->st_atime = tmtime.tv_sec;
+  buf->st_mtime = mtime.tv_sec;
+  buf->st_ctime = ctime.tv_sec;
+  buf->st_atim.tv_sec = tmtime.tv_sec;
+  buf->st_mtim.tv_sec = mtime.tv_sec;
+  buf->st_ctim.tv_sec = ctime.tv_sec;
+  buf->st_atim.tv_nsec = tmtime.tv_nsec;
+  buf->st_mtim.tv_nsec = mtime.tv_nsec;
+  buf->st_ctim.tv_nsec = ctime.tv_nsec;
+#endif
+
+  if (etag) {
+    // use inode + mtime
+    char setag[256];
+    snprintf(setag, sizeof(setag) - 1, "\"%llx:%llu.%03lu\"",
+             (unsigned long long) cmd->getId(), (unsigned long long) buf->st_atime,
+             (unsigned long) buf->st_atim.tv_nsec / 1000000);
+    *etag = setag;
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 int
 XrdMgmOfs::_stat(const char* path,
@@ -167,98 +343,7 @@ XrdMgmOfs::_stat(const char* path,
   }
 
   if (fmd) {
-    memset(buf, 0, sizeof(struct stat));
-    buf->st_dev = 0xcaff;
-    buf->st_ino = eos::common::FileId::FidToInode(fmd->getId());
-
-    if (fmd->isLink()) {
-      buf->st_mode = S_IFLNK;
-    } else {
-      buf->st_mode = S_IFREG;
-    }
-
-    uint16_t flags = fmd->getFlags();
-
-    if (fmd->isLink()) {
-      buf->st_mode |= (S_IRWXU | S_IRWXG | S_IRWXO);
-      buf->st_nlink = 1;
-    } else {
-      if (!flags) {
-        buf->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR);
-      } else {
-        buf->st_mode |= flags;
-      }
-
-      buf->st_nlink = fmd->getNumLocation();
-    }
-
-    buf->st_uid = fmd->getCUid();
-    buf->st_gid = fmd->getCGid();
-    buf->st_rdev = 0; /* device type (if inode device) */
-    buf->st_size = fmd->getSize();
-    buf->st_blksize = 512;
-    buf->st_blocks = Quota::MapSizeCB(fmd.get()) / 512; // including layout factor
-    eos::IFileMD::ctime_t atime;
-    // adding also nanosecond to stat struct
-    fmd->getCTime(atime);
-#ifdef __APPLE__
-    buf->st_ctimespec.tv_sec = atime.tv_sec;
-    buf->st_ctimespec.tv_nsec = atime.tv_nsec;
-#else
-    buf->st_ctime = atime.tv_sec;
-    buf->st_ctim.tv_sec = atime.tv_sec;
-    buf->st_ctim.tv_nsec = atime.tv_nsec;
-#endif
-    fmd->getMTime(atime);
-#ifdef __APPLE__
-    buf->st_mtimespec.tv_sec = atime.tv_sec;
-    buf->st_mtimespec.tv_nsec = atime.tv_nsec;
-    buf->st_atimespec.tv_sec = atime.tv_sec;
-    buf->st_atimespec.tv_nsec = atime.tv_nsec;
-#else
-    buf->st_mtime = atime.tv_sec;
-    buf->st_mtim.tv_sec = atime.tv_sec;
-    buf->st_mtim.tv_nsec = atime.tv_nsec;
-    buf->st_atime = atime.tv_sec;
-    buf->st_atim.tv_sec = atime.tv_sec;
-    buf->st_atim.tv_nsec = atime.tv_nsec;
-#endif
-
-    if (etag) {
-      // if there is a checksum we use the checksum, otherwise we return inode+mtime
-      size_t cxlen = eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId());
-
-      if (cxlen) {
-        // use inode + checksum
-        char setag[256];
-        snprintf(setag, sizeof(setag) - 1, "\"%llu:", (unsigned long long) buf->st_ino);
-
-        // if MD5 checksums are used we omit the inode number in the ETag (S3 wants that)
-        if (eos::common::LayoutId::GetChecksum(fmd->getLayoutId()) !=
-            eos::common::LayoutId::kMD5) {
-          *etag = setag;
-        } else {
-          *etag = "";
-        }
-
-        for (unsigned int i = 0; i < cxlen; i++) {
-          char hb[3];
-          sprintf(hb, "%02x", (i < cxlen) ? (unsigned char)(
-                    fmd->getChecksum().getDataPadded(i)) : 0);
-          *etag += hb;
-        }
-
-        *etag += "\"";
-      } else {
-        // use inode + mtime
-        char setag[256];
-        snprintf(setag, sizeof(setag) - 1, "\"%llu:%llu\"",
-                 (unsigned long long) buf->st_ino,
-                 (unsigned long long) buf->st_mtime);
-        *etag = setag;
-      }
-    }
-
+    FileMdToStat(fmd.get(), buf, etag);
     EXEC_TIMING_END("Stat");
     return SFS_OK;
   }
@@ -275,71 +360,68 @@ XrdMgmOfs::_stat(const char* path,
       *uri = gOFS->eosView->getUri(cmd.get());
     }
 
-    memset(buf, 0, sizeof(struct stat));
-    buf->st_dev = 0xcaff;
-    buf->st_ino = cmd->getId();
-    buf->st_mode = cmd->getMode();
-
-    if (cmd->attributesBegin() != cmd->attributesEnd()) {
-      buf->st_mode |= S_ISVTX;
-    }
-
-    buf->st_nlink = 1;
-    buf->st_uid = cmd->getCUid();
-    buf->st_gid = cmd->getCGid();
-    buf->st_rdev = 0; /* device type (if inode device) */
-    buf->st_size = cmd->getTreeSize();
-    buf->st_blksize = cmd->getNumContainers() + cmd->getNumFiles();
-    buf->st_blocks = 0;
-    eos::IContainerMD::ctime_t ctime;
-    eos::IContainerMD::ctime_t mtime;
-    eos::IContainerMD::ctime_t tmtime;
-    cmd->getCTime(ctime);
-    cmd->getMTime(mtime);
-
-    if (gOFS->eosSyncTimeAccounting) {
-      cmd->getTMTime(tmtime);
-    } else
-      // if there is no sync time accounting we just use the normal modification time
-    {
-      tmtime = mtime;
-    }
+    ContainerMdToStat(cmd.get(), buf, etag);
+    return SFS_OK;
+  } catch (eos::MDException& e) {
+    errno = e.getErrno();
+    eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+              e.getMessage().str().c_str());
+    return Emsg(epname, error, errno, "stat", cPath.GetPath());
+  }
+}
 
-#ifdef __APPLE__
-    buf->st_atimespec.tv_sec = tmtime.tv_sec;
-    buf->st_mtimespec.tv_sec = mtime.tv_sec;
-    buf->st_ctimespec.tv_sec = ctime.tv_sec;
-    buf->st_atimespec.tv_nsec = tmtime.tv_nsec;
-    buf->st_mtimespec.tv_nsec = mtime.tv_nsec;
-    buf->st_ctimespec.tv_nsec = ctime.tv_nsec;
-#else
-    buf->st_atime = tmtime.tv_sec;
-    buf->st_mtime = mtime.tv_sec;
-    buf->st_ctime = ctime.tv_sec;
-    buf->st_atim.tv_sec = tmtime.tv_sec;
-    buf->st_mtim.tv_sec = mtime.tv_sec;
-    buf->st_ctim.tv_sec = ctime.tv_sec;
-    buf->st_atim.tv_nsec = tmtime.tv_nsec;
-    buf->st_mtim.tv_nsec = mtime.tv_nsec;
-    buf->st_ctim.tv_nsec = ctime.tv_nsec;
-#endif
+/*----------------------------------------------------------------------------*/
+int
+XrdMgmOfs::_stat(uint64_t id,
+                 bool container,
+                 struct stat* buf,
+                 XrdOucErrInfo& error,
+                 eos::common::Mapping::VirtualIdentity& vid,
+                 std::string* etag)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief return stat information for a file or container given by id
+ *
+ * @param id file or container id
+ * @param container true if the id is a container id
+ * @param buf stat buffer where to store the stat information
+ * @param error error object
+ * @param vid virtual identity of the client
+ * @param etag if given the ETag is stored there
+ * @return SFS_OK on success otherwise SFS_ERROR
+ *
+ * Used for entries of a directory listing which are already known by id, this
+ * avoids resolving their full path again.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  static const char* epname = "_stat";
+  EXEC_TIMING_BEGIN("Stat");
+  gOFS->MgmStats.Add("Stat", vid.uid, vid.gid, 1);
+  errno = 0;
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
 
-    if (etag) {
-      // use inode + mtime
-      char setag[256];
-      snprintf(setag, sizeof(setag) - 1, "\"%llx:%llu.%03lu\"",
-               (unsigned long long) cmd->getId(), (unsigned long long) buf->st_atime,
-               (unsigned long) buf->st_atim.tv_nsec / 1000000);
-      *etag = setag;
+  try {
+    if (container) {
+      std::shared_ptr<eos::IContainerMD> cmd =
+        gOFS->eosDirectoryService->getContainerMD(id);
+      ContainerMdToStat(cmd.get(), buf, etag);
+    } else {
+      std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(id);
+      FileMdToStat(fmd.get(), buf, etag);
     }
-
-    return SFS_OK;
   } catch (eos::MDException& e) {
     errno = e.getErrno();
     eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
               e.getMessage().str().c_str());
-    return Emsg(epname, error, errno, "stat", cPath.GetPath());
+    char sid[64];
+    snprintf(sid, sizeof(sid), "%s id=%llu", container ? "container" : "file",
+             (unsigned long long) id);
+    return Emsg(epname, error, errno, "stat", sid);
   }
+
+  EXEC_TIMING_END("Stat");
+  return SFS_OK;
 }
 
 //------------------------------------------------------------------------------
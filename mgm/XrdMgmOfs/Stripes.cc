@@ -653,6 +653,8 @@ XrdMgmOfs::_replicatestripe (eos::IFileMD *fmd,
     target_cap.replace("cap.sym", "target.cap.sym");
     source_cap.replace("cap.msg", "source.cap.msg");
     target_cap.replace("cap.msg", "target.cap.msg");
+    source_cap.replace("cap.mac", "source.cap.mac");
+    target_cap.replace("cap.mac", "target.cap.mac");
     source_cap += "&source.url=root://";
     source_cap += source_snapshot.mHostPort.c_str();
     source_cap += "//replicate:";
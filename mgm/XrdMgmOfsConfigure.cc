@@ -1436,6 +1436,20 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     return 1;
   }
 
+  if (getenv("EOS_MGM_CAPABILITY_FORMAT")) {
+    std::string format = getenv("EOS_MGM_CAPABILITY_FORMAT");
+
+    if (format == "hmac") {
+      XrdCapability::SetFormat(XrdCapability::kHmac);
+    } else if (format != "legacy") {
+      eos_warning("unknown capability format %s - using legacy", format.c_str());
+    }
+  }
+
+  Eroute.Say("=====> mgmofs.capability.format: ",
+             (XrdCapability::GetFormat() == XrdCapability::kHmac) ? "hmac" :
+             "legacy");
+
   // ----------------------------------------------------------
   // create global visible configuration parameters
   // we create 3 queues
@@ -1887,6 +1901,13 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   eosViewRWMutex.SetDebugName("eosView");
   eosViewRWMutex.SetTiming(false);
   eosViewRWMutex.SetSampling(true, 0.01);
+  eos::common::Mapping::gMapMutex.SetDebugName("Mapping");
+  // contention profiling is always on, each thread samples 1 lock out of 1000
+  eos::common::RWMutex::SetProfileSampling(0.001);
+  FsView::gFsView.ViewMutex.SetProfiling(true);
+  Quota::pMapMutex.SetProfiling(true);
+  eosViewRWMutex.SetProfiling(true);
+  eos::common::Mapping::gMapMutex.SetProfiling(true);
   std::vector<eos::common::RWMutex*> order;
   order.push_back(&FsView::gFsView.ViewMutex);
   order.push_back(&eosViewRWMutex);
@@ -60,6 +60,7 @@ XrdMgmOfsDirectory::XrdMgmOfsDirectory (char *user, int MonID):
 {
   dirName = "";
   dh.reset();
+  dh_pos = 0;
   d_pnt = &dirent_full.d_entry;
   eos::common::Mapping::Nobody (vid);
   eos::common::LogId ();
@@ -156,8 +157,8 @@ XrdMgmOfsDirectory::_open (const char *dir_path,
  *
  * @return SFS_OK otherwise SFS_ERROR
  *
- * We create during the open the full directory listing which then is retrieved
- * via nextEntry() and cleaned up with close().
+ * The listing is read in chunks straight from the container during open and
+ * nextEntry(), the namespace lock is only held while a chunk is fetched.
  */
 /*----------------------------------------------------------------------------*/
 {
@@ -212,17 +213,19 @@ XrdMgmOfsDirectory::_open (const char *dir_path,
 
     if (permok)
     {
-      // Add all the files and subdirectories
       gOFS->MgmStats.Add("OpenDir-Entry", vid.uid, vid.gid,
                          dh->getNumContainers() + dh->getNumFiles());
-      dh_list = dh->getNameFiles();
-      std::set<std::string> dnames = dh->getNameContainers();
-      dh_list.insert(dnames.begin(), dnames.end());
-      dh_list.insert(".");
+      dh_cursor = eos::IContainerMD::ListCursor();
+      dh_chunk.clear();
+      dh_pos = 0;
+      dh_chunk.push_back(ListEntry{".", dh->getId(), true});
 
       // The root dir has no .. entry
       if (strcmp(dir_path, "/"))
-        dh_list.insert("..");
+        dh_chunk.push_back(ListEntry{"..", dh->getParentId(), true});
+
+      // Add the first chunk of subdirectories and files
+      FillChunk();
     }
   }
   catch (eos::MDException &e)
@@ -249,6 +252,7 @@ XrdMgmOfsDirectory::_open (const char *dir_path,
 
   if (!permok)
   {
+    dh.reset();
     errno = EPERM;
     return Emsg(epname, error, errno,
                 "open directory", cPath.GetPath());
@@ -256,10 +260,6 @@ XrdMgmOfsDirectory::_open (const char *dir_path,
 
   dirName = dir_path;
 
-  // Set up values for this directory object
-  //
-  dh_it = dh_list.begin();
-
   EXEC_TIMING_END("OpenDir");
   return SFS_OK;
 }
@@ -280,15 +280,67 @@ XrdMgmOfsDirectory::nextEntry ()
  */
 /*----------------------------------------------------------------------------*/
 {
-  if (dh_it == dh_list.end())
+  uint64_t id;
+  bool container;
+  return nextEntry(id, container);
+}
+
+/*----------------------------------------------------------------------------*/
+const char *
+XrdMgmOfsDirectory::nextEntry (uint64_t &id, bool &container)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief read the next directory entry with its id and type
+ *
+ * @param id set to the file or container id of the entry
+ * @param container set to true if the entry is a container
+ *
+ * @return name of the next directory entry or 0 at the end of the listing
+ */
+/*----------------------------------------------------------------------------*/
+{
+  if (dh_pos == dh_chunk.size())
   {
-    // no more entry
-    return (const char *) 0;
+    dh_chunk.clear();
+    dh_pos = 0;
+
+    if (!dh || dh_cursor.done)
+    {
+      // no more entry
+      return (const char *) 0;
+    }
+
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    FillChunk();
+
+    if (dh_chunk.empty())
+    {
+      return (const char *) 0;
+    }
   }
 
-  std::set<std::string>::iterator tmp_it = dh_it;
-  dh_it++;
-  return tmp_it->c_str();
+  const ListEntry &entry = dh_chunk[dh_pos++];
+  id = entry.id;
+  container = entry.container;
+  return entry.name.c_str();
+}
+
+/*----------------------------------------------------------------------------*/
+void
+XrdMgmOfsDirectory::FillChunk ()
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief append the next chunk of entries of the container to the listing
+ *
+ * The caller has to hold the namespace read lock.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  dh->listEntries(dh_cursor, sListChunkSize,
+                  [this] (const std::string &name, uint64_t id, bool container)
+  {
+    dh_chunk.push_back(ListEntry{name, id, container});
+  });
 }
 
 /*----------------------------------------------------------------------------*/
@@ -303,7 +355,9 @@ XrdMgmOfsDirectory::close ()
 /*----------------------------------------------------------------------------*/
 {
   //  static const char *epname = "closedir";
-  dh_list.clear();
+  dh_chunk.clear();
+  dh_pos = 0;
+  dh.reset();
 
   return SFS_OK;
 }
@@ -36,6 +36,7 @@
 /*----------------------------------------------------------------------------*/
 #include "common/Logging.hh"
 #include "common/Mapping.hh"
+#include "namespace/interface/IContainerMD.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include "XrdSec/XrdSecEntity.hh"
@@ -43,15 +44,9 @@
 /*----------------------------------------------------------------------------*/
 #include <dirent.h>
 #include <string>
-#include <set>
+#include <vector>
 /*----------------------------------------------------------------------------*/
 
-//! Forward declaration
-namespace eos
-{
-class IContainerMD;
-};
-
 /*----------------------------------------------------------------------------*/
 //! Class implementing directories and operations
 /*----------------------------------------------------------------------------*/
@@ -85,6 +80,12 @@ public:
   // ---------------------------------------------------------------------------
   const char *nextEntry ();
 
+  // ---------------------------------------------------------------------------
+  //! return entry of an open directory together with its id and type, the
+  //! id allows to stat the entry without resolving its path again
+  // ---------------------------------------------------------------------------
+  const char *nextEntry (uint64_t &id, bool &container);
+
   //----------------------------------------------------------------------------
   //! Create an error message
   //!
@@ -132,6 +133,22 @@ public:
 
 private:
 
+  // ---------------------------------------------------------------------------
+  //! fetch the next chunk of entries, the namespace lock has to be held
+  // ---------------------------------------------------------------------------
+  void FillChunk ();
+
+  //! max. number of entries fetched per namespace lock
+  static constexpr size_t sListChunkSize = 10000;
+
+  //! entry of the current listing chunk
+  struct ListEntry
+  {
+    std::string name;
+    uint64_t id;
+    bool container;
+  };
+
   struct
   {
     struct dirent d_entry;
@@ -143,8 +160,9 @@ private:
   eos::common::Mapping::VirtualIdentity vid;
 
   std::shared_ptr<eos::IContainerMD> dh;
-  std::set<std::string> dh_list;
-  std::set<std::string>::const_iterator dh_it;
+  eos::IContainerMD::ListCursor dh_cursor; //< position of the listing
+  std::vector<ListEntry> dh_chunk; //< current chunk of entries
+  size_t dh_pos; //< position in the current chunk
 };
 
 
@@ -225,6 +225,7 @@ XrdMgmOfsFile::open(const char* inpath,
 
   XrdOucString pinfo = info ? info : "";
   eos::common::StringConversion::MaskTag(pinfo, "cap.msg");
+  eos::common::StringConversion::MaskTag(pinfo, "cap.mac");
   eos::common::StringConversion::MaskTag(pinfo, "cap.sym");
   eos::common::StringConversion::MaskTag(pinfo, "authz");
 
@@ -403,6 +404,7 @@ XrdMgmOfsFile::open(const char* inpath,
     } else {
       procCmd = new ProcCommand();
       procCmd->SetLogId(logId, vid, tident);
+      procCmd->EnableStreaming();
       return procCmd->open(path, info, vid, &error);
     }
   }
@@ -560,6 +562,7 @@ XrdMgmOfsFile::open(const char* inpath,
           gOFS->MgmStats.Add("RedirectENOENT", vid.uid, vid.gid, 1);
           XrdOucString predirectionhost = redirectionhost.c_str();
           eos::common::StringConversion::MaskTag(predirectionhost, "cap.msg");
+          eos::common::StringConversion::MaskTag(predirectionhost, "cap.mac");
           eos::common::StringConversion::MaskTag(predirectionhost, "cap.sym");
           eos::common::StringConversion::MaskTag(pinfo, "authz");
           eos_info("info=\"redirecting\" hostport=%s:%d", predirectionhost.c_str(),
@@ -2178,6 +2181,7 @@ XrdMgmOfsFile::open(const char* inpath,
 
   XrdOucString predirectionhost = redirectionhost.c_str();
   eos::common::StringConversion::MaskTag(predirectionhost, "cap.msg");
+  eos::common::StringConversion::MaskTag(predirectionhost, "cap.mac");
   eos::common::StringConversion::MaskTag(predirectionhost, "cap.sym");
 
   if (isRW) {
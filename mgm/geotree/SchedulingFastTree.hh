@@ -1809,6 +1809,20 @@ public:
   {
     pBranchComp.fillRatioCompTol = tol;
   }
+  // direct access to the node data for the users of a working copy of the tree
+  // which are not friends (tests, offline tools), updateTree has to be called after a modification
+  inline FsData& getFsData(const tFastTreeIdx &node)
+  {
+    return pNodes[node].fsData;
+  }
+  inline FileData& getFileData(const tFastTreeIdx &node)
+  {
+    return pNodes[node].fileData;
+  }
+  inline const FsId2NodeIdxMap<FsIdType>* getFs2Idx() const
+  {
+    return pFs2Idx;
+  }
   bool
   selfAllocate(tFastTreeIdx size)
   {
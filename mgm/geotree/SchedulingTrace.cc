@@ -0,0 +1,361 @@
+//------------------------------------------------------------------------------
+// @file SchedulingTrace.cc
+// @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/geotree/SchedulingTrace.hh"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+static const char gTraceMagic[8] = {'E', 'O', 'S', 'G', 'T', 'R', 'C', '\n'};
+static const uint32_t gTraceVersion = 1;
+
+// the writer caps strings and fs id lists at 0xffff entries, a record holds
+// at most three of each and less than 256 bytes of fixed size fields
+static const size_t gMaxString = sizeof(uint16_t) + 0xffff;
+static const size_t gMaxFsIds = sizeof(uint16_t) + 0xffff * sizeof(uint32_t);
+static const uint32_t gMaxRecordSize = 3 * gMaxString + 3 * gMaxFsIds + 256;
+
+/*----------------------------------------------------------------------------*/
+// serialization helpers
+/*----------------------------------------------------------------------------*/
+template<typename T>
+static inline void
+PutRaw(std::string& buf, const T& v)
+{
+  buf.append((const char*) &v, sizeof(T));
+}
+
+static inline void
+PutString(std::string& buf, const std::string& s)
+{
+  uint16_t len = (s.size() > 0xffff) ? 0xffff : (uint16_t) s.size();
+  PutRaw(buf, len);
+  buf.append(s.c_str(), len);
+}
+
+static inline void
+PutFsIds(std::string& buf, const std::vector<uint32_t>& v)
+{
+  uint16_t len = (v.size() > 0xffff) ? 0xffff : (uint16_t) v.size();
+  PutRaw(buf, len);
+
+  if (len) {
+    buf.append((const char*) &v[0], len * sizeof(uint32_t));
+  }
+}
+
+template<typename T>
+static inline bool
+GetRaw(const std::string& buf, size_t& pos, T& v)
+{
+  if (pos + sizeof(T) > buf.size()) {
+    return false;
+  }
+
+  memcpy(&v, buf.c_str() + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+static inline bool
+GetString(const std::string& buf, size_t& pos, std::string& s)
+{
+  uint16_t len = 0;
+
+  if (!GetRaw(buf, pos, len) || (pos + len > buf.size())) {
+    return false;
+  }
+
+  s.assign(buf.c_str() + pos, len);
+  pos += len;
+  return true;
+}
+
+static inline bool
+GetFsIds(const std::string& buf, size_t& pos, std::vector<uint32_t>& v)
+{
+  uint16_t len = 0;
+
+  if (!GetRaw(buf, pos, len) || (pos + len * sizeof(uint32_t) > buf.size())) {
+    return false;
+  }
+
+  v.resize(len);
+
+  if (len) {
+    memcpy(&v[0], buf.c_str() + pos, len * sizeof(uint32_t));
+  }
+
+  pos += len * sizeof(uint32_t);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+uint64_t
+SchedulingTraceWriter::Now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return ((uint64_t) tv.tv_sec) * 1000000ull + tv.tv_usec;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+SchedulingTraceWriter::BuildPath(const std::string& dir,
+                                 const std::string& name, std::string& path)
+{
+  if (dir.empty() || name.empty() || (name == ".") || (name == "..") ||
+      (name.find('/') != std::string::npos)) {
+    return false;
+  }
+
+  path = dir;
+
+  if (path[path.length() - 1] != '/') {
+    path += '/';
+  }
+
+  path += name;
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+SchedulingTraceWriter::Open(const std::string& path)
+{
+  XrdSysMutexHelper lock(mMutex);
+
+  if (mFile) {
+    mEnabled = false;
+    fclose(mFile);
+    mFile = 0;
+  }
+
+  // O_EXCL also refuses to follow a symlink planted at the path
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                S_IRUSR | S_IWUSR);
+
+  if (fd < 0) {
+    return errno;
+  }
+
+  mFile = fdopen(fd, "w");
+
+  if (!mFile) {
+    int retc = errno;
+    close(fd);
+    return retc;
+  }
+
+  if ((fwrite(gTraceMagic, sizeof(gTraceMagic), 1, mFile) != 1) ||
+      (fwrite(&gTraceVersion, sizeof(gTraceVersion), 1, mFile) != 1)) {
+    fclose(mFile);
+    mFile = 0;
+    return EIO;
+  }
+
+  mPath = path;
+  mRecords = 0;
+  mEnabled = true;
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+SchedulingTraceWriter::Close()
+{
+  XrdSysMutexHelper lock(mMutex);
+  mEnabled = false;
+
+  if (mFile) {
+    fclose(mFile);
+    mFile = 0;
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+SchedulingTraceWriter::GetStatus(std::string& path, unsigned long long& records)
+{
+  XrdSysMutexHelper lock(mMutex);
+  path = mFile ? mPath : "";
+  records = mRecords;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+SchedulingTraceWriter::Write(const SchedulingTraceRecord& rec)
+{
+  XrdSysMutexHelper lock(mMutex);
+
+  if (!mFile) {
+    return;
+  }
+
+  mBuffer.clear();
+  PutRaw(mBuffer, rec.timeUs);
+
+  if (rec.type == SchedulingTraceRecord::kFsState) {
+    PutRaw(mBuffer, rec.fsId);
+    PutString(mBuffer, rec.group);
+    PutString(mBuffer, rec.geotag);
+    PutString(mBuffer, rec.host);
+    PutRaw(mBuffer, rec.status);
+    PutRaw(mBuffer, rec.ulScore);
+    PutRaw(mBuffer, rec.dlScore);
+    PutRaw(mBuffer, rec.totalSpace);
+    PutRaw(mBuffer, rec.fillRatio);
+  } else {
+    PutString(mBuffer, rec.group);
+    PutRaw(mBuffer, rec.schedType);
+    PutRaw(mBuffer, rec.nReplicas);
+    PutFsIds(mBuffer, rec.existingReplicas);
+    PutFsIds(mBuffer, rec.excludeFs);
+    PutRaw(mBuffer, rec.bookingSize);
+    PutString(mBuffer, rec.clientGeotag);
+    PutFsIds(mBuffer, rec.result);
+    PutRaw(mBuffer, rec.retCode);
+    PutRaw(mBuffer, rec.latencyUs);
+  }
+
+  uint32_t len = mBuffer.size();
+
+  if ((fwrite(&rec.type, sizeof(rec.type), 1, mFile) != 1) ||
+      (fwrite(&len, sizeof(len), 1, mFile) != 1) ||
+      (fwrite(mBuffer.c_str(), len, 1, mFile) != 1)) {
+    // stop tracing on write errors (e.g. disk full)
+    mEnabled = false;
+    fclose(mFile);
+    mFile = 0;
+    return;
+  }
+
+  mRecords++;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+SchedulingTraceReader::Open(const std::string& path)
+{
+  Close();
+  mFile = fopen(path.c_str(), "r");
+
+  if (!mFile) {
+    return false;
+  }
+
+  char magic[sizeof(gTraceMagic)];
+  uint32_t version = 0;
+
+  if ((fread(magic, sizeof(magic), 1, mFile) != 1) ||
+      memcmp(magic, gTraceMagic, sizeof(magic)) ||
+      (fread(&version, sizeof(version), 1, mFile) != 1) ||
+      (version != gTraceVersion)) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+SchedulingTraceReader::Close()
+{
+  if (mFile) {
+    fclose(mFile);
+    mFile = 0;
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+SchedulingTraceReader::Next(SchedulingTraceRecord& rec)
+{
+  if (!mFile) {
+    return false;
+  }
+
+  uint8_t type = 0;
+  uint32_t len = 0;
+
+  if ((fread(&type, sizeof(type), 1, mFile) != 1) ||
+      (fread(&len, sizeof(len), 1, mFile) != 1)) {
+    return false;
+  }
+
+  // a larger length comes from a truncated or corrupted trace
+  if (len > gMaxRecordSize) {
+    return false;
+  }
+
+  mBuffer.resize(len);
+
+  if (len && (fread(&mBuffer[0], len, 1, mFile) != 1)) {
+    return false;
+  }
+
+  rec.Reset();
+  rec.type = type;
+  size_t pos = 0;
+
+  if (!GetRaw(mBuffer, pos, rec.timeUs)) {
+    return false;
+  }
+
+  if (type == SchedulingTraceRecord::kFsState) {
+    return GetRaw(mBuffer, pos, rec.fsId) &&
+           GetString(mBuffer, pos, rec.group) &&
+           GetString(mBuffer, pos, rec.geotag) &&
+           GetString(mBuffer, pos, rec.host) &&
+           GetRaw(mBuffer, pos, rec.status) &&
+           GetRaw(mBuffer, pos, rec.ulScore) &&
+           GetRaw(mBuffer, pos, rec.dlScore) &&
+           GetRaw(mBuffer, pos, rec.totalSpace) &&
+           GetRaw(mBuffer, pos, rec.fillRatio);
+  }
+
+  if ((type == SchedulingTraceRecord::kPlacement) ||
+      (type == SchedulingTraceRecord::kAccess)) {
+    return GetString(mBuffer, pos, rec.group) &&
+           GetRaw(mBuffer, pos, rec.schedType) &&
+           GetRaw(mBuffer, pos, rec.nReplicas) &&
+           GetFsIds(mBuffer, pos, rec.existingReplicas) &&
+           GetFsIds(mBuffer, pos, rec.excludeFs) &&
+           GetRaw(mBuffer, pos, rec.bookingSize) &&
+           GetString(mBuffer, pos, rec.clientGeotag) &&
+           GetFsIds(mBuffer, pos, rec.result) &&
+           GetRaw(mBuffer, pos, rec.retCode) &&
+           GetRaw(mBuffer, pos, rec.latencyUs);
+  }
+
+  // unknown record types written by a newer version are skipped
+  return true;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,233 @@
+//------------------------------------------------------------------------------
+// @file SchedulingTrace.hh
+// @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_SCHEDULINGTRACE__H__
+#define __EOSMGM_SCHEDULINGTRACE__H__
+
+#include "mgm/Namespace.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @file SchedulingTrace.hh
+ *
+ * @brief Compact binary trace of the inputs and decisions of the GeoTreeEngine
+ *
+ * The trace is a file starting with an 8 bytes magic and a 32 bits version
+ * followed by records. Each record is a 1 byte type, a 32 bits payload length
+ * and the payload. Integers are stored in host byte order, strings are
+ * prefixed by their 16 bits length and vectors of fsids by their 16 bits size.
+ *
+ * Three kinds of records are written:
+ * - fs state : the scheduling state of a filesystem as seen by the tree
+ *   updater (GeoTreeEngine::listenFsChange) or when a fs is inserted
+ * - placement : a placement request and the filesystems chosen
+ * - access : an access request and the head replica chosen
+ *
+ * The MGM only writes traces into EOS_GEOSCHED_TRACE_DIR and never overwrites
+ * an existing file. The trace can be replayed offline on SlowTree/FastTree by
+ * eos-geosched-replay.
+ */
+/*----------------------------------------------------------------------------*/
+
+//! Directory the MGM writes the scheduling traces to
+#define EOS_GEOSCHED_TRACE_DIR "/var/log/eos/mgm/geosched/"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! One record of a scheduling trace
+//------------------------------------------------------------------------------
+struct SchedulingTraceRecord {
+  enum eType {
+    kFsState = 1, kPlacement = 2, kAccess = 3
+  };
+
+  uint8_t type;
+  //! time of the record in microseconds since the epoch
+  uint64_t timeUs;
+
+  //! kFsState
+  uint32_t fsId;
+  std::string group;
+  std::string geotag;
+  std::string host;
+  int16_t status;
+  float ulScore;
+  float dlScore;
+  float totalSpace;
+  float fillRatio;
+
+  //! kPlacement and kAccess
+  uint8_t schedType;
+  uint32_t nReplicas;
+  std::vector<uint32_t> existingReplicas;
+  std::vector<uint32_t> excludeFs;
+  uint64_t bookingSize;
+  //! startFromGeoTag for a placement, accesserGeotag for an access
+  std::string clientGeotag;
+  //! new replicas of a placement or head replica of an access
+  std::vector<uint32_t> result;
+  //! 1/0 for a placement, return code of an access
+  int32_t retCode;
+  //! time spent in the GeoTreeEngine
+  uint32_t latencyUs;
+
+  SchedulingTraceRecord()
+  {
+    Reset();
+  }
+
+  void Reset()
+  {
+    type = 0;
+    timeUs = 0;
+    fsId = 0;
+    group.clear();
+    geotag.clear();
+    host.clear();
+    status = 0;
+    ulScore = dlScore = totalSpace = fillRatio = 0;
+    schedType = 0;
+    nReplicas = 0;
+    existingReplicas.clear();
+    excludeFs.clear();
+    bookingSize = 0;
+    clientGeotag.clear();
+    result.clear();
+    retCode = 0;
+    latencyUs = 0;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Thread-safe writer of a scheduling trace
+//------------------------------------------------------------------------------
+class SchedulingTraceWriter
+{
+public:
+  SchedulingTraceWriter() : mFile(0), mRecords(0), mEnabled(false) {}
+
+  ~SchedulingTraceWriter()
+  {
+    Close();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Build the path of a trace file inside a trace directory
+  //!
+  //! @param dir trace directory ending with a '/'
+  //! @param name plain file name, it may not contain '/' nor be "." or ".."
+  //! @param path the resulting path
+  //!
+  //! @return true if the name is acceptable
+  //----------------------------------------------------------------------------
+  static bool BuildPath(const std::string& dir, const std::string& name,
+                        std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Create a new trace file, an existing file is never overwritten
+  //!
+  //! @return 0 if successful, otherwise the errno of the failure
+  //----------------------------------------------------------------------------
+  int Open(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Flush and close the trace file
+  //----------------------------------------------------------------------------
+  void Close();
+
+  //----------------------------------------------------------------------------
+  //! Cheap check to be done before building a record
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return mEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Serialize and append a record
+  //----------------------------------------------------------------------------
+  void Write(const SchedulingTraceRecord& rec);
+
+  //----------------------------------------------------------------------------
+  //! Get the path and the number of records written so far
+  //----------------------------------------------------------------------------
+  void GetStatus(std::string& path, unsigned long long& records);
+
+  //----------------------------------------------------------------------------
+  //! Current time in microseconds since the epoch
+  //----------------------------------------------------------------------------
+  static uint64_t Now();
+
+private:
+  XrdSysMutex mMutex;
+  FILE* mFile;
+  std::string mPath;
+  unsigned long long mRecords;
+  volatile bool mEnabled;
+  std::string mBuffer;
+};
+
+//------------------------------------------------------------------------------
+//! Sequential reader of a scheduling trace
+//------------------------------------------------------------------------------
+class SchedulingTraceReader
+{
+public:
+  SchedulingTraceReader() : mFile(0) {}
+
+  ~SchedulingTraceReader()
+  {
+    Close();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Open a trace file and check its header
+  //!
+  //! @return true if successful
+  //----------------------------------------------------------------------------
+  bool Open(const std::string& path);
+
+  void Close();
+
+  //----------------------------------------------------------------------------
+  //! Read the next record
+  //!
+  //! @return true if a record was read, false at the end of the trace or if
+  //!         the trace is truncated/corrupted
+  //----------------------------------------------------------------------------
+  bool Next(SchedulingTraceRecord& rec);
+
+private:
+  FILE* mFile;
+  std::string mBuffer;
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
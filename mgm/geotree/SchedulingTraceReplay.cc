@@ -0,0 +1,741 @@
+//------------------------------------------------------------------------------
+// @file SchedulingTraceReplay.cc
+// @author agent <agent@local>
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @file SchedulingTraceReplay.cc
+ *
+ * @brief Offline replay of a GeoTreeEngine scheduling trace
+ *
+ * The fs states found in the trace are loaded into one SlowTree per
+ * scheduling group. The fast structures are rebuilt from it at most once per
+ * time frame, like the GeoTreeEngine updater does. Every placement and access
+ * of the trace is then replayed on a working copy of the fast tree. The tool
+ * reports the replay throughput, the latency percentiles of the replay and of
+ * the original run, and how far the replayed decisions are from the recorded
+ * ones.
+ *
+ * Penalties are modelled by a fixed value per operation which is applied to
+ * the chosen fs until the next time frame.
+ */
+/*----------------------------------------------------------------------------*/
+
+#include "mgm/geotree/SchedulingSlowTree.hh"
+#include "mgm/geotree/SchedulingTrace.hh"
+#include "common/LatencyHistogram.hh"
+#include "common/Logging.hh"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+using namespace eos::mgm;
+
+//------------------------------------------------------------------------------
+//! Replay parameters, they match the GeoTreeEngine parameters of the same name
+//------------------------------------------------------------------------------
+struct ReplayConfig {
+  int fillRatioLimit;
+  int fillRatioCompTol;
+  int saturationThres;
+  int timeFrameDurationMs;
+  int plctDlScorePenalty;
+  int plctUlScorePenalty;
+  int accessDlScorePenalty;
+  int accessUlScorePenalty;
+  bool skipSaturated;
+  std::string decisionsFile;
+
+  ReplayConfig() :
+    fillRatioLimit(80), fillRatioCompTol(100), saturationThres(10),
+    timeFrameDurationMs(1000), plctDlScorePenalty(0), plctUlScorePenalty(0),
+    accessDlScorePenalty(0), accessUlScorePenalty(0), skipSaturated(false)
+  {}
+};
+
+//------------------------------------------------------------------------------
+//! Slow and fast structures of one scheduling group
+//------------------------------------------------------------------------------
+struct ReplayGroup {
+  SlowTree slowTree;
+  FastPlacementTree plctTree;
+  FastROAccessTree roAccessTree;
+  FastRWAccessTree rwAccessTree;
+  FastBalancingPlacementTree blcPlctTree;
+  FastBalancingAccessTree blcAccessTree;
+  FastDrainingPlacementTree drnPlctTree;
+  FastDrainingAccessTree drnAccessTree;
+  SchedTreeBase::FastTreeInfo treeInfo;
+  Fs2TreeIdxMap fs2Idx;
+  GeoTag2NodeIdxMap geo2Node;
+  bool modified;
+  bool built;
+  uint64_t lastBuildUs;
+
+  ReplayGroup() : modified(false), built(false), lastBuildUs(0) {}
+};
+
+//------------------------------------------------------------------------------
+//! Last known description of a filesystem
+//------------------------------------------------------------------------------
+struct ReplayFs {
+  std::string group;
+  SchedTreeBase::TreeNodeInfo info;
+};
+
+//------------------------------------------------------------------------------
+//! Statistics of one kind of operation
+//------------------------------------------------------------------------------
+struct ReplayStats {
+  unsigned long long count;
+  unsigned long long failedRecorded;
+  unsigned long long failedReplayed;
+  unsigned long long sameDecision;
+  double replaySeconds;
+  eos::common::LatencyHistogram replayLatency;
+  eos::common::LatencyHistogram recordedLatency;
+  std::map<uint32_t, unsigned long long> recordedChoices;
+  std::map<uint32_t, unsigned long long> replayedChoices;
+
+  ReplayStats() : count(0), failedRecorded(0), failedReplayed(0),
+    sameDecision(0), replaySeconds(0) {}
+};
+
+static map<string, ReplayGroup*> gGroups;
+static map<uint32_t, ReplayFs> gFs;
+static ReplayConfig gConfig;
+static size_t gBufferSize = sizeof(FastPlacementTree) +
+                            FastPlacementTree::sGetMaxDataMemSize();
+static char* gBuffer = 0;
+
+//------------------------------------------------------------------------------
+//! Monotonic time in seconds
+//------------------------------------------------------------------------------
+static inline double
+Now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+//! Apply an fs state record to the slow tree of its group
+//------------------------------------------------------------------------------
+static void
+ApplyFsState(const SchedulingTraceRecord& rec)
+{
+  SchedTreeBase::TreeNodeStateFloat state;
+  state.mStatus = rec.status;
+  state.ulScore = rec.ulScore;
+  state.dlScore = rec.dlScore;
+  state.totalSpace = rec.totalSpace;
+  state.fillRatio = rec.fillRatio;
+  auto fsit = gFs.find(rec.fsId);
+
+  // the fs moved to another group or another geotag, remove it first
+  if (fsit != gFs.end() && (fsit->second.group != rec.group ||
+                            fsit->second.info.geotag != rec.geotag)) {
+    ReplayGroup* old = gGroups[fsit->second.group];
+    old->slowTree.remove(&fsit->second.info);
+    old->modified = true;
+    gFs.erase(fsit);
+    fsit = gFs.end();
+  }
+
+  ReplayGroup*& group = gGroups[rec.group];
+
+  if (!group) {
+    group = new ReplayGroup;
+    group->slowTree.setName(rec.group);
+  }
+
+  ReplayFs& fs = gFs[rec.fsId];
+  fs.group = rec.group;
+  fs.info.geotag = rec.geotag;
+  fs.info.host = rec.host.empty() ? std::string("nohost") : rec.host;
+  fs.info.fsId = rec.fsId;
+
+  if (!group->slowTree.insert(&fs.info, &state, true, true)) {
+    cerr << "warning: could not insert fs " << rec.fsId << " into group " <<
+         rec.group << endl;
+    gFs.erase(rec.fsId);
+    return;
+  }
+
+  group->modified = true;
+}
+
+//------------------------------------------------------------------------------
+//! Rebuild the fast structures of a group if its state changed and the
+//! current time frame is over
+//------------------------------------------------------------------------------
+static bool
+RefreshGroup(ReplayGroup* group, uint64_t nowUs)
+{
+  if (group->built && (!group->modified ||
+                       (nowUs - group->lastBuildUs) < (uint64_t) gConfig.timeFrameDurationMs * 1000)) {
+    return true;
+  }
+
+  if (!group->slowTree.buildFastStrcturesSched(&group->plctTree,
+      &group->roAccessTree, &group->rwAccessTree, &group->blcPlctTree,
+      &group->blcAccessTree, &group->drnPlctTree, &group->drnAccessTree,
+      &group->treeInfo, &group->fs2Idx, &group->geo2Node)) {
+    cerr << "error: could not build the fast structures" << endl;
+    return false;
+  }
+
+  char sat = gConfig.saturationThres;
+  char cap = gConfig.fillRatioLimit;
+  char tol = gConfig.fillRatioCompTol;
+  group->roAccessTree.setSaturationThreshold(sat);
+  group->rwAccessTree.setSaturationThreshold(sat);
+  group->drnAccessTree.setSaturationThreshold(sat);
+  group->blcAccessTree.setSaturationThreshold(sat);
+  group->plctTree.setSaturationThreshold(sat);
+  group->plctTree.setSpreadingFillRatioCap(cap);
+  group->plctTree.setFillRatioCompTol(tol);
+  group->blcPlctTree.setSaturationThreshold(sat);
+  group->blcPlctTree.setSpreadingFillRatioCap(cap);
+  group->blcPlctTree.setFillRatioCompTol(tol);
+  group->drnPlctTree.setSaturationThreshold(sat);
+  group->drnPlctTree.setSpreadingFillRatioCap(cap);
+  group->drnPlctTree.setFillRatioCompTol(tol);
+  group->roAccessTree.updateTree();
+  group->rwAccessTree.updateTree();
+  group->drnAccessTree.updateTree();
+  group->blcAccessTree.updateTree();
+  group->plctTree.updateTree();
+  group->blcPlctTree.updateTree();
+  group->drnPlctTree.updateTree();
+  group->modified = false;
+  group->built = true;
+  group->lastBuildUs = nowUs;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! Apply a penalty to a fs in all the fast trees of a group
+//------------------------------------------------------------------------------
+template<class T>
+static inline void
+Penalize(T& tree, SchedTreeBase::tFastTreeIdx idx, int dl, int ul)
+{
+  SchedTreeBase::TreeNodeStateChar& fsData = tree.getFsData(idx);
+  fsData.dlScore = (fsData.dlScore > dl) ? fsData.dlScore - dl : 0;
+  fsData.ulScore = (fsData.ulScore > ul) ? fsData.ulScore - ul : 0;
+}
+
+static void
+ApplyPenalty(ReplayGroup* group, SchedTreeBase::tFastTreeIdx idx, int dl,
+             int ul)
+{
+  if (!dl && !ul) {
+    return;
+  }
+
+  Penalize(group->plctTree, idx, dl, ul);
+  Penalize(group->blcPlctTree, idx, dl, ul);
+  Penalize(group->drnPlctTree, idx, dl, ul);
+  Penalize(group->roAccessTree, idx, dl, ul);
+  Penalize(group->rwAccessTree, idx, dl, ul);
+  Penalize(group->blcAccessTree, idx, dl, ul);
+  Penalize(group->drnAccessTree, idx, dl, ul);
+}
+
+//------------------------------------------------------------------------------
+//! Replay a placement on a working copy of the given tree
+//------------------------------------------------------------------------------
+template<class T>
+static bool
+ReplayPlacement(ReplayGroup* group, T& srcTree,
+                const SchedulingTraceRecord& rec,
+                std::vector<SchedTreeBase::tFastTreeIdx>& newIdx)
+{
+  if (srcTree.copyToBuffer(gBuffer, gBufferSize)) {
+    return false;
+  }
+
+  T* tree = (T*) gBuffer;
+  const SchedTreeBase::tFastTreeIdx* idx;
+  bool updateNeeded = false;
+
+  for (auto it = rec.existingReplicas.begin(); it != rec.existingReplicas.end();
+       ++it) {
+    if (group->fs2Idx.get(*it, idx)) {
+      tree->getFileData(*idx).freeSlotsCount = 0;
+      tree->getFileData(*idx).takenSlotsCount = 1;
+      updateNeeded = true;
+    }
+  }
+
+  for (auto it = rec.excludeFs.begin(); it != rec.excludeFs.end(); ++it) {
+    if (group->fs2Idx.get(*it, idx)) {
+      tree->getFsData(*idx).mStatus &= ~SchedTreeBase::Available;
+      updateNeeded = true;
+    }
+  }
+
+  if (rec.bookingSize) {
+    for (auto it = tree->getFs2Idx()->begin(); it != tree->getFs2Idx()->end();
+         it++) {
+      float& freeSpace = tree->getFsData((*it).second).totalSpace;
+
+      if (freeSpace > rec.bookingSize) {
+        freeSpace -= rec.bookingSize;
+      } else {
+        tree->getFsData((*it).second).mStatus &= ~SchedTreeBase::Available;
+      }
+    }
+
+    updateNeeded = true;
+  }
+
+  if (updateNeeded) {
+    tree->updateTree();
+  }
+
+  SchedTreeBase::tFastTreeIdx startFrom = 0;
+
+  if (!rec.clientGeotag.empty()) {
+    startFrom = group->geo2Node.getClosestFastTreeNode(rec.clientGeotag.c_str());
+  }
+
+  for (size_t k = 0; k < rec.nReplicas; k++) {
+    SchedTreeBase::tFastTreeIdx newReplica;
+
+    if (!tree->findFreeSlot(newReplica, startFrom, true, true,
+                            gConfig.skipSaturated) &&
+        (!gConfig.skipSaturated ||
+         !tree->findFreeSlot(newReplica, startFrom, true, true, false))) {
+      return false;
+    }
+
+    newIdx.push_back(newReplica);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! Replay the access to one replica on a working copy of the given tree
+//------------------------------------------------------------------------------
+template<class T>
+static bool
+ReplayAccess(ReplayGroup* group, T& srcTree, const SchedulingTraceRecord& rec,
+             SchedTreeBase::tFastTreeIdx& accessIdx)
+{
+  if (srcTree.copyToBuffer(gBuffer, gBufferSize)) {
+    return false;
+  }
+
+  T* tree = (T*) gBuffer;
+  const SchedTreeBase::tFastTreeIdx* idx;
+
+  for (auto it = rec.existingReplicas.begin(); it != rec.existingReplicas.end();
+       ++it) {
+    if (group->fs2Idx.get(*it, idx)) {
+      tree->getFileData(*idx).freeSlotsCount = 1;
+      tree->getFileData(*idx).takenSlotsCount = 0;
+    }
+  }
+
+  tree->updateTree();
+  SchedTreeBase::tFastTreeIdx accesser =
+    group->geo2Node.getClosestFastTreeNode(rec.clientGeotag.c_str());
+  return tree->findFreeSlot(accessIdx, accesser, true, true,
+                            gConfig.skipSaturated) ||
+         (gConfig.skipSaturated && tree->findFreeSlot(accessIdx, 0, false, true,
+             false));
+}
+
+//------------------------------------------------------------------------------
+//! Account the decision of the replay against the recorded one
+//------------------------------------------------------------------------------
+static void
+Account(ReplayStats& stats, const SchedulingTraceRecord& rec, bool recordedOk,
+        bool replayOk, std::vector<uint32_t>& replayed, double seconds,
+        std::ostream* decisions)
+{
+  stats.count++;
+  stats.replaySeconds += seconds;
+  stats.replayLatency.Add(seconds * 1000.0);
+  stats.recordedLatency.Add(rec.latencyUs / 1000.0);
+
+  if (!recordedOk) {
+    stats.failedRecorded++;
+  }
+
+  if (!replayOk) {
+    stats.failedReplayed++;
+    replayed.clear();
+  }
+
+  for (auto it = rec.result.begin(); it != rec.result.end(); ++it) {
+    stats.recordedChoices[*it]++;
+  }
+
+  for (auto it = replayed.begin(); it != replayed.end(); ++it) {
+    stats.replayedChoices[*it]++;
+  }
+
+  std::vector<uint32_t> a(rec.result), b(replayed);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+
+  if (a == b) {
+    stats.sameDecision++;
+  }
+
+  if (decisions) {
+    (*decisions) << ((rec.type == SchedulingTraceRecord::kPlacement) ? "plct" :
+                     "accs") << " " << (int) rec.schedType << " ";
+
+    for (size_t i = 0; i < replayed.size(); i++) {
+      (*decisions) << (i ? "," : "") << replayed[i];
+    }
+
+    (*decisions) << "\n";
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Total variation distance between two choice distributions
+//------------------------------------------------------------------------------
+static double
+Distance(const std::map<uint32_t, unsigned long long>& p,
+         const std::map<uint32_t, unsigned long long>& q)
+{
+  double np = 0, nq = 0, d = 0;
+  std::set<uint32_t> keys;
+
+  for (auto it = p.begin(); it != p.end(); ++it) {
+    np += it->second;
+    keys.insert(it->first);
+  }
+
+  for (auto it = q.begin(); it != q.end(); ++it) {
+    nq += it->second;
+    keys.insert(it->first);
+  }
+
+  if (!np || !nq) {
+    return (np == nq) ? 0 : 1;
+  }
+
+  for (auto it = keys.begin(); it != keys.end(); ++it) {
+    auto pi = p.find(*it);
+    auto qi = q.find(*it);
+    double vp = (pi == p.end()) ? 0 : pi->second / np;
+    double vq = (qi == q.end()) ? 0 : qi->second / nq;
+    d += fabs(vp - vq);
+  }
+
+  return d / 2;
+}
+
+static void
+Print(const char* name, const ReplayStats& stats)
+{
+  if (!stats.count) {
+    return;
+  }
+
+  cout << "# " << name << endl;
+  cout << "requests              : " << stats.count << endl;
+  cout << "failed recorded       : " << stats.failedRecorded << endl;
+  cout << "failed replayed       : " << stats.failedReplayed << endl;
+  cout << "same decision         : " << std::fixed << std::setprecision(2) <<
+       100.0 * stats.sameDecision / stats.count << " %" << endl;
+  cout << "choice distance (TVD) : " << std::setprecision(4) <<
+       Distance(stats.recordedChoices, stats.replayedChoices) << endl;
+  cout << "replay rate           : " << std::setprecision(0) <<
+       (stats.replaySeconds ? stats.count / stats.replaySeconds : 0) << " /s" <<
+       endl;
+  cout << std::setprecision(3);
+  cout << "replay latency   [ms] : p50=" << stats.replayLatency.Percentile(0.5)
+       << " p99=" << stats.replayLatency.Percentile(0.99) << " p99.9=" <<
+       stats.replayLatency.Percentile(0.999) << " max=" <<
+       stats.replayLatency.GetMax() << endl;
+  cout << "recorded latency [ms] : p50=" << stats.recordedLatency.Percentile(
+         0.5) << " p99=" << stats.recordedLatency.Percentile(0.99) << " p99.9=" <<
+       stats.recordedLatency.Percentile(0.999) << " max=" <<
+       stats.recordedLatency.GetMax() << endl;
+  // show the most chosen filesystems side by side
+  std::vector<std::pair<unsigned long long, uint32_t> > top;
+
+  for (auto it = stats.recordedChoices.begin(); it != stats.recordedChoices.end();
+       ++it) {
+    top.push_back(std::make_pair(it->second, it->first));
+  }
+
+  std::sort(top.rbegin(), top.rend());
+  cout << "top filesystems       : fsid recorded replayed" << endl;
+
+  for (size_t i = 0; i < top.size() && i < 10; i++) {
+    auto rit = stats.replayedChoices.find(top[i].second);
+    cout << "                        " << top[i].second << " " << top[i].first <<
+         " " << ((rit == stats.replayedChoices.end()) ? 0 : rit->second) << endl;
+  }
+
+  cout << endl;
+}
+
+static void
+Usage(const char* prog)
+{
+  cerr << "usage: " << prog << " [options] <trace file>" << endl
+       << "       --fill-ratio-limit <n>      (default 80)" << endl
+       << "       --fill-ratio-comp-tol <n>   (default 100)" << endl
+       << "       --saturation-thres <n>      (default 10)" << endl
+       << "       --time-frame-ms <n>         fast structures refresh period (default 1000)"
+       << endl
+       << "       --plct-penalty <dl>:<ul>    penalty applied after a placement (default 0:0)"
+       << endl
+       << "       --access-penalty <dl>:<ul>  penalty applied after an access (default 0:0)"
+       << endl
+       << "       --skip-saturated            skip saturated fs first" << endl
+       << "       --decisions <file>          dump the replayed decisions to compare versions"
+       << endl;
+}
+
+static bool
+ParsePenalty(const char* arg, int& dl, int& ul)
+{
+  return sscanf(arg, "%d:%d", &dl, &ul) == 2;
+}
+
+int
+main(int argc, char* argv[])
+{
+  std::string traceFile;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i + 1 < argc);
+
+    if (arg == "--fill-ratio-limit" && hasValue) {
+      gConfig.fillRatioLimit = atoi(argv[++i]);
+    } else if (arg == "--fill-ratio-comp-tol" && hasValue) {
+      gConfig.fillRatioCompTol = atoi(argv[++i]);
+    } else if (arg == "--saturation-thres" && hasValue) {
+      gConfig.saturationThres = atoi(argv[++i]);
+    } else if (arg == "--time-frame-ms" && hasValue) {
+      gConfig.timeFrameDurationMs = atoi(argv[++i]);
+    } else if (arg == "--plct-penalty" && hasValue) {
+      if (!ParsePenalty(argv[++i], gConfig.plctDlScorePenalty,
+                        gConfig.plctUlScorePenalty)) {
+        Usage(argv[0]);
+        return EINVAL;
+      }
+    } else if (arg == "--access-penalty" && hasValue) {
+      if (!ParsePenalty(argv[++i], gConfig.accessDlScorePenalty,
+                        gConfig.accessUlScorePenalty)) {
+        Usage(argv[0]);
+        return EINVAL;
+      }
+    } else if (arg == "--skip-saturated") {
+      gConfig.skipSaturated = true;
+    } else if (arg == "--decisions" && hasValue) {
+      gConfig.decisionsFile = argv[++i];
+    } else if (arg[0] != '-' && traceFile.empty()) {
+      traceFile = arg;
+    } else {
+      Usage(argv[0]);
+      return EINVAL;
+    }
+  }
+
+  if (traceFile.empty()) {
+    Usage(argv[0]);
+    return EINVAL;
+  }
+
+  eos::common::Logging::Init();
+  eos::common::Logging::SetUnit("eos-geosched-replay");
+  eos::common::Logging::SetLogPriority(LOG_NOTICE);
+  SchedulingTraceReader reader;
+
+  if (!reader.Open(traceFile)) {
+    cerr << "error: cannot open trace file " << traceFile << endl;
+    return EIO;
+  }
+
+  std::ofstream decisionsStream;
+  std::ostream* decisions = 0;
+
+  if (gConfig.decisionsFile.length()) {
+    decisionsStream.open(gConfig.decisionsFile.c_str());
+
+    if (!decisionsStream.is_open()) {
+      cerr << "error: cannot open decisions file " << gConfig.decisionsFile << endl;
+      return EIO;
+    }
+
+    decisions = &decisionsStream;
+  }
+
+  gBuffer = new char[gBufferSize];
+  SchedulingTraceRecord rec;
+  ReplayStats plctStats, accessStats;
+  unsigned long long nFsStates = 0, nSkipped = 0;
+  uint64_t firstUs = 0, lastUs = 0;
+  std::vector<SchedTreeBase::tFastTreeIdx> newIdx;
+  std::vector<uint32_t> replayed;
+
+  while (reader.Next(rec)) {
+    if (!firstUs) {
+      firstUs = rec.timeUs;
+    }
+
+    lastUs = rec.timeUs;
+
+    if (rec.type == SchedulingTraceRecord::kFsState) {
+      ApplyFsState(rec);
+      nFsStates++;
+      continue;
+    }
+
+    if (rec.type == SchedulingTraceRecord::kPlacement) {
+      auto git = gGroups.find(rec.group);
+
+      if (git == gGroups.end() || !RefreshGroup(git->second, rec.timeUs)) {
+        nSkipped++;
+        continue;
+      }
+
+      ReplayGroup* group = git->second;
+      newIdx.clear();
+      replayed.clear();
+      double start = Now();
+      bool ok = false;
+
+      switch (rec.schedType) {
+      case 2: // balancing
+        ok = ReplayPlacement(group, group->blcPlctTree, rec, newIdx);
+        break;
+
+      case 3: // draining
+        ok = ReplayPlacement(group, group->drnPlctTree, rec, newIdx);
+        break;
+
+      default:
+        ok = ReplayPlacement(group, group->plctTree, rec, newIdx);
+      }
+
+      double elapsed = Now() - start;
+
+      for (auto it = newIdx.begin(); ok && it != newIdx.end(); ++it) {
+        replayed.push_back(group->treeInfo[*it].fsId);
+        ApplyPenalty(group, *it, gConfig.plctDlScorePenalty,
+                     gConfig.plctUlScorePenalty);
+      }
+
+      Account(plctStats, rec, rec.retCode == 1, ok, replayed, elapsed, decisions);
+      continue;
+    }
+
+    if (rec.type == SchedulingTraceRecord::kAccess) {
+      // replicas are placed in a single group, use the one of the first known replica
+      ReplayGroup* group = 0;
+
+      for (auto it = rec.existingReplicas.begin(); it != rec.existingReplicas.end();
+           ++it) {
+        auto fsit = gFs.find(*it);
+
+        if (fsit != gFs.end()) {
+          group = gGroups[fsit->second.group];
+          break;
+        }
+      }
+
+      if (!group || !RefreshGroup(group, rec.timeUs)) {
+        nSkipped++;
+        continue;
+      }
+
+      replayed.clear();
+      SchedTreeBase::tFastTreeIdx accessIdx = 0;
+      double start = Now();
+      bool ok = false;
+
+      switch (rec.schedType) {
+      case 0: // regularRO
+        ok = ReplayAccess(group, group->roAccessTree, rec, accessIdx);
+        break;
+
+      case 1: // regularRW
+        ok = ReplayAccess(group, group->rwAccessTree, rec, accessIdx);
+        break;
+
+      case 2: // balancing
+        ok = ReplayAccess(group, group->blcAccessTree, rec, accessIdx);
+        break;
+
+      default: // draining
+        ok = ReplayAccess(group, group->drnAccessTree, rec, accessIdx);
+      }
+
+      double elapsed = Now() - start;
+
+      if (ok) {
+        replayed.push_back(group->treeInfo[accessIdx].fsId);
+        ApplyPenalty(group, accessIdx, gConfig.accessDlScorePenalty,
+                     gConfig.accessUlScorePenalty);
+      }
+
+      Account(accessStats, rec, rec.retCode == 0, ok, replayed, elapsed,
+              decisions);
+    }
+  }
+
+  cout << "# trace" << endl;
+  cout << "file                  : " << traceFile << endl;
+  cout << "duration              : " << std::fixed << std::setprecision(3) <<
+       (lastUs - firstUs) / 1e6 << " s" << endl;
+  cout << "fs states             : " << nFsStates << endl;
+  cout << "groups                : " << gGroups.size() << endl;
+  cout << "filesystems           : " << gFs.size() << endl;
+  cout << "skipped requests      : " << nSkipped << endl;
+  cout << endl;
+  Print("placements", plctStats);
+  Print("accesses", accessStats);
+  delete[] gBuffer;
+
+  for (auto it = gGroups.begin(); it != gGroups.end(); ++it) {
+    delete it->second;
+  }
+
+  return 0;
+}
@@ -728,6 +728,94 @@ int mainFull()
          elapsed) / CLOCKS_PER_SEC)
        << " placements/sec " << endl;
   cout << "----------------------------" << endl << endl;
+  // placement of files having one existing replica and one excluded fs
+  // as done for draining and balancing, first file by file with the
+  // constraints vectors allocated for each file
+  begin = clock();
+
+  for (size_t i = 0; i < schedGroups.size() * nbIter; i++) {
+    size_t j = i % schedGroups.size();
+    vector<SchedTreeBase::tFastTreeIdx>* existingIdx =
+      new vector<SchedTreeBase::tFastTreeIdx>(1);
+    vector<SchedTreeBase::tFastTreeIdx>* excludeIdx =
+      new vector<SchedTreeBase::tFastTreeIdx>(1);
+    vector<SchedTreeBase::tFastTreeIdx> newIdx(2);
+    (*existingIdx)[0] = replicaIdxs[3 * j];
+    (*excludeIdx)[0] = replicaIdxs[3 * j + 1];
+    newIdx.resize(0);
+    char buffer[bufferSize];
+    assert(fptrees[j].copyToBuffer(buffer, bufferSize) == 0);
+    FastPlacementTree* ftree = (FastPlacementTree*) buffer;
+    ftree->getFileData((*existingIdx)[0]).freeSlotsCount = 0;
+    ftree->getFileData((*existingIdx)[0]).takenSlotsCount = 1;
+    ftree->getFsData((*excludeIdx)[0]).mStatus &= ~SchedTreeBase::Available;
+    ftree->updateTree();
+    SchedTreeBase::tFastTreeIdx repId;
+
+    for (int k = 0; k < 2; k++) {
+      if (ftree->findFreeSlot(repId, 0, true, true)) {
+        newIdx.push_back(repId);
+      }
+    }
+
+    delete existingIdx;
+    delete excludeIdx;
+  }
+
+  elapsed = clock() - begin;
+  cout << "CONSTRAINED PLACEMENT SPEED TEST (FILE BY FILE)" << endl;
+  cout << "elapsed time : " << float (elapsed) / CLOCKS_PER_SEC << " sec." <<
+       endl;
+  cout << "speed        : " << schedGroups.size() * nbIter / (float (
+         elapsed) / CLOCKS_PER_SEC)
+       << " files/sec " << endl;
+  cout << "----------------------------" << endl << endl;
+  // same placements in batches of files of one scheduling group reusing the
+  // constraints vectors and the working buffer as GeoTreeEngine does with
+  // placeNewReplicasOneGroupBatch. This binary does not link the engine, the
+  // same comparison through GeoTreeEngine on a live scheduling group is
+  // 'eos geosched bench <group> <nfiles>'
+  const size_t batchSize = 1000;
+  vector<SchedTreeBase::tFastTreeIdx> existingArena, excludeArena, newArena;
+  char* batchBuffer = new char[bufferSize];
+  begin = clock();
+
+  for (size_t i = 0; i < schedGroups.size() * nbIter; i += batchSize) {
+    size_t j = (i / batchSize) % schedGroups.size();
+
+    for (size_t f = 0; f < batchSize; f++) {
+      existingArena.clear();
+      excludeArena.clear();
+      newArena.clear();
+      existingArena.push_back(replicaIdxs[3 * j]);
+      excludeArena.push_back(replicaIdxs[3 * j + 1]);
+      assert(fptrees[j].copyToBuffer(batchBuffer, bufferSize) == 0);
+      FastPlacementTree* ftree = (FastPlacementTree*) batchBuffer;
+      ftree->getFileData(existingArena[0]).freeSlotsCount = 0;
+      ftree->getFileData(existingArena[0]).takenSlotsCount = 1;
+      ftree->getFsData(excludeArena[0]).mStatus &= ~SchedTreeBase::Available;
+      ftree->updateTree();
+      SchedTreeBase::tFastTreeIdx repId;
+
+      for (int k = 0; k < 2; k++) {
+        if (ftree->findFreeSlot(repId, 0, true, true)) {
+          newArena.push_back(repId);
+        }
+      }
+    }
+  }
+
+  elapsed = clock() - begin;
+  delete[] batchBuffer;
+  cout << "CONSTRAINED PLACEMENT SPEED TEST (BATCH OF " << batchSize << ")" <<
+       endl;
+  cout << "elapsed time : " << float (elapsed) / CLOCKS_PER_SEC << " sec." <<
+       endl;
+  cout << "speed        : " << ((schedGroups.size() * nbIter + batchSize - 1) /
+                                batchSize) * batchSize / (float (
+                                      elapsed) / CLOCKS_PER_SEC)
+       << " files/sec " << endl;
+  cout << "----------------------------" << endl << endl;
   begin = clock();
 
   for (size_t i = 0; i < schedGroups.size() * nbIter; i++) {
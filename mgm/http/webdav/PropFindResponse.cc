@@ -180,8 +180,10 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
 
     if (!listrc) {
       const char* val;
+      uint64_t entry_id = 0;
+      bool entry_container = false;
 
-      while ((val = directory.nextEntry())) {
+      while ((val = directory.nextEntry(entry_id, entry_container))) {
         XrdOucString entryname = val;
 
         // don't display . .., atomic(+version) uploads and version directories
@@ -199,7 +201,19 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
                                   val)).c_str());
         eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
                                    std::string(val)).c_str());
-        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
+        // stat the listed entry by id instead of resolving its path again
+        XrdOucErrInfo error;
+        struct stat entryStat;
+        std::string entryEtag;
+
+        if (gOFS->_stat(entry_id, entry_container, &entryStat, error,
+                        *mVirtualIdentity, &entryEtag)) {
+          // removed after the listing
+          continue;
+        }
+
+        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath(),
+                                         &entryStat, &entryEtag);
 
         if (responseNode) {
           multistatusNode->append_node(responseNode);
@@ -303,7 +317,9 @@ PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
 /*----------------------------------------------------------------------------*/
 rapidxml::xml_node<>*
 PropFindResponse::BuildResponseNode(const std::string& url,
-                                    const std::string& hrefurl)
+                                    const std::string& hrefurl,
+                                    const struct stat* statinfo,
+                                    const std::string* knownetag)
 {
   using namespace rapidxml;
   XrdMgmOfsDirectory directory;
@@ -324,8 +340,14 @@ PropFindResponse::BuildResponseNode(const std::string& url,
   // Is the requested resource a file or directory?
   eos_static_debug("url=%s", urlp.c_str());
 
-  if (gOFS->_stat(urlp.c_str(), &statInfo, error, *mVirtualIdentity,
-                  (const char*) 0, &etag)) {
+  if (statinfo) {
+    statInfo = *statinfo;
+
+    if (knownetag) {
+      etag = *knownetag;
+    }
+  } else if (gOFS->_stat(urlp.c_str(), &statInfo, error, *mVirtualIdentity,
+                         (const char*) 0, &etag)) {
     eos_static_err("msg=\"error stating %s: %s\"", urlp.c_str(),
                    error.getErrText());
     SetResponseCode(ResponseCodes::NOT_FOUND);
@@ -141,11 +141,15 @@ public:
    * requested, whether they were found or not, etc (see RFC)
    *
    * @param url  the URL of the resource to build a response node for
+   * @param statinfo stat of the resource if already known (directory listing)
+   * @param etag etag of the resource if already known
    *
    * @return the newly build response node
    */
   rapidxml::xml_node<>*
-  BuildResponseNode (const std::string &url, const std::string &hrefurl);
+  BuildResponseNode (const std::string &url, const std::string &hrefurl,
+                     const struct stat *statinfo = 0,
+                     const std::string *etag = 0);
 
   /**
    * Convert the given property type string into its integer constant
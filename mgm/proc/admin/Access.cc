@@ -1017,6 +1017,13 @@ ProcCommand::Access ()
         stdOut += "\n";
       }
     }
+
+    if (Access::gStallUserGroup)
+    {
+      std::string rates;
+      Access::gRateLimiter.Print(rates, monitoring);
+      stdOut += rates.c_str();
+    }
   }
   return SFS_OK;
 }
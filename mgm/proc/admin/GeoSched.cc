@@ -84,6 +84,49 @@ ProcCommand::GeoSched ()
       stdOut += "GeoTreeEngine has been refreshed\n";
       retc = SFS_OK;
     }
+    if(mSubCmd.beginswith("trace"))
+    {
+      if(mSubCmd == "tracestart")
+      {
+        XrdOucString tracefile = pOpaque->Get("mgm.tracefile");
+        if(!tracefile.length())
+        {
+          stdErr += "error: missing trace file name\n";
+          retc = EINVAL;
+        }
+        else
+        {
+          XrdOucString msg;
+          retc = gGeoTreeEngine.startTrace(tracefile.c_str(),&msg);
+          if(retc) stdErr += msg;
+          else stdOut += msg;
+        }
+      }
+      if(mSubCmd == "tracestop")
+      {
+        gGeoTreeEngine.stopTrace(&stdOut);
+        retc = SFS_OK;
+      }
+      if(mSubCmd == "traceshow")
+      {
+        gGeoTreeEngine.showTrace(&stdOut);
+        retc = SFS_OK;
+      }
+    }
+    if(mSubCmd == "bench")
+    {
+      XrdOucString group = pOpaque->Get("mgm.schedgroup");
+      XrdOucString nfiles = pOpaque->Get("mgm.nfiles");
+      XrdOucString nreplicas = pOpaque->Get("mgm.nreplicas");
+      retc = gGeoTreeEngine.benchPlacement(group.c_str(),
+          nfiles.length()?strtoul(nfiles.c_str(),0,10):0,
+          nreplicas.length()?strtoul(nreplicas.c_str(),0,10):1,&stdOut);
+      if(retc)
+      {
+        stdErr += stdOut;
+        stdOut = "";
+      }
+    }
     if(mSubCmd.beginswith("disabled"))
     {
       XrdOucString geotag = pOpaque->Get("mgm.geotag");
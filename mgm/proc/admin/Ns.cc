@@ -26,11 +26,98 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/Quota.hh"
 #include "common/LinuxMemConsumption.hh"
+#include "namespace/interface/IDeferredAccounting.hh"
+#include <algorithm>
 
 /*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN
 
+#ifdef EOS_INSTRUMENTED_RWMUTEX
+//------------------------------------------------------------------------------
+// Print the contention profile of the top call sites and the last long write
+// holds of the profiled mutexes
+//------------------------------------------------------------------------------
+static void
+PrintMutexProfile(XrdOucString& out, size_t top, bool byhold)
+{
+  std::vector<eos::common::RWMutexSiteStats> sites;
+  eos::common::RWMutex::GetProfileStatistics(sites);
+  std::sort(sites.begin(), sites.end(),
+            [byhold](const eos::common::RWMutexSiteStats & a,
+  const eos::common::RWMutexSiteStats & b) {
+    return byhold ? (a.TotalHold() > b.TotalHold()) :
+           (a.TotalWait() > b.TotalWait());
+  });
+
+  if (sites.size() > top) {
+    sites.resize(top);
+  }
+
+  char line[4096];
+  out += "# ------------------------------------------------------------------------------------\n";
+  snprintf(line, sizeof(line),
+           "# Mutex Contention Profile - top %lu call sites by %s time [us]\n",
+           (unsigned long) top, byhold ? "hold" : "wait");
+  out += line;
+  out += "# ------------------------------------------------------------------------------------\n";
+  snprintf(line, sizeof(line),
+           "%-10s %-5s %10s %10s %10s %10s %10s %10s %10s  %s\n", "mutex", "lock",
+           "samples", "wait-avg", "wait-p99", "wait-max", "hold-avg", "hold-p99",
+           "hold-max", "call site");
+  out += line;
+
+  for (size_t i = 0; i < sites.size(); i++) {
+    for (int write = 0; write < 2; write++) {
+      const eos::common::RWMutexHistogram& wait =
+        write ? sites[i].waitwrite : sites[i].waitread;
+      const eos::common::RWMutexHistogram& hold =
+        write ? sites[i].holdwrite : sites[i].holdread;
+
+      if (!wait.count) {
+        continue;
+      }
+
+      snprintf(line, sizeof(line),
+               "%-10s %-5s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f  %s\n",
+               sites[i].mutex.c_str(), write ? "write" : "read",
+               (unsigned long) wait.count, wait.Average() / 1000.0,
+               wait.Percentile(99) / 1000.0, wait.max / 1000.0,
+               hold.Average() / 1000.0, hold.Percentile(99) / 1000.0,
+               hold.max / 1000.0, sites[i].site.c_str());
+      out += line;
+    }
+  }
+
+  std::vector<eos::common::RWMutexLongHold> holds;
+  eos::common::RWMutex::GetLongWriteHolds(holds);
+
+  if (holds.empty()) {
+    return;
+  }
+
+  out += "# ------------------------------------------------------------------------------------\n";
+  out += "# Long Write Holds\n";
+  out += "# ------------------------------------------------------------------------------------\n";
+
+  for (size_t i = 0; i < holds.size(); i++) {
+    char stime[32];
+    struct tm tms;
+    localtime_r(&holds[i].when, &tms);
+    strftime(stime, sizeof(stime), "%y%m%d %H:%M:%S", &tms);
+    snprintf(line, sizeof(line), "%s %-10s held for %.03f ms\n", stime,
+             holds[i].mutex.c_str(), holds[i].duration / 1000000.0);
+    out += line;
+
+    for (size_t f = 0; f < holds[i].backtrace.size(); f++) {
+      out += "\t";
+      out += holds[i].backtrace[f].c_str();
+      out += "\n";
+    }
+  }
+}
+#endif
+
 int
 ProcCommand::Ns()
 {
@@ -44,6 +131,10 @@ ProcCommand::Ns()
       bool smplrate1 = false;
       bool smplrate10 = false;
       bool smplrate100 = false;
+      bool toggleprofile = false;
+      bool showprofile = false;
+      bool longwrite = false;
+      bool resetprofile = false;
       bool nooption = true;
 
       if ((option.find("t") != STR_NPOS)) {
@@ -66,7 +157,24 @@ ProcCommand::Ns()
         smplrate100 = true;
       }
 
-      if (smplrate1 || smplrate10 || smplrate100 || toggleorder || toggletiming) {
+      if ((option.find("p") != STR_NPOS)) {
+        toggleprofile = true;
+      }
+
+      if ((option.find("P") != STR_NPOS)) {
+        showprofile = true;
+      }
+
+      if ((option.find("L") != STR_NPOS)) {
+        longwrite = true;
+      }
+
+      if ((option.find("r") != STR_NPOS)) {
+        resetprofile = true;
+      }
+
+      if (smplrate1 || smplrate10 || smplrate100 || toggleorder || toggletiming ||
+          toggleprofile || showprofile || longwrite || resetprofile) {
         nooption = false;
       }
 
@@ -106,6 +214,22 @@ ProcCommand::Ns()
         }
 
         stdOut += "\n";
+        stdOut += "profiling      is : ";
+        stdOut += (gOFS->eosViewRWMutex.GetProfiling() ? "on " : "off");
+        sprintf(ssr, "%f", eos::common::RWMutex::GetProfileSampling());
+        stdOut += " (sampling rate per thread ";
+        stdOut += ssr;
+        stdOut += ")\n";
+        stdOut += "long write hold is: ";
+        size_t longhold = eos::common::RWMutex::GetLongWriteHold();
+
+        if (longhold) {
+          stdOut += "reported above ";
+          stdOut += (int)(longhold / 1000000);
+          stdOut += " ms\n";
+        } else {
+          stdOut += "off\n";
+        }
       }
 
       if (toggletiming) {
@@ -151,6 +275,41 @@ ProcCommand::Ns()
         Quota::pMapMutex.SetSampling(true, rate);
         gOFS->eosViewRWMutex.SetSampling(true, rate);
       }
+
+      if (toggleprofile) {
+        bool on = !gOFS->eosViewRWMutex.GetProfiling();
+        FsView::gFsView.ViewMutex.SetProfiling(on);
+        Quota::pMapMutex.SetProfiling(on);
+        gOFS->eosViewRWMutex.SetProfiling(on);
+        eos::common::Mapping::gMapMutex.SetProfiling(on);
+        stdOut += (on ? "mutex profiling is on\n" : "mutex profiling is off\n");
+      }
+
+      if (longwrite) {
+        const char* val = pOpaque->Get("mgm.mutex.longwrite");
+        size_t ms = val ? strtoull(val, 0, 10) : 0;
+        eos::common::RWMutex::SetLongWriteHold(ms * 1000000);
+
+        if (ms) {
+          stdOut += "mutex write holds above ";
+          stdOut += (int) ms;
+          stdOut += " ms are reported\n";
+        } else {
+          stdOut += "mutex long write hold reporting is off\n";
+        }
+      }
+
+      if (resetprofile) {
+        eos::common::RWMutex::ResetProfileStatistics();
+        stdOut += "mutex profiles are reset\n";
+      }
+
+      if (showprofile) {
+        const char* val = pOpaque->Get("mgm.mutex.top");
+        const char* sort = pOpaque->Get("mgm.mutex.sort");
+        size_t top = val ? strtoull(val, 0, 10) : 0;
+        PrintMutexProfile(stdOut, top ? top : 10, sort && !strcmp(sort, "hold"));
+      }
     } else {
       retc = EPERM;
       stdErr = "error: you have to take role 'root' to execute this command";
@@ -245,6 +404,44 @@ ProcCommand::Ns()
         boottime = gOFS->InitializationTime;
       }
     }
+    // lag of the deferred tree size and sync time propagation
+    std::string deferred_human;
+    std::string deferred_monitor;
+    {
+      eos::common::RWMutexReadLock nsLock(gOFS->eosViewRWMutex);
+      const char* deferred_tag[2] = {"treesize", "synctime"};
+      const char* deferred_name[2] = {"Deferred Tree Size      ",
+                                      "Deferred Sync Time      "
+                                     };
+      eos::IDeferredAccounting* deferred[2] = {
+        dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosContainerAccounting),
+        dynamic_cast<eos::IDeferredAccounting*>(gOFS->eosSyncTimeAccounting)
+      };
+
+      for (size_t i = 0; i < 2; ++i) {
+        uint64_t pending = 0;
+        uint64_t lag_ms = 0;
+        uint64_t last_ms = 0;
+
+        if (!deferred[i] || !deferred[i]->getDeferredLag(pending, lag_ms, last_ms)) {
+          continue;
+        }
+
+        char line[1024];
+        snprintf(line, sizeof(line) - 1, "ALL      %s         pending=%llu "
+                 "lag=%llu ms last=%llu ms\n", deferred_name[i],
+                 (unsigned long long) pending, (unsigned long long) lag_ms,
+                 (unsigned long long) last_ms);
+        deferred_human += line;
+        snprintf(line, sizeof(line) - 1, "uid=all gid=all ns.%s.pending=%llu\n"
+                 "uid=all gid=all ns.%s.lag=%llu\n"
+                 "uid=all gid=all ns.%s.last=%llu\n",
+                 deferred_tag[i], (unsigned long long) pending,
+                 deferred_tag[i], (unsigned long long) lag_ms,
+                 deferred_tag[i], (unsigned long long) last_ms);
+        deferred_monitor += line;
+      }
+    }
     double avg = 0;
     double sigma = 0;
 
@@ -272,6 +469,11 @@ ProcCommand::Ns()
       gOFS->MgmMaster.PrintOut(stdOut);
       stdOut += "\n";
 
+      if (deferred_human.length()) {
+        stdOut += "# ....................................................................................\n";
+        stdOut += deferred_human.c_str();
+      }
+
       if (!gOFS->MgmMaster.IsMaster()) {
         char slatency[1024];
         snprintf(slatency, sizeof(slatency) - 1, "%.02f += %.02f ms", avg, sigma);
@@ -425,6 +627,7 @@ ProcCommand::Ns()
         stdOut += "\n";
       }
 
+      stdOut += deferred_monitor.c_str();
       stdOut += "uid=all gid=all ns.uptime=";
       stdOut += (int)(time(NULL) - gOFS->StartTime);
       stdOut += "\n";
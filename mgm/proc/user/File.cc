@@ -1468,11 +1468,15 @@ ProcCommand::File()
                   retc = EINVAL;
                   stdErr += "error: invalid argument for file access";
                 } else {
-                  // We got a new replication vector
+                  // We got a new replication vector, schedule one source
+                  // per new replica in one go
+                  std::vector<unsigned long> sourceidx(selectedfs.size());
+                  size_t nsources = Quota::FileAccessBatch(&acsargs, sourceidx);
+
                   for (unsigned int i = 0; i < selectedfs.size(); i++) {
-                    if (!(errno = Quota::FileAccess(&acsargs))) {
+                    if (i < nsources) {
                       // This is now our source filesystem
-                      unsigned int sourcefsid = sourcefs[fsIndex];
+                      unsigned int sourcefsid = sourcefs[sourceidx[i]];
 
                       // stdOut += "info: replication := "; stdOut += (int) sourcefsid;
                       // stdOut += " => "; stdOut += (int)selectedfs[i]; stdOut += "\n";
@@ -1494,6 +1498,7 @@ ProcCommand::File()
                         stdOut += "\n";
                       }
                     } else {
+                      errno = ENODATA;
                       stdErr = "error: create new replicas => no source available: ";
                       stdErr += spath;
                       stdErr += "\n";
@@ -57,9 +57,6 @@ ProcCommand::Find ()
   XrdOucString printkey = pOpaque->Get("mgm.find.printkey");
 
   const char* inpath = spath.c_str();
-  bool deepquery = false;
-  static XrdSysMutex deepQueryMutex;
-  static std::map<std::string, std::set<std::string> > * globalfound = 0;
   NAMESPACEMAP;
   info = 0;
   if (info)info = 0; // for compiler happyness
@@ -75,21 +72,6 @@ ProcCommand::Find ()
     return SFS_OK;
   }
 
-  eos::common::Path cPath(spath.c_str());
-  if (cPath.GetSubPathSize() < 5)
-  {
-    if ((((option.find("d")) != STR_NPOS) && ((option.find("f")) == STR_NPOS)))
-    {
-      // directory queries are fine even for the complete namespace
-      deepquery = false;
-    }
-    else
-    {
-      // deep queries are serialized by a mutex and use a single the output hashmap !
-      deepquery = true;
-    }
-  }
-
   // this hash is used to calculate the balance of the found files over the filesystems involved
   google::dense_hash_map<unsigned long, unsigned long long> filesystembalance;
   google::dense_hash_map<std::string, unsigned long long> spacebalance;
@@ -306,24 +288,6 @@ ProcCommand::Find ()
   }
   else
   {
-    std::map<std::string, std::set<std::string> > * found = 0;
-    if (deepquery)
-    {
-      // we use a single once allocated map for deep searches to store the results to avoid memory explosion
-      deepQueryMutex.Lock();
-
-      if (!globalfound)
-      {
-        globalfound = new std::map<std::string, std::set<std::string> >;
-      }
-      found = globalfound;
-    }
-    else
-    {
-      found = new std::map<std::string, std::set<std::string> >;
-    }
-    std::map<std::string, std::set<std::string> >::const_iterator foundit;
-    std::set<std::string>::const_iterator fileit;
     bool nofiles = false;
 
     if (((option.find("d")) != STR_NPOS) && ((option.find("f")) == STR_NPOS))
@@ -340,12 +304,6 @@ ProcCommand::Find ()
       stdErr += "'";
       fprintf(fstderr, "%s", stdErr.c_str());
       retc = errno;
-
-      if (deepquery)
-	deepQueryMutex.UnLock();
-      else
-	delete found;
-
       return SFS_OK;
     }
     else
@@ -361,64 +319,24 @@ ProcCommand::Find ()
 	stdErr += "error: no such file or directory";
 	fprintf(fstderr, "%s", stdErr.c_str());
 	retc = ENOENT;
-
-	if (deepquery)
-	  deepQueryMutex.UnLock();
-	else
-	  delete found;
-	
 	return SFS_OK;
       }
     }
-    if (gOFS->_find(spath.c_str(), *mError, stdErr, *pVid, (*found),
-                    key.c_str(), val.c_str(), nofiles, 0, true, finddepth, filematch.length()?filematch.c_str():0))
-    {
-      fprintf(fstderr, "%s", stdErr.c_str());
-      fprintf(fstderr, "error: unable to run find in directory");
-      retc = errno;
-
-      if (deepquery)
-	deepQueryMutex.UnLock();
-      else
-	delete found;
-
-      return SFS_OK;
-    }
-    else
-    {
-      if (stdErr.length())
-      {
-        fprintf(fstderr,"%s", stdErr.c_str());
-        retc = E2BIG;
-      }
-    }
     int cnt = 0;
     unsigned long long filecounter = 0;
     unsigned long long dircounter = 0;
-
-    if (((option.find("f")) != STR_NPOS) || ((option.find("d")) == STR_NPOS))
+    bool listfiles = (((option.find("f")) != STR_NPOS) || ((option.find("d")) == STR_NPOS));
+    bool listdirs = ((option.find("d")) != STR_NPOS);
+    bool printdirs = ((option.find("d")) == STR_NPOS) && (option.find("f") == STR_NPOS);
+
+    // -------------------------------------------------------------------------
+    // the entries are processed and written out while the find is running
+    // -------------------------------------------------------------------------
+    auto processFile = [&](const std::string& dirpath, const std::string& filename)
     {
-      for (foundit = (*found).begin(); foundit != (*found).end(); foundit++)
-      {
-        if ((option.find("d")) == STR_NPOS)
-        {
-          if (option.find("f") == STR_NPOS)
-          {
-            if (!printcounter) 
-	    {
-	      if (printxurl)
-		fprintf(fstdout,"%s", url.c_str());
-	      fprintf(fstdout, "%s\n", foundit->first.c_str());
-	    }
-            dircounter++;
-          }
-        }
-
-        for (fileit = foundit->second.begin(); fileit != foundit->second.end(); fileit++)
-        {
           cnt++;
-          std::string fspath = foundit->first;
-          fspath += *fileit;
+          std::string fspath = dirpath;
+          fspath += filename;
           if (!calcbalance)
           {
             if (findgroupmix || findzero || printsize || printfid || printuid ||
@@ -860,26 +778,20 @@ ProcCommand::Find ()
               //-------------------------------------------
             }
           }
-        }
-      }
-      gOFS->MgmStats.Add("FindEntries", pVid->uid, pVid->gid, cnt);
-    }
+    };
 
-    eos_debug("Listing directories");
-    if ((option.find("d")) != STR_NPOS)
+    auto processDir = [&](const std::string& dirpath)
     {
-      for (foundit = (*found).begin(); foundit != (*found).end(); foundit++)
-      {
         // eventually call the version purge function if we own this version dir or we are root
 
-        if (purge && (foundit->first.find(EOS_COMMON_PATH_VERSION_PREFIX) != std::string::npos))
+        if (purge && (dirpath.find(EOS_COMMON_PATH_VERSION_PREFIX) != std::string::npos))
         {
           struct stat buf;
-          if ( (!gOFS->_stat(foundit->first.c_str(), &buf, *mError, *pVid, (const char*) 0, 0)) &&
+          if ( (!gOFS->_stat(dirpath.c_str(), &buf, *mError, *pVid, (const char*) 0, 0)) &&
               ( (pVid->uid == 0) || (pVid->uid == buf.st_uid) ) )
           {
-            fprintf(fstdout, "# purging %s", foundit->first.c_str());
-            gOFS->PurgeVersion(foundit->first.c_str(), *mError,max_version);
+            fprintf(fstdout, "# purging %s", dirpath.c_str());
+            gOFS->PurgeVersion(dirpath.c_str(), *mError,max_version);
           }
         }
 
@@ -887,7 +799,7 @@ ProcCommand::Find ()
         {
           // get the attributes and call the verify function
           eos::IContainerMD::XAttrMap map;
-          if (!gOFS->_attr_ls(foundit->first.c_str(),
+          if (!gOFS->_attr_ls(dirpath.c_str(),
                               *mError,
                               *pVid,
                               (const char *) 0,
@@ -899,19 +811,19 @@ ProcCommand::Find ()
               if (map.count("sys.acl"))
               {
                 if (Acl::IsValid(map["sys.acl"].c_str(), *mError))
-                  continue;
+                  return;
               }
 
               if (map.count("user.acl"))
               {
                 if (Acl::IsValid(map["user.acl"].c_str(), *mError))
-                  continue;
+                  return;
               }
             }
 
             else
             {
-              continue;
+              return;
             }
           }
         }
@@ -920,7 +832,7 @@ ProcCommand::Find ()
         XrdOucString attr = "";
         if (printkey.length())
         {
-          gOFS->_attr_get(foundit->first.c_str(), *mError, vid, (const char*) 0, printkey.c_str(), attr);
+          gOFS->_attr_get(dirpath.c_str(), *mError, vid, (const char*) 0, printkey.c_str(), attr);
           if (printkey.length())
           {
             if (!attr.length())
@@ -942,10 +854,10 @@ ProcCommand::Find ()
             unsigned long long childdirs = 0;
             try
             {
-              mCmd = gOFS->eosView->getContainer(foundit->first.c_str());
+              mCmd = gOFS->eosView->getContainer(dirpath.c_str());
               childfiles = mCmd->getNumFiles();
               childdirs = mCmd->getNumContainers();
-              fprintf(fstdout, "%s ndir=%llu nfiles=%llu\n", foundit->first.c_str(), childdirs, childfiles);
+              fprintf(fstdout, "%s ndir=%llu nfiles=%llu\n", dirpath.c_str(), childdirs, childfiles);
             }
             catch (eos::MDException &e)
             {
@@ -958,7 +870,7 @@ ProcCommand::Find ()
             {
 	      if (printxurl)
 		fprintf(fstdout,"%s", url.c_str());
-              fprintf(fstdout, "%s", foundit->first.c_str());
+              fprintf(fstdout, "%s", dirpath.c_str());
 
               if (printuid || printgid)
               {
@@ -966,7 +878,7 @@ ProcCommand::Find ()
 		std::shared_ptr<eos::IContainerMD> mCmd;
                 try
                 {
-                  mCmd = gOFS->eosView->getContainer(foundit->first.c_str());
+                  mCmd = gOFS->eosView->getContainer(dirpath.c_str());
 
                   if (printuid)
                   {
@@ -991,7 +903,7 @@ ProcCommand::Find ()
               XrdOucString lStdOut = "";
               XrdOucString lStdErr = "";
               XrdOucString info = "&mgm.cmd=fileinfo&mgm.path=";
-              info += foundit->first.c_str();
+              info += dirpath.c_str();
               info += "&mgm.file.info.option=-m";
               Cmd.open("/proc/user", info.c_str(), *pVid, mError);
               Cmd.AddOutput(lStdOut, lStdErr);
@@ -1002,18 +914,62 @@ ProcCommand::Find ()
             fprintf(fstdout, "\n");
           }
         }
-      }
       dircounter++;
-    }
-    if (deepquery)
+    };
+
+    FindFunctionVisitor visitor(
+      [&](const std::string& dirpath)
+    {
+      if (printdirs)
+      {
+        if (!printcounter)
+        {
+          if (printxurl)
+            fprintf(fstdout,"%s", url.c_str());
+          fprintf(fstdout, "%s\n", dirpath.c_str());
+        }
+        dircounter++;
+      }
+
+      if (listdirs)
+      {
+        processDir(dirpath);
+      }
+    },
+    [&](const std::string& dirpath, const std::vector<std::string>& names)
+    {
+      if (listfiles)
+      {
+        for (auto it = names.begin(); it != names.end(); ++it)
+        {
+          processFile(dirpath, *it);
+        }
+      }
+    },
+    [&]()
+    {
+      // a streamed result has been abandoned by the client
+      return mStream && mStream->IsCancelled();
+    });
+
+    if (gOFS->_find(spath.c_str(), *mError, stdErr, *pVid, visitor,
+                    key.c_str(), val.c_str(), nofiles, 0, true, finddepth, filematch.length()?filematch.c_str():0))
     {
-      globalfound->clear();
-      deepQueryMutex.UnLock();
+      fprintf(fstderr, "%s", stdErr.c_str());
+      fprintf(fstderr, "error: unable to run find in directory");
+      retc = errno;
+      return SFS_OK;
     }
     else
     {
-      delete found;
+      if (stdErr.length())
+      {
+        fprintf(fstderr,"%s", stdErr.c_str());
+        retc = E2BIG;
+      }
     }
+    gOFS->MgmStats.Add("FindEntries", pVid->uid, pVid->gid, cnt);
+
     if (printcounter)
     {
       fprintf(fstdout, "nfiles=%llu ndirectories=%llu\n", filecounter, dircounter);
@@ -88,7 +88,10 @@ ProcCommand::Fuse ()
     size_t dotend = 0;
     size_t dotstart = mResultStream.length();
 
-    while ((entry = inodir->nextEntry()))
+    uint64_t entry_id = 0;
+    bool entry_container = false;
+
+    while ((entry = inodir->nextEntry(entry_id, entry_container)))
     {
       bool isdot = false;
       bool isdotdot = false;
@@ -132,58 +135,17 @@ ProcCommand::Fuse ()
         mResultStream.insert(".. ", dotend);
       }
 
-      XrdOucString statpath = path;
-      statpath += "/";
-      statpath += entry;
-
-      eos::common::Path cPath(statpath.c_str());
-
-      // attach MD to get inode number
-      std::shared_ptr<eos::IFileMD> fmd;
-      std::shared_ptr<eos::IContainerMD> dir;
-      inode = 0;
-
-      //-------------------------------------------
-      {
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-        try
-        {
-          fmd = gOFS->eosView->getFile(cPath.GetPath(), false);
-          inode = fmd->getId() << 28;
-        }
-        catch (eos::MDException &e)
-        {
-          errno = e.getErrno();
-          eos_debug("caught exception %d %s\n", e.getErrno(), e.getMessage().str().c_str());
-        }
-      }
-      //-------------------------------------------
-
-      // check if that is a directory in case
-      if (!fmd)
-      {
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-        try
-        {
-          dir = gOFS->eosView->getContainer(cPath.GetPath(), false);
-          inode = dir->getId();
-        }
-        catch (eos::MDException &e)
-        {
-          dir = std::shared_ptr<IContainerMD>((IContainerMD*)0);
-          eos_debug("caught exception %d %s\n", e.getErrno(), e.getMessage().str().c_str());
-        }
-      }
+      // the listing provides id and type of the entry, no path lookup needed
+      inode = entry_container ? entry_id : (entry_id << 28);
       sprintf(inodestr, "%lld", inode);
       if ((!isdot) && (!isdotdot) && inode)
       {
         mResultStream += inodestr;
         mResultStream += " ";
-        if(statentries && (fmd || dir))
+        if(statentries)
         {
           struct stat buf;
-          std::string uri;
-          if(!gOFS->_stat(cPath.GetPath(), &buf, *mError, *pVid, (const char*) 0, 0, false, &uri))
+          if(!gOFS->_stat(entry_id, entry_container, &buf, *mError, *pVid))
           {
             char cbuf[1024];
             char* ss=cbuf;
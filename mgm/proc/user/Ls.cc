@@ -27,7 +27,9 @@
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "mgm/Access.hh"
 #include "mgm/Macros.hh"
-
+/*----------------------------------------------------------------------------*/
+#include <algorithm>
+#include <vector>
 /*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN
@@ -125,10 +127,17 @@ ProcCommand::Ls ()
       if (!listrc)
       {
         const char* val;
-        while ((ls_file.length() && (val = ls_file.c_str())) || (val = dir.nextEntry()))
+        uint64_t entry_id = 0;
+        bool entry_container = false;
+        // entries come in chunks without order, they are sorted by name
+        // here and an entry listed twice by a rehashed directory is dropped
+        std::vector<std::pair<std::string, std::string>> entries;
+        while ((ls_file.length() && (val = ls_file.c_str())) ||
+               (val = dir.nextEntry(entry_id, entry_container)))
         {
           // this return's a single file or a (filtered) directory list
           XrdOucString entryname = val;
+          XrdOucString entry_out = "";
           if (((option.find("a")) == STR_NPOS) && entryname.beginswith("."))
           {
             // quit if we list a hidden file without 'a' flag
@@ -144,8 +153,8 @@ ProcCommand::Ls ()
           }
           if ((((option.find("l")) == STR_NPOS)) && ((option.find("F")) == STR_NPOS))
           {
-            stdOut += val;
-            stdOut += "\n";
+            entry_out += val;
+            entry_out += "\n";
           }
           else
           {
@@ -182,7 +191,11 @@ ProcCommand::Ls ()
             {
             }
             struct stat buf;
-            if (gOFS->_stat(statpath.c_str(), &buf, *mError, *pVid, (const char*) 0, 0, false))
+            // listed entries are known by id, no need to resolve their path
+            int statrc = ls_file.length() ?
+              gOFS->_stat(statpath.c_str(), &buf, *mError, *pVid, (const char*) 0, 0, false) :
+              gOFS->_stat(entry_id, entry_container, &buf, *mError, *pVid);
+            if (statrc)
             {
               stdErr += "error: unable to stat path ";
               stdErr += statpath;
@@ -253,7 +266,7 @@ ProcCommand::Ls ()
                 bool isfile = (modestr[0] != 'd');
                 snprintf(sinode, 16, "%llu", (unsigned long long) (isfile ? (buf.st_ino >> 28) : buf.st_ino));
                 sprintf(lsline, "%-16s", sinode);
-                stdOut += lsline;
+                entry_out += lsline;
               }
 
 	      if ((option.find("h")) == STR_NPOS)
@@ -264,35 +277,43 @@ ProcCommand::Ls ()
 			suid.c_str(), sgid.c_str(), eos::common::StringConversion::GetReadableSizeString(sizestring, (unsigned long long) buf.st_size, ""), t_creat, val, dirmarker.c_str());
               if ((option.find("l")) != STR_NPOS)
 	      {
-                stdOut += lsline;
+                entry_out += lsline;
 		if (S_ISLNK(buf.st_mode)) 
 		{
-		  stdOut += " -> ";
+		  entry_out += " -> ";
 		  XrdOucString link;
 		  if (!gOFS->_readlink(statpath.c_str(), *mError, *pVid, link)) {
-		    stdOut += link.c_str();
+		    entry_out += link.c_str();
 		  } 
 		  else 
 		  {
-		    stdOut += "( error )\n";
+		    entry_out += "( error )\n";
 		  }
 		}
-		stdOut += "\n";
+		entry_out += "\n";
 	      }
               else
               {
-                stdOut += val;
-                stdOut += dirmarker;
-                stdOut += "\n";
+                entry_out += val;
+                entry_out += dirmarker;
+                entry_out += "\n";
               }
             }
           }
+          entries.push_back(std::make_pair(std::string(val), std::string(entry_out.c_str())));
           if (ls_file.length())
           {
             // this was a single file to be listed
             break;
           }
         }
+        std::sort(entries.begin(), entries.end());
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+          if ((it != entries.begin()) && (it->first == (it - 1)->first))
+            continue;
+          stdOut += it->second.c_str();
+        }
         if (!ls_file.length())
         {
           dir.close();
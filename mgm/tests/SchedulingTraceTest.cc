@@ -0,0 +1,256 @@
+//------------------------------------------------------------------------------
+//! @file SchedulingTraceTest.cc
+//! @author agent <agent@local>
+//! @brief Unit tests for the GeoTreeEngine scheduling traces
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "SchedulingTraceTest.hh"
+#include "mgm/geotree/SchedulingTrace.hh"
+#include "mgm/geotree/SchedulingTreeCommon.hh"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace eos::mgm;
+
+static const size_t gNbFs = 4;
+static const size_t gNbRequests = 10;
+
+//------------------------------------------------------------------------------
+// Build a placement or an access record
+//------------------------------------------------------------------------------
+static void
+MakeRequest(SchedulingTraceRecord& rec, uint8_t type, uint64_t timeUs)
+{
+  rec.Reset();
+  rec.type = type;
+  rec.timeUs = timeUs;
+  rec.group = "default.0";
+  rec.latencyUs = 10;
+
+  if (type == SchedulingTraceRecord::kPlacement) {
+    rec.schedType = 1; // regularRW
+    rec.nReplicas = 2;
+    rec.bookingSize = 1024;
+    rec.result.push_back(1);
+    rec.result.push_back(3);
+    rec.retCode = 1;
+  } else {
+    rec.schedType = 0; // regularRO
+    rec.nReplicas = 1;
+    rec.existingReplicas.push_back(2);
+    rec.existingReplicas.push_back(4);
+    rec.clientGeotag = "site1::rack1";
+    rec.result.push_back(2);
+    rec.retCode = 0;
+  }
+}
+
+void SchedulingTraceTest::setUp()
+{
+  char dir[] = "/tmp/eos-geosched-trace-XXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(dir));
+  mDir = dir;
+  mDir += "/";
+}
+
+void SchedulingTraceTest::tearDown()
+{
+  std::string cmd = "rm -rf " + mDir;
+  CPPUNIT_ASSERT(system(cmd.c_str()) == 0);
+}
+
+void SchedulingTraceTest::PathTest()
+{
+  std::string path;
+  CPPUNIT_ASSERT(SchedulingTraceWriter::BuildPath(mDir, "run1.trc", path));
+  CPPUNIT_ASSERT(path == mDir + "run1.trc");
+  CPPUNIT_ASSERT(SchedulingTraceWriter::BuildPath("/var/trace", "a..b", path));
+  CPPUNIT_ASSERT(path == "/var/trace/a..b");
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, "", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, ".", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, "..", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, "../run1.trc", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, "/etc/passwd", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath(mDir, "sub/run1.trc", path));
+  CPPUNIT_ASSERT(!SchedulingTraceWriter::BuildPath("", "run1.trc", path));
+}
+
+void SchedulingTraceTest::NoOverwriteTest()
+{
+  std::string path = mDir + "existing";
+  std::ofstream(path.c_str()) << "precious";
+  SchedulingTraceWriter writer;
+  CPPUNIT_ASSERT_EQUAL(EEXIST, writer.Open(path));
+  CPPUNIT_ASSERT(!writer.IsEnabled());
+  std::string link = mDir + "link";
+  CPPUNIT_ASSERT(symlink((mDir + "target").c_str(), link.c_str()) == 0);
+  CPPUNIT_ASSERT_EQUAL(EEXIST, writer.Open(link));
+  CPPUNIT_ASSERT(access((mDir + "target").c_str(), F_OK));
+  std::ifstream in(path.c_str());
+  std::string content;
+  in >> content;
+  CPPUNIT_ASSERT(content == "precious");
+  // a new file can be created but not reopened
+  CPPUNIT_ASSERT_EQUAL(0, writer.Open(mDir + "new"));
+  writer.Close();
+  CPPUNIT_ASSERT_EQUAL(EEXIST, writer.Open(mDir + "new"));
+}
+
+void SchedulingTraceTest::WriteReplayTest()
+{
+  std::string path;
+  CPPUNIT_ASSERT(SchedulingTraceWriter::BuildPath(mDir, "replay.trc", path));
+  SchedulingTraceWriter writer;
+  CPPUNIT_ASSERT_EQUAL(0, writer.Open(path));
+  CPPUNIT_ASSERT(writer.IsEnabled());
+  uint64_t now = SchedulingTraceWriter::Now();
+  SchedulingTraceRecord rec;
+
+  for (size_t i = 1; i <= gNbFs; i++) {
+    rec.Reset();
+    rec.type = SchedulingTraceRecord::kFsState;
+    rec.timeUs = now;
+    rec.fsId = i;
+    rec.group = "default.0";
+    rec.geotag = (i % 2) ? "site1::rack1" : "site1::rack2";
+    rec.host = "fst" + std::to_string((unsigned long long) i) + ".cern.ch";
+    rec.status = SchedTreeBase::Available | SchedTreeBase::Readable |
+                 SchedTreeBase::Writable;
+    rec.ulScore = 99;
+    rec.dlScore = 99;
+    rec.totalSpace = 1e12;
+    rec.fillRatio = 10;
+    writer.Write(rec);
+  }
+
+  for (size_t i = 0; i < gNbRequests; i++) {
+    MakeRequest(rec, SchedulingTraceRecord::kPlacement, now + 2 * i + 1);
+    writer.Write(rec);
+    MakeRequest(rec, SchedulingTraceRecord::kAccess, now + 2 * i + 2);
+    writer.Write(rec);
+  }
+
+  std::string statusPath;
+  unsigned long long records = 0;
+  writer.GetStatus(statusPath, records);
+  CPPUNIT_ASSERT(statusPath == path);
+  CPPUNIT_ASSERT_EQUAL((unsigned long long)(gNbFs + 2 * gNbRequests), records);
+  writer.Close();
+  // read the records back
+  SchedulingTraceReader reader;
+  CPPUNIT_ASSERT(reader.Open(path));
+  size_t nFs = 0, nPlct = 0, nAccess = 0;
+  SchedulingTraceRecord expected;
+
+  while (reader.Next(rec)) {
+    if (rec.type == SchedulingTraceRecord::kFsState) {
+      nFs++;
+      CPPUNIT_ASSERT_EQUAL((uint32_t) nFs, rec.fsId);
+      CPPUNIT_ASSERT(rec.group == "default.0");
+      CPPUNIT_ASSERT_EQUAL(99.0f, rec.ulScore);
+      CPPUNIT_ASSERT_EQUAL(1e12f, rec.totalSpace);
+      continue;
+    }
+
+    MakeRequest(expected, rec.type, rec.timeUs);
+    (rec.type == SchedulingTraceRecord::kPlacement) ? nPlct++ : nAccess++;
+    CPPUNIT_ASSERT(rec.group == expected.group);
+    CPPUNIT_ASSERT_EQUAL(expected.schedType, rec.schedType);
+    CPPUNIT_ASSERT_EQUAL(expected.nReplicas, rec.nReplicas);
+    CPPUNIT_ASSERT(rec.existingReplicas == expected.existingReplicas);
+    CPPUNIT_ASSERT_EQUAL(expected.bookingSize, rec.bookingSize);
+    CPPUNIT_ASSERT(rec.clientGeotag == expected.clientGeotag);
+    CPPUNIT_ASSERT(rec.result == expected.result);
+    CPPUNIT_ASSERT_EQUAL(expected.retCode, rec.retCode);
+    CPPUNIT_ASSERT_EQUAL(expected.latencyUs, rec.latencyUs);
+  }
+
+  CPPUNIT_ASSERT_EQUAL(gNbFs, nFs);
+  CPPUNIT_ASSERT_EQUAL(gNbRequests, nPlct);
+  CPPUNIT_ASSERT_EQUAL(gNbRequests, nAccess);
+  reader.Close();
+  // replay the trace and check every request is scheduled again
+  std::string decisions = mDir + "decisions";
+  std::string cmd = std::string(EOS_GEOSCHED_REPLAY_BIN) + " --decisions " +
+                    decisions + " " + path + " > " + mDir + "report";
+  CPPUNIT_ASSERT(system(cmd.c_str()) == 0);
+  std::ifstream report((mDir + "report").c_str());
+  std::stringstream out;
+  out << report.rdbuf();
+  CPPUNIT_ASSERT(out.str().find("filesystems           : 4") != std::string::npos);
+  CPPUNIT_ASSERT(out.str().find("skipped requests      : 0") != std::string::npos);
+  CPPUNIT_ASSERT(out.str().find("failed replayed       : 0") != std::string::npos);
+  std::ifstream in(decisions.c_str());
+  std::string kind, fsids;
+  int schedType;
+  nPlct = nAccess = 0;
+
+  while (in >> kind >> schedType >> fsids) {
+    if (kind == "plct") {
+      nPlct++;
+      CPPUNIT_ASSERT(fsids.find(',') != std::string::npos);
+    } else {
+      nAccess++;
+      CPPUNIT_ASSERT(fsids == "2" || fsids == "4");
+    }
+  }
+
+  CPPUNIT_ASSERT_EQUAL(gNbRequests, nPlct);
+  CPPUNIT_ASSERT_EQUAL(gNbRequests, nAccess);
+}
+
+void SchedulingTraceTest::CorruptTest()
+{
+  std::string path = mDir + "corrupt.trc";
+  SchedulingTraceWriter writer;
+  CPPUNIT_ASSERT_EQUAL(0, writer.Open(path));
+  SchedulingTraceRecord rec;
+  MakeRequest(rec, SchedulingTraceRecord::kPlacement, 1);
+  writer.Write(rec);
+  writer.Close();
+  // append a record header announcing 4 GB of payload
+  FILE* file = fopen(path.c_str(), "a");
+  CPPUNIT_ASSERT(file);
+  uint8_t type = SchedulingTraceRecord::kAccess;
+  uint32_t len = 0xffffffff;
+  CPPUNIT_ASSERT(fwrite(&type, sizeof(type), 1, file) == 1);
+  CPPUNIT_ASSERT(fwrite(&len, sizeof(len), 1, file) == 1);
+  fclose(file);
+  SchedulingTraceReader reader;
+  CPPUNIT_ASSERT(reader.Open(path));
+  CPPUNIT_ASSERT(reader.Next(rec));
+  CPPUNIT_ASSERT(!reader.Next(rec));
+  reader.Close();
+}
+
+int main(int argc, char** argv)
+{
+  CppUnit::TextUi::TestRunner runner;
+  CppUnit::TestFactoryRegistry& registry =
+    CppUnit::TestFactoryRegistry::getRegistry();
+  runner.addTest(registry.makeTest());
+  return runner.run() ? 0 : 1;
+}
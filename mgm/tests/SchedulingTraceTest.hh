@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+//! @file SchedulingTraceTest.hh
+//! @author agent <agent@local>
+//! @brief Unit tests for the GeoTreeEngine scheduling traces
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+#ifndef __EOSMGMTEST_SCHEDULINGTRACETEST_HH__
+#define __EOSMGMTEST_SCHEDULINGTRACETEST_HH__
+
+#include <string>
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class SchedulingTraceTest: public CppUnit::TestCase
+{
+private:
+  std::string mDir; ///< temporary trace directory
+
+public:
+  void setUp();
+  void tearDown();
+
+  CPPUNIT_TEST_SUITE(SchedulingTraceTest);
+  CPPUNIT_TEST(PathTest);
+  CPPUNIT_TEST(NoOverwriteTest);
+  CPPUNIT_TEST(WriteReplayTest);
+  CPPUNIT_TEST(CorruptTest);
+  CPPUNIT_TEST_SUITE_END();
+
+  //----------------------------------------------------------------------------
+  //! Trace names escaping the trace directory are rejected
+  //----------------------------------------------------------------------------
+  void PathTest();
+
+  //----------------------------------------------------------------------------
+  //! An existing file or a symlink is never opened for writing
+  //----------------------------------------------------------------------------
+  void NoOverwriteTest();
+
+  //----------------------------------------------------------------------------
+  //! Records read back match the written ones and the trace replays with
+  //! eos-geosched-replay
+  //----------------------------------------------------------------------------
+  void WriteReplayTest();
+
+  //----------------------------------------------------------------------------
+  //! A record length beyond the largest possible record ends the trace
+  //----------------------------------------------------------------------------
+  void CorruptTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SchedulingTraceTest);
+
+#endif // __EOSMGMTEST_SCHEDULINGTRACETEST_HH__
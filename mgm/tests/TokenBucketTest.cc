@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+//! @file TokenBucketTest.cc
+//! @author agent <agent@local>
+//! @brief Unit tests for the token buckets of the rate limiter
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "TokenBucketTest.hh"
+#include "mgm/TokenBucket.hh"
+
+using namespace eos::mgm;
+
+static const int64_t gStart = 1000000000; ///< arbitrary start time in us
+static const int64_t gSec = 1000000; ///< one second in us
+
+void TokenBucketTest::BurstTest()
+{
+  // 10 Hz with a burst of 50 tokens
+  TokenBucket bucket(10, 50, "rate:user:*:stat", gStart);
+  CPPUNIT_ASSERT_EQUAL(50.0, bucket.GetLevel());
+  CPPUNIT_ASSERT_EQUAL((int64_t) 50 * gSec, bucket.mCapacity);
+
+  // the whole burst is admitted at once
+  for (int i = 0; i < 50; ++i) {
+    CPPUNIT_ASSERT_EQUAL((int64_t) 0, bucket.DebtTime(gStart));
+    bucket.Take(1, gStart);
+  }
+
+  CPPUNIT_ASSERT_EQUAL(0.0, bucket.GetLevel());
+  CPPUNIT_ASSERT_EQUAL((int64_t) 0, bucket.DebtTime(gStart));
+  bucket.Take(1, gStart);
+  CPPUNIT_ASSERT(bucket.DebtTime(gStart) > 0);
+  // a long idle period does not refill above the capacity
+  CPPUNIT_ASSERT_EQUAL((int64_t) 0, bucket.DebtTime(gStart + 3600 * gSec));
+  CPPUNIT_ASSERT_EQUAL(50.0, bucket.GetLevel());
+  // a capacity below one token is raised to one token
+  TokenBucket slow(0.1, 0.5, "rate:user:*:stat", gStart);
+  CPPUNIT_ASSERT_EQUAL(1.0, slow.GetLevel());
+}
+
+void TokenBucketTest::RefillTest()
+{
+  TokenBucket bucket(10, 50, "rate:user:*:stat", gStart);
+  bucket.Take(50, gStart);
+  CPPUNIT_ASSERT_EQUAL(0.0, bucket.GetLevel());
+  // 10 tokens per second
+  bucket.Take(0, gStart + gSec);
+  CPPUNIT_ASSERT_EQUAL(10.0, bucket.GetLevel());
+  bucket.Take(0, gStart + gSec + gSec / 2);
+  CPPUNIT_ASSERT_EQUAL(15.0, bucket.GetLevel());
+  // time going backwards does not change the level
+  bucket.Take(0, gStart);
+  CPPUNIT_ASSERT_EQUAL(15.0, bucket.GetLevel());
+  // a debt is paid back at the same rate
+  bucket.Take(35, gStart + 2 * gSec);
+  CPPUNIT_ASSERT_EQUAL(-15.0, bucket.GetLevel());
+  bucket.Take(0, gStart + 3 * gSec);
+  CPPUNIT_ASSERT_EQUAL(-5.0, bucket.GetLevel());
+  bucket.Take(0, gStart + 4 * gSec);
+  CPPUNIT_ASSERT_EQUAL(5.0, bucket.GetLevel());
+}
+
+void TokenBucketTest::StallTimeTest()
+{
+  TokenBucket bucket(10, 50, "rate:user:*:stat", gStart);
+  // 20 tokens of debt take 2 seconds to be paid back
+  bucket.Take(70, gStart);
+  int64_t debt = bucket.DebtTime(gStart);
+  CPPUNIT_ASSERT(debt >= 2 * gSec);
+  CPPUNIT_ASSERT(debt <= 2 * gSec + 1);
+  // half a second later the remaining debt takes 1.5 seconds
+  debt = bucket.DebtTime(gStart + gSec / 2);
+  CPPUNIT_ASSERT(debt >= gSec + gSec / 2);
+  CPPUNIT_ASSERT(debt <= gSec + gSec / 2 + 1);
+  // no stall once the debt time has passed
+  CPPUNIT_ASSERT_EQUAL((int64_t) 0, bucket.DebtTime(gStart + 2 * gSec + 1));
+}
+
+int main(int argc, char** argv)
+{
+  CppUnit::TextUi::TestRunner runner;
+  CppUnit::TestFactoryRegistry& registry =
+    CppUnit::TestFactoryRegistry::getRegistry();
+  runner.addTest(registry.makeTest());
+  return runner.run() ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+//! @file TokenBucketTest.hh
+//! @author agent <agent@local>
+//! @brief Unit tests for the token buckets of the rate limiter
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+#ifndef __EOSMGMTEST_TOKENBUCKETTEST_HH__
+#define __EOSMGMTEST_TOKENBUCKETTEST_HH__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/TestAssert.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class TokenBucketTest: public CppUnit::TestCase
+{
+public:
+  CPPUNIT_TEST_SUITE(TokenBucketTest);
+  CPPUNIT_TEST(BurstTest);
+  CPPUNIT_TEST(RefillTest);
+  CPPUNIT_TEST(StallTimeTest);
+  CPPUNIT_TEST_SUITE_END();
+
+  //----------------------------------------------------------------------------
+  //! A full bucket admits its capacity, the level is capped at the capacity
+  //----------------------------------------------------------------------------
+  void BurstTest();
+
+  //----------------------------------------------------------------------------
+  //! The bucket refills at the configured rate, also out of debt
+  //----------------------------------------------------------------------------
+  void RefillTest();
+
+  //----------------------------------------------------------------------------
+  //! The debt time is the time needed to refill the debt
+  //----------------------------------------------------------------------------
+  void StallTimeTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenBucketTest);
+
+#endif // __EOSMGMTEST_TOKENBUCKETTEST_HH__
@@ -25,6 +25,7 @@
 #define __EOS_NS_ICHLOGFILEMDSVC_HH__
 
 #include "namespace/Namespace.hh"
+#include <stdint.h>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -91,6 +92,65 @@ public:
   //----------------------------------------------------------------------------
   virtual void compactCommit(void* comp_data, bool autorepair = false) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Prepare for incremental online compacting.
+  //!
+  //! Only creates the compacted log and marks the end of the changelog, the
+  //! records up to the mark being the snapshot to compact. No external file
+  //! metadata mutation may occur while the method is running.
+  //!
+  //! @param  newLogFileName name for the compacted log file
+  //! @return                compacting information that needs to be passed
+  //!                        to the other incremental compacting functions
+  //----------------------------------------------------------------------------
+  virtual void* compactPrepareIncremental(const std::string& newLogFileName)
+  const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Copy the records up to the last mark to the compacted log, the first
+  //! call copies the snapshot.
+  //!
+  //! This does not access any of the in-memory structures so any external
+  //! metadata operations (including mutations) may happen while it is
+  //! running. On failure the compacting information is released.
+  //!
+  //! @param  comp_data state information from compactPrepareIncremental
+  //! @return           number of changelog bytes processed
+  //----------------------------------------------------------------------------
+  virtual uint64_t compactCatchUp(void*& comp_data) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Move the mark to the current end of the changelog. No external file
+  //! metadata mutation may occur while the method is running.
+  //!
+  //! @param  comp_data state information from compactPrepareIncremental
+  //! @return           number of changelog bytes not copied yet
+  //----------------------------------------------------------------------------
+  virtual uint64_t compactMark(void* comp_data) const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Commit the incremental compacting.
+  //!
+  //! Copies the records appended since the last mark and switches to the
+  //! compacted log. Needs an exclusive lock on the namespace, the time it
+  //! takes only depends on the records appended since the last mark. The
+  //! in-memory log offsets are updated afterwards by compactRemap.
+  //!
+  //! @param comp_data state information from compactPrepareIncremental, it
+  //!                  is released in any case
+  //----------------------------------------------------------------------------
+  virtual void compactCommitIncremental(void* comp_data) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Update the in-memory log offsets after an incremental compacting. Needs
+  //! an exclusive lock on the namespace. No new compacting can be prepared
+  //! until all the offsets are updated.
+  //!
+  //! @param  batch maximum number of entries to update
+  //! @return       number of entries left
+  //----------------------------------------------------------------------------
+  virtual uint64_t compactRemap(uint64_t batch) = 0;
+
   //----------------------------------------------------------------------------
   //! Make transition from slave to master
   //!
@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <memory>
+#include <functional>
 #include <string>
 #include <map>
 #include <set>
@@ -318,6 +319,63 @@ class IContainerMD
   //----------------------------------------------------------------------------
   virtual std::set<std::string> getNameContainers() const = 0;
 
+  //----------------------------------------------------------------------------
+  //! Callback receiving the name and the id of an entry, returning false
+  //! stops the iteration
+  //----------------------------------------------------------------------------
+  typedef std::function<bool(const std::string&, uint64_t)> EntryVisitor;
+
+  //----------------------------------------------------------------------------
+  //! Visit the files contained in the current object without copying their
+  //! names. The order of the entries is not defined.
+  //!
+  //! @param visitor callback invoked for each file name and id
+  //----------------------------------------------------------------------------
+  virtual void visitFiles(const EntryVisitor& visitor) const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Visit the subcontainers of the current object without copying their
+  //! names. The order of the entries is not defined.
+  //!
+  //! @param visitor callback invoked for each subcontainer name and id
+  //----------------------------------------------------------------------------
+  virtual void visitContainers(const EntryVisitor& visitor) const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Position of a chunked listing of the current object. It is opaque to the
+  //! caller and has to be passed unchanged from one call to the next.
+  //----------------------------------------------------------------------------
+  struct ListCursor {
+    ListCursor(): inFiles(false), done(false), count(0), position(0),
+      layout(0) {}
+
+    bool inFiles; ///< subcontainers are done, listing the files
+    bool done; ///< all entries have been listed
+    uint64_t count; ///< number of entries listed from the current map
+    uint64_t position; ///< where to resume in the current map
+    uint64_t layout; ///< layout of the current map at the last call
+    std::string last; ///< last name listed from the current map
+  };
+
+  //----------------------------------------------------------------------------
+  //! Callback receiving the name, the id and the type of a listed entry
+  //----------------------------------------------------------------------------
+  typedef std::function<void(const std::string&, uint64_t, bool)> ListVisitor;
+
+  //----------------------------------------------------------------------------
+  //! List the next chunk of entries, the subcontainers first and then the
+  //! files. Like for readdir, entries added or removed while a listing is in
+  //! progress may or may not be returned. If the name maps of the container
+  //! are rehashed meanwhile, an entry may also be returned twice or missed.
+  //!
+  //! @param cursor listing position, updated by the call
+  //! @param max max. number of entries to list
+  //! @param visitor callback invoked for each entry with its name, id and
+  //!        true if it is a subcontainer
+  //----------------------------------------------------------------------------
+  virtual void listEntries(ListCursor& cursor, size_t max,
+                           const ListVisitor& visitor) const = 0;
+
  private:
 
   //----------------------------------------------------------------------------
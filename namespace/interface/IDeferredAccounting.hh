@@ -0,0 +1,79 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @author agent <agent@local>
+//! @brief Interface of accounting listeners able to defer their propagation
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_IDEFERRED_ACCOUNTING_HH
+#define EOS_NS_IDEFERRED_ACCOUNTING_HH
+
+#include "namespace/Namespace.hh"
+#include <stdint.h>
+
+EOSNSNAMESPACE_BEGIN
+
+//! Forward declaration
+class LockHandler;
+
+//------------------------------------------------------------------------------
+//! Accounting listeners implementing this interface can record the changes
+//! they receive and propagate them up the hierarchy from a background thread
+//! instead of walking to the root for every change.
+//------------------------------------------------------------------------------
+class IDeferredAccounting
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~IDeferredAccounting() {}
+
+  //----------------------------------------------------------------------------
+  //! Switch to deferred propagation. The recorded changes are applied every
+  //! interval under the write lock of the namespace.
+  //!
+  //! @param ns_lock namespace lock handler
+  //! @param interval_ms propagation interval in milliseconds, 0 switches
+  //!        back to synchronous propagation
+  //----------------------------------------------------------------------------
+  virtual void setDeferred(LockHandler* ns_lock, uint32_t interval_ms) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Stop the background propagation and apply the pending changes. This
+  //! takes the namespace lock so it must not be called while holding it.
+  //----------------------------------------------------------------------------
+  virtual void stopDeferred() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get the propagation lag
+  //!
+  //! @param pending number of containers with pending changes
+  //! @param lag_ms age of the oldest pending change in milliseconds
+  //! @param last_ms duration of the last propagation in milliseconds
+  //!
+  //! @return false if the propagation is not deferred, otherwise true
+  //----------------------------------------------------------------------------
+  virtual bool getDeferredLag(uint64_t& pending, uint64_t& lag_ms,
+                              uint64_t& last_ms) = 0;
+};
+
+EOSNSNAMESPACE_END
+
+#endif
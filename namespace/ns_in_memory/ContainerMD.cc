@@ -26,9 +26,44 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include <sys/stat.h>
+#include <atomic>
 
 EOSNSNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Source of the layout stamps of the name maps, unique across all containers
+//------------------------------------------------------------------------------
+static std::atomic<uint64_t> sLayoutStamp(0);
+
+//------------------------------------------------------------------------------
+// Start of the bucket array of a name map, the sparsehash iterators expose
+// their bucket pointer
+//------------------------------------------------------------------------------
+template <typename Map>
+static inline const typename Map::value_type*
+MapTable(const Map& map)
+{
+  return map.end().pos - map.bucket_count();
+}
+
+//------------------------------------------------------------------------------
+// Insert or update a name. The map allocates a new bucket array while the old
+// one is still in use when it gets rehashed, so a moved array means the
+// positions of the entries changed and the map gets a new layout stamp.
+//------------------------------------------------------------------------------
+template <typename Map>
+static void
+InsertName(Map& map, uint64_t& layout, const std::string& name,
+           typename Map::mapped_type id)
+{
+  const typename Map::value_type* table = MapTable(map);
+  map[name] = id;
+
+  if (MapTable(map) != table) {
+    layout = ++sLayoutStamp;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -48,6 +83,8 @@ ContainerMD::ContainerMD(id_t id, IFileMDSvc* file_svc,
   pFiles.set_deleted_key("");
   pSubContainers.set_empty_key("##_EMPTY_##");
   pFiles.set_empty_key("##_EMPTY_##");
+  pSubContainersLayout = ++sLayoutStamp;
+  pFilesLayout = ++sLayoutStamp;
 }
 
 //------------------------------------------------------------------------------
@@ -71,7 +108,8 @@ ContainerMD::clone() const
 //------------------------------------------------------------------------------
 // Copy constructor
 //------------------------------------------------------------------------------
-ContainerMD::ContainerMD(const ContainerMD& other)
+ContainerMD::ContainerMD(const ContainerMD& other):
+  pSubContainersLayout(++sLayoutStamp), pFilesLayout(++sLayoutStamp)
 {
   *this = other;
 }
@@ -130,7 +168,8 @@ void
 ContainerMD::addContainer(IContainerMD* container)
 {
   container->setParentId(pId);
-  pSubContainers[container->getName()] = container->getId();
+  InsertName(pSubContainers, pSubContainersLayout, container->getName(),
+             container->getId());
 }
 
 //------------------------------------------------------------------------------
@@ -155,7 +194,7 @@ void
 ContainerMD::addFile(IFileMD* file)
 {
   file->setContainerId(pId);
-  pFiles[file->getName()] = file->getId();
+  InsertName(pFiles, pFilesLayout, file->getName(), file->getId());
   IFileMDChangeListener::Event e(file, IFileMDChangeListener::SizeChange,
                                  0, 0, file->getSize());
   file->getFileMDSvc()->notifyListeners(&e);
@@ -457,6 +496,94 @@ ContainerMD::getNameContainers() const
   return dnames;
 }
 
+//------------------------------------------------------------------------------
+// Visit the files contained in the current object
+//------------------------------------------------------------------------------
+void
+ContainerMD::visitFiles(const EntryVisitor& visitor) const
+{
+  for (auto it = pFiles.begin(); it != pFiles.end(); ++it) {
+    if (!visitor(it->first, it->second)) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Visit the subcontainers of the current object
+//------------------------------------------------------------------------------
+void
+ContainerMD::visitContainers(const EntryVisitor& visitor) const
+{
+  for (auto it = pSubContainers.begin(); it != pSubContainers.end(); ++it) {
+    if (!visitor(it->first, it->second)) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// List the next chunk of a name map. The hash map has no order, a call
+// resumes at the bucket following the last listed entry as long as the map
+// has not been rehashed, otherwise by counting the entries listed so far.
+//
+// @return true if the end of the map has been reached
+//------------------------------------------------------------------------------
+template <typename Map>
+static bool
+ListMapChunk(const Map& map, uint64_t layout, IContainerMD::ListCursor& cursor,
+             size_t& max, const IContainerMD::ListVisitor& visitor,
+             bool container)
+{
+  const typename Map::value_type* table = MapTable(map);
+  typename Map::const_iterator end = map.end();
+  typename Map::const_iterator it = map.begin();
+
+  if (cursor.count) {
+    if (cursor.layout == layout) {
+      // entries removed meanwhile leave a deleted bucket, which is skipped
+      it = typename Map::const_iterator(end.ht, table + cursor.position,
+                                        end.end, true);
+    } else {
+      for (uint64_t i = 0; (i < cursor.count) && (it != end); ++i) {
+        ++it;
+      }
+    }
+  }
+
+  for (; (it != end) && max; ++it, --max) {
+    visitor(it->first, it->second, container);
+    cursor.count++;
+  }
+
+  cursor.layout = layout;
+  cursor.position = it.pos - table;
+  return (it == end);
+}
+
+//------------------------------------------------------------------------------
+// List the next chunk of entries
+//------------------------------------------------------------------------------
+void
+ContainerMD::listEntries(ListCursor& cursor, size_t max,
+                         const ListVisitor& visitor) const
+{
+  if (!cursor.inFiles) {
+    if (!ListMapChunk(pSubContainers, pSubContainersLayout, cursor, max,
+                      visitor, true)) {
+      return;
+    }
+
+    cursor = ListCursor();
+    cursor.inFiles = true;
+  }
+
+  if (!cursor.done &&
+      ListMapChunk(pFiles, pFilesLayout, cursor, max, visitor, false)) {
+    cursor.done = true;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Set modification time
 //------------------------------------------------------------------------------
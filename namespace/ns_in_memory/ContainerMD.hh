@@ -481,6 +481,22 @@ class ContainerMD: public IContainerMD
   //----------------------------------------------------------------------------
   std::set<std::string> getNameContainers() const;
 
+  //----------------------------------------------------------------------------
+  //! Visit the files contained in the current object
+  //----------------------------------------------------------------------------
+  void visitFiles(const EntryVisitor& visitor) const;
+
+  //----------------------------------------------------------------------------
+  //! Visit the subcontainers of the current object
+  //----------------------------------------------------------------------------
+  void visitContainers(const EntryVisitor& visitor) const;
+
+  //----------------------------------------------------------------------------
+  //! List the next chunk of entries
+  //----------------------------------------------------------------------------
+  void listEntries(ListCursor& cursor, size_t max,
+                   const ListVisitor& visitor) const;
+
   //----------------------------------------------------------------------------
   //! Serialize the object to a buffer
   //----------------------------------------------------------------------------
@@ -510,6 +526,8 @@ class ContainerMD: public IContainerMD
   mtime_t      pMTime;
   tmtime_t     pTMTime;
   uint64_t     pTreeSize;
+  uint64_t     pSubContainersLayout; ///< changes when pSubContainers is rehashed
+  uint64_t     pFilesLayout; ///< changes when pFiles is rehashed
 
   IFileMDSvc* pFileSvc; ///< File metadata service
   IContainerMDSvc* pContSvc; ///< Container metadata service
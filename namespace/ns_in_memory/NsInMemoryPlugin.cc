@@ -249,7 +249,7 @@ NsInMemoryPlugin::DestroySyncTimeAcc(void* obj)
   if (!obj)
     return -1;
 
-  delete static_cast<FileSystemView*>(obj);
+  delete static_cast<SyncTimeAccounting*>(obj);
   return 0;
 }
 
@@ -29,6 +29,14 @@ ContainerAccounting::ContainerAccounting(IContainerMDSvc* svc) :
 {
 }
 
+//----------------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------------
+ContainerAccounting::~ContainerAccounting()
+{
+  stopDeferred();
+}
+
 //----------------------------------------------------------------------------
 // Notify the me about the changes in the main view
 //----------------------------------------------------------------------------
@@ -76,6 +84,9 @@ void ContainerAccounting::Account(IFileMD* obj , int64_t dsize)
 
   ContainerMD::id_t iId = obj->getContainerId();
 
+  if (Defer(iId, dsize))
+    return;
+
   while ((iId > 1) && (deepness < 255))
   {
     std::shared_ptr<IContainerMD> iCont;
@@ -110,6 +121,9 @@ void ContainerAccounting::AddTree( IContainerMD* obj , int64_t dsize )
 
   ContainerMD::id_t iId = obj->getId();
 
+  if (Defer(iId, dsize))
+    return;
+
   while ( (iId > 1 ) && (deepness < 255) )
   {
     std::shared_ptr<IContainerMD> iCont;
@@ -136,4 +150,103 @@ void ContainerAccounting::RemoveTree( IContainerMD* obj , int64_t dsize )
   AddTree(obj, -dsize);
 }
 
+//------------------------------------------------------------------------------
+// Forward the pending size change of a removed container to its parent
+//------------------------------------------------------------------------------
+void ContainerAccounting::RemoveContainer(IContainerMD* obj)
+{
+  if (!obj)
+    return;
+
+  std::lock_guard<std::mutex> lock(mBatchMutex);
+  auto it = mBatch.find(obj->getId());
+
+  if (it == mBatch.end())
+    return;
+
+  int64_t dsize = it->second;
+  mBatch.erase(it);
+
+  if ((obj->getParentId() > 1) && dsize)
+    mBatch[obj->getParentId()] += dsize;
+}
+
+//------------------------------------------------------------------------------
+// Record a size change in deferred mode
+//------------------------------------------------------------------------------
+bool ContainerAccounting::Defer(IContainerMD::id_t id, int64_t dsize)
+{
+  std::lock_guard<std::mutex> lock(mBatchMutex);
+
+  if (!mDeferred)
+    return false;
+
+  if ((id > 1) && dsize)
+  {
+    mBatch[id] += dsize;
+    markPending();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Move the recorded changes to the batch to apply
+//------------------------------------------------------------------------------
+size_t ContainerAccounting::swapBatch()
+{
+  mApply.clear();
+  mApply.swap(mBatch);
+  return mApply.size();
+}
+
+//------------------------------------------------------------------------------
+// Number of containers with recorded changes
+//------------------------------------------------------------------------------
+size_t ContainerAccounting::pendingBatch()
+{
+  return mBatch.size();
+}
+
+//------------------------------------------------------------------------------
+// Apply the swapped batch level by level: every container of the current
+// level is updated once and its delta is merged into the one of its parent
+//------------------------------------------------------------------------------
+void ContainerAccounting::applyBatch()
+{
+  std::unordered_map<IContainerMD::id_t, int64_t> next;
+  size_t deepness = 0;
+
+  while (!mApply.empty() && (deepness < 255))
+  {
+    for (auto it = mApply.begin(); it != mApply.end(); ++it)
+    {
+      if ((it->first <= 1) || !it->second)
+        continue;
+
+      std::shared_ptr<IContainerMD> iCont;
+
+      try
+      {
+        iCont = pContainerMDSvc->getContainerMD(it->first);
+      }
+      catch (MDException& e)
+      {
+      }
+
+      if (!iCont)
+        continue;
+
+      iCont->addTreeSize(it->second);
+      next[iCont->getParentId()] += it->second;
+    }
+
+    mApply.swap(next);
+    next.clear();
+    deepness++;
+  }
+
+  mApply.clear();
+}
+
 EOSNSNAMESPACE_END
@@ -28,18 +28,26 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/ns_in_memory/ContainerMD.hh"
 #include "namespace/ns_in_memory/FileMD.hh"
+#include "namespace/ns_in_memory/accounting/DeferredAccounting.hh"
 #include "namespace/MDException.hh"
 #include "namespace/Namespace.hh"
 #include <utility>
 #include <list>
 #include <deque>
+#include <unordered_map>
 
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Container subtree accounting listener
+//!
+//! By default a change is propagated synchronously up to the root. In
+//! deferred mode (see IDeferredAccounting) the size changes are summed per
+//! container and applied level by level from a background thread, so that N
+//! changes below the same ancestor cost a single update of that ancestor.
 //------------------------------------------------------------------------------
-class ContainerAccounting : public IFileMDChangeListener
+class ContainerAccounting : public IFileMDChangeListener,
+  public DeferredAccounting
 {
  public:
 
@@ -51,7 +59,7 @@ class ContainerAccounting : public IFileMDChangeListener
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  virtual ~ContainerAccounting() {}
+  virtual ~ContainerAccounting();
 
   //----------------------------------------------------------------------------
   //! Notify me about the changes in the main view
@@ -83,9 +91,21 @@ class ContainerAccounting : public IFileMDChangeListener
   //----------------------------------------------------------------------------
   void RemoveTree( IContainerMD* obj , int64_t dsize );
 
+  //----------------------------------------------------------------------------
+  //! Container is removed from the store - in deferred mode its pending size
+  //! change is moved to its parent so that the ancestors still receive it
+  //!
+  //! @param obj container being removed
+  //----------------------------------------------------------------------------
+  void RemoveContainer(IContainerMD* obj);
+
  private:
 
   IContainerMDSvc* pContainerMDSvc; ///< container MD service
+  //! Size changes recorded per container in deferred mode
+  std::unordered_map<IContainerMD::id_t, int64_t> mBatch;
+  //! Size changes being applied
+  std::unordered_map<IContainerMD::id_t, int64_t> mApply;
 
   //----------------------------------------------------------------------------
   //! Account a file in the respective container
@@ -94,6 +114,21 @@ class ContainerAccounting : public IFileMDChangeListener
   //! @param dsize size change
   //----------------------------------------------------------------------------
   void Account(IFileMD* obj , int64_t dsize);
+
+  //----------------------------------------------------------------------------
+  //! Record a size change of a container subtree in deferred mode
+  //!
+  //! @return false if not in deferred mode, the change has to be propagated
+  //!         synchronously
+  //----------------------------------------------------------------------------
+  bool Defer(IContainerMD::id_t id, int64_t dsize);
+
+  //----------------------------------------------------------------------------
+  //! DeferredAccounting interface
+  //----------------------------------------------------------------------------
+  virtual size_t swapBatch();
+  virtual size_t pendingBatch();
+  virtual void applyBatch();
 };
 
 EOSNSNAMESPACE_END
@@ -0,0 +1,140 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_in_memory/accounting/DeferredAccounting.hh"
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+DeferredAccounting::DeferredAccounting() :
+  mDeferred(false), mNsLock(0), mIntervalMs(0), mOldestPending(0),
+  mLastApplyMs(0), mStop(false)
+{}
+
+//------------------------------------------------------------------------------
+// Switch to deferred propagation
+//------------------------------------------------------------------------------
+void DeferredAccounting::setDeferred(LockHandler* ns_lock, uint32_t interval_ms)
+{
+  if (!ns_lock || !interval_ms) {
+    stopDeferred();
+    return;
+  }
+
+  mIntervalMs = interval_ms;
+
+  if (mThread.joinable()) {
+    // Already running, only the interval changes
+    return;
+  }
+
+  mNsLock = ns_lock;
+  {
+    std::lock_guard<std::mutex> lock(mThreadMutex);
+    mStop = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mBatchMutex);
+    mDeferred = true;
+  }
+  mThread = std::thread(&DeferredAccounting::run, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop the background propagation and apply the pending changes
+//------------------------------------------------------------------------------
+void DeferredAccounting::stopDeferred()
+{
+  {
+    // From now on the changes are propagated synchronously
+    std::lock_guard<std::mutex> lock(mBatchMutex);
+    mDeferred = false;
+  }
+
+  if (!mThread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mThreadMutex);
+    mStop = true;
+  }
+  mThreadCond.notify_all();
+  mThread.join();
+  // Apply what was recorded before switching back
+  flush();
+}
+
+//------------------------------------------------------------------------------
+// Get the propagation lag
+//------------------------------------------------------------------------------
+bool DeferredAccounting::getDeferredLag(uint64_t& pending, uint64_t& lag_ms,
+                                        uint64_t& last_ms)
+{
+  std::lock_guard<std::mutex> lock(mBatchMutex);
+  pending = pendingBatch();
+  lag_ms = (pending && mOldestPending) ? (nowMs() - mOldestPending) : 0;
+  last_ms = mLastApplyMs;
+  return mDeferred;
+}
+
+//------------------------------------------------------------------------------
+// Propagation thread loop
+//------------------------------------------------------------------------------
+void DeferredAccounting::run()
+{
+  std::unique_lock<std::mutex> lock(mThreadMutex);
+
+  while (!mStop) {
+    mThreadCond.wait_for(lock, std::chrono::milliseconds(mIntervalMs.load()));
+
+    if (mStop) {
+      break;
+    }
+
+    lock.unlock();
+    flush();
+    lock.lock();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply the recorded changes
+//------------------------------------------------------------------------------
+void DeferredAccounting::flush()
+{
+  {
+    std::lock_guard<std::mutex> lock(mBatchMutex);
+    size_t n = swapBatch();
+    mOldestPending = 0;
+
+    if (!n) {
+      return;
+    }
+  }
+
+  uint64_t start = nowMs();
+  mNsLock->writeLock();
+  applyBatch();
+  mNsLock->unLock();
+  mLastApplyMs = nowMs() - start;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,143 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @author agent <agent@local>
+//! @brief Background propagation of coalesced accounting changes
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_DEFERRED_ACCOUNTING_HH
+#define EOS_NS_DEFERRED_ACCOUNTING_HH
+
+#include "namespace/interface/IDeferredAccounting.hh"
+#include "namespace/utils/Locking.hh"
+#include "namespace/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Common part of the deferred accounting listeners. The listener records the
+//! changes in a batch while holding mBatchMutex; a background thread swaps the
+//! batch out every interval and applies it under the namespace write lock.
+//!
+//! Lock order: namespace lock -> mBatchMutex. The batch mutex is never held
+//! while taking the namespace lock.
+//!
+//! Derived classes must call stopDeferred in their destructor.
+//------------------------------------------------------------------------------
+class DeferredAccounting : public IDeferredAccounting
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  DeferredAccounting();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~DeferredAccounting() {}
+
+  //----------------------------------------------------------------------------
+  //! Switch to deferred propagation
+  //----------------------------------------------------------------------------
+  virtual void setDeferred(LockHandler* ns_lock, uint32_t interval_ms);
+
+  //----------------------------------------------------------------------------
+  //! Stop the background propagation and apply the pending changes
+  //----------------------------------------------------------------------------
+  virtual void stopDeferred();
+
+  //----------------------------------------------------------------------------
+  //! Get the propagation lag
+  //----------------------------------------------------------------------------
+  virtual bool getDeferredLag(uint64_t& pending, uint64_t& lag_ms,
+                              uint64_t& last_ms);
+
+protected:
+  //! Protects the recorded batch and mDeferred
+  std::mutex mBatchMutex;
+  //! Changes are recorded instead of propagated - only change under
+  //! mBatchMutex
+  bool mDeferred;
+
+  //----------------------------------------------------------------------------
+  //! Remember the time of the first change of a batch - mBatchMutex held
+  //----------------------------------------------------------------------------
+  inline void markPending()
+  {
+    if (!mOldestPending) {
+      mOldestPending = nowMs();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move the recorded changes to the batch to apply - mBatchMutex held
+  //!
+  //! @return number of containers moved
+  //----------------------------------------------------------------------------
+  virtual size_t swapBatch() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Number of containers with recorded changes - mBatchMutex held
+  //----------------------------------------------------------------------------
+  virtual size_t pendingBatch() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Apply the swapped batch - namespace write lock held
+  //----------------------------------------------------------------------------
+  virtual void applyBatch() = 0;
+
+private:
+  LockHandler* mNsLock; ///< namespace lock taken to apply a batch
+  std::atomic<uint32_t> mIntervalMs; ///< propagation interval
+  uint64_t mOldestPending; ///< time of the oldest recorded change
+  std::atomic<uint64_t> mLastApplyMs; ///< duration of the last propagation
+  std::thread mThread; ///< propagation thread
+  std::mutex mThreadMutex;
+  std::condition_variable mThreadCond;
+  bool mStop; ///< stop the propagation thread - under mThreadMutex
+
+  //----------------------------------------------------------------------------
+  //! Propagation thread loop
+  //----------------------------------------------------------------------------
+  void run();
+
+  //----------------------------------------------------------------------------
+  //! Apply the recorded changes, takes the namespace write lock
+  //----------------------------------------------------------------------------
+  void flush();
+
+  //----------------------------------------------------------------------------
+  //! Monotonic time in milliseconds
+  //----------------------------------------------------------------------------
+  static inline uint64_t nowMs()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+           (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+};
+
+EOSNSNAMESPACE_END
+
+#endif
@@ -28,6 +28,14 @@ SyncTimeAccounting::SyncTimeAccounting(IContainerMDSvc* svc) :
     pContainerMDSvc(svc)
 {}
 
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+SyncTimeAccounting::~SyncTimeAccounting()
+{
+  stopDeferred();
+}
+
 //------------------------------------------------------------------------------
 // Notify the me about the changes in the main view
 //------------------------------------------------------------------------------
@@ -37,8 +45,20 @@ void SyncTimeAccounting::containerMDChanged(IContainerMD* obj, Action type)
   {
     // MTime change
     case IContainerMDChangeListener::MTimeChange:
+    {
+      std::unique_lock<std::mutex> lock(mBatchMutex);
+
+      if (mDeferred)
+      {
+        mBatch.insert(obj->getId());
+        markPending();
+        break;
+      }
+
+      lock.unlock();
       Propagate(obj->getId());
       break;
+    }
 
     default:
       break;
@@ -89,4 +109,33 @@ void SyncTimeAccounting::Propagate(IContainerMD::id_t id)
   }
 }
 
+//------------------------------------------------------------------------------
+// Move the recorded changes to the batch to apply
+//------------------------------------------------------------------------------
+size_t SyncTimeAccounting::swapBatch()
+{
+  mApply.clear();
+  mApply.swap(mBatch);
+  return mApply.size();
+}
+
+//------------------------------------------------------------------------------
+// Number of containers with recorded changes
+//------------------------------------------------------------------------------
+size_t SyncTimeAccounting::pendingBatch()
+{
+  return mBatch.size();
+}
+
+//------------------------------------------------------------------------------
+// Apply the swapped batch, the mtime of each container is taken at this point
+//------------------------------------------------------------------------------
+void SyncTimeAccounting::applyBatch()
+{
+  for (auto it = mApply.begin(); it != mApply.end(); ++it)
+    Propagate(*it);
+
+  mApply.clear();
+}
+
 EOSNSNAMESPACE_END
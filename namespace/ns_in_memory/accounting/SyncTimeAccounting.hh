@@ -24,16 +24,23 @@
 #ifndef EOS_NS_SYNCTIME_ACCOUNTING_HH
 #define EOS_NS_SYNCTIME_ACCOUNTING_HH
 #include "namespace/interface/IContainerMDSvc.hh"
-#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/ns_in_memory/accounting/DeferredAccounting.hh"
 #include "namespace/MDException.hh"
 #include "namespace/Namespace.hh"
+#include <unordered_set>
 
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Synchronous mtime propagation listener
+//!
+//! In deferred mode (see IDeferredAccounting) the changed containers are
+//! collected in a set and propagated from a background thread. Several
+//! changes of the same container are propagated once and the walks of
+//! siblings stop at the first ancestor already updated.
 //------------------------------------------------------------------------------
-class SyncTimeAccounting : public IContainerMDChangeListener
+class SyncTimeAccounting : public IContainerMDChangeListener,
+  public DeferredAccounting
 {
  public:
 
@@ -45,7 +52,7 @@ class SyncTimeAccounting : public IContainerMDChangeListener
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  virtual ~SyncTimeAccounting() { }
+  virtual ~SyncTimeAccounting();
 
   //----------------------------------------------------------------------------
   //! Notify me about the changes in the main view
@@ -54,6 +61,8 @@ class SyncTimeAccounting : public IContainerMDChangeListener
 
  private:
   IContainerMDSvc* pContainerMDSvc;
+  std::unordered_set<IContainerMD::id_t> mBatch; ///< changed containers
+  std::unordered_set<IContainerMD::id_t> mApply; ///< containers being applied
 
   //----------------------------------------------------------------------------
   //! Propagate a container change
@@ -61,6 +70,13 @@ class SyncTimeAccounting : public IContainerMDChangeListener
   //! @param id container id
   //----------------------------------------------------------------------------
   void Propagate(IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! DeferredAccounting interface
+  //----------------------------------------------------------------------------
+  virtual size_t swapBatch();
+  virtual size_t pendingBatch();
+  virtual void applyBatch();
 };
 
 EOSNSNAMESPACE_END
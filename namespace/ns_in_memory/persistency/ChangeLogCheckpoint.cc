@@ -0,0 +1,782 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_in_memory/persistency/ChangeLogCheckpoint.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
+#include "namespace/utils/Buffer.hh"
+#include "namespace/utils/DataHelper.hh"
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//! Size of the serialized image header
+const size_t kHeaderSize = 52;
+//! Size of the serialized entry header
+const size_t kEntrySize = 20;
+
+typedef std::vector<std::pair<uint64_t, uint64_t>> RecordList;
+
+//------------------------------------------------------------------------------
+// Strip the directory part of a path
+//------------------------------------------------------------------------------
+std::string baseName(const std::string& path)
+{
+  return path.substr(path.rfind('/') + 1);
+}
+
+//------------------------------------------------------------------------------
+// Serialize/deserialize the image header
+//------------------------------------------------------------------------------
+void encodeHeader(const ChangeLogCheckpoint::Info& info, char* buf)
+{
+  uint32_t magic = ChangeLogCheckpoint::kMagic;
+  memcpy(buf, &magic, 4);
+  memcpy(buf + 4, &info.version, 2);
+  memcpy(buf + 6, &info.contentFlag, 2);
+  memcpy(buf + 8, &info.coveredOffset, 8);
+  memcpy(buf + 16, &info.lastOffset, 8);
+  memcpy(buf + 24, &info.lastCrc, 4);
+  memcpy(buf + 28, &info.largestId, 8);
+  memcpy(buf + 36, &info.numEntries, 8);
+  memcpy(buf + 44, &info.ctime, 8);
+}
+
+bool decodeHeader(const char* buf, ChangeLogCheckpoint::Info& info)
+{
+  uint32_t magic;
+  memcpy(&magic, buf, 4);
+  memcpy(&info.version, buf + 4, 2);
+  memcpy(&info.contentFlag, buf + 6, 2);
+  memcpy(&info.coveredOffset, buf + 8, 8);
+  memcpy(&info.lastOffset, buf + 16, 8);
+  memcpy(&info.lastCrc, buf + 24, 4);
+  memcpy(&info.largestId, buf + 28, 8);
+  memcpy(&info.numEntries, buf + 36, 8);
+  memcpy(&info.ctime, buf + 44, 8);
+  return (magic == ChangeLogCheckpoint::kMagic);
+}
+
+//------------------------------------------------------------------------------
+// Sequential image reader
+//------------------------------------------------------------------------------
+class ImageReader
+{
+public:
+  ImageReader(): pFile(0), pCrc(0), pRead(0), pLastId(0) {}
+
+  ~ImageReader()
+  {
+    if (pFile) {
+      fclose(pFile);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Open the image and read the header, false if it does not exist
+  //----------------------------------------------------------------------------
+  bool open(const std::string& name)
+  {
+    pName = name;
+    pFile = fopen(name.c_str(), "r");
+
+    if (!pFile) {
+      if (errno == ENOENT) {
+        return false;
+      }
+
+      MDException e(errno);
+      e.getMessage() << "Checkpoint: unable to open " << name << ": ";
+      e.getMessage() << strerror(errno);
+      throw e;
+    }
+
+    char buf[kHeaderSize];
+
+    if (fread(buf, kHeaderSize, 1, pFile) != 1 || !decodeHeader(buf, pInfo)) {
+      MDException e(EFAULT);
+      e.getMessage() << "Checkpoint: " << name << " is not a checkpoint image";
+      throw e;
+    }
+
+    if (pInfo.version != ChangeLogCheckpoint::kVersion) {
+      MDException e(EFAULT);
+      e.getMessage() << "Checkpoint: unsupported version " << pInfo.version;
+      e.getMessage() << " of " << name;
+      throw e;
+    }
+
+    pCrc = DataHelper::computeCRC32(0, 0);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Read the next entry, false after the last one once the trailer has been
+  // checked
+  //----------------------------------------------------------------------------
+  bool next(uint64_t& id, uint64_t& offset, Buffer& data)
+  {
+    if (pRead == pInfo.numEntries) {
+      uint32_t trailer[2];
+
+      if (fread(trailer, sizeof(trailer), 1, pFile) != 1 ||
+          trailer[1] != ChangeLogCheckpoint::kMagic) {
+        fail("missing trailer");
+      }
+
+      if (trailer[0] != pCrc) {
+        fail("checksum mismatch");
+      }
+
+      return false;
+    }
+
+    char buf[kEntrySize];
+    uint32_t size;
+
+    if (fread(buf, kEntrySize, 1, pFile) != 1) {
+      fail("truncated entry");
+    }
+
+    memcpy(&id, buf, 8);
+    memcpy(&offset, buf + 8, 8);
+    memcpy(&size, buf + 16, 4);
+
+    if (size < sizeof(uint64_t) || size > 0xffff) {
+      fail("invalid entry size");
+    }
+
+    if (pRead && id <= pLastId) {
+      fail("entries out of order");
+    }
+
+    data.resize(size);
+
+    if (fread(data.getDataPtr(), size, 1, pFile) != 1) {
+      fail("truncated entry");
+    }
+
+    pCrc = DataHelper::updateCRC32(pCrc, buf, kEntrySize);
+    pCrc = DataHelper::updateCRC32(pCrc, data.getDataPtr(), size);
+    pLastId = id;
+    ++pRead;
+    return true;
+  }
+
+  const ChangeLogCheckpoint::Info& getInfo() const
+  {
+    return pInfo;
+  }
+
+private:
+  void fail(const char* reason)
+  {
+    MDException e(EFAULT);
+    e.getMessage() << "Checkpoint: " << pName << " is corrupted: " << reason;
+    e.getMessage() << " after " << pRead << " entries";
+    throw e;
+  }
+
+  std::string pName;
+  FILE* pFile;
+  ChangeLogCheckpoint::Info pInfo;
+  uint32_t pCrc;
+  uint64_t pRead;
+  uint64_t pLastId;
+};
+
+//------------------------------------------------------------------------------
+// Image writer
+//------------------------------------------------------------------------------
+class ImageWriter
+{
+public:
+  ImageWriter(const std::string& name): pName(name), pCrc(0), pWritten(0)
+  {
+    pFile = fopen(name.c_str(), "w");
+
+    if (!pFile) {
+      MDException e(errno);
+      e.getMessage() << "Checkpoint: unable to create " << name << ": ";
+      e.getMessage() << strerror(errno);
+      throw e;
+    }
+
+    char buf[kHeaderSize];
+    memset(buf, 0, kHeaderSize);
+    write(buf, kHeaderSize);
+    pCrc = DataHelper::computeCRC32(0, 0);
+  }
+
+  ~ImageWriter()
+  {
+    if (pFile) {
+      fclose(pFile);
+      unlink(pName.c_str());
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Append an entry
+  //----------------------------------------------------------------------------
+  void add(uint64_t id, uint64_t offset, const Buffer& data)
+  {
+    char buf[kEntrySize];
+    uint32_t size = data.size();
+    memcpy(buf, &id, 8);
+    memcpy(buf + 8, &offset, 8);
+    memcpy(buf + 16, &size, 4);
+    write(buf, kEntrySize);
+    write(data.getDataPtr(), size);
+    pCrc = DataHelper::updateCRC32(pCrc, buf, kEntrySize);
+    pCrc = DataHelper::updateCRC32(pCrc, (void*)data.getDataPtr(), size);
+    ++pWritten;
+  }
+
+  //----------------------------------------------------------------------------
+  // Write the trailer and the header, sync and rename to the final name
+  //----------------------------------------------------------------------------
+  void commit(ChangeLogCheckpoint::Info& info, const std::string& finalName)
+  {
+    uint32_t trailer[2] = { pCrc, ChangeLogCheckpoint::kMagic };
+    write(trailer, sizeof(trailer));
+    info.numEntries = pWritten;
+    char buf[kHeaderSize];
+    encodeHeader(info, buf);
+
+    if (fseek(pFile, 0, SEEK_SET) || fwrite(buf, kHeaderSize, 1, pFile) != 1 ||
+        fflush(pFile) || fsync(fileno(pFile))) {
+      fail();
+    }
+
+    FILE* file = pFile;
+    pFile = 0;
+
+    if (fclose(file) || rename(pName.c_str(), finalName.c_str())) {
+      MDException e(errno);
+      e.getMessage() << "Checkpoint: unable to commit " << finalName << ": ";
+      e.getMessage() << strerror(errno);
+      unlink(pName.c_str());
+      throw e;
+    }
+  }
+
+private:
+  void write(const void* ptr, size_t len)
+  {
+    if (len && fwrite(ptr, len, 1, pFile) != 1) {
+      fail();
+    }
+  }
+
+  void fail()
+  {
+    MDException e(errno);
+    e.getMessage() << "Checkpoint: unable to write " << pName << ": ";
+    e.getMessage() << strerror(errno);
+    throw e;
+  }
+
+  std::string pName;
+  FILE* pFile;
+  uint32_t pCrc;
+  uint64_t pWritten;
+};
+
+//------------------------------------------------------------------------------
+// Collect the latest record offset of every id up to a limit, a zero offset
+// marks a deletion
+//------------------------------------------------------------------------------
+class RecordCollector: public ILogRecordScanner
+{
+public:
+  RecordCollector(uint64_t limit = (uint64_t) - 1):
+    pLimit(limit), pLargestId(0), pLastOffset(0), pLastCrc(0), pScanned(0),
+    pIgnored(0) {}
+
+  virtual bool processRecord(uint64_t offset, char type, const Buffer& buffer)
+  {
+    if (offset >= pLimit) {
+      ++pIgnored;
+      return true;
+    }
+
+    ++pScanned;
+    pLastOffset = offset;
+    pLastCrc = buffer.getCRC32();
+
+    if (type == UPDATE_RECORD_MAGIC || type == DELETE_RECORD_MAGIC) {
+      uint64_t id;
+      buffer.grabData(0, &id, sizeof(id));
+      pRecords.push_back(std::make_pair(id, type == UPDATE_RECORD_MAGIC ?
+                                        offset : 0));
+
+      if (pLargestId < id) {
+        pLargestId = id;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Sort by id and keep the latest record of every id
+  //----------------------------------------------------------------------------
+  void sort()
+  {
+    std::stable_sort(pRecords.begin(), pRecords.end(),
+                     [](const std::pair<uint64_t, uint64_t>& a,
+    const std::pair<uint64_t, uint64_t>& b) {
+      return a.first < b.first;
+    });
+    RecordList::iterator out = pRecords.begin();
+
+    for (RecordList::iterator it = pRecords.begin(); it != pRecords.end(); ++it) {
+      if (out != pRecords.begin() && (out - 1)->first == it->first) {
+        *(out - 1) = *it;
+      } else {
+        *out++ = *it;
+      }
+    }
+
+    pRecords.erase(out, pRecords.end());
+  }
+
+  uint64_t pLimit;
+  uint64_t pLargestId;
+  uint64_t pLastOffset;
+  uint32_t pLastCrc;
+  uint64_t pScanned;
+  uint64_t pIgnored;
+  RecordList pRecords;
+};
+
+//------------------------------------------------------------------------------
+// Read an update record of the changelog and check its id
+//------------------------------------------------------------------------------
+void readUpdate(ChangeLogFile& log, uint64_t id, uint64_t offset, Buffer& data)
+{
+  uint8_t type = log.readRecord(offset, data);
+  uint64_t recordId = 0;
+
+  if (data.size() >= sizeof(recordId)) {
+    data.grabData(0, &recordId, sizeof(recordId));
+  }
+
+  if (type != UPDATE_RECORD_MAGIC || recordId != id) {
+    MDException e(EFAULT);
+    e.getMessage() << "Checkpoint: unexpected record at offset " << offset;
+    throw e;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write an image merging the previous one (if any) with the collected records
+//------------------------------------------------------------------------------
+void writeImage(ChangeLogFile& log, const std::string& imageName,
+                bool incremental, RecordCollector& records,
+                ChangeLogCheckpoint::Info& info,
+                ChangeLogCheckpoint::CreateStats& stats)
+{
+  ImageReader base;
+  ImageWriter writer(imageName + ".tmp");
+  uint64_t baseId = 0, baseOffset = 0;
+  Buffer data;
+  bool haveBase = incremental && base.open(imageName) &&
+                  base.next(baseId, baseOffset, data);
+  RecordList::iterator it = records.pRecords.begin();
+
+  while (haveBase || it != records.pRecords.end()) {
+    if (it == records.pRecords.end() || (haveBase && baseId < it->first)) {
+      writer.add(baseId, baseOffset, data);
+      ++stats.entriesKept;
+      haveBase = base.next(baseId, baseOffset, data);
+      continue;
+    }
+
+    if (haveBase && baseId == it->first) {
+      if (!it->second) {
+        ++stats.entriesDeleted;
+      }
+
+      haveBase = base.next(baseId, baseOffset, data);
+    }
+
+    if (it->second) {
+      Buffer record;
+      readUpdate(log, it->first, it->second, record);
+      writer.add(it->first, it->second, record);
+      ++stats.entriesUpdated;
+    }
+
+    ++it;
+  }
+
+  info.version = ChangeLogCheckpoint::kVersion;
+  info.contentFlag = log.getContentFlag();
+  info.lastOffset = records.pLastOffset;
+  info.lastCrc = records.pLastCrc;
+  info.largestId = records.pLargestId;
+  info.ctime = time(0);
+  writer.commit(info, imageName);
+}
+}
+
+//------------------------------------------------------------------------------
+// Create an image of a changelog file or extend an existing one
+//------------------------------------------------------------------------------
+void ChangeLogCheckpoint::create(const std::string& logName,
+                                 const std::string& imageName,
+                                 Info& info, CreateStats& stats)
+throw(MDException)
+{
+  time_t startTime = time(0);
+  ChangeLogFile log;
+  log.open(logName, ChangeLogFile::ReadOnly, 0);
+  Info old;
+  std::string reason;
+
+  try {
+    stats.incremental = readInfo(imageName, old) && matches(&log, old, reason);
+  } catch (MDException& e) {
+    stats.incremental = false;
+  }
+
+  //----------------------------------------------------------------------------
+  // Scan the records not covered by the previous image, fall back to a full
+  // scan if the previous image turns out to be corrupted
+  //----------------------------------------------------------------------------
+  while (true) {
+    RecordCollector records;
+    uint64_t start = log.getFirstOffset();
+
+    if (stats.incremental) {
+      start = old.coveredOffset;
+      records.pLastOffset = old.lastOffset;
+      records.pLastCrc = old.lastCrc;
+      records.pLargestId = old.largestId;
+    }
+
+    info.coveredOffset = log.follow(&records, start);
+    stats.recordsScanned = records.pScanned;
+
+    if (stats.incremental && info.coveredOffset == old.coveredOffset) {
+      info = old;
+      break;
+    }
+
+    records.sort();
+    stats.entriesKept = stats.entriesUpdated = stats.entriesDeleted = 0;
+
+    try {
+      writeImage(log, imageName, stats.incremental, records, info, stats);
+    } catch (MDException& e) {
+      if (!stats.incremental) {
+        throw;
+      }
+
+      stats.incremental = false;
+      continue;
+    }
+
+    break;
+  }
+
+  log.close();
+  stats.timeElapsed = time(0) - startTime;
+}
+
+//------------------------------------------------------------------------------
+// Read the header of an image
+//------------------------------------------------------------------------------
+bool ChangeLogCheckpoint::readInfo(const std::string& imageName, Info& info)
+throw(MDException)
+{
+  ImageReader reader;
+
+  if (!reader.open(imageName)) {
+    return false;
+  }
+
+  info = reader.getInfo();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if an image header belongs to an open changelog
+//------------------------------------------------------------------------------
+bool ChangeLogCheckpoint::matches(ChangeLogFile* log, const Info& info,
+                                  std::string& reason)
+{
+  if (info.contentFlag != log->getContentFlag()) {
+    reason = "content flag differs";
+    return false;
+  }
+
+  if (info.coveredOffset > log->getNextOffset()) {
+    reason = "changelog is shorter than the covered offset";
+    return false;
+  }
+
+  if (!info.lastOffset) {
+    if (info.coveredOffset != log->getFirstOffset()) {
+      reason = "invalid covered offset";
+      return false;
+    }
+
+    return true;
+  }
+
+  Buffer data;
+
+  try {
+    log->readRecord(info.lastOffset, data);
+  } catch (MDException& e) {
+    reason = "no record at the last covered offset";
+    return false;
+  }
+
+  if (data.getCRC32() != info.lastCrc ||
+      info.lastOffset + 24 + data.size() != info.coveredOffset) {
+    reason = "changelog holds a different record at the last covered offset";
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Load an image into a record scanner
+//------------------------------------------------------------------------------
+uint64_t ChangeLogCheckpoint::load(const std::string& imageName,
+                                   ChangeLogFile* log,
+                                   ILogRecordScanner* scanner,
+                                   uint64_t& largestId)
+throw(MDException)
+{
+  ImageReader reader;
+  std::string fname = baseName(imageName);
+  std::string reason;
+
+  try {
+    if (!reader.open(imageName)) {
+      return 0;
+    }
+
+    if (!matches(log, reader.getInfo(), reason)) {
+      fprintf(stderr, "ALERT    [ %-64s ] ignoring checkpoint: %s\n",
+              fname.c_str(), reason.c_str());
+      return 0;
+    }
+  } catch (MDException& e) {
+    fprintf(stderr, "ALERT    [ %-64s ] ignoring checkpoint: %s\n",
+            fname.c_str(), e.getMessage().str().c_str());
+    return 0;
+  }
+
+  const Info& info = reader.getInfo();
+  uint64_t id, offset, cnt = 0;
+  Buffer data;
+  size_t progress = 0;
+  time_t start_time = time(0);
+  time_t now = start_time;
+
+  while (reader.next(id, offset, data)) {
+    scanner->processRecord(offset, UPDATE_RECORD_MAGIC, data);
+    ++cnt;
+
+    if ((100.0 * cnt / info.numEntries) > progress) {
+      now = time(0);
+      double estimate = (1 + info.numEntries - cnt) /
+                        ((1.0 * cnt / (now + 1 - start_time)));
+
+      if (progress == 0) {
+        fprintf(stderr, "PROGRESS [ load %-64s ] %02u%% estimate none \n",
+                fname.c_str(), (unsigned int)progress);
+      } else {
+        fprintf(stderr, "PROGRESS [ load %-64s ] %02u%% estimate %3.02fs\n",
+                fname.c_str(), (unsigned int)progress, estimate);
+      }
+
+      progress += 5;
+    }
+  }
+
+  now = time(0);
+  fprintf(stderr, "ALERT    [ %-64s ] loaded %llu entries up to offset %llu "
+          "in %ds\n", fname.c_str(), (unsigned long long)cnt,
+          (unsigned long long)info.coveredOffset, (int)(now - start_time));
+  largestId = info.largestId;
+  return info.coveredOffset;
+}
+
+//------------------------------------------------------------------------------
+// Verify the consistency of an image
+//------------------------------------------------------------------------------
+void ChangeLogCheckpoint::verify(const std::string& imageName,
+                                 const std::string& logName, Info& info)
+throw(MDException)
+{
+  ImageReader reader;
+
+  if (!reader.open(imageName)) {
+    MDException e(ENOENT);
+    e.getMessage() << "Checkpoint: " << imageName << " does not exist";
+    throw e;
+  }
+
+  info = reader.getInfo();
+  uint64_t id, offset, recordId;
+  Buffer data;
+
+  while (reader.next(id, offset, data)) {
+    data.grabData(0, &recordId, sizeof(recordId));
+
+    if (recordId != id || offset < 8 || offset >= info.coveredOffset ||
+        id > info.largestId) {
+      MDException e(EFAULT);
+      e.getMessage() << "Checkpoint: invalid entry of id " << id;
+      e.getMessage() << " at changelog offset " << offset;
+      throw e;
+    }
+  }
+
+  if (logName.empty()) {
+    return;
+  }
+
+  ChangeLogFile log;
+  std::string reason;
+  log.open(logName, ChangeLogFile::ReadOnly, 0);
+
+  if (!matches(&log, info, reason)) {
+    MDException e(EINVAL);
+    e.getMessage() << "Checkpoint: " << imageName << " does not belong to ";
+    e.getMessage() << logName << ": " << reason;
+    throw e;
+  }
+
+  log.close();
+}
+
+//------------------------------------------------------------------------------
+// Compare an image with the replayed changelog
+//------------------------------------------------------------------------------
+uint64_t ChangeLogCheckpoint::diff(const std::string& logName,
+                                   const std::string& imageName,
+                                   std::ostream& out)
+throw(MDException)
+{
+  ImageReader reader;
+
+  if (!reader.open(imageName)) {
+    MDException e(ENOENT);
+    e.getMessage() << "Checkpoint: " << imageName << " does not exist";
+    throw e;
+  }
+
+  const Info& info = reader.getInfo();
+  ChangeLogFile log;
+  log.open(logName, ChangeLogFile::ReadOnly, 0);
+  uint64_t diffs = 0;
+  std::string reason;
+
+  if (!matches(&log, info, reason)) {
+    out << "image does not belong to the changelog: " << reason << std::endl;
+    ++diffs;
+  }
+
+  //----------------------------------------------------------------------------
+  // Replay the changelog up to the covered offset
+  //----------------------------------------------------------------------------
+  RecordCollector records(info.coveredOffset);
+  log.follow(&records, log.getFirstOffset());
+  records.sort();
+
+  if (records.pLargestId != info.largestId) {
+    out << "largest id: image=" << info.largestId << " changelog=";
+    out << records.pLargestId << std::endl;
+    ++diffs;
+  }
+
+  //----------------------------------------------------------------------------
+  // Walk both sorted id sets
+  //----------------------------------------------------------------------------
+  uint64_t id = 0, offset = 0;
+  Buffer data, record;
+  bool haveEntry = reader.next(id, offset, data);
+  RecordList::iterator it = records.pRecords.begin();
+
+  while (haveEntry || it != records.pRecords.end()) {
+    if (it != records.pRecords.end() && !it->second) {
+      if (haveEntry && id == it->first) {
+        out << "deleted  id=" << id << " offset=" << offset << std::endl;
+        ++diffs;
+        haveEntry = reader.next(id, offset, data);
+      }
+
+      ++it;
+      continue;
+    }
+
+    if (it == records.pRecords.end() || (haveEntry && id < it->first)) {
+      out << "extra    id=" << id << " offset=" << offset << std::endl;
+      ++diffs;
+      haveEntry = reader.next(id, offset, data);
+      continue;
+    }
+
+    if (!haveEntry || it->first < id) {
+      out << "missing  id=" << it->first << " offset=" << it->second;
+      out << std::endl;
+      ++diffs;
+      ++it;
+      continue;
+    }
+
+    if (offset != it->second) {
+      out << "offset   id=" << id << " image=" << offset << " changelog=";
+      out << it->second << std::endl;
+      ++diffs;
+    } else {
+      log.readRecord(offset, record);
+
+      if (record.size() != data.size() ||
+          memcmp(record.getDataPtr(), data.getDataPtr(), data.size())) {
+        out << "data     id=" << id << " offset=" << offset << std::endl;
+        ++diffs;
+      }
+    }
+
+    haveEntry = reader.next(id, offset, data);
+    ++it;
+  }
+
+  log.close();
+  return diffs;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,174 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @author agent <agent@local>
+//! @brief Checkpoint images of changelog files
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_CHANGE_LOG_CHECKPOINT_HH
+#define EOS_NS_CHANGE_LOG_CHECKPOINT_HH
+
+#include "namespace/Namespace.hh"
+#include "namespace/MDException.hh"
+#include <stdint.h>
+#include <ctime>
+#include <ostream>
+#include <string>
+
+EOSNSNAMESPACE_BEGIN
+
+class ChangeLogFile;
+class ILogRecordScanner;
+
+//------------------------------------------------------------------------------
+//! Checkpoint image of a changelog file.
+//!
+//! The image holds the latest update record of every live id found in the
+//! changelog up to a given offset (the covered offset), sorted by id and
+//! together with the offset of the record in the changelog. Loading the image
+//! and replaying the records following the covered offset gives the same
+//! state as replaying the whole changelog.
+//!
+//! An image belongs to the content of a changelog file and not to its name:
+//! it carries the offset and the checksum of the last record it covers and is
+//! only used if the changelog holds the same record at that offset. An image
+//! of a master changelog is therefore valid for the replica on a slave and
+//! for the copy made at a master/slave transition, while a compacted
+//! changelog invalidates all the images taken before the compaction.
+//!
+//! Layout: header, entries (u64 id, u64 log offset, u32 size, record data)
+//! and a trailer (u32 crc32 of the entries, u32 magic).
+//------------------------------------------------------------------------------
+class ChangeLogCheckpoint
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Image header
+  //----------------------------------------------------------------------------
+  struct Info {
+    Info(): version(0), contentFlag(0), coveredOffset(0), lastOffset(0),
+      lastCrc(0), largestId(0), numEntries(0), ctime(0) {}
+
+    uint16_t version; ///< format version
+    uint16_t contentFlag; ///< content flag of the changelog
+    uint64_t coveredOffset; ///< changelog offset following the last record
+    uint64_t lastOffset; ///< offset of the last covered record, 0 if none
+    uint32_t lastCrc; ///< crc32 of the data of the last covered record
+    uint64_t largestId; ///< largest id seen, including deleted ones
+    uint64_t numEntries; ///< number of entries in the image
+    uint64_t ctime; ///< creation time
+  };
+
+  //----------------------------------------------------------------------------
+  //! Statistics of an image creation
+  //----------------------------------------------------------------------------
+  struct CreateStats {
+    CreateStats(): incremental(false), recordsScanned(0), entriesKept(0),
+      entriesUpdated(0), entriesDeleted(0), timeElapsed(0) {}
+
+    bool incremental; ///< an existing image has been extended
+    uint64_t recordsScanned; ///< changelog records scanned
+    uint64_t entriesKept; ///< entries copied from the previous image
+    uint64_t entriesUpdated; ///< entries written from the changelog
+    uint64_t entriesDeleted; ///< entries of the previous image dropped
+    time_t timeElapsed; ///< duration in seconds
+  };
+
+  //----------------------------------------------------------------------------
+  //! Create an image of a changelog file or extend an existing one.
+  //!
+  //! If the existing image belongs to the changelog only the records following
+  //! its covered offset are scanned and merged into a new image, otherwise the
+  //! whole changelog is scanned. The new image is written to '<image>.tmp' and
+  //! renamed over the old one. The changelog may be appended to concurrently,
+  //! an incomplete trailing record is left for the next image.
+  //!
+  //! @param logName changelog file
+  //! @param imageName image file
+  //! @param info returns the header of the new image
+  //! @param stats returns the statistics
+  //----------------------------------------------------------------------------
+  static void create(const std::string& logName, const std::string& imageName,
+                     Info& info, CreateStats& stats) throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Read the header of an image
+  //!
+  //! @return false if the image does not exist, throws if it is not valid
+  //----------------------------------------------------------------------------
+  static bool readInfo(const std::string& imageName, Info& info)
+  throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Check if an image header belongs to an open changelog
+  //!
+  //! @param log open changelog
+  //! @param info image header
+  //! @param reason returns the reason if it does not
+  //----------------------------------------------------------------------------
+  static bool matches(ChangeLogFile* log, const Info& info,
+                      std::string& reason);
+
+  //----------------------------------------------------------------------------
+  //! Load an image into a record scanner. Every entry is passed as an update
+  //! record at its changelog offset.
+  //!
+  //! @param imageName image file
+  //! @param log open changelog the image has to belong to
+  //! @param scanner record scanner
+  //! @param largestId returns the largest id covered by the image
+  //!
+  //! @return covered changelog offset, 0 if there is no usable image; throws
+  //!         if the image is corrupted after entries have been passed on
+  //----------------------------------------------------------------------------
+  static uint64_t load(const std::string& imageName, ChangeLogFile* log,
+                       ILogRecordScanner* scanner, uint64_t& largestId)
+  throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Verify the consistency of an image: header, id order, record ids and
+  //! checksum. If a changelog is given, check that the image belongs to it.
+  //!
+  //! @param imageName image file
+  //! @param logName changelog file, may be empty
+  //! @param info returns the image header
+  //----------------------------------------------------------------------------
+  static void verify(const std::string& imageName, const std::string& logName,
+                     Info& info) throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Compare an image with the state obtained by replaying the changelog up
+  //! to the covered offset
+  //!
+  //! @param logName changelog file
+  //! @param imageName image file
+  //! @param out receives one line per difference
+  //!
+  //! @return number of differences
+  //----------------------------------------------------------------------------
+  static uint64_t diff(const std::string& logName, const std::string& imageName,
+                       std::ostream& out) throw(MDException);
+
+  static const uint32_t kMagic = 0x45434b50;
+  static const uint16_t kVersion = 1;
+};
+
+EOSNSNAMESPACE_END
+
+#endif // EOS_NS_CHANGE_LOG_CHECKPOINT_HH
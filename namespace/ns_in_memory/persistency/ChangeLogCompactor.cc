@@ -0,0 +1,196 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_in_memory/persistency/ChangeLogCompactor.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
+#include "namespace/utils/Buffer.hh"
+#include <algorithm>
+#include <utility>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ChangeLogCompactor::ChangeLogCompactor(ChangeLogFile* log,
+                                       const std::string& newLogName,
+                                       uint16_t contentFlag) throw(MDException):
+  pLog(log), pNewLog(new ChangeLogFile()), pNewLogName(newLogName),
+  pCopied(log->getFirstOffset()), pMark(0), pSnapshotDone(false)
+{
+  try {
+    pNewLog->open(newLogName, ChangeLogFile::Create, contentFlag);
+  } catch (MDException& e) {
+    delete pNewLog;
+    throw;
+  }
+
+  mark();
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ChangeLogCompactor::~ChangeLogCompactor()
+{
+  if (pNewLog) {
+    pNewLog->close();
+    delete pNewLog;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move the mark to the current end of the changelog
+//------------------------------------------------------------------------------
+uint64_t ChangeLogCompactor::mark()
+{
+  pMark = pLog->getNextOffset();
+  return (pMark > pCopied) ? (pMark - pCopied) : 0;
+}
+
+//------------------------------------------------------------------------------
+// Copy the records up to the mark
+//------------------------------------------------------------------------------
+uint64_t ChangeLogCompactor::catchUp() throw(MDException)
+{
+  uint64_t start = pCopied;
+
+  if (!pSnapshotDone) {
+    copySnapshot();
+    pSnapshotDone = true;
+  } else {
+    pStats.tailRecords += copyTail();
+  }
+
+  ++pStats.rounds;
+  return pCopied - start;
+}
+
+//------------------------------------------------------------------------------
+// Copy the remaining records and stamp the compacted log
+//------------------------------------------------------------------------------
+ChangeLogFile* ChangeLogCompactor::commit(Remap& remap) throw(MDException)
+{
+  if (!pSnapshotDone) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compactor: commit before the snapshot was copied";
+    throw e;
+  }
+
+  mark();
+  pStats.commitRecords += copyTail();
+  pNewLog->addCompactionMark();
+  remap.offsets.swap(pRemap.offsets);
+  remap.ids.swap(pRemap.ids);
+  remap.next = 0;
+  ChangeLogFile* newLog = pNewLog;
+  pNewLog = 0;
+  return newLog;
+}
+
+//------------------------------------------------------------------------------
+// Copy the latest update record of every live id up to the mark
+//------------------------------------------------------------------------------
+void ChangeLogCompactor::copySnapshot()
+{
+  // The offset of the latest update of every live id
+  OffsetMap& latest = pRemap.offsets;
+  uint64_t offset = pCopied;
+  uint64_t id;
+  Buffer data;
+
+  while (offset < pMark) {
+    uint8_t type = pLog->readRecord(offset, data);
+
+    if (type == UPDATE_RECORD_MAGIC) {
+      data.grabData(0, &id, sizeof(id));
+      latest[id] = offset;
+    } else if (type == DELETE_RECORD_MAGIC) {
+      data.grabData(0, &id, sizeof(id));
+      latest.erase(id);
+    }
+
+    offset += data.size() + 24;
+    ++pStats.snapshotRecords;
+  }
+
+  // Copy in changelog order to avoid random seeks
+  std::vector<std::pair<uint64_t, uint64_t>> records;
+  records.reserve(latest.size());
+
+  for (OffsetMap::iterator it = latest.begin(); it != latest.end(); ++it) {
+    records.push_back(std::make_pair(it->second, it->first));
+  }
+
+  std::sort(records.begin(), records.end());
+  pRemap.ids.reserve(records.size());
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    pLog->readRecord(records[i].first, data);
+    latest[records[i].second] = pNewLog->storeRecord(UPDATE_RECORD_MAGIC, data);
+    pRemap.ids.push_back(records[i].second);
+  }
+
+  pStats.snapshotCopied = records.size();
+  pCopied = offset;
+}
+
+//------------------------------------------------------------------------------
+// Copy all the records up to the mark
+//------------------------------------------------------------------------------
+uint64_t ChangeLogCompactor::copyTail()
+{
+  uint64_t offset = pCopied;
+  uint64_t copied = 0;
+  uint64_t id;
+  Buffer data;
+
+  while (offset < pMark) {
+    uint8_t type = pLog->readRecord(offset, data);
+    offset += data.size() + 24;
+
+    // The compacted log gets its own stamp
+    if (type == COMPACT_STAMP_RECORD_MAGIC) {
+      continue;
+    }
+
+    uint64_t newOffset = pNewLog->storeRecord(type, data);
+    ++copied;
+
+    if (type == UPDATE_RECORD_MAGIC) {
+      data.grabData(0, &id, sizeof(id));
+      std::pair<OffsetMap::iterator, bool> res =
+        pRemap.offsets.insert(std::make_pair(id, newOffset));
+
+      if (res.second) {
+        pRemap.ids.push_back(id);
+      } else {
+        res.first->second = newOffset;
+      }
+    } else if (type == DELETE_RECORD_MAGIC) {
+      data.grabData(0, &id, sizeof(id));
+      pRemap.offsets.erase(id);
+    }
+  }
+
+  pCopied = offset;
+  return copied;
+}
+
+EOSNSNAMESPACE_END
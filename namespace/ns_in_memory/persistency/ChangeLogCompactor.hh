@@ -0,0 +1,248 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @author agent <agent@local>
+//! @brief Incremental online compaction of changelog files
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_CHANGE_LOG_COMPACTOR_HH
+#define EOS_NS_CHANGE_LOG_COMPACTOR_HH
+
+#include "namespace/Namespace.hh"
+#include "namespace/MDException.hh"
+#include <google/dense_hash_map>
+#include <stdint.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+class ChangeLogFile;
+
+//------------------------------------------------------------------------------
+//! Incremental online compaction of a changelog file.
+//!
+//! The compacted log is built from the changelog itself and not from the
+//! in-memory structures: the records up to an end mark form a consistent
+//! snapshot from which the latest update record of every live id is copied.
+//! The records appended afterwards are copied in rounds, each one up to a new
+//! mark, until the remaining tail is small. Only taking a mark and the final
+//! round followed by the switch to the new log need the changelog not to be
+//! appended to, the copying itself only uses positional reads and runs
+//! concurrently with the writers.
+//!
+//! The offsets of the records in the new log are handed over in a Remap
+//! object so that the owner of the changelog can update its in-memory offsets
+//! in batches after the switch.
+//------------------------------------------------------------------------------
+class ChangeLogCompactor
+{
+public:
+  typedef google::dense_hash_map<uint64_t, uint64_t> OffsetMap;
+
+  //----------------------------------------------------------------------------
+  //! New log offsets of the records still to be applied to the in-memory
+  //! structures after the switch to the compacted log
+  //----------------------------------------------------------------------------
+  struct Remap {
+    Remap(): next(0)
+    {
+      offsets.set_deleted_key(0);
+      offsets.set_empty_key(std::numeric_limits<uint64_t>::max());
+    }
+
+    //--------------------------------------------------------------------------
+    //! Check if there is nothing to apply
+    //--------------------------------------------------------------------------
+    bool empty() const
+    {
+      return offsets.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Drop the pending offset of an id which has been updated or removed
+    //! since the switch, its in-memory offset is already right
+    //--------------------------------------------------------------------------
+    void forget(uint64_t id)
+    {
+      if (!offsets.empty()) {
+        offsets.erase(id);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Set the log offsets of at most batch entries of an id map whose values
+    //! have a logOffset member
+    //!
+    //! @return number of entries left
+    //--------------------------------------------------------------------------
+    template <typename IdMap>
+    uint64_t apply(IdMap& idMap, uint64_t batch)
+    {
+      uint64_t done = 0;
+
+      while ((next < ids.size()) && (done < batch)) {
+        OffsetMap::iterator it = offsets.find(ids[next++]);
+
+        if (it == offsets.end()) {
+          continue;
+        }
+
+        typename IdMap::iterator itI = idMap.find(it->first);
+
+        if (itI != idMap.end()) {
+          itI->second.logOffset = it->second;
+        }
+
+        offsets.erase(it);
+        ++done;
+      }
+
+      if (next >= ids.size()) {
+        clear();
+      }
+
+      return offsets.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Drop everything and release the memory
+    //--------------------------------------------------------------------------
+    void clear()
+    {
+      Remap empty;
+      offsets.swap(empty.offsets);
+      ids.swap(empty.ids);
+      next = 0;
+    }
+
+    OffsetMap offsets; ///< new log offset of the latest record of each id
+    std::vector<uint64_t> ids; ///< ids in the order they are applied
+    size_t next; ///< next position in ids
+  };
+
+  //----------------------------------------------------------------------------
+  //! Statistics of a compaction
+  //----------------------------------------------------------------------------
+  struct Stats {
+    Stats(): snapshotRecords(0), snapshotCopied(0), tailRecords(0), rounds(0),
+      commitRecords(0) {}
+
+    uint64_t snapshotRecords; ///< records scanned in the snapshot
+    uint64_t snapshotCopied; ///< live records copied from the snapshot
+    uint64_t tailRecords; ///< records copied by the catch up rounds
+    uint64_t rounds; ///< catch up rounds, including the snapshot
+    uint64_t commitRecords; ///< records copied while committing
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor - create the new log and take the first mark. The changelog
+  //! must not be appended to while it runs.
+  //!
+  //! @param log changelog to be compacted
+  //! @param newLogName name of the compacted log
+  //! @param contentFlag content flag of the changelog
+  //----------------------------------------------------------------------------
+  ChangeLogCompactor(ChangeLogFile* log, const std::string& newLogName,
+                     uint16_t contentFlag) throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - closes the new log unless it was handed over by commit
+  //----------------------------------------------------------------------------
+  ~ChangeLogCompactor();
+
+  //----------------------------------------------------------------------------
+  //! Move the mark to the current end of the changelog. The changelog must
+  //! not be appended to while it runs.
+  //!
+  //! @return number of bytes up to the mark not copied yet
+  //----------------------------------------------------------------------------
+  uint64_t mark();
+
+  //----------------------------------------------------------------------------
+  //! Copy the records up to the mark, the first call copies the snapshot.
+  //! Needs no lock.
+  //!
+  //! @return number of changelog bytes processed
+  //----------------------------------------------------------------------------
+  uint64_t catchUp() throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Copy the remaining records and stamp the compacted log. The changelog
+  //! must not be appended to while it runs, the work is proportional to the
+  //! bytes appended since the last mark.
+  //!
+  //! @param remap receives the offsets to be applied to the in-memory
+  //!              structures
+  //!
+  //! @return the compacted log, owned by the caller from now on
+  //----------------------------------------------------------------------------
+  ChangeLogFile* commit(Remap& remap) throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Get the name of the compacted log
+  //----------------------------------------------------------------------------
+  const std::string& getLogName() const
+  {
+    return pNewLogName;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the changelog offset up to which the records have been copied
+  //----------------------------------------------------------------------------
+  uint64_t getCopiedOffset() const
+  {
+    return pCopied;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics
+  //----------------------------------------------------------------------------
+  const Stats& getStats() const
+  {
+    return pStats;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Copy the latest update record of every live id up to the mark
+  //----------------------------------------------------------------------------
+  void copySnapshot();
+
+  //----------------------------------------------------------------------------
+  //! Copy all the records up to the mark
+  //!
+  //! @return number of records copied
+  //----------------------------------------------------------------------------
+  uint64_t copyTail();
+
+  ChangeLogFile* pLog; ///< changelog being compacted
+  ChangeLogFile* pNewLog; ///< compacted log
+  std::string pNewLogName; ///< name of the compacted log
+  uint64_t pCopied; ///< changelog offset copied up to
+  uint64_t pMark; ///< changelog offset to be copied up to
+  bool pSnapshotDone; ///< the snapshot has been copied
+  Remap pRemap; ///< offsets of the records in the compacted log
+  Stats pStats; ///< statistics
+};
+
+EOSNSNAMESPACE_END
+
+#endif // EOS_NS_CHANGE_LOG_COMPACTOR_HH
@@ -31,6 +31,8 @@
 #include "namespace/ns_in_memory/accounting/ContainerAccounting.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogContainerMDSvc.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogCheckpoint.hh"
+#include <algorithm>
 #include <set>
 #include <memory>
 
@@ -545,14 +547,29 @@ void ChangeLogContainerMDSvc::initialize()
   // In the master mode we go throug the entire file
   // In the slave mode up until the compaction mark or not at all
   // if the compaction mark is not present
+  //
+  // If a checkpoint image of the change log is available we load it and
+  // scan only the records following it, in the slave mode these are left
+  // to the follower
   pChangeLog->open(pChangeLogPath, logOpenFlags, CONTAINER_LOG_MAGIC);
   bool logIsCompacted = (pChangeLog->getUserFlags() & LOG_FLAG_COMPACTED);
   pFollowStart = pChangeLog->getFirstOffset();
+  uint64_t checkpointLargestId = 0;
+  uint64_t checkpointOffset = loadCheckpoint(checkpointLargestId);
 
-  if (!pSlaveMode || logIsCompacted) {
+  if (checkpointOffset || !pSlaveMode || logIsCompacted) {
     ContainerMDScanner scanner(pIdMap, pSlaveMode);
-    pFollowStart = pChangeLog->scanAllRecords(&scanner , pAutoRepair);
-    pFirstFreeId = scanner.getLargestId() + 1;
+
+    if (!checkpointOffset) {
+      pFollowStart = pChangeLog->scanAllRecords(&scanner , pAutoRepair);
+    } else if (!pSlaveMode) {
+      pFollowStart = pChangeLog->scanAllRecordsAtOffset(&scanner,
+                     checkpointOffset, pAutoRepair);
+    } else {
+      pFollowStart = checkpointOffset;
+    }
+
+    pFirstFreeId = std::max(scanner.getLargestId(), checkpointLargestId) + 1;
     // Recreate the container structure
     IdMap::iterator it;
     ContainerList   orphans;
@@ -722,6 +739,12 @@ void ChangeLogContainerMDSvc::configure(
   if (it != config.end() && it->second == "true") {
     pAutoRepair = true;
   }
+
+  it = config.find("checkpoint_path");
+
+  if (it != config.end()) {
+    pCheckpointPath = it->second;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -731,6 +754,7 @@ void ChangeLogContainerMDSvc::finalize()
 {
   pChangeLog->close();
   pIdMap.clear();
+  pCompactRemap.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -781,6 +805,7 @@ void ChangeLogContainerMDSvc::updateStore(IContainerMD* obj)
   dynamic_cast<ContainerMD*>(obj)->serialize(buffer);
   it->second.logOffset = pChangeLog->storeRecord(eos::UPDATE_RECORD_MAGIC,
                          buffer);
+  pCompactRemap.forget(obj->getId());
   notifyListeners(obj, IContainerMDChangeListener::Updated);
 }
 
@@ -811,6 +836,14 @@ void ChangeLogContainerMDSvc::removeContainer(IContainerMD::id_t containerId)
   eos::Buffer buffer;
   buffer.putData(&containerId, sizeof(IContainerMD::id_t));
   pChangeLog->storeRecord(eos::DELETE_RECORD_MAGIC, buffer);
+  pCompactRemap.forget(containerId);
+
+  if (pContainerAccounting) {
+    // don't lose a size change still pending for the removed container
+    ((ContainerAccounting*)pContainerAccounting)->RemoveContainer(
+      it->second.ptr.get());
+  }
+
   notifyListeners(it->second.ptr.get(), IContainerMDChangeListener::Deleted);
   pIdMap.erase(it);
 }
@@ -830,6 +863,13 @@ ChangeLogContainerMDSvc::addChangeListener(IContainerMDChangeListener* listener)
 void*
 ChangeLogContainerMDSvc::compactPrepare(const std::string& newLogFileName) const
 {
+  if (!pCompactRemap.empty()) {
+    MDException e(EBUSY);
+    e.getMessage() << "ContainerMDSvc: log offsets of the previous compacting not "
+                   << "updated yet";
+    throw e;
+  }
+
   // Try to open a new log file for writing
   ::ContainerCompactingData* data = new ::ContainerCompactingData();
 
@@ -972,6 +1012,104 @@ ChangeLogContainerMDSvc::compactCommit(void* compactingData, bool autorepair)
   delete data;
 }
 
+//----------------------------------------------------------------------------
+// Prepare for incremental online compacting
+//----------------------------------------------------------------------------
+void*
+ChangeLogContainerMDSvc::compactPrepareIncremental(
+  const std::string& newLogFileName) const
+{
+  if (!pCompactRemap.empty()) {
+    MDException e(EBUSY);
+    e.getMessage() << "ContainerMDSvc: log offsets of the previous compacting not "
+                   << "updated yet";
+    throw e;
+  }
+
+  return new ChangeLogCompactor(pChangeLog, newLogFileName, CONTAINER_LOG_MAGIC);
+}
+
+//----------------------------------------------------------------------------
+// Copy the records up to the last mark to the compacted log
+//----------------------------------------------------------------------------
+uint64_t
+ChangeLogContainerMDSvc::compactCatchUp(void*& compactingData)
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  try {
+    return compactor->catchUp();
+  } catch (MDException& e) {
+    delete compactor;
+    compactingData = 0;
+    throw;
+  }
+}
+
+//----------------------------------------------------------------------------
+// Move the mark to the current end of the changelog
+//----------------------------------------------------------------------------
+uint64_t
+ChangeLogContainerMDSvc::compactMark(void* compactingData) const
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  return compactor->mark();
+}
+
+//----------------------------------------------------------------------------
+// Copy the records appended since the last mark and switch to the
+// compacted log
+//----------------------------------------------------------------------------
+void
+ChangeLogContainerMDSvc::compactCommitIncremental(void* compactingData)
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  ChangeLogFile* newLog = 0;
+
+  try {
+    newLog = compactor->commit(pCompactRemap);
+  } catch (MDException& e) {
+    delete compactor;
+    throw;
+  }
+
+  // Replace the logs, the in-memory offsets are updated by compactRemap
+  ChangeLogFile* originalLog = pChangeLog;
+  pChangeLog = newLog;
+  pChangeLogPath = compactor->getLogName();
+  originalLog->close();
+  delete compactor;
+}
+
+//----------------------------------------------------------------------------
+// Update the in-memory log offsets after an incremental compacting
+//----------------------------------------------------------------------------
+uint64_t
+ChangeLogContainerMDSvc::compactRemap(uint64_t batch)
+{
+  return pCompactRemap.apply(pIdMap, batch);
+}
+
 //----------------------------------------------------------------------------
 // Start the slave
 //----------------------------------------------------------------------------
@@ -1153,6 +1291,29 @@ void ChangeLogContainerMDSvc::attachBroken(IContainerMD*   parent,
   }
 }
 
+//----------------------------------------------------------------------------
+// Load the checkpoint image of the changelog into the lookup table
+//----------------------------------------------------------------------------
+uint64_t ChangeLogContainerMDSvc::loadCheckpoint(uint64_t& largestId)
+{
+  if (pCheckpointPath.empty()) {
+    return 0;
+  }
+
+  try {
+    ContainerMDScanner scanner(pIdMap, pSlaveMode);
+    return ChangeLogCheckpoint::load(pCheckpointPath, pChangeLog, &scanner,
+                                     largestId);
+  } catch (MDException& e) {
+    fprintf(stderr, "ALERT    [ %-64s ] %s - replaying the full changelog\n",
+            "checkpoint-load", e.getMessage().str().c_str());
+  }
+
+  pIdMap.clear();
+  largestId = 0;
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 // Scan the changelog and put the appropriate data in the lookup table
 //----------------------------------------------------------------------------
@@ -30,6 +30,7 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IChLogContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogCompactor.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
 #include "namespace/ns_in_memory/accounting/QuotaStats.hh"
 
@@ -178,6 +179,32 @@ public:
   //--------------------------------------------------------------------------
   void compactCommit(void* compactingData, bool autorepair = false);
 
+  //--------------------------------------------------------------------------
+  //! Prepare for incremental online compacting, see the interface
+  //--------------------------------------------------------------------------
+  void* compactPrepareIncremental(const std::string& newLogFileName) const;
+
+  //--------------------------------------------------------------------------
+  //! Copy the records up to the last mark to the compacted log
+  //--------------------------------------------------------------------------
+  uint64_t compactCatchUp(void*& compactingData);
+
+  //--------------------------------------------------------------------------
+  //! Move the mark to the current end of the changelog
+  //--------------------------------------------------------------------------
+  uint64_t compactMark(void* compactingData) const;
+
+  //--------------------------------------------------------------------------
+  //! Copy the records appended since the last mark and switch to the
+  //! compacted log
+  //--------------------------------------------------------------------------
+  void compactCommitIncremental(void* compactingData);
+
+  //--------------------------------------------------------------------------
+  //! Update the in-memory log offsets after an incremental compacting
+  //--------------------------------------------------------------------------
+  uint64_t compactRemap(uint64_t batch);
+
   //--------------------------------------------------------------------------
   //! Make a transition from slave to master
   // -----------------------------------------------------------------------
@@ -381,13 +408,21 @@ private:
   //--------------------------------------------------------------------------
   void attachBroken(IContainerMD* parent, ContainerList& broken);
 
+  //--------------------------------------------------------------------------
+  // Load the checkpoint image of the changelog, if configured and usable.
+  // Returns the changelog offset covered by the image or 0.
+  //--------------------------------------------------------------------------
+  uint64_t loadCheckpoint(uint64_t& largestId);
+
   //--------------------------------------------------------------------------
   // Data members
   //--------------------------------------------------------------------------
   IContainerMD::id_t pFirstFreeId;
   std::string        pChangeLogPath;
+  std::string        pCheckpointPath;
   ChangeLogFile*     pChangeLog;
   IdMap              pIdMap;
+  ChangeLogCompactor::Remap pCompactRemap;
   ListenerList       pListeners;
   pthread_t          pFollowerThread;
   LockHandler*       pSlaveLock;
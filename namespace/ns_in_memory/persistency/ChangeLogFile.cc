@@ -45,7 +45,6 @@
 #include <fcntl.h>
 
 #define CHANGELOG_MAGIC 0x45434847
-#define RECORD_MAGIC    0x4552
 
 namespace eos
 {
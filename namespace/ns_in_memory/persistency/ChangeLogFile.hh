@@ -25,6 +25,7 @@
 #define EOS_NS_CHANGE_LOG_FILE_HH
 
 #include <string>
+#include <cstring>
 #include <stdint.h>
 #include <ctime>
 #include <pthread.h>
@@ -33,6 +34,8 @@
 #include "namespace/utils/Buffer.hh"
 #include "namespace/utils/Descriptor.hh"
 
+#define RECORD_MAGIC 0x4552
+
 namespace eos
 {
 //----------------------------------------------------------------------------
@@ -280,6 +283,21 @@ public:
   //------------------------------------------------------------------------
   static off_t findRecordMagic(int fd, off_t offset, off_t limit);
 
+  //------------------------------------------------------------------------
+  //! Get the length of the record starting with the given header
+  //!
+  //! @param header first 4 bytes of the record
+  //! @return length including header and trailer, 0 if the buffer does not
+  //!         start with a record magic
+  //------------------------------------------------------------------------
+  static uint32_t getRecordLength(const char* header)
+  {
+    uint16_t magic, size;
+    memcpy(&magic, header, sizeof(magic));
+    memcpy(&size, header + 2, sizeof(size));
+    return (magic == RECORD_MAGIC) ? 24 + size : 0;
+  }
+
   //------------------------------------------------------------------------
   // Add Warning Message
   //------------------------------------------------------------------------
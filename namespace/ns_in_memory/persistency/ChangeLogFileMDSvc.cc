@@ -24,6 +24,7 @@
 #include "ChangeLogFileMDSvc.hh"
 #include "ChangeLogContainerMDSvc.hh"
 #include "ChangeLogConstants.hh"
+#include "ChangeLogCheckpoint.hh"
 #include "common/ShellCmd.hh"
 #include "namespace/Constants.hh"
 #include "namespace/utils/Locking.hh"
@@ -689,14 +690,29 @@ void ChangeLogFileMDSvc::initialize()
   // In the master mode we go through the entire file
   // In the slave mode up until the compaction mark or not at all
   // if the compaction mark is not present
+  //
+  // If a checkpoint image of the change log is available we load it and
+  // scan only the records following it, in the slave mode these are left
+  // to the follower
   pChangeLog->open(pChangeLogPath, logOpenFlags, FILE_LOG_MAGIC);
   bool logIsCompacted = (pChangeLog->getUserFlags() & LOG_FLAG_COMPACTED);
   pFollowStart = pChangeLog->getFirstOffset();
+  uint64_t checkpointLargestId = 0;
+  uint64_t checkpointOffset = loadCheckpoint(checkpointLargestId);
 
-  if (!pSlaveMode || logIsCompacted) {
+  if (checkpointOffset || !pSlaveMode || logIsCompacted) {
     FileMDScanner scanner(pIdMap, pSlaveMode);
-    pFollowStart = pChangeLog->scanAllRecords(&scanner);
-    pFirstFreeId = scanner.getLargestId() + 1;
+
+    if (!checkpointOffset) {
+      pFollowStart = pChangeLog->scanAllRecords(&scanner);
+    } else if (!pSlaveMode) {
+      pFollowStart = pChangeLog->scanAllRecordsAtOffset(&scanner,
+                     checkpointOffset);
+    } else {
+      pFollowStart = checkpointOffset;
+    }
+
+    pFirstFreeId = std::max(scanner.getLargestId(), checkpointLargestId) + 1;
     // Recreate the files
     IdMap::iterator it;
 
@@ -866,6 +882,12 @@ void ChangeLogFileMDSvc::configure(
   if (it != config.end()) {
     pResSize = strtoull(it->second.c_str(), 0, 10);
   }
+
+  it = config.find("checkpoint_path");
+
+  if (it != config.end()) {
+    pCheckpointPath = it->second;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -875,6 +897,7 @@ void ChangeLogFileMDSvc::finalize()
 {
   pChangeLog->close();
   pIdMap.clear();
+  pCompactRemap.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -927,6 +950,7 @@ void ChangeLogFileMDSvc::updateStore(IFileMD* obj)
   obj->serialize(buffer);
   it->second.logOffset = pChangeLog->storeRecord(eos::UPDATE_RECORD_MAGIC,
                          buffer);
+  pCompactRemap.forget(obj->getId());
   IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Updated);
   notifyListeners(&e);
 }
@@ -951,6 +975,7 @@ void ChangeLogFileMDSvc::removeFile(IFileMD* obj)
   eos::Buffer buffer;
   buffer.putData(&fileId, sizeof(FileMD::id_t));
   pChangeLog->storeRecord(eos::DELETE_RECORD_MAGIC, buffer);
+  pCompactRemap.forget(fileId);
   IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Deleted);
   notifyListeners(&e);
   pIdMap.erase(it);
@@ -1008,6 +1033,33 @@ void ChangeLogFileMDSvc::visit(IFileVisitor* visitor)
           (int)(now - start_time));
 }
 
+//------------------------------------------------------------------------------
+// Load the checkpoint image of the changelog into the lookup table
+//------------------------------------------------------------------------------
+uint64_t ChangeLogFileMDSvc::loadCheckpoint(uint64_t& largestId)
+{
+  if (pCheckpointPath.empty()) {
+    return 0;
+  }
+
+  try {
+    FileMDScanner scanner(pIdMap, pSlaveMode);
+    return ChangeLogCheckpoint::load(pCheckpointPath, pChangeLog, &scanner,
+                                     largestId);
+  } catch (MDException& e) {
+    fprintf(stderr, "ALERT    [ %-64s ] %s - replaying the full changelog\n",
+            "checkpoint-load", e.getMessage().str().c_str());
+  }
+
+  for (IdMap::iterator it = pIdMap.begin(); it != pIdMap.end(); ++it) {
+    delete it->second.buffer;
+  }
+
+  pIdMap.clear();
+  largestId = 0;
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Scan the changelog and put the appropriate data in the lookup table
 //------------------------------------------------------------------------------
@@ -1063,6 +1115,13 @@ bool ChangeLogFileMDSvc::FileMDScanner::processRecord(uint64_t      offset,
 void* ChangeLogFileMDSvc::compactPrepare(const std::string& newLogFileName)
 const
 {
+  if (!pCompactRemap.empty()) {
+    MDException e(EBUSY);
+    e.getMessage() << "FileMDSvc: log offsets of the previous compacting not "
+                   << "updated yet";
+    throw e;
+  }
+
   // Try to open a new log file for writing
   ::CompactingData* data = new ::CompactingData();
 
@@ -1208,6 +1267,99 @@ void ChangeLogFileMDSvc::compactCommit(void* compactingData, bool autorepair)
   delete data;
 }
 
+//------------------------------------------------------------------------------
+// Prepare for incremental online compacting
+//------------------------------------------------------------------------------
+void* ChangeLogFileMDSvc::compactPrepareIncremental(
+  const std::string& newLogFileName) const
+{
+  if (!pCompactRemap.empty()) {
+    MDException e(EBUSY);
+    e.getMessage() << "FileMDSvc: log offsets of the previous compacting not "
+                   << "updated yet";
+    throw e;
+  }
+
+  return new ChangeLogCompactor(pChangeLog, newLogFileName, FILE_LOG_MAGIC);
+}
+
+//------------------------------------------------------------------------------
+// Copy the records up to the last mark to the compacted log
+//------------------------------------------------------------------------------
+uint64_t ChangeLogFileMDSvc::compactCatchUp(void*& compactingData)
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  try {
+    return compactor->catchUp();
+  } catch (MDException& e) {
+    delete compactor;
+    compactingData = 0;
+    throw;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move the mark to the current end of the changelog
+//------------------------------------------------------------------------------
+uint64_t ChangeLogFileMDSvc::compactMark(void* compactingData) const
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  return compactor->mark();
+}
+
+//------------------------------------------------------------------------------
+// Copy the records appended since the last mark and switch to the
+// compacted log
+//------------------------------------------------------------------------------
+void ChangeLogFileMDSvc::compactCommitIncremental(void* compactingData)
+{
+  ChangeLogCompactor* compactor = (ChangeLogCompactor*)compactingData;
+
+  if (!compactor) {
+    MDException e(EINVAL);
+    e.getMessage() << "Compacting data incorrect";
+    throw e;
+  }
+
+  ChangeLogFile* newLog = 0;
+
+  try {
+    newLog = compactor->commit(pCompactRemap);
+  } catch (MDException& e) {
+    delete compactor;
+    throw;
+  }
+
+  // Replace the logs, the in-memory offsets are updated by compactRemap
+  ChangeLogFile* originalLog = pChangeLog;
+  pChangeLog = newLog;
+  pChangeLogPath = compactor->getLogName();
+  originalLog->close();
+  delete compactor;
+}
+
+//------------------------------------------------------------------------------
+// Update the in-memory log offsets after an incremental compacting
+//------------------------------------------------------------------------------
+uint64_t ChangeLogFileMDSvc::compactRemap(uint64_t batch)
+{
+  return pCompactRemap.apply(pIdMap, batch);
+}
+
 //------------------------------------------------------------------------------
 // Start the slave
 //------------------------------------------------------------------------------
@@ -0,0 +1,1279 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_in_memory/persistency/ChangeLogStream.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+
+EOSNSNAMESPACE_BEGIN
+
+using namespace ChangeLogStreamProtocol;
+
+namespace
+{
+//! Max. number of bytes sent in one data message
+const size_t kChunkSize = 1024 * 1024;
+//! Max. accepted payload of a control message
+const uint64_t kMaxControlPayload = 4096;
+//! Interval of the master heartbeats
+const int kHeartbeatMs = 1000;
+//! A slave reconnects if the master has been silent for this long
+const int kSilenceMs = 5000;
+
+//------------------------------------------------------------------------------
+// Read exactly len bytes, waiting at most timeout_ms for every chunk
+//------------------------------------------------------------------------------
+bool readFull(int fd, void* buf, size_t len, int timeout_ms)
+{
+  char* ptr = (char*) buf;
+
+  while (len) {
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int rc = poll(&pfd, 1, timeout_ms);
+
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (rc <= 0) {
+      return false;
+    }
+
+    ssize_t nread = recv(fd, ptr, len, 0);
+
+    if (nread < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (nread <= 0) {
+      return false;
+    }
+
+    ptr += nread;
+    len -= nread;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write exactly len bytes
+//------------------------------------------------------------------------------
+bool writeFull(int fd, const void* buf, size_t len)
+{
+  const char* ptr = (const char*) buf;
+
+  while (len) {
+    ssize_t nwrite = send(fd, ptr, len, MSG_NOSIGNAL);
+
+    if (nwrite < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (nwrite <= 0) {
+      return false;
+    }
+
+    ptr += nwrite;
+    len -= nwrite;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Send a message
+//------------------------------------------------------------------------------
+bool sendMessage(int fd, uint32_t type, uint64_t seq, uint64_t offset,
+                 uint64_t end, const void* payload = 0, uint64_t length = 0)
+{
+  Header hdr;
+  hdr.magic = kMagic;
+  hdr.type = type;
+  hdr.seq = seq;
+  hdr.offset = offset;
+  hdr.end = end;
+  hdr.length = length;
+
+  if (!writeFull(fd, &hdr, sizeof(hdr))) {
+    return false;
+  }
+
+  return !length || writeFull(fd, payload, length);
+}
+
+//------------------------------------------------------------------------------
+// Read a control message payload
+//------------------------------------------------------------------------------
+bool readPayload(int fd, const Header& hdr, std::string& payload,
+                 int timeout_ms)
+{
+  if (hdr.length > kMaxControlPayload) {
+    return false;
+  }
+
+  payload.resize(hdr.length);
+  return !hdr.length || readFull(fd, &payload[0], hdr.length, timeout_ms);
+}
+
+//------------------------------------------------------------------------------
+// Read exactly len bytes at offset
+//------------------------------------------------------------------------------
+bool preadFull(int fd, char* buf, size_t len, off_t offset)
+{
+  while (len) {
+    ssize_t nread = pread(fd, buf, len, offset);
+
+    if (nread < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (nread <= 0) {
+      return false;
+    }
+
+    buf += nread;
+    len -= nread;
+    offset += nread;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write exactly len bytes at offset
+//------------------------------------------------------------------------------
+bool pwriteFull(int fd, const char* buf, size_t len, off_t offset)
+{
+  while (len) {
+    ssize_t nwrite = pwrite(fd, buf, len, offset);
+
+    if (nwrite < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (nwrite <= 0) {
+      return false;
+    }
+
+    buf += nwrite;
+    len -= nwrite;
+    offset += nwrite;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Connect with a timeout
+//------------------------------------------------------------------------------
+int connectTo(const std::string& host, int port, int timeout_ms,
+              std::string& error)
+{
+  addrinfo hints;
+  addrinfo* result = 0;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  std::string sport = std::to_string(port);
+  int rc = getaddrinfo(host.c_str(), sport.c_str(), &hints, &result);
+
+  if (rc) {
+    error = "unable to resolve " + host + ": " + gai_strerror(rc);
+    return -1;
+  }
+
+  int sock = -1;
+
+  for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+    sock = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                  ai->ai_protocol);
+
+    if (sock < 0) {
+      continue;
+    }
+
+    int flags = fcntl(sock, F_GETFL);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    bool ok = !connect(sock, ai->ai_addr, ai->ai_addrlen);
+
+    if (!ok && errno == EINPROGRESS) {
+      pollfd pfd;
+      pfd.fd = sock;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+
+      if (poll(&pfd, 1, timeout_ms) == 1) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ok = !getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) && !err;
+
+        if (err) {
+          errno = err;
+        }
+      } else {
+        errno = ETIMEDOUT;
+      }
+    }
+
+    if (ok) {
+      fcntl(sock, F_SETFL, flags);
+      int one = 1;
+      setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      break;
+    }
+
+    error = "unable to connect to " + host + ":" + sport + ": " +
+            strerror(errno);
+    close(sock);
+    sock = -1;
+  }
+
+  freeaddrinfo(result);
+  return sock;
+}
+
+//------------------------------------------------------------------------------
+// HMAC-SHA256 of data with the shared secret
+//------------------------------------------------------------------------------
+std::string computeMac(const std::string& secret, const std::string& data)
+{
+  unsigned char mac[EVP_MAX_MD_SIZE];
+  unsigned int len = 0;
+
+  if (!HMAC(EVP_sha256(), secret.data(), secret.size(),
+            (const unsigned char*) data.data(), data.size(), mac, &len)) {
+    return "";
+  }
+
+  return std::string((const char*) mac, len);
+}
+
+//------------------------------------------------------------------------------
+// Compare two MACs in constant time
+//------------------------------------------------------------------------------
+bool sameMac(const std::string& mac, const std::string& expected)
+{
+  return (mac.size() == kMacSize) && (expected.size() == kMacSize) &&
+         !CRYPTO_memcmp(mac.data(), expected.data(), kMacSize);
+}
+
+//------------------------------------------------------------------------------
+// Generate a random nonce
+//------------------------------------------------------------------------------
+bool makeNonce(std::string& nonce)
+{
+  nonce.resize(kNonceSize);
+  return RAND_bytes((unsigned char*) &nonce[0], kNonceSize) == 1;
+}
+
+//------------------------------------------------------------------------------
+// Data authenticated by the slave in its subscription
+//------------------------------------------------------------------------------
+std::string subscribeData(const std::string& master_nonce,
+                          const std::string& slave_nonce, uint64_t offset,
+                          const std::string& fingerprint,
+                          const std::string& channel)
+{
+  return "subscribe" + master_nonce + slave_nonce +
+         std::string((const char*) &offset, sizeof(offset)) + fingerprint +
+         channel;
+}
+
+//------------------------------------------------------------------------------
+// Data authenticated by the master in its answer
+//------------------------------------------------------------------------------
+std::string authData(const std::string& master_nonce,
+                     const std::string& slave_nonce)
+{
+  return "auth" + slave_nonce + master_nonce;
+}
+
+//------------------------------------------------------------------------------
+// Map an IPv4 or IPv6 address to an IPv6 address
+//------------------------------------------------------------------------------
+bool toInet6(const sockaddr* sa, in6_addr& addr)
+{
+  if (sa->sa_family == AF_INET6) {
+    addr = ((const sockaddr_in6*) sa)->sin6_addr;
+    return true;
+  }
+
+  if (sa->sa_family == AF_INET) {
+    memset(&addr, 0, sizeof(addr));
+    addr.s6_addr[10] = addr.s6_addr[11] = 0xff;
+    memcpy(&addr.s6_addr[12], &((const sockaddr_in*) sa)->sin_addr, 4);
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Milliseconds on a monotonic clock
+//------------------------------------------------------------------------------
+int64_t nowMs()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+//------------------------------------------------------------------------------
+// Server constructor
+//------------------------------------------------------------------------------
+ChangeLogStreamServer::ChangeLogStreamServer():
+  mListenFd(-1), mPort(0), mRunning(false)
+{}
+
+//------------------------------------------------------------------------------
+// Server destructor
+//------------------------------------------------------------------------------
+ChangeLogStreamServer::~ChangeLogStreamServer()
+{
+  stop();
+}
+
+//------------------------------------------------------------------------------
+// Define or change the file served on a channel
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::setChannel(const std::string& name,
+                                       const std::string& path)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::map<std::string, std::string>::iterator it = mChannels.find(name);
+
+    if (it != mChannels.end() && it->second == path) {
+      return;
+    }
+
+    mChannels[name] = path;
+  }
+  dropSubscribers(name);
+}
+
+//------------------------------------------------------------------------------
+// Remove all channels
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::clearChannels()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mChannels.clear();
+  }
+  dropSubscribers("");
+}
+
+//------------------------------------------------------------------------------
+// Set the secret shared with the slaves
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::setSecret(const std::string& secret)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mSecret = secret;
+}
+
+//------------------------------------------------------------------------------
+// Restrict the subscriptions to the given hosts
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::setAllowedHosts(const std::vector<std::string>&
+    hosts)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mAllowedHosts = hosts;
+}
+
+//------------------------------------------------------------------------------
+// Check if a slave address belongs to one of the allowed hosts
+//------------------------------------------------------------------------------
+bool ChangeLogStreamServer::isAllowed(const sockaddr_storage& addr)
+{
+  std::vector<std::string> hosts;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    hosts = mAllowedHosts;
+  }
+
+  if (hosts.empty()) {
+    return true;
+  }
+
+  in6_addr peer;
+
+  if (!toInet6((const sockaddr*) &addr, peer)) {
+    return false;
+  }
+
+  for (auto it = hosts.begin(); it != hosts.end(); ++it) {
+    addrinfo hints;
+    addrinfo* result = 0;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(it->c_str(), 0, &hints, &result)) {
+      continue;
+    }
+
+    bool found = false;
+
+    for (addrinfo* ai = result; ai && !found; ai = ai->ai_next) {
+      in6_addr host;
+      found = toInet6(ai->ai_addr, host) &&
+              !memcmp(&host, &peer, sizeof(peer));
+    }
+
+    freeaddrinfo(result);
+
+    if (found) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Look up a channel
+//------------------------------------------------------------------------------
+bool ChangeLogStreamServer::getChannel(const std::string& name,
+                                       std::string& path)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::map<std::string, std::string>::const_iterator it = mChannels.find(name);
+
+  if (it == mChannels.end()) {
+    return false;
+  }
+
+  path = it->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop the subscriptions of a channel, all if the channel is empty
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::dropSubscribers(const std::string& channel)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto it = mSubscribers.begin(); it != mSubscribers.end(); ++it) {
+    if (channel.empty() || (*it)->status.channel == channel) {
+      // the serving thread notices and finishes, the socket is closed
+      // when the thread is reaped
+      shutdown((*it)->fd, SHUT_RDWR);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start listening
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::start(int port, const std::string& bind_address)
+throw(MDException)
+{
+  if (mRunning) {
+    return;
+  }
+
+  addrinfo hints;
+  addrinfo* result = 0;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  std::string sport = std::to_string(port);
+  int rc = getaddrinfo(bind_address.empty() ? 0 : bind_address.c_str(),
+                       sport.c_str(), &hints, &result);
+
+  if (rc) {
+    MDException ex(EINVAL);
+    ex.getMessage() << "Unable to resolve stream address " << bind_address
+                    << ": " << gai_strerror(rc);
+    throw ex;
+  }
+
+  int fd = -1;
+  int err = 0;
+
+  // prefer a dual stack IPv6 socket
+  for (int pass = 0; pass < 2 && fd < 0; ++pass) {
+    for (addrinfo* ai = result; ai && fd < 0; ai = ai->ai_next) {
+      if ((pass == 0) != (ai->ai_family == AF_INET6)) {
+        continue;
+      }
+
+      fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                  ai->ai_protocol);
+
+      if (fd < 0) {
+        err = errno;
+        continue;
+      }
+
+      int one = 1;
+      int zero = 0;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+      if (ai->ai_family == AF_INET6) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+      }
+
+      if (bind(fd, ai->ai_addr, ai->ai_addrlen) || listen(fd, 16)) {
+        err = errno;
+        close(fd);
+        fd = -1;
+      }
+    }
+  }
+
+  freeaddrinfo(result);
+
+  if (fd < 0) {
+    MDException ex(err);
+    ex.getMessage() << "Unable to listen on stream port " << port << ": "
+                    << strerror(err);
+    throw ex;
+  }
+
+  sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  getsockname(fd, (sockaddr*) &addr, &len);
+  mPort = ntohs(addr.ss_family == AF_INET6 ?
+                ((sockaddr_in6*) &addr)->sin6_port :
+                ((sockaddr_in*) &addr)->sin_port);
+  mListenFd = fd;
+  mRunning = true;
+  mAcceptThread = std::thread(&ChangeLogStreamServer::acceptLoop, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop listening and drop all subscriptions
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::stop()
+{
+  if (!mRunning.exchange(false)) {
+    return;
+  }
+
+  mAcceptThread.join();
+  close(mListenFd);
+  mListenFd = -1;
+  std::list<std::unique_ptr<Subscriber>> subscribers;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    subscribers.swap(mSubscribers);
+  }
+
+  for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+    shutdown((*it)->fd, SHUT_RDWR);
+  }
+
+  for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+    (*it)->thread.join();
+    close((*it)->fd);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the state of all subscriptions
+//------------------------------------------------------------------------------
+std::vector<ChangeLogStreamServer::SubscriberStatus>
+ChangeLogStreamServer::getSubscribers()
+{
+  std::vector<SubscriberStatus> result;
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto it = mSubscribers.begin(); it != mSubscribers.end(); ++it) {
+    if (!(*it)->done && !(*it)->status.channel.empty()) {
+      result.push_back((*it)->status);
+    }
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Accept new subscriptions and reap the finished ones
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::acceptLoop()
+{
+  while (mRunning) {
+    std::list<std::unique_ptr<Subscriber>> finished;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      for (auto it = mSubscribers.begin(); it != mSubscribers.end();) {
+        if ((*it)->done) {
+          finished.push_back(std::move(*it));
+          it = mSubscribers.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    for (auto it = finished.begin(); it != finished.end(); ++it) {
+      (*it)->thread.join();
+      close((*it)->fd);
+    }
+
+    pollfd pfd;
+    pfd.fd = mListenFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if (poll(&pfd, 1, 500) != 1) {
+      continue;
+    }
+
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    int fd = accept4(mListenFd, (sockaddr*) &addr, &len, SOCK_CLOEXEC);
+
+    if (fd < 0) {
+      continue;
+    }
+
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    std::unique_ptr<Subscriber> sub(new Subscriber());
+    sub->fd = fd;
+    sub->addr = addr;
+    sub->done = false;
+    sub->status.seq = sub->status.ackedSeq = 0;
+    sub->status.sentOffset = sub->status.ackedOffset = 0;
+    sub->status.endOffset = 0;
+    sub->status.lastAck = 0;
+
+    if (!getnameinfo((sockaddr*) &addr, len, host, sizeof(host), serv,
+                     sizeof(serv), NI_NUMERICHOST | NI_NUMERICSERV)) {
+      sub->status.peer = std::string(host) + ":" + serv;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::lock_guard<std::mutex> lock(mMutex);
+    Subscriber* ptr = sub.get();
+    mSubscribers.push_back(std::move(sub));
+    ptr->thread = std::thread(&ChangeLogStreamServer::serve, this, ptr);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Serve one subscription
+//------------------------------------------------------------------------------
+void ChangeLogStreamServer::serve(Subscriber* sub)
+{
+  int sock = sub->fd;
+  Header hdr;
+  std::string payload;
+  std::string secret;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    secret = mSecret;
+  }
+
+  if (!isAllowed(sub->addr)) {
+    std::string msg = "host " + sub->status.peer + " is not allowed";
+    sendMessage(sock, kError, 0, 0, 0, msg.c_str(), msg.size());
+    sub->done = true;
+    return;
+  }
+
+  if (secret.empty()) {
+    std::string msg = "no shared secret configured on the master";
+    sendMessage(sock, kError, 0, 0, 0, msg.c_str(), msg.size());
+    sub->done = true;
+    return;
+  }
+
+  // challenge the slave to prove the shared secret
+  std::string master_nonce;
+
+  if (!makeNonce(master_nonce) ||
+      !sendMessage(sock, kChallenge, 0, 0, 0, master_nonce.c_str(),
+                   master_nonce.size())) {
+    sub->done = true;
+    return;
+  }
+
+  if (!readFull(sock, &hdr, sizeof(hdr), kSilenceMs) || hdr.magic != kMagic ||
+      hdr.type != kSubscribe || !readPayload(sock, hdr, payload, kSilenceMs)) {
+    sub->done = true;
+    return;
+  }
+
+  uint64_t offset = hdr.offset;
+  size_t fplen = offset < kFingerprintSize ? offset : kFingerprintSize;
+
+  if (payload.size() < kNonceSize + kMacSize + fplen) {
+    sub->done = true;
+    return;
+  }
+
+  std::string slave_nonce = payload.substr(0, kNonceSize);
+  std::string mac = payload.substr(kNonceSize, kMacSize);
+  std::string fingerprint = payload.substr(kNonceSize + kMacSize, fplen);
+  std::string channel = payload.substr(kNonceSize + kMacSize + fplen);
+
+  if (!sameMac(mac, computeMac(secret, subscribeData(master_nonce, slave_nonce,
+                               offset, fingerprint, channel)))) {
+    std::string msg = "authentication failed";
+    sendMessage(sock, kError, 0, 0, 0, msg.c_str(), msg.size());
+    sub->done = true;
+    return;
+  }
+
+  // prove the shared secret to the slave
+  mac = computeMac(secret, authData(master_nonce, slave_nonce));
+
+  if (!sendMessage(sock, kAuth, 0, 0, 0, mac.c_str(), mac.size())) {
+    sub->done = true;
+    return;
+  }
+
+  std::string path;
+
+  if (!getChannel(channel, path)) {
+    std::string msg = "unknown channel '" + channel + "'";
+    sendMessage(sock, kError, 0, 0, 0, msg.c_str(), msg.size());
+    sub->done = true;
+    return;
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat buf;
+
+  if (fd < 0 || fstat(fd, &buf)) {
+    std::string msg = "unable to open " + path + ": " + strerror(errno);
+    sendMessage(sock, kError, 0, 0, 0, msg.c_str(), msg.size());
+
+    if (fd >= 0) {
+      close(fd);
+    }
+
+    sub->done = true;
+    return;
+  }
+
+  ino_t inode = buf.st_ino;
+  uint64_t end = buf.st_size;
+  // the slave has to hold a prefix of our file ending at a record boundary
+  std::string reason;
+  char tmp[kFingerprintSize];
+
+  if (offset && offset < 8) {
+    reason = "offset inside the file header";
+  } else if (offset > end) {
+    reason = "offset beyond the end of the master file";
+  } else if (fplen && (!preadFull(fd, tmp, fplen, offset - fplen) ||
+                       memcmp(tmp, fingerprint.c_str(), fplen))) {
+    reason = "content differs from the master file";
+  } else if (offset > 8 && offset < end &&
+             (!preadFull(fd, tmp, 4, offset) ||
+              !ChangeLogFile::getRecordLength(tmp))) {
+    reason = "offset is not at a record boundary";
+  }
+
+  if (!reason.empty()) {
+    sendMessage(sock, kResync, 0, 0, end, reason.c_str(), reason.size());
+    close(fd);
+    sub->done = true;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    sub->status.channel = channel;
+    sub->status.sentOffset = sub->status.ackedOffset = offset;
+    sub->status.endOffset = end;
+    sub->status.lastAck = time(0);
+  }
+  int ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (ifd >= 0) {
+    inotify_add_watch(ifd, path.c_str(), IN_MODIFY);
+  }
+
+  std::vector<char> chunk(kChunkSize);
+  uint64_t sent = offset;
+  uint64_t seq = 0;
+  int64_t last_send = 0;
+  int64_t last_check = nowMs();
+  bool ok = sendMessage(sock, kHeartbeat, seq, sent, end);
+
+  while (ok && mRunning) {
+    if (fstat(fd, &buf) || (uint64_t) buf.st_size < sent) {
+      // truncated - the slave has to resubscribe
+      break;
+    }
+
+    end = buf.st_size;
+
+    if (sent < end) {
+      size_t nread = (end - sent) < kChunkSize ? (end - sent) : kChunkSize;
+
+      if (!preadFull(fd, chunk.data(), nread, sent)) {
+        break;
+      }
+
+      // send only complete records, the file header goes with the first ones
+      size_t pos = sent ? 0 : 8;
+
+      if (pos > nread) {
+        pos = 0;
+      }
+
+      while (pos + 4 <= nread) {
+        uint32_t len = ChangeLogFile::getRecordLength(chunk.data() + pos);
+
+        if (!len) {
+          std::string msg = "corrupted master changelog at offset " +
+                            std::to_string(sent + pos);
+          sendMessage(sock, kError, seq, sent, end, msg.c_str(), msg.size());
+          ok = false;
+          break;
+        }
+
+        if (pos + len > nread) {
+          break;
+        }
+
+        pos += len;
+      }
+
+      if (!ok) {
+        break;
+      }
+
+      if (pos) {
+        ok = sendMessage(sock, kData, ++seq, sent, end, chunk.data(), pos);
+        sent += pos;
+        last_send = nowMs();
+        std::lock_guard<std::mutex> lock(mMutex);
+        sub->status.seq = seq;
+        sub->status.sentOffset = sent;
+        sub->status.endOffset = end;
+        continue;
+      }
+    }
+
+    // wait for acknowledgements, new data or the next heartbeat
+    pollfd pfd[2];
+    pfd[0].fd = sock;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd = ifd;
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+    int64_t wait = kHeartbeatMs - (nowMs() - last_send);
+    int rc = poll(pfd, ifd >= 0 ? 2 : 1, wait < 0 ? 0 : (ifd >= 0 ? wait : 100));
+
+    if (rc < 0 && errno != EINTR) {
+      break;
+    }
+
+    if (rc > 0 && pfd[0].revents) {
+      if (!readFull(sock, &hdr, sizeof(hdr), kSilenceMs) ||
+          hdr.magic != kMagic || hdr.type != kAck ||
+          !readPayload(sock, hdr, payload, kSilenceMs)) {
+        break;
+      }
+
+      std::lock_guard<std::mutex> lock(mMutex);
+      sub->status.ackedSeq = hdr.seq;
+      sub->status.ackedOffset = hdr.offset;
+      sub->status.lastAck = time(0);
+    }
+
+    if (rc > 0 && ifd >= 0 && pfd[1].revents) {
+      char events[4096];
+
+      while (read(ifd, events, sizeof(events)) > 0) {}
+    }
+
+    if (nowMs() - last_send >= kHeartbeatMs) {
+      ok = sendMessage(sock, kHeartbeat, seq, sent, end);
+      last_send = nowMs();
+    }
+
+    if (nowMs() - last_check >= kHeartbeatMs) {
+      // a replaced file (e.g. compaction) means a new subscription
+      last_check = nowMs();
+      struct stat pbuf;
+
+      if (::stat(path.c_str(), &pbuf) || pbuf.st_ino != inode) {
+        break;
+      }
+    }
+  }
+
+  if (ifd >= 0) {
+    close(ifd);
+  }
+
+  close(fd);
+  sub->done = true;
+}
+
+//------------------------------------------------------------------------------
+// Client constructor
+//------------------------------------------------------------------------------
+ChangeLogStreamClient::ChangeLogStreamClient(const std::string& host, int port,
+    const std::string& channel, const std::string& path,
+    const std::string& secret):
+  mHost(host.substr(0, host.find(':'))), mPort(port), mChannel(channel),
+  mPath(path), mSecret(secret), mRunning(false), mSocket(-1)
+{
+  mStatus.connected = false;
+  mStatus.seq = mStatus.localOffset = mStatus.masterOffset = 0;
+  mStatus.resyncs = 0;
+  mStatus.lastContact = mStatus.behindSince = 0;
+}
+
+//------------------------------------------------------------------------------
+// Client destructor
+//------------------------------------------------------------------------------
+ChangeLogStreamClient::~ChangeLogStreamClient()
+{
+  stop();
+}
+
+//------------------------------------------------------------------------------
+// Start following the master
+//------------------------------------------------------------------------------
+void ChangeLogStreamClient::start()
+{
+  if (mRunning.exchange(true)) {
+    return;
+  }
+
+  mThread = std::thread(&ChangeLogStreamClient::run, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop following the master
+//------------------------------------------------------------------------------
+void ChangeLogStreamClient::stop()
+{
+  if (!mRunning.exchange(false)) {
+    return;
+  }
+
+  int sock = mSocket;
+
+  if (sock >= 0) {
+    shutdown(sock, SHUT_RDWR);
+  }
+
+  mThread.join();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStatus.connected = false;
+}
+
+//------------------------------------------------------------------------------
+// Get the replication state
+//------------------------------------------------------------------------------
+ChangeLogStreamClient::Status ChangeLogStreamClient::getStatus()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStatus;
+}
+
+//------------------------------------------------------------------------------
+// Wait until the local file has caught up with the master
+//------------------------------------------------------------------------------
+bool ChangeLogStreamClient::waitInSync(int timeout)
+{
+  time_t start = time(0);
+
+  do {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      // the master end offset has to be reported after we started waiting
+      if (mStatus.connected && mStatus.lastContact > start &&
+          mStatus.localOffset == mStatus.masterOffset) {
+        return true;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  } while (time(0) - start <= timeout);
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Remember the last error
+//------------------------------------------------------------------------------
+void ChangeLogStreamClient::setError(const std::string& msg)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStatus.lastError = msg;
+  mStatus.connected = false;
+}
+
+//------------------------------------------------------------------------------
+// Subscription loop
+//------------------------------------------------------------------------------
+void ChangeLogStreamClient::run()
+{
+  int fd = ::open(mPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  bool staging = false;
+
+  if (fd < 0) {
+    setError("unable to open " + mPath + ": " + strerror(errno));
+    return;
+  }
+
+  while (mRunning) {
+    uint64_t local = lseek(fd, 0, SEEK_END);
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStatus.localOffset = local;
+    }
+    std::string error;
+    int sock = connectTo(mHost, mPort, kSilenceMs, error);
+    bool resync = false;
+
+    if (sock < 0) {
+      setError(error);
+    } else {
+      mSocket = sock;
+
+      if (!mRunning) {
+        // stop() might have missed the new socket
+        shutdown(sock, SHUT_RDWR);
+      }
+
+      // subscribe with the offset and the last bytes we hold
+      size_t fplen = local < kFingerprintSize ? local : kFingerprintSize;
+      std::string fingerprint(fplen, '\0');
+      std::string auth;
+
+      if (fplen && !preadFull(fd, &fingerprint[0], fplen, local - fplen)) {
+        resync = true;
+      } else {
+        resync = subscribe(sock, local, fingerprint, auth) &&
+                 follow(sock, fd, staging, auth);
+      }
+
+      mSocket = -1;
+      close(sock);
+    }
+
+    if (resync && mRunning) {
+      // Start over from the beginning of the master file. The copy is built
+      // in a staging file replacing the local file once it caught up, so that
+      // readers of the local file see a new inode as after a compaction.
+      std::string stage = mPath + ".resync";
+      int sfd = ::open(stage.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                       0644);
+
+      if (sfd < 0) {
+        setError("unable to open " + stage + ": " + strerror(errno));
+      } else {
+        close(fd);
+        fd = sfd;
+        staging = true;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStatus.resyncs++;
+        mStatus.connected = false;
+        continue;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStatus.connected = false;
+    }
+
+    for (int i = 0; i < 10 && mRunning; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  close(fd);
+}
+
+//------------------------------------------------------------------------------
+// Answer the challenge of the master and subscribe, returns the MAC expected
+// from the master in auth
+//------------------------------------------------------------------------------
+bool ChangeLogStreamClient::subscribe(int sock, uint64_t local,
+                                      const std::string& fingerprint,
+                                      std::string& auth)
+{
+  Header hdr;
+  std::string master_nonce;
+
+  if (!readFull(sock, &hdr, sizeof(hdr), kSilenceMs) || hdr.magic != kMagic ||
+      !readPayload(sock, hdr, master_nonce, kSilenceMs)) {
+    setError("connection to the master lost");
+    return false;
+  }
+
+  if (hdr.type == kError) {
+    setError("master error: " + master_nonce);
+    return false;
+  }
+
+  if (hdr.type != kChallenge || master_nonce.size() != kNonceSize) {
+    setError("unexpected message type " + std::to_string(hdr.type));
+    return false;
+  }
+
+  std::string slave_nonce;
+
+  if (mSecret.empty() || !makeNonce(slave_nonce)) {
+    setError("no shared secret to authenticate with the master");
+    return false;
+  }
+
+  std::string mac = computeMac(mSecret, subscribeData(master_nonce, slave_nonce,
+                               local, fingerprint, mChannel));
+  std::string payload = slave_nonce + mac + fingerprint + mChannel;
+  auth = computeMac(mSecret, authData(master_nonce, slave_nonce));
+
+  if (!sendMessage(sock, kSubscribe, 0, local, 0, payload.c_str(),
+                   payload.size())) {
+    setError("connection to the master lost");
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Follow a subscription, returns true if a resync is requested
+//------------------------------------------------------------------------------
+bool ChangeLogStreamClient::follow(int sock, int fd, bool& staging,
+                                   const std::string& auth)
+{
+  uint64_t local = lseek(fd, 0, SEEK_END);
+  std::vector<char> data;
+  std::string payload;
+  Header hdr;
+  bool authenticated = false;
+
+  while (mRunning) {
+    if (!readFull(sock, &hdr, sizeof(hdr), kSilenceMs) || hdr.magic != kMagic) {
+      setError("connection to the master lost");
+      return false;
+    }
+
+    // the master has to prove the shared secret before anything is applied
+    if (!authenticated && (hdr.type != kError)) {
+      if ((hdr.type != kAuth) || !readPayload(sock, hdr, payload, kSilenceMs) ||
+          !sameMac(payload, auth)) {
+        setError("master authentication failed");
+        return false;
+      }
+
+      authenticated = true;
+      continue;
+    }
+
+    if (hdr.type == kData) {
+      if (hdr.offset != local || hdr.length > kChunkSize) {
+        setError("unexpected data at offset " + std::to_string(hdr.offset));
+        return false;
+      }
+
+      data.resize(hdr.length);
+
+      if (!readFull(sock, data.data(), hdr.length, kSilenceMs)) {
+        setError("connection to the master lost");
+        return false;
+      }
+
+      if (!pwriteFull(fd, data.data(), hdr.length, local) || fdatasync(fd)) {
+        setError("unable to write " + mPath + ": " + strerror(errno));
+        return false;
+      }
+
+      local += hdr.length;
+
+      if (!sendMessage(sock, kAck, hdr.seq, local, hdr.end)) {
+        setError("connection to the master lost");
+        return false;
+      }
+    } else if (hdr.type == kHeartbeat) {
+      // nothing to do but to update the state below
+    } else if ((hdr.type == kResync) || (hdr.type == kError)) {
+      readPayload(sock, hdr, payload, kSilenceMs);
+      setError((hdr.type == kResync ? "resynchronizing: " : "master error: ") +
+               payload);
+      return (hdr.type == kResync);
+    } else {
+      setError("unexpected message type " + std::to_string(hdr.type));
+      return false;
+    }
+
+    if (staging && local >= hdr.end) {
+      std::string stage = mPath + ".resync";
+
+      if (::rename(stage.c_str(), mPath.c_str())) {
+        setError("unable to rename " + stage + ": " + strerror(errno));
+        return false;
+      }
+
+      staging = false;
+    }
+
+    time_t now = time(0);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStatus.connected = true;
+    mStatus.seq = hdr.seq;
+    mStatus.localOffset = local;
+    mStatus.masterOffset = hdr.end;
+    mStatus.lastContact = now;
+
+    if (local >= hdr.end) {
+      mStatus.behindSince = 0;
+    } else if (!mStatus.behindSince) {
+      mStatus.behindSince = now;
+    }
+  }
+
+  return false;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,291 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @author agent <agent@local>
+//! @brief Streaming replication of changelog files from master to slaves
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_CHANGE_LOG_STREAM_HH
+#define EOS_NS_CHANGE_LOG_STREAM_HH
+
+#include "namespace/Namespace.hh"
+#include "namespace/MDException.hh"
+#include <stdint.h>
+#include <sys/socket.h>
+#include <ctime>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Wire protocol of the changelog stream.
+//!
+//! Every message is a fixed header optionally followed by 'length' payload
+//! bytes. Both ends share a secret (the instance symkey). The master opens
+//! with a kChallenge carrying a random nonce. The slave answers with a
+//! kSubscribe whose payload starts with its own nonce and an HMAC-SHA256
+//! over both nonces, the offset, the fingerprint and the channel; the master
+//! proves the secret in turn with a kAuth carrying an HMAC over the nonces.
+//! Nothing is streamed before both sides are authenticated. A slave subscribes to a named channel with the offset it wants to
+//! resume from and the last (up to kFingerprintSize) bytes it holds before
+//! that offset. The master checks that these bytes match its own file, so a
+//! slave holding a different file (e.g. after compaction on the master) is
+//! told to resynchronize from scratch. The master then streams complete
+//! records in kData messages carrying a per-subscription sequence number and
+//! the file offset of the payload. The slave appends the payload at exactly
+//! that offset and acknowledges the sequence number and its new end offset.
+//! An idle master sends a heartbeat every second, all messages carry the
+//! current end offset of the master file so that both ends know the lag.
+//------------------------------------------------------------------------------
+namespace ChangeLogStreamProtocol
+{
+enum Type {
+  kSubscribe = 1, //!< slave => master: payload nonce + mac + fingerprint +
+                  //!< channel name
+  kData      = 2, //!< master => slave: payload changelog bytes
+  kHeartbeat = 3, //!< master => slave: no payload
+  kAck       = 4, //!< slave => master: no payload
+  kResync    = 5, //!< master => slave: restart from offset 0, payload reason
+  kError     = 6, //!< master => slave: payload reason
+  kChallenge = 7, //!< master => slave: payload nonce
+  kAuth      = 8  //!< master => slave: payload mac
+};
+
+struct Header {
+  uint32_t magic;  //!< kMagic
+  uint32_t type;   //!< message type
+  uint64_t seq;    //!< sequence number of the data message
+  uint64_t offset; //!< file offset (data: of the payload, ack: new end)
+  uint64_t end;    //!< end offset of the master file
+  uint64_t length; //!< payload length
+};
+
+const uint32_t kMagic = 0x45434c53;
+const size_t kFingerprintSize = 16;
+const size_t kNonceSize = 16;
+const size_t kMacSize = 32;
+}
+
+//------------------------------------------------------------------------------
+//! Master side: serves changelog files to subscribed slaves
+//------------------------------------------------------------------------------
+class ChangeLogStreamServer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! State of one subscription
+  //----------------------------------------------------------------------------
+  struct SubscriberStatus {
+    std::string peer; ///< address of the slave
+    std::string channel; ///< subscribed channel
+    uint64_t seq; ///< last sequence number sent
+    uint64_t ackedSeq; ///< last sequence number acknowledged
+    uint64_t sentOffset; ///< end of the data sent
+    uint64_t ackedOffset; ///< end of the data acknowledged
+    uint64_t endOffset; ///< end of the master file
+    time_t lastAck; ///< time of the last acknowledgement
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ChangeLogStreamServer();
+
+  //----------------------------------------------------------------------------
+  //! Destructor - stops the server
+  //----------------------------------------------------------------------------
+  ~ChangeLogStreamServer();
+
+  //----------------------------------------------------------------------------
+  //! Define or change the file served on a channel. Running subscriptions of
+  //! the channel are dropped and resume on the new file.
+  //----------------------------------------------------------------------------
+  void setChannel(const std::string& name, const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Remove all channels and drop all subscriptions
+  //----------------------------------------------------------------------------
+  void clearChannels();
+
+  //----------------------------------------------------------------------------
+  //! Set the secret shared with the slaves, subscriptions are refused as long
+  //! as no secret is set
+  //----------------------------------------------------------------------------
+  void setSecret(const std::string& secret);
+
+  //----------------------------------------------------------------------------
+  //! Restrict the subscriptions to the given hosts, an empty list allows any
+  //! host. The names are resolved when a subscription comes in.
+  //----------------------------------------------------------------------------
+  void setAllowedHosts(const std::vector<std::string>& hosts);
+
+  //----------------------------------------------------------------------------
+  //! Start listening
+  //!
+  //! @param port TCP port, 0 to pick a free one (see getPort)
+  //! @param bind_address address to listen on, empty for any
+  //----------------------------------------------------------------------------
+  void start(int port, const std::string& bind_address = "")
+  throw(MDException);
+
+  //----------------------------------------------------------------------------
+  //! Stop listening and drop all subscriptions
+  //----------------------------------------------------------------------------
+  void stop();
+
+  //----------------------------------------------------------------------------
+  //! Port the server is listening on
+  //----------------------------------------------------------------------------
+  int getPort() const
+  {
+    return mPort;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the state of all subscriptions
+  //----------------------------------------------------------------------------
+  std::vector<SubscriberStatus> getSubscribers();
+
+private:
+  struct Subscriber {
+    int fd;
+    sockaddr_storage addr; ///< address of the slave
+    std::thread thread;
+    std::atomic<bool> done;
+    SubscriberStatus status;
+  };
+
+  void acceptLoop();
+  void serve(Subscriber* sub);
+  void dropSubscribers(const std::string& channel);
+  bool getChannel(const std::string& name, std::string& path);
+  bool isAllowed(const sockaddr_storage& addr);
+
+  int mListenFd;
+  int mPort;
+  std::atomic<bool> mRunning;
+  std::thread mAcceptThread;
+  std::mutex mMutex; ///< protects the members below
+  std::map<std::string, std::string> mChannels; ///< channel => file path
+  std::string mSecret; ///< secret shared with the slaves
+  std::vector<std::string> mAllowedHosts; ///< hosts allowed to subscribe
+  std::list<std::unique_ptr<Subscriber>> mSubscribers;
+};
+
+//------------------------------------------------------------------------------
+//! Slave side: follows one channel of a master into a local changelog file
+//------------------------------------------------------------------------------
+class ChangeLogStreamClient
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Replication state
+  //----------------------------------------------------------------------------
+  struct Status {
+    bool connected; ///< subscription is established
+    uint64_t seq; ///< last sequence number received
+    uint64_t localOffset; ///< end of the local file
+    uint64_t masterOffset; ///< end of the master file as last reported
+    uint64_t resyncs; ///< number of full resynchronizations
+    time_t lastContact; ///< time of the last message from the master
+    time_t behindSince; ///< time since the local file is behind, 0 if not
+    std::string lastError; ///< last connection/protocol error
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param host master host name, an optional ':<port>' is ignored
+  //! @param port master stream port
+  //! @param channel channel to subscribe to
+  //! @param path local changelog file
+  //! @param secret secret shared with the master
+  //----------------------------------------------------------------------------
+  ChangeLogStreamClient(const std::string& host, int port,
+                        const std::string& channel, const std::string& path,
+                        const std::string& secret);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - stops the client
+  //----------------------------------------------------------------------------
+  ~ChangeLogStreamClient();
+
+  //----------------------------------------------------------------------------
+  //! Start following the master. If the master holds a different file (e.g.
+  //! after a compaction) it is copied into '<path>.resync', which is renamed
+  //! over the local file once it is complete.
+  //----------------------------------------------------------------------------
+  void start();
+
+  //----------------------------------------------------------------------------
+  //! Stop following the master
+  //----------------------------------------------------------------------------
+  void stop();
+
+  //----------------------------------------------------------------------------
+  //! Get the replication state
+  //----------------------------------------------------------------------------
+  Status getStatus();
+
+  //----------------------------------------------------------------------------
+  //! Wait until the local file has caught up with the master
+  //!
+  //! @param timeout max. time to wait in seconds
+  //!
+  //! @return true if in sync, false on timeout
+  //----------------------------------------------------------------------------
+  bool waitInSync(int timeout);
+
+  //----------------------------------------------------------------------------
+  //! Get the channel name
+  //----------------------------------------------------------------------------
+  const std::string& getChannel() const
+  {
+    return mChannel;
+  }
+
+private:
+  void run();
+  bool subscribe(int sock, uint64_t local, const std::string& fingerprint,
+                 std::string& auth);
+  bool follow(int sock, int fd, bool& staging, const std::string& auth);
+  void setError(const std::string& msg);
+
+  std::string mHost;
+  int mPort;
+  std::string mChannel;
+  std::string mPath;
+  std::string mSecret;
+  std::atomic<bool> mRunning;
+  std::atomic<int> mSocket; ///< socket of the running subscription
+  std::thread mThread;
+  std::mutex mMutex; ///< protects mStatus
+  Status mStatus;
+};
+
+EOSNSNAMESPACE_END
+
+#endif // EOS_NS_CHANGE_LOG_STREAM_HH
@@ -0,0 +1,112 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// author: agent <agent@local>
+// desc:   Namespace checkpoint image utility
+//------------------------------------------------------------------------------
+
+#include <iostream>
+#include <string>
+#include "namespace/utils/DisplayHelper.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogCheckpoint.hh"
+
+//------------------------------------------------------------------------------
+// Print the image header
+//------------------------------------------------------------------------------
+static void printInfo(const eos::ChangeLogCheckpoint::Info& info)
+{
+  std::cerr << "Content flag:           0x" << std::hex << info.contentFlag;
+  std::cerr << std::dec << std::endl;
+  std::cerr << "Covered offset:         " << info.coveredOffset << std::endl;
+  std::cerr << "Largest id:             " << info.largestId     << std::endl;
+  std::cerr << "Entries:                " << info.numEntries    << std::endl;
+  std::cerr << "Created:                " << info.ctime         << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Here we go
+//------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  //----------------------------------------------------------------------------
+  // Check the commandline parameters
+  //----------------------------------------------------------------------------
+  std::string cmd = (argc > 1) ? argv[1] : "";
+
+  if (argc != 4 || (cmd != "create" && cmd != "verify" && cmd != "diff")) {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  " << argv[0] << " create log_file image_file";
+    std::cerr << std::endl;
+    std::cerr << "  " << argv[0] << " verify log_file image_file";
+    std::cerr << std::endl;
+    std::cerr << "  " << argv[0] << " diff   log_file image_file";
+    std::cerr << std::endl;
+    return 1;
+  }
+
+  std::string logName = argv[2];
+  std::string imageName = argv[3];
+  eos::ChangeLogCheckpoint::Info info;
+
+  try {
+    //--------------------------------------------------------------------------
+    // Create or extend the image
+    //--------------------------------------------------------------------------
+    if (cmd == "create") {
+      eos::ChangeLogCheckpoint::CreateStats stats;
+      eos::ChangeLogCheckpoint::create(logName, imageName, info, stats);
+      printInfo(info);
+      std::cerr << "Incremental:            ";
+      std::cerr << (stats.incremental ? "yes" : "no") << std::endl;
+      std::cerr << "Records scanned:        " << stats.recordsScanned;
+      std::cerr << std::endl;
+      std::cerr << "Entries kept:           " << stats.entriesKept;
+      std::cerr << std::endl;
+      std::cerr << "Entries updated:        " << stats.entriesUpdated;
+      std::cerr << std::endl;
+      std::cerr << "Entries deleted:        " << stats.entriesDeleted;
+      std::cerr << std::endl;
+      std::cerr << "Elapsed time:           ";
+      std::cerr << eos::DisplayHelper::getReadableTime(stats.timeElapsed);
+      std::cerr << std::endl;
+      return 0;
+    }
+
+    //--------------------------------------------------------------------------
+    // Verify the image
+    //--------------------------------------------------------------------------
+    if (cmd == "verify") {
+      eos::ChangeLogCheckpoint::verify(imageName, logName, info);
+      printInfo(info);
+      std::cerr << "Image is valid" << std::endl;
+      return 0;
+    }
+
+    //--------------------------------------------------------------------------
+    // Compare the image with the changelog
+    //--------------------------------------------------------------------------
+    uint64_t diffs = eos::ChangeLogCheckpoint::diff(logName, imageName,
+                     std::cout);
+    std::cerr << "Differences:            " << diffs << std::endl;
+    return diffs ? 3 : 0;
+  } catch (eos::MDException& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 2;
+  }
+}
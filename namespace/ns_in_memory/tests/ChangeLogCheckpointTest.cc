@@ -0,0 +1,210 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// author: agent <agent@local>
+// desc:   Changelog checkpoint image test
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "namespace/ns_in_memory/persistency/ChangeLogCheckpoint.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
+#include "namespace/utils/TestHelpers.hh"
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class ChangeLogCheckpointTest: public CppUnit::TestCase
+{
+public:
+  CPPUNIT_TEST_SUITE(ChangeLogCheckpointTest);
+  CPPUNIT_TEST(checkpointTest);
+  CPPUNIT_TEST_SUITE_END();
+  void checkpointTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChangeLogCheckpointTest);
+
+typedef std::map<uint64_t, std::string> State;
+
+//------------------------------------------------------------------------------
+// Append random updates and deletions of ids in [1, maxId]
+//------------------------------------------------------------------------------
+static void appendRecords(const std::string& name, uint64_t maxId, int num)
+{
+  eos::ChangeLogFile file;
+  file.open(name, eos::ChangeLogFile::Create | eos::ChangeLogFile::Append,
+            eos::FILE_LOG_MAGIC);
+  eos::Buffer buffer;
+
+  for (int i = 0; i < num; ++i) {
+    uint64_t id = 1 + random() % maxId;
+    buffer.clear();
+    buffer.putData(&id, sizeof(id));
+
+    if (random() % 5) {
+      std::ostringstream o;
+      o << "file_" << id << "_" << random();
+      buffer.putData(o.str().c_str(), o.str().size());
+      file.storeRecord(eos::UPDATE_RECORD_MAGIC, buffer);
+    } else {
+      file.storeRecord(eos::DELETE_RECORD_MAGIC, buffer);
+    }
+  }
+
+  file.close();
+}
+
+//------------------------------------------------------------------------------
+// Apply records to an id => data map
+//------------------------------------------------------------------------------
+class StateBuilder: public eos::ILogRecordScanner
+{
+public:
+  StateBuilder(State& state): pState(state) {}
+  virtual bool processRecord(uint64_t offset, char type,
+                             const eos::Buffer& buffer)
+  {
+    uint64_t id;
+    buffer.grabData(0, &id, sizeof(id));
+
+    if (type == eos::UPDATE_RECORD_MAGIC) {
+      pState[id] = std::string(buffer.getDataPtr(), buffer.size());
+    } else if (type == eos::DELETE_RECORD_MAGIC) {
+      pState.erase(id);
+    }
+
+    return true;
+  }
+  State& pState;
+};
+
+//------------------------------------------------------------------------------
+// State out of the full changelog
+//------------------------------------------------------------------------------
+static State replayLog(const std::string& name)
+{
+  State state;
+  StateBuilder builder(state);
+  eos::ChangeLogFile file;
+  file.open(name, eos::ChangeLogFile::ReadOnly, eos::FILE_LOG_MAGIC);
+  file.scanAllRecords(&builder);
+  file.close();
+  return state;
+}
+
+//------------------------------------------------------------------------------
+// State out of the image and the changelog tail, empty if no usable image
+//------------------------------------------------------------------------------
+static State loadImage(const std::string& name, const std::string& image)
+{
+  State state;
+  StateBuilder builder(state);
+  eos::ChangeLogFile file;
+  uint64_t largestId = 0;
+  file.open(name, eos::ChangeLogFile::ReadOnly, eos::FILE_LOG_MAGIC);
+  uint64_t offset = eos::ChangeLogCheckpoint::load(image, &file, &builder,
+                    largestId);
+
+  if (offset) {
+    file.scanAllRecordsAtOffset(&builder, offset);
+  }
+
+  file.close();
+  return state;
+}
+
+//------------------------------------------------------------------------------
+// Create, extend, verify, diff and invalidate images
+//------------------------------------------------------------------------------
+void ChangeLogCheckpointTest::checkpointTest()
+{
+  srandom(time(0));
+  std::string logName = getTempName("/tmp", "eosns");
+  std::string imageName = logName + ".ckp";
+  eos::ChangeLogCheckpoint::Info info;
+  eos::ChangeLogCheckpoint::CreateStats stats;
+  //----------------------------------------------------------------------------
+  // Full image
+  //----------------------------------------------------------------------------
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(logName, 1000, 5000));
+  CPPUNIT_ASSERT_NO_THROW(eos::ChangeLogCheckpoint::create(logName, imageName,
+                          info, stats));
+  CPPUNIT_ASSERT(!stats.incremental);
+  CPPUNIT_ASSERT(stats.recordsScanned == 5000);
+  State state = replayLog(logName);
+  CPPUNIT_ASSERT(info.numEntries == state.size());
+  CPPUNIT_ASSERT(loadImage(logName, imageName) == state);
+  CPPUNIT_ASSERT_NO_THROW(eos::ChangeLogCheckpoint::verify(imageName, logName,
+                          info));
+  std::ostringstream out;
+  CPPUNIT_ASSERT(eos::ChangeLogCheckpoint::diff(logName, imageName, out) == 0);
+  //----------------------------------------------------------------------------
+  // The tail is replayed on top of the image and merged incrementally
+  //----------------------------------------------------------------------------
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(logName, 1500, 2000));
+  state = replayLog(logName);
+  CPPUNIT_ASSERT(loadImage(logName, imageName) == state);
+  CPPUNIT_ASSERT_NO_THROW(eos::ChangeLogCheckpoint::create(logName, imageName,
+                          info, stats));
+  CPPUNIT_ASSERT(stats.incremental);
+  CPPUNIT_ASSERT(stats.recordsScanned == 2000);
+  CPPUNIT_ASSERT(info.numEntries == state.size());
+  CPPUNIT_ASSERT(loadImage(logName, imageName) == state);
+  CPPUNIT_ASSERT(eos::ChangeLogCheckpoint::diff(logName, imageName, out) == 0);
+  //----------------------------------------------------------------------------
+  // A different changelog (e.g. compacted) does not use the image
+  //----------------------------------------------------------------------------
+  std::string otherName = getTempName("/tmp", "eosns");
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(otherName, 1000, 100));
+  CPPUNIT_ASSERT(loadImage(otherName, imageName).empty());
+  CPPUNIT_ASSERT_THROW(eos::ChangeLogCheckpoint::verify(imageName, otherName,
+                       info), eos::MDException);
+  CPPUNIT_ASSERT(eos::ChangeLogCheckpoint::diff(otherName, imageName, out) > 0);
+  //----------------------------------------------------------------------------
+  // A corrupted image is detected
+  //----------------------------------------------------------------------------
+  FILE* f = fopen(imageName.c_str(), "r+");
+  CPPUNIT_ASSERT(f);
+  fseek(f, 100, SEEK_SET);
+  int c = fgetc(f);
+  fseek(f, 100, SEEK_SET);
+  fputc(c ^ 0xff, f);
+  fclose(f);
+  CPPUNIT_ASSERT_THROW(eos::ChangeLogCheckpoint::verify(imageName, logName,
+                       info), eos::MDException);
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(logName, 1500, 100));
+  CPPUNIT_ASSERT_NO_THROW(eos::ChangeLogCheckpoint::create(logName, imageName,
+                          info, stats));
+  CPPUNIT_ASSERT(!stats.incremental);
+  CPPUNIT_ASSERT_NO_THROW(eos::ChangeLogCheckpoint::verify(imageName, logName,
+                          info));
+  CPPUNIT_ASSERT(loadImage(logName, imageName) == replayLog(logName));
+  unlink(logName.c_str());
+  unlink(otherName.c_str());
+  unlink(imageName.c_str());
+}
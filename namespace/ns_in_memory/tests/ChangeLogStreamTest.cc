@@ -0,0 +1,231 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// author: agent <agent@local>
+// desc:   Changelog streaming replication test
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFile.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogStream.hh"
+#include "namespace/utils/TestHelpers.hh"
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class ChangeLogStreamTest: public CppUnit::TestCase
+{
+public:
+  CPPUNIT_TEST_SUITE(ChangeLogStreamTest);
+  CPPUNIT_TEST(loopbackTest);
+  CPPUNIT_TEST_SUITE_END();
+  void loopbackTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChangeLogStreamTest);
+
+//------------------------------------------------------------------------------
+// Append records to a changelog file
+//------------------------------------------------------------------------------
+static void appendRecords(const std::string& name, int first, int num)
+{
+  eos::ChangeLogFile file;
+  file.open(name, eos::ChangeLogFile::Create | eos::ChangeLogFile::Append,
+            0x1212);
+  eos::Buffer buffer;
+
+  for (int i = first; i < first + num; ++i) {
+    std::ostringstream o;
+    o << "record_" << i;
+    buffer.clear();
+    buffer.putData(o.str().c_str(), o.str().size());
+    file.storeRecord(eos::UPDATE_RECORD_MAGIC, buffer);
+  }
+
+  file.close();
+}
+
+//------------------------------------------------------------------------------
+// Read a whole file
+//------------------------------------------------------------------------------
+static std::string readFile(const std::string& name)
+{
+  std::ifstream in(name.c_str(), std::ios::binary);
+  std::ostringstream o;
+  o << in.rdbuf();
+  return o.str();
+}
+
+//------------------------------------------------------------------------------
+// Count the records of a changelog file
+//------------------------------------------------------------------------------
+class RecordCounter: public eos::ILogRecordScanner
+{
+public:
+  RecordCounter(): pCount(0) {}
+  virtual bool processRecord(uint64_t offset, char type,
+                             const eos::Buffer& buffer)
+  {
+    ++pCount;
+    return true;
+  }
+  uint64_t pCount;
+};
+
+static uint64_t countRecords(const std::string& name)
+{
+  eos::ChangeLogFile file;
+  RecordCounter counter;
+  file.open(name, eos::ChangeLogFile::ReadOnly, 0x1212);
+  file.scanAllRecords(&counter);
+  file.close();
+  return counter.pCount;
+}
+
+//------------------------------------------------------------------------------
+// Run a master and a slave over a loopback socket
+//------------------------------------------------------------------------------
+void ChangeLogStreamTest::loopbackTest()
+{
+  std::string masterName = getTempName("/tmp", "eosns");
+  std::string slaveName = getTempName("/tmp", "eosns");
+  unlink(slaveName.c_str());
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(masterName, 0, 1000));
+  //----------------------------------------------------------------------------
+  // Initial replication of an existing file
+  //----------------------------------------------------------------------------
+  eos::ChangeLogStreamServer server;
+  CPPUNIT_ASSERT_NO_THROW(server.start(0, "127.0.0.1"));
+  CPPUNIT_ASSERT(server.getPort() > 0);
+  server.setChannel("files", masterName);
+  server.setSecret("secret");
+  std::unique_ptr<eos::ChangeLogStreamClient> client(
+    new eos::ChangeLogStreamClient("127.0.0.1", server.getPort(), "files",
+                                   slaveName, "secret"));
+  client->start();
+  CPPUNIT_ASSERT(client->waitInSync(10));
+  CPPUNIT_ASSERT(readFile(masterName) == readFile(slaveName));
+  //----------------------------------------------------------------------------
+  // Records appended on the master are streamed and acknowledged
+  //----------------------------------------------------------------------------
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(masterName, 1000, 500));
+  CPPUNIT_ASSERT(client->waitInSync(10));
+  CPPUNIT_ASSERT(readFile(masterName) == readFile(slaveName));
+  uint64_t masterSize = readFile(masterName).size();
+  std::vector<eos::ChangeLogStreamServer::SubscriberStatus> subscribers;
+
+  for (int i = 0; i < 50; ++i) {
+    subscribers = server.getSubscribers();
+
+    if (subscribers.size() == 1 && subscribers[0].ackedOffset == masterSize) {
+      break;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  CPPUNIT_ASSERT(subscribers.size() == 1);
+  CPPUNIT_ASSERT(subscribers[0].channel == "files");
+  CPPUNIT_ASSERT(subscribers[0].ackedOffset == masterSize);
+  CPPUNIT_ASSERT(subscribers[0].ackedSeq == subscribers[0].seq);
+  CPPUNIT_ASSERT(countRecords(slaveName) == 1500);
+  //----------------------------------------------------------------------------
+  // A restarted slave resumes from its offset
+  //----------------------------------------------------------------------------
+  client->stop();
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(masterName, 1500, 500));
+  client.reset(new eos::ChangeLogStreamClient("127.0.0.1", server.getPort(),
+               "files", slaveName, "secret"));
+  client->start();
+  CPPUNIT_ASSERT(client->waitInSync(10));
+  CPPUNIT_ASSERT(readFile(masterName) == readFile(slaveName));
+  CPPUNIT_ASSERT(client->getStatus().resyncs == 0);
+  CPPUNIT_ASSERT(countRecords(slaveName) == 2000);
+  //----------------------------------------------------------------------------
+  // A replaced master file (e.g. compaction) triggers a full resync
+  //----------------------------------------------------------------------------
+  struct stat before, after;
+  CPPUNIT_ASSERT(stat(slaveName.c_str(), &before) == 0);
+  std::string newName = getTempName("/tmp", "eosns");
+  CPPUNIT_ASSERT_NO_THROW(appendRecords(newName, 5000, 100));
+  CPPUNIT_ASSERT(rename(newName.c_str(), masterName.c_str()) == 0);
+
+  for (int i = 0; i < 100 && !client->getStatus().resyncs; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  CPPUNIT_ASSERT(client->getStatus().resyncs == 1);
+  CPPUNIT_ASSERT(client->waitInSync(10));
+  CPPUNIT_ASSERT(readFile(masterName) == readFile(slaveName));
+  CPPUNIT_ASSERT(countRecords(slaveName) == 100);
+  CPPUNIT_ASSERT(stat(slaveName.c_str(), &after) == 0);
+  CPPUNIT_ASSERT(before.st_ino != after.st_ino);
+  //----------------------------------------------------------------------------
+  // Unknown channels are refused
+  //----------------------------------------------------------------------------
+  eos::ChangeLogStreamClient other("127.0.0.1", server.getPort(), "none",
+                                   slaveName + ".none", "secret");
+  other.start();
+  CPPUNIT_ASSERT(!other.waitInSync(2));
+  CPPUNIT_ASSERT(other.getStatus().lastError.find("unknown channel") !=
+                 std::string::npos);
+  other.stop();
+  //----------------------------------------------------------------------------
+  // Slaves without the shared secret are refused
+  //----------------------------------------------------------------------------
+  eos::ChangeLogStreamClient intruder("127.0.0.1", server.getPort(), "files",
+                                      slaveName + ".intruder", "guess");
+  intruder.start();
+  CPPUNIT_ASSERT(!intruder.waitInSync(2));
+  CPPUNIT_ASSERT(intruder.getStatus().lastError.find("authentication failed")
+                 != std::string::npos);
+  CPPUNIT_ASSERT(readFile(slaveName + ".intruder").empty());
+  intruder.stop();
+  //----------------------------------------------------------------------------
+  // Only the allowed hosts can subscribe
+  //----------------------------------------------------------------------------
+  client->stop();
+  server.setAllowedHosts(std::vector<std::string>(1, "192.0.2.1"));
+  client.reset(new eos::ChangeLogStreamClient("127.0.0.1", server.getPort(),
+               "files", slaveName, "secret"));
+  client->start();
+  CPPUNIT_ASSERT(!client->waitInSync(2));
+  CPPUNIT_ASSERT(client->getStatus().lastError.find("is not allowed") !=
+                 std::string::npos);
+  client->stop();
+  server.setAllowedHosts(std::vector<std::string>(1, "127.0.0.1"));
+  client->start();
+  CPPUNIT_ASSERT(client->waitInSync(10));
+  client->stop();
+  server.stop();
+  unlink(masterName.c_str());
+  unlink(slaveName.c_str());
+  unlink((slaveName + ".none").c_str());
+  unlink((slaveName + ".intruder").c_str());
+}
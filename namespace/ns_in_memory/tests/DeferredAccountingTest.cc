@@ -0,0 +1,329 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// author: agent <agent@local>
+// desc:   Deferred versus synchronous tree size and mtime propagation
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "namespace/utils/TestHelpers.hh"
+#include "namespace/utils/Locking.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/ns_in_memory/views/HierarchicalView.hh"
+#include "namespace/ns_in_memory/accounting/ContainerAccounting.hh"
+#include "namespace/ns_in_memory/accounting/SyncTimeAccounting.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogContainerMDSvc.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFileMDSvc.hh"
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class DeferredAccountingTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE(DeferredAccountingTest);
+    CPPUNIT_TEST(deferredVsSyncTest);
+    CPPUNIT_TEST(removeTreeTest);
+    CPPUNIT_TEST_SUITE_END();
+
+    void deferredVsSyncTest();
+    void removeTreeTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeferredAccountingTest);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Namespace lock taken by the propagation thread
+  //----------------------------------------------------------------------------
+  class TestLock: public eos::LockHandler
+  {
+    public:
+      virtual void readLock() { mMutex.lock(); }
+      virtual void writeLock() { mMutex.lock(); }
+      virtual void unLock() { mMutex.unlock(); }
+
+    private:
+      std::mutex mMutex;
+  };
+
+  //----------------------------------------------------------------------------
+  // In-memory namespace with the tree size and mtime listeners attached
+  //----------------------------------------------------------------------------
+  struct TestNamespace
+  {
+    std::string fileChangeLog;
+    std::string contChangeLog;
+    eos::ChangeLogContainerMDSvc* contSvc;
+    eos::ChangeLogFileMDSvc* fileSvc;
+    eos::HierarchicalView* view;
+    eos::ContainerAccounting* treeAcc;
+    eos::SyncTimeAccounting* syncAcc;
+
+    TestNamespace()
+    {
+      contSvc = new eos::ChangeLogContainerMDSvc();
+      fileSvc = new eos::ChangeLogFileMDSvc();
+      view = new eos::HierarchicalView();
+      fileSvc->setContMDService(contSvc);
+      contSvc->setFileMDService(fileSvc);
+      std::map<std::string, std::string> fileSettings;
+      std::map<std::string, std::string> contSettings;
+      std::map<std::string, std::string> settings;
+      fileChangeLog = getTempName("/tmp", "eosns");
+      contChangeLog = getTempName("/tmp", "eosns");
+      contSettings["changelog_path"] = contChangeLog;
+      fileSettings["changelog_path"] = fileChangeLog;
+      fileSvc->configure(fileSettings);
+      contSvc->configure(contSettings);
+      view->setContainerMDSvc(contSvc);
+      view->setFileMDSvc(fileSvc);
+      view->configure(settings);
+      treeAcc = new eos::ContainerAccounting(contSvc);
+      syncAcc = new eos::SyncTimeAccounting(contSvc);
+      fileSvc->addChangeListener(treeAcc);
+      contSvc->setContainerAccounting(treeAcc);
+      contSvc->addChangeListener(syncAcc);
+      view->initialize();
+    }
+
+    ~TestNamespace()
+    {
+      delete treeAcc;
+      delete syncAcc;
+      view->finalize();
+      delete view;
+      delete fileSvc;
+      delete contSvc;
+      ::unlink(fileChangeLog.c_str());
+      ::unlink(contChangeLog.c_str());
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  // Set the mtime of a container and notify the listeners
+  //----------------------------------------------------------------------------
+  void touch(TestNamespace& ns, const std::string& path, time_t sec)
+  {
+    std::shared_ptr<eos::IContainerMD> cont = ns.view->getContainer(path);
+    eos::IContainerMD::ctime_t mtime;
+    mtime.tv_sec = sec;
+    mtime.tv_nsec = 0;
+    cont->setMTime(mtime);
+    cont->notifyMTimeChange(ns.contSvc);
+    ns.view->updateContainerStore(cont.get());
+  }
+
+  //----------------------------------------------------------------------------
+  // Create a file of the given size
+  //----------------------------------------------------------------------------
+  void create(TestNamespace& ns, const std::string& path, uint64_t size)
+  {
+    std::shared_ptr<eos::IFileMD> file = ns.view->createFile(path);
+    file->setSize(size);
+    ns.view->updateFileStore(file.get());
+  }
+
+  //----------------------------------------------------------------------------
+  // Unlink a file from its container the way the MGM remove does it
+  //----------------------------------------------------------------------------
+  void unlink(TestNamespace& ns, const std::string& path)
+  {
+    std::shared_ptr<eos::IFileMD> file = ns.view->getFile(path);
+    std::shared_ptr<eos::IContainerMD> cont =
+      ns.contSvc->getContainerMD(file->getContainerId());
+    cont->removeFile(file->getName());
+    file->setContainerId(0);
+    ns.view->updateFileStore(file.get());
+  }
+
+  //----------------------------------------------------------------------------
+  // Move a container to another parent the way the MGM rename does it
+  //----------------------------------------------------------------------------
+  void move(TestNamespace& ns, const std::string& src, const std::string& dst,
+            time_t sec)
+  {
+    std::shared_ptr<eos::IContainerMD> cont = ns.view->getContainer(src);
+    std::shared_ptr<eos::IContainerMD> oldParent =
+      ns.contSvc->getContainerMD(cont->getParentId());
+    std::shared_ptr<eos::IContainerMD> newParent = ns.view->getContainer(dst);
+    uint64_t treeSize = cont->getTreeSize();
+    eos::IContainerMD::ctime_t mtime;
+    mtime.tv_sec = sec;
+    mtime.tv_nsec = 0;
+    oldParent->removeContainer(cont->getName());
+    oldParent->setMTime(mtime);
+    oldParent->notifyMTimeChange(ns.contSvc);
+    ns.treeAcc->RemoveTree(oldParent.get(), treeSize);
+    ns.view->updateContainerStore(oldParent.get());
+    cont->setParentId(newParent->getId());
+    ns.view->updateContainerStore(cont.get());
+    newParent->addContainer(cont.get());
+    newParent->setMTime(mtime);
+    ns.treeAcc->AddTree(newParent.get(), treeSize);
+    newParent->notifyMTimeChange(ns.contSvc);
+    ns.view->updateContainerStore(newParent.get());
+  }
+
+  //----------------------------------------------------------------------------
+  // Remove a subtree bottom-up the way the MGM recursive remove does it
+  //----------------------------------------------------------------------------
+  void removeTree(TestNamespace& ns, const std::string& path)
+  {
+    std::shared_ptr<eos::IContainerMD> cont = ns.view->getContainer(path);
+    std::set<std::string> names = cont->getNameContainers();
+
+    for (auto it = names.begin(); it != names.end(); ++it)
+      removeTree(ns, path + "/" + *it);
+
+    names = cont->getNameFiles();
+
+    for (auto it = names.begin(); it != names.end(); ++it)
+      unlink(ns, path + "/" + *it);
+
+    ns.view->removeContainer(path);
+  }
+
+  //----------------------------------------------------------------------------
+  // Apply the same sequence of changes to a namespace, the times are in the
+  // future so that they win over the creation times
+  //----------------------------------------------------------------------------
+  void populate(TestNamespace& ns, time_t base)
+  {
+    const char* dirs[] = { "/a/b/c", "/a/d", "/x/y" };
+
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+      ns.view->createContainer(dirs[i], true);
+
+    const char* all[] = { "/a", "/a/b", "/a/b/c", "/a/d", "/x", "/x/y" };
+
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i)
+    {
+      std::shared_ptr<eos::IContainerMD> cont = ns.view->getContainer(all[i]);
+      cont->setAttribute("sys.mtime.propagation", "1");
+      ns.view->updateContainerStore(cont.get());
+    }
+
+    create(ns, "/a/b/c/f1", 1000);
+    create(ns, "/a/b/c/f2", 2000);
+    create(ns, "/a/b/f3", 300);
+    create(ns, "/a/d/f4", 40);
+    create(ns, "/x/y/f5", 5);
+    touch(ns, "/a/b/c", base + 10);
+    touch(ns, "/a/d", base + 20);
+    // grow and shrink files which are then moved with their container
+    ns.view->getFile("/a/b/c/f1")->setSize(1500);
+    ns.view->getFile("/a/b/c/f2")->setSize(100);
+    touch(ns, "/a/b/c", base + 30);
+    move(ns, "/a/b/c", "/x/y", base + 40);
+    // changes below the moved container after the move
+    create(ns, "/x/y/c/f6", 60000);
+    unlink(ns, "/a/d/f4");
+    touch(ns, "/x/y/c", base + 50);
+    touch(ns, "/a/d", base + 60);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Deferred and synchronous propagation give the same tree sizes and
+// propagated mtimes once the pending changes are flushed
+//------------------------------------------------------------------------------
+void DeferredAccountingTest::deferredVsSyncTest()
+{
+  time_t base = time(0) + 3600;
+  TestNamespace sync;
+  TestNamespace deferred;
+  TestLock lock;
+  // a long interval so that only stopDeferred applies the changes
+  deferred.treeAcc->setDeferred(&lock, 3600 * 1000);
+  deferred.syncAcc->setDeferred(&lock, 3600 * 1000);
+  populate(sync, base);
+  populate(deferred, base);
+  uint64_t pending = 0, lag_ms = 0, last_ms = 0;
+  CPPUNIT_ASSERT(deferred.treeAcc->getDeferredLag(pending, lag_ms, last_ms));
+  CPPUNIT_ASSERT(pending > 0);
+  CPPUNIT_ASSERT(deferred.syncAcc->getDeferredLag(pending, lag_ms, last_ms));
+  CPPUNIT_ASSERT(pending > 0);
+  deferred.treeAcc->stopDeferred();
+  deferred.syncAcc->stopDeferred();
+  CPPUNIT_ASSERT(!deferred.treeAcc->getDeferredLag(pending, lag_ms, last_ms));
+  CPPUNIT_ASSERT(pending == 0);
+  // the expected sizes after the move
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 61600,
+                       sync.view->getContainer("/x/y/c")->getTreeSize());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 61605,
+                       sync.view->getContainer("/x")->getTreeSize());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 300,
+                       sync.view->getContainer("/a")->getTreeSize());
+  const char* all[] = { "/a", "/a/b", "/a/d", "/x", "/x/y", "/x/y/c" };
+
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i)
+  {
+    std::shared_ptr<eos::IContainerMD> s = sync.view->getContainer(all[i]);
+    std::shared_ptr<eos::IContainerMD> d = deferred.view->getContainer(all[i]);
+    CPPUNIT_ASSERT_EQUAL(s->getTreeSize(), d->getTreeSize());
+    eos::IContainerMD::tmtime_t stime, dtime;
+    s->getTMTime(stime);
+    d->getTMTime(dtime);
+    CPPUNIT_ASSERT_EQUAL(stime.tv_sec, dtime.tv_sec);
+    CPPUNIT_ASSERT_EQUAL(stime.tv_nsec, dtime.tv_nsec);
+  }
+
+  // the propagated mtimes reached the top of both subtrees
+  eos::IContainerMD::tmtime_t tmtime;
+  sync.view->getContainer("/a")->getTMTime(tmtime);
+  CPPUNIT_ASSERT_EQUAL((time_t)(base + 60), tmtime.tv_sec);
+  sync.view->getContainer("/x")->getTMTime(tmtime);
+  CPPUNIT_ASSERT_EQUAL((time_t)(base + 50), tmtime.tv_sec);
+}
+
+//------------------------------------------------------------------------------
+// The pending size changes of removed containers still reach the ancestors
+//------------------------------------------------------------------------------
+void DeferredAccountingTest::removeTreeTest()
+{
+  TestNamespace ns;
+  TestLock lock;
+  ns.view->createContainer("/r/s/t", true);
+  create(ns, "/r/f0", 7);
+  create(ns, "/r/s/f1", 100);
+  create(ns, "/r/s/t/f2", 2000);
+  create(ns, "/r/s/t/f3", 30000);
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 32107,
+                       ns.view->getContainer("/r")->getTreeSize());
+  ns.treeAcc->setDeferred(&lock, 3600 * 1000);
+  // changes pending on containers which are removed before the flush
+  ns.view->getFile("/r/s/t/f2")->setSize(4000);
+  create(ns, "/r/s/f4", 500);
+  removeTree(ns, "/r/s");
+  ns.treeAcc->stopDeferred();
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 7,
+                       ns.view->getContainer("/r")->getTreeSize());
+}
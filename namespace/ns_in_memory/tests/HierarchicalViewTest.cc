@@ -29,6 +29,7 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <map>
 #include <pthread.h>
 
 #include "namespace/utils/TestHelpers.hh"
@@ -50,12 +51,14 @@ class HierarchicalViewTest: public CppUnit::TestCase
     CPPUNIT_TEST(quotaTest);
     CPPUNIT_TEST(lostContainerTest);
     CPPUNIT_TEST(onlineCompactingTest);
+    CPPUNIT_TEST(incrementalCompactingTest);
     CPPUNIT_TEST_SUITE_END();
 
     void reloadTest();
     void quotaTest();
     void lostContainerTest();
     void onlineCompactingTest();
+    void incrementalCompactingTest();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HierarchicalViewTest);
@@ -839,3 +842,219 @@ void HierarchicalViewTest::onlineCompactingTest()
   unlink(fileNameContMD.c_str());
   unlink(newFileLogName.c_str());
 }
+
+//------------------------------------------------------------------------------
+// Namespace mutations running concurrently with the incremental compacting,
+// the mutex stands for the namespace lock of the MGM
+//------------------------------------------------------------------------------
+struct MutatorData
+{
+  MutatorData(): stop(false), ops(0), first(0)
+  {
+    pthread_mutex_init(&mutex, 0);
+  }
+
+  std::shared_ptr<eos::IView> view;
+  pthread_mutex_t mutex;
+  volatile bool stop;
+  int ops;
+  int first;
+};
+
+void* mutatorThread(void* arg)
+{
+  MutatorData* md = (MutatorData*)arg;
+  int next = md->first;
+
+  while (!md->stop || (md->ops < 20000)) {
+    pthread_mutex_lock(&md->mutex);
+    std::ostringstream s;
+    int op = random() % 10;
+
+    if (op < 5) {
+      s << "/test/file" << next++;
+      md->view->createFile(s.str());
+    } else if (op < 8) {
+      s << "/test/file" << random() % next;
+      std::shared_ptr<eos::IFileMD> fmd;
+
+      try {
+        fmd = md->view->getFile(s.str());
+      } catch (eos::MDException& e) {}
+
+      if (fmd) {
+        fmd->setSize(random());
+        md->view->updateFileStore(fmd.get());
+      }
+    } else if (op < 9) {
+      s << "/test/file" << random() % next;
+
+      try {
+        md->view->removeFile(md->view->getFile(s.str()).get());
+      } catch (eos::MDException& e) {}
+    } else {
+      s << "/test/dir" << next++;
+      md->view->createContainer(s.str(), true);
+    }
+
+    ++md->ops;
+    pthread_mutex_unlock(&md->mutex);
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Get the names and sizes of the files and the containers below /test
+//------------------------------------------------------------------------------
+std::map<std::string, uint64_t> getTestState(std::shared_ptr<eos::IView> view)
+{
+  std::map<std::string, uint64_t> state;
+  std::shared_ptr<eos::IContainerMD> cont = view->getContainer("/test/");
+  std::set<std::string> names = cont->getNameFiles();
+
+  for (auto it = names.begin(); it != names.end(); ++it) {
+    state[*it] = cont->findFile(*it)->getSize();
+  }
+
+  names = cont->getNameContainers();
+
+  for (auto it = names.begin(); it != names.end(); ++it) {
+    state[*it + "/"] = cont->findContainer(*it)->getId();
+  }
+
+  return state;
+}
+
+//------------------------------------------------------------------------------
+// Incremental online compacting test
+//------------------------------------------------------------------------------
+void HierarchicalViewTest::incrementalCompactingTest()
+{
+  std::shared_ptr<eos::IContainerMDSvc> contSvc =
+    std::shared_ptr<eos::IContainerMDSvc>(new eos::ChangeLogContainerMDSvc());
+  std::shared_ptr<eos::IFileMDSvc> fileSvc =
+    std::shared_ptr<eos::IFileMDSvc>(new eos::ChangeLogFileMDSvc());
+  std::shared_ptr<eos::IView> view =
+    std::shared_ptr<eos::IView>(new eos::HierarchicalView());
+  fileSvc->setContMDService(contSvc.get());
+  contSvc->setFileMDService(fileSvc.get());
+  std::map<std::string, std::string> fileSettings;
+  std::map<std::string, std::string> contSettings;
+  std::map<std::string, std::string> settings;
+  std::string fileNameFileMD = getTempName("/tmp", "eosns");
+  std::string fileNameContMD = getTempName("/tmp", "eosns");
+  contSettings["changelog_path"] = fileNameContMD;
+  contSvc->configure(contSettings);
+  fileSettings["changelog_path"] = fileNameFileMD;
+  fileSvc->configure(fileSettings);
+  view->setContainerMDSvc(contSvc.get());
+  view->setFileMDSvc(fileSvc.get());
+  view->configure(settings);
+  view->initialize();
+  eos::ChangeLogFileMDSvc* clFileSvc =
+    dynamic_cast<eos::ChangeLogFileMDSvc*>(fileSvc.get());
+  eos::ChangeLogContainerMDSvc* clContSvc =
+    dynamic_cast<eos::ChangeLogContainerMDSvc*>(contSvc.get());
+  //----------------------------------------------------------------------------
+  // Create some files and rewrite them a few times
+  //----------------------------------------------------------------------------
+  CPPUNIT_ASSERT_NO_THROW(view->createContainer("/test/", true));
+
+  for (int i = 0; i < 10000; ++i) {
+    std::ostringstream s;
+    s << "/test/file" << i;
+    CPPUNIT_ASSERT_NO_THROW(view->createFile(s.str()));
+  }
+
+  for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < 10000; ++i) {
+      std::ostringstream s;
+      s << "/test/file" << i;
+      std::shared_ptr<eos::IFileMD> fmd = view->getFile(s.str());
+      fmd->setSize(j);
+      CPPUNIT_ASSERT_NO_THROW(view->updateFileStore(fmd.get()));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Compact while the namespace is being modified, the mutations go on
+  // during the update of the in-memory offsets
+  //----------------------------------------------------------------------------
+  MutatorData md;
+  md.view = view;
+  md.first = 10000;
+  pthread_t thread;
+  CPPUNIT_ASSERT(pthread_create(&thread, 0, mutatorThread, &md) == 0);
+  std::string newFileLogName = getTempName("/tmp", "eosns");
+  std::string newContLogName = getTempName("/tmp", "eosns");
+  void* fileData = 0;
+  void* contData = 0;
+  pthread_mutex_lock(&md.mutex);
+  CPPUNIT_ASSERT_NO_THROW(fileData =
+                            clFileSvc->compactPrepareIncremental(newFileLogName));
+  CPPUNIT_ASSERT_NO_THROW(contData =
+                            clContSvc->compactPrepareIncremental(newContLogName));
+  pthread_mutex_unlock(&md.mutex);
+
+  for (int round = 0; round < 5; ++round) {
+    CPPUNIT_ASSERT_NO_THROW(clFileSvc->compactCatchUp(fileData));
+    CPPUNIT_ASSERT_NO_THROW(clContSvc->compactCatchUp(contData));
+    pthread_mutex_lock(&md.mutex);
+    clFileSvc->compactMark(fileData);
+    clContSvc->compactMark(contData);
+    pthread_mutex_unlock(&md.mutex);
+  }
+
+  pthread_mutex_lock(&md.mutex);
+  CPPUNIT_ASSERT_NO_THROW(clFileSvc->compactCommitIncremental(fileData));
+  CPPUNIT_ASSERT_NO_THROW(clContSvc->compactCommitIncremental(contData));
+  // A new compacting has to wait for the in-memory offsets
+  CPPUNIT_ASSERT_THROW(clFileSvc->compactPrepare(getTempName("/tmp", "eosns")),
+                       eos::MDException);
+  pthread_mutex_unlock(&md.mutex);
+  uint64_t left = 0;
+
+  do {
+    pthread_mutex_lock(&md.mutex);
+    left = clFileSvc->compactRemap(1000) + clContSvc->compactRemap(1000);
+    pthread_mutex_unlock(&md.mutex);
+  } while (left);
+
+  md.stop = true;
+  CPPUNIT_ASSERT(pthread_join(thread, 0) == 0);
+  std::map<std::string, uint64_t> state = getTestState(view);
+  //----------------------------------------------------------------------------
+  // Compact again the classic way, which copies the records at the in-memory
+  // offsets and therefore checks them
+  //----------------------------------------------------------------------------
+  std::string checkFileLogName = getTempName("/tmp", "eosns");
+  void* compData = 0;
+  CPPUNIT_ASSERT_NO_THROW(compData = clFileSvc->compactPrepare(checkFileLogName));
+  CPPUNIT_ASSERT_NO_THROW(clFileSvc->compact(compData));
+  CPPUNIT_ASSERT_NO_THROW(clFileSvc->compactCommit(compData));
+  //----------------------------------------------------------------------------
+  // Reload both compacted logs and compare
+  //----------------------------------------------------------------------------
+  view->finalize();
+  fileSettings["changelog_path"] = newFileLogName;
+  fileSvc->configure(fileSettings);
+  contSettings["changelog_path"] = newContLogName;
+  contSvc->configure(contSettings);
+  view->initialize();
+  CPPUNIT_ASSERT(state == getTestState(view));
+  view->finalize();
+  fileSettings["changelog_path"] = checkFileLogName;
+  fileSvc->configure(fileSettings);
+  view->initialize();
+  CPPUNIT_ASSERT(state == getTestState(view));
+  view->finalize();
+  //----------------------------------------------------------------------------
+  // Cleanup
+  //----------------------------------------------------------------------------
+  unlink(fileNameFileMD.c_str());
+  unlink(fileNameContMD.c_str());
+  unlink(newFileLogName.c_str());
+  unlink(newContLogName.c_str());
+  unlink(checkFileLogName.c_str());
+}
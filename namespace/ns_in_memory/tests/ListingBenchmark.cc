@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2017 by European Organization for Nuclear Research (CERN)
+// Author: agent <agent@local>
+//------------------------------------------------------------------------------
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Compare listing a large directory by copying its name sets with the chunked
+// cursor based listing
+//------------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "namespace/ns_in_memory/ContainerMD.hh"
+#include "namespace/ns_in_memory/FileMD.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogFileMDSvc.hh"
+
+//------------------------------------------------------------------------------
+// Get time in microsecs
+//------------------------------------------------------------------------------
+uint64_t clockGetTime( clockid_t type = CLOCK_REALTIME )
+{
+  timespec ts;
+  clock_gettime( type, &ts );
+  return (uint64_t)ts.tv_sec * 1000000LL + (uint64_t)ts.tv_nsec / 1000LL;
+}
+
+int main( int argc, char **argv )
+{
+  //----------------------------------------------------------------------------
+  // Check up the commandline params
+  //----------------------------------------------------------------------------
+  uint64_t nfiles = 10000000;
+  size_t chunk = 10000;
+
+  if( argc > 3 )
+  {
+    std::cerr << "Usage:"                                              << std::endl;
+    std::cerr << "  ns-listing-benchmark [nfiles=10000000] [chunk=10000]" << std::endl;
+    return 1;
+  }
+
+  if( argc > 1 )
+    nfiles = strtoull( argv[1], 0, 10 );
+
+  if( argc > 2 )
+    chunk = strtoull( argv[2], 0, 10 );
+
+  if( !nfiles || !chunk )
+  {
+    std::cerr << "[!] Error: nfiles and chunk have to be > 0" << std::endl;
+    return 1;
+  }
+
+  //----------------------------------------------------------------------------
+  // Fill a directory, the same file object is added under all names
+  //----------------------------------------------------------------------------
+  eos::ChangeLogFileMDSvc fileSvc;
+  eos::ContainerMD        cont( 1, &fileSvc, 0 );
+  eos::FileMD             file( 1, &fileSvc );
+  char                    name[64];
+
+  std::cerr << "[i] Filling directory with " << nfiles << " files..." << std::endl;
+  uint64_t start = clockGetTime();
+
+  for( uint64_t i = 0; i < nfiles; ++i )
+  {
+    snprintf( name, sizeof( name ), "file_%012llu", (unsigned long long)i );
+    file.setName( name );
+    cont.addFile( &file );
+  }
+
+  std::cerr << "[i] Filled in " << (clockGetTime() - start) / 1000000.0
+            << " s" << std::endl;
+
+  //----------------------------------------------------------------------------
+  // Full copy of the names as done before by opendir
+  //----------------------------------------------------------------------------
+  start = clockGetTime();
+  std::set<std::string> names = cont.getNameFiles();
+  std::set<std::string> dnames = cont.getNameContainers();
+  names.insert( dnames.begin(), dnames.end() );
+  uint64_t copyTime = clockGetTime() - start;
+  std::cerr << "[i] Set copy:     " << names.size() << " entries in "
+            << copyTime / 1000000.0 << " s (lock held for the whole time)"
+            << std::endl;
+  names.clear();
+
+  //----------------------------------------------------------------------------
+  // Chunked listing
+  //----------------------------------------------------------------------------
+  eos::IContainerMD::ListCursor cursor;
+  std::vector<std::string> entries;
+  uint64_t nlisted = 0;
+  uint64_t nchunks = 0;
+  uint64_t maxChunkTime = 0;
+  start = clockGetTime();
+
+  while( !cursor.done )
+  {
+    uint64_t chunkStart = clockGetTime();
+    entries.clear();
+    cont.listEntries( cursor, chunk,
+                      [&entries]( const std::string &name, uint64_t id,
+                                  bool container )
+    {
+      entries.push_back( name );
+    } );
+    uint64_t chunkTime = clockGetTime() - chunkStart;
+
+    if( chunkTime > maxChunkTime )
+      maxChunkTime = chunkTime;
+
+    nlisted += entries.size();
+    nchunks++;
+  }
+
+  uint64_t listTime = clockGetTime() - start;
+  std::cerr << "[i] Chunked list: " << nlisted << " entries in "
+            << listTime / 1000000.0 << " s, " << nchunks << " chunks, max. "
+            << maxChunkTime / 1000.0 << " ms per chunk (lock hold time)"
+            << std::endl;
+
+  if( nlisted != nfiles )
+  {
+    std::cerr << "[!] Error: listed " << nlisted << " of " << nfiles
+              << " entries" << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
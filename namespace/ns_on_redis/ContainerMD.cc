@@ -373,6 +373,74 @@ ContainerMD::getNameContainers() const
   return set_dirs;
 }
 
+//------------------------------------------------------------------------------
+// Visit the files contained in the current object
+//------------------------------------------------------------------------------
+void
+ContainerMD::visitFiles(const EntryVisitor& visitor) const
+{
+  for (auto && elem : mFilesMap) {
+    if (!visitor(elem.first, elem.second)) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Visit the subcontainers of the current object
+//------------------------------------------------------------------------------
+void
+ContainerMD::visitContainers(const EntryVisitor& visitor) const
+{
+  for (auto && elem : mDirsMap) {
+    if (!visitor(elem.first, elem.second)) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// List the next chunk of a name map, resuming after the last listed name
+//
+// @return true if the end of the map has been reached
+//------------------------------------------------------------------------------
+template <typename Map>
+static bool
+ListMapChunk(const Map& map, IContainerMD::ListCursor& cursor, size_t& max,
+             const IContainerMD::ListVisitor& visitor, bool container)
+{
+  auto it = cursor.count ? map.upper_bound(cursor.last) : map.begin();
+
+  for (; (it != map.end()) && max; ++it, --max) {
+    visitor(it->first, it->second, container);
+    cursor.last = it->first;
+    cursor.count++;
+  }
+
+  return (it == map.end());
+}
+
+//------------------------------------------------------------------------------
+// List the next chunk of entries
+//------------------------------------------------------------------------------
+void
+ContainerMD::listEntries(ListCursor& cursor, size_t max,
+                         const ListVisitor& visitor) const
+{
+  if (!cursor.inFiles) {
+    if (!ListMapChunk(mDirsMap, cursor, max, visitor, true)) {
+      return;
+    }
+
+    cursor = ListCursor();
+    cursor.inFiles = true;
+  }
+
+  if (!cursor.done && ListMapChunk(mFilesMap, cursor, max, visitor, false)) {
+    cursor.done = true;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Access checking helpers
 //------------------------------------------------------------------------------
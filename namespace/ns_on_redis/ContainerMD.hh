@@ -405,6 +405,22 @@ public:
   //----------------------------------------------------------------------------
   virtual std::set<std::string> getNameContainers() const;
 
+  //----------------------------------------------------------------------------
+  //! Visit the files contained in the current object
+  //----------------------------------------------------------------------------
+  virtual void visitFiles(const EntryVisitor& visitor) const;
+
+  //----------------------------------------------------------------------------
+  //! Visit the subcontainers of the current object
+  //----------------------------------------------------------------------------
+  virtual void visitContainers(const EntryVisitor& visitor) const;
+
+  //----------------------------------------------------------------------------
+  //! List the next chunk of entries
+  //----------------------------------------------------------------------------
+  virtual void listEntries(ListCursor& cursor, size_t max,
+                           const ListVisitor& visitor) const;
+
   //----------------------------------------------------------------------------
   //! Serialize the object to a buffer
   //----------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+// ----------------------------------------------------------------------
+// File: EosCapabilityBenchmark.cc
+// Author: agent <agent@local>
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include "authz/XrdCapability.hh"
+/*----------------------------------------------------------------------------*/
+#include "XrdOuc/XrdOucEnv.hh"
+/*----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+/*----------------------------------------------------------------------------*/
+
+//------------------------------------------------------------------------------
+// Typical capability environment of a file open
+//------------------------------------------------------------------------------
+static const char* sCapEnv =
+  "mgm.access=read&mgm.ruid=1234&mgm.rgid=1000&mgm.uid=1234&mgm.gid=1000"
+  "&mgm.path=/eos/instance/user/a/alice/data/run0001/file0001.root"
+  "&mgm.manager=eosmgm.cern.ch:1094&mgm.fid=0001a2b3&mgm.cid=12345"
+  "&mgm.sec=krb5|alice|lxplus.cern.ch||alice|||&mgm.lid=1048850"
+  "&mgm.bookingsize=0&mgm.fsid=42&mgm.localprefix=/data42/"
+  "&mgm.url0=root://fst42.cern.ch:1095//&mgm.logid=0f1e2d3c-4b5a-6978-8796"
+  "-a5b4c3d2e1f0";
+
+//------------------------------------------------------------------------------
+// Create and extract capabilities in a given format, print the throughput
+//------------------------------------------------------------------------------
+static bool
+Run(XrdCapability::Format format, const char* name, int loops)
+{
+  eos::common::SymKey* key = eos::common::gSymKeyStore.GetCurrentKey();
+  XrdOucEnv inenv(sCapEnv);
+  XrdOucEnv* capenv = 0;
+  std::string cap;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < loops; ++i) {
+    if (XrdCapability::Create(&inenv, capenv, key, 3600, format)) {
+      fprintf(stderr, "error: unable to create %s capability\n", name);
+      return false;
+    }
+
+    if (i == loops - 1) {
+      int envlen = 0;
+      cap = capenv->Env(envlen);
+    }
+
+    delete capenv;
+  }
+
+  double sign = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                start).count();
+  XrdOucEnv capin(cap.c_str());
+  XrdOucEnv* outenv = 0;
+  std::string path;
+  start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < loops; ++i) {
+    int rc = XrdCapability::Extract(&capin, outenv);
+
+    if (rc || !outenv->Get("mgm.path")) {
+      fprintf(stderr, "error: unable to extract %s capability errno=%d\n", name,
+              rc);
+      delete outenv;
+      return false;
+    }
+
+    path = outenv->Get("mgm.path");
+    delete outenv;
+  }
+
+  double verify = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                  - start).count();
+  fprintf(stdout, "%-8s size=%-5zu sign=%10.0f/s verify=%10.0f/s\n", name,
+          cap.length(), loops / sign, loops / verify);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Compare the throughput of the legacy and the HMAC capability format
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  int loops = (argc > 1) ? atoi(argv[1]) : 100000;
+
+  if (loops <= 0) {
+    fprintf(stderr, "usage: %s [loops]\n", argv[0]);
+    exit(-1);
+  }
+
+  if (!eos::common::gSymKeyStore.SetKey64("MTIzNDU2Nzg5MDEyMzQ1Njc4OTA=", 0)) {
+    fprintf(stderr, "error: unable to store the symmetric key\n");
+    exit(-1);
+  }
+
+  if (!Run(XrdCapability::kLegacy, "legacy", loops) ||
+      !Run(XrdCapability::kHmac, "hmac", loops)) {
+    exit(-1);
+  }
+
+  return 0;
+}
@@ -30,11 +30,14 @@
 #include "common/Timing.hh"
 #include "common/StringConversion.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/checksum/ChecksumEngine.hh"
 /*-----------------------------------------------------------------------------*/
 #include <XrdPosix/XrdPosixXrootd.hh>
 #include <XrdClient/XrdClient.hh>
 #include <XrdOuc/XrdOucString.hh>
 /*-----------------------------------------------------------------------------*/
+#include <thread>
+/*-----------------------------------------------------------------------------*/
 
 XrdPosixXrootd posixXrootd;
 
@@ -65,12 +68,21 @@ int main (int argc, char* argv[]) {
   checksumids.push_back(eos::common::LayoutId::kSHA1);
   
   size_t nforks = 1;
+  size_t nthreads = std::thread::hardware_concurrency();
 
-  if (argc == 2 ) {
+  if (argc >= 2 ) {
 
     nforks = atoi(argv[1]);
   }
 
+  if (argc >= 3) {
+    nthreads = atoi(argv[2]);
+  }
+
+  if (!nthreads) {
+    nthreads = 1;
+  }
+
 
   for (size_t foker = 0; foker < nforks; foker ++) {
     if (!fork()) {
@@ -136,4 +148,70 @@ int main (int argc, char* argv[]) {
   for (size_t foker = 0; foker < nforks; foker ++) {
     wait(0);
   }
+
+  // thread scaling of the checksum kernels used by the scanner: every thread
+  // checksums a contiguous part of the buffer, the partial checksums of the
+  // combinable algorithms are combined into the checksum of the whole buffer
+  char* buffer = (char*) malloc(MEMORYBUFFERSIZE);
+
+  if (!buffer) {
+    fprintf(stderr,"error: failed to allocate reference buffer!\n");
+    exit(-1);
+  }
+
+  srandom(0);
+  for (off_t i = 0; i< MEMORYBUFFERSIZE; i++) {
+    buffer[i]= (rand())%256;
+  }
+
+  for (size_t i = 0; i< checksumnames.size(); i++) {
+    eos::fst::CheckSum* checksum = eos::fst::ChecksumPlugins::GetChecksumObject(checksumids[i]);
+    if (!checksum) {
+      eos_static_err("failed to get checksum algorithm %s", checksumnames[i].c_str());
+      continue;
+    }
+
+    eos::fst::ChecksumEngine::Kind kind = eos::fst::ChecksumEngine::GetKind(checksum);
+    delete checksum;
+    uint32_t reference = 0;
+
+    for (size_t n = 1; n <= nthreads; n *= 2) {
+      std::vector<std::thread> workers;
+      std::vector<char> results(n * 20);
+      size_t part = MEMORYBUFFERSIZE / n;
+      eos::common::Timing tm("Scaling");
+      COMMONTIMING("START",&tm);
+      for (size_t t = 0; t < n; t++) {
+        size_t length = (t == n - 1) ? (MEMORYBUFFERSIZE - t * part) : part;
+        char* out = &results[t * 20];
+        char* ptr = buffer + t * part;
+        workers.push_back(std::thread([kind, ptr, length, out]() {
+          eos::fst::ChecksumEngine::Digest digest(kind);
+          digest.Update(ptr, length);
+          digest.Final(out);
+        }));
+      }
+      for (size_t t = 0; t < n; t++) {
+        workers[t].join();
+      }
+      bool combined = eos::fst::ChecksumEngine::IsCombinable(kind);
+      uint32_t value = 0;
+      if (combined) {
+        memcpy(&value, &results[0], sizeof(value));
+        for (size_t t = 1; t < n; t++) {
+          uint32_t second;
+          size_t length = (t == n - 1) ? (MEMORYBUFFERSIZE - t * part) : part;
+          memcpy(&second, &results[t * 20], sizeof(second));
+          value = eos::fst::ChecksumEngine::Combine(kind, value, second, length);
+        }
+      }
+      COMMONTIMING("STOP",&tm);
+      if (n == 1) {
+        reference = value;
+      }
+      eos_static_info("checksum( %-10s ) threads=%-3lu realtime=%.02f [ms] rate=%.02f GB/s %s", checksumnames[i].c_str(), (unsigned long) n, tm.RealTime(), MEMORYBUFFERSIZE/tm.RealTime()/1000000.0, !combined ? "partial-only" : ((value == reference) ? "combined-ok" : "combined-mismatch"));
+    }
+  }
+
+  free(buffer);
 }